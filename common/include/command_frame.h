@@ -0,0 +1,93 @@
+/**
+ * @file command_frame.h
+ * @brief Header for command_frame.c file.
+ *
+ * A binary frame carries a command over the USART, alongside the text lines: a start byte, the opcode of the command
+ * (fixed when it is registered in the command table), the length of the payload, the payload and a CRC-16
+ * (CRC-16/CCITT-FALSE, most significant byte first) of the opcode, the length and the payload. The payload holds the
+ * arguments of the command, as text, separated by NUL characters: a frame is handled by the same handlers as a text
+ * line, with no separators to skip, no quotes and no name to look up.
+ *
+ * The USART port decodes the frames byte by byte as they are received and checks their CRC (port_usart.h): a frame is
+ * queued as a line that starts with the start byte and has no CRC. The layout of a frame is defined there. Both the
+ * ports and the encoder compute the CRC with command_frame_crc16_update(), a byte at a time.
+ *
+ * @author Javier de Ponte Hernando
+ * @author Roberto Maldonado Macafee
+ * @date 18/10/2026
+ */
+
+#ifndef COMMAND_FRAME_H_
+#define COMMAND_FRAME_H_
+
+/* Includes ------------------------------------------------------------------*/
+/* Standard C includes */
+#include <stdint.h>
+#include <stdbool.h>
+
+/* HW dependent includes */
+#include "port_usart.h"
+
+/* Other includes */
+#include "command_line.h"
+
+/* Defines and enums ----------------------------------------------------------*/
+#define COMMAND_FRAME_START USART_FRAME_START_CONSTANT          /*!< First byte of a frame */
+#define COMMAND_FRAME_HEADER_LENGTH USART_FRAME_HEADER_LENGTH   /*!< Bytes of a frame before its payload */
+#define COMMAND_FRAME_CRC_LENGTH USART_FRAME_CRC_LENGTH         /*!< Bytes of the CRC of a frame */
+#define COMMAND_FRAME_MAX_PAYLOAD USART_FRAME_MAX_PAYLOAD       /*!< Maximum length of the payload of a frame */
+#define COMMAND_FRAME_MAX_LENGTH (COMMAND_FRAME_HEADER_LENGTH + COMMAND_FRAME_MAX_PAYLOAD + COMMAND_FRAME_CRC_LENGTH) /*!< Maximum length of a frame */
+
+/* Function prototypes and explanation -------------------------------------------------*/
+/**
+ * @brief Update the CRC-16 of a frame with a byte, a nibble at a time. \n
+ * It is called from the USART ISR for every byte of a frame received: start with USART_FRAME_CRC_INIT.
+ *
+ * @param crc CRC-16 of the bytes before
+ * @param data Byte
+ * @return uint16_t CRC-16/CCITT-FALSE of the bytes before and the byte
+ */
+uint16_t command_frame_crc16_update(uint16_t crc, uint8_t data);
+
+/**
+ * @brief Compute the CRC-16 of a frame: from its opcode to the end of its payload.
+ *
+ * @param p_data Pointer to the bytes
+ * @param length Number of bytes
+ * @return uint16_t CRC-16/CCITT-FALSE of the bytes
+ */
+uint16_t command_frame_crc16(const uint8_t *p_data, uint32_t length);
+
+/**
+ * @brief Encode a command as a frame, e.g. to send it from a host.
+ *
+ * @param opcode Opcode of the command
+ * @param pp_args Arguments of the command, as strings
+ * @param num_args Number of arguments
+ * @param p_frame Pointer to store the frame
+ * @param size Size of the buffer of the frame
+ * @return uint32_t Length of the frame, or 0 if the arguments do not fit in a payload or the frame does not fit in the buffer
+ */
+uint32_t command_frame_encode(uint8_t opcode, const char *const *pp_args, uint32_t num_args, uint8_t *p_frame, uint32_t size);
+
+/**
+ * @brief Check if a line received is a frame.
+ *
+ * @param p_text Line received
+ * @return true if it starts with the start byte of a frame
+ */
+bool command_frame_is_frame(const char *p_text);
+
+/**
+ * @brief Decode a frame received, as queued by the USART port (with no CRC), in place: the arguments of the command
+ * line are the strings of its payload. The command of the line is empty: the command is known by its opcode.
+ *
+ * @param p_line Pointer to store the command line
+ * @param p_frame Frame received. The byte that follows the payload must be a NUL character
+ * @param p_opcode Pointer to store the opcode of the command
+ * @return true if the frame has been decoded
+ * @return false if it is not a frame, or it has more than COMMAND_LINE_MAX_ARGS arguments
+ */
+bool command_frame_decode(command_line_t *p_line, char *p_frame, uint8_t *p_opcode);
+
+#endif /* COMMAND_FRAME_H_ */
@@ -0,0 +1,127 @@
+/**
+ * @file command_line.h
+ * @brief Header for command_line.c file.
+ *
+ * A command line is tokenized in place, in the buffer where it was received: its command and its arguments are slices
+ * of the buffer (a pointer and a length), with no copies. An argument is a word, or a name between double quotes that
+ * may have spaces (`upload "my song" 10`). The arguments are read as strings, as the rest of the line, or as numbers:
+ * integers and fixed-point decimals, parsed with integer arithmetic only.
+ *
+ * A slice is not NUL-terminated until it is read as a string: the character that follows it, a separator, is then
+ * overwritten in the buffer.
+ *
+ * A line may hold a batch of commands separated by semicolons (`select 2; speed 1.5; info`), split in place too.
+ *
+ * @author Javier de Ponte Hernando
+ * @author Roberto Maldonado Macafee
+ * @date 18/10/2026
+ */
+
+#ifndef COMMAND_LINE_H_
+#define COMMAND_LINE_H_
+
+/* Includes ------------------------------------------------------------------*/
+/* Standard C includes */
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Defines and enums ----------------------------------------------------------*/
+#define COMMAND_LINE_MAX_ARGS 8U     /*!< Maximum number of arguments of a command */
+#define COMMAND_LINE_MAX_DECIMALS 4U /*!< Decimals of a fixed-point argument that are parsed. The rest are ignored */
+#define COMMAND_LINE_SEPARATOR ';'   /*!< Separator of the commands of a batch */
+
+/* Typedefs --------------------------------------------------------------------*/
+/**
+ * @brief Slice of a command line: a token.
+ */
+typedef struct
+{
+    char *p_start;   /*!< First character of the token, in the buffer of the line */
+    uint16_t length; /*!< Number of characters of the token */
+} command_token_t;
+
+/**
+ * @brief Command line tokenized.
+ */
+typedef struct
+{
+    command_token_t command;                    /*!< Command, the first token. Its length is 0 if the line is blank */
+    command_token_t args[COMMAND_LINE_MAX_ARGS]; /*!< Arguments of the command */
+    uint8_t num_args;                           /*!< Number of arguments */
+} command_line_t;
+
+/* Function prototypes and explanation -------------------------------------------------*/
+/**
+ * @brief Get the next command of a batch, in place: the separator that ends it is overwritten, and the spaces around it
+ * are skipped. A separator between double quotes is part of a name.
+ *
+ * @param pp_text Pointer to the position in the batch. It is moved to the next command, or set to NULL after the last one
+ * @return char* NUL-terminated command, or NULL if there are no more commands
+ */
+char *command_line_next(char **pp_text);
+
+/**
+ * @brief Split a line into its command and its arguments, in place. Tokens are separated by spaces, tabs or carriage
+ * returns; a token that starts with a double quote ends at the next one, and the quotes are not part of it.
+ *
+ * @param p_line Pointer to store the tokens
+ * @param p_text NUL-terminated line. Its tokens point into it
+ * @return true if the line has been tokenized, even if it is blank
+ * @return false if a quote is not closed, is not followed by a separator, or there are more than COMMAND_LINE_MAX_ARGS arguments
+ */
+bool command_line_tokenize(command_line_t *p_line, char *p_text);
+
+/**
+ * @brief Check if a token is a string.
+ *
+ * @param p_token Pointer to the token
+ * @param p_string NUL-terminated string
+ * @return true if the token has the same characters as the string
+ * @return false otherwise
+ */
+bool command_token_equals(const command_token_t *p_token, const char *p_string);
+
+/**
+ * @brief Get an argument as a NUL-terminated string: the separator that follows it is overwritten.
+ *
+ * @param p_line Pointer to the command line
+ * @param index Index of the argument
+ * @return char* Argument, or NULL if there is no such argument
+ */
+char *command_line_get_string(command_line_t *p_line, uint32_t index);
+
+/**
+ * @brief Get the text of the line from an argument to the end of the last one, as a NUL-terminated string: a name with
+ * spaces given with no quotes. Get it before the arguments that follow are got as strings.
+ *
+ * @param p_line Pointer to the command line
+ * @param index Index of the first argument
+ * @return char* Text of the arguments, or NULL if there is no such argument
+ */
+char *command_line_get_rest(command_line_t *p_line, uint32_t index);
+
+/**
+ * @brief Parse an argument as an unsigned decimal integer.
+ *
+ * @param p_line Pointer to the command line
+ * @param index Index of the argument
+ * @param p_value Pointer to store the value
+ * @return true if the argument is an integer that fits in 32 bits
+ * @return false if there is no such argument or it is not a valid integer
+ */
+bool command_line_get_uint(const command_line_t *p_line, uint32_t index, uint32_t *p_value);
+
+/**
+ * @brief Parse an argument as an unsigned decimal number (e.g. "1.25") into fixed point, rounded to the nearest. Only
+ * the first COMMAND_LINE_MAX_DECIMALS decimals are parsed.
+ *
+ * @param p_line Pointer to the command line
+ * @param index Index of the argument
+ * @param fraction_bits Number of fractional bits of the fixed point, up to 16 (e.g. 8 for Q8.8)
+ * @param p_value Pointer to store the value
+ * @return true if the argument is a number that fits in 32 bits once scaled
+ * @return false if there is no such argument or it is not a valid number
+ */
+bool command_line_get_fixed(const command_line_t *p_line, uint32_t index, uint32_t fraction_bits, uint32_t *p_value);
+
+#endif /* COMMAND_LINE_H_ */
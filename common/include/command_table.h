@@ -0,0 +1,144 @@
+/**
+ * @file command_table.h
+ * @brief Header for command_table.c file.
+ *
+ * A command table maps the names of the commands received over the USART to their handlers. Commands are registered
+ * at runtime, each with the schema of its arguments, so any module can add commands to the jukebox. A command is found
+ * through a hash of its length and its first character, which leads to a short chain of commands (usually one) whose
+ * names are compared: the cost of a command does not depend on how many commands there are or when it was registered.
+ *
+ * A command is also known by its opcode, for the binary frames of command_frame.h. The opcode is fixed when the command
+ * is registered, so the frames of a client keep their meaning whatever the order in which the commands are registered.
+ * A command is found by its opcode with a direct lookup in a table of the opcodes.
+ *
+ * @author Javier de Ponte Hernando
+ * @author Roberto Maldonado Macafee
+ * @date 18/10/2026
+ */
+
+#ifndef COMMAND_TABLE_H_
+#define COMMAND_TABLE_H_
+
+/* Includes ------------------------------------------------------------------*/
+/* Standard C includes */
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Other includes */
+#include "command_line.h"
+
+/* Defines and enums ----------------------------------------------------------*/
+#define COMMAND_TABLE_MAX_COMMANDS 32U  /*!< Maximum number of commands of a table */
+#define COMMAND_TABLE_NUM_BUCKETS 32U   /*!< Buckets of the hash of the commands: a power of 2 */
+#define COMMAND_TABLE_ANY_ARGS COMMAND_LINE_MAX_ARGS /*!< Maximum number of arguments of a command that takes as many as a line holds */
+#define COMMAND_TABLE_NO_COMMAND -1     /*!< End of a chain of commands of a bucket, or opcode with no command */
+#define COMMAND_TABLE_MAX_OPCODES 64U   /*!< Opcodes of a table: from 0 to COMMAND_TABLE_MAX_OPCODES - 1 */
+#define COMMAND_TABLE_NO_OPCODE UINT8_MAX /*!< Opcode of a command that is only received as a text line */
+
+/**
+ * @brief Result of the dispatch of a command.
+ */
+typedef enum
+{
+    COMMAND_TABLE_OK = 0,       /*!< The handler of the command has been called */
+    COMMAND_TABLE_NOT_FOUND,    /*!< There is no command with that name */
+    COMMAND_TABLE_WRONG_ARGS,   /*!< The number of arguments does not match the schema of the command */
+} command_table_result_t;
+
+/* Typedefs --------------------------------------------------------------------*/
+/**
+ * @brief Handler of a command.
+ *
+ * @param p_context Pointer registered with the command, e.g. the FSM that owns it
+ * @param p_line Pointer to the command line, tokenized. Its arguments may be read as strings by the handler
+ */
+typedef void (*command_handler_t)(void *p_context, command_line_t *p_line);
+
+/**
+ * @brief Command of a command table.
+ */
+typedef struct
+{
+    const char *p_name;        /*!< Name of the command. It must outlive the table */
+    uint8_t length;            /*!< Length of the name */
+    uint8_t opcode;            /*!< Opcode of the command in the binary frames, or COMMAND_TABLE_NO_OPCODE */
+    uint8_t min_args;          /*!< Minimum number of arguments */
+    uint8_t max_args;          /*!< Maximum number of arguments */
+    int8_t next;               /*!< Next command of the same bucket, or COMMAND_TABLE_NO_COMMAND */
+    command_handler_t handler; /*!< Handler of the command */
+    void *p_context;           /*!< Context passed to the handler */
+} command_t;
+
+/**
+ * @brief Command table.
+ */
+typedef struct
+{
+    command_t commands[COMMAND_TABLE_MAX_COMMANDS]; /*!< Commands registered */
+    uint8_t num_commands;                           /*!< Number of commands registered */
+    int8_t buckets[COMMAND_TABLE_NUM_BUCKETS];      /*!< First command of each bucket, or COMMAND_TABLE_NO_COMMAND */
+    int8_t opcodes[COMMAND_TABLE_MAX_OPCODES];      /*!< Command of each opcode, or COMMAND_TABLE_NO_COMMAND */
+} command_table_t;
+
+/* Function prototypes and explanation -------------------------------------------------*/
+/**
+ * @brief Initialize an empty command table.
+ *
+ * @param p_table Pointer to the table
+ */
+void command_table_init(command_table_t *p_table);
+
+/**
+ * @brief Register a command.
+ *
+ * @param p_table Pointer to the table
+ * @param p_name Name of the command, with no spaces. It is not copied
+ * @param opcode Opcode of the command in the binary frames, below COMMAND_TABLE_MAX_OPCODES, or COMMAND_TABLE_NO_OPCODE
+ * @param min_args Minimum number of arguments
+ * @param max_args Maximum number of arguments, COMMAND_TABLE_ANY_ARGS for as many as a line holds
+ * @param handler Handler of the command
+ * @param p_context Context passed to the handler
+ * @return true if the command has been registered
+ * @return false if the table is full, the name is empty or too long, the opcode is not valid, or there is a command
+ * with the same name or the same opcode
+ */
+bool command_table_register(command_table_t *p_table, const char *p_name, uint8_t opcode, uint8_t min_args, uint8_t max_args, command_handler_t handler, void *p_context);
+
+/**
+ * @brief Find a command by its name.
+ *
+ * @param p_table Pointer to the table
+ * @param p_name Name of the command. It does not need to be NUL-terminated
+ * @param length Length of the name
+ * @return const command_t* Pointer to the command, or NULL if there is no command with that name
+ */
+const command_t *command_table_find(const command_table_t *p_table, const char *p_name, uint32_t length);
+
+/**
+ * @brief Get a command by its opcode.
+ *
+ * @param p_table Pointer to the table
+ * @param opcode Opcode of the command, as registered
+ * @return const command_t* Pointer to the command, or NULL if there is no command with that opcode
+ */
+const command_t *command_table_get(const command_table_t *p_table, uint32_t opcode);
+
+/**
+ * @brief Check the arguments of a line against the schema of a command and call its handler.
+ *
+ * @param p_command Pointer to the command, as found in a table. NULL if it was not found
+ * @param p_line Pointer to the command line, tokenized. Its command is not read
+ * @return command_table_result_t COMMAND_TABLE_OK if the handler has been called, otherwise the error
+ */
+command_table_result_t command_table_call(const command_t *p_command, command_line_t *p_line);
+
+/**
+ * @brief Find the command of a line, check its arguments against its schema and call its handler.
+ *
+ * @param p_table Pointer to the table
+ * @param p_line Pointer to the command line, tokenized
+ * @return command_table_result_t COMMAND_TABLE_OK if the handler has been called, otherwise the error
+ */
+command_table_result_t command_table_dispatch(const command_table_t *p_table, command_line_t *p_line);
+
+#endif /* COMMAND_TABLE_H_ */
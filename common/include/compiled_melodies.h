@@ -0,0 +1,53 @@
+/**
+ * @file compiled_melodies.h
+ * @brief Header for compiled_melodies.c file.
+ *
+ * A compiled melody holds, for every note of a melody_t, the timer register values that the buzzer port loads
+ * directly (see port_buzzer_set_note_regs()). They are generated at build time from melodies.c by
+ * tools/compile_melodies.py.
+ *
+ * @author Javier de Ponte Hernando
+ * @author Roberto Maldonado Macafee
+ * @date 17/10/2026
+ */
+
+#ifndef COMPILED_MELODIES_H_
+#define COMPILED_MELODIES_H_
+
+/* Includes ------------------------------------------------------------------*/
+/* Standard C includes */
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Other includes */
+#include "melodies.h"
+#include "port_buzzer.h"
+
+/* Typedefs --------------------------------------------------------------------*/
+/**
+ * @brief Structure to define a compiled melody.
+ */
+typedef struct
+{
+    const melody_t *p_source;               /*!< Pointer to the melody it has been compiled from */
+    const port_buzzer_note_regs_t *p_regs;  /*!< Pointer to the register values of each note of the melody */
+    uint16_t melody_length;                 /*!< Length of the melody */
+} compiled_melody_t;
+
+/* Global variables */
+extern const compiled_melody_t compiled_melodies[]; /*!< Compiled melodies, generated from melodies.c */
+extern const uint32_t compiled_melodies_length;     /*!< Number of compiled melodies */
+extern const uint32_t compiled_melodies_clock_hz;   /*!< Timer clock the melodies have been compiled for */
+
+/* Function prototypes and explanation -------------------------------------------------*/
+/**
+ * @brief Find the compiled version of a melody. \n
+ * A melody matches if it is the source melody or a copy of it (same notes and durations arrays and length).
+ * Compiled melodies are only valid for the timer clock they have been compiled for.
+ *
+ * @param p_melody Pointer to the melody
+ * @return const compiled_melody_t* Pointer to the compiled melody, or NULL if there is none
+ */
+const compiled_melody_t *compiled_melody_find(const melody_t *p_melody);
+
+#endif /* COMPILED_MELODIES_H_ */
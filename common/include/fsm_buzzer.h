@@ -15,11 +15,13 @@
 #include <stdbool.h>
 #include <fsm.h>
 #include "melodies.h"
+#include "compiled_melodies.h"
+#include "melody_timeline.h"
 
 /* Other includes */
 
 /* HW dependent includes */
-
+#include "port_buzzer.h"
 
 /* Defines and enums ----------------------------------------------------------*/
 /* Enums */
@@ -49,7 +51,28 @@ enum USER_ACTIONS {
 };
  
 
+/* Defines */
+#define FSM_BUZZER_SPEED_Q8_ONE 256U /*!< Normal speed of the player in Q8.8 fixed point*/
+#define FSM_BUZZER_SPEED_Q8(speed) ((uint32_t)((speed) * 256.0 + 0.5)) /*!< Convert a speed factor to Q8.8 fixed point. Folded at build time for constants*/
+
 /* Typedefs --------------------------------------------------------------------*/
+/**
+ * @brief Structure to define the state of the voice allocator of a multi-track melody. \n
+ * The melody is played in segments: a segment lasts until the next note of any track starts, so every voice shares the timer that
+ * controls the duration of the note. A note that starts takes a free voice, or the voice that has played its note for the longest time.
+ * 
+ */
+typedef struct {
+    uint16_t note_index[MELODY_MAX_TRACKS]; /*!< Index of the current note of each track*/
+    uint16_t remaining_ms[MELODY_MAX_TRACKS]; /*!< Time left of the current note of each track, in ms at normal speed*/
+    int8_t track_voice[MELODY_MAX_TRACKS]; /*!< Voice that plays the current note of each track, or -1 if it has none*/
+    int8_t voice_track[PORT_BUZZER_MAX_VOICES]; /*!< Track whose note is played by each voice, or -1 if the voice is free*/
+    uint32_t voice_start_ms[PORT_BUZZER_MAX_VOICES]; /*!< Time of the melody at which the note of each voice has started, in ms*/
+    uint8_t reload_mask; /*!< Voices whose timer has to be loaded at the start of the next segment, one bit per voice*/
+    uint32_t elapsed_ms; /*!< Time of the melody at the start of the next segment, in ms at normal speed*/
+    uint32_t stolen_notes; /*!< Number of notes cut or not played for lack of voices*/
+} fsm_buzzer_voices_t;
+
 /**
  * @brief Structure to define the Buzzer FSM.
  * 
@@ -60,7 +83,27 @@ typedef struct {
     uint32_t note_index; /*!< Index of the current note of the melody to play*/
     uint8_t buzzer_id; /*!< Buzzer melody player ID. Must be unique. */
     uint8_t user_action; /*!< Action to perform on the player. Can indicate if the user has stopped, paused or started the player, or if the player has stopped itself*/
-    double player_speed; /*!< Speed of the player. 1.0 is normal speed. 0.5 is half speed. 2.0 is double speed*/
+    double player_speed; /*!< Speed of the player. 1.0 is normal speed. 0.5 is half speed. 2.0 is double speed. Kept for compatibility: the player uses speed_q8. Set by the speed setters, not by the steps of a tempo ramp*/
+    uint16_t speed_q8; /*!< Speed of the player, Q8.8 fixed point. FSM_BUZZER_SPEED_Q8_ONE is normal speed*/
+    const compiled_melody_t *p_compiled; /*!< Pointer to the compiled version of the melody, or NULL if there is none*/
+    bool gapless; /*!< If true, the next note is staged in the timers while the current one plays, so the HW starts it with no gap*/
+    bool next_staged; /*!< Flag to indicate that the note at note_index has been staged in the timers*/
+    bool sequencer; /*!< If true, the notes are advanced by the ISR of the timer that controls the duration of the note*/
+    bool dma; /*!< If true, the melody is played by DMA with no CPU involvement until its end*/
+    uint32_t dma_first_note; /*!< Index of the note at which the DMA playback has started*/
+    bool absolute_time; /*!< If true, each note ends at its time in the schedule of the melody instead of after its duration from its start*/
+    bool schedule_resync; /*!< Flag to indicate that the player has been paused and the schedule has to be set from the next note*/
+    uint32_t schedule_us; /*!< Time of the end of the last note handed to the HW in the schedule of the melody: prefix sum of the scaled durations, in us*/
+    int32_t drift_us; /*!< Drift of the end of the last melody played from its schedule, in us. Positive if it has ended late*/
+    uint16_t ramp_target_q8; /*!< Speed at the end of the tempo ramp, Q8.8*/
+    uint32_t ramp_remaining_us; /*!< Time of the melody left until the end of the tempo ramp, in us. 0 if there is no ramp*/
+    const multitrack_melody_t *p_multitrack; /*!< Pointer to the multi-track melody to play, or NULL. p_melody points to its first track*/
+    fsm_buzzer_voices_t voices; /*!< Voice allocator of the multi-track melody*/
+    melody_timeline_t timeline; /*!< Start time of the notes of the melody, built when it is set*/
+    uint32_t total_ms; /*!< Duration of the melody in ms at normal speed: that of its longest track for a multi-track melody*/
+    uint32_t seek_offset_ms; /*!< Time to skip of the note at note_index when it is started, after a seek. 0 if there is none*/
+    const melody_t *volatile p_next_melody; /*!< Pointer to the melody that follows the melody playing with no gap, or NULL*/
+    const compiled_melody_t *p_next_compiled; /*!< Pointer to the compiled version of the next melody, or NULL if there is none*/
 } fsm_buzzer_t;
 
 /* Function prototypes and explanation -------------------------------------------------*/
@@ -73,6 +116,47 @@ typedef struct {
  */
 void fsm_buzzer_set_melody (fsm_t *p_this, const melody_t *p_melody);
 
+/**
+ * @brief Set the melody that follows the melody playing, or NULL to play none. \n
+ * In gapless and sequencer modes the player goes on with the next melody when it stages the note that follows the last note of the melody
+ * playing: the first note of the next melody is staged in the timers, so the HW starts it with no gap. From then on the next melody is the
+ * melody to play (fsm_buzzer_get_melody()), with no STOP in between. In the other modes, or if the melody playing is played by DMA, the next
+ * melody starts when the melody playing ends. The next melody is dropped when the player is stopped or another melody is set. Once
+ * it is dropped, the player cannot go on with it: fsm_buzzer_get_melody() tells if it has done so before.
+ *
+ * @param p_this 	Pointer to an fsm_t struct than contains an fsm_buzzer_t struct
+ * @param p_next Pointer to the next melody, or NULL. It must stay valid until it is played. A streamed or packed melody cannot follow: its notes are not resident
+ * @return true if the next melody has been set
+ * @return false if the melody cannot follow: it is empty, streamed or packed
+ */
+bool fsm_buzzer_set_next_melody (fsm_t *p_this, const melody_t *p_next);
+
+/**
+ * @brief Get the melody to play: the melody set, or the next melody once the player has gone on with it.
+ *
+ * @param p_this 	Pointer to an fsm_t struct than contains an fsm_buzzer_t struct
+ * @return const melody_t* Pointer to the melody, or NULL if there is none
+ */
+const melody_t *fsm_buzzer_get_melody (fsm_t *p_this);
+
+/**
+ * @brief Set a multi-track melody to play. Its tracks are played at the same time on the voices of the buzzer, which share the timer that
+ * controls the duration of the note, so they keep in sync. \n
+ * A multi-track melody is played segment by segment from the main loop: the gapless, sequencer and DMA modes only apply to single-track melodies.
+ * 
+ * @param p_this 	Pointer to an fsm_t struct than contains an fsm_buzzer_t struct
+ * @param p_multitrack Pointer to the multi-track melody to play
+ */
+void fsm_buzzer_set_multitrack (fsm_t *p_this, const multitrack_melody_t *p_multitrack);
+
+/**
+ * @brief Get the number of notes of the multi-track melodies that have been cut or not played because all the voices were busy.
+ * 
+ * @param p_this 	Pointer to an fsm_t struct than contains an fsm_buzzer_t struct
+ * @return uint32_t Number of notes
+ */
+uint32_t fsm_buzzer_get_stolen_notes (fsm_t *p_this);
+
 /**
  * @brief 
  * Set the speed of the player. \n 
@@ -84,6 +168,123 @@ void fsm_buzzer_set_melody (fsm_t *p_this, const melody_t *p_melody);
  */
 void fsm_buzzer_set_speed (fsm_t *p_this, double speed);
 
+/**
+ * @brief Set the speed of the player in fixed point: Q8.8, from 1/256 to 255.99. FSM_BUZZER_SPEED_Q8_ONE is normal speed. \n
+ * The durations of the notes are scaled with integer arithmetic only. fsm_buzzer_set_speed() is kept for compatibility: it converts the
+ * speed and the player uses the same code. \n
+ * If a note is playing, the rest of it is rescaled in place, so the new tempo is heard at once.
+ * 
+ * @param p_this 	Pointer to an fsm_t struct than contains an fsm_buzzer_t struct
+ * @param speed_q8 Speed of the player, Q8.8
+ */
+void fsm_buzzer_set_speed_q8 (fsm_t *p_this, uint16_t speed_q8);
+
+/**
+ * @brief Change the speed of the player gradually: from the current speed to the target speed along the given time of the melody. 
+
+ * The speed is stepped linearly at the start of each note, with integer arithmetic only. A new speed or ramp cancels the ramp in progress.
+ * 
+ * @param p_this 	Pointer to an fsm_t struct than contains an fsm_buzzer_t struct
+ * @param target_q8 Speed at the end of the ramp, Q8.8
+ * @param ramp_ms Duration of the ramp in ms of the melody. 0 sets the target speed at once
+ */
+void fsm_buzzer_set_speed_ramp (fsm_t *p_this, uint16_t target_q8, uint32_t ramp_ms);
+
+/**
+ * @brief Enable or disable the gapless mode of the player. \n
+ * In gapless mode the next note is staged in the timers while the current one plays, and the HW switches to it on the update event
+ * that ends the current note. The main loop only has to stage a note before the current one ends.
+ * 
+ * @param p_this 	Pointer to an fsm_t struct than contains an fsm_buzzer_t struct
+ * @param gapless True to enable the gapless mode
+ */
+void fsm_buzzer_set_gapless (fsm_t *p_this, bool gapless);
+
+/**
+ * @brief Enable or disable the sequencer mode of the player. \n
+ * In sequencer mode the ISR of the timer that controls the duration of the note advances note_index and stages the next note itself,
+ * so the timing of the notes does not depend on the main loop. The FSM only handles the play, pause and stop requests and the end of the melody.
+ * 
+ * @param p_this 	Pointer to an fsm_t struct than contains an fsm_buzzer_t struct
+ * @param sequencer True to enable the sequencer mode
+ */
+void fsm_buzzer_set_sequencer (fsm_t *p_this, bool sequencer);
+
+/**
+ * @brief Enable or disable the DMA mode of the player. \n
+ * In DMA mode the register values of the rest of the melody are loaded in the port when it starts or resumes, and the timers and the DMA
+ * play it with no CPU involvement: the FSM is only notified at the end of the melody, and the system can sleep meanwhile. Pause and stop
+ * take effect immediately, and a paused note is played again from its beginning on resume. Melodies longer than PORT_BUZZER_DMA_MAX_NOTES
+ * are played in the other modes.
+ * 
+ * @param p_this 	Pointer to an fsm_t struct than contains an fsm_buzzer_t struct
+ * @param dma True to enable the DMA mode
+ */
+void fsm_buzzer_set_dma (fsm_t *p_this, bool dma);
+
+/**
+ * @brief Enable or disable the absolute time mode of the player. \n
+ * In absolute time mode the end of each note started by the FSM is computed from the start of the melody plus the prefix sum of the scaled
+ * durations, instead of restarting the timer that controls the duration of the note for its whole duration. The time the main loop takes to
+ * start a note is compensated instead of being accumulated along the melody. The notes started by the HW (gapless, sequencer and DMA modes)
+ * follow the schedule by construction.
+ * 
+ * @param p_this 	Pointer to an fsm_t struct than contains an fsm_buzzer_t struct
+ * @param absolute_time True to enable the absolute time mode
+ */
+void fsm_buzzer_set_absolute_time (fsm_t *p_this, bool absolute_time);
+
+/**
+ * @brief Get the drift of the end of the last melody played: the time it has actually ended minus the time it was expected to end
+ * according to its schedule. The time paused is not accounted. It is measured in all the modes of the player.
+ * 
+ * @param p_this 	Pointer to an fsm_t struct than contains an fsm_buzzer_t struct
+ * @return int32_t Drift in us. Positive if the melody has ended late
+ */
+int32_t fsm_buzzer_get_drift_us (fsm_t *p_this);
+
+/**
+ * @brief Get the progress of the melody: the time played and its duration, both at the current speed of the player. \n
+ * They are read from the timeline of the melody and the timer that controls the duration of the note, with no walk of the durations.
+ * The time of a multi-track melody is that of its segments.
+ * 
+ * @param p_this 	Pointer to an fsm_t struct than contains an fsm_buzzer_t struct
+ * @param p_elapsed_ms Pointer to store the time played in ms. 0 if the player is stopped
+ * @param p_total_ms Pointer to store the duration of the melody in ms
+ */
+void fsm_buzzer_get_progress (fsm_t *p_this, uint32_t *p_elapsed_ms, uint32_t *p_total_ms);
+
+/**
+ * @brief Move the player to a time of the melody, in ms at the current speed of the player as reported by fsm_buzzer_get_progress(). \n
+ * The note is found by binary search in the timeline of the melody and started from the middle: at once if a note is playing, or else when
+ * the player plays the next note (e.g. on resume). The staged and DMA notes are dropped and the schedule restarts at the seek.
+ * Multi-track melodies cannot be seeked.
+ * 
+ * @param p_this 	Pointer to an fsm_t struct than contains an fsm_buzzer_t struct
+ * @param elapsed_ms Time of the melody in ms at the current speed
+ * @return true if the player has moved
+ * @return false if the player is stopped, the melody is multi-track or the time is not before its end
+ */
+bool fsm_buzzer_seek (fsm_t *p_this, uint32_t elapsed_ms);
+
+/**
+ * @brief Read ahead the next notes of the melody playing if it is streamed, while the notes before them play. \n
+ * Call it from the main loop: the notes that are not read ahead in time are read by the main loop when they are played, late, and counted as
+ * underruns of the stream. The ISR of the player only reads the notes read ahead, and never the storage device.
+ * 
+ * @param p_this 	Pointer to an fsm_t struct than contains an fsm_buzzer_t struct
+ */
+void fsm_buzzer_refill (fsm_t *p_this);
+
+/**
+ * @brief Keep the ISR of the timer that controls the duration of the note from reading the melody playing, or let it read it again. \n
+ * Hold the player while the main loop moves the notes of the melody playing: in sequencer mode the ISR reads them to stage the next note.
+ * 
+ * @param p_this 	Pointer to an fsm_t struct than contains an fsm_buzzer_t struct
+ * @param hold True to hold the ISR, false to release it
+ */
+void fsm_buzzer_hold (fsm_t *p_this, bool hold);
+
 /**
  * @brief Set the action to perform on the player. \n 
  * This function sets the action to perform on the player. 
@@ -122,7 +323,8 @@ fsm_t * fsm_buzzer_new (uint32_t buzzer_id);
 void fsm_buzzer_init (fsm_t *p_this, uint32_t buzzer_id);
 
 /**
- * @brief Check if the buzzer finite state machine is playing a melody.
+ * @brief Check if the buzzer finite state machine is playing a melody. \n
+ * A melody played by DMA does not need the CPU until its end, so the player is not active meanwhile.
  * 
  * @param p_this Pointer to an fsm_t struct than contains an fsm_buzzer_t struct
  * @return true 
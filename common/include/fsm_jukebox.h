@@ -13,15 +13,46 @@
 #include <stdint.h>
 #include <fsm.h>
 #include "melodies.h"
+#include "melody_bank.h"
+#include "melody_pool.h"
+#include "melody_upload.h"
+#include "melody_stream.h"
+#include "melody_cache.h"
+#include "command_table.h"
+#include "port_melody_bank.h"
 
 /* Other includes */
 
 
 /* Defines and enums ----------------------------------------------------------*/
 /* Defines */
-#define MELODIES_MEMORY_SIZE 6 /*!< Array of melodies length*/
+#define JUKEBOX_QUEUE_LENGTH 8U /*!< Maximum number of melodies in the play queue*/
 
 /* Enums */
+/**
+ * @brief Opcodes of the commands built in the jukebox, in the binary frames of command_frame.h.
+ * They are part of the protocol: a new command takes a new opcode, and the opcodes of the others never change.
+ */
+enum JUKEBOX_OPCODE {
+  JUKEBOX_OPCODE_PLAY = 0, /*!< Opcode of `play`*/
+  JUKEBOX_OPCODE_STOP = 1, /*!< Opcode of `stop`*/
+  JUKEBOX_OPCODE_PAUSE = 2, /*!< Opcode of `pause`*/
+  JUKEBOX_OPCODE_SPEED = 3, /*!< Opcode of `speed`*/
+  JUKEBOX_OPCODE_NEXT = 4, /*!< Opcode of `next`*/
+  JUKEBOX_OPCODE_SELECT = 5, /*!< Opcode of `select`*/
+  JUKEBOX_OPCODE_INFO = 6, /*!< Opcode of `info`*/
+  JUKEBOX_OPCODE_DRIFT = 7, /*!< Opcode of `drift`*/
+  JUKEBOX_OPCODE_SEEK = 8, /*!< Opcode of `seek`*/
+  JUKEBOX_OPCODE_UPLOAD = 9, /*!< Opcode of `upload`*/
+  JUKEBOX_OPCODE_BANK = 10, /*!< Opcode of `bank`*/
+  JUKEBOX_OPCODE_STREAM = 11, /*!< Opcode of `stream`*/
+  JUKEBOX_OPCODE_CACHE = 12, /*!< Opcode of `cache`*/
+  JUKEBOX_OPCODE_QUEUE = 13, /*!< Opcode of `queue`*/
+  JUKEBOX_OPCODE_DEQUEUE = 14, /*!< Opcode of `dequeue`*/
+  JUKEBOX_OPCODE_CLEAR = 15, /*!< Opcode of `clear`*/
+  JUKEBOX_OPCODE_LIST = 16 /*!< Opcode of `list`*/
+};
+
 /**
  * @brief Enumerator for the Jukebox finite state machine.
  * This enumerator defines the different states that the Jukebox finite state machine can be in. Each state represents a specific 
@@ -39,14 +70,34 @@ enum FSM_JUKEBOX {
 };
 
 /* Typedefs ------------------------------------------------------------------*/
+/**
+ * @brief Melody of the play queue. An uploaded melody is kept by its name: its index changes as the pool evicts and
+ * replaces melodies. The others are kept by their index, which is moved when the bank is swapped.
+ * 
+ */
+typedef struct {
+uint16_t index; /*!< Index in the library of a melody of the bank or streamed*/
+char name[MELODY_POOL_NAME_LENGTH]; /*!< Name of an uploaded melody, found in the pool when it is played. Empty for the others*/
+} jukebox_queue_entry_t;
+
 /**
  * @brief Structure that contains the information of a melody.
  * 
  */
 typedef struct {
 fsm_t f; /*!< Jukebox FSM*/
-melody_t melodies [MELODIES_MEMORY_SIZE]; /*!< Array of melody names of size MELODIES_MEMORY_SIZE*/
-uint8_t melody_idx; /*!< Index of the melody to playing*/
+const melody_bank_t *volatile p_bank; /*!< Pointer to the active read-only melody bank, or NULL if it is not valid. A swap is a single store of this pointer*/
+const melody_bank_t *bank_slots[PORT_MELODY_BANK_NUM_SLOTS]; /*!< Banks loaded in the slots of the double buffer, or NULL if a slot is empty*/
+melody_stream_t stream; /*!< Library of melodies streamed from the storage device. They follow the melodies of the bank*/
+melody_cache_t cache; /*!< Cache of the melodies streamed and of the packed melodies of the bank played lately, keyed by their index in the stream, or by their index in the bank and the generation of the bank*/
+melody_codec_t codec; /*!< Codec of the packed melody of the bank selected, if it is played from the bank because it does not fit in the cache*/
+uint16_t bank_generation; /*!< Generation of the active bank, never 0: it changes on each swap, so the melodies of the old bank are not found in the cache*/
+melody_pool_t pool; /*!< Pool of the melodies uploaded over the USART. They follow the melodies streamed*/
+melody_upload_t upload; /*!< Decoder of the melody being uploaded over the USART*/
+command_table_t commands; /*!< Commands received over the USART: the commands built in and the commands registered by other modules*/
+uint32_t dropped_lines; /*!< Lines dropped by the USART already reported*/
+melody_t melody; /*!< Melody of the library selected: its notes point into the bank, the cache or the pool, or are read from the stream or from a codec*/
+uint16_t melody_idx; /*!< Index of the melody to playing*/
 char *p_melody; /*!< Pointer to the name of the melody playing*/
 fsm_t *p_fsm_button; /*!< Pointer to the button FSM*/
 uint32_t on_off_press_time_ms; /*!< Time in ms to consider ON/OFF*/
@@ -54,6 +105,12 @@ fsm_t *p_fsm_usart; /*!< Pointer to the USART FSM*/
 fsm_t *p_fsm_buzzer; /*!< Pointer to the buzzer FSM*/
 uint32_t next_song_press_time_ms; /*!< Time in ms to consider next song*/
 double 	speed; /*!< Speed of the melody playing*/
+jukebox_queue_entry_t play_queue[JUKEBOX_QUEUE_LENGTH]; /*!< Ring buffer of the melodies queued: each one is played when the melody playing ends*/
+uint8_t queue_head; /*!< Position in the ring buffer of the next melody to play*/
+uint8_t queue_count; /*!< Number of melodies queued*/
+melody_t next_melody; /*!< Melody at the head of the queue, set in the buzzer to follow the melody playing with no gap. Only a melody of the bank is set*/
+uint16_t next_idx; /*!< Index in the library of next_melody*/
+bool stopped; /*!< Flag to indicate that the user has stopped the melody playing: the queue does not advance until a melody is played*/
 } fsm_jukebox_t;
 
 /* Function prototypes and explanation ---------------------------------------*/
@@ -81,5 +138,39 @@ fsm_t * fsm_jukebox_new (fsm_t *p_fsm_button, uint32_t on_off_press_time_ms, fsm
  */
 void fsm_jukebox_init (fsm_t *p_this, fsm_t *p_fsm_button, uint32_t on_off_press_time_ms, fsm_t *p_fsm_usart, fsm_t *p_fsm_buzzer, uint32_t next_song_press_time_ms);
 
+/**
+ * @brief Get the slot of the double buffer of the melody bank that can be reflashed with a new bank: a slot whose bank
+ * is neither the active bank nor the bank of the melody playing.
+ *
+ * @param p_this Pointer to the jukebox FSM
+ * @return int32_t Index of the slot, or -1 if no slot is free
+ */
+int32_t fsm_jukebox_get_free_bank_slot(fsm_t *p_this);
+
+/**
+ * @brief Swap the melody bank for the bank of the free slot, without stopping the jukebox. \n
+ * The new bank is read in place, with no copy of the library: the lookups use it at once, while the melody playing
+ * keeps reading its notes from the old bank until it ends. The slot of the old bank is not free until then.
+ *
+ * @param p_this Pointer to the jukebox FSM
+ * @return int32_t Number of melodies of the new bank, -1 if no slot is free, or -2 if the slot holds no valid bank
+ */
+int32_t fsm_jukebox_swap_bank(fsm_t *p_this);
+
+/**
+ * @brief Register a command of the USART in the jukebox, with no change to the jukebox: its handler is called when a
+ * line starts with its name and has between min_args and max_args arguments.
+ *
+ * @param p_this Pointer to the jukebox FSM
+ * @param p_name Name of the command. It is not copied
+ * @param opcode Opcode of the command in the binary frames, not taken by a command of JUKEBOX_OPCODE, or COMMAND_TABLE_NO_OPCODE
+ * @param min_args Minimum number of arguments
+ * @param max_args Maximum number of arguments, COMMAND_TABLE_ANY_ARGS if the last one is the rest of the line
+ * @param handler Handler of the command
+ * @param p_context Context passed to the handler
+ * @return true if the command has been registered
+ * @return false if the command table is full or there is a command with that name or that opcode
+ */
+bool fsm_jukebox_register_command(fsm_t *p_this, const char *p_name, uint8_t opcode, uint8_t min_args, uint8_t max_args, command_handler_t handler, void *p_context);
 
 #endif /* FSM_JUKEBOX_H_ */
\ No newline at end of file
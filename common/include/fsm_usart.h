@@ -43,8 +43,9 @@ enum FSM_USART {
 typedef struct {
     fsm_t f; /*!< USART FSM*/
     bool data_received; /*!< Flag to indicate that a data has been received*/
-    char in_data [USART_INPUT_BUFFER_LENGTH]; /*!< Input data */
-    char out_data [USART_OUTPUT_BUFFER_LENGTH]; /*!< Output data */
+    char in_data [USART_INPUT_BUFFER_LENGTH + 1]; /*!< Input data. The last character is always a NUL terminator, even if a message fills the buffer */
+    char out_data [USART_OUTPUT_BUFFER_LENGTH]; /*!< Output data: lines queued to be sent, one after the other */
+    uint32_t dropped_replies; /*!< Data to send dropped because it did not fit in out_data */
     uint32_t usart_id; /*!< USART identifier. Must be unique */
 }fsm_usart_t;
 
@@ -101,9 +102,18 @@ bool fsm_usart_check_data_received (fsm_t *p_this);
  */
 void fsm_usart_get_in_data (fsm_t *p_this, char *p_data);
 
+/**
+ * @brief Get the buffer of the data received, to read it in place. \n 
+ * The data is NUL-terminated and stays valid, and may be modified, until **fsm_usart_reset_input_data()** is called.
+ * @param p_this Pointer to an **fsm_t** struct that contains a **fsm_usart_t** struct
+ * @return char* Pointer to the **in_data** array
+ */
+char *fsm_usart_get_in_buffer (fsm_t *p_this);
+
 /**
  * @brief Set the data to send. \n 
- * This function sets the data to send by the USART.
+ * This function sets the data to send by the USART. The data is a line, ended by END_CHAR_CONSTANT: if the lines set
+ * before have not been sent yet, it is queued after them, and it is dropped if it does not fit.
  * 
  * @param p_this Pointer to an **fsm_t** struct that contains a **fsm_usart_t** struct
  * @param p_data Pointer to the array where the data will be copied from the **in_data** array
@@ -111,12 +121,22 @@ void fsm_usart_get_in_data (fsm_t *p_this, char *p_data);
 void fsm_usart_set_out_data (fsm_t *p_this, char *p_data);
 
 /**
- * @brief Reset the input data buffer
+ * @brief Reset the input data buffer. \n 
+ * If more lines have been received, the next one is read into the **in_data** array at once, so that all the lines
+ * pending can be read in a row while **fsm_usart_check_data_received()** returns true.
  * 
  * @param p_this Pointer to an **fsm_t** struct that contains a **fsm_usart_t** struct 
  */
 void fsm_usart_reset_input_data (fsm_t *p_this);
 
+/**
+ * @brief Get the number of lines dropped because they were received while the queue of lines received was full.
+ * 
+ * @param p_this Pointer to an **fsm_t** struct that contains a **fsm_usart_t** struct 
+ * @return uint32_t Number of lines dropped
+ */
+uint32_t fsm_usart_get_dropped_lines (fsm_t *p_this);
+
 /**
  * @brief Check if the USART FSM is active, or not. \n 
  * The USART is active either when it is in the state SEND_DATA or there is data to be read (indicated as true in the field data_received).
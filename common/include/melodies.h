@@ -10,9 +10,27 @@
 /* Includes ------------------------------------------------------------------*/
 /* Standard C includes */
 #include <stdint.h>
+#include <stdbool.h>
 
 /* Defines and enums ----------------------------------------------------------*/
 #define SILENCE 0 /*!< Silence note */
+#define MELODY_MAX_TRACKS 8 /*!< Maximum number of tracks of a multi-track melody */
+
+// Notes of compact melodies: MIDI note numbers (DO4 is 60), e.g. MIDI_NOTE(FAs, 4) is FA#4
+#define MIDI_SILENCE 0 /*!< Silence note of a compact melody */
+#define MIDI_NOTE(note, octave) ((uint8_t)(12 * ((octave) + 1) + MIDI_SEMITONE_##note)) /*!< MIDI note number of a note of an octave */
+#define MIDI_SEMITONE_DO 0    /*!< Semitones of DO above DO */
+#define MIDI_SEMITONE_DOs 1   /*!< Semitones of DO# above DO */
+#define MIDI_SEMITONE_RE 2    /*!< Semitones of RE above DO */
+#define MIDI_SEMITONE_REs 3   /*!< Semitones of RE# above DO */
+#define MIDI_SEMITONE_MI 4    /*!< Semitones of MI above DO */
+#define MIDI_SEMITONE_FA 5    /*!< Semitones of FA above DO */
+#define MIDI_SEMITONE_FAs 6   /*!< Semitones of FA# above DO */
+#define MIDI_SEMITONE_SOL 7   /*!< Semitones of SOL above DO */
+#define MIDI_SEMITONE_SOLs 8  /*!< Semitones of SOL# above DO */
+#define MIDI_SEMITONE_LA 9    /*!< Semitones of LA above DO */
+#define MIDI_SEMITONE_LAs 10  /*!< Semitones of LA# above DO */
+#define MIDI_SEMITONE_SI 11   /*!< Semitones of SI above DO */
 
 // 1st Octave (Primera Octava)
 #define DO1 32.70  /*!< DO1 note frequency */
@@ -129,16 +147,40 @@
 
 /* Typedefs --------------------------------------------------------------------*/
 /**
- * @brief Structure to define the Buzzer melody player FSM.
+ * @brief Structure to define the Buzzer melody player FSM. \n
+ * A melody is stored in one of two formats. The notes of a melody with p_notes are frequencies in Hz (8 + 2 bytes a note with its
+ * duration). The notes of a compact melody (p_notes is NULL) are MIDI note numbers into the shared note table and its durations are
+ * a number of ticks of tick_ms (1 + 1 bytes a note). The notes of a streamed melody (p_stream is not NULL) are compact, and are read
+ * from a melody stream instead of p_midi_notes and p_ticks. The notes of a packed melody (p_codec is not NULL) are compact too, and are
+ * decoded one at a time from its tokens. Use the melody_get_*() accessors to read the notes of any format.
  */
 typedef struct
 {
-    char *p_name;           /*!< Pointer to the name of the melody to play */
-    double *p_notes;        /*!< Pointer to the notes of the melody */
-    uint16_t *p_durations;  /*!< Pointer to the duration of each note of the melody in milliseconds */
-    uint16_t melody_length; /*!< Length of the melody to play */
+    char *p_name;                 /*!< Pointer to the name of the melody to play */
+    const double *p_notes;        /*!< Pointer to the notes of the melody, or NULL if the melody is compact */
+    const uint16_t *p_durations;  /*!< Pointer to the duration of each note of the melody in milliseconds */
+    uint16_t melody_length;       /*!< Length of the melody to play */
+    const uint8_t *p_midi_notes;  /*!< Compact melody: pointer to the MIDI note number of each note, MIDI_SILENCE for a silence */
+    const uint8_t *p_ticks;       /*!< Compact melody: pointer to the duration of each note in ticks */
+    uint16_t tick_ms;             /*!< Compact melody: duration of a tick in milliseconds */
+    struct melody_stream *p_stream; /*!< Streamed compact melody: stream that reads its notes and ticks from a block device, or NULL */
+    struct melody_codec *p_codec;   /*!< Packed compact melody: codec that decodes its notes and ticks from its tokens, or NULL */
+    const uint32_t *p_start_ms;     /*!< Start of the notes 0, timeline_stride, 2 * timeline_stride... in ms, then the total, precomputed by the bank builder, or NULL */
+    uint16_t timeline_stride;       /*!< Notes between two start times of p_start_ms, or of the stream of a streamed melody. 0 if they are not precomputed */
 } melody_t;
 
+/**
+ * @brief Structure to define a multi-track melody: several lines of notes (e.g. melody, harmony and bass) that start together and
+ * are played at the same time. Each track is a melody with its own notes and durations. \n
+ * There can be more tracks than voices in the buzzer: the player allocates a voice to each note that sounds.
+ */
+typedef struct
+{
+    char *p_name;                                /*!< Pointer to the name of the melody to play */
+    const melody_t *p_tracks[MELODY_MAX_TRACKS]; /*!< Pointers to the tracks of the melody. The first one is the main line */
+    uint8_t num_tracks;                          /*!< Number of tracks of the melody */
+} multitrack_melody_t;
+
 // Melodies must be defined in melodies.c, and declared here as extern
 // Scale melody
 extern const melody_t scale_melody; 
@@ -158,4 +200,71 @@ extern const melody_t spanish_anthem;
 // Reversed scale
 extern const melody_t scale_reverse_melody;
 
+// Tracks of the scale harmonized in thirds over a bass line
+extern const melody_t scale_thirds_melody;
+extern const melody_t scale_bass_melody;
+
+// Scale harmonized in thirds over a bass line
+extern const multitrack_melody_t scale_harmony_multitrack;
+
+/* Function prototypes and explanation -------------------------------------------------*/
+/**
+ * @brief Check the format of a melody.
+ *
+ * @param p_melody Pointer to the melody
+ * @return true The notes are MIDI note numbers and the durations ticks
+ * @return false The notes are frequencies in Hz and the durations milliseconds
+ */
+bool melody_is_compact(const melody_t *p_melody);
+
+/**
+ * @brief Get the frequency of a note of a melody.
+ *
+ * @param p_melody Pointer to the melody
+ * @param index Index of the note
+ * @return double Frequency of the note in Hz, SILENCE for a silence
+ */
+double melody_get_note_hz(const melody_t *p_melody, uint32_t index);
+
+/**
+ * @brief Get the frequency of a note of a melody in fixed point. \n
+ * The notes of a compact melody are read from the note table, with no floating point arithmetic.
+ *
+ * @param p_melody Pointer to the melody
+ * @param index Index of the note
+ * @return uint32_t Frequency of the note in Hz, Q16.16 fixed point. 0 for a silence
+ */
+uint32_t melody_get_note_q16(const melody_t *p_melody, uint32_t index);
+
+/**
+ * @brief Get the duration of a note of a melody.
+ *
+ * @param p_melody Pointer to the melody
+ * @param index Index of the note
+ * @return uint32_t Duration of the note in milliseconds
+ */
+uint32_t melody_get_duration_ms(const melody_t *p_melody, uint32_t index);
+
+/**
+ * @brief Decode the notes of a compact melody into arrays of MIDI note numbers and durations in ticks. \n
+ * The notes of a streamed melody are read from its device at once, not through the read-ahead ring. The notes of a packed melody are
+ * decoded in order.
+ *
+ * @param p_melody Pointer to the melody
+ * @param p_midi_notes Pointer to store the melody_length MIDI note numbers
+ * @param p_ticks Pointer to store the melody_length durations in ticks
+ * @return true if the notes have been decoded
+ * @return false if the melody is not compact or its notes cannot be read
+ */
+bool melody_decode(const melody_t *p_melody, uint8_t *p_midi_notes, uint8_t *p_ticks);
+
+/**
+ * @brief Get the memory taken by the notes and durations of a melody.
+ *
+ * @param p_melody Pointer to the melody
+ * @param compact True to get the size in the compact format, false in the format with frequencies in Hz
+ * @return uint32_t Size of the notes and durations in bytes
+ */
+uint32_t melody_get_size(const melody_t *p_melody, bool compact);
+
 #endif /* MELODIES_H_ */
\ No newline at end of file
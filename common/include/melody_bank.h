@@ -0,0 +1,168 @@
+/**
+ * @file melody_bank.h
+ * @brief Header for melody_bank.c file.
+ *
+ * A melody bank is a read-only image with many compact melodies: a header, one entry per melody, an index of the
+ * entries sorted by name, a minimal perfect hash of the names, the start times of the notes of each melody and the packed notes and durations. It is used in place (from flash, or from a file mapped
+ * in memory on the native platform): a melody is read into a melody_t view whose pointers point into the bank, so the
+ * RAM used does not depend on the number of melodies. The payload of a melody flagged MELODY_BANK_FLAG_PACKED is the
+ * tokens of a packed melody (see melody_codec.h) instead of its notes and durations: it is read with a melody codec
+ * that decodes the tokens in place. The bank is built by tools/build_melody_bank.py from the melodies
+ * of melodies.c and from the .rtttl and .mid files of assets/melodies.
+ *
+ * @author Javier de Ponte Hernando
+ * @author Roberto Maldonado Macafee
+ * @date 18/10/2026
+ */
+
+#ifndef MELODY_BANK_H_
+#define MELODY_BANK_H_
+
+/* Includes ------------------------------------------------------------------*/
+/* Standard C includes */
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Other includes */
+#include "melodies.h"
+#include "melody_codec.h"
+
+/* Defines and enums ----------------------------------------------------------*/
+#define MELODY_BANK_MAGIC 0x4B4E424DU /*!< Magic number of a melody bank: "MBNK" */
+#define MELODY_BANK_VERSION 5         /*!< Version of the format of the melody bank */
+#define MELODY_BANK_HASH_BASIS 2166136261U /*!< Offset basis of the FNV-1a hash of the names */
+#define MELODY_BANK_HASH_PRIME 16777619U   /*!< Prime of the FNV-1a hash of the names */
+#define MELODY_BANK_FLAG_PACKED 0x0001U    /*!< Flag of a melody whose payload is the tokens of a packed melody */
+
+/* Typedefs --------------------------------------------------------------------*/
+/**
+ * @brief Header of a melody bank. The entries of the melodies follow it.
+ */
+typedef struct
+{
+    uint32_t magic;        /*!< MELODY_BANK_MAGIC */
+    uint16_t version;      /*!< MELODY_BANK_VERSION */
+    uint16_t num_melodies; /*!< Number of melodies of the bank */
+    uint32_t size;         /*!< Size of the bank in bytes */
+    uint32_t index_offset; /*!< Offset of the name index: num_melodies uint16_t entry numbers sorted by name */
+    uint32_t hash_offset;  /*!< Offset of the perfect hash of the names, 0 if there is none: hash_buckets uint16_t displacements, then num_melodies uint16_t entry numbers, one per slot */
+    uint32_t hash_buckets; /*!< Number of buckets of the perfect hash */
+} melody_bank_t;
+
+/**
+ * @brief Entry of a melody in a melody bank. Offsets are from the start of the bank.
+ */
+typedef struct
+{
+    uint32_t name_offset;   /*!< Offset of the NUL-terminated name of the melody */
+    uint32_t notes_offset;  /*!< Offset of the payload of the melody: its MIDI note numbers followed by its durations in ticks, or its tokens if it is packed */
+    uint32_t duration_ms;   /*!< Total duration of the melody in milliseconds, precomputed by the bank builder */
+    uint32_t timeline_offset; /*!< Offset of the start times in ms of the notes 0, timeline_stride, 2 * timeline_stride... (uint32_t, 4-byte aligned), then of the total duration. 0 if there are none */
+    uint32_t packed_size;   /*!< Size of the tokens of a packed melody in bytes, 0 if it is not packed */
+    uint16_t melody_length; /*!< Length of the melody */
+    uint16_t tick_ms;       /*!< Duration of a tick in milliseconds */
+    uint16_t timeline_stride; /*!< Notes between two start times, the smallest that keeps them within MELODY_TIMELINE_MAX_ENTRIES */
+    uint16_t flags;         /*!< MELODY_BANK_FLAG_PACKED if the payload is the tokens of a packed melody */
+} melody_bank_entry_t;
+
+/* Function prototypes and explanation -------------------------------------------------*/
+/**
+ * @brief Check a melody bank image: magic number, version, and that every offset is inside the image.
+ *
+ * @param p_data Pointer to the image, 4-byte aligned
+ * @param size Size of the image in bytes
+ * @return const melody_bank_t* Pointer to the bank, or NULL if the image is not a valid bank
+ */
+const melody_bank_t *melody_bank_open(const void *p_data, uint32_t size);
+
+/**
+ * @brief Get the number of melodies of a bank.
+ *
+ * @param p_bank Pointer to the bank, or NULL
+ * @return uint32_t Number of melodies, 0 if there is no bank
+ */
+uint32_t melody_bank_get_length(const melody_bank_t *p_bank);
+
+/**
+ * @brief Get the name of a melody of a bank.
+ *
+ * @param p_bank Pointer to the bank
+ * @param index Index of the melody, in playlist order
+ * @return const char* Name of the melody, or NULL if there is no such melody
+ */
+const char *melody_bank_get_name(const melody_bank_t *p_bank, uint32_t index);
+
+/**
+ * @brief Get the number of start times of the notes of a melody of a bank, before its total duration.
+ *
+ * @param melody_length Length of the melody
+ * @param timeline_stride Notes between two start times, 0 if there are none
+ * @return uint32_t Number of start times
+ */
+uint32_t melody_bank_get_timeline_entries(uint32_t melody_length, uint32_t timeline_stride);
+
+/**
+ * @brief Check whether a melody of a bank is packed: it is read with melody_bank_get_packed().
+ *
+ * @param p_bank Pointer to the bank
+ * @param index Index of the melody, in playlist order
+ * @return true if the melody exists and is packed
+ * @return false otherwise
+ */
+bool melody_bank_is_packed(const melody_bank_t *p_bank, uint32_t index);
+
+/**
+ * @brief Get a melody of a bank. The melody is a compact melody_t that points into the bank, with the start times of
+ * its notes if the bank has them.
+ *
+ * @param p_bank Pointer to the bank
+ * @param index Index of the melody, in playlist order
+ * @param p_melody Pointer to store the melody
+ * @return true if the melody exists
+ * @return false otherwise, or if the melody is packed
+ */
+bool melody_bank_get_melody(const melody_bank_t *p_bank, uint32_t index, melody_t *p_melody);
+
+/**
+ * @brief Get a packed melody of a bank. The codec is set to decode the tokens of the melody in place, and the melody
+ * is a compact melody_t that reads its notes from the codec, with the start times of its notes if the bank has them.
+ *
+ * @param p_bank Pointer to the bank
+ * @param index Index of the melody, in playlist order
+ * @param p_codec Pointer to the codec of the melody. It must not be changed while the melody is played
+ * @param p_melody Pointer to store the melody
+ * @return true if the melody exists and is packed
+ * @return false otherwise
+ */
+bool melody_bank_get_packed(const melody_bank_t *p_bank, uint32_t index, melody_codec_t *p_codec, melody_t *p_melody);
+
+/**
+ * @brief Get the total duration of a melody of a bank, at normal speed.
+ *
+ * @param p_bank Pointer to the bank
+ * @param index Index of the melody, in playlist order
+ * @return uint32_t Duration of the melody in milliseconds, 0 if there is no such melody
+ */
+uint32_t melody_bank_get_duration_ms(const melody_bank_t *p_bank, uint32_t index);
+
+/**
+ * @brief Find a melody of a bank by its name. With the perfect hash of the bank a lookup takes two hashes and one
+ * string comparison, whatever the number of melodies. Without it, it is a binary search in the name index.
+ *
+ * @param p_bank Pointer to the bank
+ * @param p_name Name of the melody
+ * @return int32_t Index of the melody, in playlist order, or -1 if there is no melody with that name
+ */
+int32_t melody_bank_find(const melody_bank_t *p_bank, const char *p_name);
+
+/**
+ * @brief Hash a name for the perfect hash of a bank: FNV-1a from a seeded basis, followed by the final mix of
+ * MurmurHash3. tools/build_melody_bank.py computes the same hash.
+ *
+ * @param p_name NUL-terminated name
+ * @param seed Seed: 0 for the bucket of the name, the displacement of its bucket for its slot
+ * @return uint32_t Hash of the name
+ */
+uint32_t melody_bank_hash(const char *p_name, uint32_t seed);
+
+#endif /* MELODY_BANK_H_ */
@@ -0,0 +1,102 @@
+/**
+ * @file melody_cache.h
+ * @brief Header for melody_cache.c file.
+ *
+ * A melody cache keeps the notes of the last melodies decoded from a slow or compressed source (e.g. a storage device)
+ * in RAM, as compact melodies, so a melody played again is not decoded again. It has a fixed number of slots of a
+ * fixed size, with no dynamic memory, and melodies are keyed by an id chosen by the caller. When every slot is taken
+ * the least recently used melody is evicted.
+ *
+ * As in the melody pool, the melody_t view of the melody playing can be attached to the cache: its slot is never
+ * evicted while the view points to it.
+ *
+ * @author Javier de Ponte Hernando
+ * @author Roberto Maldonado Macafee
+ * @date 18/10/2026
+ */
+
+#ifndef MELODY_CACHE_H_
+#define MELODY_CACHE_H_
+
+/* Includes ------------------------------------------------------------------*/
+/* Standard C includes */
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Other includes */
+#include "melodies.h"
+
+/* Defines and enums ----------------------------------------------------------*/
+#define MELODY_CACHE_NUM_SLOTS 4U     /*!< Melodies of the cache */
+#define MELODY_CACHE_SLOT_NOTES 256U  /*!< Maximum length of a melody of the cache: two bytes per note */
+#define MELODY_CACHE_NAME_LENGTH 32U  /*!< Maximum length of the name of a melody, including the NUL terminator */
+
+/* Typedefs --------------------------------------------------------------------*/
+/**
+ * @brief Slot of a melody of a cache.
+ */
+typedef struct
+{
+    bool valid;                                  /*!< The slot holds a melody */
+    uint32_t id;                                 /*!< Id of the melody */
+    char name[MELODY_CACHE_NAME_LENGTH];         /*!< NUL-terminated name of the melody */
+    uint16_t melody_length;                      /*!< Length of the melody */
+    uint16_t tick_ms;                            /*!< Duration of a tick in milliseconds */
+    uint32_t last_used;                          /*!< Value of the use counter of the cache when the melody was stored or read last */
+    uint8_t midi_notes[MELODY_CACHE_SLOT_NOTES]; /*!< MIDI note numbers of the melody */
+    uint8_t ticks[MELODY_CACHE_SLOT_NOTES];      /*!< Durations of the melody in ticks */
+} melody_cache_slot_t;
+
+/**
+ * @brief Melody cache.
+ */
+typedef struct
+{
+    melody_cache_slot_t slots[MELODY_CACHE_NUM_SLOTS]; /*!< Melodies of the cache */
+    uint32_t use_counter;                              /*!< Counter of the uses of the melodies, for the LRU eviction */
+    uint32_t hits;                                     /*!< Melodies read from the cache */
+    uint32_t misses;                                   /*!< Melodies looked up and not found */
+    uint32_t evictions;                                /*!< Melodies evicted to store others */
+    const melody_t *p_view;                            /*!< View of the melody playing, or NULL */
+} melody_cache_t;
+
+/* Function prototypes and explanation -------------------------------------------------*/
+/**
+ * @brief Initialize an empty melody cache, with its counters cleared.
+ *
+ * @param p_cache Pointer to the cache
+ * @param p_view Pointer to the view of the melody playing, whose slot is not evicted, or NULL
+ */
+void melody_cache_init(melody_cache_t *p_cache, const melody_t *p_view);
+
+/**
+ * @brief Look up a melody in the cache. It counts as a hit or a miss.
+ *
+ * @param p_cache Pointer to the cache
+ * @param id Id of the melody
+ * @param p_melody Pointer to store the view of the melody if it is found: its notes point into the cache
+ * @return true if the melody is in the cache
+ * @return false otherwise
+ */
+bool melody_cache_get(melody_cache_t *p_cache, uint32_t id, melody_t *p_melody);
+
+/**
+ * @brief Decode a melody into the cache, evicting the least recently used melody if there is no free slot.
+ *
+ * @param p_cache Pointer to the cache
+ * @param id Id of the melody
+ * @param p_source Pointer to the melody to decode, in any compact format
+ * @param p_melody Pointer to store the view of the melody stored. It may be the source
+ * @return true if the melody has been stored
+ * @return false if it is not compact, it is longer than a slot, every slot is in use or it cannot be decoded
+ */
+bool melody_cache_store(melody_cache_t *p_cache, uint32_t id, const melody_t *p_source, melody_t *p_melody);
+
+/**
+ * @brief Drop every melody of the cache but the melody playing, e.g. when the ids refer to a new source.
+ *
+ * @param p_cache Pointer to the cache
+ */
+void melody_cache_clear(melody_cache_t *p_cache);
+
+#endif /* MELODY_CACHE_H_ */
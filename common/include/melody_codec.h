@@ -0,0 +1,126 @@
+/**
+ * @file melody_codec.h
+ * @brief Header for melody_codec.c file.
+ *
+ * A packed melody is a compact melody encoded as a sequence of tokens, one byte each plus their operands:
+ * - The pitch is delta-coded: a note is the MIDI note number of the last note that was not a silence plus a delta.
+ * - The durations are run-length coded: a note carries its ticks only when they change, and a note repeated (same
+ *   pitch and same ticks) is a single run token.
+ * - A phrase repeated is a back-reference to the tokens of its first occurrence. The tokens replayed keep their
+ *   deltas, so the phrase is decoded exactly as the first time. A back-reference never points to another one.
+ *
+ * | Token           | Bytes           | Note                                                                         |
+ * |-----------------|-----------------|------------------------------------------------------------------------------|
+ * | `00dddddd`      | 1               | Pitch + d - 32, same ticks                                                   |
+ * | `01dddddd`      | 2: ticks        | Pitch + d - 32, new ticks                                                    |
+ * | `100nnnnn`      | 1               | The previous note, repeated n + 1 times                                      |
+ * | `0xA0`/`0xA1`   | 1/2: ticks      | Silence, same/new ticks. The pitch is kept                                   |
+ * | `0xA2`/`0xA3`   | 2/3: note ticks | MIDI note number, same/new ticks, for jumps out of the range of the deltas   |
+ * | `11nnnnnn`      | 3: offset       | Replay the n + 2 tokens at the offset (16 bits, little endian) of the tokens |
+ *
+ * A packed melody is decoded by a melody codec one note at a time, as the notes are played: the state of the decoder
+ * does not depend on the length of the melody, and no decoded copy of the melody is kept in RAM. The notes are read in
+ * order; reading a note before the previous one decodes the melody again from the start.
+ *
+ * @author Javier de Ponte Hernando
+ * @author Roberto Maldonado Macafee
+ * @date 18/10/2026
+ */
+
+#ifndef MELODY_CODEC_H_
+#define MELODY_CODEC_H_
+
+/* Includes ------------------------------------------------------------------*/
+/* Standard C includes */
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Other includes */
+#include "melodies.h"
+
+/* Defines and enums ----------------------------------------------------------*/
+#define MELODY_CODEC_NOTE 0x00U           /*!< Token of a note delta-coded, with the same ticks */
+#define MELODY_CODEC_NOTE_TICKS 0x40U     /*!< Token of a note delta-coded, with new ticks */
+#define MELODY_CODEC_RUN 0x80U            /*!< Token of a run of the previous note */
+#define MELODY_CODEC_SILENCE 0xA0U        /*!< Token of a silence, with the same ticks */
+#define MELODY_CODEC_SILENCE_TICKS 0xA1U  /*!< Token of a silence, with new ticks */
+#define MELODY_CODEC_ABSOLUTE 0xA2U       /*!< Token of a note by its MIDI note number, with the same ticks */
+#define MELODY_CODEC_ABSOLUTE_TICKS 0xA3U /*!< Token of a note by its MIDI note number, with new ticks */
+#define MELODY_CODEC_BACKREF 0xC0U        /*!< Token of a back-reference */
+
+#define MELODY_CODEC_DELTA_BIAS 32         /*!< Bias of the delta of the pitch: deltas from -32 to +31 */
+#define MELODY_CODEC_RUN_MAX_NOTES 32U     /*!< Maximum number of notes of a run token */
+#define MELODY_CODEC_BACKREF_MIN_TOKENS 2U /*!< Minimum number of tokens of a back-reference */
+#define MELODY_CODEC_BACKREF_MAX_TOKENS 65U /*!< Maximum number of tokens of a back-reference */
+#define MELODY_CODEC_MAX_SIZE 0x10000U     /*!< Maximum size of the tokens of a melody: the offsets have 16 bits */
+#define MELODY_CODEC_INITIAL_PITCH 60U     /*!< Pitch before the first note: the delta of the first note is from C4 */
+#define MELODY_CODEC_NO_NOTE UINT32_MAX    /*!< Index of the current note of a decoder before the first note */
+
+/* Typedefs --------------------------------------------------------------------*/
+/**
+ * @brief Melody codec: tokens of a packed melody and state of its decoder.
+ */
+typedef struct melody_codec
+{
+    const uint8_t *p_data;  /*!< Tokens of the melody */
+    uint32_t size;          /*!< Size of the tokens in bytes */
+    uint16_t melody_length; /*!< Length of the melody */
+    uint32_t index;         /*!< Index of the current note, MELODY_CODEC_NO_NOTE before the first one */
+    uint32_t position;      /*!< Offset of the next token */
+    uint32_t ref_return;    /*!< Offset of the token after the back-reference replayed, 0 if none is */
+    uint8_t ref_tokens;     /*!< Tokens of the back-reference left to replay */
+    uint8_t run;            /*!< Repetitions of the current note left */
+    uint8_t pitch;          /*!< MIDI note number of the last note that was not a silence: base of the deltas */
+    uint8_t midi_note;      /*!< MIDI note number of the current note */
+    uint8_t ticks;          /*!< Duration of the current note in ticks */
+    uint8_t prev_midi_note; /*!< MIDI note number of the note before the current one */
+    uint8_t prev_ticks;     /*!< Duration of the note before the current one in ticks */
+} melody_codec_t;
+
+/* Function prototypes and explanation -------------------------------------------------*/
+/**
+ * @brief Encode the notes of a compact melody into tokens. \n
+ * The notes are first written as tokens with no back-references, which are then replaced in place: the buffer must
+ * have room for them, 3 bytes a note in the worst case, although the melody encoded is usually much smaller.
+ *
+ * @param p_midi_notes Pointer to the MIDI note numbers, MIDI_SILENCE for a silence
+ * @param p_ticks Pointer to the durations in ticks
+ * @param length Number of notes
+ * @param p_data Pointer to store the tokens
+ * @param size Size of the buffer in bytes
+ * @return int32_t Size of the tokens in bytes, or -1 if they do not fit in the buffer or in MELODY_CODEC_MAX_SIZE
+ */
+int32_t melody_codec_encode(const uint8_t *p_midi_notes, const uint8_t *p_ticks, uint32_t length, uint8_t *p_data, uint32_t size);
+
+/**
+ * @brief Initialize a melody codec to decode the tokens of a packed melody. \n
+ * The melody is played with a melody_t whose p_codec points to the codec, with its length and its tick.
+ *
+ * @param p_codec Pointer to the codec
+ * @param p_data Pointer to the tokens
+ * @param size Size of the tokens in bytes
+ * @param melody_length Length of the melody
+ */
+void melody_codec_init(melody_codec_t *p_codec, const uint8_t *p_data, uint32_t size, uint16_t melody_length);
+
+/**
+ * @brief Go back to the start of the melody: the next note decoded is the first one.
+ *
+ * @param p_codec Pointer to the codec
+ */
+void melody_codec_rewind(melody_codec_t *p_codec);
+
+/**
+ * @brief Get a note of the melody. The current note and the one before are read with no decoding, the next notes are
+ * decoded from the current one, and the notes before are decoded from the start.
+ *
+ * @param p_codec Pointer to the codec
+ * @param index Index of the note
+ * @param p_midi_note Pointer to store the MIDI note number
+ * @param p_ticks Pointer to store the duration in ticks
+ * @return true if the note has been decoded
+ * @return false if there is no such note or the tokens are not valid: a silence of no duration is stored
+ */
+bool melody_codec_get_note(melody_codec_t *p_codec, uint32_t index, uint8_t *p_midi_note, uint8_t *p_ticks);
+
+#endif /* MELODY_CODEC_H_ */
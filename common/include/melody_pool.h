@@ -0,0 +1,167 @@
+/**
+ * @file melody_pool.h
+ * @brief Header for melody_pool.c file.
+ *
+ * A melody pool keeps the compact melodies uploaded at runtime in a fixed-size arena, with no dynamic memory. Stored
+ * melodies are packed from the start of the arena (the MIDI notes of a melody followed by its durations in ticks).
+ * The melody being stored grows in the free space in between: its notes after the stored melodies and its ticks
+ * downwards from the end of the arena, so its length does not have to be known in advance. When there is no room,
+ * the least recently used melody is evicted and the arena is compacted.
+ *
+ * The melody_t view of the melody playing can be attached to the pool: that melody is never evicted, and the view is
+ * updated when the compaction moves its notes, so it can be played while other melodies are uploaded. If the player reads
+ * the view from an interrupt, a hold function keeps it from reading while the notes and the view are moved.
+ *
+ * @author Javier de Ponte Hernando
+ * @author Roberto Maldonado Macafee
+ * @date 18/10/2026
+ */
+
+#ifndef MELODY_POOL_H_
+#define MELODY_POOL_H_
+
+/* Includes ------------------------------------------------------------------*/
+/* Standard C includes */
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Other includes */
+#include "melodies.h"
+
+/* Defines and enums ----------------------------------------------------------*/
+#define MELODY_POOL_ARENA_SIZE 1024U  /*!< Bytes of the arena: two bytes per note */
+#define MELODY_POOL_MAX_MELODIES 8U   /*!< Maximum number of melodies of the pool */
+#define MELODY_POOL_NAME_LENGTH 16U   /*!< Maximum length of the name of a melody, including the NUL terminator */
+
+/* Typedefs --------------------------------------------------------------------*/
+/**
+ * @brief Function that keeps the player from reading the view of the melody playing, or lets it read it again.
+ *
+ * @param p_arg Argument given with the function
+ * @param hold true before the notes of the melody playing and its view are moved, false after
+ */
+typedef void (*melody_pool_hold_t)(void *p_arg, bool hold);
+
+/**
+ * @brief Slot of a melody of a pool.
+ */
+typedef struct
+{
+    char name[MELODY_POOL_NAME_LENGTH]; /*!< NUL-terminated name of the melody. Empty if the slot is free */
+    uint16_t offset;                    /*!< Offset of the MIDI note numbers of the melody in the arena. The ticks follow them */
+    uint16_t melody_length;             /*!< Length of the melody */
+    uint16_t tick_ms;                   /*!< Duration of a tick in milliseconds */
+    uint32_t last_used;                 /*!< Value of the use counter of the pool when the melody was stored or read last */
+} melody_pool_slot_t;
+
+/**
+ * @brief Melody pool.
+ */
+typedef struct
+{
+    uint8_t arena[MELODY_POOL_ARENA_SIZE];                /*!< Notes and ticks of the melodies */
+    melody_pool_slot_t slots[MELODY_POOL_MAX_MELODIES];   /*!< Melodies of the pool, in the order of their indexes */
+    uint16_t used;                                        /*!< Bytes used by the stored melodies from the start of the arena */
+    int8_t upload_slot;                                   /*!< Slot of the melody being stored, or -1 */
+    uint16_t upload_length;                               /*!< Notes of the melody being stored */
+    uint32_t use_counter;                                 /*!< Counter of the uses of the melodies, for the LRU eviction */
+    uint32_t evictions;                                   /*!< Number of melodies evicted */
+    melody_t *p_view;                                     /*!< View of the melody playing, or NULL */
+    melody_pool_hold_t hold;                              /*!< Function that holds the player while the view is moved, or NULL */
+    void *p_hold_arg;                                     /*!< Argument of the hold function */
+} melody_pool_t;
+
+/* Function prototypes and explanation -------------------------------------------------*/
+/**
+ * @brief Initialize an empty melody pool.
+ *
+ * @param p_pool Pointer to the pool
+ * @param p_view Pointer to the view of the melody playing, kept valid by the pool, or NULL
+ */
+void melody_pool_init(melody_pool_t *p_pool, melody_t *p_view);
+
+/**
+ * @brief Set the function that holds the player while the compaction moves the melody playing.
+ *
+ * @param p_pool Pointer to the pool
+ * @param hold Hold function, or NULL if the view is only read by the caller of the pool
+ * @param p_arg Argument given with the hold function
+ */
+void melody_pool_set_hold(melody_pool_t *p_pool, melody_pool_hold_t hold, void *p_arg);
+
+/**
+ * @brief Get the number of melodies stored in a pool.
+ *
+ * @param p_pool Pointer to the pool
+ * @return uint32_t Number of melodies, not counting the melody being stored
+ */
+uint32_t melody_pool_get_length(const melody_pool_t *p_pool);
+
+/**
+ * @brief Get a melody of a pool. The melody is a compact melody_t that points into the arena. Reading a melody makes
+ * it the most recently used one.
+ *
+ * @param p_pool Pointer to the pool
+ * @param index Index of the melody
+ * @param p_melody Pointer to store the melody
+ * @return true if the melody exists
+ * @return false otherwise
+ */
+bool melody_pool_get_melody(melody_pool_t *p_pool, uint32_t index, melody_t *p_melody);
+
+/**
+ * @brief Find a melody of a pool by its name.
+ *
+ * @param p_pool Pointer to the pool
+ * @param p_name Name of the melody
+ * @return int32_t Index of the melody, or -1 if there is no melody with that name
+ */
+int32_t melody_pool_find(const melody_pool_t *p_pool, const char *p_name);
+
+/**
+ * @brief Start storing a melody in a pool. A melody being stored is aborted. A melody with the same name is replaced,
+ * and if every slot is used the least recently used melody is evicted.
+ *
+ * @param p_pool Pointer to the pool
+ * @param p_name Name of the melody, shorter than MELODY_POOL_NAME_LENGTH
+ * @return true if the melody can be stored
+ * @return false if the name is not valid, or the melody with that name is playing, or no slot can be freed
+ */
+bool melody_pool_begin(melody_pool_t *p_pool, const char *p_name);
+
+/**
+ * @brief Add a note to the melody being stored. If the arena is full the least recently used melodies are evicted.
+ *
+ * @param p_pool Pointer to the pool
+ * @param midi_note MIDI note number, or MIDI_SILENCE
+ * @param ticks Duration of the note in ticks
+ * @return true if the note has been added
+ * @return false if no melody is being stored, or there is no room for the note
+ */
+bool melody_pool_append(melody_pool_t *p_pool, uint8_t midi_note, uint8_t ticks);
+
+/**
+ * @brief Finish storing a melody. Its ticks are moved after its notes, and the melody can be read.
+ *
+ * @param p_pool Pointer to the pool
+ * @param tick_ms Duration of a tick of the melody in milliseconds
+ * @return int32_t Index of the melody, or -1 if no melody is being stored or it has no notes (it is then aborted)
+ */
+int32_t melody_pool_commit(melody_pool_t *p_pool, uint16_t tick_ms);
+
+/**
+ * @brief Abort storing a melody, freeing its slot and its notes.
+ *
+ * @param p_pool Pointer to the pool
+ */
+void melody_pool_abort(melody_pool_t *p_pool);
+
+/**
+ * @brief Get the number of melodies evicted from a pool to make room for others.
+ *
+ * @param p_pool Pointer to the pool
+ * @return uint32_t Number of melodies evicted
+ */
+uint32_t melody_pool_get_evictions(const melody_pool_t *p_pool);
+
+#endif /* MELODY_POOL_H_ */
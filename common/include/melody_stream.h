@@ -0,0 +1,208 @@
+/**
+ * @file melody_stream.h
+ * @brief Header for melody_stream.c file.
+ *
+ * A melody stream plays the melodies of a library that is not mapped in memory: a melody bank image (the same format
+ * as melody_bank.h) stored in a block device, such as an SPI flash or an SD card. Only the melody open is resident, and
+ * only a window of its notes: a read-ahead ring that the main loop refills with melody_stream_refill() while the notes
+ * play, one block at a time.
+ *
+ * The player reads the notes from the ring only, so it can read them from an interrupt: reading a note never accesses
+ * the device nor moves the ring. A note that is not in the ring when it has to be played is fetched from the device by
+ * the main loop with melody_stream_fetch(), so there is no gap but the note may be late. When the note is the next one
+ * to be read ahead the refill has fallen behind the player: it is an underrun, and it is counted. Other misses are
+ * jumps (e.g. a seek) and are not underruns.
+ *
+ * The ring has a single producer, the main loop, and a single consumer, the player. A refill moves `first` past the
+ * notes it overwrites before it reads the device, and `tail` past the notes read after, so the player never reads a
+ * note while it is written.
+ *
+ * A packed melody of the library (see melody_bank.h) has no ring: its tokens are read at once when it is open, into
+ * the room of the ring, and its notes are decoded from RAM by the codec of the stream.
+ *
+ * @author Javier de Ponte Hernando
+ * @author Roberto Maldonado Macafee
+ * @date 18/10/2026
+ */
+
+#ifndef MELODY_STREAM_H_
+#define MELODY_STREAM_H_
+
+/* Includes ------------------------------------------------------------------*/
+/* Standard C includes */
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Other includes */
+#include "melodies.h"
+#include "melody_codec.h"
+
+/* Defines and enums ----------------------------------------------------------*/
+#define MELODY_STREAM_RING_NOTES 128U   /*!< Notes of the read-ahead ring: two bytes per note */
+#define MELODY_STREAM_BLOCK_NOTES 32U   /*!< Notes read from the device at a time */
+#define MELODY_STREAM_HISTORY_NOTES 16U /*!< Notes already played kept in the ring, for the queries of the position */
+#define MELODY_STREAM_NAME_LENGTH 32U   /*!< Maximum length of the name of a melody, including the NUL terminator */
+
+/* Typedefs --------------------------------------------------------------------*/
+/**
+ * @brief Function to read a block device.
+ *
+ * @param address Address of the data in the device
+ * @param p_data Pointer to store the data
+ * @param size Number of bytes to read
+ * @return true if the data has been read
+ * @return false otherwise
+ */
+typedef bool (*melody_stream_read_t)(uint32_t address, void *p_data, uint32_t size);
+
+/**
+ * @brief Melody stream: library of melodies in a block device and read-ahead ring of the melody open.
+ */
+typedef struct melody_stream
+{
+    melody_stream_read_t read;                    /*!< Function to read the device */
+    uint16_t num_melodies;                        /*!< Melodies of the library, 0 if the device holds no valid library */
+    uint32_t size;                                /*!< Size of the library in bytes */
+    uint32_t hash_offset;                         /*!< Address of the perfect hash of the names of the library, 0 if there is none */
+    uint32_t hash_buckets;                        /*!< Number of buckets of the perfect hash */
+    char name[MELODY_STREAM_NAME_LENGTH];         /*!< Name of the melody open */
+    uint32_t notes_address;                       /*!< Address of the MIDI note numbers of the melody open. The ticks follow them */
+    uint16_t melody_length;                       /*!< Length of the melody open */
+    uint32_t timeline_address;                    /*!< Address of the start times of the notes of the melody open, 0 if there are none */
+    union
+    {
+        struct
+        {
+            uint8_t midi_notes[MELODY_STREAM_RING_NOTES]; /*!< Ring of MIDI note numbers: note i is at i % MELODY_STREAM_RING_NOTES */
+            uint8_t ticks[MELODY_STREAM_RING_NOTES];      /*!< Ring of durations in ticks */
+        };
+        uint8_t tokens[2U * MELODY_STREAM_RING_NOTES];    /*!< Tokens of the melody open if it is packed: it has no ring */
+    };
+    melody_codec_t codec;                         /*!< Codec of the melody open if it is packed */
+    volatile uint32_t first;                      /*!< Index of the first note in the ring */
+    volatile uint32_t tail;                       /*!< Index of the next note to read ahead: the ring holds the notes first to tail - 1 */
+    volatile uint32_t position;                   /*!< Index of the last note read from the ring by the player */
+    uint32_t underruns;                           /*!< Notes read by the player before the refill had read them ahead */
+    uint32_t reads;                               /*!< Blocks read from the device */
+} melody_stream_t;
+
+/* Function prototypes and explanation -------------------------------------------------*/
+/**
+ * @brief Initialize a melody stream: read and check the header of the library in a device.
+ *
+ * @param p_stream Pointer to the stream
+ * @param read Function to read the device
+ * @param device_size Size of the device in bytes, 0 if there is none
+ * @return true if the device holds a valid library
+ * @return false otherwise: the library is empty
+ */
+bool melody_stream_init(melody_stream_t *p_stream, melody_stream_read_t read, uint32_t device_size);
+
+/**
+ * @brief Get the number of melodies of the library of a stream.
+ *
+ * @param p_stream Pointer to the stream
+ * @return uint32_t Number of melodies
+ */
+uint32_t melody_stream_get_length(const melody_stream_t *p_stream);
+
+/**
+ * @brief Find a melody of the library by its name. With the perfect hash of the library it takes a constant number of
+ * reads of the device; without it, the names are read one by one.
+ *
+ * @param p_stream Pointer to the stream
+ * @param p_name Name of the melody
+ * @return int32_t Index of the melody, or -1 if there is no melody with that name or the device cannot be read
+ */
+int32_t melody_stream_find(melody_stream_t *p_stream, const char *p_name);
+
+/**
+ * @brief Open a melody of the library, and fill the ring with its first notes. The melody open before is closed.
+ *
+ * @param p_stream Pointer to the stream
+ * @param index Index of the melody
+ * @param p_melody Pointer to store the view of the melody: a compact melody that reads its notes from the stream, or
+ * from the codec of the stream if it is packed
+ * @return true if the melody has been open
+ * @return false if there is no such melody, it cannot be read or its tokens do not fit in the ring
+ */
+bool melody_stream_open(melody_stream_t *p_stream, uint32_t index, melody_t *p_melody);
+
+/**
+ * @brief Read the start times of the notes of the melody open, precomputed by the bank builder, in one read of the
+ * device. The notes are not read, and the ring is not changed.
+ *
+ * @param p_stream Pointer to the stream
+ * @param p_start_ms Pointer to store the start times of the notes 0, timeline_stride, 2 * timeline_stride... in ms,
+ * then the total duration (see melody_bank_entry_t)
+ * @param count Number of start times, including the total duration
+ * @return true if the start times have been read
+ * @return false if the library has none for the melody or they cannot be read
+ */
+bool melody_stream_read_timeline(melody_stream_t *p_stream, uint32_t *p_start_ms, uint32_t count);
+
+/**
+ * @brief Go back to the start of the melody open: fill the ring with its first notes and clear the counters.
+ *
+ * @param p_stream Pointer to the stream
+ */
+void melody_stream_rewind(melody_stream_t *p_stream);
+
+/**
+ * @brief Read ahead the next notes of the melody open, one block at most, if there is room in the ring.
+ * Call it from the main loop while the melody plays.
+ *
+ * @param p_stream Pointer to the stream
+ */
+void melody_stream_refill(melody_stream_t *p_stream);
+
+/**
+ * @brief Get a note of the melody open from the ring, with no access to the device. It can be called from an interrupt.
+ *
+ * @param p_stream Pointer to the stream
+ * @param index Index of the note
+ * @param p_midi_note Pointer to store the MIDI note number
+ * @param p_ticks Pointer to store the duration in ticks
+ * @return true if the note has been read
+ * @return false if there is no such note or it is not in the ring: a silence of no duration is stored
+ */
+bool melody_stream_get_note(melody_stream_t *p_stream, uint32_t index, uint8_t *p_midi_note, uint8_t *p_ticks);
+
+/**
+ * @brief Check if a note of the melody open is in the ring, so it can be read with no access to the device. It can be
+ * called from an interrupt.
+ *
+ * @param p_stream Pointer to the stream
+ * @param index Index of the note
+ * @return true if the note is in the ring
+ * @return false otherwise
+ */
+bool melody_stream_has_note(const melody_stream_t *p_stream, uint32_t index);
+
+/**
+ * @brief Make sure a note of the melody open is in the ring, reading it from the device if it is not. If it is the
+ * next note to read ahead it is an underrun, and the next block is read; otherwise the ring is emptied and filled from
+ * the note. Call it from the main loop only.
+ *
+ * @param p_stream Pointer to the stream
+ * @param index Index of the note
+ * @return true if the note is in the ring
+ * @return false if there is no such note or it cannot be read
+ */
+bool melody_stream_fetch(melody_stream_t *p_stream, uint32_t index);
+
+/**
+ * @brief Read notes of the melody open from the device at once, without the ring. It counts as a block read, never
+ * as an underrun.
+ *
+ * @param p_stream Pointer to the stream
+ * @param index Index of the first note
+ * @param count Number of notes
+ * @param p_midi_notes Pointer to store the MIDI note numbers, or NULL to read only the durations
+ * @param p_ticks Pointer to store the durations in ticks
+ * @return true if the notes have been read
+ * @return false if they are not notes of the melody or they cannot be read
+ */
+bool melody_stream_read_notes(melody_stream_t *p_stream, uint32_t index, uint32_t count, uint8_t *p_midi_notes, uint8_t *p_ticks);
+
+#endif /* MELODY_STREAM_H_ */
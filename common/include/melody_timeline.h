@@ -0,0 +1,80 @@
+/**
+ * @file melody_timeline.h
+ * @brief Header for melody_timeline.c file.
+ *
+ * A melody timeline is the prefix sum of the durations of a melody: the time at which each note starts, at normal
+ * speed. It is built once when the melody is loaded, so the time of a note is read in O(1) and the note that plays at
+ * a given time is found by binary search, with no walk of the durations per query. The melodies of a bank, in memory
+ * or streamed, come with their start times precomputed by the bank builder, so they are not walked at all.
+ *
+ * Melodies longer than MELODY_TIMELINE_MAX_ENTRIES notes keep the start of one note every few (the stride): a query
+ * then walks at most stride - 1 durations from the closest entry.
+ *
+ * @author Javier de Ponte Hernando
+ * @author Roberto Maldonado Macafee
+ * @date 18/10/2026
+ */
+
+#ifndef MELODY_TIMELINE_H_
+#define MELODY_TIMELINE_H_
+
+/* Includes ------------------------------------------------------------------*/
+/* Standard C includes */
+#include <stdint.h>
+
+/* Other includes */
+#include "melodies.h"
+
+/* Defines and enums ----------------------------------------------------------*/
+#define MELODY_TIMELINE_MAX_ENTRIES 512U /*!< Start times stored per melody: every note of a pool melody has its own */
+
+/* Typedefs --------------------------------------------------------------------*/
+/**
+ * @brief Timeline of a melody.
+ */
+typedef struct
+{
+    const melody_t *p_melody;                            /*!< Melody indexed, or NULL */
+    uint32_t start_ms[MELODY_TIMELINE_MAX_ENTRIES + 1U]; /*!< Start of the notes 0, stride, 2 * stride... in ms at normal speed. The last entry is the total */
+    uint16_t num_entries;                                /*!< Entries of start_ms[] before the total */
+    uint16_t stride;                                     /*!< Notes between two entries */
+} melody_timeline_t;
+
+/* Function prototypes and explanation -------------------------------------------------*/
+/**
+ * @brief Build the timeline of a melody: load the start times of its notes precomputed by the bank builder, or walk
+ * its durations once if it has none.
+ *
+ * @param p_timeline Pointer to the timeline
+ * @param p_melody Pointer to the melody, or NULL for an empty timeline
+ */
+void melody_timeline_build(melody_timeline_t *p_timeline, const melody_t *p_melody);
+
+/**
+ * @brief Get the duration of the melody of a timeline.
+ *
+ * @param p_timeline Pointer to the timeline
+ * @return uint32_t Duration in ms at normal speed
+ */
+uint32_t melody_timeline_get_total_ms(const melody_timeline_t *p_timeline);
+
+/**
+ * @brief Get the time at which a note starts.
+ *
+ * @param p_timeline Pointer to the timeline
+ * @param note_index Index of the note. The length of the melody, or more, gives the total
+ * @return uint32_t Start of the note in ms at normal speed
+ */
+uint32_t melody_timeline_get_start_ms(const melody_timeline_t *p_timeline, uint32_t note_index);
+
+/**
+ * @brief Find the note that plays at a time of the melody. Notes with no duration are skipped.
+ *
+ * @param p_timeline Pointer to the timeline
+ * @param time_ms Time of the melody in ms at normal speed
+ * @param p_offset_ms Pointer to store the time from the start of the note, or NULL
+ * @return uint32_t Index of the note, or the length of the melody if the time is not before its end
+ */
+uint32_t melody_timeline_find(const melody_timeline_t *p_timeline, uint32_t time_ms, uint32_t *p_offset_ms);
+
+#endif /* MELODY_TIMELINE_H_ */
@@ -0,0 +1,121 @@
+/**
+ * @file melody_upload.h
+ * @brief Header for melody_upload.c file.
+ *
+ * Incremental decoder of the melodies uploaded over the USART. A melody arrives in chunks (the lines received), in
+ * RTTTL (`d=4,o=5,b=120:e,8f#,2g.`, with or without the name section) or in a compact hexadecimal form (pairs of
+ * bytes MIDI note, ticks: `3C04 3E04 0002`). Every note is stored in a melody pool as soon as it is decoded, so no
+ * chunk has to be kept, and a token may be split between chunks. Notes out of the note table are moved by octaves
+ * into it.
+ *
+ * The tick of an RTTTL melody is the finest of 1/64, 1/32 and 1/16 of a whole note that lasts a whole number of
+ * milliseconds at its tempo (at 120 bpm, 1/16: 125 ms), or 1/64 rounded to milliseconds if none does. Notes shorter
+ * than the tick last one tick.
+ *
+ * @author Javier de Ponte Hernando
+ * @author Roberto Maldonado Macafee
+ * @date 18/10/2026
+ */
+
+#ifndef MELODY_UPLOAD_H_
+#define MELODY_UPLOAD_H_
+
+/* Includes ------------------------------------------------------------------*/
+/* Standard C includes */
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Other includes */
+#include "melody_pool.h"
+
+/* Defines and enums ----------------------------------------------------------*/
+#define MELODY_UPLOAD_TOKEN_LENGTH 8U           /*!< Longest RTTTL note or default, e.g. "16c#6." or "b=120" */
+#define MELODY_UPLOAD_RTTTL_MAX_TICKS_PER_WHOLE 64U /*!< Finest tick of an RTTTL melody: a 32nd note is 2 ticks */
+#define MELODY_UPLOAD_RTTTL_MIN_TICKS_PER_WHOLE 16U /*!< Coarsest tick of an RTTTL melody tried to get a tick of a whole number of ms */
+
+/**
+ * @brief States of the decoder of an upload.
+ */
+typedef enum
+{
+    MELODY_UPLOAD_IDLE = 0,       /*!< No melody is being uploaded */
+    MELODY_UPLOAD_RTTTL_DEFAULTS, /*!< RTTTL name and defaults section */
+    MELODY_UPLOAD_RTTTL_NOTES,    /*!< RTTTL notes section */
+    MELODY_UPLOAD_HEX             /*!< Pairs of bytes MIDI note, ticks in hexadecimal */
+} melody_upload_state_t;
+
+/* Typedefs --------------------------------------------------------------------*/
+/**
+ * @brief Decoder of an upload.
+ */
+typedef struct
+{
+    melody_pool_t *p_pool;                    /*!< Pool where the melody is stored */
+    melody_upload_state_t state;              /*!< State of the decoder */
+    char token[MELODY_UPLOAD_TOKEN_LENGTH];   /*!< RTTTL token being received, lowercase */
+    uint8_t token_length;                     /*!< Characters of the token, including those that do not fit in it */
+    bool token_has_equal;                     /*!< The token has an '=': it is an RTTTL default */
+    uint8_t duration;                         /*!< RTTTL default duration */
+    uint8_t octave;                           /*!< RTTTL default octave */
+    uint16_t bpm;                             /*!< RTTTL beats per minute */
+    uint8_t ticks_per_whole;                  /*!< Ticks of an RTTTL whole note */
+    uint16_t tick_ms;                         /*!< Duration of a tick of the melody in milliseconds */
+    uint8_t hex_digits;                       /*!< Hexadecimal digits of the pair being received */
+    uint16_t hex_pair;                        /*!< Value of the pair being received */
+} melody_upload_t;
+
+/* Function prototypes and explanation -------------------------------------------------*/
+/**
+ * @brief Initialize an idle upload decoder.
+ *
+ * @param p_upload Pointer to the decoder
+ * @param p_pool Pointer to the pool where the melodies are stored
+ */
+void melody_upload_init(melody_upload_t *p_upload, melody_pool_t *p_pool);
+
+/**
+ * @brief Start an upload. An upload in progress is aborted.
+ *
+ * @param p_upload Pointer to the decoder
+ * @param p_name Name of the melody
+ * @param tick_ms Duration of a tick for the hexadecimal form, or 0 for RTTTL
+ * @return true if the upload has started
+ * @return false if the pool cannot store the melody (see melody_pool_begin())
+ */
+bool melody_upload_begin(melody_upload_t *p_upload, const char *p_name, uint16_t tick_ms);
+
+/**
+ * @brief Decode a chunk of the melody being uploaded.
+ *
+ * @param p_upload Pointer to the decoder
+ * @param p_data NUL-terminated chunk
+ * @return true if the chunk has been decoded
+ * @return false if there is no upload, the chunk is not valid or the pool is full. The upload is aborted
+ */
+bool melody_upload_feed(melody_upload_t *p_upload, const char *p_data);
+
+/**
+ * @brief Finish an upload: the melody is stored in the pool.
+ *
+ * @param p_upload Pointer to the decoder
+ * @return int32_t Index of the melody in the pool, or -1 if the melody is not complete or has no notes
+ */
+int32_t melody_upload_end(melody_upload_t *p_upload);
+
+/**
+ * @brief Abort an upload.
+ *
+ * @param p_upload Pointer to the decoder
+ */
+void melody_upload_abort(melody_upload_t *p_upload);
+
+/**
+ * @brief Check if a melody is being uploaded.
+ *
+ * @param p_upload Pointer to the decoder
+ * @return true if a melody is being uploaded
+ * @return false otherwise
+ */
+bool melody_upload_is_active(const melody_upload_t *p_upload);
+
+#endif /* MELODY_UPLOAD_H_ */
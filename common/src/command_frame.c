@@ -0,0 +1,109 @@
+/**
+ * @file command_frame.c
+ * @brief Binary frames of the commands received over the USART: encoded with a CRC-16, decoded in place.
+ * @author Javier de Ponte Hernando
+ * @author Roberto Maldonado Macafee
+ * @date 18/10/2026
+ */
+
+/* Includes ------------------------------------------------------------------*/
+/* Standard C includes */
+#include <stddef.h>
+#include <string.h>
+
+/* Other includes */
+#include "command_frame.h"
+
+/* Global variables -----------------------------------------------------------*/
+/**
+ * @brief CRC-16 of the 16 values of a nibble, shifted to the top of the CRC (polynomial USART_FRAME_CRC_POLY).
+ */
+static const uint16_t crc16_nibbles[16] = {0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50A5, 0x60C6, 0x70E7,
+                                           0x8108, 0x9129, 0xA14A, 0xB16B, 0xC18C, 0xD1AD, 0xE1CE, 0xF1EF};
+
+/* Public functions -----------------------------------------------------------*/
+uint16_t command_frame_crc16_update(uint16_t crc, uint8_t data)
+{
+    crc = (uint16_t)(crc << 4) ^ crc16_nibbles[(crc >> 12) ^ (data >> 4)];
+    return (uint16_t)(crc << 4) ^ crc16_nibbles[(crc >> 12) ^ (data & 0x0FU)];
+}
+
+uint16_t command_frame_crc16(const uint8_t *p_data, uint32_t length)
+{
+    uint16_t crc = USART_FRAME_CRC_INIT;
+    for (uint32_t i = 0; i < length; i++)
+    {
+        crc = command_frame_crc16_update(crc, p_data[i]);
+    }
+    return crc;
+}
+
+uint32_t command_frame_encode(uint8_t opcode, const char *const *pp_args, uint32_t num_args, uint8_t *p_frame, uint32_t size)
+{
+    uint32_t length = 0;
+    for (uint32_t i = 0; i < num_args; i++)
+    {
+        // The arguments are separated, not terminated: the last one ends with the payload
+        length += (uint32_t)strlen(pp_args[i]) + ((i > 0) ? 1U : 0U);
+    }
+    if ((length > COMMAND_FRAME_MAX_PAYLOAD) || (COMMAND_FRAME_HEADER_LENGTH + length + COMMAND_FRAME_CRC_LENGTH > size))
+    {
+        return 0;
+    }
+    p_frame[0] = COMMAND_FRAME_START;
+    p_frame[1] = opcode;
+    p_frame[2] = (uint8_t)length;
+    uint8_t *p_payload = &p_frame[COMMAND_FRAME_HEADER_LENGTH];
+    for (uint32_t i = 0; i < num_args; i++)
+    {
+        size_t arg_length = strlen(pp_args[i]);
+        if (i > 0)
+        {
+            *p_payload++ = '\0';
+        }
+        memcpy(p_payload, pp_args[i], arg_length);
+        p_payload += arg_length;
+    }
+    uint16_t crc = command_frame_crc16(&p_frame[1], COMMAND_FRAME_HEADER_LENGTH - 1U + length);
+    *p_payload++ = (uint8_t)(crc >> 8);
+    *p_payload = (uint8_t)crc;
+    return COMMAND_FRAME_HEADER_LENGTH + length + COMMAND_FRAME_CRC_LENGTH;
+}
+
+bool command_frame_is_frame(const char *p_text)
+{
+    return (uint8_t)p_text[0] == COMMAND_FRAME_START;
+}
+
+bool command_frame_decode(command_line_t *p_line, char *p_frame, uint8_t *p_opcode)
+{
+    memset(p_line, 0, sizeof(command_line_t));
+    uint32_t length = (uint8_t)p_frame[2];
+    if (!command_frame_is_frame(p_frame) || (length > COMMAND_FRAME_MAX_PAYLOAD))
+    {
+        return false;
+    }
+    *p_opcode = (uint8_t)p_frame[1];
+    char *p_payload = &p_frame[COMMAND_FRAME_HEADER_LENGTH];
+    p_line->command.p_start = p_payload;
+    // An empty payload has no arguments. Otherwise every NUL starts a new argument
+    uint32_t start = 0;
+    while (length > 0)
+    {
+        if (p_line->num_args >= COMMAND_LINE_MAX_ARGS)
+        {
+            return false;
+        }
+        const char *p_end = memchr(&p_payload[start], '\0', length - start);
+        uint32_t end = (p_end != NULL) ? (uint32_t)(p_end - p_payload) : length;
+        p_line->args[p_line->num_args].p_start = &p_payload[start];
+        p_line->args[p_line->num_args].length = (uint16_t)(end - start);
+        p_line->num_args++;
+        if (end == length)
+        {
+            break;
+        }
+        start = end + 1U;
+    }
+    return true;
+}
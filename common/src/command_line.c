@@ -0,0 +1,228 @@
+/**
+ * @file command_line.c
+ * @brief Tokenizer of the command lines received over the USART, in place and with no copies.
+ * @author Javier de Ponte Hernando
+ * @author Roberto Maldonado Macafee
+ * @date 18/10/2026
+ */
+
+/* Includes ------------------------------------------------------------------*/
+/* Standard C includes */
+#include <stddef.h>
+#include <string.h>
+
+/* Other includes */
+#include "command_line.h"
+
+/* Private functions ----------------------------------------------------------*/
+/**
+ * @brief Check if a character separates tokens.
+ *
+ * @param c Character
+ * @return true if it is a space, a tab or a carriage return
+ */
+static bool _is_separator(char c)
+{
+    return (c == ' ') || (c == '\t') || (c == '\r');
+}
+
+/**
+ * @brief Check if a character is a decimal digit.
+ *
+ * @param c Character
+ * @return true if it is a digit
+ */
+static bool _is_digit(char c)
+{
+    return (c >= '0') && (c <= '9');
+}
+
+/**
+ * @brief Skip the separators of a line.
+ *
+ * @param p_text Position in the line
+ * @return char* First character that is not a separator
+ */
+static char *_skip_separators(char *p_text)
+{
+    while (_is_separator(*p_text))
+    {
+        p_text++;
+    }
+    return p_text;
+}
+
+/**
+ * @brief Read a token of a line.
+ *
+ * @param pp_text Pointer to the position of the token in the line. It is moved past the token
+ * @param p_token Pointer to store the token
+ * @return true if the token is valid
+ * @return false if it is a quoted token not closed or not followed by a separator
+ */
+static bool _read_token(char **pp_text, command_token_t *p_token)
+{
+    char *p_text = *pp_text;
+    bool quoted = (*p_text == '"');
+    p_text += quoted ? 1 : 0;
+    p_token->p_start = p_text;
+    while ((*p_text != '\0') && (quoted ? (*p_text != '"') : !_is_separator(*p_text)))
+    {
+        p_text++;
+    }
+    p_token->length = (uint16_t)(p_text - p_token->p_start);
+    if (quoted)
+    {
+        // The closing quote ends the token: it must be followed by a separator or by the end of the line
+        if ((*p_text != '"') || ((p_text[1] != '\0') && !_is_separator(p_text[1])))
+        {
+            return false;
+        }
+        p_text++;
+    }
+    *pp_text = p_text;
+    return true;
+}
+
+/**
+ * @brief Parse digits as an unsigned decimal integer.
+ *
+ * @param p_digits Pointer to the digits
+ * @param count Number of digits
+ * @param p_value Pointer to store the value
+ * @return true if they are all digits and the value fits in 32 bits
+ */
+static bool _parse_digits(const char *p_digits, uint32_t count, uint32_t *p_value)
+{
+    uint32_t value = 0;
+    for (uint32_t i = 0; i < count; i++)
+    {
+        uint32_t digit = (uint32_t)(p_digits[i] - '0');
+        if (!_is_digit(p_digits[i]) || (value > (UINT32_MAX - digit) / 10U))
+        {
+            return false;
+        }
+        value = value * 10U + digit;
+    }
+    *p_value = value;
+    return true;
+}
+
+/* Public functions -----------------------------------------------------------*/
+char *command_line_next(char **pp_text)
+{
+    if (*pp_text == NULL)
+    {
+        return NULL;
+    }
+    char *p_start = _skip_separators(*pp_text);
+    char *p_text = p_start;
+    bool quoted = false;
+    while ((*p_text != '\0') && (quoted || (*p_text != COMMAND_LINE_SEPARATOR)))
+    {
+        quoted = (*p_text == '"') ? !quoted : quoted;
+        p_text++;
+    }
+    *pp_text = (*p_text == COMMAND_LINE_SEPARATOR) ? p_text + 1 : NULL;
+    // The separators before the end of the command are not part of it
+    while ((p_text > p_start) && _is_separator(p_text[-1]))
+    {
+        p_text--;
+    }
+    *p_text = '\0';
+    return p_start;
+}
+
+bool command_line_tokenize(command_line_t *p_line, char *p_text)
+{
+    memset(p_line, 0, sizeof(command_line_t));
+    p_text = _skip_separators(p_text);
+    p_line->command.p_start = p_text;
+    if ((*p_text != '\0') && !_read_token(&p_text, &p_line->command))
+    {
+        return false;
+    }
+    for (p_text = _skip_separators(p_text); *p_text != '\0'; p_text = _skip_separators(p_text))
+    {
+        if ((p_line->num_args >= COMMAND_LINE_MAX_ARGS) || !_read_token(&p_text, &p_line->args[p_line->num_args]))
+        {
+            return false;
+        }
+        p_line->num_args++;
+    }
+    return true;
+}
+
+bool command_token_equals(const command_token_t *p_token, const char *p_string)
+{
+    return (strncmp(p_token->p_start, p_string, p_token->length) == 0) && (p_string[p_token->length] == '\0');
+}
+
+char *command_line_get_string(command_line_t *p_line, uint32_t index)
+{
+    if (index >= p_line->num_args)
+    {
+        return NULL;
+    }
+    command_token_t *p_token = &p_line->args[index];
+    p_token->p_start[p_token->length] = '\0';
+    return p_token->p_start;
+}
+
+char *command_line_get_rest(command_line_t *p_line, uint32_t index)
+{
+    if (index >= p_line->num_args)
+    {
+        return NULL;
+    }
+    command_token_t *p_last = &p_line->args[p_line->num_args - 1U];
+    p_last->p_start[p_last->length] = '\0';
+    return p_line->args[index].p_start;
+}
+
+bool command_line_get_uint(const command_line_t *p_line, uint32_t index, uint32_t *p_value)
+{
+    if ((index >= p_line->num_args) || (p_line->args[index].length == 0))
+    {
+        return false;
+    }
+    return _parse_digits(p_line->args[index].p_start, p_line->args[index].length, p_value);
+}
+
+bool command_line_get_fixed(const command_line_t *p_line, uint32_t index, uint32_t fraction_bits, uint32_t *p_value)
+{
+    if ((index >= p_line->num_args) || (fraction_bits > 16U))
+    {
+        return false;
+    }
+    const command_token_t *p_token = &p_line->args[index];
+    const char *p_point = memchr(p_token->p_start, '.', p_token->length);
+    uint32_t integer_digits = (p_point != NULL) ? (uint32_t)(p_point - p_token->p_start) : p_token->length;
+    uint32_t decimal_digits = (p_point != NULL) ? p_token->length - integer_digits - 1U : 0;
+    uint32_t integer;
+    uint32_t fraction = 0;
+    uint32_t scale = 1;
+    if ((integer_digits + decimal_digits == 0) || !_parse_digits(p_token->p_start, integer_digits, &integer))
+    {
+        return false;
+    }
+    for (uint32_t i = 0; i < decimal_digits; i++)
+    {
+        char c = p_point[1U + i];
+        if (!_is_digit(c))
+        {
+            return false;
+        }
+        if (i < COMMAND_LINE_MAX_DECIMALS)
+        {
+            fraction = fraction * 10U + (uint32_t)(c - '0');
+            scale *= 10U;
+        }
+    }
+    if (integer > (UINT32_MAX >> fraction_bits) - 1U)
+    {
+        return false;
+    }
+    *p_value = (integer << fraction_bits) + ((fraction << fraction_bits) + scale / 2U) / scale;
+    return true;
+}
@@ -0,0 +1,126 @@
+/**
+ * @file command_table.c
+ * @brief Table of the commands of the jukebox, hashed by the length and the first character of their names.
+ * @author Javier de Ponte Hernando
+ * @author Roberto Maldonado Macafee
+ * @date 18/10/2026
+ */
+
+/* Includes ------------------------------------------------------------------*/
+/* Standard C includes */
+#include <stddef.h>
+#include <string.h>
+
+/* Other includes */
+#include "command_table.h"
+
+/* Private functions ----------------------------------------------------------*/
+/**
+ * @brief Get the bucket of a name from its length and its first character.
+ *
+ * @param p_name Name
+ * @param length Length of the name
+ * @return uint32_t Bucket of the name
+ */
+static uint32_t _bucket(const char *p_name, uint32_t length)
+{
+    return ((uint32_t)(uint8_t)p_name[0] ^ (length << 3)) & (COMMAND_TABLE_NUM_BUCKETS - 1U);
+}
+
+/**
+ * @brief Find a command by its name and the length of its name.
+ *
+ * @param p_table Pointer to the table
+ * @param p_name Name of the command
+ * @param length Length of the name
+ * @return const command_t* Pointer to the command, or NULL if there is no command with that name
+ */
+static const command_t *_find(const command_table_t *p_table, const char *p_name, uint32_t length)
+{
+    if (length == 0)
+    {
+        return NULL;
+    }
+    for (int32_t i = p_table->buckets[_bucket(p_name, length)]; i != COMMAND_TABLE_NO_COMMAND; i = p_table->commands[i].next)
+    {
+        const command_t *p_command = &p_table->commands[i];
+        if ((p_command->length == length) && (memcmp(p_command->p_name, p_name, length) == 0))
+        {
+            return p_command;
+        }
+    }
+    return NULL;
+}
+
+/* Public functions -----------------------------------------------------------*/
+void command_table_init(command_table_t *p_table)
+{
+    memset(p_table, 0, sizeof(command_table_t));
+    memset(p_table->buckets, COMMAND_TABLE_NO_COMMAND, sizeof(p_table->buckets));
+    memset(p_table->opcodes, COMMAND_TABLE_NO_COMMAND, sizeof(p_table->opcodes));
+}
+
+bool command_table_register(command_table_t *p_table, const char *p_name, uint8_t opcode, uint8_t min_args, uint8_t max_args, command_handler_t handler, void *p_context)
+{
+    size_t length = strlen(p_name);
+    if ((p_table->num_commands >= COMMAND_TABLE_MAX_COMMANDS) || (length == 0) || (length > UINT8_MAX) ||
+        (strchr(p_name, ' ') != NULL) || (handler == NULL) || (_find(p_table, p_name, length) != NULL))
+    {
+        return false;
+    }
+    if ((opcode != COMMAND_TABLE_NO_OPCODE) &&
+        ((opcode >= COMMAND_TABLE_MAX_OPCODES) || (p_table->opcodes[opcode] != COMMAND_TABLE_NO_COMMAND)))
+    {
+        return false;
+    }
+    uint32_t bucket = _bucket(p_name, length);
+    command_t *p_command = &p_table->commands[p_table->num_commands];
+    p_command->p_name = p_name;
+    p_command->length = (uint8_t)length;
+    p_command->opcode = opcode;
+    p_command->min_args = min_args;
+    p_command->max_args = max_args;
+    p_command->handler = handler;
+    p_command->p_context = p_context;
+    p_command->next = p_table->buckets[bucket];
+    p_table->buckets[bucket] = (int8_t)p_table->num_commands;
+    if (opcode != COMMAND_TABLE_NO_OPCODE)
+    {
+        p_table->opcodes[opcode] = (int8_t)p_table->num_commands;
+    }
+    p_table->num_commands++;
+    return true;
+}
+
+const command_t *command_table_find(const command_table_t *p_table, const char *p_name, uint32_t length)
+{
+    return _find(p_table, p_name, length);
+}
+
+const command_t *command_table_get(const command_table_t *p_table, uint32_t opcode)
+{
+    if ((opcode >= COMMAND_TABLE_MAX_OPCODES) || (p_table->opcodes[opcode] == COMMAND_TABLE_NO_COMMAND))
+    {
+        return NULL;
+    }
+    return &p_table->commands[p_table->opcodes[opcode]];
+}
+
+command_table_result_t command_table_call(const command_t *p_command, command_line_t *p_line)
+{
+    if (p_command == NULL)
+    {
+        return COMMAND_TABLE_NOT_FOUND;
+    }
+    if ((p_line->num_args < p_command->min_args) || (p_line->num_args > p_command->max_args))
+    {
+        return COMMAND_TABLE_WRONG_ARGS;
+    }
+    p_command->handler(p_command->p_context, p_line);
+    return COMMAND_TABLE_OK;
+}
+
+command_table_result_t command_table_dispatch(const command_table_t *p_table, command_line_t *p_line)
+{
+    return command_table_call(_find(p_table, p_line->command.p_start, p_line->command.length), p_line);
+}
@@ -0,0 +1,32 @@
+/**
+ * @file compiled_melodies.c
+ * @brief Lookup of the compiled version of the melodies.
+ * @author Javier de Ponte Hernando
+ * @author Roberto Maldonado Macafee
+ * @date 17/10/2026
+ */
+
+/* Includes ------------------------------------------------------------------*/
+/* Standard C libraries */
+#include <stddef.h>
+/* Other libraries */
+#include "compiled_melodies.h"
+
+/* Public functions */
+const compiled_melody_t *compiled_melody_find(const melody_t *p_melody)
+{
+    if ((p_melody == NULL) || (SystemCoreClock != compiled_melodies_clock_hz))
+    {
+        return NULL;
+    }
+    for (uint32_t i = 0; i < compiled_melodies_length; i++)
+    {
+        const melody_t *p_source = compiled_melodies[i].p_source;
+        if ((p_melody == p_source) ||
+            ((p_melody->p_notes == p_source->p_notes) && (p_melody->p_durations == p_source->p_durations) && (p_melody->melody_length == p_source->melody_length)))
+        {
+            return &compiled_melodies[i];
+        }
+    }
+    return NULL;
+}
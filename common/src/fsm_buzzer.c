@@ -12,22 +12,480 @@
 #include "port_buzzer.h"
 #include "fsm_buzzer.h"
 #include "melodies.h"
+#include "melody_stream.h"
+#include "melody_codec.h"
 /* Other libraries */
 
 /* State machine input or transition functions */
 
 /**
- * @brief 
+ * @brief Get the duration of the note of the melody at the given index, scaled by the speed of the player.
+ * 
+ * @param p_this Pointer to an fsm_t struct than contains an fsm_buzzer_t.
+ * @param note_index Index of the note in the melody
+ * @return uint32_t Duration of the note in us
+ */
+static uint32_t _note_duration_us (fsm_t *p_this, uint32_t note_index) {
+    fsm_buzzer_t *p_fsm = (fsm_buzzer_t *)(p_this);
+    uint32_t duration_ms = melody_get_duration_ms(p_fsm -> p_melody, note_index);
+    if (p_fsm -> speed_q8 == FSM_BUZZER_SPEED_Q8_ONE) {
+        return duration_ms * 1000U;
+    }
+    return (uint32_t)(((uint64_t)duration_ms * 1000U * FSM_BUZZER_SPEED_Q8_ONE) / p_fsm -> speed_q8);
+}
+
+/**
+ * @brief Get a time of the melody at normal speed scaled by the speed of the player.
+ * 
+ * @param p_fsm Pointer to an fsm_buzzer_t struct
+ * @param time_ms Time at normal speed, in ms
+ * @return uint32_t Time at the speed of the player, in us
+ */
+static uint32_t _scaled_us (fsm_buzzer_t *p_fsm, uint32_t time_ms) {
+    return (uint32_t)(((uint64_t)time_ms * 1000U * FSM_BUZZER_SPEED_Q8_ONE) / p_fsm -> speed_q8);
+}
+
+/**
+ * @brief Build the timeline of a melody. The start times of the melodies of a bank are loaded as they are, so a streamed melody is not read
+ * and its read-ahead ring and its counters are left as they are. A packed melody with no start times is decoded once to the end, so its codec
+ * is then rewound to its first note.
+ * 
+ * @param p_fsm Pointer to an fsm_buzzer_t struct
+ * @param p_melody Pointer to the melody, or NULL
+ */
+static void _timeline_build (fsm_buzzer_t *p_fsm, const melody_t *p_melody) {
+    melody_timeline_build(&(p_fsm -> timeline), p_melody);
+    p_fsm -> total_ms = melody_timeline_get_total_ms(&(p_fsm -> timeline));
+    if ((p_melody != NULL) && (p_melody -> p_codec != NULL)) {
+        melody_codec_rewind(p_melody -> p_codec);
+    }
+}
+
+/**
+ * @brief Build the timeline of the melody if it has been set with no call to fsm_buzzer_set_melody().
+ * 
+ * @param p_fsm Pointer to an fsm_buzzer_t struct
+ */
+static void _timeline_load (fsm_buzzer_t *p_fsm) {
+    if (p_fsm -> timeline.p_melody != p_fsm -> p_melody) {
+        _timeline_build(p_fsm, p_fsm -> p_melody);
+    }
+}
+
+/**
+ * @brief Check if the note of the melody at the given index can be read with no access to the storage device: a streamed note must be in the
+ * read-ahead ring of its stream. It may run in interrupt context.
+ * 
+ * @param p_fsm Pointer to an fsm_buzzer_t struct
+ * @param note_index Index of the note in the melody
+ * @return true if the note can be read
+ * @return false if it has to be fetched by the main loop
+ */
+static bool _note_ready (fsm_buzzer_t *p_fsm, uint32_t note_index) {
+    const melody_t *p_melody = p_fsm -> p_melody;
+    return (p_melody -> p_stream == NULL) || melody_stream_has_note(p_melody -> p_stream, note_index);
+}
+
+/**
+ * @brief Read the note of the melody at the given index from the storage device if it is streamed and not in the read-ahead ring. \n
+ * It runs in the main loop only: the ISR of the timer that controls the duration of the note never reads the device.
+ * 
+ * @param p_fsm Pointer to an fsm_buzzer_t struct
+ * @param note_index Index of the note in the melody
+ */
+static void _fetch_note (fsm_buzzer_t *p_fsm, uint32_t note_index) {
+    const melody_t *p_melody = p_fsm -> p_melody;
+    if (p_melody -> p_stream != NULL) {
+        melody_stream_fetch(p_melody -> p_stream, note_index);
+    }
+}
+
+/**
+ * @brief Get the register values of the note of the melody at the given index. \n
+ * They are taken from the compiled version of the melody if there is one: at other speeds only the duration is computed. Otherwise they are
+ * computed in fixed point.
+ * 
+ * @param p_this Pointer to an fsm_t struct than contains an fsm_buzzer_t.
+ * @param note_index Index of the note in the melody
+ * @param p_buffer Pointer to store the register values if they have to be computed
+ * @return const port_buzzer_note_regs_t* Pointer to the register values of the note
+ */
+static const port_buzzer_note_regs_t *_get_note_regs (fsm_t *p_this, uint32_t note_index, port_buzzer_note_regs_t *p_buffer) {
+    fsm_buzzer_t *p_fsm = (fsm_buzzer_t *)(p_this);
+    if (p_fsm -> p_compiled != NULL) {
+        if (p_fsm -> speed_q8 == FSM_BUZZER_SPEED_Q8_ONE) {
+            return &(p_fsm -> p_compiled -> p_regs[note_index]);
+        }
+        // The frequency of a note does not depend on the speed
+        *p_buffer = p_fsm -> p_compiled -> p_regs[note_index];
+        port_buzzer_get_duration_regs(_note_duration_us(p_this, note_index), p_buffer);
+        return p_buffer;
+    }
+    port_buzzer_get_note_regs_q16(melody_get_note_q16(p_fsm -> p_melody, note_index), _note_duration_us(p_this, note_index), p_buffer);
+    return p_buffer;
+}
+
+/**
+ * @brief Account a time of the melody in the schedule, and step the tempo ramp in progress by it. \n
+ * The speed moves towards the target in proportion to the time of the ramp played, so the ramp is linear in time with no floating point.
+ * 
+ * @param p_this Pointer to an fsm_t struct than contains an fsm_buzzer_t.
+ * @param duration_us Time played at the current speed, in us
+ */
+static void _account_us (fsm_t *p_this, uint32_t duration_us) {
+    fsm_buzzer_t *p_fsm = (fsm_buzzer_t *)(p_this);
+    p_fsm -> schedule_us += duration_us;
+    if (p_fsm -> ramp_remaining_us == 0) {
+        return;
+    }
+    if (duration_us >= p_fsm -> ramp_remaining_us) {
+        p_fsm -> speed_q8 = p_fsm -> ramp_target_q8;
+        p_fsm -> ramp_remaining_us = 0;
+        return;
+    }
+    int32_t step = (int32_t)(((int64_t)p_fsm -> ramp_target_q8 - p_fsm -> speed_q8) * duration_us / p_fsm -> ramp_remaining_us);
+    p_fsm -> speed_q8 = (uint16_t)((int32_t)p_fsm -> speed_q8 + step);
+    p_fsm -> ramp_remaining_us -= duration_us;
+}
+
+/**
+ * @brief Account the note of the melody at the given index in the schedule, and step the tempo ramp in progress by its duration.
+ * 
+ * @param p_this Pointer to an fsm_t struct than contains an fsm_buzzer_t.
+ * @param note_index Index of the note in the melody
+ */
+static void _account_note (fsm_t *p_this, uint32_t note_index) {
+    _account_us(p_this, _note_duration_us(p_this, note_index));
+}
+
+/**
+ * @brief Start the note of the melody at the given index.
+ * 
+ * @param p_this Pointer to an fsm_t struct than contains an fsm_buzzer_t.
+ * @param note_index Index of the note in the melody
+ */
+static void _start_note_index (fsm_t *p_this, uint32_t note_index) {
+    fsm_buzzer_t *p_fsm = (fsm_buzzer_t *)(p_this);
+    port_buzzer_note_regs_t regs;
+    _fetch_note(p_fsm, note_index);
+    port_buzzer_set_note_regs(p_fsm -> buzzer_id, _get_note_regs(p_this, note_index, &regs));
+}
+
+/**
+ * @brief Set the time origin of the schedule at the start of the note of the melody at the given index: the prefix sum of the scaled durations of the previous notes.
  * 
  * @param p_this Pointer to an fsm_t struct than contains an fsm_buzzer_t.
- * @param freq 
- * @param duration 
+ * @param note_index Index of the note in the melody
  */
-static void _start_note	(fsm_t *p_this, double freq, uint32_t duration) {
+static void _schedule_from (fsm_t *p_this, uint32_t note_index) {
     fsm_buzzer_t *p_fsm = (fsm_buzzer_t *)(p_this);
-    double duration2 = (double)duration/(p_fsm -> player_speed);
-    port_buzzer_set_note_frequency (p_fsm -> buzzer_id, freq);
-    port_buzzer_set_note_duration (p_fsm -> buzzer_id, (uint32_t) duration2);
+    uint32_t schedule_us;
+    if (p_fsm -> p_multitrack != NULL) {
+        // The segments of a multi-track melody are not notes of its first track
+        schedule_us = _scaled_us(p_fsm, p_fsm -> voices.elapsed_ms);
+    } else {
+        _timeline_load(p_fsm);
+        schedule_us = _scaled_us(p_fsm, melody_timeline_get_start_ms(&(p_fsm -> timeline), note_index));
+    }
+    p_fsm -> schedule_us = schedule_us;
+    p_fsm -> schedule_resync = false;
+    port_buzzer_set_schedule_origin(p_fsm -> buzzer_id, schedule_us);
+}
+
+/**
+ * @brief Start the note of the melody at the given index and account it in the schedule. \n
+ * In absolute time mode the note ends at its time in the schedule, so the time the player has been late to start it is compensated.
+ * 
+ * @param p_this Pointer to an fsm_t struct than contains an fsm_buzzer_t.
+ * @param note_index Index of the note in the melody
+ */
+static void _start_scheduled_note (fsm_t *p_this, uint32_t note_index) {
+    fsm_buzzer_t *p_fsm = (fsm_buzzer_t *)(p_this);
+    _start_note_index(p_this, note_index);
+    _account_note(p_this, note_index);
+    if (p_fsm -> absolute_time) {
+        port_buzzer_set_note_end(p_fsm -> buzzer_id, p_fsm -> schedule_us);
+    }
+}
+
+/**
+ * @brief Start the note of the melody at the given index from the middle, after a seek. The schedule restarts at the start of the note.
+ * 
+ * @param p_this Pointer to an fsm_t struct than contains an fsm_buzzer_t.
+ * @param note_index Index of the note in the melody
+ * @param offset_ms Time of the note to skip, in ms at normal speed
+ */
+static void _start_note_at (fsm_t *p_this, uint32_t note_index, uint32_t offset_ms) {
+    fsm_buzzer_t *p_fsm = (fsm_buzzer_t *)(p_this);
+    _fetch_note(p_fsm, note_index);
+    uint32_t remaining_us = _scaled_us(p_fsm, melody_get_duration_ms(p_fsm -> p_melody, note_index) - offset_ms);
+    p_fsm -> schedule_us = 0;
+    p_fsm -> schedule_resync = false;
+    port_buzzer_set_schedule_origin(p_fsm -> buzzer_id, 0);
+    port_buzzer_note_regs_t regs;
+    port_buzzer_get_note_regs_q16(melody_get_note_q16(p_fsm -> p_melody, note_index), remaining_us, &regs);
+    port_buzzer_set_note_regs(p_fsm -> buzzer_id, &regs);
+    _account_us(p_this, remaining_us);
+    if (p_fsm -> absolute_time) {
+        port_buzzer_set_note_end(p_fsm -> buzzer_id, p_fsm -> schedule_us);
+    }
+}
+
+/**
+ * @brief Load the first note of a track, skipping the notes with no duration.
+ * 
+ * @param p_fsm Pointer to an fsm_buzzer_t struct
+ * @param track Index of the track in the multi-track melody
+ */
+static void _voices_load_note (fsm_buzzer_t *p_fsm, uint32_t track) {
+    fsm_buzzer_voices_t *p_voices = &(p_fsm -> voices);
+    const melody_t *p_track = p_fsm -> p_multitrack -> p_tracks[track];
+    while ((p_voices -> note_index[track] < p_track -> melody_length) && (melody_get_duration_ms(p_track, p_voices -> note_index[track]) == 0)) {
+        p_voices -> note_index[track]++;
+    }
+    p_voices -> remaining_ms[track] = (p_voices -> note_index[track] < p_track -> melody_length) ? melody_get_duration_ms(p_track, p_voices -> note_index[track]) : 0;
+}
+
+/**
+ * @brief Reset the voice allocator to the start of the multi-track melody, with every voice free.
+ * 
+ * @param p_fsm Pointer to an fsm_buzzer_t struct
+ */
+static void _voices_reset (fsm_buzzer_t *p_fsm) {
+    fsm_buzzer_voices_t *p_voices = &(p_fsm -> voices);
+    for (uint32_t track = 0; track < p_fsm -> p_multitrack -> num_tracks; track++) {
+        p_voices -> note_index[track] = 0;
+        p_voices -> track_voice[track] = -1;
+        _voices_load_note(p_fsm, track);
+    }
+    for (uint32_t voice = 0; voice < PORT_BUZZER_MAX_VOICES; voice++) {
+        p_voices -> voice_track[voice] = -1;
+    }
+    p_voices -> reload_mask = (1U << PORT_BUZZER_MAX_VOICES) - 1U;
+    p_voices -> elapsed_ms = 0;
+}
+
+/**
+ * @brief Allocate a voice to the note that starts in a track: a free voice, or else the voice that has played its note for the longest time,
+ * whose note is cut. Among the notes that have started at the same time, the one of the last voice is cut.
+ * 
+ * @param p_fsm Pointer to an fsm_buzzer_t struct
+ * @param track Index of the track in the multi-track melody
+ */
+static void _voices_allocate (fsm_buzzer_t *p_fsm, uint32_t track) {
+    fsm_buzzer_voices_t *p_voices = &(p_fsm -> voices);
+    uint32_t chosen = 0;
+    for (uint32_t voice = 0; voice < PORT_BUZZER_MAX_VOICES; voice++) {
+        if (p_voices -> voice_track[voice] < 0) {
+            chosen = voice;
+            break;
+        }
+        if (p_voices -> voice_start_ms[voice] <= p_voices -> voice_start_ms[chosen]) {
+            chosen = voice;
+        }
+    }
+    if (p_voices -> voice_track[chosen] >= 0) {
+        p_voices -> track_voice[p_voices -> voice_track[chosen]] = -1;
+        p_voices -> stolen_notes++;
+    }
+    p_voices -> voice_track[chosen] = (int8_t)track;
+    p_voices -> voice_start_ms[chosen] = p_voices -> elapsed_ms;
+    p_voices -> track_voice[track] = (int8_t)chosen;
+    p_voices -> reload_mask |= 1U << chosen;
+}
+
+/**
+ * @brief Check if every track of the multi-track melody has ended.
+ * 
+ * @param p_fsm Pointer to an fsm_buzzer_t struct
+ * @return true 
+ * @return false 
+ */
+static bool _voices_done (fsm_buzzer_t *p_fsm) {
+    for (uint32_t track = 0; track < p_fsm -> p_multitrack -> num_tracks; track++) {
+        if (p_fsm -> voices.remaining_ms[track] > 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Start the next segment of the multi-track melody: allocate a voice to the notes that start, load the voices that change and
+ * start the timer that controls the duration of the note until the next note of any track. Then advance the tracks to the end of the segment.
+ * 
+ * @param p_this Pointer to an fsm_t struct than contains an fsm_buzzer_t.
+ */
+static void _start_segment (fsm_t *p_this) {
+    fsm_buzzer_t *p_fsm = (fsm_buzzer_t *)(p_this);
+    fsm_buzzer_voices_t *p_voices = &(p_fsm -> voices);
+    const multitrack_melody_t *p_multitrack = p_fsm -> p_multitrack;
+
+    // The segment ends with the first note that ends. The notes that start take a voice: the main line first
+    uint32_t segment_ms = UINT16_MAX;
+    for (uint32_t track = 0; track < p_multitrack -> num_tracks; track++) {
+        uint32_t remaining_ms = p_voices -> remaining_ms[track];
+        if (remaining_ms == 0) {
+            continue;
+        }
+        segment_ms = (remaining_ms < segment_ms) ? remaining_ms : segment_ms;
+        const melody_t *p_track = p_multitrack -> p_tracks[track];
+        uint32_t note_index = p_voices -> note_index[track];
+        bool starts = (remaining_ms == melody_get_duration_ms(p_track, note_index)) && (p_voices -> track_voice[track] < 0);
+        if (starts && (melody_get_note_q16(p_track, note_index) != 0)) {
+            _voices_allocate(p_fsm, track);
+        }
+    }
+    uint32_t segment_us = (uint32_t)(((uint64_t)segment_ms * 1000U * FSM_BUZZER_SPEED_Q8_ONE) / p_fsm -> speed_q8);
+
+    // Only the voices whose note changes are loaded: the others go on with no glitch
+    port_buzzer_note_regs_t regs = {0};
+    for (uint32_t voice = 0; voice < PORT_BUZZER_MAX_VOICES; voice++) {
+        if (!(p_voices -> reload_mask & (1U << voice))) {
+            continue;
+        }
+        int32_t track = p_voices -> voice_track[voice];
+        if (track >= 0) {
+            const melody_t *p_track = p_multitrack -> p_tracks[track];
+            port_buzzer_get_note_regs_q16(melody_get_note_q16(p_track, p_voices -> note_index[track]), segment_us, &regs);
+        } else {
+            regs.pwm_arr = 0;
+        }
+        port_buzzer_set_voice_regs(p_fsm -> buzzer_id, voice, &regs);
+    }
+    p_voices -> reload_mask = 0;
+    port_buzzer_get_duration_regs(segment_us, &regs);
+    port_buzzer_start_note_duration(p_fsm -> buzzer_id, &regs);
+    _account_us(p_this, segment_us);
+    if (p_fsm -> absolute_time) {
+        port_buzzer_set_note_end(p_fsm -> buzzer_id, p_fsm -> schedule_us);
+    }
+
+    // The notes that end free their voice, which is silenced at the start of the next segment unless another note takes it
+    p_voices -> elapsed_ms += segment_ms;
+    for (uint32_t track = 0; track < p_multitrack -> num_tracks; track++) {
+        if (p_voices -> remaining_ms[track] == 0) {
+            continue;
+        }
+        p_voices -> remaining_ms[track] -= (uint16_t)segment_ms;
+        if (p_voices -> remaining_ms[track] == 0) {
+            int32_t voice = p_voices -> track_voice[track];
+            if (voice >= 0) {
+                p_voices -> voice_track[voice] = -1;
+                p_voices -> track_voice[track] = -1;
+                p_voices -> reload_mask |= 1U << voice;
+            }
+            p_voices -> note_index[track]++;
+            _voices_load_note(p_fsm, track);
+        }
+    }
+}
+
+/**
+ * @brief Go on with the next melody, if there is one, at the end of the melody playing: its first note is the next note to play. \n
+ * It may run in interrupt context: the next melody is not streamed nor packed, and its timeline is built when it is needed.
+ * 
+ * @param p_fsm Pointer to an fsm_buzzer_t struct
+ * @return true if there is a next melody
+ * @return false otherwise
+ */
+static bool _follow_next_melody (fsm_buzzer_t *p_fsm) {
+    const melody_t *p_next = p_fsm -> p_next_melody;
+    if ((p_next == NULL) || (p_fsm -> p_multitrack != NULL)) {
+        return false;
+    }
+    p_fsm -> p_melody = (melody_t *)(p_next);
+    p_fsm -> p_compiled = p_fsm -> p_next_compiled;
+    p_fsm -> p_next_melody = NULL;
+    p_fsm -> note_index = 0;
+    p_fsm -> seek_offset_ms = 0;
+    return true;
+}
+
+/**
+ * @brief Provide the next note of the melody to the ISR of the timer that controls the duration of the note (sequencer mode). \n
+ * It runs in interrupt context. A streamed note that has not been read ahead is not staged: it is fetched and played by the main loop
+ * when the note playing ends.
+ * 
+ * @param p_arg Pointer to an fsm_t struct than contains an fsm_buzzer_t.
+ * @param p_regs Pointer to store the register values of the next note
+ * @return true if there is a next note to play
+ * @return false if the melody ends with no next melody, the player has been paused or stopped, or the next note is not in the read-ahead ring
+ */
+static bool _sequencer_next_note (void *p_arg, port_buzzer_note_regs_t *p_regs) {
+    fsm_t *p_this = (fsm_t *)(p_arg);
+    fsm_buzzer_t *p_fsm = (fsm_buzzer_t *)(p_this);
+    if (p_fsm -> user_action != PLAY) {
+        return false;
+    }
+    // The first note of the next melody follows the last note of this one with no gap
+    if ((p_fsm -> note_index >= p_fsm -> p_melody -> melody_length) && !_follow_next_melody(p_fsm)) {
+        return false;
+    }
+    if (!_note_ready(p_fsm, p_fsm -> note_index)) {
+        return false;
+    }
+    const port_buzzer_note_regs_t *p_note_regs = _get_note_regs(p_this, p_fsm -> note_index, p_regs);
+    if (p_note_regs != p_regs) {
+        *p_regs = *p_note_regs;
+    }
+    _account_note(p_this, p_fsm -> note_index);
+    p_fsm -> note_index++;
+    return true;
+}
+
+/**
+ * @brief Stage the next note of the melody in the timers, if the player is in gapless or sequencer mode and the melody has not ended. At its end
+ * the player goes on with the next melody, if any, and stages its first note. In sequencer mode the staged note is accounted in note_index, as the ISR advances the melody from then on.
+ * 
+ * @param p_this Pointer to an fsm_t struct than contains an fsm_buzzer_t.
+ */
+static void _stage_next_note (fsm_t *p_this) {
+    fsm_buzzer_t *p_fsm = (fsm_buzzer_t *)(p_this);
+    if (p_fsm -> p_multitrack != NULL) {
+        return;
+    }
+    if (p_fsm -> sequencer) {
+        port_buzzer_note_regs_t regs;
+        _fetch_note(p_fsm, p_fsm -> note_index);
+        if (_sequencer_next_note(p_this, &regs)) {
+            port_buzzer_set_next_note_regs(p_fsm -> buzzer_id, &regs);
+        }
+    } else if (p_fsm -> gapless && ((p_fsm -> note_index < p_fsm -> p_melody -> melody_length) || _follow_next_melody(p_fsm))) {
+        port_buzzer_note_regs_t regs;
+        _fetch_note(p_fsm, p_fsm -> note_index);
+        port_buzzer_set_next_note_regs(p_fsm -> buzzer_id, _get_note_regs(p_this, p_fsm -> note_index, &regs));
+        _account_note(p_this, p_fsm -> note_index);
+        p_fsm -> next_staged = true;
+    }
+}
+
+/**
+ * @brief Play the rest of the melody by DMA, from note_index, if the player is in DMA mode, the notes fit in the DMA buffers of the port and the melody is not streamed or packed. \n
+ * note_index is set to the end of the melody: the FSM is notified when the HW has played it.
+ * 
+ * @param p_this Pointer to an fsm_t struct than contains an fsm_buzzer_t.
+ * @return true if the melody is played by DMA
+ * @return false otherwise
+ */
+static bool _start_dma (fsm_t *p_this) {
+    fsm_buzzer_t *p_fsm = (fsm_buzzer_t *)(p_this);
+    uint32_t length = p_fsm -> p_melody -> melody_length - p_fsm -> note_index;
+    // A streamed or packed melody is not staged at once: only the notes of its ring are resident, or only the note decoded.
+    // A melody followed by another is left to the timers, which stage the first note of the next one
+    if (!p_fsm -> dma || (p_fsm -> p_multitrack != NULL) || (p_fsm -> p_next_melody != NULL) || (p_fsm -> p_melody -> p_stream != NULL) || (p_fsm -> p_melody -> p_codec != NULL) || (length == 0) || (length > PORT_BUZZER_DMA_MAX_NOTES)) {
+        return false;
+    }
+    for (uint32_t i = 0; i < length; i++) {
+        port_buzzer_note_regs_t regs;
+        port_buzzer_dma_load_note(p_fsm -> buzzer_id, i, _get_note_regs(p_this, p_fsm -> note_index + i, &regs));
+        _account_note(p_this, p_fsm -> note_index + i);
+    }
+    port_buzzer_dma_start(p_fsm -> buzzer_id, length);
+    p_fsm -> dma_first_note = p_fsm -> note_index;
+    p_fsm -> note_index = p_fsm -> p_melody -> melody_length;
+    p_fsm -> next_staged = false;
+    return true;
 }
 
 /**
@@ -67,6 +525,9 @@ static bool check_player_start	(fsm_t *p_this)	{
  */
 static bool check_end_melody(fsm_t * p_this	){
     fsm_buzzer_t *p_fsm = (fsm_buzzer_t *)(p_this);
+    if (p_fsm -> p_multitrack != NULL) {
+        return _voices_done(p_fsm);
+    }
     if ((p_fsm->note_index) < (p_fsm->p_melody->melody_length)){
         return false;
     }
@@ -116,7 +577,8 @@ static bool check_pause	(	fsm_t * 	p_this	)	{
 
 static bool check_play_note	(	fsm_t * 	p_this	)	{
     fsm_buzzer_t *p_fsm = (fsm_buzzer_t *)(p_this);
-    if((p_fsm->user_action == PLAY) && (check_end_melody(p_this) == false)){
+    // At the end of the melody the player goes on with the next melody, if any
+    if((p_fsm->user_action == PLAY) && ((check_end_melody(p_this) == false) || ((p_fsm -> p_next_melody != NULL) && (p_fsm -> p_multitrack == NULL)))){
         return true;
     }
     else{
@@ -174,8 +636,10 @@ static bool check_resume (	fsm_t * 	p_this	){
  */
 static void do_end_melody	(	fsm_t * 	p_this	)	{
     fsm_buzzer_t *p_fsm = (fsm_buzzer_t *)(p_this);
+    p_fsm -> drift_us = port_buzzer_get_schedule_drift(p_fsm -> buzzer_id, p_fsm -> schedule_us);
     port_buzzer_stop(p_fsm -> buzzer_id);
     p_fsm ->note_index = 0;
+    p_fsm -> seek_offset_ms = 0;
     p_fsm ->user_action = STOP;
 }
 
@@ -187,10 +651,23 @@ static void do_end_melody	(	fsm_t * 	p_this	)	{
  */
 static void do_melody_start	(fsm_t *p_this)	{
     fsm_buzzer_t *p_fsm = (fsm_buzzer_t *)(p_this);
-    double freq = p_fsm -> p_melody -> p_notes[0];
-    uint32_t duration = p_fsm -> p_melody -> p_durations[0];
-    _start_note(p_this, freq, duration);
+    p_fsm -> p_compiled = compiled_melody_find(p_fsm -> p_melody);
+    p_fsm -> next_staged = false;
+    p_fsm -> seek_offset_ms = 0;
+    if (p_fsm -> p_multitrack != NULL) {
+        _voices_reset(p_fsm);
+        _schedule_from(p_this, 0);
+        _start_segment(p_this);
+        p_fsm -> note_index++;
+        return;
+    }
+    _schedule_from(p_this, 0);
+    if (_start_dma(p_this)) {
+        return;
+    }
+    _start_scheduled_note(p_this, 0);
     p_fsm -> note_index++;
+    _stage_next_note(p_this);
 }
 
 /**
@@ -200,7 +677,22 @@ static void do_melody_start	(fsm_t *p_this)	{
  */
 static void do_note_end	(fsm_t *p_this)	{
     fsm_buzzer_t *p_fsm = (fsm_buzzer_t *)(p_this);
-    port_buzzer_stop(p_fsm -> buzzer_id);
+    if (p_fsm -> p_multitrack != NULL) {
+        // The voices that go on in the next segment keep sounding
+        port_buzzer_reset_note_timeout(p_fsm -> buzzer_id);
+        return;
+    }
+    if (p_fsm -> next_staged && !port_buzzer_get_next_note_staged(p_fsm -> buzzer_id)) {
+        // The HW has already started the staged note
+        port_buzzer_reset_note_timeout(p_fsm -> buzzer_id);
+    } else {
+        port_buzzer_stop(p_fsm -> buzzer_id);
+        if (p_fsm -> next_staged) {
+            // The staged note is started again by do_play_note()
+            p_fsm -> schedule_us -= _note_duration_us(p_this, p_fsm -> note_index);
+            p_fsm -> next_staged = false;
+        }
+    }
 }
 
 /**
@@ -211,6 +703,12 @@ static void do_note_end	(fsm_t *p_this)	{
 static void do_pause (fsm_t *p_this) {
     fsm_buzzer_t *p_fsm = (fsm_buzzer_t *)(p_this);
     port_buzzer_stop(p_fsm -> buzzer_id);
+    // A note started by the HW is played again from the beginning on resume
+    p_fsm -> next_staged = false;
+    // The time paused is not accounted in the schedule
+    p_fsm -> schedule_resync = true;
+    // Every voice has been stopped
+    p_fsm -> voices.reload_mask = (1U << PORT_BUZZER_MAX_VOICES) - 1U;
 }
 
 /**
@@ -229,21 +727,54 @@ static void do_play_note (fsm_t *p_this) {
     
     uint32_t actual_note_index = (p_fsm -> note_index);
 
+    // On resume the schedule continues from the note to play
+    if (p_fsm -> schedule_resync) {
+        _schedule_from(p_this, actual_note_index);
+    }
+
+    if (p_fsm -> p_multitrack != NULL) {
+        _start_segment(p_this);
+        p_fsm -> note_index++;
+        return;
+    }
+
+    // The melody has ended before the first note of the next one was staged: the next one starts as any melody
+    if ((actual_note_index >= p_fsm -> p_melody -> melody_length) && _follow_next_melody(p_fsm)) {
+        p_fsm -> drift_us = port_buzzer_get_schedule_drift(p_fsm -> buzzer_id, p_fsm -> schedule_us);
+        do_melody_start(p_this);
+        return;
+    }
+
+    // After a seek the note is played from the middle, and the rest of the melody from the next one
+    if (p_fsm -> seek_offset_ms > 0) {
+        _start_note_at(p_this, actual_note_index, p_fsm -> seek_offset_ms);
+        p_fsm -> seek_offset_ms = 0;
+        p_fsm -> note_index += 1;
+        _stage_next_note(p_this);
+        return;
+    }
+
+    // In DMA mode the rest of the melody is played by the HW
+    if (_start_dma(p_this)) {
+        return;
+    }
+
     //indice de la nota siguiente
     // uint32_t next_note_index = (actual_note_index + 1);
 
-    // conseguir la frecuencia de next_note_index
-    melody_t *pp_melody = (p_fsm -> p_melody);
-    double freq = (pp_melody -> p_notes[(actual_note_index)]);
-    
-    // lo mismo con la duracion
-    uint32_t duration = (pp_melody -> p_durations[(actual_note_index)]);
-
-    // llamar a _start_note
-    _start_note(p_this, freq, duration);
+    // llamar a _start_note con la frecuencia y la duracion de la nota (o sus registros compilados),
+    // salvo que el HW ya la haya empezado (modo gapless)
+    if (p_fsm -> next_staged) {
+        p_fsm -> next_staged = false;
+    } else {
+        _start_scheduled_note(p_this, actual_note_index);
+    }
 
     // Update the index of the melody
     p_fsm -> note_index +=1;
+
+    // Stage the following note while this one plays
+    _stage_next_note(p_this);
 }    
 
 /*
@@ -279,6 +810,8 @@ static void do_player_stop(fsm_t *p_this) {
     fsm_buzzer_t *p_fsm = (fsm_buzzer_t *)(p_this);
     port_buzzer_stop(p_fsm -> buzzer_id);
     p_fsm ->note_index = 0;
+    p_fsm -> next_staged = false;
+    p_fsm -> seek_offset_ms = 0;
 }
 
 /**
@@ -329,22 +862,313 @@ void fsm_buzzer_set_melody (fsm_t *p_this, const melody_t *p_melody) {
     fsm_buzzer_t *p_fsm = (fsm_buzzer_t *)(p_this);
     melody_t *p_melothis = (melody_t *)(p_melody);
     p_fsm -> p_melody = p_melothis;
+    p_fsm -> p_compiled = compiled_melody_find(p_melody);
+    p_fsm -> p_multitrack = NULL;
+    p_fsm -> seek_offset_ms = 0;
+    // The next melody followed the melody replaced
+    p_fsm -> p_next_melody = NULL;
+    // The melody may be a view whose notes have changed: the timeline is built again
+    _timeline_build(p_fsm, p_melody);
 }	
 
+/**
+ * @brief Set the melody that follows the melody playing, or NULL to play none.
+ * 
+ * @param p_this 	Pointer to an fsm_t struct than contains an fsm_buzzer_t struct
+ * @param p_next Pointer to the next melody, or NULL
+ * @return true if the next melody has been set
+ * @return false if the melody cannot follow
+ */
+bool fsm_buzzer_set_next_melody (fsm_t *p_this, const melody_t *p_next) {
+    fsm_buzzer_t *p_fsm = (fsm_buzzer_t *)(p_this);
+    if ((p_next != NULL) && ((p_next -> melody_length == 0) || (p_next -> p_stream != NULL) || (p_next -> p_codec != NULL))) {
+        return false;
+    }
+    // Once the next melody is dropped, the ISR cannot go on with it: fsm_buzzer_get_melody() tells if it has done so before
+    p_fsm -> p_next_melody = NULL;
+    if (p_next != NULL) {
+        p_fsm -> p_next_compiled = compiled_melody_find(p_next);
+        p_fsm -> p_next_melody = p_next;
+    }
+    return true;
+}
+
+/**
+ * @brief Get the melody to play: the melody set, or the next melody once the player has gone on with it.
+ * 
+ * @param p_this 	Pointer to an fsm_t struct than contains an fsm_buzzer_t struct
+ * @return const melody_t* Pointer to the melody, or NULL if there is none
+ */
+const melody_t *fsm_buzzer_get_melody (fsm_t *p_this) {
+    fsm_buzzer_t *p_fsm = (fsm_buzzer_t *)(p_this);
+    return p_fsm -> p_melody;
+}
+
+/**
+ * @brief Set a multi-track melody to play.
+ * 
+ * @param p_this 	Pointer to an fsm_t struct than contains an fsm_buzzer_t struct
+ * @param p_multitrack Pointer to the multi-track melody to play
+ */
+void fsm_buzzer_set_multitrack (fsm_t *p_this, const multitrack_melody_t *p_multitrack) {
+    fsm_buzzer_t *p_fsm = (fsm_buzzer_t *)(p_this);
+    fsm_buzzer_set_melody(p_this, p_multitrack -> p_tracks[0]);
+    p_fsm -> p_multitrack = p_multitrack;
+    for (uint32_t track = 1; track < p_multitrack -> num_tracks; track++) {
+        const melody_t *p_track = p_multitrack -> p_tracks[track];
+        uint32_t track_ms = 0;
+        for (uint32_t i = 0; i < p_track -> melody_length; i++) {
+            track_ms += melody_get_duration_ms(p_track, i);
+        }
+        p_fsm -> total_ms = (track_ms > p_fsm -> total_ms) ? track_ms : p_fsm -> total_ms;
+    }
+}
+
+/**
+ * @brief Get the number of notes of the multi-track melodies cut or not played for lack of voices.
+ * 
+ * @param p_this 	Pointer to an fsm_t struct than contains an fsm_buzzer_t struct
+ * @return uint32_t Number of notes
+ */
+uint32_t fsm_buzzer_get_stolen_notes (fsm_t *p_this) {
+    fsm_buzzer_t *p_fsm = (fsm_buzzer_t *)(p_this);
+    return p_fsm -> voices.stolen_notes;
+}
+
+/**
+ * @brief Enable or disable the gapless mode of the player.
+ * 
+ * @param p_this 	Pointer to an fsm_t struct than contains an fsm_buzzer_t struct
+ * @param gapless True to enable the gapless mode
+ */
+void fsm_buzzer_set_gapless (fsm_t *p_this, bool gapless) {
+    fsm_buzzer_t *p_fsm = (fsm_buzzer_t *)(p_this);
+    p_fsm -> gapless = gapless;
+}
+
+/**
+ * @brief Enable or disable the sequencer mode of the player.
+ * 
+ * @param p_this 	Pointer to an fsm_t struct than contains an fsm_buzzer_t struct
+ * @param sequencer True to enable the sequencer mode
+ */
+void fsm_buzzer_set_sequencer (fsm_t *p_this, bool sequencer) {
+    fsm_buzzer_t *p_fsm = (fsm_buzzer_t *)(p_this);
+    p_fsm -> sequencer = sequencer;
+    port_buzzer_set_sequencer(p_fsm -> buzzer_id, sequencer ? _sequencer_next_note : NULL, p_this);
+}
+
+/**
+ * @brief Enable or disable the DMA mode of the player.
+ * 
+ * @param p_this 	Pointer to an fsm_t struct than contains an fsm_buzzer_t struct
+ * @param dma True to enable the DMA mode
+ */
+void fsm_buzzer_set_dma (fsm_t *p_this, bool dma) {
+    fsm_buzzer_t *p_fsm = (fsm_buzzer_t *)(p_this);
+    p_fsm -> dma = dma;
+}
+
+/**
+ * @brief Enable or disable the absolute time mode of the player.
+ * 
+ * @param p_this 	Pointer to an fsm_t struct than contains an fsm_buzzer_t struct
+ * @param absolute_time True to enable the absolute time mode
+ */
+void fsm_buzzer_set_absolute_time (fsm_t *p_this, bool absolute_time) {
+    fsm_buzzer_t *p_fsm = (fsm_buzzer_t *)(p_this);
+    p_fsm -> absolute_time = absolute_time;
+}
+
+/**
+ * @brief Get the drift of the end of the last melody played.
+ * 
+ * @param p_this 	Pointer to an fsm_t struct than contains an fsm_buzzer_t struct
+ * @return int32_t Drift in us
+ */
+int32_t fsm_buzzer_get_drift_us (fsm_t *p_this) {
+    fsm_buzzer_t *p_fsm = (fsm_buzzer_t *)(p_this);
+    return p_fsm -> drift_us;
+}
+
 /**
  * @brief 
  * Set the speed of the player. \n 
  * This function sets the speed of the player. 
- * The user must pass a double value with the speed of the player.
+ * The user must pass a double value with the speed of the player. It is converted to the Q8.8 speed used by the player.
  * 
  * @param p_this 	Pointer to an fsm_t struct than contains an fsm_buzzer_t struct
  * @param speed Speed of the player
  */
 void fsm_buzzer_set_speed (fsm_t *p_this, double speed)	{
-    fsm_buzzer_t *p_fsm = (fsm_buzzer_t *)(p_this);
-    p_fsm -> player_speed = speed;
+    uint32_t speed_q8 = 0xFFFF;
+    if (speed < 0xFFFF / (double)FSM_BUZZER_SPEED_Q8_ONE) {
+        speed_q8 = (speed > 0) ? FSM_BUZZER_SPEED_Q8(speed) : 0;
+    }
+    fsm_buzzer_set_speed_q8(p_this, (uint16_t)speed_q8);
 }	
 
+/**
+ * @brief Change the speed of the player while a note is playing: the staged or DMA notes, computed at the old speed, are taken back,
+ * the rest of the current note is rescaled in the timer and the schedule restarts from now.
+ * 
+ * @param p_this 	Pointer to an fsm_t struct than contains an fsm_buzzer_t struct
+ * @param speed_q8 New speed of the player, Q8.8
+ */
+static void _rescale_live (fsm_t *p_this, uint16_t speed_q8) {
+    fsm_buzzer_t *p_fsm = (fsm_buzzer_t *)(p_this);
+    uint16_t old_q8 = p_fsm -> speed_q8;
+    if (p_fsm -> sequencer && port_buzzer_cancel_next_note(p_fsm -> buzzer_id)) {
+        p_fsm -> note_index--;
+    }
+    if (p_fsm -> next_staged) {
+        port_buzzer_cancel_next_note(p_fsm -> buzzer_id);
+        p_fsm -> next_staged = false;
+    }
+    bool dma_detached = false;
+    if (p_fsm -> dma && port_buzzer_get_dma_busy(p_fsm -> buzzer_id)) {
+        // The rest of the melody is played again by DMA from the next note
+        p_fsm -> note_index = p_fsm -> dma_first_note + port_buzzer_dma_detach(p_fsm -> buzzer_id) + 1U;
+        dma_detached = true;
+    }
+    p_fsm -> speed_q8 = speed_q8;
+    // The duration of a note is inversely proportional to the speed
+    uint32_t remaining_us = port_buzzer_rescale_note(p_fsm -> buzzer_id, old_q8, speed_q8);
+    if (remaining_us == 0) {
+        // The note has just ended: the schedule restarts from the next one
+        p_fsm -> schedule_resync = true;
+        return;
+    }
+    p_fsm -> schedule_us = remaining_us;
+    p_fsm -> schedule_resync = false;
+    port_buzzer_set_schedule_origin(p_fsm -> buzzer_id, 0);
+    if (!dma_detached) {
+        _stage_next_note(p_this);
+    }
+}
+
+/**
+ * @brief Set the speed of the player in fixed point.
+ * 
+ * @param p_this 	Pointer to an fsm_t struct than contains an fsm_buzzer_t struct
+ * @param speed_q8 Speed of the player, Q8.8
+ */
+void fsm_buzzer_set_speed_q8 (fsm_t *p_this, uint16_t speed_q8) {
+    fsm_buzzer_t *p_fsm = (fsm_buzzer_t *)(p_this);
+    speed_q8 = (speed_q8 > 0) ? speed_q8 : 1U;
+    p_fsm -> ramp_remaining_us = 0;
+    if ((speed_q8 != p_fsm -> speed_q8) && (p_fsm -> user_action == PLAY) && (p_fsm -> f.current_state == WAIT_NOTE)) {
+        _rescale_live(p_this, speed_q8);
+    }
+    p_fsm -> speed_q8 = speed_q8;
+    p_fsm -> player_speed = (double)(p_fsm -> speed_q8) / FSM_BUZZER_SPEED_Q8_ONE;
+}
+
+/**
+ * @brief Change the speed of the player gradually.
+ * 
+ * @param p_this 	Pointer to an fsm_t struct than contains an fsm_buzzer_t struct
+ * @param target_q8 Speed at the end of the ramp, Q8.8
+ * @param ramp_ms Duration of the ramp in ms of the melody
+ */
+void fsm_buzzer_set_speed_ramp (fsm_t *p_this, uint16_t target_q8, uint32_t ramp_ms) {
+    fsm_buzzer_t *p_fsm = (fsm_buzzer_t *)(p_this);
+    if (ramp_ms == 0) {
+        fsm_buzzer_set_speed_q8(p_this, target_q8);
+        return;
+    }
+    p_fsm -> ramp_target_q8 = (target_q8 > 0) ? target_q8 : 1U;
+    p_fsm -> ramp_remaining_us = ramp_ms * 1000U;
+}
+
+/**
+ * @brief Get the time of the melody played, at normal speed: the start of the note that is playing plus the part of it played.
+ * 
+ * @param p_this Pointer to an fsm_t struct than contains an fsm_buzzer_t struct
+ * @return uint32_t Time played in ms at normal speed
+ */
+static uint32_t _get_position_ms (fsm_t *p_this) {
+    fsm_buzzer_t *p_fsm = (fsm_buzzer_t *)(p_this);
+    uint32_t remaining_us = port_buzzer_get_note_remaining_us(p_fsm -> buzzer_id);
+    uint32_t remaining_ms = (uint32_t)(((uint64_t)remaining_us * p_fsm -> speed_q8) / (1000U * FSM_BUZZER_SPEED_Q8_ONE));
+    if (p_fsm -> p_multitrack != NULL) {
+        // The time of the melody is accounted at the start of each segment
+        uint32_t end_ms = p_fsm -> voices.elapsed_ms;
+        return end_ms - ((remaining_ms < end_ms) ? remaining_ms : end_ms);
+    }
+    // note_index is the next note to start, unless a staged note has already started (gapless) or is yet to start (sequencer)
+    int32_t note_index = (int32_t)(p_fsm -> note_index) - 1;
+    if (p_fsm -> dma && port_buzzer_get_dma_busy(p_fsm -> buzzer_id)) {
+        note_index = (int32_t)(p_fsm -> dma_first_note + port_buzzer_get_dma_note(p_fsm -> buzzer_id));
+    } else {
+        note_index += (int32_t)(p_fsm -> next_staged) - (int32_t)port_buzzer_get_next_note_staged(p_fsm -> buzzer_id);
+    }
+    if ((remaining_us == 0) || (note_index < 0)) {
+        // No note is playing: the player is at the start of the next one, or in the middle of it after a seek
+        return melody_timeline_get_start_ms(&(p_fsm -> timeline), p_fsm -> note_index) + p_fsm -> seek_offset_ms;
+    }
+    uint32_t start_ms = melody_timeline_get_start_ms(&(p_fsm -> timeline), (uint32_t)note_index);
+    uint32_t end_ms = melody_timeline_get_start_ms(&(p_fsm -> timeline), (uint32_t)note_index + 1U);
+    return end_ms - ((remaining_ms < end_ms - start_ms) ? remaining_ms : end_ms - start_ms);
+}
+
+/**
+ * @brief Get the progress of the melody at the current speed of the player.
+ * 
+ * @param p_this 	Pointer to an fsm_t struct than contains an fsm_buzzer_t struct
+ * @param p_elapsed_ms Pointer to store the time played in ms
+ * @param p_total_ms Pointer to store the duration of the melody in ms
+ */
+void fsm_buzzer_get_progress (fsm_t *p_this, uint32_t *p_elapsed_ms, uint32_t *p_total_ms) {
+    fsm_buzzer_t *p_fsm = (fsm_buzzer_t *)(p_this);
+    *p_elapsed_ms = 0;
+    *p_total_ms = 0;
+    if (p_fsm -> p_melody == NULL) {
+        return;
+    }
+    _timeline_load(p_fsm);
+    uint32_t position_ms = (p_fsm -> user_action != STOP) ? _get_position_ms(p_this) : 0;
+    *p_elapsed_ms = (uint32_t)(((uint64_t)position_ms * FSM_BUZZER_SPEED_Q8_ONE) / p_fsm -> speed_q8);
+    *p_total_ms = (uint32_t)(((uint64_t)p_fsm -> total_ms * FSM_BUZZER_SPEED_Q8_ONE) / p_fsm -> speed_q8);
+}
+
+/**
+ * @brief Move the player to a time of the melody, in ms at the current speed of the player.
+ * 
+ * @param p_this 	Pointer to an fsm_t struct than contains an fsm_buzzer_t struct
+ * @param elapsed_ms Time of the melody in ms at the current speed
+ * @return true if the player has moved
+ * @return false otherwise
+ */
+bool fsm_buzzer_seek (fsm_t *p_this, uint32_t elapsed_ms) {
+    fsm_buzzer_t *p_fsm = (fsm_buzzer_t *)(p_this);
+    uint32_t state = p_fsm -> f.current_state;
+    if ((p_fsm -> p_melody == NULL) || (p_fsm -> p_multitrack != NULL) || (p_fsm -> user_action == STOP) || (state == WAIT_START) || (state == WAIT_MELODY)) {
+        return false;
+    }
+    _timeline_load(p_fsm);
+    uint32_t offset_ms;
+    uint32_t position_ms = (uint32_t)(((uint64_t)elapsed_ms * p_fsm -> speed_q8) / FSM_BUZZER_SPEED_Q8_ONE);
+    uint32_t note_index = melody_timeline_find(&(p_fsm -> timeline), position_ms, &offset_ms);
+    if (note_index >= p_fsm -> p_melody -> melody_length) {
+        return false;
+    }
+    // The notes handed to the HW are dropped: the note playing, the staged one and the DMA playback
+    port_buzzer_stop(p_fsm -> buzzer_id);
+    p_fsm -> next_staged = false;
+    p_fsm -> note_index = note_index;
+    p_fsm -> seek_offset_ms = offset_ms;
+    p_fsm -> schedule_resync = true;
+    if (state == WAIT_NOTE) {
+        // The FSM goes on waiting for the end of the note, which is started now
+        _start_note_at(p_this, note_index, offset_ms);
+        p_fsm -> seek_offset_ms = 0;
+        p_fsm -> note_index++;
+        _stage_next_note(p_this);
+    }
+    return true;
+}
+
 /**
  * @brief Set the action to perform on the player. \n 
  * This function sets the action to perform on the player. 
@@ -356,8 +1180,22 @@ void fsm_buzzer_set_speed (fsm_t *p_this, double speed)	{
 void fsm_buzzer_set_action (fsm_t *p_this, uint8_t action) {
     fsm_buzzer_t *p_fsm = (fsm_buzzer_t *)(p_this);
     p_fsm -> user_action = action;
+    // In sequencer mode the staged note has already been accounted: it is cancelled, so the player pauses or stops at the end of the current note
+    if (p_fsm -> sequencer && (action != PLAY) && port_buzzer_cancel_next_note(p_fsm -> buzzer_id)) {
+        p_fsm -> note_index--;
+        p_fsm -> schedule_us -= _note_duration_us(p_this, p_fsm -> note_index);
+    }
+    // The DMA playback stops now: the note that was playing is played again on resume
+    if (p_fsm -> dma && (action != PLAY) && port_buzzer_get_dma_busy(p_fsm -> buzzer_id)) {
+        p_fsm -> note_index = p_fsm -> dma_first_note + port_buzzer_dma_stop(p_fsm -> buzzer_id);
+        p_fsm -> schedule_resync = true;
+    }
     if (action == STOP) {
         p_fsm -> note_index = 0;
+        p_fsm -> next_staged = false;
+        p_fsm -> seek_offset_ms = 0;
+        // A stop ends the melodies that follow
+        p_fsm -> p_next_melody = NULL;
     }
 }	
 
@@ -390,17 +1228,54 @@ void fsm_buzzer_init(fsm_t *p_this, uint32_t buzzer_id)
     p_fsm -> note_index = 0;
     p_fsm -> user_action = STOP;
     p_fsm -> player_speed = 1.0;
+    p_fsm -> speed_q8 = FSM_BUZZER_SPEED_Q8_ONE;
+    p_fsm -> p_compiled = NULL;
+    p_fsm -> gapless = false;
+    p_fsm -> next_staged = false;
+    p_fsm -> sequencer = false;
+    p_fsm -> dma = false;
+    p_fsm -> dma_first_note = 0;
+    p_fsm -> absolute_time = false;
+    p_fsm -> schedule_resync = false;
+    p_fsm -> schedule_us = 0;
+    p_fsm -> drift_us = 0;
+    p_fsm -> ramp_target_q8 = FSM_BUZZER_SPEED_Q8_ONE;
+    p_fsm -> ramp_remaining_us = 0;
+    p_fsm -> p_multitrack = NULL;
+    p_fsm -> voices.stolen_notes = 0;
+    melody_timeline_build(&(p_fsm -> timeline), NULL);
+    p_fsm -> total_ms = 0;
+    p_fsm -> seek_offset_ms = 0;
+    p_fsm -> p_next_melody = NULL;
+    p_fsm -> p_next_compiled = NULL;
     port_buzzer_init (p_fsm -> buzzer_id); 
 }
 
 
 /**
- * @brief Check if the buzzer finite state machine is playing a melody.
+ * @brief Check if the buzzer finite state machine is playing a melody. \n
+ * A melody played by DMA does not need the CPU until its end, so the player is not active meanwhile.
  * 
  * @param p_this Pointer to an fsm_t struct than contains an fsm_buzzer_t struct
  * @return true 
  * @return false 
  */
 bool fsm_buzzer_check_activity(fsm_t *p_this){
+    fsm_buzzer_t *p_fsm = (fsm_buzzer_t *)(p_this);
+    if (p_fsm -> dma && port_buzzer_get_dma_busy(p_fsm -> buzzer_id)) {
+        return false;
+    }
     return check_resume(p_this);
 }	
+
+void fsm_buzzer_refill (fsm_t *p_this) {
+    fsm_buzzer_t *p_fsm = (fsm_buzzer_t *)(p_this);
+    if ((p_fsm -> p_melody != NULL) && (p_fsm -> p_melody -> p_stream != NULL) && (p_fsm -> user_action == PLAY)) {
+        melody_stream_refill(p_fsm -> p_melody -> p_stream);
+    }
+}
+
+void fsm_buzzer_hold (fsm_t *p_this, bool hold) {
+    fsm_buzzer_t *p_fsm = (fsm_buzzer_t *)(p_this);
+    port_buzzer_set_note_interrupt(p_fsm -> buzzer_id, !hold);
+}
@@ -16,61 +16,373 @@
 #include <stdlib.h>
 
 #include "fsm_jukebox.h"
+#include "command_frame.h"
 #include "fsm_button.h"
 #include "fsm_usart.h"
 #include "fsm_buzzer.h"
 #include "port_system.h"
 #include "port_usart.h"
+#include "port_melody_bank.h"
+#include "port_storage.h"
 
 /* Defines ------------------------------------------------------------------*/
 #define MAX(a, b) ((a) > (b) ? (a) : (b)) /*!< Macro to get the maximum of two values. */
+#define MIN(a, b) ((a) < (b) ? (a) : (b)) /*!< Macro to get the minimum of two values. */
+#define JUKEBOX_MIN_SPEED_Q8 26U /*!< Lowest speed set by the speed command: 0.1 in Q8.8 */
+#define JUKEBOX_SPEED_FRACTION_BITS 8U /*!< Fractional bits of the speed parsed by the speed command: Q8.8 */
 
 /* Private functions */
 
 /**
- * @brief Parse the message received by the USART.
- * 
- * Given data received by the USART, this function parses the message and extracts the command and the parameter (if available).
- * 
- * > 1. Split the message by space using function `strtok()` \n
- * > 2. If there's a token (command), copy it to the `p_command` variable. Otherwise, return `false` \n
- * > 3. Extract the parameter (if available). To do so, get the next token using function `strtok()`. If there's a token, copy it to the `p_param` variable. Otherwise, copy an empty string to the `p_param` variable \n
- * > 4. Return `true` indicating that the message has been parsed correctly \n
- * 
- * @param p_message Pointer to the message received by the USART.
- * @param p_command Pointer to store the command extracted from the message. 
- * @param p_param Pointer to store the parameter extracted from the message. 
- * @return true if the message has been parsed correctly 
- * @return false if the message has not been parsed correctly 
+ * @brief Get the index of the first melody uploaded in the library of the jukebox: the melodies uploaded follow the melodies of the bank and the melodies streamed.
+ * @param p_fsm_jukebox	Pointer to the Jukebox FSM.
+ * @return uint32_t Index of the first melody of the pool.
  */
-bool _parse_message(char *p_message, char *p_command, char *p_param)
-{
-    char *p_token = strtok(p_message, ""); // Split the message by space
+static uint32_t _library_get_pool_offset(fsm_jukebox_t *p_fsm_jukebox){
+    return melody_bank_get_length(p_fsm_jukebox -> p_bank) + melody_stream_get_length(&(p_fsm_jukebox -> stream));
+}
+
+/**
+ * @brief Get the number of melodies of the library of the jukebox: the melodies of the bank, the melodies streamed and the melodies uploaded.
+ * @param p_fsm_jukebox	Pointer to the Jukebox FSM.
+ * @return uint32_t Number of melodies.
+ */
+static uint32_t _library_get_length(fsm_jukebox_t *p_fsm_jukebox){
+    return _library_get_pool_offset(p_fsm_jukebox) + melody_pool_get_length(&(p_fsm_jukebox -> pool));
+}
+
+/**
+ * @brief Get the id in the cache of a packed melody of the active bank: its index, with the generation of the bank in
+ * the upper bits. The ids of the melodies streamed are their indexes in the stream, whose generation is 0.
+ * @param p_fsm_jukebox	Pointer to the Jukebox FSM.
+ * @param index Index of the melody in the bank.
+ * @return uint32_t Id of the melody in the cache.
+ */
+static uint32_t _library_get_cache_id(fsm_jukebox_t *p_fsm_jukebox, uint32_t index){
+    return ((uint32_t)p_fsm_jukebox -> bank_generation << 16) | index;
+}
+
+/**
+ * @brief Get a melody of the library of the jukebox.
+ * @param p_fsm_jukebox	Pointer to the Jukebox FSM.
+ * @param index Index of the melody in the library.
+ * @param p_melody Pointer to store the melody.
+ * @return true if the melody exists
+ * @return false otherwise
+ */
+static bool _library_get_melody(fsm_jukebox_t *p_fsm_jukebox, uint32_t index, melody_t *p_melody){
+    const melody_bank_t *p_bank = p_fsm_jukebox -> p_bank; // Read once: a swap of the bank takes effect at the next lookup
+    uint32_t bank_length = melody_bank_get_length(p_bank);
+    if (index < bank_length){
+        if (!melody_bank_is_packed(p_bank, index)){
+            return melody_bank_get_melody(p_bank, index, p_melody);
+        }
+        // A packed melody is read from the cache if it was played lately. Otherwise it is decoded into the cache if it
+        // fits; if not, its tokens are decoded from the bank as it plays
+        uint32_t id = _library_get_cache_id(p_fsm_jukebox, index);
+        if (melody_cache_get(&(p_fsm_jukebox -> cache), id, p_melody)){
+            return true;
+        }
+        if (!melody_bank_get_packed(p_bank, index, &(p_fsm_jukebox -> codec), p_melody)){
+            return false;
+        }
+        melody_cache_store(&(p_fsm_jukebox -> cache), id, p_melody, p_melody);
+        return true;
+    }
+    index -= bank_length;
+    // A melody streamed is read from the cache if it was played lately. Otherwise it is open, and decoded into the
+    // cache if it fits; if not, only the notes of its ring are read
+    uint32_t stream_length = melody_stream_get_length(&(p_fsm_jukebox -> stream));
+    if (index < stream_length){
+        if (melody_cache_get(&(p_fsm_jukebox -> cache), index, p_melody)){
+            return true;
+        }
+        if (!melody_stream_open(&(p_fsm_jukebox -> stream), index, p_melody)){
+            return false;
+        }
+        melody_cache_store(&(p_fsm_jukebox -> cache), index, p_melody, p_melody);
+        return true;
+    }
+    return melody_pool_get_melody(&(p_fsm_jukebox -> pool), index - stream_length, p_melody);
+}
 
-    // If there's a token (command), copy it to the command variable
-    if (p_token != NULL)
-    {
-        strcpy(p_command, p_token);
+/**
+ * @brief Find a melody of the library of the jukebox by its name: in the bank and in the stream by their perfect hash,
+ * and among the few melodies uploaded one by one.
+ * @param p_fsm_jukebox	Pointer to the Jukebox FSM.
+ * @param p_name Name of the melody.
+ * @return int32_t Index of the melody in the library, or -1 if there is no melody with that name.
+ */
+static int32_t _library_find(fsm_jukebox_t *p_fsm_jukebox, const char *p_name){
+    const melody_bank_t *p_bank = p_fsm_jukebox -> p_bank;
+    int32_t index = melody_bank_find(p_bank, p_name);
+    if (index >= 0){
+        return index;
     }
-    else
-    {
-        // No command found, you might return an error or handle it as needed
-        // The USART driver of the computer sends an empty at initialization, so we will ignore it
-        return false;
+    index = melody_stream_find(&(p_fsm_jukebox -> stream), p_name);
+    if (index >= 0){
+        return (int32_t)melody_bank_get_length(p_bank) + index;
+    }
+    index = melody_pool_find(&(p_fsm_jukebox -> pool), p_name);
+    if (index >= 0){
+        return (int32_t)_library_get_pool_offset(p_fsm_jukebox) + index;
+    }
+    return -1;
+}
+
+/**
+ * @brief Update the index of the melody selected if it is an uploaded melody: the indexes of the pool change when melodies are evicted.
+ * @param p_fsm_jukebox	Pointer to the Jukebox FSM.
+ */
+static void _library_update_index(fsm_jukebox_t *p_fsm_jukebox){
+    uint32_t pool_offset = _library_get_pool_offset(p_fsm_jukebox);
+    if ((p_fsm_jukebox -> melody_idx >= pool_offset) && (p_fsm_jukebox -> melody.p_name != NULL)){
+        int32_t index = melody_pool_find(&(p_fsm_jukebox -> pool), p_fsm_jukebox -> melody.p_name);
+        if (index >= 0){
+            p_fsm_jukebox -> melody_idx = (uint16_t)(pool_offset + (uint32_t)index);
+        }
+    }
+}
+
+/**
+ * @brief Get the melody of the library of a command line: an index checked against the library, or a name. A name with
+ * spaces may be quoted or not.
+ * @param p_fsm_jukebox	Pointer to the Jukebox FSM.
+ * @param p_line Pointer to the command line.
+ * @return int32_t Index of the melody in the library, or -1 if there is no such melody.
+ */
+static int32_t _library_resolve(fsm_jukebox_t *p_fsm_jukebox, command_line_t *p_line){
+    uint32_t index;
+    if ((p_line -> num_args == 1) && command_line_get_uint(p_line, 0, &index)){
+        return (index < _library_get_length(p_fsm_jukebox)) ? (int32_t)index : -1;
+    }
+    return _library_find(p_fsm_jukebox, command_line_get_rest(p_line, 0));
+}
+
+/**
+ * @brief Write the name of a melody of the library, with no change to the stream: a melody streamed is written as its index.
+ * @param p_fsm_jukebox	Pointer to the Jukebox FSM.
+ * @param index Index of the melody in the library.
+ * @param p_text Pointer to store the name.
+ * @param size Size of the buffer of the name.
+ */
+static void _library_format_name(fsm_jukebox_t *p_fsm_jukebox, uint32_t index, char *p_text, uint32_t size){
+    const melody_bank_t *p_bank = p_fsm_jukebox -> p_bank;
+    uint32_t pool_offset = _library_get_pool_offset(p_fsm_jukebox);
+    melody_t melody;
+    if (index < melody_bank_get_length(p_bank)){
+        snprintf(p_text, size, "%s", melody_bank_get_name(p_bank, index));
+    }
+    else if ((index >= pool_offset) && melody_pool_get_melody(&(p_fsm_jukebox -> pool), index - pool_offset, &melody)){
+        snprintf(p_text, size, "%s", melody.p_name);
+    }
+    else{
+        snprintf(p_text, size, "#%lu", (unsigned long)index);
+    }
+}
+
+/**
+ * @brief Check if a pointer points into the image of a melody bank.
+ * @param p_bank Pointer to the melody bank, or NULL.
+ * @param p_data Pointer to check.
+ * @return true if the pointer is within the image of the bank
+ * @return false otherwise
+ */
+static bool _bank_contains(const melody_bank_t *p_bank, const void *p_data){
+    const uint8_t *p_start = (const uint8_t *)p_bank;
+    return (p_bank != NULL) && ((const uint8_t *)p_data >= p_start) && ((const uint8_t *)p_data < p_start + p_bank -> size);
+}
+
+/**
+ * @brief Get the data the notes of the melody selected are read from: its notes, or the tokens of its codec if it is packed.
+ * @param p_fsm_jukebox	Pointer to the Jukebox FSM.
+ * @return const void* Pointer to the data, or NULL if the melody has none in memory.
+ */
+static const void *_melody_get_data(fsm_jukebox_t *p_fsm_jukebox){
+    const melody_t *p_melody = &(p_fsm_jukebox -> melody);
+    return (p_melody -> p_codec != NULL) ? (const void *)p_melody -> p_codec -> p_data : (const void *)p_melody -> p_midi_notes;
+}
+
+/**
+ * @brief Check if the melody selected has been decoded into the cache: nothing of it points into a bank.
+ * @param p_fsm_jukebox	Pointer to the Jukebox FSM.
+ * @return true if the notes of the melody selected are in the cache
+ * @return false otherwise
+ */
+static bool _melody_is_cached(fsm_jukebox_t *p_fsm_jukebox){
+    const uint8_t *p_start = (const uint8_t *)&(p_fsm_jukebox -> cache);
+    const uint8_t *p_notes = p_fsm_jukebox -> melody.p_midi_notes;
+    return (p_notes >= p_start) && (p_notes < p_start + sizeof(p_fsm_jukebox -> cache));
+}
+
+/**
+ * @brief Get the index in the library of a melody after a swap of the bank: a melody of the old bank by its name, a
+ * melody streamed or uploaded after the melodies of the new bank.
+ * @param p_old_bank Pointer to the old bank, or NULL.
+ * @param p_new_bank Pointer to the new bank.
+ * @param index Index of the melody in the library with the old bank.
+ * @return int32_t Index of the melody in the library with the new bank, or -1 if it is not in the new bank.
+ */
+static int32_t _bank_remap_index(const melody_bank_t *p_old_bank, const melody_bank_t *p_new_bank, uint32_t index){
+    uint32_t old_length = melody_bank_get_length(p_old_bank);
+    if (index >= old_length){
+        return (int32_t)(melody_bank_get_length(p_new_bank) + (index - old_length));
+    }
+    return melody_bank_find(p_new_bank, melody_bank_get_name(p_old_bank, index));
+}
+
+/**
+ * @brief Release the old melody bank once its melody is not playing: the melody selected and its name are read again
+ * from the active bank, so nothing points into the old bank and its slot can be reflashed.
+ * @param p_fsm_jukebox	Pointer to the Jukebox FSM.
+ */
+static void _bank_release(fsm_jukebox_t *p_fsm_jukebox){
+    const melody_bank_t *p_bank = p_fsm_jukebox -> p_bank;
+    const void *p_data = _melody_get_data(p_fsm_jukebox);
+    if ((fsm_buzzer_get_action(p_fsm_jukebox -> p_fsm_buzzer) != STOP) || (p_fsm_jukebox -> melody_idx >= melody_bank_get_length(p_bank))){
+        return;
+    }
+    if (_melody_is_cached(p_fsm_jukebox) || (_bank_contains(p_bank, p_fsm_jukebox -> p_melody) && ((p_data == NULL) || _bank_contains(p_bank, p_data)))){
+        return;
+    }
+    p_fsm_jukebox -> p_melody = (char *)melody_bank_get_name(p_bank, p_fsm_jukebox -> melody_idx);
+    if (p_data != NULL){
+        _library_get_melody(p_fsm_jukebox, p_fsm_jukebox -> melody_idx, &(p_fsm_jukebox -> melody));
+        fsm_buzzer_set_melody(p_fsm_jukebox -> p_fsm_buzzer, &(p_fsm_jukebox -> melody));
+    }
+}
+
+/**
+ * @brief Hold the player while the pool moves the notes of the melody selected: the ISR of the player reads them in sequencer mode.
+ * @param p_arg Pointer to the Buzzer FSM.
+ * @param hold True to hold the player, false to release it.
+ */
+static void _pool_hold(void *p_arg, bool hold){
+    fsm_buzzer_hold((fsm_t *)p_arg, hold);
+}
+
+/**
+ * @brief Handle a line received while a melody is uploaded: `end` stores the melody in the pool, `abort` drops it, and
+ * any other line is decoded as the next chunk of the melody. Decoding is incremental, so the melody playing is not stopped.
+ * @param p_fsm_jukebox	Pointer to the Jukebox FSM.
+ * @param p_message Line received by the USART.
+ */
+static void _upload_line(fsm_jukebox_t *p_fsm_jukebox, char *p_message){
+    char msg[USART_OUTPUT_BUFFER_LENGTH];
+    if (strcmp(p_message, "abort") == 0){
+        melody_upload_abort(&(p_fsm_jukebox -> upload));
+        fsm_usart_set_out_data(p_fsm_jukebox -> p_fsm_usart, "Upload aborted\n");
+    }
+    else if (strcmp(p_message, "end") == 0){
+        int32_t index = melody_upload_end(&(p_fsm_jukebox -> upload));
+        _library_update_index(p_fsm_jukebox);
+        if (index >= 0){
+            melody_t melody;
+            uint32_t library_index = _library_get_pool_offset(p_fsm_jukebox) + (uint32_t)index;
+            melody_pool_get_melody(&(p_fsm_jukebox -> pool), (uint32_t)index, &melody);
+            sprintf(msg, "Uploaded: %s (%lu)\n", melody.p_name, (unsigned long)library_index);
+            fsm_usart_set_out_data(p_fsm_jukebox -> p_fsm_usart, msg);
+        }
+        else{
+            fsm_usart_set_out_data(p_fsm_jukebox -> p_fsm_usart, "Error : Upload failed\n");
+        }
+    }
+    else if (!melody_upload_feed(&(p_fsm_jukebox -> upload), p_message)){
+        _library_update_index(p_fsm_jukebox);
+        fsm_usart_set_out_data(p_fsm_jukebox -> p_fsm_usart, "Error : Upload failed\n");
+    }
+    else{
+        _library_update_index(p_fsm_jukebox);
     }
+}
 
-    // Extract the parameter (if available)
-    p_token = strtok(NULL, ""); // Get the next token
+/**
+ * @brief Get the index in the library of a melody of the queue: an uploaded melody is found in the pool by its name.
+ * @param p_fsm_jukebox	Pointer to the Jukebox FSM.
+ * @param p_entry Pointer to the melody of the queue.
+ * @return int32_t Index of the melody in the library, or -1 if it has been evicted from the pool.
+ */
+static int32_t _queue_get_index(fsm_jukebox_t *p_fsm_jukebox, const jukebox_queue_entry_t *p_entry){
+    if (p_entry -> name[0] == '\0'){
+        return p_entry -> index;
+    }
+    int32_t index = melody_pool_find(&(p_fsm_jukebox -> pool), p_entry -> name);
+    return (index >= 0) ? (int32_t)_library_get_pool_offset(p_fsm_jukebox) + index : -1;
+}
 
-    if (p_token != NULL)
-    {
-        strcpy(p_param, p_token);
+/**
+ * @brief Write the name of a melody of the queue: an uploaded melody is written as the name it was queued with.
+ * @param p_fsm_jukebox	Pointer to the Jukebox FSM.
+ * @param p_entry Pointer to the melody of the queue.
+ * @param p_text Pointer to store the name.
+ * @param size Size of the buffer of the name.
+ */
+static void _queue_format_name(fsm_jukebox_t *p_fsm_jukebox, const jukebox_queue_entry_t *p_entry, char *p_text, uint32_t size){
+    if (p_entry -> name[0] != '\0'){
+        snprintf(p_text, size, "%s", p_entry -> name);
     }
-    else
-    {
-        strcpy(p_param, " "); // NO param found
+    else{
+        _library_format_name(p_fsm_jukebox, p_entry -> index, p_text, size);
     }
-    return true;
+}
+
+/**
+ * @brief Set the melody at the head of the queue in the buzzer, to follow the melody playing with no gap. \n
+ * Only a melody of the bank that is not packed is set: its notes stay in place while the melody playing goes on, whereas
+ * a packed melody needs a codec, a melody streamed needs the stream and an uploaded melody may be moved by the pool. The
+ * others are played when the buzzer stops.
+ * @param p_fsm_jukebox	Pointer to the Jukebox FSM.
+ */
+static void _queue_stage_next(fsm_jukebox_t *p_fsm_jukebox){
+    //The melody staged is dropped first. Its view is not overwritten if the buzzer has already gone on with it
+    fsm_buzzer_set_next_melody(p_fsm_jukebox -> p_fsm_buzzer, NULL);
+    if (fsm_buzzer_get_melody(p_fsm_jukebox -> p_fsm_buzzer) == &(p_fsm_jukebox -> next_melody)){
+        return;
+    }
+    if (p_fsm_jukebox -> stopped || (p_fsm_jukebox -> queue_count == 0)){
+        return;
+    }
+    const melody_bank_t *p_bank = p_fsm_jukebox -> p_bank;
+    int32_t index = _queue_get_index(p_fsm_jukebox, &(p_fsm_jukebox -> play_queue[p_fsm_jukebox -> queue_head]));
+    if ((index >= 0) && ((uint32_t)index < melody_bank_get_length(p_bank)) && melody_bank_get_melody(p_bank, (uint32_t)index, &(p_fsm_jukebox -> next_melody))){
+        p_fsm_jukebox -> next_idx = (uint16_t)index;
+        fsm_buzzer_set_next_melody(p_fsm_jukebox -> p_fsm_buzzer, &(p_fsm_jukebox -> next_melody));
+    }
+}
+
+/**
+ * @brief Take the melody at the head of the queue.
+ * @param p_fsm_jukebox	Pointer to the Jukebox FSM. The queue must not be empty.
+ * @return const jukebox_queue_entry_t* Pointer to the melody taken. It is valid until another melody is queued.
+ */
+static const jukebox_queue_entry_t *_queue_pop(fsm_jukebox_t *p_fsm_jukebox){
+    const jukebox_queue_entry_t *p_entry = &(p_fsm_jukebox -> play_queue[p_fsm_jukebox -> queue_head]);
+    p_fsm_jukebox -> queue_head = (uint8_t)((p_fsm_jukebox -> queue_head + 1U) % JUKEBOX_QUEUE_LENGTH);
+    p_fsm_jukebox -> queue_count--;
+    return p_entry;
+}
+
+/**
+ * @brief Move the melodies of the queue to their indexes with a new bank. The melodies of the old bank that are not in
+ * the new bank are dropped from the queue. The uploaded melodies are kept by their names and need no change.
+ * @param p_fsm_jukebox	Pointer to the Jukebox FSM.
+ * @param p_new_bank Pointer to the new bank. The old bank is still the active one.
+ */
+static void _queue_remap(fsm_jukebox_t *p_fsm_jukebox, const melody_bank_t *p_new_bank){
+    uint8_t count = 0;
+    for (uint32_t i = 0; i < p_fsm_jukebox -> queue_count; i++){
+        jukebox_queue_entry_t entry = p_fsm_jukebox -> play_queue[(p_fsm_jukebox -> queue_head + i) % JUKEBOX_QUEUE_LENGTH];
+        if (entry.name[0] == '\0'){
+            int32_t index = _bank_remap_index(p_fsm_jukebox -> p_bank, p_new_bank, entry.index);
+            if (index < 0){
+                continue;
+            }
+            entry.index = (uint16_t)index;
+        }
+        p_fsm_jukebox -> play_queue[(p_fsm_jukebox -> queue_head + count) % JUKEBOX_QUEUE_LENGTH] = entry;
+        count++;
+    }
+    p_fsm_jukebox -> queue_count = count;
 }
 
 /**
@@ -80,108 +392,355 @@ bool _parse_message(char *p_message, char *p_command, char *p_param)
 void _set_next_song	(fsm_jukebox_t * p_fsm_jukebox){
     //Stop the buzzer by calling fsm_buzzer_set_action() with the right parameter.
     fsm_buzzer_set_action (p_fsm_jukebox->p_fsm_buzzer, STOP);
-    //Update the melody index to select to the next song by increasing this melody_idx in 1. If the result equals or greater than the maximum number of melodies (MELODIES_MEMORY_SIZE), set the index to 0.
+    //Update the melody index to select to the next song by increasing this melody_idx in 1. If the result equals or greater than the number of melodies of the library, set the index to 0.
     p_fsm_jukebox -> melody_idx++;
-    if(p_fsm_jukebox -> melody_idx >= MELODIES_MEMORY_SIZE){
-        p_fsm_jukebox -> melody_idx = 0;
-    } 
-    //Check if the melody exists. A melody exists if the length of the melody is greater than 0. If it does not exist, set the index of the melody to be played (melody_idx) to 0. After updating the melody_idx the name of the melody to be played (p_melody) to the name of the melody selected before.
-    if (p_fsm_jukebox -> melodies[p_fsm_jukebox -> melody_idx].melody_length <= 0){
+    if (p_fsm_jukebox -> melody_idx >= _library_get_length(p_fsm_jukebox)){
         p_fsm_jukebox -> melody_idx = 0;
     }
+    //Read the melody from the library. If the library is empty there is nothing to play.
+    if (!_library_get_melody(p_fsm_jukebox, p_fsm_jukebox -> melody_idx, &(p_fsm_jukebox -> melody))){
+        return;
+    }
     //Print by the ITM terminal the message "Playing: %s\n" by calling printf() with the name of the melody to be played.
-    printf("Playing: %s\n", p_fsm_jukebox -> p_melody = p_fsm_jukebox -> melodies[p_fsm_jukebox -> melody_idx].p_name);
+    printf("Playing: %s\n", p_fsm_jukebox -> p_melody = p_fsm_jukebox -> melody.p_name);
     //Set the melody to be played by calling fsm_buzzer_set_melody() properly.
-    fsm_buzzer_set_melody(p_fsm_jukebox -> p_fsm_buzzer, &(p_fsm_jukebox -> melodies[p_fsm_jukebox -> melody_idx]));
+    fsm_buzzer_set_melody(p_fsm_jukebox -> p_fsm_buzzer, &(p_fsm_jukebox -> melody));
     //Set the status of the buzzer correctly by calling fsm_buzzer_set_action(). After this call, the buzzer will start playing the melody.
     fsm_buzzer_set_action(p_fsm_jukebox -> p_fsm_buzzer, PLAY);
+    //The queue goes on after the melody
+    p_fsm_jukebox -> stopped = false;
+    _queue_stage_next(p_fsm_jukebox);
+}
 
+/**
+ * @brief Handler of the command `play`: play the melody selected.
+ * @param p_context Pointer to the Jukebox FSM.
+ * @param p_line Pointer to the command line: no arguments.
+ */
+static void _command_play(void *p_context, command_line_t *p_line){
+    fsm_jukebox_t *p_fsm_jukebox = (fsm_jukebox_t *)p_context;
+    fsm_buzzer_set_action(p_fsm_jukebox -> p_fsm_buzzer, PLAY);
+    p_fsm_jukebox -> stopped = false;
+    _queue_stage_next(p_fsm_jukebox);
 }
 
 /**
- * @brief Execute the command received by the USART.
- * @param p_fsm_jukebox	Pointer to the Jukebox FSM.
- * @param p_command Pointer to store the command extracted from the message. 
- * @param p_param Pointer to store the parameter extracted from the message.  
+ * @brief Handler of the command `stop`: stop the melody playing. The queue is kept, but it does not advance.
+ * @param p_context Pointer to the Jukebox FSM.
+ * @param p_line Pointer to the command line: no arguments.
+ */
+static void _command_stop(void *p_context, command_line_t *p_line){
+    fsm_jukebox_t *p_fsm_jukebox = (fsm_jukebox_t *)p_context;
+    p_fsm_jukebox -> stopped = true;
+    fsm_buzzer_set_action(p_fsm_jukebox -> p_fsm_buzzer, STOP);
+}
+
+/**
+ * @brief Handler of the command `pause`: pause the melody playing.
+ * @param p_context Pointer to the Jukebox FSM.
+ * @param p_line Pointer to the command line: no arguments.
+ */
+static void _command_pause(void *p_context, command_line_t *p_line){
+    fsm_jukebox_t *p_fsm_jukebox = (fsm_jukebox_t *)p_context;
+    fsm_buzzer_set_action(p_fsm_jukebox -> p_fsm_buzzer, PAUSE);
+}
+
+/**
+ * @brief Handler of the command `speed <factor> [ramp_ms]`: with a ramp the tempo changes gradually along ramp_ms of the melody.
+ * @param p_context Pointer to the Jukebox FSM.
+ * @param p_line Pointer to the command line.
  */
-void _execute_command	(fsm_jukebox_t * p_fsm_jukebox, char * p_command, char * p_param){
-    if (strcmp(p_command, "play") == 0)
-    {
+static void _command_speed(void *p_context, command_line_t *p_line){
+    fsm_jukebox_t *p_fsm_jukebox = (fsm_jukebox_t *)p_context;
+    uint32_t speed_q8;
+    uint32_t ramp_ms = 0;
+    if (!command_line_get_fixed(p_line, 0, JUKEBOX_SPEED_FRACTION_BITS, &speed_q8) || ((p_line -> num_args > 1) && !command_line_get_uint(p_line, 1, &ramp_ms))){
+        fsm_usart_set_out_data(p_fsm_jukebox -> p_fsm_usart, "Error : Wrong arguments\n");
+        return;
+    }
+    speed_q8 = MIN(speed_q8, UINT16_MAX);
+    fsm_buzzer_set_speed_ramp(p_fsm_jukebox -> p_fsm_buzzer, (uint16_t)MAX(speed_q8, JUKEBOX_MIN_SPEED_Q8), ramp_ms);
+}
+
+/**
+ * @brief Handler of the command `next`: play the next melody of the library.
+ * @param p_context Pointer to the Jukebox FSM.
+ * @param p_line Pointer to the command line: no arguments.
+ */
+static void _command_next(void *p_context, command_line_t *p_line){
+    _set_next_song((fsm_jukebox_t *)p_context);
+}
+
+/**
+ * @brief Handler of the command `select <index>` or `select <name>`: the index is checked against the library, and
+ * becomes the melody selected. A name with spaces may be quoted or not.
+ * @param p_context Pointer to the Jukebox FSM.
+ * @param p_line Pointer to the command line.
+ */
+static void _command_select(void *p_context, command_line_t *p_line){
+    fsm_jukebox_t *p_fsm_jukebox = (fsm_jukebox_t *)p_context;
+    int32_t melody_selected = _library_resolve(p_fsm_jukebox, p_line);
+    // The melody playing is stopped before its view is overwritten
+    if (melody_selected >= 0){
+        fsm_buzzer_set_action(p_fsm_jukebox -> p_fsm_buzzer, STOP);
+    }
+    if ((melody_selected >= 0) && _library_get_melody(p_fsm_jukebox, (uint32_t)melody_selected, &(p_fsm_jukebox -> melody))){
+        p_fsm_jukebox -> melody_idx = (uint16_t)melody_selected;
+        p_fsm_jukebox -> p_melody = p_fsm_jukebox -> melody.p_name;
+        fsm_buzzer_set_melody(p_fsm_jukebox -> p_fsm_buzzer, &(p_fsm_jukebox -> melody));
         fsm_buzzer_set_action(p_fsm_jukebox -> p_fsm_buzzer, PLAY);
+        p_fsm_jukebox -> stopped = false;
+        _queue_stage_next(p_fsm_jukebox);
     }
-    else
-    {
-        if (strcmp(p_command, "stop") == 0)
-        {
-            fsm_buzzer_set_action(p_fsm_jukebox -> p_fsm_buzzer, STOP);
-        }
-        else
-        {
-            if (strcmp(p_command, "pause") == 0)
-            {
-                fsm_buzzer_set_action(p_fsm_jukebox -> p_fsm_buzzer, PAUSE);
-            }
-            else
-            {
-                if (strcmp(p_command, "speed") == 0)
-                {
-                    double param = atof(p_param);
-                    fsm_buzzer_set_speed(p_fsm_jukebox -> p_fsm_buzzer, MAX(param, 0.1));
-                }
-                else
-                {
-                    if (strcmp(p_command, "next") == 0)
-                    {
-                        _set_next_song(p_fsm_jukebox);
-                    }
-                    else
-                    {
-                        if (strcmp(p_command, "select") == 0)
-                        {
-                            uint32_t melody_selected = atoi(p_param);
-                            if (p_fsm_jukebox->melodies[p_fsm_jukebox->melody_idx].melody_length != 0)
-                            {
-                                fsm_buzzer_set_action(p_fsm_jukebox -> p_fsm_buzzer, STOP);
-                                fsm_buzzer_set_melody(p_fsm_jukebox -> p_fsm_buzzer, &p_fsm_jukebox->melodies[melody_selected]);
-
-
-                                fsm_buzzer_set_action(p_fsm_jukebox -> p_fsm_buzzer, PLAY);
-                            }
-                            else
-                            {
-                                char *error = "Error : Command not found\n";
-                                fsm_usart_set_out_data(p_fsm_jukebox->p_fsm_usart, error);
-                            }
-                        }
-                        else
-                        {
-                            if (strcmp(p_command, "info") == 0)
-                            {
-                                char msg[USART_OUTPUT_BUFFER_LENGTH];
-                                sprintf(msg, "Playing: %s\n", p_fsm_jukebox->p_melody);
-                                fsm_usart_set_out_data(p_fsm_jukebox->p_fsm_usart, msg);
-                            }
-                            else
-                            {
-                                char *error = "Error : Command not found\n";
-                                fsm_usart_set_out_data(p_fsm_jukebox->p_fsm_usart, error);
-                            }
-                        }
-                        
-                    }
-                    
-                }
-                
-            }
-            
+    else{
+        fsm_usart_set_out_data(p_fsm_jukebox -> p_fsm_usart, "Error : Melody not found\n");
+    }
+}
+
+/**
+ * @brief Handler of the command `info`: time played and duration of the melody at the speed of the player.
+ * @param p_context Pointer to the Jukebox FSM.
+ * @param p_line Pointer to the command line: no arguments.
+ */
+static void _command_info(void *p_context, command_line_t *p_line){
+    fsm_jukebox_t *p_fsm_jukebox = (fsm_jukebox_t *)p_context;
+    char msg[USART_OUTPUT_BUFFER_LENGTH];
+    uint32_t elapsed_ms;
+    uint32_t total_ms;
+    fsm_buzzer_get_progress(p_fsm_jukebox -> p_fsm_buzzer, &elapsed_ms, &total_ms);
+    sprintf(msg, "Playing: %s %lu/%lu ms\n", p_fsm_jukebox -> p_melody, (unsigned long)elapsed_ms, (unsigned long)total_ms);
+    fsm_usart_set_out_data(p_fsm_jukebox -> p_fsm_usart, msg);
+}
+
+/**
+ * @brief Handler of the command `drift`: drift of the notes played from their timeline.
+ * @param p_context Pointer to the Jukebox FSM.
+ * @param p_line Pointer to the command line: no arguments.
+ */
+static void _command_drift(void *p_context, command_line_t *p_line){
+    fsm_jukebox_t *p_fsm_jukebox = (fsm_jukebox_t *)p_context;
+    char msg[USART_OUTPUT_BUFFER_LENGTH];
+    sprintf(msg, "Drift: %ld us\n", (long)fsm_buzzer_get_drift_us(p_fsm_jukebox -> p_fsm_buzzer));
+    fsm_usart_set_out_data(p_fsm_jukebox -> p_fsm_usart, msg);
+}
+
+/**
+ * @brief Handler of the command `seek <ms>`: time of the melody at the speed of the player, as shown by info.
+ * @param p_context Pointer to the Jukebox FSM.
+ * @param p_line Pointer to the command line.
+ */
+static void _command_seek(void *p_context, command_line_t *p_line){
+    fsm_jukebox_t *p_fsm_jukebox = (fsm_jukebox_t *)p_context;
+    uint32_t time_ms;
+    if (!command_line_get_uint(p_line, 0, &time_ms)){
+        fsm_usart_set_out_data(p_fsm_jukebox -> p_fsm_usart, "Error : Wrong arguments\n");
+    }
+    else if (!fsm_buzzer_seek(p_fsm_jukebox -> p_fsm_buzzer, time_ms)){
+        fsm_usart_set_out_data(p_fsm_jukebox -> p_fsm_usart, "Error : Seek failed\n");
+    }
+}
+
+/**
+ * @brief Handler of the command `upload <name> [tick_ms]`: the next lines are the melody, in RTTTL or, with tick_ms, in
+ * hexadecimal pairs note, ticks. Ended by "end". A name with spaces is quoted.
+ * @param p_context Pointer to the Jukebox FSM.
+ * @param p_line Pointer to the command line.
+ */
+static void _command_upload(void *p_context, command_line_t *p_line){
+    fsm_jukebox_t *p_fsm_jukebox = (fsm_jukebox_t *)p_context;
+    uint32_t tick_ms = 0;
+    bool valid = (p_line -> num_args == 1) || (command_line_get_uint(p_line, 1, &tick_ms) && (tick_ms <= UINT16_MAX));
+    if (valid && melody_upload_begin(&(p_fsm_jukebox -> upload), command_line_get_string(p_line, 0), (uint16_t)tick_ms)){
+        _library_update_index(p_fsm_jukebox);
+    }
+    else{
+        fsm_usart_set_out_data(p_fsm_jukebox -> p_fsm_usart, "Error : Upload failed\n");
+    }
+}
+
+/**
+ * @brief Handler of the command `bank`: swap to the bank reflashed in the free slot. The melody playing goes on from the old bank.
+ * @param p_context Pointer to the Jukebox FSM.
+ * @param p_line Pointer to the command line: no arguments.
+ */
+static void _command_bank(void *p_context, command_line_t *p_line){
+    fsm_jukebox_t *p_fsm_jukebox = (fsm_jukebox_t *)p_context;
+    char msg[USART_OUTPUT_BUFFER_LENGTH];
+    int32_t length = fsm_jukebox_swap_bank(&(p_fsm_jukebox -> f));
+    if (length >= 0){
+        sprintf(msg, "Bank: %ld melodies\n", (long)length);
+    }
+    else{
+        strcpy(msg, (length == -1) ? "Error : Bank busy\n" : "Error : Bank not valid\n");
+    }
+    fsm_usart_set_out_data(p_fsm_jukebox -> p_fsm_usart, msg);
+}
+
+/**
+ * @brief Handler of the command `stream`: notes of the melody streamed that were read when they had to be played, and blocks read.
+ * @param p_context Pointer to the Jukebox FSM.
+ * @param p_line Pointer to the command line: no arguments.
+ */
+static void _command_stream(void *p_context, command_line_t *p_line){
+    fsm_jukebox_t *p_fsm_jukebox = (fsm_jukebox_t *)p_context;
+    char msg[USART_OUTPUT_BUFFER_LENGTH];
+    sprintf(msg, "Stream: %lu underruns, %lu reads\n", (unsigned long)p_fsm_jukebox -> stream.underruns, (unsigned long)p_fsm_jukebox -> stream.reads);
+    fsm_usart_set_out_data(p_fsm_jukebox -> p_fsm_usart, msg);
+}
+
+/**
+ * @brief Handler of the command `cache`: melodies streamed read from the cache, decoded from the device, and evicted.
+ * @param p_context Pointer to the Jukebox FSM.
+ * @param p_line Pointer to the command line: no arguments.
+ */
+static void _command_cache(void *p_context, command_line_t *p_line){
+    fsm_jukebox_t *p_fsm_jukebox = (fsm_jukebox_t *)p_context;
+    char msg[USART_OUTPUT_BUFFER_LENGTH];
+    sprintf(msg, "Cache: %lu hits, %lu misses, %lu evictions\n", (unsigned long)p_fsm_jukebox -> cache.hits, (unsigned long)p_fsm_jukebox -> cache.misses, (unsigned long)p_fsm_jukebox -> cache.evictions);
+    fsm_usart_set_out_data(p_fsm_jukebox -> p_fsm_usart, msg);
+}
+
+/**
+ * @brief Handler of the command `queue <index>` or `queue <name>`: add a melody to the end of the play queue.
+ * @param p_context Pointer to the Jukebox FSM.
+ * @param p_line Pointer to the command line.
+ */
+static void _command_queue(void *p_context, command_line_t *p_line){
+    fsm_jukebox_t *p_fsm_jukebox = (fsm_jukebox_t *)p_context;
+    char msg[USART_OUTPUT_BUFFER_LENGTH];
+    char name[USART_OUTPUT_BUFFER_LENGTH / 2];
+    int32_t index = _library_resolve(p_fsm_jukebox, p_line);
+    if (index < 0){
+        fsm_usart_set_out_data(p_fsm_jukebox -> p_fsm_usart, "Error : Melody not found\n");
+        return;
+    }
+    if (p_fsm_jukebox -> queue_count >= JUKEBOX_QUEUE_LENGTH){
+        fsm_usart_set_out_data(p_fsm_jukebox -> p_fsm_usart, "Error : Queue full\n");
+        return;
+    }
+    jukebox_queue_entry_t *p_entry = &(p_fsm_jukebox -> play_queue[(p_fsm_jukebox -> queue_head + p_fsm_jukebox -> queue_count) % JUKEBOX_QUEUE_LENGTH]);
+    p_entry -> index = (uint16_t)index;
+    p_entry -> name[0] = '\0';
+    //An uploaded melody is kept by its name: its index changes when the pool evicts or replaces a melody
+    if ((uint32_t)index >= _library_get_pool_offset(p_fsm_jukebox)){
+        _library_format_name(p_fsm_jukebox, (uint32_t)index, p_entry -> name, sizeof(p_entry -> name));
+    }
+    p_fsm_jukebox -> queue_count++;
+    //A melody queued at the head follows the melody playing
+    if (p_fsm_jukebox -> queue_count == 1){
+        _queue_stage_next(p_fsm_jukebox);
+    }
+    _library_format_name(p_fsm_jukebox, (uint32_t)index, name, sizeof(name));
+    sprintf(msg, "Queued: %s (%lu)\n", name, (unsigned long)p_fsm_jukebox -> queue_count);
+    fsm_usart_set_out_data(p_fsm_jukebox -> p_fsm_usart, msg);
+}
+
+/**
+ * @brief Handler of the command `dequeue`: remove the melody at the head of the play queue.
+ * @param p_context Pointer to the Jukebox FSM.
+ * @param p_line Pointer to the command line: no arguments.
+ */
+static void _command_dequeue(void *p_context, command_line_t *p_line){
+    fsm_jukebox_t *p_fsm_jukebox = (fsm_jukebox_t *)p_context;
+    char msg[USART_OUTPUT_BUFFER_LENGTH];
+    char name[USART_OUTPUT_BUFFER_LENGTH / 2];
+    if (p_fsm_jukebox -> queue_count == 0){
+        fsm_usart_set_out_data(p_fsm_jukebox -> p_fsm_usart, "Error : Queue empty\n");
+        return;
+    }
+    _queue_format_name(p_fsm_jukebox, _queue_pop(p_fsm_jukebox), name, sizeof(name));
+    _queue_stage_next(p_fsm_jukebox);
+    sprintf(msg, "Dequeued: %s\n", name);
+    fsm_usart_set_out_data(p_fsm_jukebox -> p_fsm_usart, msg);
+}
+
+/**
+ * @brief Handler of the command `clear`: empty the play queue. The melody playing goes on.
+ * @param p_context Pointer to the Jukebox FSM.
+ * @param p_line Pointer to the command line: no arguments.
+ */
+static void _command_clear(void *p_context, command_line_t *p_line){
+    fsm_jukebox_t *p_fsm_jukebox = (fsm_jukebox_t *)p_context;
+    p_fsm_jukebox -> queue_count = 0;
+    _queue_stage_next(p_fsm_jukebox);
+}
+
+/**
+ * @brief Handler of the command `list`: melodies of the play queue, from its head. The list is cut with "..." if it does
+ * not fit in a line.
+ * @param p_context Pointer to the Jukebox FSM.
+ * @param p_line Pointer to the command line: no arguments.
+ */
+static void _command_list(void *p_context, command_line_t *p_line){
+    fsm_jukebox_t *p_fsm_jukebox = (fsm_jukebox_t *)p_context;
+    char msg[USART_OUTPUT_BUFFER_LENGTH];
+    char name[USART_OUTPUT_BUFFER_LENGTH];
+    uint32_t length = (uint32_t)sprintf(msg, "Queue:%s", (p_fsm_jukebox -> queue_count == 0) ? " empty" : "");
+    for (uint32_t i = 0; i < p_fsm_jukebox -> queue_count; i++){
+        const jukebox_queue_entry_t *p_entry = &(p_fsm_jukebox -> play_queue[(p_fsm_jukebox -> queue_head + i) % JUKEBOX_QUEUE_LENGTH]);
+        const char *p_separator = (i > 0) ? ", " : " ";
+        _queue_format_name(p_fsm_jukebox, p_entry, name, sizeof(name));
+        //There must be room left for " ..." and the end of the line
+        if (length + strlen(p_separator) + strlen(name) + sizeof(" ...\n") > sizeof(msg)){
+            length += (uint32_t)sprintf(&msg[length], " ...");
+            break;
         }
-        
+        strcat(strcat(msg, p_separator), name);
+        length = (uint32_t)strlen(msg);
     }
-    
-}	
+    sprintf(&msg[length], "\n");
+    fsm_usart_set_out_data(p_fsm_jukebox -> p_fsm_usart, msg);
+}
 
+/**
+ * @brief Command built in the jukebox: its name, the schema of its arguments and its handler.
+ */
+typedef struct {
+    const char *p_name; /*!< Name of the command*/
+    uint8_t opcode; /*!< Opcode of the command in the binary frames*/
+    uint8_t min_args; /*!< Minimum number of arguments*/
+    uint8_t max_args; /*!< Maximum number of arguments*/
+    command_handler_t handler; /*!< Handler of the command*/
+} jukebox_command_t;
 
+/**
+ * @brief Commands built in the jukebox, registered in its command table when it is initialized.
+ */
+static const jukebox_command_t jukebox_commands[] = {
+    {"play", JUKEBOX_OPCODE_PLAY, 0, 0, _command_play},
+    {"stop", JUKEBOX_OPCODE_STOP, 0, 0, _command_stop},
+    {"pause", JUKEBOX_OPCODE_PAUSE, 0, 0, _command_pause},
+    {"speed", JUKEBOX_OPCODE_SPEED, 1, 2, _command_speed},
+    {"next", JUKEBOX_OPCODE_NEXT, 0, 0, _command_next},
+    {"select", JUKEBOX_OPCODE_SELECT, 1, COMMAND_TABLE_ANY_ARGS, _command_select},
+    {"info", JUKEBOX_OPCODE_INFO, 0, 0, _command_info},
+    {"drift", JUKEBOX_OPCODE_DRIFT, 0, 0, _command_drift},
+    {"seek", JUKEBOX_OPCODE_SEEK, 1, 1, _command_seek},
+    {"upload", JUKEBOX_OPCODE_UPLOAD, 1, 2, _command_upload},
+    {"bank", JUKEBOX_OPCODE_BANK, 0, 0, _command_bank},
+    {"stream", JUKEBOX_OPCODE_STREAM, 0, 0, _command_stream},
+    {"cache", JUKEBOX_OPCODE_CACHE, 0, 0, _command_cache},
+    {"queue", JUKEBOX_OPCODE_QUEUE, 1, COMMAND_TABLE_ANY_ARGS, _command_queue},
+    {"dequeue", JUKEBOX_OPCODE_DEQUEUE, 0, 0, _command_dequeue},
+    {"clear", JUKEBOX_OPCODE_CLEAR, 0, 0, _command_clear},
+    {"list", JUKEBOX_OPCODE_LIST, 0, 0, _command_list},
+};
 
+/**
+ * @brief Execute the command received by the USART, a text line or a binary frame: the handler of the command found in the command table of the jukebox.
+ * @param p_fsm_jukebox	Pointer to the Jukebox FSM.
+ * @param p_command Pointer to the command, found by its name or by its opcode. NULL if it was not found.
+ * @param p_line Pointer to the command line, tokenized.
+ */
+void _execute_command	(fsm_jukebox_t * p_fsm_jukebox, const command_t * p_command, command_line_t * p_line){
+    command_table_result_t result = command_table_call(p_command, p_line);
+    if (result == COMMAND_TABLE_NOT_FOUND){
+        fsm_usart_set_out_data(p_fsm_jukebox -> p_fsm_usart, "Error : Command not found\n");
+    }
+    else if (result == COMMAND_TABLE_WRONG_ARGS){
+        fsm_usart_set_out_data(p_fsm_jukebox -> p_fsm_usart, "Error : Wrong arguments\n");
+    }
+}
 
 /* State machine input or transition functions */
 /**
@@ -252,6 +811,22 @@ static bool check_melody_finished(fsm_t *p_this){
     }
 }
 
+/**
+ * @brief Check if the next melody of the queue has to be played: the buzzer has gone on with the melody staged, or it
+ * has stopped at the end of a melody and the queue is not empty.
+ * 
+ * @param p_this Pointer to an fsm_t struct that contains an fsm_jukebox_t.
+ * @return true 
+ * @return false 
+ */
+static bool check_queue_next(fsm_t *p_this){
+    fsm_jukebox_t *p_fsm = (fsm_jukebox_t *)(p_this);
+    if (fsm_buzzer_get_melody(p_fsm -> p_fsm_buzzer) == &(p_fsm -> next_melody)){
+        return true;
+    }
+    return (p_fsm -> queue_count > 0) && !(p_fsm -> stopped) && (fsm_buzzer_get_action(p_fsm -> p_fsm_buzzer) == STOP);
+}
+
 /**
  * @brief Check if the USART has received data.
  * 
@@ -313,7 +888,7 @@ static void do_start_up	(fsm_t *p_this){
     // (only for debugging purposes)
     printf("Jukebox ON \n");
     // Set the speed of the buzzer to 1.0 by calling fsm_buzzer_set_speed
-    fsm_buzzer_set_speed (p_fsm->p_fsm_buzzer, 1.0);
+    fsm_buzzer_set_speed_q8 (p_fsm->p_fsm_buzzer, FSM_BUZZER_SPEED_Q8_ONE);
     // Set the scale_melody to be played by calling fsm_buzzer_set_melody
     fsm_buzzer_set_melody (p_fsm->p_fsm_buzzer, &scale_melody);
     // Set the status of the buzzer to PLAY by calling fsm_buzzer_set_action 
@@ -331,7 +906,7 @@ static void do_start_jukebox	(fsm_t *p_this)	{
     //Set the index of the melody to be played (melody_idx) to 0. Set the index to any other melody you want to play first.
     p_fsm -> melody_idx = 0;
     //Set the name of the melody to be played (p_melody) to the name of the melody selected before.
-    p_fsm -> p_melody = p_fsm -> melodies[p_fsm -> melody_idx].p_name;
+    p_fsm -> p_melody = (char *)melody_bank_get_name(p_fsm -> p_bank, p_fsm -> melody_idx);
 }
 /* EXTRA */
 /**
@@ -364,6 +939,9 @@ static void do_stop_jukebox	(fsm_t *p_this)	{
     printf("Jukebox OFF \n");
     //Stop the buzzer by calling fsm_buzzer_set_action() with the right parameter.
     fsm_buzzer_set_action (p_fsm->p_fsm_buzzer, STOP);
+    //The queue is emptied
+    p_fsm -> queue_count = 0;
+    p_fsm -> stopped = false;
 }
 
 
@@ -381,28 +959,106 @@ static void do_load_next_song	(fsm_t *p_this)	{
 }
 
 /**
- * @brief Read the command received by the USART.
+ * @brief Play the next melody of the queue, with no command from the host. \n
+ * If the buzzer has gone on with the melody staged, it becomes the melody selected and the buzzer plays it from the view
+ * of the melody selected. Otherwise the melody at the head of the queue is started. Then the following one is staged.
+ * 
+ * @param p_this Pointer to an fsm_t struct that contains an fsm_jukebox_t.
+ */
+static void do_play_queued(fsm_t *p_this){
+    fsm_jukebox_t *p_fsm = (fsm_jukebox_t *)(p_this);
+    if (fsm_buzzer_get_melody(p_fsm -> p_fsm_buzzer) == &(p_fsm -> next_melody)){
+        if ((p_fsm -> queue_count > 0) && (_queue_get_index(p_fsm, &(p_fsm -> play_queue[p_fsm -> queue_head])) == p_fsm -> next_idx)){
+            _queue_pop(p_fsm);
+        }
+        p_fsm -> melody = p_fsm -> next_melody;
+        p_fsm -> melody_idx = p_fsm -> next_idx;
+        //Both views have the same notes: the melody goes on with no gap
+        fsm_buzzer_set_melody(p_fsm -> p_fsm_buzzer, &(p_fsm -> melody));
+    }
+    else{
+        int32_t index = _queue_get_index(p_fsm, _queue_pop(p_fsm));
+        //The library may have changed since the melody was queued: an uploaded melody may have been evicted
+        if ((index < 0) || !_library_get_melody(p_fsm, (uint32_t)index, &(p_fsm -> melody))){
+            return;
+        }
+        p_fsm -> melody_idx = (uint16_t)index;
+        fsm_buzzer_set_melody(p_fsm -> p_fsm_buzzer, &(p_fsm -> melody));
+        fsm_buzzer_set_action(p_fsm -> p_fsm_buzzer, PLAY);
+    }
+    printf("Playing: %s\n", p_fsm -> p_melody = p_fsm -> melody.p_name);
+    _queue_stage_next(p_fsm);
+}
+
+/**
+ * @brief Handle a command of a line received by the USART: a line of the melody while a melody is uploaded, otherwise
+ * a command of the command table.
+ * @param p_fsm_jukebox	Pointer to the Jukebox FSM.
+ * @param p_text Command, NUL-terminated. It is tokenized in place.
+ */
+static void _handle_command(fsm_jukebox_t *p_fsm_jukebox, char *p_text){
+    command_line_t line;
+    //While a melody is uploaded, the lines received are the melody
+    if (melody_upload_is_active(&(p_fsm_jukebox -> upload))){
+        _upload_line(p_fsm_jukebox, p_text);
+    }
+    else if (!command_line_tokenize(&line, p_text)){
+        fsm_usart_set_out_data(p_fsm_jukebox -> p_fsm_usart, "Error : Wrong arguments\n");
+    }
+    //A blank line is ignored: the USART driver of the computer sends one at initialization
+    else if (line.command.length > 0){
+        _execute_command(p_fsm_jukebox, command_table_find(&(p_fsm_jukebox -> commands), line.command.p_start, line.command.length), &line);
+    }
+}
+
+/**
+ * @brief Handle a binary frame received by the USART: the command of its opcode, with the arguments of its payload.
+ * A frame is always a command, even while a melody is uploaded.
+ * @param p_fsm_jukebox	Pointer to the Jukebox FSM.
+ * @param p_frame Frame, as queued by the USART. It is decoded in place.
+ */
+static void _handle_frame(fsm_jukebox_t *p_fsm_jukebox, char *p_frame){
+    command_line_t line;
+    uint8_t opcode;
+    if (!command_frame_decode(&line, p_frame, &opcode)){
+        fsm_usart_set_out_data(p_fsm_jukebox -> p_fsm_usart, "Error : Wrong arguments\n");
+    }
+    else {
+        _execute_command(p_fsm_jukebox, command_table_get(&(p_fsm_jukebox -> commands), opcode), &line);
+    }
+}
+
+/**
+ * @brief Read the commands received by the USART: all the lines queued, and all the commands of each line.
  * 
  * @param p_this Pointer to an fsm_t struct that contains an fsm_jukebox_t.
  */
 static void do_read_command	(fsm_t *p_this){
     fsm_jukebox_t *p_fsm = (fsm_jukebox_t *)(p_this);  
-    //Declare the following auxiliary variables, they will be used to parse the message received by the USART.
-    char p_message[USART_INPUT_BUFFER_LENGTH];
-    char p_command[USART_INPUT_BUFFER_LENGTH];
-    char p_param[USART_INPUT_BUFFER_LENGTH];
-    //Call function fsm_usart_get_in_data() to get the message received by the USART in the variable p_message.
-    fsm_usart_get_in_data(p_fsm -> p_fsm_usart, p_message);
-    //Call function _parse_message() to parse the message received by the USART and retrieve the result. 
-    bool is_valid_message = _parse_message(p_message, p_command, p_param);
-    //If the message is valid, call function _execute_command() to execute the command received by the USART.
-    if(is_valid_message){
-        _execute_command(p_fsm, p_command, p_param);   
-    }
-    //Reset the message received by the USART by calling fsm_usart_reset_input_data()
-    fsm_usart_reset_input_data(p_fsm -> p_fsm_usart);
-    //Reset the p_message variable to 0 (or any other value) to avoid reading the same message again.
-    memset(p_message, 0, sizeof(p_message));
+    //Drain the lines received: resetting the input data of the USART reads the next line queued
+    while (fsm_usart_check_data_received(p_fsm -> p_fsm_usart)){
+        //The message received by the USART is read in place: the tokens of the command point into the buffer of the USART.
+        char *p_message = fsm_usart_get_in_buffer(p_fsm -> p_fsm_usart);
+        char *p_command;
+        //A binary frame holds one command. A text line may hold a batch
+        if (command_frame_is_frame(p_message)){
+            _handle_frame(p_fsm, p_message);
+        }
+        else {
+            while ((p_command = command_line_next(&p_message)) != NULL){
+                _handle_command(p_fsm, p_command);
+            }
+        }
+        fsm_usart_reset_input_data(p_fsm -> p_fsm_usart);
+    }
+    //Report the lines lost because they were received while the queue of the USART was full
+    uint32_t dropped_lines = fsm_usart_get_dropped_lines(p_fsm -> p_fsm_usart);
+    if (dropped_lines != p_fsm -> dropped_lines){
+        char msg[USART_OUTPUT_BUFFER_LENGTH];
+        sprintf(msg, "Error : %lu lines dropped\n", (unsigned long)dropped_lines);
+        fsm_usart_set_out_data(p_fsm -> p_fsm_usart, msg);
+        p_fsm -> dropped_lines = dropped_lines;
+    }
 }	
 
 /**
@@ -456,9 +1112,11 @@ static fsm_trans_t fsm_trans_jukebox[] = {
     {SLEEP_WHILE_OFF, check_activity, OFF, NULL},
     {SLEEP_WHILE_OFF, check_no_activity, SLEEP_WHILE_OFF, do_sleep_while_off},
     {START_UP, check_melody_finished, WAIT_COMMAND, do_start_jukebox},
+    {WAIT_COMMAND, check_queue_next, WAIT_COMMAND, do_play_queued},
     {WAIT_COMMAND, check_next_song_button, WAIT_COMMAND, do_load_next_song},
     {WAIT_COMMAND, check_command_received, WAIT_COMMAND, do_read_command},
     {WAIT_COMMAND, check_no_activity, SLEEP_WHILE_ON, do_sleep_wait_command},
+    {SLEEP_WHILE_ON, check_queue_next, WAIT_COMMAND, do_play_queued},
     {SLEEP_WHILE_ON, check_no_activity, SLEEP_WHILE_ON, do_sleep_while_on},
     {SLEEP_WHILE_ON, check_activity, WAIT_COMMAND, NULL},
     // Modified {WAIT_COMMAND, check_off, OFF, do_stop_jukebox},
@@ -486,18 +1144,42 @@ void fsm_jukebox_init	(fsm_t *p_this,fsm_t *p_fsm_button, uint32_t on_off_press_
     // Initialize the melody index to 0
     p_fsm -> melody_idx = 0;
     
-    // Reset the array of melodies to 0. 
-    //memset(*dest, value, size)
-    memset(p_fsm -> melodies, 0, sizeof(p_fsm -> melodies));
+    // Reference the melody bank in place: the RAM used does not depend on the number of melodies
+    uint32_t bank_size;
+    const void *p_bank_data = port_melody_bank_get(&bank_size);
+    p_fsm -> p_bank = melody_bank_open(p_bank_data, bank_size);
+    // The slots of the double buffer are empty until a new bank is swapped in
+    memset(p_fsm -> bank_slots, 0, sizeof(p_fsm -> bank_slots));
+    memset(&(p_fsm -> melody), 0, sizeof(p_fsm -> melody));
+
+    // The library of the storage device is read as it is played: only the melody selected is resident, and only in part
+    melody_stream_init(&(p_fsm -> stream), port_storage_read, port_storage_init());
+    // The melodies streamed and the packed melodies of the bank played lately are kept decoded in RAM. The melody
+    // selected is never evicted
+    melody_cache_init(&(p_fsm -> cache), &(p_fsm -> melody));
+    p_fsm -> bank_generation = 1;
+
+    // The pool keeps the view of the melody selected valid while other melodies are uploaded
+    melody_pool_init(&(p_fsm -> pool), &(p_fsm -> melody));
+    melody_pool_set_hold(&(p_fsm -> pool), _pool_hold, p_fsm_buzzer);
+    melody_upload_init(&(p_fsm -> upload), &(p_fsm -> pool));
 
-    // Load the melodies defined in melodies.c to the array of melodies
-    p_fsm -> melodies[0] = happy_birthday_melody;
-    p_fsm -> melodies[1] = tetris_melody;    
-    p_fsm -> melodies[2] = scale_melody;
-    p_fsm -> melodies[3] = spanish_anthem;
-    p_fsm -> melodies[4] = feliz_navidad_melody;
+    // The lines dropped by the USART are reported as they are dropped
+    p_fsm -> dropped_lines = 0;
 
+    // The play queue is empty: the melodies are played when they are selected
+    p_fsm -> queue_head = 0;
+    p_fsm -> queue_count = 0;
+    p_fsm -> next_idx = 0;
+    p_fsm -> stopped = false;
+    memset(&(p_fsm -> next_melody), 0, sizeof(p_fsm -> next_melody));
 
+    // The commands built in the jukebox. Other modules add theirs with fsm_jukebox_register_command()
+    command_table_init(&(p_fsm -> commands));
+    for (uint32_t i = 0; i < sizeof(jukebox_commands) / sizeof(jukebox_commands[0]); i++){
+        const jukebox_command_t *p_command = &jukebox_commands[i];
+        command_table_register(&(p_fsm -> commands), p_command -> p_name, p_command -> opcode, p_command -> min_args, p_command -> max_args, p_command -> handler, p_fsm);
+    }
 }
 
 fsm_t *fsm_jukebox_new(fsm_t *p_fsm_button, uint32_t on_off_press_time_ms, fsm_t *p_fsm_usart, fsm_t *p_fsm_buzzer, uint32_t next_song_press_time_ms)
@@ -509,5 +1191,54 @@ fsm_t *fsm_jukebox_new(fsm_t *p_fsm_button, uint32_t on_off_press_time_ms, fsm_t
     return p_fsm;
 }
 
+int32_t fsm_jukebox_get_free_bank_slot(fsm_t *p_this)
+{
+    fsm_jukebox_t *p_fsm = (fsm_jukebox_t *)(p_this);
+    _bank_release(p_fsm);
+    const melody_bank_t *p_bank = p_fsm -> p_bank;
+    for (uint32_t slot = 0; slot < PORT_MELODY_BANK_NUM_SLOTS; slot++){
+        const melody_bank_t *p_slot_bank = p_fsm -> bank_slots[slot];
+        if ((p_slot_bank == NULL) || ((p_slot_bank != p_bank) && !_bank_contains(p_slot_bank, _melody_get_data(p_fsm)) && !_bank_contains(p_slot_bank, p_fsm -> p_melody))){
+            return (int32_t)slot;
+        }
+    }
+    return -1;
+}
 
+int32_t fsm_jukebox_swap_bank(fsm_t *p_this)
+{
+    fsm_jukebox_t *p_fsm = (fsm_jukebox_t *)(p_this);
+    int32_t slot = fsm_jukebox_get_free_bank_slot(p_this);
+    if (slot < 0){
+        return -1;
+    }
+    uint32_t size;
+    const void *p_data = port_melody_bank_get_slot((uint32_t)slot, &size);
+    const melody_bank_t *p_new_bank = melody_bank_open(p_data, size);
+    p_fsm -> bank_slots[slot] = p_new_bank;
+    if (p_new_bank == NULL){
+        return -2;
+    }
+    // Keep the melody selected, the melody staged and the melodies queued: a melody of the bank by its name, a melody
+    // streamed or uploaded after the melodies of the new bank
+    int32_t index = _bank_remap_index(p_fsm -> p_bank, p_new_bank, p_fsm -> melody_idx);
+    p_fsm -> melody_idx = (index >= 0) ? (uint16_t)index : 0;
+    index = _bank_remap_index(p_fsm -> p_bank, p_new_bank, p_fsm -> next_idx);
+    p_fsm -> next_idx = (index >= 0) ? (uint16_t)index : 0;
+    _queue_remap(p_fsm, p_new_bank);
+    // Publish the new bank with a single store: the lookups switch to it at once, with no copy of the library. The
+    // melodies of the old bank decoded into the cache are dropped, and the one playing is not found any more
+    p_fsm -> p_bank = p_new_bank;
+    p_fsm -> bank_generation = (p_fsm -> bank_generation == UINT16_MAX) ? 1U : (uint16_t)(p_fsm -> bank_generation + 1U);
+    melody_cache_clear(&(p_fsm -> cache));
+    _bank_release(p_fsm);
+    // The melody staged is read again from the new bank
+    _queue_stage_next(p_fsm);
+    return (int32_t)melody_bank_get_length(p_new_bank);
+}
 
+bool fsm_jukebox_register_command(fsm_t *p_this, const char *p_name, uint8_t opcode, uint8_t min_args, uint8_t max_args, command_handler_t handler, void *p_context)
+{
+    fsm_jukebox_t *p_fsm = (fsm_jukebox_t *)(p_this);
+    return command_table_register(&(p_fsm -> commands), p_name, opcode, min_args, max_args, handler, p_context);
+}
@@ -26,7 +26,8 @@
 static bool check_data_rx(fsm_t * p_this)
 {
     fsm_usart_t *p_fsm = (fsm_usart_t *)(p_this);
-    return port_usart_rx_done(p_fsm -> usart_id);
+    // The line in in_data is not overwritten until it is read: the next lines wait in the queue of the PORT layer
+    return !p_fsm -> data_received && port_usart_rx_done(p_fsm -> usart_id);
 }
 
 /**
@@ -78,6 +79,19 @@ static void do_get_data_rx(	fsm_t * p_this)
     p_fsm -> data_received = true;
 }
 
+/**
+ * @brief Get the next line received, if any, once the previous one has been read.
+ * 
+* @param p_this Pointer to an **fsm_t** struct that contains a **fsm_usart_t** struct
+ */
+static void _get_next_line(fsm_t * p_this)
+{
+    if (check_data_rx(p_this))
+    {
+        do_get_data_rx(p_this);
+    }
+}
+
 /**
  * @brief Set the data to be sent. \n 
  * This function sets the data to be sent by the USART to the internal buffer of the PORT layer.
@@ -110,8 +124,11 @@ static void do_tx_end( fsm_t * p_this)
     fsm_usart_t *p_fsm = (fsm_usart_t *)(p_this);
     //Reset the output data in the PORT layer
     port_usart_reset_output_buffer(p_fsm -> usart_id);
-    //Reset the array out_data
-    memset(p_fsm->out_data, EMPTY_BUFFER_CONSTANT, USART_OUTPUT_BUFFER_LENGTH);
+    //Remove the line sent from the array out_data. The lines queued after it are sent next
+    char *p_end = memchr(p_fsm->out_data, END_CHAR_CONSTANT, USART_OUTPUT_BUFFER_LENGTH);
+    uint32_t sent = (p_end != NULL) ? (uint32_t)(p_end - p_fsm->out_data) + 1U : USART_OUTPUT_BUFFER_LENGTH;
+    memmove(p_fsm->out_data, &p_fsm->out_data[sent], USART_OUTPUT_BUFFER_LENGTH - sent);
+    memset(&p_fsm->out_data[USART_OUTPUT_BUFFER_LENGTH - sent], EMPTY_BUFFER_CONSTANT, sent);
 }
 
 /**
@@ -136,12 +153,26 @@ void fsm_usart_get_in_data(fsm_t *p_this, char *p_data)
     memcpy(p_data, p_fsm->in_data, USART_INPUT_BUFFER_LENGTH);
 }
 
+char *fsm_usart_get_in_buffer(fsm_t *p_this)
+{
+    fsm_usart_t *p_fsm = (fsm_usart_t *)(p_this);
+    return p_fsm->in_data;
+}
+
 void fsm_usart_set_out_data(fsm_t *p_this, char *p_data)
 {
     fsm_usart_t *p_fsm = (fsm_usart_t *)(p_this);
-    // Ensure to reset the output data before setting a new one
-    memset(p_fsm->out_data, EMPTY_BUFFER_CONSTANT, USART_OUTPUT_BUFFER_LENGTH);
-    memcpy(p_fsm->out_data, p_data, USART_OUTPUT_BUFFER_LENGTH);
+    // Queue the data after the lines not sent yet, if it fits. The last character of out_data is always empty
+    size_t queued = strnlen(p_fsm->out_data, USART_OUTPUT_BUFFER_LENGTH);
+    size_t length = strnlen(p_data, USART_OUTPUT_BUFFER_LENGTH);
+    if (queued + length < USART_OUTPUT_BUFFER_LENGTH)
+    {
+        memcpy(&p_fsm->out_data[queued], p_data, length);
+    }
+    else
+    {
+        p_fsm -> dropped_replies++;
+    }
 }
 
 
@@ -158,7 +189,8 @@ void fsm_usart_init(fsm_t *p_this, uint32_t usart_id)
     fsm_init(p_this, fsm_trans_usart);
     p_fsm -> usart_id = usart_id;
     p_fsm -> data_received = false;
-    memset(p_fsm -> in_data, EMPTY_BUFFER_CONSTANT, 10);
+    p_fsm -> dropped_replies = 0;
+    memset(p_fsm -> in_data, EMPTY_BUFFER_CONSTANT, sizeof(p_fsm -> in_data));
     memset(p_fsm -> out_data, EMPTY_BUFFER_CONSTANT, 100);
     port_usart_init(p_fsm -> usart_id);
 }
@@ -175,6 +207,14 @@ void fsm_usart_reset_input_data( fsm_t * p_this){
     memset(p_fsm-> in_data, EMPTY_BUFFER_CONSTANT, USART_INPUT_BUFFER_LENGTH);
     //Reset the field data_received
     p_fsm -> data_received = false;
+    //The next line queued, if any, is ready to be read at once
+    _get_next_line(p_this);
+}
+
+
+uint32_t fsm_usart_get_dropped_lines( fsm_t * p_this){
+    fsm_usart_t *p_fsm = (fsm_usart_t *)(p_this);
+    return port_usart_get_dropped_lines(p_fsm -> usart_id);
 }
 
 
@@ -205,7 +245,7 @@ bool fsm_usart_check_activity(fsm_t *p_this){
     // Get current_state of the FSM and get data_received
     int current_state = (p_fsm -> f.current_state);
     // Return true if the current state is SEND_DATA or data_received is true
-    if((current_state == SEND_DATA) || ((p_fsm -> data_received) == true)){
+    if((current_state == SEND_DATA) || ((p_fsm -> data_received) == true) || port_usart_rx_done(p_fsm -> usart_id)){
         return true;
     } else {
         return false;
@@ -6,29 +6,39 @@
  */
 
 /* Includes ------------------------------------------------------------------*/
+#include <stddef.h>
+#include <string.h>
 #include "melodies.h"
+#include "note_table.h"
+#include "melody_stream.h"
+#include "melody_codec.h"
+#include "port_buzzer.h"
 
 /* Melodies ------------------------------------------------------------------*/
 // Melody Happy Birthday
 #define HAPPY_BIRTHDAY_LENGTH 25 /*!< Happy Birthday melody length */
+#define HAPPY_BIRTHDAY_TICK_MS 100 /*!< Happy Birthday melody duration of a tick in ms */
 
 /**
  * @brief Happy Birthday melody notes.
  *
- * This array contains the frequencies of the notes for the Happy Birthday song.
- * The notes are defined as frequency values in Hertz, and they are arranged in the order they are played in the song.
+ * This array contains the notes for the Happy Birthday song.
+ * The notes are MIDI note numbers into the note table, and they are arranged in the order they are played in the song.
  */
-static const double happy_birthday_notes[HAPPY_BIRTHDAY_LENGTH] = {
-    DO4, DO4, RE4, DO4, FA4, MI4, DO4, DO4, RE4, DO4, SOL4, FA4, DO4, DO4, DO5, LA4, FA4, MI4, RE4, LAs4, LAs4, LA4, FA4, SOL4, FA4};
+static const uint8_t happy_birthday_notes[HAPPY_BIRTHDAY_LENGTH] = {
+    MIDI_NOTE(DO, 4), MIDI_NOTE(DO, 4), MIDI_NOTE(RE, 4), MIDI_NOTE(DO, 4), MIDI_NOTE(FA, 4), MIDI_NOTE(MI, 4), MIDI_NOTE(DO, 4), MIDI_NOTE(DO, 4),
+    MIDI_NOTE(RE, 4), MIDI_NOTE(DO, 4), MIDI_NOTE(SOL, 4), MIDI_NOTE(FA, 4), MIDI_NOTE(DO, 4), MIDI_NOTE(DO, 4), MIDI_NOTE(DO, 5), MIDI_NOTE(LA, 4),
+    MIDI_NOTE(FA, 4), MIDI_NOTE(MI, 4), MIDI_NOTE(RE, 4), MIDI_NOTE(LAs, 4), MIDI_NOTE(LAs, 4), MIDI_NOTE(LA, 4), MIDI_NOTE(FA, 4), MIDI_NOTE(SOL, 4),
+    MIDI_NOTE(FA, 4)};
 
 /**
- * @brief Happy Birthday melody durations in miliseconds.
+ * @brief Happy Birthday melody durations in ticks of HAPPY_BIRTHDAY_TICK_MS.
  *
  * This array contains the duration of each note in the Happy Birthday song.
- * The durations are defined in milliseconds, and they are arranged in the order they are played in the song.
+ * The durations are defined in ticks, and they are arranged in the order they are played in the song.
  */
-static const uint16_t happy_birthday_durations[HAPPY_BIRTHDAY_LENGTH] = {
-    300, 100, 400, 400, 400, 800, 300, 100, 400, 400, 400, 800, 300, 100, 400, 400, 400, 400, 400, 300, 100, 400, 400, 400, 800};
+static const uint8_t happy_birthday_ticks[HAPPY_BIRTHDAY_LENGTH] = {
+    3, 1, 4, 4, 4, 8, 3, 1, 4, 4, 4, 8, 3, 1, 4, 4, 4, 4, 4, 3, 1, 4, 4, 4, 8};
 
 /**
  * @brief Happy Birthday melody struct.
@@ -37,33 +47,37 @@ static const uint16_t happy_birthday_durations[HAPPY_BIRTHDAY_LENGTH] = {
  * It is used to play the melody using the buzzer.
  */
 const melody_t happy_birthday_melody = {.p_name = "happy_birthday",
-                                        .p_notes = (double *)happy_birthday_notes,
-                                        .p_durations = (uint16_t *)happy_birthday_durations,
+                                        .p_midi_notes = happy_birthday_notes,
+                                        .p_ticks = happy_birthday_ticks,
+                                        .tick_ms = HAPPY_BIRTHDAY_TICK_MS,
                                         .melody_length = HAPPY_BIRTHDAY_LENGTH};
 
 // Tetris melody
 #define TETRIS_LENGTH 40 /*!< Tetris melody length */
+#define TETRIS_TICK_MS 200 /*!< Tetris melody duration of a tick in ms */
 
 /**
  * @brief Tetris melody notes.
  *
- * This array contains the frequencies of the notes for the Tetris song.
- * The notes are defined as frequency values in Hertz, and they are arranged in the order they are played in the song.
+ * This array contains the notes for the Tetris song.
+ * The notes are MIDI note numbers into the note table, and they are arranged in the order they are played in the song.
  */
-static const double tetris_notes[TETRIS_LENGTH] = {
-    MI5, SI4, DO5, RE5, DO5, SI4, LA4, LA4, DO5, MI5, RE5, DO5, SI4, DO5, RE5, MI5, DO5, LA4,
-    LA4, LA4, SI4, DO5, RE5, FA4, LA5, SOL5, FA5, MI5, DO5, MI5, RE5, DO5, SI4, SI4, LA4, RE5,
-    MI5, DO5, LA4, LA4};
+static const uint8_t tetris_notes[TETRIS_LENGTH] = {
+    MIDI_NOTE(MI, 5), MIDI_NOTE(SI, 4), MIDI_NOTE(DO, 5), MIDI_NOTE(RE, 5), MIDI_NOTE(DO, 5), MIDI_NOTE(SI, 4), MIDI_NOTE(LA, 4), MIDI_NOTE(LA, 4),
+    MIDI_NOTE(DO, 5), MIDI_NOTE(MI, 5), MIDI_NOTE(RE, 5), MIDI_NOTE(DO, 5), MIDI_NOTE(SI, 4), MIDI_NOTE(DO, 5), MIDI_NOTE(RE, 5), MIDI_NOTE(MI, 5),
+    MIDI_NOTE(DO, 5), MIDI_NOTE(LA, 4), MIDI_NOTE(LA, 4), MIDI_NOTE(LA, 4), MIDI_NOTE(SI, 4), MIDI_NOTE(DO, 5), MIDI_NOTE(RE, 5), MIDI_NOTE(FA, 4),
+    MIDI_NOTE(LA, 5), MIDI_NOTE(SOL, 5), MIDI_NOTE(FA, 5), MIDI_NOTE(MI, 5), MIDI_NOTE(DO, 5), MIDI_NOTE(MI, 5), MIDI_NOTE(RE, 5), MIDI_NOTE(DO, 5),
+    MIDI_NOTE(SI, 4), MIDI_NOTE(SI, 4), MIDI_NOTE(LA, 4), MIDI_NOTE(RE, 5), MIDI_NOTE(MI, 5), MIDI_NOTE(DO, 5), MIDI_NOTE(LA, 4), MIDI_NOTE(LA, 4)};
 
 /** 
- * @brief Tetris melody durations in miliseconds.
+ * @brief Tetris melody durations in ticks of TETRIS_TICK_MS.
  *
  * This array contains the duration of each note in the Tetris song.
- * The durations are defined in milliseconds, and they are arranged in the order they are played in the song.
+ * The durations are defined in ticks, and they are arranged in the order they are played in the song.
  */
-static const uint16_t tetris_durations[TETRIS_LENGTH] = {
-    400, 200, 200, 400, 200, 200, 400, 200, 200, 400, 200, 200, 600, 200, 400, 400, 400, 400, 200, 200, 200, 200,
-    600, 200, 400, 200, 200, 600, 200, 400, 200, 200, 400, 200, 200, 400, 400, 400, 400, 400};
+static const uint8_t tetris_ticks[TETRIS_LENGTH] = {
+    2, 1, 1, 2, 1, 1, 2, 1, 1, 2, 1, 1, 3, 1, 2, 2, 2, 2, 1, 1, 1, 1,
+    3, 1, 2, 1, 1, 3, 1, 2, 1, 1, 2, 1, 1, 2, 2, 2, 2, 2};
 
 /**
  * @brief Tetris melody struct.
@@ -72,8 +86,9 @@ static const uint16_t tetris_durations[TETRIS_LENGTH] = {
  * It is used to play the melody using the buzzer.
  */
 const melody_t tetris_melody = {.p_name = "tetris",
-                                .p_notes = (double *)tetris_notes,
-                                .p_durations = (uint16_t *)tetris_durations,
+                                .p_midi_notes = tetris_notes,
+                                .p_ticks = tetris_ticks,
+                                .tick_ms = TETRIS_TICK_MS,
                                 .melody_length = TETRIS_LENGTH};
 
 // Scale Melody
@@ -104,46 +119,51 @@ static const uint16_t scale_melody_durations[SCALE_MELODY_LENGTH] = {
  * It is used to play the melody using the buzzer.
  */
 const melody_t scale_melody = {.p_name = "scale",
-                               .p_notes = (double *)scale_melody_notes,
-                               .p_durations = (uint16_t *)scale_melody_durations,
+                               .p_notes = scale_melody_notes,
+                               .p_durations = scale_melody_durations,
                                .melody_length = SCALE_MELODY_LENGTH};
 
 
 // Spanish Anthem
-#define SPANISH_ANTHEM_LENGTH 101  /*!< Scale melody length */
+#define SPANISH_ANTHEM_LENGTH 101  /*!< Spanish anthem melody length */
+#define SPANISH_ANTHEM_TICK_MS 500 /*!< Spanish anthem melody duration of a tick in ms */
 /**
  * @brief Spanish anthem notes.
  *
- * This array contains the frequencies of the notes for the Spanish anthem.
- * The notes are defined as frequency values in Hertz, and they are arranged in the order they are played in the song.
+ * This array contains the notes for the Spanish anthem.
+ * The notes are MIDI note numbers into the note table, and they are arranged in the order they are played in the song.
  */
 
 
-static const double spanish_anthem_notes[SPANISH_ANTHEM_LENGTH] = {
-    MI6, SOL6, MI6, DO6, SOL6, FA6, MI6, RE6, DO6, DO6, SI6, LA6, SOL6,
-    DO6, RE6, MI6, SOL6, FA6, MI6, RE6, DO6, RE6, SOL6, LA6, SI6, DO7,
-    SOL6, MI6, DO6, SOL6, FA6, MI6, RE6, DO6, DO6, SI6, LA6, SOL6,
-    DO6, RE6, MI6, SOL6, FA6, MI6, RE6, DO6, RE6, SOL6, LA6, SI6, DO7,
-    SOL6, MI6, DO6, SOL6, FA6, MI6, RE6, DO6, DO6, SI6, LA6, SOL6,
-    DO6, RE6, MI6, SOL6, FA6, MI6, RE6, DO6, RE6, SOL6, LA6, SI6, DO7,
-    SOL6, MI6, DO6, SOL6, FA6, MI6, RE6, DO6, DO6, SI6, LA6, SOL6,
-    DO6, RE6, MI6, SOL6, FA6, MI6, RE6, DO6, RE6, SOL6, LA6, SI6, DO7
-};
+static const uint8_t spanish_anthem_notes[SPANISH_ANTHEM_LENGTH] = {
+    MIDI_NOTE(MI, 6), MIDI_NOTE(SOL, 6), MIDI_NOTE(MI, 6), MIDI_NOTE(DO, 6), MIDI_NOTE(SOL, 6), MIDI_NOTE(FA, 6), MIDI_NOTE(MI, 6), MIDI_NOTE(RE, 6),
+    MIDI_NOTE(DO, 6), MIDI_NOTE(DO, 6), MIDI_NOTE(SI, 6), MIDI_NOTE(LA, 6), MIDI_NOTE(SOL, 6), MIDI_NOTE(DO, 6), MIDI_NOTE(RE, 6), MIDI_NOTE(MI, 6),
+    MIDI_NOTE(SOL, 6), MIDI_NOTE(FA, 6), MIDI_NOTE(MI, 6), MIDI_NOTE(RE, 6), MIDI_NOTE(DO, 6), MIDI_NOTE(RE, 6), MIDI_NOTE(SOL, 6), MIDI_NOTE(LA, 6),
+    MIDI_NOTE(SI, 6), MIDI_NOTE(DO, 7), MIDI_NOTE(SOL, 6), MIDI_NOTE(MI, 6), MIDI_NOTE(DO, 6), MIDI_NOTE(SOL, 6), MIDI_NOTE(FA, 6), MIDI_NOTE(MI, 6),
+    MIDI_NOTE(RE, 6), MIDI_NOTE(DO, 6), MIDI_NOTE(DO, 6), MIDI_NOTE(SI, 6), MIDI_NOTE(LA, 6), MIDI_NOTE(SOL, 6), MIDI_NOTE(DO, 6), MIDI_NOTE(RE, 6),
+    MIDI_NOTE(MI, 6), MIDI_NOTE(SOL, 6), MIDI_NOTE(FA, 6), MIDI_NOTE(MI, 6), MIDI_NOTE(RE, 6), MIDI_NOTE(DO, 6), MIDI_NOTE(RE, 6), MIDI_NOTE(SOL, 6),
+    MIDI_NOTE(LA, 6), MIDI_NOTE(SI, 6), MIDI_NOTE(DO, 7), MIDI_NOTE(SOL, 6), MIDI_NOTE(MI, 6), MIDI_NOTE(DO, 6), MIDI_NOTE(SOL, 6), MIDI_NOTE(FA, 6),
+    MIDI_NOTE(MI, 6), MIDI_NOTE(RE, 6), MIDI_NOTE(DO, 6), MIDI_NOTE(DO, 6), MIDI_NOTE(SI, 6), MIDI_NOTE(LA, 6), MIDI_NOTE(SOL, 6), MIDI_NOTE(DO, 6),
+    MIDI_NOTE(RE, 6), MIDI_NOTE(MI, 6), MIDI_NOTE(SOL, 6), MIDI_NOTE(FA, 6), MIDI_NOTE(MI, 6), MIDI_NOTE(RE, 6), MIDI_NOTE(DO, 6), MIDI_NOTE(RE, 6),
+    MIDI_NOTE(SOL, 6), MIDI_NOTE(LA, 6), MIDI_NOTE(SI, 6), MIDI_NOTE(DO, 7), MIDI_NOTE(SOL, 6), MIDI_NOTE(MI, 6), MIDI_NOTE(DO, 6), MIDI_NOTE(SOL, 6),
+    MIDI_NOTE(FA, 6), MIDI_NOTE(MI, 6), MIDI_NOTE(RE, 6), MIDI_NOTE(DO, 6), MIDI_NOTE(DO, 6), MIDI_NOTE(SI, 6), MIDI_NOTE(LA, 6), MIDI_NOTE(SOL, 6),
+    MIDI_NOTE(DO, 6), MIDI_NOTE(RE, 6), MIDI_NOTE(MI, 6), MIDI_NOTE(SOL, 6), MIDI_NOTE(FA, 6), MIDI_NOTE(MI, 6), MIDI_NOTE(RE, 6), MIDI_NOTE(DO, 6),
+    MIDI_NOTE(RE, 6), MIDI_NOTE(SOL, 6), MIDI_NOTE(LA, 6), MIDI_NOTE(SI, 6), MIDI_NOTE(DO, 7)};
 /**
- * @brief Spanish anthem durations in miliseconds.
+ * @brief Spanish anthem durations in ticks of SPANISH_ANTHEM_TICK_MS.
  * 
  * This array contains the duration of each note in the spanish anthem song.
- * The durations are defined in milliseconds, and they are arranged in the order they are played in the song.
+ * The durations are defined in ticks, and they are arranged in the order they are played in the song.
  */
-static const uint16_t spanish_anthem_durations[SPANISH_ANTHEM_LENGTH] = {
-    500, 500, 500, 500, 500, 500, 500, 500, 500, 500, 500, 500, 500,
-    500, 500, 500, 500, 500, 500, 500, 500, 500, 500, 500, 500, 500,
-    500, 500, 500, 500, 500, 500, 500, 500, 500, 500, 500, 500, 500,
-    500, 500, 500, 500, 500, 500, 500, 500, 500, 500, 500, 500, 500,
-    500, 500, 500, 500, 500, 500, 500, 500, 500, 500, 500, 500, 500,
-    500, 500, 500, 500, 500, 500, 500, 500, 500, 500, 500, 500, 500,
-    500, 500, 500, 500, 500, 500, 500, 500, 500, 500, 500, 500, 500,
-    500, 500, 500, 500, 500, 500, 500, 500, 500, 500
+static const uint8_t spanish_anthem_ticks[SPANISH_ANTHEM_LENGTH] = {
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1
 };
 
 /**
@@ -153,30 +173,34 @@ static const uint16_t spanish_anthem_durations[SPANISH_ANTHEM_LENGTH] = {
  * It is used to play the melody using the buzzer.
  */
 const melody_t spanish_anthem = {.p_name = "Spanish anthem",
-                               .p_notes = (double *)spanish_anthem_notes,
-                               .p_durations = (uint16_t *)spanish_anthem_durations,
-                               .melody_length = SPANISH_ANTHEM_LENGTH};
+                                 .p_midi_notes = spanish_anthem_notes,
+                                 .p_ticks = spanish_anthem_ticks,
+                                 .tick_ms = SPANISH_ANTHEM_TICK_MS,
+                                 .melody_length = SPANISH_ANTHEM_LENGTH};
 
  // Feliz Navidad Melody
 #define FELIZ_NAVIDAD_MELODY_LENGTH 20   /*!< Feliz Navidad melody length */
+#define FELIZ_NAVIDAD_MELODY_TICK_MS 250 /*!< Feliz Navidad melody duration of a tick in ms */
 
 /**
  * @brief Feliz Navidad melody notes.
  *
- * This array contains the frequencies of the notes for the Feliz Navidad song.
- * The notes are defined as frequency values in Hertz, and they are arranged in the order they are played in the song.
+ * This array contains the notes for the Feliz Navidad song.
+ * The notes are MIDI note numbers into the note table, and they are arranged in the order they are played in the song.
  */
-static const double feliz_navidad_melody_notes[FELIZ_NAVIDAD_MELODY_LENGTH] = {
-    MI5, MI5, SOL5, DO6, SI5, LA5, SOL5, FA5, MI5, RE5, DO5, RE5, SOL4, SOL4, LA4, LA4, DO5, SOL4, MI5, MI5};
+static const uint8_t feliz_navidad_melody_notes[FELIZ_NAVIDAD_MELODY_LENGTH] = {
+    MIDI_NOTE(MI, 5), MIDI_NOTE(MI, 5), MIDI_NOTE(SOL, 5), MIDI_NOTE(DO, 6), MIDI_NOTE(SI, 5), MIDI_NOTE(LA, 5), MIDI_NOTE(SOL, 5), MIDI_NOTE(FA, 5),
+    MIDI_NOTE(MI, 5), MIDI_NOTE(RE, 5), MIDI_NOTE(DO, 5), MIDI_NOTE(RE, 5), MIDI_NOTE(SOL, 4), MIDI_NOTE(SOL, 4), MIDI_NOTE(LA, 4), MIDI_NOTE(LA, 4),
+    MIDI_NOTE(DO, 5), MIDI_NOTE(SOL, 4), MIDI_NOTE(MI, 5), MIDI_NOTE(MI, 5)};
 
 /**
- * @brief Feliz Navidad melody durations in milliseconds.
+ * @brief Feliz Navidad melody durations in ticks of FELIZ_NAVIDAD_MELODY_TICK_MS.
  * 
  * This array contains the duration of each note in the Feliz Navidad song.
- * The durations are defined in milliseconds, and they are arranged in the order they are played in the song.
+ * The durations are defined in ticks, and they are arranged in the order they are played in the song.
  */
-static const uint16_t feliz_navidad_melody_durations[FELIZ_NAVIDAD_MELODY_LENGTH] = {
-    250, 250, 500, 500, 500, 1000, 500, 500, 500, 1000, 500, 1000, 500, 500, 500, 1000, 500, 500, 500, 1000};
+static const uint8_t feliz_navidad_melody_ticks[FELIZ_NAVIDAD_MELODY_LENGTH] = {
+    1, 1, 2, 2, 2, 4, 2, 2, 2, 4, 2, 4, 2, 2, 2, 4, 2, 2, 2, 4};
 
 /**
  * @brief Feliz Navidad melody struct.
@@ -185,9 +209,10 @@ static const uint16_t feliz_navidad_melody_durations[FELIZ_NAVIDAD_MELODY_LENGTH
  * It is used to play the melody using the buzzer.
  */
 const melody_t feliz_navidad_melody = {.p_name = "Feliz Navidad",
-                               .p_notes = (double *)feliz_navidad_melody_notes,
-                               .p_durations = (uint16_t *)feliz_navidad_melody_durations,
-                               .melody_length = FELIZ_NAVIDAD_MELODY_LENGTH};
+                                       .p_midi_notes = feliz_navidad_melody_notes,
+                                       .p_ticks = feliz_navidad_melody_ticks,
+                                       .tick_ms = FELIZ_NAVIDAD_MELODY_TICK_MS,
+                                       .melody_length = FELIZ_NAVIDAD_MELODY_LENGTH};
 
 
 // scale_reverse Melody
@@ -218,6 +243,193 @@ static const uint16_t scale_reverse_melody_durations[SCALE_REVERSE_MELODY_LENGTH
  * It is used to play the melody using the buzzer.
  */
 const melody_t scale_reverse_melody = {.p_name = "scale_reverse",
-                               .p_notes = (double *)scale_reverse_melody_notes,
-                               .p_durations = (uint16_t *)scale_reverse_melody_durations,
+                               .p_notes = scale_reverse_melody_notes,
+                               .p_durations = scale_reverse_melody_durations,
                                .melody_length = SCALE_REVERSE_MELODY_LENGTH}; 
+
+
+// Scale harmony
+#define SCALE_THIRDS_MELODY_LENGTH 8   /*!< scale_thirds melody length */
+#define SCALE_BASS_MELODY_LENGTH 3   /*!< scale_bass melody length */
+
+/**
+ * @brief scale_thirds melody notes.
+ *
+ * This array contains the frequencies of the notes of the scale a third above scale_melody.
+ */
+static const double scale_thirds_melody_notes[SCALE_THIRDS_MELODY_LENGTH] = {
+    MI4, FA4, SOL4, LA4, SI4, DO5, RE5, MI5};
+
+/**
+ * @brief scale_thirds melody durations in miliseconds.
+ */
+static const uint16_t scale_thirds_melody_durations[SCALE_THIRDS_MELODY_LENGTH] = {
+    250, 250, 250, 250, 250, 250, 250, 250};
+
+/**
+ * @brief scale_thirds melody struct: harmony track of scale_harmony_multitrack.
+ */
+const melody_t scale_thirds_melody = {.p_name = "scale_thirds",
+                               .p_notes = scale_thirds_melody_notes,
+                               .p_durations = scale_thirds_melody_durations,
+                               .melody_length = SCALE_THIRDS_MELODY_LENGTH};
+
+/**
+ * @brief scale_bass melody notes.
+ *
+ * This array contains the frequencies of the bass line under the scale: tonic, dominant and tonic.
+ */
+static const double scale_bass_melody_notes[SCALE_BASS_MELODY_LENGTH] = {
+    DO3, SOL3, DO3};
+
+/**
+ * @brief scale_bass melody durations in miliseconds. The notes do not start with the notes of the scale.
+ */
+static const uint16_t scale_bass_melody_durations[SCALE_BASS_MELODY_LENGTH] = {
+    750, 875, 375};
+
+/**
+ * @brief scale_bass melody struct: bass track of scale_harmony_multitrack.
+ */
+const melody_t scale_bass_melody = {.p_name = "scale_bass",
+                               .p_notes = scale_bass_melody_notes,
+                               .p_durations = scale_bass_melody_durations,
+                               .melody_length = SCALE_BASS_MELODY_LENGTH};
+
+/**
+ * @brief Scale harmony multi-track melody struct.
+ * 
+ * The scale, the scale a third above and a bass line, played at the same time on three voices.
+ */
+const multitrack_melody_t scale_harmony_multitrack = {.p_name = "scale_harmony",
+                               .p_tracks = {&scale_melody, &scale_thirds_melody, &scale_bass_melody},
+                               .num_tracks = 3};
+
+/* Private functions ----------------------------------------------------------*/
+/**
+ * @brief Read a note of a streamed or packed melody from its stream or its codec.
+ *
+ * @param p_melody Pointer to the melody
+ * @param index Index of the note
+ * @param p_midi_note Pointer to store the MIDI note number
+ * @param p_ticks Pointer to store the duration in ticks
+ */
+static void _read_note(const melody_t *p_melody, uint32_t index, uint8_t *p_midi_note, uint8_t *p_ticks)
+{
+    if (p_melody->p_stream != NULL)
+    {
+        melody_stream_get_note(p_melody->p_stream, index, p_midi_note, p_ticks);
+    }
+    else
+    {
+        melody_codec_get_note(p_melody->p_codec, index, p_midi_note, p_ticks);
+    }
+}
+
+/**
+ * @brief Get the MIDI note number of a note of a compact melody, from its notes, its stream or its codec.
+ *
+ * @param p_melody Pointer to the melody
+ * @param index Index of the note
+ * @return uint8_t MIDI note number, MIDI_SILENCE for a silence
+ */
+static uint8_t _get_midi_note(const melody_t *p_melody, uint32_t index)
+{
+    if ((p_melody->p_stream == NULL) && (p_melody->p_codec == NULL))
+    {
+        return p_melody->p_midi_notes[index];
+    }
+    uint8_t midi_note;
+    uint8_t ticks;
+    _read_note(p_melody, index, &midi_note, &ticks);
+    return midi_note;
+}
+
+/**
+ * @brief Get the duration in ticks of a note of a compact melody, from its ticks, its stream or its codec.
+ *
+ * @param p_melody Pointer to the melody
+ * @param index Index of the note
+ * @return uint32_t Duration of the note in ticks
+ */
+static uint32_t _get_ticks(const melody_t *p_melody, uint32_t index)
+{
+    if ((p_melody->p_stream == NULL) && (p_melody->p_codec == NULL))
+    {
+        return p_melody->p_ticks[index];
+    }
+    uint8_t midi_note;
+    uint8_t ticks;
+    _read_note(p_melody, index, &midi_note, &ticks);
+    return ticks;
+}
+
+/* Public functions -----------------------------------------------------------*/
+bool melody_is_compact(const melody_t *p_melody)
+{
+    return p_melody->p_notes == NULL;
+}
+
+double melody_get_note_hz(const melody_t *p_melody, uint32_t index)
+{
+    if (!melody_is_compact(p_melody))
+    {
+        return p_melody->p_notes[index];
+    }
+    const note_regs_t *p_note = note_table_find_midi(_get_midi_note(p_melody, index));
+    return (p_note != NULL) ? p_note->frequency_hz : SILENCE;
+}
+
+uint32_t melody_get_note_q16(const melody_t *p_melody, uint32_t index)
+{
+    if (!melody_is_compact(p_melody))
+    {
+        return PORT_BUZZER_HZ_Q16(p_melody->p_notes[index]);
+    }
+    const note_regs_t *p_note = note_table_find_midi(_get_midi_note(p_melody, index));
+    return (p_note != NULL) ? p_note->frequency_q16 : 0;
+}
+
+uint32_t melody_get_duration_ms(const melody_t *p_melody, uint32_t index)
+{
+    if (!melody_is_compact(p_melody))
+    {
+        return p_melody->p_durations[index];
+    }
+    return _get_ticks(p_melody, index) * p_melody->tick_ms;
+}
+
+bool melody_decode(const melody_t *p_melody, uint8_t *p_midi_notes, uint8_t *p_ticks)
+{
+    if (!melody_is_compact(p_melody))
+    {
+        return false;
+    }
+    if (p_melody->p_stream != NULL)
+    {
+        return melody_stream_read_notes(p_melody->p_stream, 0, p_melody->melody_length, p_midi_notes, p_ticks);
+    }
+    if (p_melody->p_codec != NULL)
+    {
+        for (uint32_t i = 0; i < p_melody->melody_length; i++)
+        {
+            if (!melody_codec_get_note(p_melody->p_codec, i, &p_midi_notes[i], &p_ticks[i]))
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+    memcpy(p_midi_notes, p_melody->p_midi_notes, p_melody->melody_length);
+    memcpy(p_ticks, p_melody->p_ticks, p_melody->melody_length);
+    return true;
+}
+
+uint32_t melody_get_size(const melody_t *p_melody, bool compact)
+{
+    if (compact)
+    {
+        return p_melody->melody_length * (sizeof(uint8_t) + sizeof(uint8_t));
+    }
+    return p_melody->melody_length * (sizeof(double) + sizeof(uint16_t));
+}
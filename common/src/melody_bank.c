@@ -0,0 +1,234 @@
+/**
+ * @file melody_bank.c
+ * @brief Read-only melody bank: lookup of melodies by index and by name.
+ * @author Javier de Ponte Hernando
+ * @author Roberto Maldonado Macafee
+ * @date 18/10/2026
+ */
+
+/* Includes ------------------------------------------------------------------*/
+/* Standard C includes */
+#include <stddef.h>
+#include <string.h>
+
+/* Other includes */
+#include "melody_bank.h"
+
+/* Private functions ----------------------------------------------------------*/
+/**
+ * @brief Get the entries of the melodies of a bank.
+ *
+ * @param p_bank Pointer to the bank
+ * @return const melody_bank_entry_t* Pointer to the first entry
+ */
+static const melody_bank_entry_t *_entries(const melody_bank_t *p_bank)
+{
+    return (const melody_bank_entry_t *)(p_bank + 1);
+}
+
+/**
+ * @brief Get a pointer to an offset of a bank.
+ *
+ * @param p_bank Pointer to the bank
+ * @param offset Offset from the start of the bank
+ * @return const uint8_t* Pointer to the offset
+ */
+static const uint8_t *_at(const melody_bank_t *p_bank, uint32_t offset)
+{
+    return (const uint8_t *)p_bank + offset;
+}
+
+/**
+ * @brief Get the size of the payload of a melody of a bank: its tokens if it is packed, else its notes and durations.
+ *
+ * @param p_entry Pointer to the entry of the melody
+ * @return uint32_t Size of the payload in bytes
+ */
+static uint32_t _payload_size(const melody_bank_entry_t *p_entry)
+{
+    return (p_entry->flags & MELODY_BANK_FLAG_PACKED) ? p_entry->packed_size : 2U * p_entry->melody_length;
+}
+
+/**
+ * @brief Fill the fields of a melody of a bank that do not depend on how its notes are read.
+ *
+ * @param p_bank Pointer to the bank
+ * @param p_entry Pointer to the entry of the melody
+ * @param p_melody Pointer to store the melody
+ */
+static void _get_header(const melody_bank_t *p_bank, const melody_bank_entry_t *p_entry, melody_t *p_melody)
+{
+    memset(p_melody, 0, sizeof(melody_t));
+    p_melody->p_name = (char *)_at(p_bank, p_entry->name_offset);
+    p_melody->tick_ms = p_entry->tick_ms;
+    p_melody->melody_length = p_entry->melody_length;
+    if (p_entry->timeline_offset != 0)
+    {
+        p_melody->p_start_ms = (const uint32_t *)_at(p_bank, p_entry->timeline_offset);
+        p_melody->timeline_stride = p_entry->timeline_stride;
+    }
+}
+
+/* Public functions -----------------------------------------------------------*/
+const melody_bank_t *melody_bank_open(const void *p_data, uint32_t size)
+{
+    const melody_bank_t *p_bank = (const melody_bank_t *)p_data;
+    if ((p_bank == NULL) || (((uintptr_t)p_data & 3U) != 0) || (size < sizeof(melody_bank_t)))
+    {
+        return NULL;
+    }
+    if ((p_bank->magic != MELODY_BANK_MAGIC) || (p_bank->version != MELODY_BANK_VERSION) || (p_bank->size > size))
+    {
+        return NULL;
+    }
+    size = p_bank->size;
+    uint32_t num = p_bank->num_melodies;
+    if ((sizeof(melody_bank_t) + num * sizeof(melody_bank_entry_t) > size) || (p_bank->index_offset & 1U) ||
+        (p_bank->index_offset > size) || (num * sizeof(uint16_t) > size - p_bank->index_offset))
+    {
+        return NULL;
+    }
+    if ((p_bank->hash_offset != 0) &&
+        ((p_bank->hash_offset & 1U) || (p_bank->hash_offset > size) || (p_bank->hash_buckets == 0) ||
+         ((p_bank->hash_buckets + num) * sizeof(uint16_t) > size - p_bank->hash_offset)))
+    {
+        return NULL;
+    }
+    const melody_bank_entry_t *p_entries = _entries(p_bank);
+    const uint16_t *p_index = (const uint16_t *)_at(p_bank, p_bank->index_offset);
+    const uint16_t *p_slots = (const uint16_t *)_at(p_bank, p_bank->hash_offset) + p_bank->hash_buckets;
+    for (uint32_t i = 0; i < num; i++)
+    {
+        const melody_bank_entry_t *p_entry = &p_entries[i];
+        if ((p_index[i] >= num) || ((p_bank->hash_offset != 0) && (p_slots[i] >= num)) || (p_entry->name_offset >= size) || (memchr(_at(p_bank, p_entry->name_offset), '\0', size - p_entry->name_offset) == NULL))
+        {
+            return NULL;
+        }
+        if ((p_entry->notes_offset > size) || (_payload_size(p_entry) > size - p_entry->notes_offset) ||
+            ((p_entry->flags & MELODY_BANK_FLAG_PACKED) && ((p_entry->packed_size == 0) || (p_entry->packed_size > MELODY_CODEC_MAX_SIZE))))
+        {
+            return NULL;
+        }
+        uint32_t entries = melody_bank_get_timeline_entries(p_entry->melody_length, p_entry->timeline_stride);
+        if ((p_entry->timeline_offset != 0) &&
+            ((p_entry->timeline_offset & 3U) || (p_entry->timeline_stride == 0) || (p_entry->timeline_offset > size) ||
+             ((entries + 1U) * sizeof(uint32_t) > size - p_entry->timeline_offset)))
+        {
+            return NULL;
+        }
+    }
+    return p_bank;
+}
+
+uint32_t melody_bank_get_length(const melody_bank_t *p_bank)
+{
+    return (p_bank != NULL) ? p_bank->num_melodies : 0;
+}
+
+const char *melody_bank_get_name(const melody_bank_t *p_bank, uint32_t index)
+{
+    if (index >= melody_bank_get_length(p_bank))
+    {
+        return NULL;
+    }
+    return (const char *)_at(p_bank, _entries(p_bank)[index].name_offset);
+}
+
+uint32_t melody_bank_get_timeline_entries(uint32_t melody_length, uint32_t timeline_stride)
+{
+    return (timeline_stride > 0) ? (melody_length + timeline_stride - 1U) / timeline_stride : 0;
+}
+
+bool melody_bank_is_packed(const melody_bank_t *p_bank, uint32_t index)
+{
+    return (index < melody_bank_get_length(p_bank)) && (_entries(p_bank)[index].flags & MELODY_BANK_FLAG_PACKED);
+}
+
+bool melody_bank_get_melody(const melody_bank_t *p_bank, uint32_t index, melody_t *p_melody)
+{
+    if ((index >= melody_bank_get_length(p_bank)) || melody_bank_is_packed(p_bank, index))
+    {
+        return false;
+    }
+    const melody_bank_entry_t *p_entry = &_entries(p_bank)[index];
+    _get_header(p_bank, p_entry, p_melody);
+    p_melody->p_midi_notes = _at(p_bank, p_entry->notes_offset);
+    p_melody->p_ticks = p_melody->p_midi_notes + p_entry->melody_length;
+    return true;
+}
+
+bool melody_bank_get_packed(const melody_bank_t *p_bank, uint32_t index, melody_codec_t *p_codec, melody_t *p_melody)
+{
+    if (!melody_bank_is_packed(p_bank, index))
+    {
+        return false;
+    }
+    const melody_bank_entry_t *p_entry = &_entries(p_bank)[index];
+    melody_codec_init(p_codec, _at(p_bank, p_entry->notes_offset), p_entry->packed_size, p_entry->melody_length);
+    _get_header(p_bank, p_entry, p_melody);
+    p_melody->p_codec = p_codec;
+    return true;
+}
+
+uint32_t melody_bank_get_duration_ms(const melody_bank_t *p_bank, uint32_t index)
+{
+    if (index >= melody_bank_get_length(p_bank))
+    {
+        return 0;
+    }
+    return _entries(p_bank)[index].duration_ms;
+}
+
+int32_t melody_bank_find(const melody_bank_t *p_bank, const char *p_name)
+{
+    uint32_t low = 0;
+    uint32_t high = melody_bank_get_length(p_bank);
+    if (high == 0)
+    {
+        return -1;
+    }
+    if (p_bank->hash_offset != 0)
+    {
+        // The displacement of the bucket of the name leads to the slot of the only melody that may have it
+        const uint16_t *p_hash = (const uint16_t *)_at(p_bank, p_bank->hash_offset);
+        uint32_t displacement = p_hash[melody_bank_hash(p_name, 0) % p_bank->hash_buckets];
+        uint32_t index = p_hash[p_bank->hash_buckets + melody_bank_hash(p_name, displacement) % high];
+        return (strcmp(melody_bank_get_name(p_bank, index), p_name) == 0) ? (int32_t)index : -1;
+    }
+    const uint16_t *p_index = (const uint16_t *)_at(p_bank, p_bank->index_offset);
+    while (low < high)
+    {
+        uint32_t mid = (low + high) / 2;
+        int cmp = strcmp(melody_bank_get_name(p_bank, p_index[mid]), p_name);
+        if (cmp == 0)
+        {
+            return p_index[mid];
+        }
+        if (cmp < 0)
+        {
+            low = mid + 1;
+        }
+        else
+        {
+            high = mid;
+        }
+    }
+    return -1;
+}
+
+uint32_t melody_bank_hash(const char *p_name, uint32_t seed)
+{
+    uint32_t hash = MELODY_BANK_HASH_BASIS ^ seed;
+    while (*p_name != '\0')
+    {
+        hash ^= (uint8_t)*p_name++;
+        hash *= MELODY_BANK_HASH_PRIME;
+    }
+    // Every bit of the hash depends on every bit of the seed, not only on the lower ones
+    hash ^= hash >> 16;
+    hash *= 0x85EBCA6BU;
+    hash ^= hash >> 13;
+    hash *= 0xC2B2AE35U;
+    hash ^= hash >> 16;
+    return hash;
+}
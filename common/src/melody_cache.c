@@ -0,0 +1,171 @@
+/**
+ * @file melody_cache.c
+ * @brief LRU cache of the melodies decoded from a slow or compressed source.
+ * @author Javier de Ponte Hernando
+ * @author Roberto Maldonado Macafee
+ * @date 18/10/2026
+ */
+
+/* Includes ------------------------------------------------------------------*/
+/* Standard C includes */
+#include <stddef.h>
+#include <string.h>
+
+/* Other includes */
+#include "melody_cache.h"
+
+/* Private functions ----------------------------------------------------------*/
+/**
+ * @brief Check if the view of the melody playing points to the notes of a slot.
+ *
+ * @param p_cache Pointer to the cache
+ * @param slot Slot of the cache
+ * @return true if the melody of the slot is playing
+ * @return false otherwise
+ */
+static bool _is_playing(const melody_cache_t *p_cache, uint32_t slot)
+{
+    return (p_cache->p_view != NULL) && (p_cache->p_view->p_midi_notes == p_cache->slots[slot].midi_notes);
+}
+
+/**
+ * @brief Get the slot of a melody.
+ *
+ * @param p_cache Pointer to the cache
+ * @param id Id of the melody
+ * @return int32_t Slot of the melody, or -1 if it is not in the cache
+ */
+static int32_t _slot_of(const melody_cache_t *p_cache, uint32_t id)
+{
+    for (uint32_t slot = 0; slot < MELODY_CACHE_NUM_SLOTS; slot++)
+    {
+        if (p_cache->slots[slot].valid && (p_cache->slots[slot].id == id))
+        {
+            return (int32_t)slot;
+        }
+    }
+    return -1;
+}
+
+/**
+ * @brief Get the slot to store a melody in: its own slot if it is already in the cache, else a free slot, else the
+ * slot of the least recently used melody that is not playing.
+ *
+ * @param p_cache Pointer to the cache
+ * @param id Id of the melody
+ * @return int32_t Slot, or -1 if every slot is in use
+ */
+static int32_t _slot_for(const melody_cache_t *p_cache, uint32_t id)
+{
+    int32_t victim = _slot_of(p_cache, id);
+    if ((victim >= 0) && !_is_playing(p_cache, (uint32_t)victim))
+    {
+        return victim;
+    }
+    victim = -1;
+    for (uint32_t slot = 0; slot < MELODY_CACHE_NUM_SLOTS; slot++)
+    {
+        if (!p_cache->slots[slot].valid)
+        {
+            return (int32_t)slot;
+        }
+        if (!_is_playing(p_cache, slot) &&
+            ((victim < 0) || (p_cache->slots[slot].last_used < p_cache->slots[victim].last_used)))
+        {
+            victim = (int32_t)slot;
+        }
+    }
+    return victim;
+}
+
+/**
+ * @brief Fill the view of the melody of a slot, and mark the melody as the most recently used.
+ *
+ * @param p_cache Pointer to the cache
+ * @param slot Slot of the melody
+ * @param p_melody Pointer to store the view of the melody
+ */
+static void _get_melody(melody_cache_t *p_cache, uint32_t slot, melody_t *p_melody)
+{
+    melody_cache_slot_t *p_slot = &p_cache->slots[slot];
+    p_slot->last_used = ++p_cache->use_counter;
+    memset(p_melody, 0, sizeof(melody_t));
+    p_melody->p_name = p_slot->name;
+    p_melody->p_midi_notes = p_slot->midi_notes;
+    p_melody->p_ticks = p_slot->ticks;
+    p_melody->tick_ms = p_slot->tick_ms;
+    p_melody->melody_length = p_slot->melody_length;
+}
+
+/* Public functions -----------------------------------------------------------*/
+void melody_cache_init(melody_cache_t *p_cache, const melody_t *p_view)
+{
+    memset(p_cache, 0, sizeof(melody_cache_t));
+    p_cache->p_view = p_view;
+}
+
+bool melody_cache_get(melody_cache_t *p_cache, uint32_t id, melody_t *p_melody)
+{
+    int32_t slot = _slot_of(p_cache, id);
+    if (slot < 0)
+    {
+        p_cache->misses++;
+        return false;
+    }
+    p_cache->hits++;
+    _get_melody(p_cache, (uint32_t)slot, p_melody);
+    return true;
+}
+
+bool melody_cache_store(melody_cache_t *p_cache, uint32_t id, const melody_t *p_source, melody_t *p_melody)
+{
+    if (!melody_is_compact(p_source) || (p_source->melody_length > MELODY_CACHE_SLOT_NOTES))
+    {
+        return false;
+    }
+    int32_t slot = _slot_of(p_cache, id);
+    if ((slot >= 0) && (p_source->p_midi_notes == p_cache->slots[slot].midi_notes))
+    {
+        // The source is the melody of the cache already
+        _get_melody(p_cache, (uint32_t)slot, p_melody);
+        return true;
+    }
+    slot = _slot_for(p_cache, id);
+    if (slot < 0)
+    {
+        return false;
+    }
+    melody_cache_slot_t *p_slot = &p_cache->slots[slot];
+    bool evicted = p_slot->valid && (p_slot->id != id);
+    p_slot->valid = false;
+    if (!melody_decode(p_source, p_slot->midi_notes, p_slot->ticks))
+    {
+        return false;
+    }
+    if (evicted)
+    {
+        p_cache->evictions++;
+    }
+    p_slot->valid = true;
+    p_slot->id = id;
+    p_slot->melody_length = p_source->melody_length;
+    p_slot->tick_ms = p_source->tick_ms;
+    memset(p_slot->name, 0, MELODY_CACHE_NAME_LENGTH);
+    if (p_source->p_name != NULL)
+    {
+        strncpy(p_slot->name, p_source->p_name, MELODY_CACHE_NAME_LENGTH - 1U);
+    }
+    _get_melody(p_cache, (uint32_t)slot, p_melody);
+    return true;
+}
+
+void melody_cache_clear(melody_cache_t *p_cache)
+{
+    for (uint32_t slot = 0; slot < MELODY_CACHE_NUM_SLOTS; slot++)
+    {
+        if (!_is_playing(p_cache, slot))
+        {
+            p_cache->slots[slot].valid = false;
+        }
+    }
+}
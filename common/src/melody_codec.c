@@ -0,0 +1,373 @@
+/**
+ * @file melody_codec.c
+ * @brief Encoder and streaming decoder of packed melodies: delta-coded pitch, run-length coded durations and
+ * back-references to repeated phrases.
+ * @author Javier de Ponte Hernando
+ * @author Roberto Maldonado Macafee
+ * @date 18/10/2026
+ */
+
+/* Includes ------------------------------------------------------------------*/
+/* Standard C includes */
+#include <stddef.h>
+#include <string.h>
+
+/* Other includes */
+#include "melody_codec.h"
+
+/* Defines and enums ----------------------------------------------------------*/
+#define MELODY_CODEC_BACKREF_SIZE 3U /*!< Size of a back-reference token in bytes */
+
+/* Private functions ----------------------------------------------------------*/
+/**
+ * @brief Get the size of a token with its operands.
+ *
+ * @param token First byte of the token
+ * @return uint32_t Size of the token in bytes, 0 if it is not a valid token
+ */
+static uint32_t _token_size(uint8_t token)
+{
+    if (token < MELODY_CODEC_NOTE_TICKS)
+    {
+        return 1;
+    }
+    if (token < MELODY_CODEC_RUN)
+    {
+        return 2;
+    }
+    if (token < MELODY_CODEC_SILENCE)
+    {
+        return 1;
+    }
+    switch (token)
+    {
+    case MELODY_CODEC_SILENCE:
+        return 1;
+    case MELODY_CODEC_SILENCE_TICKS:
+    case MELODY_CODEC_ABSOLUTE:
+        return 2;
+    case MELODY_CODEC_ABSOLUTE_TICKS:
+        return 3;
+    default:
+        return (token >= MELODY_CODEC_BACKREF) ? MELODY_CODEC_BACKREF_SIZE : 0;
+    }
+}
+
+/**
+ * @brief Write a token to a buffer.
+ *
+ * @param p_data Pointer to the buffer
+ * @param size Size of the buffer in bytes
+ * @param p_offset Pointer to the offset to write the token at. It is moved past the token
+ * @param p_token Pointer to the token with its operands
+ * @return true if the token has been written
+ * @return false if it does not fit
+ */
+static bool _emit(uint8_t *p_data, uint32_t size, uint32_t *p_offset, const uint8_t *p_token)
+{
+    uint32_t token_size = _token_size(p_token[0]);
+    if (*p_offset + token_size > size)
+    {
+        return false;
+    }
+    memcpy(&p_data[*p_offset], p_token, token_size);
+    *p_offset += token_size;
+    return true;
+}
+
+/**
+ * @brief Write the notes of a melody as tokens with no back-references.
+ *
+ * @param p_midi_notes Pointer to the MIDI note numbers
+ * @param p_ticks Pointer to the durations in ticks
+ * @param length Number of notes
+ * @param p_data Pointer to store the tokens
+ * @param size Size of the buffer in bytes
+ * @return int32_t Size of the tokens in bytes, or -1 if they do not fit
+ */
+static int32_t _encode_literal(const uint8_t *p_midi_notes, const uint8_t *p_ticks, uint32_t length, uint8_t *p_data, uint32_t size)
+{
+    uint32_t offset = 0;
+    uint8_t pitch = MELODY_CODEC_INITIAL_PITCH;
+    uint8_t ticks = 0;
+    uint32_t i = 0;
+    while (i < length)
+    {
+        uint8_t token[3];
+        // A note repeated twice or more is a run: repeated once, a note token is as short
+        uint32_t repeats = 0;
+        while ((i > 0) && (i + repeats < length) && (repeats < MELODY_CODEC_RUN_MAX_NOTES) &&
+               (p_midi_notes[i + repeats] == p_midi_notes[i - 1]) && (p_ticks[i + repeats] == p_ticks[i - 1]))
+        {
+            repeats++;
+        }
+        if (repeats >= 2)
+        {
+            token[0] = (uint8_t)(MELODY_CODEC_RUN | (repeats - 1U));
+            if (!_emit(p_data, size, &offset, token))
+            {
+                return -1;
+            }
+            i += repeats;
+            continue;
+        }
+        bool new_ticks = (p_ticks[i] != ticks);
+        int32_t delta = (int32_t)p_midi_notes[i] - (int32_t)pitch;
+        if (p_midi_notes[i] == MIDI_SILENCE)
+        {
+            token[0] = new_ticks ? MELODY_CODEC_SILENCE_TICKS : MELODY_CODEC_SILENCE;
+            token[1] = p_ticks[i];
+        }
+        else if ((delta >= -MELODY_CODEC_DELTA_BIAS) && (delta < MELODY_CODEC_DELTA_BIAS))
+        {
+            token[0] = (uint8_t)((new_ticks ? MELODY_CODEC_NOTE_TICKS : MELODY_CODEC_NOTE) | (uint8_t)(delta + MELODY_CODEC_DELTA_BIAS));
+            token[1] = p_ticks[i];
+            pitch = p_midi_notes[i];
+        }
+        else
+        {
+            token[0] = new_ticks ? MELODY_CODEC_ABSOLUTE_TICKS : MELODY_CODEC_ABSOLUTE;
+            token[1] = p_midi_notes[i];
+            token[2] = p_ticks[i];
+            pitch = p_midi_notes[i];
+        }
+        if (!_emit(p_data, size, &offset, token))
+        {
+            return -1;
+        }
+        ticks = p_ticks[i];
+        i++;
+    }
+    return (int32_t)offset;
+}
+
+/**
+ * @brief Get the length of the match of the tokens at an offset of the output with the tokens at an offset of the
+ * input: the tokens must be equal and the tokens of the output must not be back-references.
+ *
+ * @param p_data Pointer to the buffer of the output and the input
+ * @param source Offset of the first token of the output
+ * @param out End of the output
+ * @param in Offset of the first token of the input
+ * @param end End of the input
+ * @param p_tokens Pointer to store the number of tokens matched
+ * @return uint32_t Size of the tokens matched in bytes
+ */
+static uint32_t _match(const uint8_t *p_data, uint32_t source, uint32_t out, uint32_t in, uint32_t end, uint32_t *p_tokens)
+{
+    uint32_t a = source;
+    uint32_t b = in;
+    uint32_t tokens = 0;
+    while ((tokens < MELODY_CODEC_BACKREF_MAX_TOKENS) && (a < out) && (b < end) && (p_data[a] < MELODY_CODEC_BACKREF))
+    {
+        uint32_t token_size = _token_size(p_data[a]);
+        if ((token_size != _token_size(p_data[b])) || (memcmp(&p_data[a], &p_data[b], token_size) != 0))
+        {
+            break;
+        }
+        a += token_size;
+        b += token_size;
+        tokens++;
+    }
+    *p_tokens = tokens;
+    return b - in;
+}
+
+/**
+ * @brief Decode the next note.
+ *
+ * @param p_codec Pointer to the codec
+ * @return true if the note has been decoded
+ * @return false if the tokens are not valid
+ */
+static bool _next(melody_codec_t *p_codec)
+{
+    p_codec->prev_midi_note = p_codec->midi_note;
+    p_codec->prev_ticks = p_codec->ticks;
+    if (p_codec->run > 0)
+    {
+        p_codec->run--;
+        p_codec->index++;
+        return true;
+    }
+    if ((p_codec->ref_return != 0) && (p_codec->ref_tokens == 0))
+    {
+        p_codec->position = p_codec->ref_return;
+        p_codec->ref_return = 0;
+    }
+    if (p_codec->position >= p_codec->size)
+    {
+        return false;
+    }
+    uint8_t token = p_codec->p_data[p_codec->position];
+    if (token >= MELODY_CODEC_BACKREF)
+    {
+        // Back-references are not nested and only point backwards, so a replay always ends
+        if ((p_codec->ref_return != 0) || (p_codec->position + MELODY_CODEC_BACKREF_SIZE > p_codec->size))
+        {
+            return false;
+        }
+        uint32_t offset = p_codec->p_data[p_codec->position + 1U] | ((uint32_t)p_codec->p_data[p_codec->position + 2U] << 8);
+        if (offset >= p_codec->position)
+        {
+            return false;
+        }
+        p_codec->ref_tokens = (uint8_t)((token & ~MELODY_CODEC_BACKREF) + MELODY_CODEC_BACKREF_MIN_TOKENS);
+        p_codec->ref_return = p_codec->position + MELODY_CODEC_BACKREF_SIZE;
+        p_codec->position = offset;
+        token = p_codec->p_data[offset];
+        if (token >= MELODY_CODEC_BACKREF)
+        {
+            return false;
+        }
+    }
+    uint32_t token_size = _token_size(token);
+    if ((token_size == 0) || (p_codec->position + token_size > p_codec->size))
+    {
+        return false;
+    }
+    const uint8_t *p_operands = &p_codec->p_data[p_codec->position + 1U];
+    p_codec->position += token_size;
+    if (p_codec->ref_return != 0)
+    {
+        p_codec->ref_tokens--;
+    }
+
+    if (token < MELODY_CODEC_RUN)
+    {
+        p_codec->pitch = (uint8_t)(p_codec->pitch + (token & ~MELODY_CODEC_NOTE_TICKS) - MELODY_CODEC_DELTA_BIAS);
+        p_codec->midi_note = p_codec->pitch;
+        if (token >= MELODY_CODEC_NOTE_TICKS)
+        {
+            p_codec->ticks = p_operands[0];
+        }
+    }
+    else if (token < MELODY_CODEC_SILENCE)
+    {
+        // The token is the first note of the run: the current note is repeated
+        if (p_codec->index == MELODY_CODEC_NO_NOTE)
+        {
+            return false;
+        }
+        p_codec->run = token & ~MELODY_CODEC_RUN;
+    }
+    else if (token <= MELODY_CODEC_SILENCE_TICKS)
+    {
+        p_codec->midi_note = MIDI_SILENCE;
+        if (token == MELODY_CODEC_SILENCE_TICKS)
+        {
+            p_codec->ticks = p_operands[0];
+        }
+    }
+    else
+    {
+        p_codec->pitch = p_operands[0];
+        p_codec->midi_note = p_codec->pitch;
+        if (token == MELODY_CODEC_ABSOLUTE_TICKS)
+        {
+            p_codec->ticks = p_operands[1];
+        }
+    }
+    p_codec->index++;
+    return true;
+}
+
+/* Public functions -----------------------------------------------------------*/
+int32_t melody_codec_encode(const uint8_t *p_midi_notes, const uint8_t *p_ticks, uint32_t length, uint8_t *p_data, uint32_t size)
+{
+    int32_t literal_size = _encode_literal(p_midi_notes, p_ticks, length, p_data, size);
+    if (literal_size < 0)
+    {
+        return -1;
+    }
+    // The output is written over the input, never ahead of it: a back-reference replaces more bytes than it takes
+    uint32_t end = (uint32_t)literal_size;
+    uint32_t in = 0;
+    uint32_t out = 0;
+    while (in < end)
+    {
+        uint32_t best_size = MELODY_CODEC_BACKREF_SIZE;
+        uint32_t best_source = 0;
+        uint32_t best_tokens = 0;
+        for (uint32_t source = 0; (source < out) && (source < MELODY_CODEC_MAX_SIZE); source += _token_size(p_data[source]))
+        {
+            uint32_t tokens;
+            uint32_t match_size = _match(p_data, source, out, in, end, &tokens);
+            if ((tokens >= MELODY_CODEC_BACKREF_MIN_TOKENS) && (match_size > best_size))
+            {
+                best_size = match_size;
+                best_source = source;
+                best_tokens = tokens;
+            }
+        }
+        if (best_tokens > 0)
+        {
+            p_data[out] = (uint8_t)(MELODY_CODEC_BACKREF | (best_tokens - MELODY_CODEC_BACKREF_MIN_TOKENS));
+            p_data[out + 1U] = (uint8_t)(best_source & 0xFFU);
+            p_data[out + 2U] = (uint8_t)(best_source >> 8);
+            out += MELODY_CODEC_BACKREF_SIZE;
+            in += best_size;
+        }
+        else
+        {
+            uint32_t token_size = _token_size(p_data[in]);
+            memmove(&p_data[out], &p_data[in], token_size);
+            out += token_size;
+            in += token_size;
+        }
+    }
+    return (out <= MELODY_CODEC_MAX_SIZE) ? (int32_t)out : -1;
+}
+
+void melody_codec_init(melody_codec_t *p_codec, const uint8_t *p_data, uint32_t size, uint16_t melody_length)
+{
+    memset(p_codec, 0, sizeof(melody_codec_t));
+    p_codec->p_data = p_data;
+    p_codec->size = size;
+    p_codec->melody_length = melody_length;
+    melody_codec_rewind(p_codec);
+}
+
+void melody_codec_rewind(melody_codec_t *p_codec)
+{
+    p_codec->index = MELODY_CODEC_NO_NOTE;
+    p_codec->position = 0;
+    p_codec->ref_return = 0;
+    p_codec->ref_tokens = 0;
+    p_codec->run = 0;
+    p_codec->pitch = MELODY_CODEC_INITIAL_PITCH;
+    p_codec->midi_note = MIDI_SILENCE;
+    p_codec->ticks = 0;
+}
+
+bool melody_codec_get_note(melody_codec_t *p_codec, uint32_t index, uint8_t *p_midi_note, uint8_t *p_ticks)
+{
+    *p_midi_note = MIDI_SILENCE;
+    *p_ticks = 0;
+    if (index >= p_codec->melody_length)
+    {
+        return false;
+    }
+    if ((p_codec->index != MELODY_CODEC_NO_NOTE) && (index + 1U == p_codec->index))
+    {
+        *p_midi_note = p_codec->prev_midi_note;
+        *p_ticks = p_codec->prev_ticks;
+        return true;
+    }
+    if ((p_codec->index == MELODY_CODEC_NO_NOTE) || (index < p_codec->index))
+    {
+        melody_codec_rewind(p_codec);
+    }
+    while (p_codec->index != index)
+    {
+        if (!_next(p_codec))
+        {
+            // The decoder is left before the first note: it is not valid after an error
+            melody_codec_rewind(p_codec);
+            return false;
+        }
+    }
+    *p_midi_note = p_codec->midi_note;
+    *p_ticks = p_codec->ticks;
+    return true;
+}
@@ -0,0 +1,293 @@
+/**
+ * @file melody_pool.c
+ * @brief Arena-backed pool of the melodies uploaded at runtime.
+ * @author Javier de Ponte Hernando
+ * @author Roberto Maldonado Macafee
+ * @date 18/10/2026
+ */
+
+/* Includes ------------------------------------------------------------------*/
+/* Standard C includes */
+#include <stddef.h>
+#include <string.h>
+
+/* Other includes */
+#include "melody_pool.h"
+
+/* Private functions ----------------------------------------------------------*/
+/**
+ * @brief Check if a slot holds a stored melody (not a free slot or the melody being stored).
+ *
+ * @param p_pool Pointer to the pool
+ * @param slot Slot of the pool
+ * @return true if the slot holds a stored melody
+ * @return false otherwise
+ */
+static bool _is_stored(const melody_pool_t *p_pool, uint32_t slot)
+{
+    return (p_pool->slots[slot].name[0] != '\0') && ((int32_t)slot != p_pool->upload_slot);
+}
+
+/**
+ * @brief Get the slot of the melody of an index.
+ *
+ * @param p_pool Pointer to the pool
+ * @param index Index of the melody
+ * @return int32_t Slot of the melody, or -1 if there is no such melody
+ */
+static int32_t _slot_of(const melody_pool_t *p_pool, uint32_t index)
+{
+    for (uint32_t slot = 0; slot < MELODY_POOL_MAX_MELODIES; slot++)
+    {
+        if (_is_stored(p_pool, slot) && (index-- == 0))
+        {
+            return (int32_t)slot;
+        }
+    }
+    return -1;
+}
+
+/**
+ * @brief Check if the view of the melody playing points to the notes of a slot.
+ *
+ * @param p_pool Pointer to the pool
+ * @param slot Slot of the pool
+ * @return true if the melody of the slot is playing
+ * @return false otherwise
+ */
+static bool _is_playing(const melody_pool_t *p_pool, uint32_t slot)
+{
+    return (p_pool->p_view != NULL) && (p_pool->p_view->p_midi_notes == &p_pool->arena[p_pool->slots[slot].offset]);
+}
+
+/**
+ * @brief Remove a stored melody and compact the arena: the notes of the melodies after it, and of the melody being
+ * stored, are moved down. The view of the melody playing follows its notes. If they are moved, the player is held
+ * meanwhile, so it never reads the notes half moved or a view with the notes moved and the ticks not.
+ *
+ * @param p_pool Pointer to the pool
+ * @param slot Slot of the melody
+ */
+static void _remove(melody_pool_t *p_pool, uint32_t slot)
+{
+    uint32_t offset = p_pool->slots[slot].offset;
+    uint32_t size = 2U * p_pool->slots[slot].melody_length;
+    uint32_t end = p_pool->used + p_pool->upload_length;
+    bool hold = false;
+    for (uint32_t i = 0; i < MELODY_POOL_MAX_MELODIES; i++)
+    {
+        hold |= _is_stored(p_pool, i) && (p_pool->slots[i].offset > offset) && _is_playing(p_pool, i);
+    }
+    hold = hold && (p_pool->hold != NULL);
+    if (hold)
+    {
+        p_pool->hold(p_pool->p_hold_arg, true);
+    }
+    memmove(&p_pool->arena[offset], &p_pool->arena[offset + size], end - offset - size);
+    for (uint32_t i = 0; i < MELODY_POOL_MAX_MELODIES; i++)
+    {
+        if (_is_stored(p_pool, i) && (p_pool->slots[i].offset > offset))
+        {
+            if (_is_playing(p_pool, i))
+            {
+                p_pool->p_view->p_midi_notes -= size;
+                p_pool->p_view->p_ticks -= size;
+            }
+            p_pool->slots[i].offset -= size;
+        }
+    }
+    if (hold)
+    {
+        p_pool->hold(p_pool->p_hold_arg, false);
+    }
+    p_pool->used -= size;
+    memset(&p_pool->slots[slot], 0, sizeof(melody_pool_slot_t));
+}
+
+/**
+ * @brief Evict the least recently used melody that is not playing.
+ *
+ * @param p_pool Pointer to the pool
+ * @return true if a melody has been evicted
+ * @return false if every stored melody is playing, or there is none
+ */
+static bool _evict(melody_pool_t *p_pool)
+{
+    int32_t victim = -1;
+    for (uint32_t slot = 0; slot < MELODY_POOL_MAX_MELODIES; slot++)
+    {
+        if (_is_stored(p_pool, slot) && !_is_playing(p_pool, slot) &&
+            ((victim < 0) || (p_pool->slots[slot].last_used < p_pool->slots[victim].last_used)))
+        {
+            victim = (int32_t)slot;
+        }
+    }
+    if (victim < 0)
+    {
+        return false;
+    }
+    _remove(p_pool, (uint32_t)victim);
+    p_pool->evictions++;
+    return true;
+}
+
+/* Public functions -----------------------------------------------------------*/
+void melody_pool_init(melody_pool_t *p_pool, melody_t *p_view)
+{
+    memset(p_pool, 0, sizeof(melody_pool_t));
+    p_pool->upload_slot = -1;
+    p_pool->p_view = p_view;
+}
+
+void melody_pool_set_hold(melody_pool_t *p_pool, melody_pool_hold_t hold, void *p_arg)
+{
+    p_pool->hold = hold;
+    p_pool->p_hold_arg = p_arg;
+}
+
+uint32_t melody_pool_get_length(const melody_pool_t *p_pool)
+{
+    uint32_t length = 0;
+    for (uint32_t slot = 0; slot < MELODY_POOL_MAX_MELODIES; slot++)
+    {
+        length += _is_stored(p_pool, slot);
+    }
+    return length;
+}
+
+bool melody_pool_get_melody(melody_pool_t *p_pool, uint32_t index, melody_t *p_melody)
+{
+    int32_t slot = _slot_of(p_pool, index);
+    if (slot < 0)
+    {
+        return false;
+    }
+    melody_pool_slot_t *p_slot = &p_pool->slots[slot];
+    p_slot->last_used = ++p_pool->use_counter;
+    memset(p_melody, 0, sizeof(melody_t));
+    p_melody->p_name = p_slot->name;
+    p_melody->p_midi_notes = &p_pool->arena[p_slot->offset];
+    p_melody->p_ticks = p_melody->p_midi_notes + p_slot->melody_length;
+    p_melody->tick_ms = p_slot->tick_ms;
+    p_melody->melody_length = p_slot->melody_length;
+    return true;
+}
+
+int32_t melody_pool_find(const melody_pool_t *p_pool, const char *p_name)
+{
+    int32_t index = 0;
+    for (uint32_t slot = 0; slot < MELODY_POOL_MAX_MELODIES; slot++)
+    {
+        if (_is_stored(p_pool, slot))
+        {
+            if (strcmp(p_pool->slots[slot].name, p_name) == 0)
+            {
+                return index;
+            }
+            index++;
+        }
+    }
+    return -1;
+}
+
+bool melody_pool_begin(melody_pool_t *p_pool, const char *p_name)
+{
+    size_t length = strlen(p_name);
+    melody_pool_abort(p_pool);
+    if ((length == 0) || (length >= MELODY_POOL_NAME_LENGTH))
+    {
+        return false;
+    }
+    int32_t index = melody_pool_find(p_pool, p_name);
+    if (index >= 0)
+    {
+        int32_t old = _slot_of(p_pool, (uint32_t)index);
+        if (_is_playing(p_pool, (uint32_t)old))
+        {
+            return false;
+        }
+        _remove(p_pool, (uint32_t)old);
+    }
+    int32_t slot = -1;
+    while (slot < 0)
+    {
+        for (uint32_t i = 0; (i < MELODY_POOL_MAX_MELODIES) && (slot < 0); i++)
+        {
+            if (p_pool->slots[i].name[0] == '\0')
+            {
+                slot = (int32_t)i;
+            }
+        }
+        if ((slot < 0) && !_evict(p_pool))
+        {
+            return false;
+        }
+    }
+    memcpy(p_pool->slots[slot].name, p_name, length + 1U);
+    p_pool->slots[slot].offset = p_pool->used;
+    p_pool->upload_slot = (int8_t)slot;
+    p_pool->upload_length = 0;
+    return true;
+}
+
+bool melody_pool_append(melody_pool_t *p_pool, uint8_t midi_note, uint8_t ticks)
+{
+    if (p_pool->upload_slot < 0)
+    {
+        return false;
+    }
+    while (MELODY_POOL_ARENA_SIZE - p_pool->used - 2U * p_pool->upload_length < 2U)
+    {
+        if (!_evict(p_pool))
+        {
+            return false;
+        }
+    }
+    p_pool->arena[p_pool->used + p_pool->upload_length] = midi_note;
+    p_pool->arena[MELODY_POOL_ARENA_SIZE - 1U - p_pool->upload_length] = ticks;
+    p_pool->upload_length++;
+    return true;
+}
+
+int32_t melody_pool_commit(melody_pool_t *p_pool, uint16_t tick_ms)
+{
+    if ((p_pool->upload_slot < 0) || (p_pool->upload_length == 0))
+    {
+        melody_pool_abort(p_pool);
+        return -1;
+    }
+    uint32_t length = p_pool->upload_length;
+    uint8_t *p_ticks = &p_pool->arena[MELODY_POOL_ARENA_SIZE - length];
+    for (uint32_t i = 0; i < length / 2U; i++)
+    {
+        uint8_t ticks = p_ticks[i];
+        p_ticks[i] = p_ticks[length - 1U - i];
+        p_ticks[length - 1U - i] = ticks;
+    }
+    memmove(&p_pool->arena[p_pool->used + length], p_ticks, length);
+
+    melody_pool_slot_t *p_slot = &p_pool->slots[p_pool->upload_slot];
+    p_slot->offset = p_pool->used;
+    p_slot->melody_length = (uint16_t)length;
+    p_slot->tick_ms = tick_ms;
+    p_slot->last_used = ++p_pool->use_counter;
+    p_pool->used += 2U * length;
+    p_pool->upload_slot = -1;
+    p_pool->upload_length = 0;
+    return melody_pool_find(p_pool, p_slot->name);
+}
+
+void melody_pool_abort(melody_pool_t *p_pool)
+{
+    if (p_pool->upload_slot >= 0)
+    {
+        memset(&p_pool->slots[p_pool->upload_slot], 0, sizeof(melody_pool_slot_t));
+    }
+    p_pool->upload_slot = -1;
+    p_pool->upload_length = 0;
+}
+
+uint32_t melody_pool_get_evictions(const melody_pool_t *p_pool)
+{
+    return p_pool->evictions;
+}
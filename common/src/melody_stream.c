@@ -0,0 +1,292 @@
+/**
+ * @file melody_stream.c
+ * @brief Melodies streamed from a block device through a read-ahead ring.
+ * @author Javier de Ponte Hernando
+ * @author Roberto Maldonado Macafee
+ * @date 18/10/2026
+ */
+
+/* Includes ------------------------------------------------------------------*/
+/* Standard C includes */
+#include <stddef.h>
+#include <string.h>
+
+/* Other includes */
+#include "melody_stream.h"
+#include "melody_bank.h"
+
+/* Defines and enums ----------------------------------------------------------*/
+#define MIN(a, b) ((a) < (b) ? (a) : (b)) /*!< Macro to get the minimum of two values. */
+
+/* Private functions ----------------------------------------------------------*/
+/**
+ * @brief Read ahead the notes that follow the tail of the ring: up to a block, without wrapping around the ring and
+ * without going past the end of the melody.
+ *
+ * @param p_stream Pointer to the stream
+ * @param room Maximum number of notes to read
+ * @return true if some notes have been read
+ * @return false if there is no room or the device cannot be read
+ */
+static bool _fill(melody_stream_t *p_stream, uint32_t room)
+{
+    uint32_t tail = p_stream->tail;
+    uint32_t slot = tail % MELODY_STREAM_RING_NOTES;
+    uint32_t count = MIN(MIN(MELODY_STREAM_BLOCK_NOTES, MELODY_STREAM_RING_NOTES - slot), MIN(p_stream->melody_length - tail, room));
+    if ((tail >= p_stream->melody_length) || (count == 0))
+    {
+        return false;
+    }
+    // The notes overwritten leave the ring before they are written
+    if (tail + count - p_stream->first > MELODY_STREAM_RING_NOTES)
+    {
+        p_stream->first = tail + count - MELODY_STREAM_RING_NOTES;
+    }
+    p_stream->reads++;
+    if (!p_stream->read(p_stream->notes_address + tail, &p_stream->midi_notes[slot], count) ||
+        !p_stream->read(p_stream->notes_address + p_stream->melody_length + tail, &p_stream->ticks[slot], count))
+    {
+        return false;
+    }
+    p_stream->tail = tail + count;
+    return true;
+}
+
+/**
+ * @brief Get the number of notes that can be read ahead: the notes already played, but the last
+ * MELODY_STREAM_HISTORY_NOTES, make room for them.
+ *
+ * @param p_stream Pointer to the stream
+ * @return uint32_t Number of notes
+ */
+static uint32_t _room(const melody_stream_t *p_stream)
+{
+    uint32_t limit = p_stream->position + MELODY_STREAM_RING_NOTES - MELODY_STREAM_HISTORY_NOTES;
+    return (limit > p_stream->tail) ? limit - p_stream->tail : 0;
+}
+
+/**
+ * @brief Empty the ring and read the notes from a note on.
+ *
+ * @param p_stream Pointer to the stream
+ * @param index Index of the note
+ */
+static void _reposition(melody_stream_t *p_stream, uint32_t index)
+{
+    p_stream->first = index;
+    p_stream->tail = index;
+    p_stream->position = index;
+    _fill(p_stream, _room(p_stream));
+}
+
+/* Public functions -----------------------------------------------------------*/
+bool melody_stream_init(melody_stream_t *p_stream, melody_stream_read_t read, uint32_t device_size)
+{
+    memset(p_stream, 0, sizeof(melody_stream_t));
+    p_stream->read = read;
+    melody_bank_t header;
+    if ((read == NULL) || (device_size < sizeof(melody_bank_t)) || !read(0, &header, sizeof(melody_bank_t)))
+    {
+        return false;
+    }
+    if ((header.magic != MELODY_BANK_MAGIC) || (header.version != MELODY_BANK_VERSION) || (header.size > device_size) ||
+        (sizeof(melody_bank_t) + header.num_melodies * sizeof(melody_bank_entry_t) > header.size))
+    {
+        return false;
+    }
+    if ((header.hash_offset != 0) &&
+        ((header.hash_offset > header.size) || (header.hash_buckets == 0) ||
+         ((header.hash_buckets + header.num_melodies) * sizeof(uint16_t) > header.size - header.hash_offset)))
+    {
+        return false;
+    }
+    p_stream->num_melodies = header.num_melodies;
+    p_stream->size = header.size;
+    p_stream->hash_offset = header.hash_offset;
+    p_stream->hash_buckets = header.hash_buckets;
+    return true;
+}
+
+uint32_t melody_stream_get_length(const melody_stream_t *p_stream)
+{
+    return p_stream->num_melodies;
+}
+
+int32_t melody_stream_find(melody_stream_t *p_stream, const char *p_name)
+{
+    uint32_t first = 0;
+    uint32_t last = p_stream->num_melodies;
+    if ((p_stream->hash_offset != 0) && (last > 0))
+    {
+        // Only the entry of the slot of the name may have it
+        uint16_t displacement;
+        uint16_t index;
+        uint32_t bucket = melody_bank_hash(p_name, 0) % p_stream->hash_buckets;
+        if (!p_stream->read(p_stream->hash_offset + bucket * sizeof(uint16_t), &displacement, sizeof(uint16_t)))
+        {
+            return -1;
+        }
+        uint32_t slot = p_stream->hash_buckets + melody_bank_hash(p_name, displacement) % p_stream->num_melodies;
+        if (!p_stream->read(p_stream->hash_offset + slot * sizeof(uint16_t), &index, sizeof(uint16_t)))
+        {
+            return -1;
+        }
+        first = index;
+        last = (index < p_stream->num_melodies) ? index + 1U : index;
+    }
+    for (uint32_t index = first; index < last; index++)
+    {
+        melody_bank_entry_t entry;
+        char name[MELODY_STREAM_NAME_LENGTH];
+        uint32_t address = sizeof(melody_bank_t) + index * sizeof(melody_bank_entry_t);
+        if (!p_stream->read(address, &entry, sizeof(melody_bank_entry_t)) || (entry.name_offset >= p_stream->size))
+        {
+            return -1;
+        }
+        memset(name, 0, MELODY_STREAM_NAME_LENGTH);
+        if (!p_stream->read(entry.name_offset, name, MIN(MELODY_STREAM_NAME_LENGTH - 1U, p_stream->size - entry.name_offset)))
+        {
+            return -1;
+        }
+        if (strcmp(name, p_name) == 0)
+        {
+            return (int32_t)index;
+        }
+    }
+    return -1;
+}
+
+bool melody_stream_open(melody_stream_t *p_stream, uint32_t index, melody_t *p_melody)
+{
+    melody_bank_entry_t entry;
+    if ((index >= p_stream->num_melodies) ||
+        !p_stream->read(sizeof(melody_bank_t) + index * sizeof(melody_bank_entry_t), &entry, sizeof(melody_bank_entry_t)))
+    {
+        return false;
+    }
+    bool packed = (entry.flags & MELODY_BANK_FLAG_PACKED) != 0;
+    uint32_t payload_size = packed ? entry.packed_size : 2U * entry.melody_length;
+    if ((entry.name_offset >= p_stream->size) || (entry.notes_offset > p_stream->size) ||
+        (payload_size > p_stream->size - entry.notes_offset) || (packed && (payload_size > sizeof(p_stream->tokens))))
+    {
+        return false;
+    }
+    uint32_t entries = melody_bank_get_timeline_entries(entry.melody_length, entry.timeline_stride);
+    if ((entry.timeline_offset != 0) &&
+        ((entry.timeline_stride == 0) || (entry.timeline_offset > p_stream->size) ||
+         ((entries + 1U) * sizeof(uint32_t) > p_stream->size - entry.timeline_offset)))
+    {
+        return false;
+    }
+    uint32_t name_length = MIN(MELODY_STREAM_NAME_LENGTH - 1U, p_stream->size - entry.name_offset);
+    memset(p_stream->name, 0, MELODY_STREAM_NAME_LENGTH);
+    if (!p_stream->read(entry.name_offset, p_stream->name, name_length))
+    {
+        return false;
+    }
+    memset(p_melody, 0, sizeof(melody_t));
+    p_melody->p_name = p_stream->name;
+    p_melody->tick_ms = entry.tick_ms;
+    p_melody->melody_length = entry.melody_length;
+    if (packed)
+    {
+        // The tokens are decoded from RAM: the stream has no notes to read ahead, and the timeline walks the codec
+        p_stream->notes_address = 0;
+        p_stream->melody_length = 0;
+        p_stream->timeline_address = 0;
+        melody_stream_rewind(p_stream);
+        p_stream->reads++;
+        if (!p_stream->read(entry.notes_offset, p_stream->tokens, payload_size))
+        {
+            return false;
+        }
+        melody_codec_init(&p_stream->codec, p_stream->tokens, payload_size, entry.melody_length);
+        p_melody->p_codec = &p_stream->codec;
+        return true;
+    }
+    p_stream->notes_address = entry.notes_offset;
+    p_stream->melody_length = entry.melody_length;
+    p_stream->timeline_address = entry.timeline_offset;
+    melody_stream_rewind(p_stream);
+
+    p_melody->p_stream = p_stream;
+    p_melody->timeline_stride = (entry.timeline_offset != 0) ? entry.timeline_stride : 0;
+    return true;
+}
+
+bool melody_stream_read_timeline(melody_stream_t *p_stream, uint32_t *p_start_ms, uint32_t count)
+{
+    if ((p_stream->timeline_address == 0) || (count * sizeof(uint32_t) > p_stream->size - p_stream->timeline_address))
+    {
+        return false;
+    }
+    p_stream->reads++;
+    return p_stream->read(p_stream->timeline_address, p_start_ms, count * sizeof(uint32_t));
+}
+
+void melody_stream_rewind(melody_stream_t *p_stream)
+{
+    p_stream->underruns = 0;
+    p_stream->reads = 0;
+    _reposition(p_stream, 0);
+    while (_fill(p_stream, _room(p_stream)))
+    {
+    }
+}
+
+void melody_stream_refill(melody_stream_t *p_stream)
+{
+    _fill(p_stream, _room(p_stream));
+}
+
+bool melody_stream_get_note(melody_stream_t *p_stream, uint32_t index, uint8_t *p_midi_note, uint8_t *p_ticks)
+{
+    *p_midi_note = MIDI_SILENCE;
+    *p_ticks = 0;
+    if (!melody_stream_has_note(p_stream, index))
+    {
+        return false;
+    }
+    if (index > p_stream->position)
+    {
+        p_stream->position = index;
+    }
+    *p_midi_note = p_stream->midi_notes[index % MELODY_STREAM_RING_NOTES];
+    *p_ticks = p_stream->ticks[index % MELODY_STREAM_RING_NOTES];
+    return true;
+}
+
+bool melody_stream_has_note(const melody_stream_t *p_stream, uint32_t index)
+{
+    return (index < p_stream->melody_length) && (index >= p_stream->first) && (index < p_stream->tail);
+}
+
+bool melody_stream_fetch(melody_stream_t *p_stream, uint32_t index)
+{
+    if ((index >= p_stream->melody_length) || melody_stream_has_note(p_stream, index))
+    {
+        return index < p_stream->melody_length;
+    }
+    if (index == p_stream->tail)
+    {
+        // The player has caught up with the refill: read the next block now
+        p_stream->underruns++;
+        _fill(p_stream, MELODY_STREAM_RING_NOTES - MELODY_STREAM_HISTORY_NOTES);
+    }
+    else
+    {
+        _reposition(p_stream, index);
+    }
+    return melody_stream_has_note(p_stream, index);
+}
+
+bool melody_stream_read_notes(melody_stream_t *p_stream, uint32_t index, uint32_t count, uint8_t *p_midi_notes, uint8_t *p_ticks)
+{
+    if ((index > p_stream->melody_length) || (count > p_stream->melody_length - index))
+    {
+        return false;
+    }
+    p_stream->reads++;
+    return ((p_midi_notes == NULL) || p_stream->read(p_stream->notes_address + index, p_midi_notes, count)) &&
+           p_stream->read(p_stream->notes_address + p_stream->melody_length + index, p_ticks, count);
+}
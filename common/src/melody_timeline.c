@@ -0,0 +1,205 @@
+/**
+ * @file melody_timeline.c
+ * @brief Prefix-sum index of the durations of a melody.
+ * @author Javier de Ponte Hernando
+ * @author Roberto Maldonado Macafee
+ * @date 18/10/2026
+ */
+
+/* Includes ------------------------------------------------------------------*/
+/* Standard C includes */
+#include <stddef.h>
+#include <string.h>
+
+/* Other includes */
+#include "melody_timeline.h"
+#include "melody_stream.h"
+#include "melody_bank.h"
+
+/* Defines and enums ----------------------------------------------------------*/
+#define MIN(a, b) ((a) < (b) ? (a) : (b)) /*!< Macro to get the minimum of two values. */
+#define MELODY_TIMELINE_BLOCK_NOTES 32U   /*!< Durations of a melody read at a time */
+
+/* Private functions ----------------------------------------------------------*/
+/**
+ * @brief Get the length of the melody of a timeline.
+ *
+ * @param p_timeline Pointer to the timeline
+ * @return uint32_t Length of the melody, 0 if there is none
+ */
+static uint32_t _length(const melody_timeline_t *p_timeline)
+{
+    return (p_timeline->p_melody != NULL) ? p_timeline->p_melody->melody_length : 0;
+}
+
+/**
+ * @brief Get the durations of consecutive notes of the melody of a timeline, up to a block. The durations of a streamed
+ * melody are read from its device at once: the read-ahead ring belongs to the player, which may be reading it from an
+ * interrupt.
+ *
+ * @param p_timeline Pointer to the timeline
+ * @param index Index of the first note
+ * @param count Number of notes, up to MELODY_TIMELINE_BLOCK_NOTES and not past the end of the melody
+ * @param p_duration_ms Pointer to store the durations in ms
+ */
+static void _get_durations(const melody_timeline_t *p_timeline, uint32_t index, uint32_t count, uint32_t *p_duration_ms)
+{
+    const melody_t *p_melody = p_timeline->p_melody;
+    if (p_melody->p_stream != NULL)
+    {
+        uint8_t ticks[MELODY_TIMELINE_BLOCK_NOTES];
+        if (!melody_stream_read_notes(p_melody->p_stream, index, count, NULL, ticks))
+        {
+            memset(ticks, 0, count);
+        }
+        for (uint32_t i = 0; i < count; i++)
+        {
+            p_duration_ms[i] = ticks[i] * p_melody->tick_ms;
+        }
+        return;
+    }
+    for (uint32_t i = 0; i < count; i++)
+    {
+        p_duration_ms[i] = melody_get_duration_ms(p_melody, index + i);
+    }
+}
+
+/**
+ * @brief Get the time from the start of a note of the melody of a timeline to the start of a later one.
+ *
+ * @param p_timeline Pointer to the timeline
+ * @param first Index of the first note
+ * @param last Index of the later note, not past the end of the melody
+ * @return uint32_t Sum of the durations of the notes first to last - 1, in ms
+ */
+static uint32_t _sum_ms(const melody_timeline_t *p_timeline, uint32_t first, uint32_t last)
+{
+    uint32_t duration_ms[MELODY_TIMELINE_BLOCK_NOTES];
+    uint32_t time_ms = 0;
+    for (uint32_t index = first; index < last; index += MELODY_TIMELINE_BLOCK_NOTES)
+    {
+        uint32_t count = MIN(MELODY_TIMELINE_BLOCK_NOTES, last - index);
+        _get_durations(p_timeline, index, count, duration_ms);
+        for (uint32_t i = 0; i < count; i++)
+        {
+            time_ms += duration_ms[i];
+        }
+    }
+    return time_ms;
+}
+
+/**
+ * @brief Load the start times of the notes of the melody of a timeline precomputed by the bank builder: from the bank,
+ * or from the device of a streamed melody in one read. They are only used if they fit in the timeline.
+ *
+ * @param p_timeline Pointer to the timeline
+ * @param stride Smallest stride that fits the melody in the timeline
+ * @return true if the start times have been loaded
+ * @return false if the melody has none, or they do not fit
+ */
+static bool _load(melody_timeline_t *p_timeline, uint32_t stride)
+{
+    const melody_t *p_melody = p_timeline->p_melody;
+    if ((p_melody == NULL) || (p_melody->timeline_stride < stride))
+    {
+        return false;
+    }
+    uint32_t entries = melody_bank_get_timeline_entries(p_melody->melody_length, p_melody->timeline_stride);
+    if (p_melody->p_start_ms != NULL)
+    {
+        memcpy(p_timeline->start_ms, p_melody->p_start_ms, (entries + 1U) * sizeof(uint32_t));
+    }
+    else if ((p_melody->p_stream == NULL) || !melody_stream_read_timeline(p_melody->p_stream, p_timeline->start_ms, entries + 1U))
+    {
+        return false;
+    }
+    p_timeline->stride = p_melody->timeline_stride;
+    p_timeline->num_entries = (uint16_t)entries;
+    return true;
+}
+
+/* Public functions -----------------------------------------------------------*/
+void melody_timeline_build(melody_timeline_t *p_timeline, const melody_t *p_melody)
+{
+    p_timeline->p_melody = p_melody;
+    uint32_t length = _length(p_timeline);
+    uint32_t stride = (length + MELODY_TIMELINE_MAX_ENTRIES - 1U) / MELODY_TIMELINE_MAX_ENTRIES;
+    stride = (stride > 0) ? stride : 1U;
+    if (_load(p_timeline, stride))
+    {
+        return;
+    }
+    uint32_t time_ms = 0;
+    for (uint32_t i = 0; i < length; i += stride)
+    {
+        p_timeline->start_ms[i / stride] = time_ms;
+        time_ms += _sum_ms(p_timeline, i, MIN(i + stride, length));
+    }
+    p_timeline->stride = (uint16_t)stride;
+    p_timeline->num_entries = (uint16_t)((length + stride - 1U) / stride);
+    p_timeline->start_ms[p_timeline->num_entries] = time_ms;
+}
+
+uint32_t melody_timeline_get_total_ms(const melody_timeline_t *p_timeline)
+{
+    return p_timeline->start_ms[p_timeline->num_entries];
+}
+
+uint32_t melody_timeline_get_start_ms(const melody_timeline_t *p_timeline, uint32_t note_index)
+{
+    if (note_index >= _length(p_timeline))
+    {
+        return melody_timeline_get_total_ms(p_timeline);
+    }
+    uint32_t entry = note_index / p_timeline->stride;
+    return p_timeline->start_ms[entry] + _sum_ms(p_timeline, entry * p_timeline->stride, note_index);
+}
+
+uint32_t melody_timeline_find(const melody_timeline_t *p_timeline, uint32_t time_ms, uint32_t *p_offset_ms)
+{
+    uint32_t note_index = _length(p_timeline);
+    uint32_t start_ms = time_ms;
+    if (time_ms < melody_timeline_get_total_ms(p_timeline))
+    {
+        // Last entry that starts at or before the time: start_ms[low] <= time_ms < start_ms[high]
+        uint32_t low = 0;
+        uint32_t high = p_timeline->num_entries;
+        while (high - low > 1U)
+        {
+            uint32_t mid = (low + high) / 2U;
+            if (p_timeline->start_ms[mid] <= time_ms)
+            {
+                low = mid;
+            }
+            else
+            {
+                high = mid;
+            }
+        }
+        note_index = low * p_timeline->stride;
+        start_ms = p_timeline->start_ms[low];
+        // Within the entry: with a stride of 1 the note found already spans the time, and no duration is read
+        uint32_t duration_ms[MELODY_TIMELINE_BLOCK_NOTES];
+        uint32_t end = MIN(note_index + p_timeline->stride, _length(p_timeline));
+        while ((p_timeline->stride > 1U) && (note_index < end - 1U))
+        {
+            uint32_t count = MIN(MELODY_TIMELINE_BLOCK_NOTES, end - 1U - note_index);
+            uint32_t i = 0;
+            _get_durations(p_timeline, note_index, count, duration_ms);
+            while ((i < count) && (start_ms + duration_ms[i] <= time_ms))
+            {
+                start_ms += duration_ms[i++];
+            }
+            note_index += i;
+            if (i < count)
+            {
+                break;
+            }
+        }
+    }
+    if (p_offset_ms != NULL)
+    {
+        *p_offset_ms = time_ms - start_ms;
+    }
+    return note_index;
+}
@@ -0,0 +1,376 @@
+/**
+ * @file melody_upload.c
+ * @brief Incremental decoder of the melodies uploaded over the USART.
+ * @author Javier de Ponte Hernando
+ * @author Roberto Maldonado Macafee
+ * @date 18/10/2026
+ */
+
+/* Includes ------------------------------------------------------------------*/
+/* Standard C includes */
+#include <string.h>
+
+/* Other includes */
+#include "melody_upload.h"
+#include "note_table.h"
+
+/* Defines ------------------------------------------------------------------*/
+#define RTTTL_MS_PER_MINUTE_WHOLE 240000U /*!< Milliseconds of a whole note (4 beats) at 1 beat per minute */
+#define MAX(a, b) ((a) > (b) ? (a) : (b)) /*!< Macro to get the maximum of two values. */
+
+/* Private functions ----------------------------------------------------------*/
+/**
+ * @brief Move a note out of the note table by octaves into it.
+ *
+ * @param midi_note MIDI note number, or MIDI_SILENCE
+ * @return uint8_t MIDI note number in the note table, or MIDI_SILENCE
+ */
+static uint8_t _clamp_note(uint32_t midi_note)
+{
+    if (midi_note == MIDI_SILENCE)
+    {
+        return MIDI_SILENCE;
+    }
+    while (midi_note < NOTE_TABLE_MIDI_FIRST)
+    {
+        midi_note += 12U;
+    }
+    while (midi_note >= NOTE_TABLE_MIDI_FIRST + NOTE_TABLE_MIDI_LENGTH)
+    {
+        midi_note -= 12U;
+    }
+    return (uint8_t)midi_note;
+}
+
+/**
+ * @brief Parse the decimal number at a position of a token.
+ *
+ * @param p_text Pointer to the position, updated to the first character after the number
+ * @param p_value Pointer to store the number, not modified if there is none
+ * @return true if there is a number
+ * @return false otherwise
+ */
+static bool _parse_number(const char **p_text, uint32_t *p_value)
+{
+    const char *p = *p_text;
+    uint32_t value = 0;
+    while ((*p >= '0') && (*p <= '9') && (value < 10000U))
+    {
+        value = value * 10U + (uint32_t)(*p - '0');
+        p++;
+    }
+    if (p == *p_text)
+    {
+        return false;
+    }
+    *p_value = value;
+    *p_text = p;
+    return true;
+}
+
+/**
+ * @brief Check an RTTTL duration.
+ *
+ * @param duration RTTTL duration
+ * @return true if it is 1, 2, 4, 8, 16 or 32
+ * @return false otherwise
+ */
+static bool _rtttl_is_duration(uint32_t duration)
+{
+    return (duration > 0) && (duration <= 32U) && ((duration & (duration - 1U)) == 0);
+}
+
+/**
+ * @brief Choose the tick of an RTTTL melody for its tempo (see melody_upload.h).
+ *
+ * @param p_upload Pointer to the decoder
+ */
+static void _rtttl_set_tick(melody_upload_t *p_upload)
+{
+    uint32_t bpm = p_upload->bpm;
+    p_upload->ticks_per_whole = MELODY_UPLOAD_RTTTL_MAX_TICKS_PER_WHOLE;
+    for (uint32_t ticks = MELODY_UPLOAD_RTTTL_MAX_TICKS_PER_WHOLE; ticks >= MELODY_UPLOAD_RTTTL_MIN_TICKS_PER_WHOLE; ticks /= 2U)
+    {
+        if (RTTTL_MS_PER_MINUTE_WHOLE % (bpm * ticks) == 0)
+        {
+            p_upload->ticks_per_whole = (uint8_t)ticks;
+            break;
+        }
+    }
+    uint32_t tick_ms = (RTTTL_MS_PER_MINUTE_WHOLE + bpm * p_upload->ticks_per_whole / 2U) / (bpm * p_upload->ticks_per_whole);
+    p_upload->tick_ms = (uint16_t)MAX(tick_ms, 1U);
+}
+
+/**
+ * @brief Decode an RTTTL default (`d=4`, `o=5` or `b=120`).
+ *
+ * @param p_upload Pointer to the decoder
+ * @return true if the default is valid
+ * @return false otherwise
+ */
+static bool _rtttl_default(melody_upload_t *p_upload)
+{
+    const char *p = &p_upload->token[2];
+    uint32_t value;
+    if ((p_upload->token[1] != '=') || !_parse_number(&p, &value) || (*p != '\0'))
+    {
+        return false;
+    }
+    switch (p_upload->token[0])
+    {
+    case 'd':
+        p_upload->duration = (uint8_t)value;
+        return _rtttl_is_duration(value);
+    case 'o':
+        p_upload->octave = (uint8_t)value;
+        return value <= 9U;
+    case 'b':
+        p_upload->bpm = (uint16_t)value;
+        return (value > 0) && (value <= 900U);
+    default:
+        return false;
+    }
+}
+
+/**
+ * @brief Decode an RTTTL note (`[duration]note[#][.][octave][.]`) and store it in the pool.
+ *
+ * @param p_upload Pointer to the decoder
+ * @return true if the note is valid and has been stored
+ * @return false otherwise
+ */
+static bool _rtttl_note(melody_upload_t *p_upload)
+{
+    static const uint8_t semitones[] = {9, 11, 0, 2, 4, 5, 7}; /* a to g */
+    const char *p = p_upload->token;
+    uint32_t duration = p_upload->duration;
+    uint32_t octave = p_upload->octave;
+    uint32_t midi_note = MIDI_SILENCE;
+    _parse_number(&p, &duration);
+    if ((*p >= 'a') && (*p <= 'g'))
+    {
+        midi_note = semitones[*p - 'a'];
+    }
+    else if (*p == 'h')
+    {
+        midi_note = 11U;
+    }
+    else if (*p != 'p')
+    {
+        return false;
+    }
+    bool pause = (*p++ == 'p');
+    if (*p == '#')
+    {
+        midi_note++;
+        p++;
+    }
+    bool dotted = (*p == '.');
+    p += dotted;
+    if ((*p >= '0') && (*p <= '9'))
+    {
+        octave = (uint32_t)(*p++ - '0');
+    }
+    if (*p == '.')
+    {
+        dotted = true;
+        p++;
+    }
+    if ((*p != '\0') || !_rtttl_is_duration(duration))
+    {
+        return false;
+    }
+    uint32_t ticks = (dotted ? 3U * p_upload->ticks_per_whole / 2U : p_upload->ticks_per_whole) / duration;
+    ticks = MAX(ticks, 1U);
+    midi_note = pause ? MIDI_SILENCE : _clamp_note(12U * (octave + 1U) + midi_note);
+    return melody_pool_append(p_upload->p_pool, (uint8_t)midi_note, (uint8_t)ticks);
+}
+
+/**
+ * @brief Decode the RTTTL token received, ended by a separator.
+ *
+ * @param p_upload Pointer to the decoder
+ * @param separator ',' or ':'
+ * @return true if the token is valid
+ * @return false otherwise
+ */
+static bool _rtttl_token(melody_upload_t *p_upload, char separator)
+{
+    bool ok = true;
+    bool fits = (p_upload->token_length < MELODY_UPLOAD_TOKEN_LENGTH);
+    if (p_upload->state == MELODY_UPLOAD_RTTTL_DEFAULTS)
+    {
+        if (p_upload->token_has_equal)
+        {
+            ok = fits && _rtttl_default(p_upload);
+        }
+        else
+        {
+            // A token with no '=' is the name section, which is ignored
+            ok = (separator == ':') || (p_upload->token_length == 0);
+        }
+        if (separator == ':' && (p_upload->token_has_equal || (p_upload->token_length == 0)))
+        {
+            p_upload->state = MELODY_UPLOAD_RTTTL_NOTES;
+            _rtttl_set_tick(p_upload);
+        }
+    }
+    else if (p_upload->token_length > 0)
+    {
+        ok = fits && (separator == ',') && _rtttl_note(p_upload);
+    }
+    p_upload->token_length = 0;
+    p_upload->token_has_equal = false;
+    memset(p_upload->token, 0, sizeof(p_upload->token));
+    return ok;
+}
+
+/**
+ * @brief Decode a character of an RTTTL melody.
+ *
+ * @param p_upload Pointer to the decoder
+ * @param c Character
+ * @return true if the character is valid
+ * @return false otherwise
+ */
+static bool _rtttl_char(melody_upload_t *p_upload, char c)
+{
+    if ((c == ',') || (c == ':'))
+    {
+        return _rtttl_token(p_upload, c);
+    }
+    if ((c >= 'A') && (c <= 'Z'))
+    {
+        c = (char)(c - 'A' + 'a');
+    }
+    p_upload->token_has_equal |= (c == '=');
+    if (p_upload->token_length < MELODY_UPLOAD_TOKEN_LENGTH - 1U)
+    {
+        p_upload->token[p_upload->token_length] = c;
+    }
+    if (p_upload->token_length < UINT8_MAX)
+    {
+        p_upload->token_length++;
+    }
+    return true;
+}
+
+/**
+ * @brief Decode a character of a melody in hexadecimal form. Every two bytes (note, ticks) a note is stored.
+ *
+ * @param p_upload Pointer to the decoder
+ * @param c Character
+ * @return true if the character is valid
+ * @return false otherwise
+ */
+static bool _hex_char(melody_upload_t *p_upload, char c)
+{
+    uint32_t digit;
+    if ((c >= '0') && (c <= '9'))
+    {
+        digit = (uint32_t)(c - '0');
+    }
+    else if ((c >= 'a') && (c <= 'f'))
+    {
+        digit = (uint32_t)(c - 'a' + 10);
+    }
+    else if ((c >= 'A') && (c <= 'F'))
+    {
+        digit = (uint32_t)(c - 'A' + 10);
+    }
+    else
+    {
+        return c == ',';
+    }
+    p_upload->hex_pair = (uint16_t)((p_upload->hex_pair << 4) | digit);
+    if (++p_upload->hex_digits < 4U)
+    {
+        return true;
+    }
+    uint8_t midi_note = (uint8_t)(p_upload->hex_pair >> 8);
+    uint8_t ticks = (uint8_t)p_upload->hex_pair;
+    p_upload->hex_digits = 0;
+    p_upload->hex_pair = 0;
+    return (ticks > 0) && melody_pool_append(p_upload->p_pool, _clamp_note(midi_note), ticks);
+}
+
+/* Public functions -----------------------------------------------------------*/
+void melody_upload_init(melody_upload_t *p_upload, melody_pool_t *p_pool)
+{
+    memset(p_upload, 0, sizeof(melody_upload_t));
+    p_upload->p_pool = p_pool;
+}
+
+bool melody_upload_begin(melody_upload_t *p_upload, const char *p_name, uint16_t tick_ms)
+{
+    melody_pool_t *p_pool = p_upload->p_pool;
+    melody_upload_init(p_upload, p_pool);
+    if (!melody_pool_begin(p_pool, p_name))
+    {
+        return false;
+    }
+    // RTTTL defaults when the melody does not give them
+    p_upload->duration = 4;
+    p_upload->octave = 6;
+    p_upload->bpm = 63;
+    p_upload->tick_ms = tick_ms;
+    p_upload->state = (tick_ms > 0) ? MELODY_UPLOAD_HEX : MELODY_UPLOAD_RTTTL_DEFAULTS;
+    return true;
+}
+
+bool melody_upload_feed(melody_upload_t *p_upload, const char *p_data)
+{
+    if (p_upload->state == MELODY_UPLOAD_IDLE)
+    {
+        return false;
+    }
+    for (; *p_data != '\0'; p_data++)
+    {
+        char c = *p_data;
+        if ((c == ' ') || (c == '\t') || (c == '\r') || (c == '\n'))
+        {
+            continue;
+        }
+        bool ok = (p_upload->state == MELODY_UPLOAD_HEX) ? _hex_char(p_upload, c) : _rtttl_char(p_upload, c);
+        if (!ok)
+        {
+            melody_upload_abort(p_upload);
+            return false;
+        }
+    }
+    return true;
+}
+
+int32_t melody_upload_end(melody_upload_t *p_upload)
+{
+    bool ok = false;
+    if (p_upload->state == MELODY_UPLOAD_RTTTL_NOTES)
+    {
+        ok = _rtttl_token(p_upload, ',');
+    }
+    else if (p_upload->state == MELODY_UPLOAD_HEX)
+    {
+        ok = (p_upload->hex_digits == 0);
+    }
+    if (!ok)
+    {
+        melody_upload_abort(p_upload);
+        return -1;
+    }
+    p_upload->state = MELODY_UPLOAD_IDLE;
+    return melody_pool_commit(p_upload->p_pool, p_upload->tick_ms);
+}
+
+void melody_upload_abort(melody_upload_t *p_upload)
+{
+    if (p_upload->state != MELODY_UPLOAD_IDLE)
+    {
+        melody_pool_abort(p_upload->p_pool);
+    }
+    p_upload->state = MELODY_UPLOAD_IDLE;
+}
+
+bool melody_upload_is_active(const melody_upload_t *p_upload)
+{
+    return p_upload->state != MELODY_UPLOAD_IDLE;
+}
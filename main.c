@@ -38,6 +38,9 @@ int main(void)
     fsm_t *p_fsm_user_button = fsm_button_new(BUTTON_0_DEBOUNCE_TIME_MS, BUTTON_0_ID);
     fsm_t *p_fsm_usart = fsm_usart_new(USART_0_ID);
     fsm_t *p_fsm_buzzer = fsm_buzzer_new(BUZZER_0_ID);
+    fsm_buzzer_set_sequencer(p_fsm_buzzer, true);
+    fsm_buzzer_set_dma(p_fsm_buzzer, true);
+    fsm_buzzer_set_absolute_time(p_fsm_buzzer, true);
     fsm_t *p_fsm_jukebox = fsm_jukebox_new(p_fsm_user_button, ON_OFF_PRESS_TIME_MS, p_fsm_usart, p_fsm_buzzer, NEXT_SONG_BUTTON_TIME_MS);
 
     /* Infinite loop */
@@ -46,6 +49,7 @@ int main(void)
         fsm_fire(p_fsm_user_button);
         fsm_fire(p_fsm_usart);
         fsm_fire(p_fsm_buzzer);
+        fsm_buzzer_refill(p_fsm_buzzer);
         fsm_fire(p_fsm_jukebox);
 
     } // End of while(1)
@@ -0,0 +1,431 @@
+/**
+ * @file port_buzzer.h
+ * @brief Header for port_buzzer.c file (native platform).
+ * @author Javier de Ponte Hernando
+ * @author Roberto Maldonado Macafee
+ * @date 17/10/2026
+ */
+#ifndef PORT_BUZZER_H_
+#define PORT_BUZZER_H_
+
+/* Includes ------------------------------------------------------------------*/
+/* Standard C includes */
+#include <stdint.h>
+#include <stdbool.h>
+
+
+/* HW dependent includes */
+#include "port_system.h"
+
+/* Defines and enums ----------------------------------------------------------*/
+/* Defines */
+
+#define BUZZER_0_ID 0 /*!< Buzzer melody player identifier*/
+#define BUZZER_0_GPIO GPIOA /*!< Buzzer melody player GPIO port*/
+#define BUZZER_0_PIN 6  /*!< Buzzer melody player GPIO pin*/
+#define PORT_BUZZER_MAX_VOICES 4 /*!< Number of tone outputs of the buzzer melody player: voice 0 is the output of BUZZER_0_PIN*/
+#define BUZZER_VOICE_1_GPIO GPIOB /*!< GPIO port of voice 1 (TIM4 CH1)*/
+#define BUZZER_VOICE_1_PIN 6 /*!< GPIO pin of voice 1 (TIM4 CH1)*/
+#define BUZZER_VOICE_2_GPIO GPIOB /*!< GPIO port of voice 2 (TIM10 CH1)*/
+#define BUZZER_VOICE_2_PIN 8 /*!< GPIO pin of voice 2 (TIM10 CH1)*/
+#define BUZZER_VOICE_3_GPIO GPIOB /*!< GPIO port of voice 3 (TIM11 CH1)*/
+#define BUZZER_VOICE_3_PIN 9 /*!< GPIO pin of voice 3 (TIM11 CH1)*/
+#define BUZZER_PWM_DC 0.5 /*!< PWM duty cycle 0-1 */
+#define BUZZER_PWM_DC_Q8 ((uint32_t)(BUZZER_PWM_DC * 256.0 + 0.5)) /*!< PWM duty cycle in fixed point, Q0.8. Folded at build time */
+#define PORT_BUZZER_HZ_Q16(hz) ((uint32_t)((hz) * 65536.0 + 0.5)) /*!< Convert a frequency in Hz to Q16.16 fixed point. Folded at build time for constants */
+#define PORT_BUZZER_Q16_MIN_HZ 1.0 /*!< Lowest frequency the double API computes in fixed point: below it Q16.16 is too coarse for the prescaler */
+#define PORT_BUZZER_Q16_MAX_HZ 65536.0 /*!< Frequencies from this one on do not fit in Q16.16 and the double API computes them with doubles */
+#define PORT_BUZZER_DMA_MAX_NOTES 128 /*!< Maximum number of notes of a melody played by DMA */
+#define PORT_BUZZER_MIN_NOTE_TICKS 2U /*!< Shortest duration of a note in timer clock periods, for a note that starts after its scheduled end*/
+#define PORT_BUZZER_DMA_PWM_PSC 7 /*!< Prescaler of the timer that controls the frequency of the note in DMA playback. It is fixed, so the ARR of the lowest note (DO1) fits in 16 bits*/
+/* Typedefs --------------------------------------------------------------------*/
+/**
+ * @brief Structure to define the register values of the timers for a note, ready to be loaded. \n
+ * They are computed at build time by tools/compile_melodies.py, or at run time by port_buzzer_get_note_regs().
+ * 
+ */
+typedef struct
+{
+    uint16_t pwm_psc; /*!< Prescaler of the timer that controls the frequency of the note*/
+    uint16_t pwm_arr; /*!< Auto-reload value of the timer that controls the frequency of the note. 0 for a silence*/
+    uint16_t pwm_ccr; /*!< Capture/compare value of the timer that controls the frequency of the note*/
+    uint16_t duration_psc; /*!< Prescaler of the timer that controls the duration of the note*/
+    uint16_t duration_arr; /*!< Auto-reload value of the timer that controls the duration of the note*/
+} port_buzzer_note_regs_t;
+
+/**
+ * @brief Structure to define the statistics of the gaps between the end of a note and the start of the next one.
+ * 
+ */
+typedef struct
+{
+    uint32_t count; /*!< Number of gaps measured*/
+    uint32_t max_cycles; /*!< Longest gap in core clock cycles*/
+    uint64_t total_cycles; /*!< Sum of the gaps in core clock cycles*/
+} port_buzzer_gap_stats_t;
+
+/**
+ * @brief Function that provides the next note of a sequence to the ISR of the timer that controls the duration of the note.
+ * It runs in interrupt context.
+ * 
+ * @param p_arg Argument registered with the sequencer
+ * @param p_regs Pointer to store the register values of the next note
+ * @return true if there is a next note
+ * @return false if the sequence ends after the current note
+ */
+typedef bool (*port_buzzer_sequencer_t)(void *p_arg, port_buzzer_note_regs_t *p_regs);
+
+/**
+ * @brief Structure to define the HW dependencies of a buzzer melody player.
+ * 
+ */
+typedef struct 
+{
+    GPIO_TypeDef *p_port; /*!< GPIO where the buzzer melody player is connected*/
+    uint8_t pin; /*!< Pin/line where the buzzer melody player is connected*/
+    uint8_t alt_func; /*!<Alternate function value for PWM according to the Alternate function table of the datasheet */
+    bool note_end; /*!< Flag to indicate that the note has ended*/
+    bool next_staged; /*!< Flag to indicate that the next note is staged and starts when the current note ends*/
+    port_buzzer_note_regs_t next_regs; /*!< Register values of the staged note*/
+    bool gap_pending; /*!< Flag to indicate that a note has ended and the next one has not started yet*/
+    uint32_t note_end_cycles; /*!< Time of the end of the last note in core clock cycles*/
+    port_buzzer_gap_stats_t gap_stats; /*!< Statistics of the gaps between notes*/
+    port_buzzer_sequencer_t sequencer; /*!< Function that provides the next note from the ISR, or NULL*/
+    void *p_sequencer_arg; /*!< Argument of the sequencer*/
+    bool dma_busy; /*!< Flag to indicate that a melody is being played by DMA*/
+    uint32_t dma_length; /*!< Number of notes of the melody played by DMA*/
+    uint16_t note_psc; /*!< Prescaler active in the timer that controls the duration of the current note*/
+    uint16_t note_arr; /*!< Auto-reload value active in the timer that controls the duration of the current note*/
+    uint32_t schedule_origin_cycles; /*!< Time of the start of the melody in core clock cycles, shifted by the time it has been paused*/
+} port_buzzer_hw_t;
+
+/**
+ * @brief Structure to define the HW dependencies of a voice of the buzzer melody player: a PWM timer and its output.
+ * All the voices share the timer that controls the duration of the note.
+ * 
+ */
+typedef struct
+{
+    TIM_TypeDef *p_tim; /*!< Timer that controls the frequency of the voice. Its channel 1 drives the output*/
+    GPIO_TypeDef *p_port; /*!< GPIO of the output of the voice*/
+    uint8_t pin; /*!< Pin of the output of the voice*/
+    uint8_t alt_func; /*!< Alternate function value of the pin for the PWM of the timer*/
+} port_buzzer_voice_hw_t;
+
+/* Global variables */
+/**
+ * @brief Array of elements that represents the HW characteristics of the buzzers.
+ * 
+ */
+ extern port_buzzer_hw_t buzzers_arr[];
+
+/**
+ * @brief Array of elements that represents the HW characteristics of the voices of the buzzer.
+ * 
+ */
+ extern port_buzzer_voice_hw_t voices_arr[];
+
+/* Function prototypes and explanation -------------------------------------------------*/
+/**
+ * @brief 	Configure the HW specifications of a given buzzer melody player.
+ * 
+ * @param buzzer_id Buzzer melody player ID. This index is used to select the element of the buzzers_arr[] array
+ */
+void port_buzzer_init (uint32_t buzzer_id);
+
+/**
+ * @brief 	Set the duration of the timer that controls the duration of the note. 
+ * 
+ * @param buzzer_id Buzzer melody player ID. This index is used to select the element of the buzzers_arr[] array
+ * @param duration_ms Duration of the note in ms
+ */
+void port_buzzer_set_note_duration (uint32_t buzzer_id, uint32_t duration_ms);
+
+/**
+ * @brief 	Set the PWM frequency of the timer that controls the frequency of the note. 
+ * 
+ * @param buzzer_id Buzzer melody player ID. This index is used to select the element of the buzzers_arr[] array
+ * @param frequency_hz Frequency of the note in Hz
+ */
+void port_buzzer_set_note_frequency (uint32_t buzzer_id, double frequency_hz);
+
+/**
+ * @brief 	Set the time origin of the schedule of the melody: now is the given time of the schedule. \n
+ * It is called with 0 at the start of a melody, and with the time of the schedule of the next note on resume, so that the pauses are not accounted.
+ * 
+ * @param buzzer_id Buzzer melody player ID. This index is used to select the element of the buzzers_arr[] array
+ * @param elapsed_us Time of the schedule that corresponds to now, in us
+ */
+void port_buzzer_set_schedule_origin (uint32_t buzzer_id, uint32_t elapsed_us);
+
+/**
+ * @brief 	Restart the timer that controls the duration of the note so that the current note ends at an absolute time of the schedule of
+ * the melody, instead of a duration from now. The time the player has been late to start the note is compensated, so it is not propagated to the
+ * following notes. The schedule is relative to port_buzzer_set_schedule_origin() and must be less than 2^31 core clock cycles away from now.
+ * 
+ * @param buzzer_id Buzzer melody player ID. This index is used to select the element of the buzzers_arr[] array
+ * @param end_us Time of the end of the note from the start of the melody, in us
+ */
+void port_buzzer_set_note_end (uint32_t buzzer_id, uint32_t end_us);
+
+/**
+ * @brief 	Get the drift of the end of the last note, timestamped by port_buzzer_update_note() or port_buzzer_dma_end(), from its expected
+ * time in the schedule of the melody.
+ * 
+ * @param buzzer_id Buzzer melody player ID. This index is used to select the element of the buzzers_arr[] array
+ * @param end_us Expected time of the end of the last note from the start of the melody, in us
+ * @return int32_t Drift in us. Positive if the note has ended late
+ */
+int32_t port_buzzer_get_schedule_drift (uint32_t buzzer_id, uint32_t end_us);
+
+/**
+ * @brief 	Set the PWM frequency of the timer that controls the frequency of the note, given in fixed point. \n
+ * The registers are computed with integer arithmetic only, so no software floating point routines are needed. The frequency must be in Hz,
+ * Q16.16, e.g. PORT_BUZZER_HZ_Q16(LA4). 0 is a silence. port_buzzer_set_note_frequency() is kept for compatibility: it converts the
+ * frequency and calls the same code.
+ * 
+ * @param buzzer_id Buzzer melody player ID. This index is used to select the element of the buzzers_arr[] array
+ * @param frequency_q16 Frequency of the note in Hz, Q16.16
+ */
+void port_buzzer_set_note_frequency_q16 (uint32_t buzzer_id, uint32_t frequency_q16);
+
+/**
+ * @brief 	Start a note loading register values computed in advance into the timer that controls the frequency of the note and the timer that controls its duration. \n
+ * Same effect as port_buzzer_set_note_frequency() and port_buzzer_set_note_duration(), without any arithmetic.
+ * 
+ * @param buzzer_id Buzzer melody player ID. This index is used to select the element of the buzzers_arr[] array
+ * @param p_regs Pointer to the register values of the note
+ */
+void port_buzzer_set_note_regs (uint32_t buzzer_id, const port_buzzer_note_regs_t *p_regs);
+
+/**
+ * @brief 	Stage the next note while the current note plays, so that it starts on the update event that ends the current note. \n
+ * The duration of the next note is written into the preload registers of the timer that controls the duration of the note. The
+ * values of the timer that controls the frequency are loaded by port_buzzer_update_note() at that update event.
+ * 
+ * @param buzzer_id Buzzer melody player ID. This index is used to select the element of the buzzers_arr[] array
+ * @param p_regs Pointer to the register values of the next note
+ */
+void port_buzzer_set_next_note_regs (uint32_t buzzer_id, const port_buzzer_note_regs_t *p_regs);
+
+/**
+ * @brief 	Set the frequency of a voice of the buzzer, with no change in the duration of the note: the voice plays until the end of the note
+ * or until it is set again. A silence stops the voice. Voice 0 is the voice of port_buzzer_set_note_regs().
+ * 
+ * @param buzzer_id Buzzer melody player ID. This index is used to select the element of the buzzers_arr[] array
+ * @param voice Index of the voice, from 0 to PORT_BUZZER_MAX_VOICES - 1
+ * @param p_regs Pointer to the register values of the note. Only the values of the PWM timer are used
+ */
+void port_buzzer_set_voice_regs (uint32_t buzzer_id, uint32_t voice, const port_buzzer_note_regs_t *p_regs);
+
+/**
+ * @brief 	Start the timer that controls the duration of the note with precomputed register values, with no change in the frequency of
+ * any voice. Its end stops all the voices. \n
+ * port_buzzer_set_note_regs() is port_buzzer_set_voice_regs() on voice 0 followed by this function.
+ * 
+ * @param buzzer_id Buzzer melody player ID. This index is used to select the element of the buzzers_arr[] array
+ * @param p_regs Pointer to the register values of the note. Only the values of the duration timer are used
+ */
+void port_buzzer_start_note_duration (uint32_t buzzer_id, const port_buzzer_note_regs_t *p_regs);
+
+/**
+ * @brief 	Scale the rest of the duration of the note that is playing, in place: the remaining ticks of the timer that controls the duration
+ * of the note are multiplied by num/den and the timer is reprogrammed with them, with no update of the player. A staged note is kept.
+ * Used to change the speed of the player within a note.
+ * 
+ * @param buzzer_id Buzzer melody player ID. This index is used to select the element of the buzzers_arr[] array
+ * @param num Numerator of the factor applied to the rest of the note
+ * @param den Denominator of the factor applied to the rest of the note
+ * @return uint32_t Rest of the duration of the note after scaling it, in us. 0 if no note is playing or it has just ended
+ */
+uint32_t port_buzzer_rescale_note (uint32_t buzzer_id, uint32_t num, uint32_t den);
+
+/**
+ * @brief 	Get the time left of the note that is playing, read from the timer that controls the duration of the note with no change to it.
+ * It also applies to the notes played by DMA.
+ * 
+ * @param buzzer_id Buzzer melody player ID. This index is used to select the element of the buzzers_arr[] array
+ * @return uint32_t Time left of the note in us. 0 if no note is playing or it has just ended
+ */
+uint32_t port_buzzer_get_note_remaining_us (uint32_t buzzer_id);
+
+/**
+ * @brief 	Handle the update event of the timer that controls the duration of the note: set the note end flag, start the staged
+ * note, if any, and timestamp the end of the note. If a sequencer is registered, it stages the note that follows the one started.
+ * It must be called from the ISR of the timer.
+ * 
+ * @param buzzer_id Buzzer melody player ID. This index is used to select the element of the buzzers_arr[] array
+ */
+void port_buzzer_update_note (uint32_t buzzer_id);
+
+/**
+ * @brief 	Cancel the staged note, if it has not started yet.
+ * 
+ * @param buzzer_id Buzzer melody player ID. This index is used to select the element of the buzzers_arr[] array
+ * @return true if a staged note has been cancelled
+ * @return false otherwise
+ */
+bool port_buzzer_cancel_next_note (uint32_t buzzer_id);
+
+/**
+ * @brief 	Mask or unmask the interrupt of the timer that controls the duration of the note. \n
+ * While it is masked the ISR does not run, so the main loop can change the notes the sequencer reads. A note that ends meanwhile is
+ * handled when the interrupt is unmasked.
+ * 
+ * @param buzzer_id Buzzer melody player ID. This index is used to select the element of the buzzers_arr[] array
+ * @param enable true to unmask the interrupt, false to mask it
+ */
+void port_buzzer_set_note_interrupt (uint32_t buzzer_id, bool enable);
+
+/**
+ * @brief 	Register the function that provides the notes of a sequence from the ISR of the timer that controls the duration of the note. \n
+ * When a staged note starts, the ISR stages the next one provided by the sequencer. The note end flag is only set when a note ends with
+ * no staged note, i.e. at the end of the sequence.
+ * 
+ * @param buzzer_id Buzzer melody player ID. This index is used to select the element of the buzzers_arr[] array
+ * @param sequencer Function that provides the next note, or NULL to disable the sequencer
+ * @param p_arg Argument passed to the sequencer
+ */
+void port_buzzer_set_sequencer (uint32_t buzzer_id, port_buzzer_sequencer_t sequencer, void *p_arg);
+
+/**
+ * @brief 	Check if the staged note is still waiting for the end of the current note.
+ * 
+ * @param buzzer_id Buzzer melody player ID. This index is used to select the element of the buzzers_arr[] array
+ * @return true 
+ * @return false 
+ */
+bool port_buzzer_get_next_note_staged (uint32_t buzzer_id);
+
+/**
+ * @brief 	Compute the register values of a note, as port_buzzer_set_note_frequency() and port_buzzer_set_note_duration() do.
+ * 
+ * @param frequency_hz Frequency of the note in Hz. 0 for a silence
+ * @param duration_ms Duration of the note in ms
+ * @param p_regs Pointer to store the register values
+ */
+void port_buzzer_get_note_regs (double frequency_hz, uint32_t duration_ms, port_buzzer_note_regs_t *p_regs);
+
+/**
+ * @brief 	Compute the register values of a note in fixed point: frequency in Q16.16 and duration in us. Integer arithmetic only.
+ * 
+ * @param frequency_q16 Frequency of the note in Hz, Q16.16. 0 for a silence
+ * @param duration_us Duration of the note in us
+ * @param p_regs Pointer to store the register values
+ */
+void port_buzzer_get_note_regs_q16 (uint32_t frequency_q16, uint32_t duration_us, port_buzzer_note_regs_t *p_regs);
+
+/**
+ * @brief 	Compute the register values of the timer that controls the duration of a note, keeping the values of the timer that controls
+ * its frequency. Used to play a compiled note at another speed.
+ * 
+ * @param duration_us Duration of the note in us
+ * @param p_regs Pointer to store the register values
+ */
+void port_buzzer_get_duration_regs (uint32_t duration_us, port_buzzer_note_regs_t *p_regs);
+
+/**
+ * @brief 	Get the statistics of the gaps between the end of a note and the start of the next one.
+ * 
+ * @param buzzer_id Buzzer melody player ID. This index is used to select the element of the buzzers_arr[] array
+ * @param p_stats Pointer to store the statistics
+ */
+void port_buzzer_get_gap_stats (uint32_t buzzer_id, port_buzzer_gap_stats_t *p_stats);
+
+/**
+ * @brief 	Reset the statistics of the gaps between notes. A note that has already ended is not accounted.
+ * 
+ * @param buzzer_id Buzzer melody player ID. This index is used to select the element of the buzzers_arr[] array
+ */
+void port_buzzer_reset_gap_stats (uint32_t buzzer_id);
+
+/**
+ * @brief Retrieve the status of the note end flag.
+ * 
+ * @param buzzer_id Buzzer melody player ID. This index is used to select the element of the buzzers_arr[] array
+ * @return true 
+ * @return false 
+ */
+bool port_buzzer_get_note_timeout (uint32_t buzzer_id);
+
+/**
+ * @brief Reset the note end flag. \n
+ * Used when the next note has been started by the HW at the end of the current one, so the player does not have to start it.
+ * 
+ * @param buzzer_id Buzzer melody player ID. This index is used to select the element of the buzzers_arr[] array
+ */
+void port_buzzer_reset_note_timeout (uint32_t buzzer_id);
+
+/**
+ * @brief 	Load the register values of a note of a melody to play by DMA (see port_buzzer_dma_start()).
+ * 
+ * @param buzzer_id Buzzer melody player ID. This index is used to select the element of the buzzers_arr[] array
+ * @param index Index of the note from the start of the DMA playback
+ * @param p_regs Pointer to the register values of the note
+ * @return true if the note has been loaded
+ * @return false if the index is out of the DMA buffers
+ */
+bool port_buzzer_dma_load_note (uint32_t buzzer_id, uint32_t index, const port_buzzer_note_regs_t *p_regs);
+
+/**
+ * @brief 	Play the notes loaded with port_buzzer_dma_load_note() with no CPU involvement. 
+
+ * Each update event of the timer that controls the duration of the note requests a DMA burst that writes the duration of the note after
+ * the next one into its preload registers, and resets the timer that controls the frequency (reset slave mode on TRGO). Its trigger requests
+ * a DMA burst that writes the ARR and CCR1 of the next note, with no preload. The end of the transfer of the last note sets the note end flag.
+ * 
+ * @param buzzer_id Buzzer melody player ID. This index is used to select the element of the buzzers_arr[] array
+ * @param length Number of notes to play. From 1 to PORT_BUZZER_DMA_MAX_NOTES
+ */
+void port_buzzer_dma_start (uint32_t buzzer_id, uint32_t length);
+
+/**
+ * @brief 	Stop the DMA requests, and let the note that is playing go on as a note played note by note: its end sets the note end flag. \n
+ * The rest of the melody can then be played again by DMA from the next note, e.g. at another speed.
+ * 
+ * @param buzzer_id Buzzer melody player ID. This index is used to select the element of the buzzers_arr[] array
+ * @return uint32_t Index of the note that is playing from the start of the DMA playback
+ */
+uint32_t port_buzzer_dma_detach (uint32_t buzzer_id);
+
+/**
+ * @brief 	Stop the DMA playback and set the note end flag.
+ * 
+ * @param buzzer_id Buzzer melody player ID. This index is used to select the element of the buzzers_arr[] array
+ * @return uint32_t Index of the note that was playing, from the start of the DMA playback
+ */
+uint32_t port_buzzer_dma_stop (uint32_t buzzer_id);
+
+/**
+ * @brief 	Handle the end of the DMA playback: stop the timers and set the note end flag. It must be called from the ISR of the DMA stream.
+ * 
+ * @param buzzer_id Buzzer melody player ID. This index is used to select the element of the buzzers_arr[] array
+ */
+void port_buzzer_dma_end (uint32_t buzzer_id);
+
+/**
+ * @brief 	Check if a melody is being played by DMA.
+ * 
+ * @param buzzer_id Buzzer melody player ID. This index is used to select the element of the buzzers_arr[] array
+ * @return true 
+ * @return false 
+ */
+bool port_buzzer_get_dma_busy (uint32_t buzzer_id);
+
+/**
+ * @brief 	Get the note that is playing by DMA, with no change to the playback.
+ * 
+ * @param buzzer_id Buzzer melody player ID. This index is used to select the element of the buzzers_arr[] array
+ * @return uint32_t Index of the note that is playing from the start of the DMA playback. 0 if no melody is played by DMA
+ */
+uint32_t port_buzzer_get_dma_note (uint32_t buzzer_id);
+
+/**
+ * @brief 	Disable the PWM output of the timer that controls the frequency of the note and the timer that controls the duration of the note.
+ * 
+ * @param buzzer_id Buzzer melody player ID. This index is used to select the element of the buzzers_arr[] array
+ */
+void port_buzzer_stop (uint32_t buzzer_id); 
+
+
+#endif
\ No newline at end of file
@@ -0,0 +1,59 @@
+/**
+ * @file port_melody_bank.h
+ * @brief Header for port_melody_bank.c file (native platform).
+ * @author Javier de Ponte Hernando
+ * @author Roberto Maldonado Macafee
+ * @date 18/10/2026
+ */
+#ifndef PORT_MELODY_BANK_H_
+#define PORT_MELODY_BANK_H_
+
+/* Includes ------------------------------------------------------------------*/
+/* Standard C includes */
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Defines and enums ----------------------------------------------------------*/
+#define NATIVE_MELODY_BANK_ENV "JUKEBOX_MELODY_BANK" /*!< Environment variable with the path of the melody bank file */
+#define NATIVE_MELODY_BANK_UPDATE_ENV "JUKEBOX_MELODY_BANK_UPDATE" /*!< Environment variable with the path of the bank file programmed into a slot. By default, the bank of NATIVE_MELODY_BANK_ENV or the bank built */
+#define PORT_MELODY_BANK_NUM_SLOTS 2U /*!< Slots of the double buffer to load a new melody bank while the jukebox runs */
+#define PORT_MELODY_BANK_SLOT_SIZE 0x20000U /*!< Size of a slot in bytes: a 128 KB sector, as on the board */
+
+/* Function prototypes and explanation -------------------------------------------------*/
+/**
+ * @brief Get the image of the melody bank of the jukebox. \n
+ * The file named by NATIVE_MELODY_BANK_ENV, or else the bank built with the project, is mapped read-only in memory the first time and
+ * read in place. If it cannot be mapped, the copy of the bank linked in the executable is used.
+ *
+ * @param p_size Pointer to store the size of the image in bytes
+ * @return const void* Pointer to the image, 4-byte aligned
+ */
+const void *port_melody_bank_get(uint32_t *p_size);
+
+/**
+ * @brief Get the image of a slot of the double buffer of the melody bank. \n
+ * The slots simulate the data sectors of the board: the file named by NATIVE_MELODY_BANK_UPDATE_ENV is programmed into
+ * the slot on each call, as if the sector had just been reflashed. If it cannot be read the slot is left erased (0xFF).
+ * The image returned must be validated with melody_bank_open().
+ *
+ * @param slot Index of the slot, less than PORT_MELODY_BANK_NUM_SLOTS
+ * @param p_size Pointer to store the size of the slot in bytes
+ * @return const void* Pointer to the image, 4-byte aligned, or NULL if the slot does not exist
+ */
+const void *port_melody_bank_get_slot(uint32_t slot, uint32_t *p_size);
+
+/**
+ * @brief Check if the melody bank is a file mapped in memory.
+ *
+ * @return true if the bank is mapped from a file
+ * @return false if the bank linked in the executable is used, or the bank has not been requested yet
+ */
+bool port_melody_bank_sim_is_mapped(void);
+
+/**
+ * @brief Unmap the melody bank file, if any. The next call to port_melody_bank_get() maps it again.
+ *
+ */
+void port_melody_bank_sim_unmap(void);
+
+#endif /* PORT_MELODY_BANK_H_ */
@@ -0,0 +1,46 @@
+/**
+ * @file port_storage.h
+ * @brief Header for port_storage.c file (native platform).
+ * @author Javier de Ponte Hernando
+ * @author Roberto Maldonado Macafee
+ * @date 18/10/2026
+ */
+#ifndef PORT_STORAGE_H_
+#define PORT_STORAGE_H_
+
+/* Includes ------------------------------------------------------------------*/
+/* Standard C includes */
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Defines and enums ----------------------------------------------------------*/
+#define NATIVE_STORAGE_ENV "JUKEBOX_STORAGE" /*!< Environment variable with the path of the file that stands in for the storage device */
+
+/* Function prototypes and explanation -------------------------------------------------*/
+/**
+ * @brief Initialize the storage device that holds the library of streamed melodies. \n
+ * The device is the file named by NATIVE_STORAGE_ENV. With no file there is no device.
+ *
+ * @return uint32_t Size of the device in bytes, 0 if there is none
+ */
+uint32_t port_storage_init(void);
+
+/**
+ * @brief Read data from the storage device.
+ *
+ * @param address Address of the data in the device
+ * @param p_data Pointer to store the data
+ * @param size Number of bytes to read
+ * @return true if the data has been read
+ * @return false if there is no device or the data is not within it
+ */
+bool port_storage_read(uint32_t address, void *p_data, uint32_t size);
+
+/**
+ * @brief Get the number of reads of the storage device since it was initialized.
+ *
+ * @return uint32_t Number of reads
+ */
+uint32_t port_storage_sim_get_reads(void);
+
+#endif /* PORT_STORAGE_H_ */
@@ -0,0 +1,594 @@
+/**
+ * @file port_system.h
+ * @brief Header for port_system.c file (native platform).
+ *
+ * The native platform runs the whole jukebox as a regular Linux process. The peripherals used by the
+ * project (GPIO, EXTI, TIM and USART) are replaced by plain C structs with the same register names as
+ * the CMSIS definitions ("register stand-ins"), so the port code can be written as it is on the board.
+ * The DMA1 streams requested by TIM2 (update) and TIM3 (trigger) are simulated too, with the DMA burst
+ * access of the timers (DCR/DMAR) and the reset slave mode of TIM3 on the TRGO of TIM2.
+ * A simulation kernel in `port_system.c` owns a virtual clock and moves the stand-ins forward in time.
+ * It raises the same ISRs of `interr.c` as the real hardware would.
+ *
+ * Time never comes from the host clock. Whenever the program waits (low power mode, busy waiting for a
+ * note to end, delays), the virtual clock jumps straight to the next pending timer expiry or stimulus.
+ * This way hours of melodies are played in a few seconds.
+ *
+ * @author Javier de Ponte Hernando
+ * @author Roberto Maldonado Macafee
+ * @date 17/10/2026
+ */
+
+#ifndef PORT_SYSTEM_H_
+#define PORT_SYSTEM_H_
+
+/* Includes ------------------------------------------------------------------*/
+/* Standard C includes */
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Defines and enums ----------------------------------------------------------*/
+/* Defines */
+#define BIT_POS_TO_MASK(x) (0x01 << (x))                                                                /*!< Convert the index of a bit into a mask by left shifting */
+#define BASE_MASK_TO_POS(m, p) ((m) << (p))                                                             /*!< Move a mask defined in the LSBs to upper positions by shifting left p bits */
+#define GET_PIN_IRQN(pin) (pin >= 10 ? EXTI15_10_IRQn : (pin >= 5 ? EXTI9_5_IRQn : (EXTI0_IRQn + pin))) /*!< Compute the IRQ number associated to a GPIO pin */
+
+/* Simulated microcontroller */
+#define HSI_VALUE ((uint32_t)16000000)   /*!< Value of the simulated internal oscillator in Hz. Same as the STM32F446RE */
+#define TICK_FREQ_1KHZ 1U                /*!< Freqency in kHz of the System tick */
+#define NATIVE_SIM_POLL_CYCLES 100U      /*!< Default number of core cycles consumed by each poll of a port status function */
+#define NATIVE_SIM_MAX_EVENTS 16U        /*!< Maximum number of scheduled stimuli pending at the same time */
+#define NATIVE_SIM_SCRIPT_ENV "JUKEBOX_SIM_SCRIPT" /*!< Environment variable with the path of the stimuli script */
+
+/* GPIOs */
+#define HIGH true /*!< Logic 1 */
+#define LOW false /*!< Logic 0 */
+
+#define GPIO_MODE_IN 0x00        /*!< GPIO as input */
+#define GPIO_MODE_OUT 0x01       /*!< GPIO as output */
+#define GPIO_MODE_ALTERNATE 0x02 /*!< GPIO as alternate function */
+#define GPIO_MODE_ANALOG 0x03    /*!< GPIO as analog */
+
+#define GPIO_PUPDR_NOPULL 0x00 /*!< GPIO no pull up or down */
+#define GPIO_PUPDR_PUP 0x01    /*!< GPIO pull up */
+#define GPIO_PUPDR_PDOWN 0x02  /*!< GPIO pull down */
+
+/* Interruption */
+#define TRIGGER_RISING_EDGE 0x01U                                      /*!< Interrupt mask for detecting rising edge */
+#define TRIGGER_FALLING_EDGE 0x02U                                     /*!< Interrupt mask for detecting falling edge */
+#define TRIGGER_BOTH_EDGE (TRIGGER_RISING_EDGE | TRIGGER_FALLING_EDGE) /*!< Interrupt mask for detecting both rising and falling edges */
+#define TRIGGER_ENABLE_EVENT_REQ 0x04U                                 /*!< Interrupt mask to enable event requests */
+#define TRIGGER_ENABLE_INTERR_REQ 0x08U                                /*!< Interrupt mask to enable interrupt request */
+
+/* Register stand-ins: bit definitions (same values as CMSIS) */
+#define GPIO_MODER_MODER0 0x3U      /*!< Mode bits of pin 0 */
+#define GPIO_PUPDR_PUPD0 0x3U       /*!< Pull-up/pull-down bits of pin 0 */
+#define TIM_CR1_CEN 0x0001U         /*!< Counter enable */
+#define TIM_CR1_URS 0x0004U         /*!< Update request source: only overflows set the update flag */
+#define TIM_CR1_ARPE 0x0080U        /*!< Auto-reload preload enable */
+#define TIM_DIER_UIE 0x0001U        /*!< Update interrupt enable */
+#define TIM_CR2_MMS 0x0070U         /*!< Master mode selection */
+#define TIM_CR2_MMS_1 0x0020U       /*!< Master mode selection, bit 1 (010: update event as TRGO) */
+#define TIM_SMCR_SMS 0x0007U        /*!< Slave mode selection */
+#define TIM_SMCR_SMS_2 0x0004U      /*!< Slave mode selection, bit 2 (100: reset mode) */
+#define TIM_SMCR_TS 0x0070U         /*!< Trigger selection */
+#define TIM_SMCR_TS_0 0x0010U       /*!< Trigger selection, bit 0 (001: internal trigger 1) */
+#define TIM_DIER_UDE 0x0100U        /*!< Update DMA request enable */
+#define TIM_DIER_TDE 0x4000U        /*!< Trigger DMA request enable */
+#define TIM_SR_TIF 0x0040U          /*!< Trigger interrupt flag */
+#define TIM_DCR_DBA_Pos 0U          /*!< Position of the DMA base address */
+#define TIM_DCR_DBA 0x001FU         /*!< DMA base address (offset of the first register of a burst, in words) */
+#define TIM_DCR_DBL_Pos 8U          /*!< Position of the DMA burst length */
+#define TIM_DCR_DBL 0x1F00U         /*!< DMA burst length (number of transfers minus 1) */
+#define TIM_SR_UIF 0x0001U          /*!< Update interrupt flag */
+#define TIM_EGR_UG 0x0001U          /*!< Update generation */
+#define TIM_CCMR1_OC1PE 0x0008U     /*!< Output compare 1 preload enable */
+#define TIM_CCMR1_OC1M_1 0x0020U    /*!< Output compare 1 mode, bit 1 */
+#define TIM_CCMR1_OC1M_2 0x0040U    /*!< Output compare 1 mode, bit 2 */
+#define TIM_CCER_CC1E 0x0001U       /*!< Capture/compare 1 output enable */
+#define USART_SR_RXNE 0x0020U       /*!< Read data register not empty */
+#define USART_SR_TC 0x0040U         /*!< Transmission complete */
+#define USART_SR_TXE 0x0080U        /*!< Transmit data register empty */
+#define USART_CR1_RE 0x0004U        /*!< Receiver enable */
+#define USART_CR1_TE 0x0008U        /*!< Transmitter enable */
+#define USART_CR1_RXNEIE 0x0020U    /*!< RXNE interrupt enable */
+#define USART_CR1_TCIE 0x0040U      /*!< Transmission complete interrupt enable */
+#define USART_CR1_TXEIE 0x0080U     /*!< TXE interrupt enable */
+#define USART_CR1_UE 0x2000U        /*!< USART enable */
+#define DMA_SxCR_EN 0x00000001U     /*!< Stream enable */
+#define DMA_SxCR_TCIE 0x00000010U   /*!< Transfer complete interrupt enable */
+#define DMA_SxCR_DIR_0 0x00000040U  /*!< Data transfer direction, bit 0 (01: memory to peripheral) */
+#define DMA_SxCR_MINC 0x00000400U   /*!< Memory increment mode */
+#define DMA_SxCR_PSIZE_1 0x00001000U /*!< Peripheral data size, bit 1 (10: word) */
+#define DMA_SxCR_MSIZE_1 0x00004000U /*!< Memory data size, bit 1 (10: word) */
+#define DMA_SxCR_CHSEL_Pos 25U      /*!< Position of the channel selection */
+#define DMA_SxCR_CHSEL 0x0E000000U  /*!< Channel selection */
+#define DMA_LISR_TCIF1 0x00000800U  /*!< Stream 1 transfer complete flag */
+#define DMA_LIFCR_CTCIF1 0x00000800U /*!< Stream 1 clear transfer complete flag */
+#define DMA_HISR_TCIF4 0x00000020U  /*!< Stream 4 transfer complete flag */
+#define DMA_HIFCR_CTCIF4 0x00000020U /*!< Stream 4 clear transfer complete flag */
+
+/* Enums */
+/**
+ * @brief Interrupt numbers of the simulated peripherals (same values as CMSIS for the STM32F446RE).
+ *
+ */
+typedef enum
+{
+  SysTick_IRQn = -1,     /*!< System tick interrupt */
+  EXTI0_IRQn = 6,        /*!< EXTI line 0 interrupt */
+  DMA1_Stream1_IRQn = 12, /*!< DMA1 stream 1 global interrupt */
+  DMA1_Stream4_IRQn = 15, /*!< DMA1 stream 4 global interrupt */
+  EXTI9_5_IRQn = 23,     /*!< EXTI lines 5 to 9 interrupt */
+  TIM1_UP_TIM10_IRQn = 25, /*!< TIM1 update and TIM10 global interrupt */
+  TIM1_TRG_COM_TIM11_IRQn = 26, /*!< TIM1 trigger and commutation and TIM11 global interrupt */
+  TIM2_IRQn = 28,        /*!< TIM2 global interrupt */
+  TIM3_IRQn = 29,        /*!< TIM3 global interrupt */
+  TIM4_IRQn = 30,        /*!< TIM4 global interrupt */
+  USART3_IRQn = 39,      /*!< USART3 global interrupt */
+  EXTI15_10_IRQn = 40,   /*!< EXTI lines 10 to 15 interrupt */
+  NATIVE_IRQN_COUNT = 96 /*!< Number of interrupt lines of the simulated NVIC */
+} IRQn_Type;
+
+/* Typedefs --------------------------------------------------------------------*/
+/**
+ * @brief Stand-in of a GPIO port. Same register names as the CMSIS `GPIO_TypeDef`.
+ *
+ */
+typedef struct
+{
+  volatile uint32_t MODER;   /*!< Port mode register */
+  volatile uint32_t OTYPER;  /*!< Port output type register */
+  volatile uint32_t OSPEEDR; /*!< Port output speed register */
+  volatile uint32_t PUPDR;   /*!< Port pull-up/pull-down register */
+  volatile uint32_t IDR;     /*!< Port input data register */
+  volatile uint32_t ODR;     /*!< Port output data register */
+  volatile uint32_t BSRR;    /*!< Port bit set/reset register */
+  volatile uint32_t LCKR;    /*!< Port configuration lock register */
+  volatile uint32_t AFR[2];  /*!< Alternate function registers (low and high) */
+} GPIO_TypeDef;
+
+/**
+ * @brief Stand-in of the external interrupt controller. Same register names as the CMSIS `EXTI_TypeDef`.
+ *
+ */
+typedef struct
+{
+  volatile uint32_t IMR;   /*!< Interrupt mask register */
+  volatile uint32_t EMR;   /*!< Event mask register */
+  volatile uint32_t RTSR;  /*!< Rising trigger selection register */
+  volatile uint32_t FTSR;  /*!< Falling trigger selection register */
+  volatile uint32_t SWIER; /*!< Software interrupt event register */
+  volatile uint32_t PR;    /*!< Pending register */
+} EXTI_TypeDef;
+
+/**
+ * @brief Stand-in of a general purpose timer. Same register names and order as the CMSIS `TIM_TypeDef`.
+ *
+ * The simulation kernel models the counter, the prescaler, the update event and the preload (shadow)
+ * registers of PSC, ARR (when `TIM_CR1_ARPE` is set) and CCR1 (when `TIM_CCMR1_OC1PE` is set). The update
+ * event is output as TRGO when `TIM_CR2_MMS_1` is selected, and it resets the slave timer in reset mode. The
+ * update (`TIM_DIER_UDE`) and trigger (`TIM_DIER_TDE`) DMA requests are served by the DMA1 stand-in.
+ */
+typedef struct
+{
+  volatile uint32_t CR1;   /*!< Control register 1 */
+  volatile uint32_t CR2;   /*!< Control register 2 */
+  volatile uint32_t SMCR;  /*!< Slave mode control register */
+  volatile uint32_t DIER;  /*!< DMA/interrupt enable register */
+  volatile uint32_t SR;    /*!< Status register */
+  volatile uint32_t EGR;   /*!< Event generation register */
+  volatile uint32_t CCMR1; /*!< Capture/compare mode register 1 */
+  volatile uint32_t CCMR2; /*!< Capture/compare mode register 2 */
+  volatile uint32_t CCER;  /*!< Capture/compare enable register */
+  volatile uint32_t CNT;   /*!< Counter */
+  volatile uint32_t PSC;   /*!< Prescaler */
+  volatile uint32_t ARR;   /*!< Auto-reload register */
+  volatile uint32_t RCR;   /*!< Repetition counter register */
+  volatile uint32_t CCR1;  /*!< Capture/compare register 1 */
+  volatile uint32_t CCR2;  /*!< Capture/compare register 2 */
+  volatile uint32_t CCR3;  /*!< Capture/compare register 3 */
+  volatile uint32_t CCR4;  /*!< Capture/compare register 4 */
+  volatile uint32_t BDTR;  /*!< Break and dead-time register */
+  volatile uint32_t DCR;   /*!< DMA control register */
+  volatile uint32_t DMAR;  /*!< DMA address for full transfer */
+} TIM_TypeDef;
+
+/**
+ * @brief Stand-in of a USART. Same register names as the CMSIS `USART_TypeDef`.
+ *
+ * `DR` only holds received data. Transmitted data is handed to the simulation by the port (see `port_usart.c`).
+ */
+typedef struct
+{
+  volatile uint32_t SR;   /*!< Status register */
+  volatile uint32_t DR;   /*!< Data register (reception) */
+  volatile uint32_t BRR;  /*!< Baud rate register */
+  volatile uint32_t CR1;  /*!< Control register 1 */
+  volatile uint32_t CR2;  /*!< Control register 2 */
+  volatile uint32_t CR3;  /*!< Control register 3 */
+  volatile uint32_t GTPR; /*!< Guard time and prescaler register */
+} USART_TypeDef;
+
+/**
+ * @brief Stand-in of a DMA stream. Same register names as the CMSIS `DMA_Stream_TypeDef`.
+ *
+ * The address registers are as wide as a host pointer. Only memory to peripheral transfers with memory increment
+ * are simulated, one word per request (or a whole burst when the peripheral address is the DMAR of the timer that
+ * requests the transfer).
+ */
+typedef struct
+{
+  volatile uint32_t CR;    /*!< Configuration register */
+  volatile uint32_t NDTR;  /*!< Number of data items to transfer */
+  volatile uintptr_t PAR;  /*!< Peripheral address */
+  volatile uintptr_t M0AR; /*!< Memory 0 address */
+  volatile uintptr_t M1AR; /*!< Memory 1 address */
+  volatile uint32_t FCR;   /*!< FIFO control register */
+} DMA_Stream_TypeDef;
+
+/**
+ * @brief Stand-in of a DMA controller. Same register names as the CMSIS `DMA_TypeDef`.
+ *
+ */
+typedef struct
+{
+  volatile uint32_t LISR;  /*!< Low interrupt status register (streams 0 to 3) */
+  volatile uint32_t HISR;  /*!< High interrupt status register (streams 4 to 7) */
+  volatile uint32_t LIFCR; /*!< Low interrupt flag clear register */
+  volatile uint32_t HIFCR; /*!< High interrupt flag clear register */
+} DMA_TypeDef;
+
+/**
+ * @brief Callback of a scheduled stimulus. It runs in "interrupt context" at the scheduled virtual time.
+ *
+ */
+typedef void (*port_system_sim_callback_t)(uint32_t arg);
+
+/* Global variables */
+extern uint32_t SystemCoreClock;   /*!< Frequency of the simulated system clock */
+extern GPIO_TypeDef native_gpioa;  /*!< Stand-in of GPIOA */
+extern GPIO_TypeDef native_gpiob;  /*!< Stand-in of GPIOB */
+extern GPIO_TypeDef native_gpioc;  /*!< Stand-in of GPIOC */
+extern EXTI_TypeDef native_exti;   /*!< Stand-in of EXTI */
+extern TIM_TypeDef native_tim2;    /*!< Stand-in of TIM2 */
+extern TIM_TypeDef native_tim3;    /*!< Stand-in of TIM3 */
+extern TIM_TypeDef native_tim4;    /*!< Stand-in of TIM4 */
+extern TIM_TypeDef native_tim10;   /*!< Stand-in of TIM10 */
+extern TIM_TypeDef native_tim11;   /*!< Stand-in of TIM11 */
+extern USART_TypeDef native_usart3; /*!< Stand-in of USART3 */
+extern DMA_TypeDef native_dma1;    /*!< Stand-in of DMA1 */
+extern DMA_Stream_TypeDef native_dma1_stream1; /*!< Stand-in of DMA1 stream 1 (TIM2_UP on channel 3) */
+extern DMA_Stream_TypeDef native_dma1_stream4; /*!< Stand-in of DMA1 stream 4 (TIM3_TRIG on channel 5) */
+
+#define GPIOA (&native_gpioa)   /*!< GPIOA stand-in */
+#define GPIOB (&native_gpiob)   /*!< GPIOB stand-in */
+#define GPIOC (&native_gpioc)   /*!< GPIOC stand-in */
+#define EXTI (&native_exti)     /*!< EXTI stand-in */
+#define TIM2 (&native_tim2)     /*!< TIM2 stand-in */
+#define TIM3 (&native_tim3)     /*!< TIM3 stand-in */
+#define TIM4 (&native_tim4)     /*!< TIM4 stand-in */
+#define TIM10 (&native_tim10)   /*!< TIM10 stand-in */
+#define TIM11 (&native_tim11)   /*!< TIM11 stand-in */
+#define USART3 (&native_usart3) /*!< USART3 stand-in */
+#define DMA1 (&native_dma1)     /*!< DMA1 stand-in */
+#define DMA1_Stream1 (&native_dma1_stream1) /*!< DMA1 stream 1 stand-in */
+#define DMA1_Stream4 (&native_dma1_stream4) /*!< DMA1 stream 4 stand-in */
+
+/* Function prototypes and explanation -------------------------------------------------*/
+
+/**
+ * @brief Reset the simulation (virtual clock, register stand-ins and pending stimuli) and configure the
+ * simulated system clock. If the environment variable `JUKEBOX_SIM_SCRIPT` holds the path of a stimuli
+ * script, it is scheduled to run at time 0 (see `port_system_sim_run_script()`).
+ *
+ * @retval Init status
+ */
+size_t port_system_init(void);
+
+/**
+ * @brief Get the count of the System tick in milliseconds
+ *
+ * @return uint32_t
+ */
+uint32_t port_system_get_millis();
+
+/**
+ * @brief Sets the number of milliseconds since the system started.
+ *
+ * @param ms New number of milliseconds since the system started.
+ */
+void port_system_set_millis(uint32_t ms);
+
+/**
+ * @brief Wait for some milliseconds. The virtual clock jumps forward, running every stimulus and ISR on the way.
+ *
+ * @param ms Number of milliseconds to wait
+ *
+ * @retval None
+ */
+void port_system_delay_ms(uint32_t ms);
+
+/**
+ * @brief Wait for some milliseconds from a time reference.
+ *
+ * @note It also updates the time reference to the system time at return.
+ *
+ * @param p_t Pointer to the time reference
+ * @param ms Number of milliseconds to wait
+ *
+ * @retval None
+ */
+void port_system_delay_until_ms(uint32_t *p_t, uint32_t ms);
+
+/**
+ * @brief Configure the mode and pull of a GPIO stand-in
+ *
+ * @param p_port Port of the GPIO (CMSIS struct like)
+ * @param pin Pin/line of the GPIO (index from 0 to 15)
+ * @param mode Input, output, alternate, or analog
+ * @param pupd Pull-up, pull-down, or no-pull
+ *
+ * @retval None
+ */
+void port_system_gpio_config(GPIO_TypeDef *p_port, uint8_t pin, uint8_t mode, uint8_t pupd);
+
+/**
+ * @brief Configure the alternate function of a GPIO stand-in
+ *
+ * @param p_port Port of the GPIO (CMSIS struct like)
+ * @param pin Pin/line of the GPIO (index from 0 to 15)
+ * @param alternate Alternate function number (values from 0 to 15)
+ *
+ * @retval None
+ */
+void port_system_gpio_config_alternate(GPIO_TypeDef *p_port, uint8_t pin, uint8_t alternate);
+
+/**
+ * @brief Configure the external interruption or event of a GPIO
+ * @param p_port Port of the GPIO (CMSIS struct like)
+ * @param pin Pin/line of the GPIO (index from 0 to 15)
+ * @param mode Trigger mode can be a combination (OR) of: (i) direction: rising edge (0x01), falling edge (0x02), (ii)  event request (0x04), or (iii) interrupt request (0x08).
+ * @retval None
+ */
+void port_system_gpio_config_exti(GPIO_TypeDef *p_port, uint8_t pin, uint32_t mode);
+
+/**
+ * @brief Enable interrupts of a GPIO line (pin)
+ *
+ * @param pin Pin/line of the GPIO (index from 0 to 15)
+ * @param priority Priority level (from highest priority: 0, to lowest priority: 15)
+ * @param subpriority Subpriority level (from highest priority: 0, to lowest priority: 15)
+ *
+ * @retval None
+ */
+void port_system_gpio_exti_enable(uint8_t pin, uint8_t priority, uint8_t subpriority);
+
+/**
+ * @brief Disable interrupts of a GPIO line (pin)
+ *
+ * @param pin Pin/line of the GPIO (index from 0 to 15)
+ *
+ * @retval None
+ */
+void port_system_gpio_exti_disable(uint8_t pin);
+
+/**
+ * @brief Read the digital value of a GPIO
+ *
+ * @param p_port Port of the GPIO (CMSIS struct like)
+ * @param pin Pin/line of the GPIO (index from 0 to 15)
+ * @return true
+ * @return false
+ */
+bool port_system_gpio_read(GPIO_TypeDef *p_port, uint8_t pin);
+
+/**
+ * @brief Write a digital value in a GPIO
+ *
+ * @param p_port Port of the GPIO (CMSIS struct like)
+ * @param pin Pin/line of the GPIO (index from 0 to 15)
+ * @param value
+ */
+void port_system_gpio_write(GPIO_TypeDef *p_port, uint8_t pin, bool value);
+
+/**
+ * @brief Toggle the value of a GPIO
+ *
+ * @param p_port Port of the GPIO (CMSIS struct like)
+ * @param pin Pin/line of the GPIO (index from 0 to 15)
+ */
+void port_system_gpio_toggle(GPIO_TypeDef *p_port, uint8_t pin);
+
+/**
+ * @brief Set the system in stop mode. The virtual clock jumps to the next interrupt.
+ * @note If there is nothing left that can wake the system up, the simulation is over and the process exits.
+ *
+ */
+void port_system_power_stop();
+
+/**
+ * @brief Set the system in sleep mode. The virtual clock jumps to the next interrupt.
+ * @note If there is nothing left that can wake the system up, the simulation is over and the process exits.
+ *
+ */
+void port_system_power_sleep();
+
+/**
+ * @brief Enable low power consumption in sleep mode.
+ *
+ */
+void port_system_sleep(void);
+
+/**
+ * @brief Resume Tick increment.
+ *
+ */
+void port_system_systick_resume();
+
+/**
+ * @brief Suspend Tick increment.
+ *
+ */
+void port_system_systick_suspend();
+
+/**
+ * @brief Enable and reset the cycle counter. On the native platform it counts host CPU cycles (time stamp counter),
+ * not virtual time: the simulation does not model the cost of the instructions.
+ *
+ */
+void port_system_cycle_counter_init(void);
+
+/**
+ * @brief Get the number of cycles counted since port_system_cycle_counter_init(). It wraps around at 2^32.
+ *
+ * @return uint32_t
+ */
+uint32_t port_system_get_cycle_count(void);
+
+/**
+ * @brief Enable an interrupt line of the simulated NVIC.
+ *
+ * @param irqn Interrupt number
+ */
+void NVIC_EnableIRQ(IRQn_Type irqn);
+
+/**
+ * @brief Disable an interrupt line of the simulated NVIC.
+ *
+ * @param irqn Interrupt number
+ */
+void NVIC_DisableIRQ(IRQn_Type irqn);
+
+/**
+ * @brief Check if an interrupt line of the simulated NVIC is enabled.
+ *
+ * @param irqn Interrupt number
+ * @return uint32_t 1 if enabled, 0 otherwise
+ */
+uint32_t NVIC_GetEnableIRQ(IRQn_Type irqn);
+
+/**
+ * @brief Set the priority of an interrupt line. Priorities are not simulated, ISRs never preempt each other.
+ *
+ * @param irqn Interrupt number
+ * @param priority Encoded priority
+ */
+void NVIC_SetPriority(IRQn_Type irqn, uint32_t priority);
+
+/**
+ * @brief Encode a priority (same interface as CMSIS).
+ *
+ * @param priority_group Priority grouping
+ * @param preempt_priority Preemption priority
+ * @param sub_priority Subpriority
+ * @return uint32_t Encoded priority
+ */
+uint32_t NVIC_EncodePriority(uint32_t priority_group, uint32_t preempt_priority, uint32_t sub_priority);
+
+/**
+ * @brief Get the priority grouping (same interface as CMSIS).
+ *
+ * @return uint32_t
+ */
+uint32_t NVIC_GetPriorityGrouping(void);
+
+/* Native simulation ------------------------------------------------------------------*/
+
+/**
+ * @brief Get the virtual time in core clock cycles since `port_system_init()`.
+ *
+ * @return uint64_t
+ */
+uint64_t port_system_sim_get_cycles(void);
+
+/**
+ * @brief Advance the virtual clock a given number of core clock cycles.
+ *
+ * Timers count, and every timer update and scheduled stimulus due on the way is processed in order,
+ * raising the corresponding ISRs. Calls from interrupt context are ignored (ISRs take no time).
+ *
+ * @param cycles Number of core clock cycles
+ */
+void port_system_sim_advance(uint64_t cycles);
+
+/**
+ * @brief Jump the virtual clock to the next event that raises an interrupt (an enabled timer update, a
+ * DMA transfer complete or a scheduled stimulus) and process it. Timer updates that only request DMA transfers
+ * do not wake the core up.
+ *
+ * @return true if an event was processed
+ * @return false if nothing is pending. The virtual clock does not move.
+ */
+bool port_system_sim_wait_for_event(void);
+
+/**
+ * @brief Apply the register writes of the timers that take effect immediately, such as a software update event (UG),
+ * with no advance of the virtual clock.
+ *
+ * The simulation applies them lazily, when the virtual clock advances. A driver that writes the preload registers
+ * right after an update event calls this function in between, as the event has already happened in the HW.
+ */
+void port_system_sim_apply_writes(void);
+
+/**
+ * @brief Account for the cost of polling a port status function from the main loop.
+ *
+ * Every status query of the native port calls this function, so busy-waiting loops always make progress in
+ * virtual time. The cost can be changed with `port_system_sim_set_poll_cycles()`.
+ */
+void port_system_sim_poll(void);
+
+/**
+ * @brief Set the number of core clock cycles consumed by each poll of a port status function.
+ *
+ * @param cycles Number of core clock cycles
+ */
+void port_system_sim_set_poll_cycles(uint32_t cycles);
+
+/**
+ * @brief Schedule a stimulus at an absolute virtual time.
+ *
+ * @param at_cycles Virtual time in core clock cycles. If it is in the past, it runs on the next advance.
+ * @param callback Function to call
+ * @param arg Argument of the callback
+ * @return true if the stimulus was scheduled
+ * @return false if there are already `NATIVE_SIM_MAX_EVENTS` stimuli pending
+ */
+bool port_system_sim_schedule(uint64_t at_cycles, port_system_sim_callback_t callback, uint32_t arg);
+
+/**
+ * @brief Raise an interrupt line from a stimulus. The ISR runs only if the line is enabled in the NVIC.
+ *
+ * @param irqn Interrupt number
+ */
+void port_system_sim_raise_irq(IRQn_Type irqn);
+
+/**
+ * @brief Check if the code running is an ISR or a stimulus, rather than the main loop.
+ *
+ * @return true if an ISR or a stimulus is running
+ * @return false otherwise
+ */
+bool port_system_sim_in_isr(void);
+
+/**
+ * @brief Run a stimuli script.
+ *
+ * Each line of the script is one of:
+ * - `@press <ms>`: press the user button for `<ms>` milliseconds.
+ * - `@wait <ms>`: continue with the next line `<ms>` milliseconds later.
+ * - `# ...` or an empty line: ignored.
+ * - Any other text: sent to the USART as a command line (a line feed is appended).
+ *
+ * Lines are processed in interrupt context at their virtual time. When the script ends and the system goes
+ * to sleep with nothing else pending, the process exits.
+ *
+ * @param p_path Path of the script
+ * @return true if the script was opened
+ * @return false otherwise
+ */
+bool port_system_sim_run_script(const char *p_path);
+
+#endif /* PORT_SYSTEM_H_ */
@@ -0,0 +1,238 @@
+/**
+ * @file port_usart.h
+ * @brief Header for port_usart.c file (native platform).
+ * @author Javier de Ponte Hernando
+ * @author Roberto Maldonado Macafee
+ * @date 17/10/2026
+ */
+#ifndef PORT_USART_H_
+#define PORT_USART_H_
+
+/* Includes ------------------------------------------------------------------*/
+/* Standard C includes */
+#include <stdint.h>
+#include <stdbool.h>
+
+
+/* HW dependent includes */
+#include "port_system.h"
+
+/* Defines and enums ----------------------------------------------------------*/
+/* Defines */
+#define 	USART_0_ID 0 /*!< USART identifier*/
+#define 	USART_0 ((USART_TypeDef*) USART3)/*!< USART used connected to the GPIO*/
+#define 	USART_0_GPIO_TX GPIOB/*!< USART GPIO port for TX pin*/
+#define 	USART_0_GPIO_RX GPIOC/*!< USART GPIO port for RX pin */
+#define 	USART_0_PIN_TX 10 /*!< USART GPIO pin for TX*/
+#define 	USART_0_PIN_RX 11 /*!< USART GPIO pin for RX*/
+#define 	USART_0_AF_TX 7 /*!< USART alternate function for TX*/
+#define 	USART_0_AF_RX 7/*!< USART alternate function for RX*/
+#define 	USART_INPUT_BUFFER_LENGTH 32 /*!< USART input message length. Long enough for a command with two parameters*/
+#define 	USART_OUTPUT_BUFFER_LENGTH 100 /*!< USART output message length*/
+#define 	USART_RX_QUEUE_DEPTH 4 /*!< Lines received that can wait to be read. Lines received while the queue is full are dropped*/
+#define 	EMPTY_BUFFER_CONSTANT 0x0 /*!< Empty char constant*/
+#define 	END_CHAR_CONSTANT 0xA /*!< End char constant*/
+#define 	USART_FRAME_START_CONSTANT 0xA5 /*!< First byte of a binary frame. It is not a character of a text line*/
+#define 	USART_FRAME_HEADER_LENGTH 3 /*!< Bytes of a binary frame before its payload: start byte, opcode and length of the payload*/
+#define 	USART_FRAME_CRC_LENGTH 2 /*!< Bytes of the CRC-16 that ends a binary frame, most significant byte first*/
+#define 	USART_FRAME_MAX_PAYLOAD (USART_INPUT_BUFFER_LENGTH - USART_FRAME_HEADER_LENGTH) /*!< Maximum length of the payload of a binary frame: the frame is queued as a line, without its CRC*/
+#define 	USART_FRAME_CRC_INIT 0xFFFF /*!< Initial value of the CRC-16 of a binary frame (CRC-16/CCITT-FALSE)*/
+#define 	USART_FRAME_CRC_POLY 0x1021 /*!< Polynomial of the CRC-16 of a binary frame*/
+#define 	USART_0_BAUDRATE 9600 /*!< USART baud rate. Each simulated byte (8-N-1) takes 10 bit times*/
+#define 	NATIVE_SIM_USART_RX_FIFO_LENGTH 256 /*!< Bytes of simulated input pending to be received*/
+#define 	NATIVE_SIM_USART_TX_CAPTURE_LENGTH 1024 /*!< Bytes of simulated output kept for port_usart_sim_read_output()*/
+
+/* Typedefs --------------------------------------------------------------------*/
+/**
+ * @brief Structure to define the HW dependencies of a USART
+ * 
+ */
+typedef struct{
+    USART_TypeDef *p_usart; /*!< USART peripheral*/
+    GPIO_TypeDef *p_port_tx; /*!< GPIO where the USART TX is connected*/
+    GPIO_TypeDef *p_port_rx; /*!< GPIO where the USART RX is connected*/
+    uint8_t pin_tx; /*!< Pin/line where the USART TX is connected*/
+    uint8_t pin_rx; /*!< Pin/line where the USART RX is connected*/
+    uint8_t alt_func_tx; /*!< Alternate function for the TX pin*/
+    uint8_t alt_func_rx; /*!< Alternate function for the RX pin*/
+    char input_lines [USART_RX_QUEUE_DEPTH][USART_INPUT_BUFFER_LENGTH]; /*!< Queue of lines received: line i is at i % USART_RX_QUEUE_DEPTH*/
+    uint8_t i_idx; /*!< Index to the line being received*/
+    volatile uint32_t rx_head; /*!< Index of the oldest line received not read yet. Only moved by the reader*/
+    volatile uint32_t rx_tail; /*!< Index of the line being received. Only moved by the ISR: the queue holds the lines rx_head to rx_tail - 1*/
+    bool rx_overflow; /*!< Flag to indicate that the line being received is dropped because the queue was full*/
+    volatile uint32_t dropped_lines; /*!< Lines dropped because the queue was full*/
+    bool rx_frame; /*!< Flag to indicate that the line being received is a binary frame: it ends after its length, not at an end char*/
+    uint8_t frame_length; /*!< Bytes of the binary frame being received, from its start byte to its CRC. 0 until its length is received*/
+    uint16_t frame_crc; /*!< CRC-16 of the binary frame being received, updated byte by byte. It is 0 after the CRC of a frame with no errors*/
+    volatile uint32_t bad_frames; /*!< Binary frames dropped because of a wrong length or CRC*/
+    char output_buffer [USART_OUTPUT_BUFFER_LENGTH]; /*!< Output buffer*/
+    uint8_t o_idx; /*!< Index to the output buffer*/
+    bool write_complete; /*!< Flag to indicate that the data has been sent*/
+} port_usart_hw_t; 
+
+/* Global variables */
+/**
+ * @brief Array of elements that represents the HW characteristics of the USARTs \n
+ * This is an **extern** variable that is defined in port_usart.c . It represents an array of HWs USARTs \n 
+ * This is an **extern** variable that is declared in port_usart.h
+ * 
+ */
+extern port_usart_hw_t usart_arr[];
+
+/* Function prototypes and explanation -------------------------------------------------*/
+
+/**
+ * @brief Configure the HW specifications of a given USART
+ * 
+ * @param usart_id This index is used to select the element of the usart_arr[] array
+ */
+void port_usart_init (uint32_t usart_id);
+
+/**
+ * @brief Check if a transmission is completed
+ * 
+ * @param usart_id This index is used to select the element of the usart_arr[] array.
+ * @return true 
+ * @return false 
+ */
+bool port_usart_tx_done (uint32_t usart_id);
+
+/**
+ * @brief Check if a reception is completed: there is a line in the queue of lines received
+ * 
+ * @param usart_id This index is used to select the element of the usart_arr[] array.
+ * @return true 
+ * @return false 
+ */
+bool port_usart_rx_done (uint32_t usart_id);
+
+/**
+ * @brief Get the oldest message received through the USART and store it in the buffer passed as an argument \n
+ * This function is called from the function do_get_data_rx() of the FSM to store the message received
+ * to the buffer of the FSM
+ *  
+ * @param usart_id This index is used to select the element of the usart_arr[] array.
+ * @param p_buffer Pointer to the buffer where the message will be stored
+ */
+void port_usart_get_from_input_buffer (uint32_t usart_id, char *p_buffer);
+
+/**
+ * @brief Check if the USART is ready to receive a new message
+ * 
+ * @param usart_id This index is used to select the element of the usart_arr[] array.
+ * @return true 
+ * @return false 
+ */
+bool port_usart_get_txr_status (uint32_t usart_id);
+
+/**
+ * @brief Copy the message passed as an argument to the output buffer of the USART \n 
+ * This function is called from the function do_set_data_tx() of the FSM to set the message to send to the USART
+ * 
+ * @param usart_id This index is used to select the element of the usart_arr[] array.
+ * @param p_data Pointer to the message to send
+ * @param length Length of the message to send
+ */
+void port_usart_copy_to_output_buffer (uint32_t usart_id, char *p_data, uint32_t length);
+
+/**
+ * @brief Reset the input buffer of the USART. \n 
+ * This function is called from do_get_data_rx() to remove the oldest message from the queue of lines received after it has been read.
+ * The next message, if any, becomes the oldest one.
+ * 
+  * @param usart_id This index is used to select the element of the usart_arr[] array.
+ */
+void port_usart_reset_input_buffer (uint32_t usart_id);
+
+/**
+ * @brief Get the number of lines dropped because they were received while the queue of lines received was full.
+ * 
+ * @param usart_id This index is used to select the element of the usart_arr[] array.
+ * @return uint32_t Number of lines dropped since the USART was initialized
+ */
+uint32_t port_usart_get_dropped_lines (uint32_t usart_id);
+
+/**
+ * @brief Get the number of binary frames dropped because their length or their CRC was wrong.
+ * 
+ * @param usart_id This index is used to select the element of the usart_arr[] array.
+ * @return uint32_t Number of frames dropped since the USART was initialized
+ */
+uint32_t port_usart_get_bad_frames (uint32_t usart_id);
+
+/**
+ * @brief Reset the output buffer of the USART. \n 
+ * This function is called from do_set_data_tx() and do_tx_end() to reset the output buffer of the USART after the message has been read.
+ * 
+ * @param usart_id This index is used to select the element of the usart_arr[] array.
+ */
+void port_usart_reset_output_buffer (uint32_t usart_id);
+
+/**
+ * @brief Function to read the data from the USART Data Register and store it in the input buffer. \n 
+ * This function is called from the ISR USART3_IRQHandler() when the RXNE flag is set \n 
+ * A line that starts with USART_FRAME_START_CONSTANT is a binary frame: it is decoded byte by byte, and queued once its CRC has been checked \n 
+ * ![Implements](docs/assets/imgs/flow_graph_store_data.png)
+ * 
+ * @param usart_id This index is used to select the element of the usart_arr[] array.
+ */
+void port_usart_store_data (uint32_t usart_id);
+
+/**
+ * @brief Function to write the data from the output buffer to the USART Data Register \n 
+ * This function is called from the ISR USART3_IRQHandler() when the TXE flag is set
+ * ![Implements](docs/assets/imgs/flow_graph_write_data.png)
+ * @param usart_id This index is used to select the element of the usart_arr[] array.
+ */
+void port_usart_write_data (uint32_t usart_id);
+
+/**
+ * @brief Disable USART RX interrupt.
+ * 
+ * @param usart_id This index is used to select the element of the usart_arr[] array.
+ */
+void port_usart_disable_rx_interrupt (uint32_t usart_id);
+
+/**
+ * @brief Disable USART TX interrupts
+ * 
+ * @param usart_id This index is used to select the element of the usart_arr[] array.
+ */
+void port_usart_disable_tx_interrupt (uint32_t usart_id);
+
+/**
+ * @brief Enable USART RX interrupt
+ * 
+ * @param usart_id This index is used to select the element of the usart_arr[] array.
+ */
+void port_usart_enable_rx_interrupt (uint32_t usart_id);
+
+/**
+ * @brief Enable USART TX interrupt
+ * 
+ * @param usart_id This index is used to select the element of the usart_arr[] array.
+ */
+void port_usart_enable_tx_interrupt (uint32_t usart_id);
+
+/**
+ * @brief Simulate the reception of some bytes through the USART. \n
+ * The bytes are queued and delivered to the Data Register one per byte time (`USART_0_BAUDRATE`), raising the RXNE
+ * interrupt as the real peripheral does.
+ * 
+ * @param usart_id This index is used to select the element of the usart_arr[] array.
+ * @param p_data Pointer to the bytes to receive
+ * @param length Number of bytes to receive
+ * @return uint32_t Number of bytes queued. Bytes that do not fit in the simulated FIFO are dropped
+ */
+uint32_t port_usart_sim_receive (uint32_t usart_id, const char *p_data, uint32_t length);
+
+/**
+ * @brief Read the bytes transmitted through the USART since the last call. They are also printed to the standard output.
+ * 
+ * @param usart_id This index is used to select the element of the usart_arr[] array.
+ * @param p_buffer Pointer to the buffer where the bytes are copied. It is always null-terminated
+ * @param length Length of the buffer
+ * @return uint32_t Number of bytes copied
+ */
+uint32_t port_usart_sim_read_output (uint32_t usart_id, char *p_buffer, uint32_t length);
+#endif
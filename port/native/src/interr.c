@@ -0,0 +1,101 @@
+/**
+ * @file interr.c
+ * @brief Interrupt service routines for the native platform.
+ *
+ * Same ISRs as the STM32F4 platform. They are called by the simulation kernel of port_system.c. The system tick
+ * is not simulated as an interrupt: the milliseconds are derived from the virtual clock.
+ *
+ * @author Sistemas Digitales II
+ * @date 2024-01-01
+ */
+// Include HW dependencies:
+#include "port_system.h"
+ 
+// Include headers of different port elements:
+ //#include "port_system.h"
+ #include "port_button.h"
+ #include "port_usart.h"
+ #include "port_buzzer.h"
+//------------------------------------------------------
+// INTERRUPT SERVICE ROUTINES
+//------------------------------------------------------
+/**
+ * @brief This function handles Px10-Px15 global interrupts \n 
+ * First, this function identifies the line/pin which has raised the interruption. 
+ * Then, it performs the desired action. Before leaving it, cleans the interrupt pending register.
+ * 
+ */
+void EXTI15_10_IRQHandler (void) {
+    port_system_systick_resume();
+    if (EXTI -> PR & BIT_POS_TO_MASK(buttons_arr[BUTTON_0_ID].pin))
+    {
+        if (port_system_gpio_read(buttons_arr[BUTTON_0_ID].p_port, buttons_arr[BUTTON_0_ID].pin))
+        {
+            buttons_arr[BUTTON_0_ID].flag_pressed = false;
+        }
+        else {
+            buttons_arr[BUTTON_0_ID].flag_pressed = true;
+        }
+        EXTI -> PR |= BIT_POS_TO_MASK(buttons_arr[BUTTON_0_ID].pin);
+    }
+}	
+
+/**
+ * @brief This function handles USART3 global interrupt. \n 
+
+First, this function identifies the line/ pin which has raised the interruption. Then, perform the desired action.
+Before leaving it cleans the interrupt pending register. \n 
+
+The program flow jumps to this ISR when the USART3 generates an interrupt. It can be due to: 
+
+- Reception of a new byte (RXNE)
+- Transmission of a byte has finished (TC)
+- Transmission buffer is empty (TXE)
+ * 
+ */
+void USART3_IRQHandler(void ){
+    port_system_systick_resume();
+    //if there has been received a new data
+    if(USART3 -> CR1 & USART_CR1_RXNEIE){
+        //Check that the flag is set
+        if(USART3 -> SR & USART_SR_RXNE){
+            port_usart_store_data(USART_0_ID);
+        }    
+    }
+        //if buffer is empty
+        if(USART3 -> CR1 & USART_CR1_TXEIE){
+        //Check that the flag is set
+        if(USART3 -> SR & USART_SR_TXE){
+            port_usart_write_data(USART_0_ID);
+        }    
+    }
+        //if TX is completed
+        if(USART3 -> CR1 & USART_CR1_TCIE){
+        //Check that the flag is set
+        if(USART3 -> SR & USART_SR_TC){
+            USART3 -> SR &= ~USART_SR_TC;
+        }    
+    }
+
+}
+
+/**
+ * @brief This function handles TIM2 global interrupt. \n 
+ * This timer is used to control the duration of the note. When the timer expires, it generates an interrupt. The code jumps to this ISR when the timer generates an interrupt.
+ */
+void TIM2_IRQHandler ( void ) {
+    TIM2 -> SR &= ~TIM_SR_UIF;
+    port_buzzer_update_note(BUZZER_0_ID);
+}	
+
+/**
+ * @brief This function handles DMA1 stream 4 global interrupt. \n 
+ * This stream writes the notes of a melody played by DMA into the timer that controls the frequency of the note. The end of its transfer is the end of the melody.
+ */
+void DMA1_Stream4_IRQHandler ( void ) {
+    port_system_systick_resume();
+    if (DMA1 -> HISR & DMA_HISR_TCIF4) {
+        DMA1 -> HIFCR = DMA_HIFCR_CTCIF4;
+        port_buzzer_dma_end(BUZZER_0_ID);
+    }
+}
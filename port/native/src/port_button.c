@@ -0,0 +1,81 @@
+/**
+ * @file port_button.c
+ * @brief File containing functions related to the HW of the button (native platform).
+ *
+ * The button is connected to a GPIO stand-in. Presses are simulated by driving the input data register
+ * and raising the EXTI interrupt of the pin, so the ISR in `interr.c` is the same as on the board.
+ *
+ * @author Javier de Ponte Hernando
+ * @author Roberto Maldonado Macafee
+ * @date 17/10/2026
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include "port_button.h" 
+
+/* Global variables ------------------------------------------------------------*/
+/**
+ * @brief Array of elements that represents the HW characteristics of the buttons \n 
+ * This is an **extern** variable that is defined in [port_button.c](port_button_8c.html). It represents an array of hardware buttons \n 
+ * This is an **extern** variable that is declared in [port_button.h](port_button_8h.html).
+ */
+port_button_hw_t buttons_arr [] = {
+    [BUTTON_0_ID] = {.p_port = BUTTON_0_GPIO, .pin = BUTTON_0_PIN, .flag_pressed = false},
+};
+
+/* Private functions */
+/**
+ * @brief Drive the level of the button pin and raise its EXTI interrupt if the edge is enabled.
+ * 
+ * @param button_id This index is used to select the element of the buttons_arr[] array
+ * @param level New level of the pin
+ */
+static void _set_level (uint32_t button_id, bool level) {
+    GPIO_TypeDef *p_port = buttons_arr[button_id].p_port;
+    uint8_t pin = buttons_arr[button_id].pin;
+    uint32_t edges = level ? EXTI -> RTSR : EXTI -> FTSR;
+    if (level) {
+        p_port -> IDR |= BIT_POS_TO_MASK(pin);
+    } else {
+        p_port -> IDR &= ~BIT_POS_TO_MASK(pin);
+    }
+    if ((EXTI -> IMR & edges) & BIT_POS_TO_MASK(pin)) {
+        EXTI -> PR |= BIT_POS_TO_MASK(pin);
+        port_system_sim_raise_irq(GET_PIN_IRQN(pin));
+        EXTI -> PR &= ~BIT_POS_TO_MASK(pin);
+    }
+}
+
+/**
+ * @brief Release the button at the end of a simulated press.
+ * 
+ * @param button_id This index is used to select the element of the buttons_arr[] array
+ */
+static void _release (uint32_t button_id) {
+    _set_level(button_id, HIGH);
+}
+
+/* Public functions */
+void port_button_init(uint32_t button_id)
+{
+    GPIO_TypeDef *p_port = buttons_arr[button_id].p_port;
+    uint8_t pin = buttons_arr[button_id].pin;
+    port_system_gpio_config(p_port, pin, GPIO_MODE_IN, GPIO_PUPDR_NOPULL);
+    port_system_gpio_config_exti(p_port, pin, (TRIGGER_ENABLE_INTERR_REQ | TRIGGER_FALLING_EDGE | TRIGGER_RISING_EDGE));
+    port_system_gpio_exti_enable(pin, 1, 0);
+}
+
+bool port_button_is_pressed (uint32_t  button_id) {
+    port_system_sim_poll();
+    return buttons_arr[button_id].flag_pressed; 
+} 	
+
+uint32_t port_button_get_tick () {
+    port_system_sim_poll();
+    return port_system_get_millis();
+}
+
+void port_button_sim_press (uint32_t button_id, uint32_t duration_ms) {
+    _set_level(button_id, LOW);
+    port_system_sim_schedule(port_system_sim_get_cycles() + (uint64_t)duration_ms * (SystemCoreClock / 1000U), _release, button_id);
+}
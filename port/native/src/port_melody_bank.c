@@ -0,0 +1,131 @@
+/**
+ * @file port_melody_bank.c
+ * @brief Portable functions to access the melody bank of the jukebox (native platform).
+ *
+ * The bank is the same image that the board links in flash: here it is a file mapped read-only with mmap(), so the
+ * melodies are read in place as they are from flash.
+ *
+ * @author Javier de Ponte Hernando
+ * @author Roberto Maldonado Macafee
+ * @date 18/10/2026
+ */
+/* Includes ------------------------------------------------------------------*/
+/* Standard C libraries */
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "port_melody_bank.h"
+#include "melody_bank_data.h"
+
+/* Private variables */
+static void *p_mapped = NULL; /*!< Melody bank file mapped in memory, or NULL */
+static uint32_t mapped_size = 0; /*!< Size of the mapped file in bytes */
+static uint32_t slots[PORT_MELODY_BANK_NUM_SLOTS][PORT_MELODY_BANK_SLOT_SIZE / sizeof(uint32_t)]; /*!< Data sectors of the slots of the double buffer */
+
+/* Private functions */
+/**
+ * @brief Map a melody bank file in memory, read-only.
+ *
+ * @param p_path Path of the file
+ * @return true if the file has been mapped
+ * @return false otherwise
+ */
+static bool _map(const char *p_path)
+{
+  int fd = open(p_path, O_RDONLY);
+  if (fd < 0)
+  {
+    return false;
+  }
+  struct stat st;
+  void *p_data = MAP_FAILED;
+  if ((fstat(fd, &st) == 0) && (st.st_size > 0) && ((uint64_t)st.st_size <= UINT32_MAX))
+  {
+    p_data = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  }
+  close(fd);
+  if (p_data == MAP_FAILED)
+  {
+    return false;
+  }
+  p_mapped = p_data;
+  mapped_size = (uint32_t)st.st_size;
+  return true;
+}
+
+/**
+ * @brief Program a melody bank file into a slot: erase it and copy the file, up to the size of the slot.
+ *
+ * @param p_slot Pointer to the slot
+ * @param p_path Path of the file
+ */
+static void _program(uint32_t *p_slot, const char *p_path)
+{
+  memset(p_slot, 0xFF, PORT_MELODY_BANK_SLOT_SIZE);
+  int fd = open(p_path, O_RDONLY);
+  if (fd < 0)
+  {
+    return;
+  }
+  uint8_t *p_data = (uint8_t *)p_slot;
+  size_t size = 0;
+  ssize_t n;
+  while ((size < PORT_MELODY_BANK_SLOT_SIZE) && ((n = read(fd, p_data + size, PORT_MELODY_BANK_SLOT_SIZE - size)) > 0))
+  {
+    size += (size_t)n;
+  }
+  close(fd);
+}
+
+/* Public functions */
+const void *port_melody_bank_get(uint32_t *p_size)
+{
+  if (p_mapped == NULL)
+  {
+    const char *p_path = getenv(NATIVE_MELODY_BANK_ENV);
+    _map((p_path != NULL) ? p_path : MELODY_BANK_DATA_PATH);
+  }
+  if (p_mapped != NULL)
+  {
+    *p_size = mapped_size;
+    return p_mapped;
+  }
+  *p_size = MELODY_BANK_DATA_SIZE;
+  return melody_bank_data;
+}
+
+const void *port_melody_bank_get_slot(uint32_t slot, uint32_t *p_size)
+{
+  if (slot >= PORT_MELODY_BANK_NUM_SLOTS)
+  {
+    *p_size = 0;
+    return NULL;
+  }
+  const char *p_path = getenv(NATIVE_MELODY_BANK_UPDATE_ENV);
+  if (p_path == NULL)
+  {
+    p_path = getenv(NATIVE_MELODY_BANK_ENV);
+  }
+  _program(slots[slot], (p_path != NULL) ? p_path : MELODY_BANK_DATA_PATH);
+  *p_size = PORT_MELODY_BANK_SLOT_SIZE;
+  return slots[slot];
+}
+
+bool port_melody_bank_sim_is_mapped(void)
+{
+  return p_mapped != NULL;
+}
+
+void port_melody_bank_sim_unmap(void)
+{
+  if (p_mapped != NULL)
+  {
+    munmap(p_mapped, mapped_size);
+    p_mapped = NULL;
+    mapped_size = 0;
+  }
+}
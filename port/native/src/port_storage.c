@@ -0,0 +1,68 @@
+/**
+ * @file port_storage.c
+ * @brief Portable functions to read the storage device of the streamed melodies (native platform).
+ *
+ * The storage device, an SPI flash on the board, is a plain file read with pread().
+ *
+ * @author Javier de Ponte Hernando
+ * @author Roberto Maldonado Macafee
+ * @date 18/10/2026
+ */
+/* Includes ------------------------------------------------------------------*/
+/* Standard C libraries */
+#include <stdlib.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "port_storage.h"
+
+/* Private variables */
+static int storage_fd = -1; /*!< File descriptor of the storage file, or -1 */
+static uint32_t storage_size = 0; /*!< Size of the storage file in bytes */
+static uint32_t storage_reads = 0; /*!< Number of reads since the device was initialized */
+
+/* Public functions */
+uint32_t port_storage_init(void)
+{
+  if (storage_fd >= 0)
+  {
+    close(storage_fd);
+    storage_fd = -1;
+  }
+  storage_size = 0;
+  storage_reads = 0;
+  const char *p_path = getenv(NATIVE_STORAGE_ENV);
+  if (p_path == NULL)
+  {
+    return 0;
+  }
+  int fd = open(p_path, O_RDONLY);
+  if (fd < 0)
+  {
+    return 0;
+  }
+  struct stat st;
+  if ((fstat(fd, &st) != 0) || ((uint64_t)st.st_size > UINT32_MAX))
+  {
+    close(fd);
+    return 0;
+  }
+  storage_fd = fd;
+  storage_size = (uint32_t)st.st_size;
+  return storage_size;
+}
+
+bool port_storage_read(uint32_t address, void *p_data, uint32_t size)
+{
+  if ((storage_fd < 0) || (address > storage_size) || (size > storage_size - address))
+  {
+    return false;
+  }
+  storage_reads++;
+  return pread(storage_fd, p_data, size, (off_t)address) == (ssize_t)size;
+}
+
+uint32_t port_storage_sim_get_reads(void)
+{
+  return storage_reads;
+}
@@ -0,0 +1,1028 @@
+/**
+ * @file port_system.c
+ * @brief Simulation kernel of the native platform: virtual clock, register stand-ins and stimuli.
+ * @author Javier de Ponte Hernando
+ * @author Roberto Maldonado Macafee
+ * @date 17/10/2026
+ */
+
+/* Includes ------------------------------------------------------------------*/
+/* Standard C libraries */
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+/* HW dependent libraries */
+#include "port_system.h"
+#include "port_button.h"
+#include "port_usart.h"
+
+/* Defines -------------------------------------------------------------------*/
+#define SIM_SCRIPT_LINE_LENGTH 128 /*!< Maximum length of a line of the stimuli script */
+#define TIM2_COUNTER_MAX 0xFFFFFFFFU /*!< TIM2 is a 32-bit timer */
+#define TIM3_COUNTER_MAX 0xFFFFU /*!< TIM3 is a 16-bit timer */
+#define TIM16_COUNTER_MAX 0xFFFFU /*!< TIM4, TIM10 and TIM11 are 16-bit timers */
+
+/* Typedefs --------------------------------------------------------------------*/
+/**
+ * @brief Hidden state of a simulated DMA stream.
+ *
+ */
+typedef struct
+{
+  DMA_Stream_TypeDef *p_stream; /*!< Register stand-in of the stream */
+  uint32_t channel;             /*!< Channel of the requests served by the stream */
+  IRQn_Type irqn;               /*!< Interrupt line of the stream */
+  volatile uint32_t *p_isr;     /*!< Interrupt status register of the stream (LISR or HISR) */
+  uint32_t tcif;                /*!< Transfer complete flag of the stream in its interrupt status register */
+  bool running;                 /*!< A transfer is in course */
+  uintptr_t mem;                /*!< Memory address latched at the start of the transfer */
+  uint32_t remaining;           /*!< Items left at the last request */
+  uint32_t index;               /*!< Next item of the memory buffer */
+  bool tc_pending;              /*!< The transfer complete interrupt has to be raised */
+} sim_dma_stream_t;
+
+/**
+ * @brief Hidden state of a simulated timer: active (shadow) registers and prescaler counter.
+ *
+ */
+typedef struct
+{
+  TIM_TypeDef *p_tim;   /*!< Register stand-in of the timer */
+  IRQn_Type irqn;       /*!< Interrupt line of the timer */
+  uint32_t counter_max; /*!< Maximum value of the counter */
+  uint32_t psc;         /*!< Active prescaler */
+  uint32_t arr;         /*!< Active auto-reload value */
+  uint32_t ccr1;        /*!< Active capture/compare 1 value */
+  uint32_t psc_cnt;     /*!< Prescaler counter */
+  uint32_t dma_index;   /*!< Index of the next access to DMAR in a DMA burst */
+  TIM_TypeDef *p_itr1;  /*!< Master timer connected to the internal trigger 1, or NULL */
+  sim_dma_stream_t *p_dma_up;   /*!< DMA stream of the update requests, or NULL */
+  sim_dma_stream_t *p_dma_trig; /*!< DMA stream of the trigger requests, or NULL */
+} sim_timer_t;
+
+/**
+ * @brief Scheduled stimulus.
+ *
+ */
+typedef struct
+{
+  bool armed;                          /*!< The stimulus is pending */
+  uint64_t at;                         /*!< Virtual time of the stimulus in core clock cycles */
+  port_system_sim_callback_t callback; /*!< Function to call */
+  uint32_t arg;                        /*!< Argument of the callback */
+} sim_event_t;
+
+/* GLOBAL VARIABLES */
+uint32_t SystemCoreClock = HSI_VALUE; /*!< Frequency of the simulated system clock */
+GPIO_TypeDef native_gpioa;            /*!< Stand-in of GPIOA */
+GPIO_TypeDef native_gpiob;            /*!< Stand-in of GPIOB */
+GPIO_TypeDef native_gpioc;            /*!< Stand-in of GPIOC */
+EXTI_TypeDef native_exti;             /*!< Stand-in of EXTI */
+TIM_TypeDef native_tim2;              /*!< Stand-in of TIM2 */
+TIM_TypeDef native_tim3;              /*!< Stand-in of TIM3 */
+TIM_TypeDef native_tim4;              /*!< Stand-in of TIM4 */
+TIM_TypeDef native_tim10;             /*!< Stand-in of TIM10 */
+TIM_TypeDef native_tim11;             /*!< Stand-in of TIM11 */
+USART_TypeDef native_usart3;          /*!< Stand-in of USART3 */
+DMA_TypeDef native_dma1;              /*!< Stand-in of DMA1 */
+DMA_Stream_TypeDef native_dma1_stream1; /*!< Stand-in of DMA1 stream 1 */
+DMA_Stream_TypeDef native_dma1_stream4; /*!< Stand-in of DMA1 stream 4 */
+
+static uint64_t sim_cycles = 0;                           /*!< Virtual time in core clock cycles */
+static int64_t millis_offset = 0;                         /*!< Offset applied by port_system_set_millis() */
+static uint32_t poll_cycles = NATIVE_SIM_POLL_CYCLES;     /*!< Cost of a poll of a port status function */
+static bool in_isr = false;                               /*!< True while an ISR or a stimulus is running */
+static bool nvic_enabled[NATIVE_IRQN_COUNT];              /*!< Enabled interrupt lines */
+static sim_event_t events[NATIVE_SIM_MAX_EVENTS];         /*!< Scheduled stimuli */
+static FILE *p_script = NULL;                             /*!< Stimuli script being run */
+static uint64_t cycle_counter_start = 0;                  /*!< Host cycles at port_system_cycle_counter_init() */
+static sim_dma_stream_t dma_streams[] = {
+    {.p_stream = DMA1_Stream1, .channel = 3, .irqn = DMA1_Stream1_IRQn, .p_isr = &native_dma1.LISR, .tcif = DMA_LISR_TCIF1},
+    {.p_stream = DMA1_Stream4, .channel = 5, .irqn = DMA1_Stream4_IRQn, .p_isr = &native_dma1.HISR, .tcif = DMA_HISR_TCIF4},
+};                                                        /*!< Simulated DMA streams (mapping of the STM32F446RE) */
+static sim_timer_t timers[] = {
+    {.p_tim = TIM2, .irqn = TIM2_IRQn, .counter_max = TIM2_COUNTER_MAX, .p_itr1 = NULL, .p_dma_up = &dma_streams[0], .p_dma_trig = NULL},
+    {.p_tim = TIM3, .irqn = TIM3_IRQn, .counter_max = TIM3_COUNTER_MAX, .p_itr1 = TIM2, .p_dma_up = NULL, .p_dma_trig = &dma_streams[1]},
+    {.p_tim = TIM4, .irqn = TIM4_IRQn, .counter_max = TIM16_COUNTER_MAX, .p_itr1 = NULL, .p_dma_up = NULL, .p_dma_trig = NULL},
+    {.p_tim = TIM10, .irqn = TIM1_UP_TIM10_IRQn, .counter_max = TIM16_COUNTER_MAX, .p_itr1 = NULL, .p_dma_up = NULL, .p_dma_trig = NULL},
+    {.p_tim = TIM11, .irqn = TIM1_TRG_COM_TIM11_IRQn, .counter_max = TIM16_COUNTER_MAX, .p_itr1 = NULL, .p_dma_up = NULL, .p_dma_trig = NULL},
+};                                                        /*!< Simulated timers */
+
+/* Interrupt service routines. Weak defaults, as in the vector table of the startup file */
+__attribute__((weak)) void SysTick_Handler(void) {}
+__attribute__((weak)) void EXTI15_10_IRQHandler(void) {}
+__attribute__((weak)) void USART3_IRQHandler(void) {}
+__attribute__((weak)) void TIM2_IRQHandler(void) {}
+__attribute__((weak)) void TIM3_IRQHandler(void) {}
+__attribute__((weak)) void DMA1_Stream1_IRQHandler(void) {}
+__attribute__((weak)) void DMA1_Stream4_IRQHandler(void) {}
+
+/* Private functions */
+/**
+ * @brief Call the ISR of an interrupt line.
+ *
+ * @param irqn Interrupt number
+ */
+static void _call_isr(IRQn_Type irqn)
+{
+  bool was_in_isr = in_isr;
+  in_isr = true;
+  switch (irqn)
+  {
+  case EXTI15_10_IRQn:
+    EXTI15_10_IRQHandler();
+    break;
+  case USART3_IRQn:
+    USART3_IRQHandler();
+    break;
+  case TIM2_IRQn:
+    TIM2_IRQHandler();
+    break;
+  case TIM3_IRQn:
+    TIM3_IRQHandler();
+    break;
+  case DMA1_Stream1_IRQn:
+    DMA1_Stream1_IRQHandler();
+    break;
+  case DMA1_Stream4_IRQn:
+    DMA1_Stream4_IRQHandler();
+    break;
+  default:
+    break;
+  }
+  in_isr = was_in_isr;
+}
+
+/**
+ * @brief Check if a timer raises an interrupt at its next update event.
+ *
+ * @param p_timer Simulated timer
+ * @return true
+ * @return false
+ */
+static bool _timer_irq_enabled(sim_timer_t *p_timer)
+{
+  return (p_timer->p_tim->DIER & TIM_DIER_UIE) && nvic_enabled[p_timer->irqn];
+}
+
+/**
+ * @brief Check if a DMA stream serves the requests of its channel.
+ *
+ * @param p_dma Simulated DMA stream, or NULL
+ * @return true
+ * @return false
+ */
+static bool _dma_enabled(sim_dma_stream_t *p_dma)
+{
+  if (p_dma == NULL)
+  {
+    return false;
+  }
+  uint32_t cr = p_dma->p_stream->CR;
+  return (cr & DMA_SxCR_EN) && (((cr & DMA_SxCR_CHSEL) >> DMA_SxCR_CHSEL_Pos) == p_dma->channel);
+}
+
+/**
+ * @brief Check if a timer is a slave in reset mode of a master timer.
+ *
+ * @param p_timer Simulated timer
+ * @param p_master Register stand-in of the master timer
+ * @return true
+ * @return false
+ */
+static bool _timer_is_reset_slave(sim_timer_t *p_timer, TIM_TypeDef *p_master)
+{
+  uint32_t smcr = p_timer->p_tim->SMCR;
+  return (p_timer->p_itr1 == p_master) && ((smcr & TIM_SMCR_SMS) == TIM_SMCR_SMS_2) && ((smcr & TIM_SMCR_TS) == TIM_SMCR_TS_0);
+}
+
+/**
+ * @brief Check if the update event of a timer outputs TRGO to a slave in reset mode.
+ *
+ * @param p_timer Simulated timer
+ * @return true
+ * @return false
+ */
+static bool _timer_resets_slave(sim_timer_t *p_timer)
+{
+  if ((p_timer->p_tim->CR2 & TIM_CR2_MMS) != TIM_CR2_MMS_1)
+  {
+    return false;
+  }
+  for (uint32_t i = 0; i < sizeof(timers) / sizeof(timers[0]); i++)
+  {
+    if (_timer_is_reset_slave(&timers[i], p_timer->p_tim))
+    {
+      return true;
+    }
+  }
+  return false;
+}
+
+/**
+ * @brief Check if the update event of a timer requests a DMA transfer, directly or through the trigger of a slave timer.
+ *
+ * @param p_timer Simulated timer
+ * @return true
+ * @return false
+ */
+static bool _timer_requests_dma(sim_timer_t *p_timer)
+{
+  if ((p_timer->p_tim->DIER & TIM_DIER_UDE) && _dma_enabled(p_timer->p_dma_up))
+  {
+    return true;
+  }
+  if ((p_timer->p_tim->CR2 & TIM_CR2_MMS) != TIM_CR2_MMS_1)
+  {
+    return false;
+  }
+  for (uint32_t i = 0; i < sizeof(timers) / sizeof(timers[0]); i++)
+  {
+    if (_timer_is_reset_slave(&timers[i], p_timer->p_tim) && (timers[i].p_tim->DIER & TIM_DIER_TDE) && _dma_enabled(timers[i].p_dma_trig))
+    {
+      return true;
+    }
+  }
+  return false;
+}
+
+/**
+ * @brief Check if the next update event of a running timer has observable effects. If not, the simulation can
+ * let it wrap silently and never stops at its update events (e.g. the PWM timer playing a steady note).
+ *
+ * @param p_timer Simulated timer
+ * @return true
+ * @return false
+ */
+static bool _timer_update_observable(sim_timer_t *p_timer)
+{
+  TIM_TypeDef *p_tim = p_timer->p_tim;
+  return _timer_irq_enabled(p_timer) || (p_tim->PSC != p_timer->psc) || (p_tim->ARR != p_timer->arr) || (p_tim->CCR1 != p_timer->ccr1) ||
+         (p_tim->DIER & TIM_DIER_UDE) || _timer_resets_slave(p_timer);
+}
+
+/**
+ * @brief Apply the register writes that take effect immediately: software update events (UG) and non-preloaded
+ * ARR and CCR1 values.
+ *
+ * @param p_timer Simulated timer
+ */
+static void _timer_apply_writes(sim_timer_t *p_timer)
+{
+  TIM_TypeDef *p_tim = p_timer->p_tim;
+  if (p_tim->EGR & TIM_EGR_UG)
+  {
+    p_tim->EGR &= ~TIM_EGR_UG;
+    p_tim->CNT = 0;
+    p_timer->psc_cnt = 0;
+    p_timer->psc = p_tim->PSC;
+    p_timer->arr = p_tim->ARR;
+    p_timer->ccr1 = p_tim->CCR1;
+  }
+  if (!(p_tim->CR1 & TIM_CR1_ARPE))
+  {
+    p_timer->arr = p_tim->ARR;
+  }
+  if (!(p_tim->CCMR1 & TIM_CCMR1_OC1PE))
+  {
+    p_timer->ccr1 = p_tim->CCR1;
+  }
+}
+
+/**
+ * @brief Number of core clock cycles until the next update event of a running timer.
+ *
+ * @param p_timer Simulated timer
+ * @return uint64_t
+ */
+static uint64_t _timer_cycles_to_update(sim_timer_t *p_timer)
+{
+  uint64_t cnt = p_timer->p_tim->CNT;
+  uint64_t ticks;
+  if (cnt <= p_timer->arr)
+  {
+    ticks = (uint64_t)p_timer->arr - cnt + 1;
+  }
+  else
+  {
+    // The counter passed ARR (ARR was lowered without preload): it counts up to its maximum and wraps
+    ticks = (uint64_t)p_timer->counter_max - cnt + 1 + (uint64_t)p_timer->arr + 1;
+  }
+  return ticks * ((uint64_t)p_timer->psc + 1) - p_timer->psc_cnt;
+}
+
+/**
+ * @brief Update event of a timer: reload the active registers from the preload registers and set the update flag.
+ * The caller raises the interrupt, once the virtual clock has reached the update event.
+ *
+ * @param p_timer Simulated timer
+ */
+static void _timer_update(sim_timer_t *p_timer)
+{
+  TIM_TypeDef *p_tim = p_timer->p_tim;
+  p_tim->CNT = 0;
+  p_timer->psc = p_tim->PSC;
+  p_timer->arr = p_tim->ARR;
+  p_timer->ccr1 = p_tim->CCR1;
+  p_tim->SR |= TIM_SR_UIF;
+}
+
+/**
+ * @brief Write a word from a DMA stream. An access to the DMAR of a timer writes the register of the burst in course,
+ * starting at the DMA base address of its DCR.
+ *
+ * @param address Peripheral address
+ * @param value Word to write
+ */
+static void _dma_write(uintptr_t address, uint32_t value)
+{
+  for (uint32_t i = 0; i < sizeof(timers) / sizeof(timers[0]); i++)
+  {
+    TIM_TypeDef *p_tim = timers[i].p_tim;
+    if (address == (uintptr_t)&p_tim->DMAR)
+    {
+      uint32_t dba = (p_tim->DCR & TIM_DCR_DBA) >> TIM_DCR_DBA_Pos;
+      uint32_t dbl = (p_tim->DCR & TIM_DCR_DBL) >> TIM_DCR_DBL_Pos;
+      uint32_t reg = dba + timers[i].dma_index;
+      if (reg < offsetof(TIM_TypeDef, DMAR) / sizeof(uint32_t))
+      {
+        ((volatile uint32_t *)p_tim)[reg] = value;
+      }
+      timers[i].dma_index = (timers[i].dma_index >= dbl) ? 0 : timers[i].dma_index + 1;
+      return;
+    }
+  }
+  *(volatile uint32_t *)address = value;
+}
+
+/**
+ * @brief DMA request of a timer. The stream transfers one word, or a whole burst if it writes the DMAR of the timer.
+ * At the end of the transfer the stream is disabled and its transfer complete interrupt is left pending.
+ *
+ * @param p_timer Simulated timer that requests the transfer
+ * @param p_dma Simulated DMA stream of the request, or NULL
+ */
+static void _dma_request(sim_timer_t *p_timer, sim_dma_stream_t *p_dma)
+{
+  if (!_dma_enabled(p_dma))
+  {
+    return;
+  }
+  DMA_Stream_TypeDef *p_stream = p_dma->p_stream;
+  // A new transfer: the stream has been (re)programmed since the last request
+  if (!p_dma->running || (p_stream->M0AR != p_dma->mem) || (p_stream->NDTR > p_dma->remaining))
+  {
+    p_dma->running = true;
+    p_dma->mem = p_stream->M0AR;
+    p_dma->index = 0;
+  }
+  uint32_t transfers = 1;
+  if (p_stream->PAR == (uintptr_t)&p_timer->p_tim->DMAR)
+  {
+    transfers = ((p_timer->p_tim->DCR & TIM_DCR_DBL) >> TIM_DCR_DBL_Pos) + 1;
+  }
+  for (uint32_t i = 0; (i < transfers) && (p_stream->NDTR > 0); i++)
+  {
+    _dma_write(p_stream->PAR, ((const uint32_t *)p_dma->mem)[p_dma->index]);
+    p_dma->index++;
+    p_stream->NDTR--;
+  }
+  p_dma->remaining = p_stream->NDTR;
+  if (p_stream->NDTR == 0)
+  {
+    p_stream->CR &= ~DMA_SxCR_EN;
+    p_dma->running = false;
+    *(p_dma->p_isr) |= p_dma->tcif;
+    p_dma->tc_pending = (p_stream->CR & DMA_SxCR_TCIE) != 0;
+  }
+}
+
+/**
+ * @brief Apply the writes to the DMA registers: interrupt flags cleared and streams disabled by the program.
+ *
+ */
+static void _dma_apply_writes(void)
+{
+  native_dma1.LISR &= ~native_dma1.LIFCR;
+  native_dma1.LIFCR = 0;
+  native_dma1.HISR &= ~native_dma1.HIFCR;
+  native_dma1.HIFCR = 0;
+  for (uint32_t i = 0; i < sizeof(dma_streams) / sizeof(dma_streams[0]); i++)
+  {
+    if (!(dma_streams[i].p_stream->CR & DMA_SxCR_EN))
+    {
+      dma_streams[i].running = false;
+    }
+  }
+}
+
+/**
+ * @brief Effects of the update event of a timer on the rest of the system, once the virtual clock has reached it:
+ * update DMA request and TRGO to the slaves in reset mode, which reload their registers and request their trigger DMA.
+ *
+ * @param p_timer Simulated timer
+ */
+static void _timer_update_outputs(sim_timer_t *p_timer)
+{
+  if (p_timer->p_tim->DIER & TIM_DIER_UDE)
+  {
+    _dma_request(p_timer, p_timer->p_dma_up);
+  }
+  if ((p_timer->p_tim->CR2 & TIM_CR2_MMS) != TIM_CR2_MMS_1)
+  {
+    return;
+  }
+  for (uint32_t i = 0; i < sizeof(timers) / sizeof(timers[0]); i++)
+  {
+    sim_timer_t *p_slave = &timers[i];
+    if (_timer_is_reset_slave(p_slave, p_timer->p_tim))
+    {
+      // Reset mode: the counter is reinitialized and the registers are updated
+      p_slave->psc_cnt = 0;
+      _timer_update(p_slave);
+      p_slave->p_tim->SR |= TIM_SR_TIF;
+      if (p_slave->p_tim->DIER & TIM_DIER_TDE)
+      {
+        _dma_request(p_slave, p_slave->p_dma_trig);
+      }
+      _timer_apply_writes(p_slave);
+    }
+  }
+}
+
+/**
+ * @brief Count a number of core clock cycles in a running timer. The caller ensures that, if the update event
+ * is observable, it is not crossed (it can be reached exactly).
+ *
+ * @param p_timer Simulated timer
+ * @param cycles Number of core clock cycles
+ */
+static void _timer_count(sim_timer_t *p_timer, uint64_t cycles)
+{
+  TIM_TypeDef *p_tim = p_timer->p_tim;
+  if (!(p_tim->CR1 & TIM_CR1_CEN))
+  {
+    return;
+  }
+  uint64_t to_update = _timer_cycles_to_update(p_timer);
+  if (cycles < to_update)
+  {
+    uint64_t total = (uint64_t)p_timer->psc_cnt + cycles;
+    uint64_t ticks = total / ((uint64_t)p_timer->psc + 1);
+    p_timer->psc_cnt = (uint32_t)(total % ((uint64_t)p_timer->psc + 1));
+    p_tim->CNT = (uint32_t)(((uint64_t)p_tim->CNT + ticks) & p_timer->counter_max);
+    return;
+  }
+  // The update event is reached. Non-observable updates may be crossed: wrap around the period
+  cycles -= to_update;
+  p_timer->psc_cnt = 0;
+  _timer_update(p_timer);
+  if (cycles > 0)
+  {
+    uint64_t period = ((uint64_t)p_timer->arr + 1) * ((uint64_t)p_timer->psc + 1);
+    _timer_count(p_timer, cycles % period);
+  }
+}
+
+/**
+ * @brief Advance the virtual clock up to a given time, processing every event on the way.
+ *
+ * @param target Virtual time in core clock cycles
+ * @param stop_at_irq If true, return right after the first event that raises an interrupt
+ * @return true if an event that raises an interrupt was processed
+ * @return false otherwise
+ */
+static bool _advance_until(uint64_t target, bool stop_at_irq)
+{
+  bool irq = false;
+  bool was_in_isr = in_isr;
+  in_isr = true;
+  while (true)
+  {
+    uint64_t next = target;
+    _dma_apply_writes();
+    for (uint32_t i = 0; i < sizeof(timers) / sizeof(timers[0]); i++)
+    {
+      _timer_apply_writes(&timers[i]);
+      if ((timers[i].p_tim->CR1 & TIM_CR1_CEN) && _timer_update_observable(&timers[i]))
+      {
+        uint64_t at = sim_cycles + _timer_cycles_to_update(&timers[i]);
+        if (at < next)
+        {
+          next = at;
+        }
+      }
+    }
+    for (uint32_t i = 0; i < NATIVE_SIM_MAX_EVENTS; i++)
+    {
+      if (events[i].armed && (events[i].at < next))
+      {
+        next = (events[i].at > sim_cycles) ? events[i].at : sim_cycles;
+      }
+    }
+
+    // Count up to the next event in every timer, and then raise the interrupts of the update events reached:
+    // the ISRs see the virtual time of the event and the final state of all the timers. The DMA transfers
+    // requested by the update events are done before any ISR runs
+    bool reaches_update[sizeof(timers) / sizeof(timers[0])];
+    bool raises_irq[sizeof(timers) / sizeof(timers[0])];
+    for (uint32_t i = 0; i < sizeof(timers) / sizeof(timers[0]); i++)
+    {
+      reaches_update[i] = (timers[i].p_tim->CR1 & TIM_CR1_CEN) && (sim_cycles + _timer_cycles_to_update(&timers[i]) == next);
+      raises_irq[i] = reaches_update[i] && _timer_irq_enabled(&timers[i]);
+      _timer_count(&timers[i], next - sim_cycles);
+    }
+    sim_cycles = next;
+    for (uint32_t i = 0; i < sizeof(timers) / sizeof(timers[0]); i++)
+    {
+      if (reaches_update[i])
+      {
+        _timer_update_outputs(&timers[i]);
+      }
+    }
+    for (uint32_t i = 0; i < sizeof(timers) / sizeof(timers[0]); i++)
+    {
+      if (raises_irq[i])
+      {
+        _call_isr(timers[i].irqn);
+        irq = true;
+      }
+    }
+    for (uint32_t i = 0; i < sizeof(dma_streams) / sizeof(dma_streams[0]); i++)
+    {
+      if (dma_streams[i].tc_pending)
+      {
+        dma_streams[i].tc_pending = false;
+        if (nvic_enabled[dma_streams[i].irqn])
+        {
+          _call_isr(dma_streams[i].irqn);
+          irq = true;
+        }
+      }
+    }
+
+    // Stimuli due now, in order of scheduling time
+    while (true)
+    {
+      sim_event_t *p_due = NULL;
+      for (uint32_t i = 0; i < NATIVE_SIM_MAX_EVENTS; i++)
+      {
+        if (events[i].armed && (events[i].at <= sim_cycles) && ((p_due == NULL) || (events[i].at < p_due->at)))
+        {
+          p_due = &events[i];
+        }
+      }
+      if (p_due == NULL)
+      {
+        break;
+      }
+      p_due->armed = false;
+      p_due->callback(p_due->arg);
+      irq = true;
+    }
+
+    if ((sim_cycles >= target) || (stop_at_irq && irq))
+    {
+      break;
+    }
+  }
+  in_isr = was_in_isr;
+  return irq;
+}
+
+/**
+ * @brief Next virtual time at which something can raise an interrupt: a timer update with its interrupt enabled or
+ * requesting a DMA transfer (the end of the transfer raises an interrupt), or a scheduled stimulus.
+ *
+ * @param p_at Pointer to store the virtual time
+ * @return true if there is a pending event
+ * @return false otherwise
+ */
+static bool _next_irq_time(uint64_t *p_at)
+{
+  bool found = false;
+  for (uint32_t i = 0; i < sizeof(timers) / sizeof(timers[0]); i++)
+  {
+    _timer_apply_writes(&timers[i]);
+    if ((timers[i].p_tim->CR1 & TIM_CR1_CEN) && (_timer_irq_enabled(&timers[i]) || _timer_requests_dma(&timers[i])))
+    {
+      uint64_t at = sim_cycles + _timer_cycles_to_update(&timers[i]);
+      if (!found || (at < *p_at))
+      {
+        *p_at = at;
+        found = true;
+      }
+    }
+  }
+  for (uint32_t i = 0; i < NATIVE_SIM_MAX_EVENTS; i++)
+  {
+    if (events[i].armed && (!found || (events[i].at < *p_at)))
+    {
+      *p_at = events[i].at;
+      found = true;
+    }
+  }
+  return found;
+}
+
+/**
+ * @brief Process the lines of the stimuli script until the next `@wait` or the end of the script.
+ *
+ * @param arg Unused
+ */
+static void _script_step(uint32_t arg)
+{
+  char line[SIM_SCRIPT_LINE_LENGTH + 1]; // Room for the line feed appended to USART lines
+  while ((p_script != NULL) && (fgets(line, SIM_SCRIPT_LINE_LENGTH, p_script) != NULL))
+  {
+    line[strcspn(line, "\r\n")] = '\0';
+    unsigned long value = 0;
+    if ((line[0] == '\0') || (line[0] == '#'))
+    {
+      continue;
+    }
+    if (sscanf(line, "@wait %lu", &value) == 1)
+    {
+      port_system_sim_schedule(sim_cycles + (uint64_t)value * (SystemCoreClock / 1000U), _script_step, arg);
+      return;
+    }
+    if (sscanf(line, "@press %lu", &value) == 1)
+    {
+      port_button_sim_press(BUTTON_0_ID, (uint32_t)value);
+      continue;
+    }
+    strcat(line, "\n");
+    port_usart_sim_receive(USART_0_ID, line, strlen(line));
+  }
+  if (p_script != NULL)
+  {
+    fclose(p_script);
+    p_script = NULL;
+  }
+}
+
+/**
+ * @brief Sleep until the next interrupt. If nothing can wake the system up, the simulation is over.
+ *
+ */
+static void _wait_for_interrupt(void)
+{
+  if (!port_system_sim_wait_for_event())
+  {
+    fflush(stdout);
+    exit(EXIT_SUCCESS);
+  }
+}
+
+//------------------------------------------------------
+// SYSTEM CONFIGURATION
+//------------------------------------------------------
+size_t port_system_init()
+{
+  sim_cycles = 0;
+  millis_offset = 0;
+  in_isr = false;
+  SystemCoreClock = HSI_VALUE;
+  memset(nvic_enabled, 0, sizeof(nvic_enabled));
+  memset(events, 0, sizeof(events));
+  memset(&native_gpioa, 0, sizeof(native_gpioa));
+  memset(&native_gpiob, 0, sizeof(native_gpiob));
+  memset(&native_gpioc, 0, sizeof(native_gpioc));
+  memset(&native_exti, 0, sizeof(native_exti));
+  memset(&native_tim2, 0, sizeof(native_tim2));
+  memset(&native_tim3, 0, sizeof(native_tim3));
+  memset(&native_tim4, 0, sizeof(native_tim4));
+  memset(&native_tim10, 0, sizeof(native_tim10));
+  memset(&native_tim11, 0, sizeof(native_tim11));
+  memset(&native_usart3, 0, sizeof(native_usart3));
+  memset(&native_dma1, 0, sizeof(native_dma1));
+  memset(&native_dma1_stream1, 0, sizeof(native_dma1_stream1));
+  memset(&native_dma1_stream4, 0, sizeof(native_dma1_stream4));
+  for (uint32_t i = 0; i < sizeof(timers) / sizeof(timers[0]); i++)
+  {
+    timers[i].psc = 0;
+    timers[i].arr = 0;
+    timers[i].ccr1 = 0;
+    timers[i].psc_cnt = 0;
+    timers[i].dma_index = 0;
+  }
+  for (uint32_t i = 0; i < sizeof(dma_streams) / sizeof(dma_streams[0]); i++)
+  {
+    dma_streams[i].running = false;
+    dma_streams[i].tc_pending = false;
+  }
+  // Buttons are active low: the pins idle high
+  native_gpioc.IDR = 0xFFFFU;
+
+  const char *p_path = getenv(NATIVE_SIM_SCRIPT_ENV);
+  if (p_path != NULL)
+  {
+    port_system_sim_run_script(p_path);
+  }
+  return 0;
+}
+
+//------------------------------------------------------
+// TIMER RELATED FUNCTIONS
+//------------------------------------------------------
+void port_system_systick_resume()
+{
+}
+
+void port_system_systick_suspend()
+{
+}
+
+uint32_t port_system_get_millis()
+{
+  return (uint32_t)((int64_t)(sim_cycles / (SystemCoreClock / 1000U)) + millis_offset);
+}
+
+void port_system_set_millis(uint32_t ms)
+{
+  millis_offset = (int64_t)ms - (int64_t)(sim_cycles / (SystemCoreClock / 1000U));
+}
+
+void port_system_delay_ms(uint32_t ms)
+{
+  port_system_sim_advance((uint64_t)ms * (SystemCoreClock / 1000U));
+}
+
+void port_system_delay_until_ms(uint32_t *p_t, uint32_t ms)
+{
+  uint32_t until = *p_t + ms;
+  uint32_t now = port_system_get_millis();
+  if (until > now)
+  {
+    port_system_delay_ms(until - now);
+  }
+  *p_t = port_system_get_millis();
+}
+
+/**
+ * @brief Read the cycle counter of the host: time stamp counter on x86, nanoseconds of the monotonic clock elsewhere.
+ *
+ * @return uint64_t
+ */
+static uint64_t _host_cycles(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+  return __rdtsc();
+#else
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000U + (uint64_t)ts.tv_nsec;
+#endif
+}
+
+void port_system_cycle_counter_init(void)
+{
+  cycle_counter_start = _host_cycles();
+}
+
+uint32_t port_system_get_cycle_count(void)
+{
+  return (uint32_t)(_host_cycles() - cycle_counter_start);
+}
+
+//------------------------------------------------------
+// GPIO RELATED FUNCTIONS
+//------------------------------------------------------
+void port_system_gpio_config(GPIO_TypeDef *p_port, uint8_t pin, uint8_t mode, uint8_t pupd)
+{
+  p_port->MODER &= ~(GPIO_MODER_MODER0 << (pin * 2U));
+  p_port->MODER |= (mode << (pin * 2U));
+
+  p_port->PUPDR &= ~(GPIO_PUPDR_PUPD0 << (pin * 2U));
+  p_port->PUPDR |= (pupd << (pin * 2U));
+}
+
+void port_system_gpio_config_exti(GPIO_TypeDef *p_port, uint8_t pin, uint32_t mode)
+{
+  EXTI->RTSR &= ~BIT_POS_TO_MASK(pin);
+  if (mode & TRIGGER_RISING_EDGE)
+  {
+    EXTI->RTSR |= BIT_POS_TO_MASK(pin);
+  }
+  EXTI->FTSR &= ~BIT_POS_TO_MASK(pin);
+  if (mode & TRIGGER_FALLING_EDGE)
+  {
+    EXTI->FTSR |= BIT_POS_TO_MASK(pin);
+  }
+  EXTI->EMR &= ~BIT_POS_TO_MASK(pin);
+  if (mode & TRIGGER_ENABLE_EVENT_REQ)
+  {
+    EXTI->EMR |= BIT_POS_TO_MASK(pin);
+  }
+  EXTI->IMR &= ~BIT_POS_TO_MASK(pin);
+  if (mode & TRIGGER_ENABLE_INTERR_REQ)
+  {
+    EXTI->IMR |= BIT_POS_TO_MASK(pin);
+  }
+}
+
+void port_system_gpio_exti_enable(uint8_t pin, uint8_t priority, uint8_t subpriority)
+{
+  NVIC_SetPriority(GET_PIN_IRQN(pin), NVIC_EncodePriority(NVIC_GetPriorityGrouping(), priority, subpriority));
+  NVIC_EnableIRQ(GET_PIN_IRQN(pin));
+}
+
+void port_system_gpio_exti_disable(uint8_t pin)
+{
+  NVIC_DisableIRQ(GET_PIN_IRQN(pin));
+}
+
+void port_system_gpio_config_alternate(GPIO_TypeDef *p_port, uint8_t pin, uint8_t alternate)
+{
+  uint32_t base_mask = 0x0FU;
+  uint32_t displacement = (pin % 8) * 4;
+
+  p_port->AFR[(uint8_t)(pin / 8)] &= ~(base_mask << displacement);
+  p_port->AFR[(uint8_t)(pin / 8)] |= (alternate << displacement);
+}
+
+bool port_system_gpio_read(GPIO_TypeDef *p_port, uint8_t pin)
+{
+  return (bool)(p_port->IDR & BIT_POS_TO_MASK(pin));
+}
+
+void port_system_gpio_write(GPIO_TypeDef *p_port, uint8_t pin, bool value)
+{
+  // Outputs are looped back to the input data register
+  if (value == true)
+  {
+    p_port->ODR |= BIT_POS_TO_MASK(pin);
+    p_port->IDR |= BIT_POS_TO_MASK(pin);
+  }
+  else
+  {
+    p_port->ODR &= ~BIT_POS_TO_MASK(pin);
+    p_port->IDR &= ~BIT_POS_TO_MASK(pin);
+  }
+}
+
+void port_system_gpio_toggle(GPIO_TypeDef *p_port, uint8_t pin)
+{
+  port_system_gpio_write(p_port, pin, !port_system_gpio_read(p_port, pin));
+}
+
+// ------------------------------------------------------
+// POWER RELATED FUNCTIONS
+// ------------------------------------------------------
+void port_system_power_stop()
+{
+  _wait_for_interrupt();
+}
+
+void port_system_power_sleep()
+{
+  _wait_for_interrupt();
+}
+
+void port_system_sleep(void)
+{
+  port_system_systick_suspend();
+  port_system_power_sleep();
+}
+
+// ------------------------------------------------------
+// NVIC STAND-IN
+// ------------------------------------------------------
+void NVIC_EnableIRQ(IRQn_Type irqn)
+{
+  if ((irqn >= 0) && (irqn < NATIVE_IRQN_COUNT))
+  {
+    nvic_enabled[irqn] = true;
+  }
+}
+
+void NVIC_DisableIRQ(IRQn_Type irqn)
+{
+  if ((irqn >= 0) && (irqn < NATIVE_IRQN_COUNT))
+  {
+    nvic_enabled[irqn] = false;
+  }
+}
+
+uint32_t NVIC_GetEnableIRQ(IRQn_Type irqn)
+{
+  if ((irqn >= 0) && (irqn < NATIVE_IRQN_COUNT))
+  {
+    return nvic_enabled[irqn] ? 1U : 0U;
+  }
+  return 0U;
+}
+
+void NVIC_SetPriority(IRQn_Type irqn, uint32_t priority)
+{
+}
+
+uint32_t NVIC_EncodePriority(uint32_t priority_group, uint32_t preempt_priority, uint32_t sub_priority)
+{
+  return (preempt_priority << 4) | sub_priority;
+}
+
+uint32_t NVIC_GetPriorityGrouping(void)
+{
+  return 0;
+}
+
+// ------------------------------------------------------
+// NATIVE SIMULATION
+// ------------------------------------------------------
+uint64_t port_system_sim_get_cycles(void)
+{
+  return sim_cycles;
+}
+
+void port_system_sim_advance(uint64_t cycles)
+{
+  if (in_isr)
+  {
+    return;
+  }
+  _advance_until(sim_cycles + cycles, false);
+}
+
+bool port_system_sim_wait_for_event(void)
+{
+  uint64_t at = 0;
+  if (in_isr)
+  {
+    return false;
+  }
+  // The core sleeps through the update events that only request DMA transfers
+  while (_next_irq_time(&at))
+  {
+    if (_advance_until((at > sim_cycles) ? at : sim_cycles, true))
+    {
+      return true;
+    }
+  }
+  return false;
+}
+
+void port_system_sim_apply_writes(void)
+{
+  for (uint32_t i = 0; i < sizeof(timers) / sizeof(timers[0]); i++)
+  {
+    _timer_apply_writes(&timers[i]);
+  }
+}
+
+void port_system_sim_poll(void)
+{
+  port_system_sim_advance(poll_cycles);
+}
+
+void port_system_sim_set_poll_cycles(uint32_t cycles)
+{
+  poll_cycles = cycles;
+}
+
+bool port_system_sim_schedule(uint64_t at_cycles, port_system_sim_callback_t callback, uint32_t arg)
+{
+  for (uint32_t i = 0; i < NATIVE_SIM_MAX_EVENTS; i++)
+  {
+    if (!events[i].armed)
+    {
+      events[i].armed = true;
+      events[i].at = at_cycles;
+      events[i].callback = callback;
+      events[i].arg = arg;
+      return true;
+    }
+  }
+  return false;
+}
+
+void port_system_sim_raise_irq(IRQn_Type irqn)
+{
+  if (NVIC_GetEnableIRQ(irqn))
+  {
+    _call_isr(irqn);
+  }
+}
+
+bool port_system_sim_in_isr(void)
+{
+  return in_isr;
+}
+
+bool port_system_sim_run_script(const char *p_path)
+{
+  if (p_script != NULL)
+  {
+    fclose(p_script);
+  }
+  p_script = fopen(p_path, "r");
+  if (p_script == NULL)
+  {
+    return false;
+  }
+  return port_system_sim_schedule(sim_cycles, _script_step, 0);
+}
@@ -0,0 +1,444 @@
+/**
+ * @file port_usart.c
+ * @brief Portable functions to interact with the USART FSM library (native platform).
+ *
+ * The USART is a register stand-in. Received bytes come from port_usart_sim_receive() (or the stimuli script)
+ * and are delivered one per byte time. Transmitted bytes are printed to the standard output.
+ *
+ * @author Javier de Ponte Hernando
+ * @author Roberto Maldonado Macafee
+ * @date 17/10/2026
+ */
+/* Includes ------------------------------------------------------------------*/
+/* Standard C libraries */
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include "port_system.h"
+#include "port_usart.h"
+#include "command_frame.h"
+/* HW dependent libraries */
+
+/* Typedefs --------------------------------------------------------------------*/
+/**
+ * @brief Simulated line of a USART: bytes on their way in and bytes already sent.
+ * 
+ */
+typedef struct
+{
+    char rx_fifo[NATIVE_SIM_USART_RX_FIFO_LENGTH]; /*!< Bytes pending to be received*/
+    uint32_t rx_head; /*!< Index of the next byte to receive*/
+    uint32_t rx_count; /*!< Number of bytes pending to be received*/
+    bool rx_pending; /*!< A reception event is scheduled*/
+    bool tx_pending; /*!< A TXE event is scheduled*/
+    char tx_capture[NATIVE_SIM_USART_TX_CAPTURE_LENGTH]; /*!< Bytes transmitted since the last read*/
+    uint32_t tx_count; /*!< Number of bytes in tx_capture*/
+} sim_usart_line_t;
+
+/* Global variables */
+/**
+ * @brief Array of elements that represents the HW characteristics of the USARTs \n
+ * This is an **extern** variable that is defined in port_usart.c . It represents an array of HWs USARTs \n 
+ * This is an **extern** variable that is declared in port_usart.h
+ * 
+ */
+port_usart_hw_t usart_arr[] = {
+[USART_0_ID] = {
+    .p_usart = USART_0,
+    .p_port_tx = USART_0_GPIO_TX,
+    .p_port_rx = USART_0_GPIO_RX,
+    .pin_tx = USART_0_PIN_TX,
+    .pin_rx = USART_0_PIN_RX,
+    .alt_func_tx = USART_0_AF_TX,
+    .alt_func_rx = USART_0_AF_RX,
+    .i_idx = 0,
+    .rx_head = 0,
+    .rx_tail = 0,
+    .rx_overflow = false,
+    .dropped_lines = 0,
+    .rx_frame = false,
+    .frame_length = 0,
+    .frame_crc = USART_FRAME_CRC_INIT,
+    .bad_frames = 0,
+    .o_idx = 0,
+    .write_complete = false}
+};
+
+static sim_usart_line_t sim_lines[sizeof(usart_arr) / sizeof(usart_arr[0])]; /*!< Simulated lines of the USARTs*/
+
+/* Private functions */
+/**
+ * @brief Reset a buffer to a default value
+ * 
+ * @param buffer Pointer to the buffer to be reseted
+ * @param length Length of the buffer
+ */
+static void _reset_buffer(char * buffer, uint32_t length){
+    memset(buffer, EMPTY_BUFFER_CONSTANT, length);
+}
+
+/**
+ * @brief Store a byte of the binary frame being received, from its start byte to the last byte of its CRC. \n
+ * The CRC is checked as the bytes arrive: the CRC-16 of a frame followed by its CRC is 0. A frame with no errors is
+ * queued as a line, without its CRC. A frame with a wrong length or CRC is dropped, and the next byte may start a line.
+ * 
+ * @param p_hw Pointer to the USART
+ * @param data Byte received
+ */
+static void _store_frame_byte(port_usart_hw_t *p_hw, uint8_t data){
+    uint8_t idx = p_hw -> i_idx;
+    char *p_line = p_hw -> input_lines[p_hw -> rx_tail % USART_RX_QUEUE_DEPTH];
+    bool queued = false;
+    //The start byte is not part of the CRC
+    if (idx > 0){
+        p_hw -> frame_crc = command_frame_crc16_update(p_hw -> frame_crc, data);
+    }
+    //The CRC is not stored: the line holds the header and the payload
+    if (!p_hw -> rx_overflow && ((p_hw -> frame_length == 0) || (idx < p_hw -> frame_length - USART_FRAME_CRC_LENGTH))){
+        p_line[idx] = (char)data;
+    }
+    p_hw -> i_idx = idx + 1;
+    if (idx == USART_FRAME_HEADER_LENGTH - 1){
+        //The length of the payload tells where the frame ends. A payload that does not fit in a line is not a frame
+        if (data <= USART_FRAME_MAX_PAYLOAD){
+            p_hw -> frame_length = USART_FRAME_HEADER_LENGTH + data + USART_FRAME_CRC_LENGTH;
+            return;
+        }
+        p_hw -> bad_frames++;
+    }
+    else if ((p_hw -> frame_length == 0) || (p_hw -> i_idx < p_hw -> frame_length)){
+        return;
+    }
+    else if (p_hw -> rx_overflow){
+        //A frame that started while the queue was full is dropped, whole
+        p_hw -> dropped_lines++;
+    }
+    else if (p_hw -> frame_crc == 0){
+        //The frame is complete and has no errors: queue it
+        p_hw -> rx_tail++;
+        queued = true;
+    }
+    else {
+        p_hw -> bad_frames++;
+    }
+    //The frame has ended. The bytes of a frame with errors are not left in the line, unless it is a line queued
+    if (!queued && !p_hw -> rx_overflow){
+        _reset_buffer(p_line, USART_INPUT_BUFFER_LENGTH);
+    }
+    p_hw -> rx_frame = false;
+    p_hw -> rx_overflow = false;
+    p_hw -> i_idx = 0;
+}
+
+/**
+ * @brief Number of core clock cycles needed to send or receive one byte (start bit, 8 data bits and stop bit).
+ * 
+ * @return uint64_t 
+ */
+static uint64_t _byte_cycles(void){
+    return ((uint64_t)SystemCoreClock * 10U) / USART_0_BAUDRATE;
+}
+
+/**
+ * @brief Interrupt line of a USART.
+ * 
+ * @param usart_id This index is used to select the element of the usart_arr[] array.
+ * @return IRQn_Type 
+ */
+static IRQn_Type _irqn(uint32_t usart_id){
+    (void)usart_id;
+    return USART3_IRQn;
+}
+
+/**
+ * @brief Deliver the next pending byte to the Data Register and raise the RXNE interrupt. \n
+ * If the previous byte has not been read yet, it is overwritten (overrun).
+ * 
+ * @param usart_id This index is used to select the element of the usart_arr[] array.
+ */
+static void _rx_event(uint32_t usart_id){
+    sim_usart_line_t *p_line = &sim_lines[usart_id];
+    USART_TypeDef *p_usart = usart_arr[usart_id].p_usart;
+    p_line->rx_pending = false;
+    if (p_line->rx_count == 0){
+        return;
+    }
+    p_usart -> DR = (uint8_t)p_line->rx_fifo[p_line->rx_head];
+    p_line->rx_head = (p_line->rx_head + 1) % NATIVE_SIM_USART_RX_FIFO_LENGTH;
+    p_line->rx_count--;
+    p_usart -> SR |= USART_SR_RXNE;
+    if ((p_usart -> CR1 & USART_CR1_UE) && (p_usart -> CR1 & USART_CR1_RXNEIE)){
+        port_system_sim_raise_irq(_irqn(usart_id));
+        // Reading DR in the ISR clears RXNE
+        p_usart -> SR &= ~USART_SR_RXNE;
+    }
+    if (p_line->rx_count > 0){
+        p_line->rx_pending = port_system_sim_schedule(port_system_sim_get_cycles() + _byte_cycles(), _rx_event, usart_id);
+    }
+}
+
+/**
+ * @brief The transmit data register is empty again: set TXE and raise the interrupt if it is enabled.
+ * 
+ * @param usart_id This index is used to select the element of the usart_arr[] array.
+ */
+static void _tx_event(uint32_t usart_id){
+    USART_TypeDef *p_usart = usart_arr[usart_id].p_usart;
+    sim_lines[usart_id].tx_pending = false;
+    p_usart -> SR |= USART_SR_TXE | USART_SR_TC;
+    if ((p_usart -> CR1 & USART_CR1_UE) && (p_usart -> CR1 & USART_CR1_TXEIE)){
+        port_system_sim_raise_irq(_irqn(usart_id));
+    }
+}
+
+/**
+ * @brief Send a byte through the simulated line. It replaces the write of the Data Register: the transmitter is
+ * busy for one byte time.
+ * 
+ * @param usart_id This index is used to select the element of the usart_arr[] array.
+ * @param data Byte to send
+ */
+static void _transmit(uint32_t usart_id, char data){
+    sim_usart_line_t *p_line = &sim_lines[usart_id];
+    usart_arr[usart_id].p_usart -> SR &= ~(USART_SR_TXE | USART_SR_TC);
+    putchar(data);
+    if (data == END_CHAR_CONSTANT){
+        fflush(stdout);
+    }
+    if (p_line->tx_count < NATIVE_SIM_USART_TX_CAPTURE_LENGTH){
+        p_line->tx_capture[p_line->tx_count++] = data;
+    }
+    if (!p_line->tx_pending){
+        p_line->tx_pending = port_system_sim_schedule(port_system_sim_get_cycles() + _byte_cycles(), _tx_event, usart_id);
+    }
+}
+
+/* Public functions */
+
+
+void port_usart_init(uint32_t usart_id)
+{
+    USART_TypeDef *p_usart = usart_arr[usart_id].p_usart;
+    GPIO_TypeDef *p_port_tx = usart_arr[usart_id].p_port_tx;
+    GPIO_TypeDef *p_port_rx = usart_arr[usart_id].p_port_rx;
+    uint8_t pin_tx = usart_arr[usart_id].pin_tx;
+    uint8_t pin_rx = usart_arr[usart_id].pin_rx;
+    uint8_t alt_func_tx = usart_arr[usart_id].alt_func_tx;
+    uint8_t alt_func_rx = usart_arr[usart_id].alt_func_rx;
+
+    // Enable USART interrupts globally
+    if (p_usart == USART3)
+    {
+        NVIC_SetPriority(USART3_IRQn, NVIC_EncodePriority(NVIC_GetPriorityGrouping(), 2, 0));
+        NVIC_EnableIRQ(USART3_IRQn);
+    }
+
+    //configure USART TX and RX pins as ALTERNATE and PULL UP
+    port_system_gpio_config(p_port_tx, pin_tx, GPIO_MODE_ALTERNATE, GPIO_PUPDR_PUP);
+    port_system_gpio_config(p_port_rx, pin_rx, GPIO_MODE_ALTERNATE, GPIO_PUPDR_PUP);
+    port_system_gpio_config_alternate(p_port_tx, pin_tx, alt_func_tx);
+    port_system_gpio_config_alternate(p_port_rx, pin_rx, alt_func_rx);
+    //Disable the USART
+    p_usart -> CR1 &= ~USART_CR1_UE;
+    // 9600-8-N-1. Only the baud rate is simulated
+    p_usart -> BRR = 0x0682;
+    //Enable TX and RX
+    p_usart -> CR1 |= USART_CR1_TE | USART_CR1_RE;
+    //Disable TX and RX interrupt
+    p_usart -> CR1 &= ~USART_CR1_RXNEIE; 
+    p_usart -> CR1 &= ~USART_CR1_TXEIE; 
+    //Reset value of the status register: transmitter empty and idle
+    p_usart -> SR = USART_SR_TXE | USART_SR_TC;
+    //Enable the USART
+    p_usart -> CR1 |= USART_CR1_UE;
+    //reset buffers
+    _reset_buffer(usart_arr[usart_id].input_lines[0], sizeof(usart_arr[usart_id].input_lines));
+    _reset_buffer(usart_arr[usart_id].output_buffer, USART_OUTPUT_BUFFER_LENGTH);
+    usart_arr[usart_id].i_idx = 0;
+    usart_arr[usart_id].o_idx = 0;
+    usart_arr[usart_id].rx_head = 0;
+    usart_arr[usart_id].rx_tail = 0;
+    usart_arr[usart_id].rx_overflow = false;
+    usart_arr[usart_id].dropped_lines = 0;
+    usart_arr[usart_id].rx_frame = false;
+    usart_arr[usart_id].frame_length = 0;
+    usart_arr[usart_id].bad_frames = 0;
+    usart_arr[usart_id].write_complete = false;
+    memset(&sim_lines[usart_id], 0, sizeof(sim_lines[usart_id]));
+}
+
+
+void port_usart_get_from_input_buffer(uint32_t usart_id, char * p_buffer){
+    memcpy(p_buffer, usart_arr[usart_id].input_lines[usart_arr[usart_id].rx_head % USART_RX_QUEUE_DEPTH], USART_INPUT_BUFFER_LENGTH);
+}
+
+
+bool port_usart_get_txr_status(uint32_t usart_id ){
+    port_system_sim_poll();
+    if(( usart_arr[usart_id].p_usart -> SR & USART_SR_TXE) == 0){
+        return false;
+    } else {
+        return true;
+    }
+}
+
+
+void port_usart_reset_input_buffer( uint32_t usart_id ){
+    uint32_t rx_head = usart_arr[usart_id].rx_head;
+    if (rx_head != usart_arr[usart_id].rx_tail){
+        //The line is cleared before it is released: the ISR only writes lines released
+        _reset_buffer(usart_arr[usart_id].input_lines[rx_head % USART_RX_QUEUE_DEPTH], USART_INPUT_BUFFER_LENGTH);
+        usart_arr[usart_id].rx_head = rx_head + 1;
+    }
+}
+
+
+uint32_t port_usart_get_dropped_lines( uint32_t usart_id ){
+    return usart_arr[usart_id].dropped_lines;
+}
+
+
+uint32_t port_usart_get_bad_frames( uint32_t usart_id ){
+    return usart_arr[usart_id].bad_frames;
+}
+
+
+void port_usart_reset_output_buffer( uint32_t usart_id ){
+    _reset_buffer(usart_arr[usart_id].output_buffer, USART_OUTPUT_BUFFER_LENGTH);
+    usart_arr[usart_id].write_complete = false;
+}
+
+
+bool port_usart_rx_done( uint32_t usart_id ){
+    port_system_sim_poll();
+    return usart_arr[usart_id].rx_head != usart_arr[usart_id].rx_tail;
+}
+
+
+bool port_usart_tx_done( uint32_t usart_id ){
+    port_system_sim_poll();
+    return usart_arr[usart_id].write_complete;
+}
+
+
+void port_usart_store_data( uint32_t usart_id ){
+   //Retrieve data from DR register
+   char data = usart_arr[usart_id].p_usart -> DR; 
+   port_usart_hw_t *p_hw = &usart_arr[usart_id];
+   //A line that starts while the queue is full is dropped, whole
+   bool queue_full = (p_hw -> rx_tail - p_hw -> rx_head) >= USART_RX_QUEUE_DEPTH;
+
+   //The bytes of a binary frame are decoded one by one: an end char is part of its payload
+   if (p_hw -> rx_frame){
+    _store_frame_byte(p_hw, (uint8_t)data);
+    return;
+   }
+   if ((p_hw -> i_idx == 0) && !p_hw -> rx_overflow && ((uint8_t)data == USART_FRAME_START_CONSTANT)){
+    //A binary frame starts. It is dropped, whole, if the queue is full
+    p_hw -> rx_frame = true;
+    p_hw -> rx_overflow = queue_full;
+    p_hw -> frame_length = 0;
+    p_hw -> frame_crc = USART_FRAME_CRC_INIT;
+    _store_frame_byte(p_hw, (uint8_t)data);
+    return;
+   }
+   if( data != END_CHAR_CONSTANT){
+    if (queue_full || p_hw -> rx_overflow){
+        p_hw -> rx_overflow = true;
+        return;
+    }
+    //Retrieve input data index. Wrap around if the line is full
+    if(p_hw -> i_idx >= USART_INPUT_BUFFER_LENGTH){
+        p_hw -> i_idx = 0;
+    }
+    //Load data in the line being received and update input buffer index
+    p_hw -> input_lines[p_hw -> rx_tail % USART_RX_QUEUE_DEPTH][p_hw -> i_idx] = data;
+    p_hw -> i_idx++;
+   } else {
+    //The line is complete: queue it, or count it as dropped. Reset input buffer index
+    if (queue_full || p_hw -> rx_overflow){
+        p_hw -> dropped_lines++;
+    }
+    else {
+        p_hw -> rx_tail++;
+    }
+    p_hw -> rx_overflow = false;
+    p_hw -> i_idx = 0;
+   }
+}
+
+
+void port_usart_write_data(uint32_t usart_id){
+    //Retrieve output buffer index and data at index
+    uint8_t o_idx = usart_arr[usart_id].o_idx;
+    char data = usart_arr[usart_id].output_buffer[o_idx];
+    if( o_idx == USART_OUTPUT_BUFFER_LENGTH - 1 || data == END_CHAR_CONSTANT){
+        //Send the last byte
+        _transmit(usart_id, data);
+        //Disable TX interrupt
+        usart_arr[usart_id].p_usart -> CR1 &= ~USART_CR1_TXEIE; 
+        //Reset output buffer index. Update write_complete
+        usart_arr[usart_id].o_idx = 0;
+        usart_arr[usart_id].write_complete = true;
+    } else {
+        if (data != EMPTY_BUFFER_CONSTANT){ 
+        //Send data and update o_idx
+        _transmit(usart_id, data);
+        usart_arr[usart_id].o_idx++;}
+    }
+}
+
+
+void port_usart_enable_rx_interrupt( uint32_t usart_id ){
+    usart_arr[usart_id].p_usart -> CR1 |= USART_CR1_RXNEIE;
+}
+
+
+void port_usart_enable_tx_interrupt( uint32_t usart_id ){
+    usart_arr[usart_id].p_usart -> CR1 |= USART_CR1_TXEIE;
+    // The interrupt is raised right away if the transmitter is already empty
+    if (!sim_lines[usart_id].tx_pending){
+        sim_lines[usart_id].tx_pending = port_system_sim_schedule(port_system_sim_get_cycles(), _tx_event, usart_id);
+    }
+}
+
+
+void port_usart_disable_rx_interrupt( uint32_t usart_id ){
+    usart_arr[usart_id].p_usart -> CR1 &= ~USART_CR1_RXNEIE;
+}
+
+
+void port_usart_disable_tx_interrupt( uint32_t usart_id ){
+    usart_arr[usart_id].p_usart -> CR1 &= ~USART_CR1_TXEIE;
+}
+
+void port_usart_copy_to_output_buffer (uint32_t usart_id, char * p_data, uint32_t length )	{
+    memcpy( usart_arr[usart_id].output_buffer, p_data, length);
+}
+
+uint32_t port_usart_sim_receive (uint32_t usart_id, const char *p_data, uint32_t length){
+    sim_usart_line_t *p_line = &sim_lines[usart_id];
+    uint32_t queued = 0;
+    while ((queued < length) && (p_line->rx_count < NATIVE_SIM_USART_RX_FIFO_LENGTH)){
+        p_line->rx_fifo[(p_line->rx_head + p_line->rx_count) % NATIVE_SIM_USART_RX_FIFO_LENGTH] = p_data[queued];
+        p_line->rx_count++;
+        queued++;
+    }
+    if ((p_line->rx_count > 0) && !p_line->rx_pending){
+        p_line->rx_pending = port_system_sim_schedule(port_system_sim_get_cycles() + _byte_cycles(), _rx_event, usart_id);
+    }
+    return queued;
+}
+
+uint32_t port_usart_sim_read_output (uint32_t usart_id, char *p_buffer, uint32_t length){
+    sim_usart_line_t *p_line = &sim_lines[usart_id];
+    if (length == 0){
+        return 0;
+    }
+    uint32_t count = (p_line->tx_count < length - 1) ? p_line->tx_count : length - 1;
+    memcpy(p_buffer, p_line->tx_capture, count);
+    p_buffer[count] = EMPTY_BUFFER_CONSTANT;
+    memmove(p_line->tx_capture, &p_line->tx_capture[count], p_line->tx_count - count);
+    p_line->tx_count -= count;
+    return count;
+}
@@ -0,0 +1,41 @@
+/**
+ * @file port_melody_bank.h
+ * @brief Header for port_melody_bank.c file.
+ * @author Javier de Ponte Hernando
+ * @author Roberto Maldonado Macafee
+ * @date 18/10/2026
+ */
+#ifndef PORT_MELODY_BANK_H_
+#define PORT_MELODY_BANK_H_
+
+/* Includes ------------------------------------------------------------------*/
+/* Standard C includes */
+#include <stdint.h>
+
+/* Defines and enums ----------------------------------------------------------*/
+#define PORT_MELODY_BANK_NUM_SLOTS 2U /*!< Slots of the double buffer to load a new melody bank while the jukebox runs */
+#define PORT_MELODY_BANK_SLOT_SIZE 0x20000U /*!< Size of a slot in bytes: one 128 KB sector of the flash */
+#define PORT_MELODY_BANK_SLOT_0_ADDRESS 0x08040000U /*!< Address of slot 0: sector 6 of the flash. The firmware must fit in sectors 0 to 5 */
+#define PORT_MELODY_BANK_SLOT_1_ADDRESS 0x08060000U /*!< Address of slot 1: sector 7 of the flash */
+
+/* Function prototypes and explanation -------------------------------------------------*/
+/**
+ * @brief Get the image of the melody bank of the jukebox. It is linked in flash and read in place.
+ *
+ * @param p_size Pointer to store the size of the image in bytes
+ * @return const void* Pointer to the image, 4-byte aligned
+ */
+const void *port_melody_bank_get(uint32_t *p_size);
+
+/**
+ * @brief Get the image of a slot of the double buffer of the melody bank. \n
+ * A slot is a sector of the flash, reflashed with a new bank image (e.g. with `st-flash write bank.bin <address>`)
+ * while the jukebox plays from the other one. The image returned must be validated with melody_bank_open().
+ *
+ * @param slot Index of the slot, less than PORT_MELODY_BANK_NUM_SLOTS
+ * @param p_size Pointer to store the size of the slot in bytes
+ * @return const void* Pointer to the image, 4-byte aligned, or NULL if the slot does not exist
+ */
+const void *port_melody_bank_get_slot(uint32_t slot, uint32_t *p_size);
+
+#endif /* PORT_MELODY_BANK_H_ */
@@ -0,0 +1,50 @@
+/**
+ * @file port_storage.h
+ * @brief Header for port_storage.c file.
+ * @author Javier de Ponte Hernando
+ * @author Roberto Maldonado Macafee
+ * @date 18/10/2026
+ */
+#ifndef PORT_STORAGE_H_
+#define PORT_STORAGE_H_
+
+/* Includes ------------------------------------------------------------------*/
+/* Standard C includes */
+#include <stdint.h>
+#include <stdbool.h>
+
+/* HW dependent includes */
+#include "stm32f4xx.h"
+
+/* Defines and enums ----------------------------------------------------------*/
+#define STORAGE_SPI SPI2 /*!< SPI of the SPI flash that holds the library of streamed melodies */
+#define STORAGE_GPIO GPIOB /*!< GPIO port of the pins of the SPI flash */
+#define STORAGE_PIN_CS 12 /*!< GPIO pin of the chip select of the SPI flash (active low) */
+#define STORAGE_PIN_SCK 13 /*!< GPIO pin of SPI2 SCK */
+#define STORAGE_PIN_MISO 14 /*!< GPIO pin of SPI2 MISO */
+#define STORAGE_PIN_MOSI 15 /*!< GPIO pin of SPI2 MOSI */
+#define STORAGE_AF 5 /*!< Alternate function of SPI2 */
+#define STORAGE_CMD_READ 0x03 /*!< Command of the SPI flash to read data from a 24-bit address */
+#define STORAGE_CMD_JEDEC_ID 0x9F /*!< Command of the SPI flash to read its JEDEC ID: manufacturer, type and log2 of the capacity */
+
+/* Function prototypes and explanation -------------------------------------------------*/
+/**
+ * @brief Initialize the storage device that holds the library of streamed melodies: an SPI flash (e.g. W25Q) on SPI2. \n
+ * The size of the device is read from its JEDEC ID.
+ *
+ * @return uint32_t Size of the device in bytes, 0 if there is none
+ */
+uint32_t port_storage_init(void);
+
+/**
+ * @brief Read data from the storage device, polling the SPI.
+ *
+ * @param address Address of the data in the device
+ * @param p_data Pointer to store the data
+ * @param size Number of bytes to read
+ * @return true if the data has been read
+ * @return false if the data is not within the device
+ */
+bool port_storage_read(uint32_t address, void *p_data, uint32_t size);
+
+#endif /* PORT_STORAGE_H_ */
@@ -272,4 +272,17 @@ void port_system_systick_resume();
  */
 void port_system_systick_suspend();
 
+/**
+ * @brief Enable and reset the cycle counter of the core (DWT CYCCNT). Used to measure the cost of code paths.
+ * 
+ */
+void port_system_cycle_counter_init(void);
+
+/**
+ * @brief Get the number of core clock cycles counted since port_system_cycle_counter_init(). It wraps around at 2^32.
+ * 
+ * @return uint32_t 
+ */
+uint32_t port_system_get_cycle_count(void);
+
 #endif /* PORT_SYSTEM_H_ */
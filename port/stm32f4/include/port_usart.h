@@ -27,10 +27,17 @@
 #define 	USART_0_PIN_RX 11 /*!< USART GPIO pin for RX*/
 #define 	USART_0_AF_TX 7 /*!< USART alternate function for TX*/
 #define 	USART_0_AF_RX 7/*!< USART alternate function for RX*/
-#define 	USART_INPUT_BUFFER_LENGTH 10 /*!< USART input message length*/
+#define 	USART_INPUT_BUFFER_LENGTH 32 /*!< USART input message length. Long enough for a command with two parameters*/
 #define 	USART_OUTPUT_BUFFER_LENGTH 100 /*!< USART output message length*/
+#define 	USART_RX_QUEUE_DEPTH 4 /*!< Lines received that can wait to be read. Lines received while the queue is full are dropped*/
 #define 	EMPTY_BUFFER_CONSTANT 0x0 /*!< Empty char constant*/
 #define 	END_CHAR_CONSTANT 0xA /*!< End char constant*/
+#define 	USART_FRAME_START_CONSTANT 0xA5 /*!< First byte of a binary frame. It is not a character of a text line*/
+#define 	USART_FRAME_HEADER_LENGTH 3 /*!< Bytes of a binary frame before its payload: start byte, opcode and length of the payload*/
+#define 	USART_FRAME_CRC_LENGTH 2 /*!< Bytes of the CRC-16 that ends a binary frame, most significant byte first*/
+#define 	USART_FRAME_MAX_PAYLOAD (USART_INPUT_BUFFER_LENGTH - USART_FRAME_HEADER_LENGTH) /*!< Maximum length of the payload of a binary frame: the frame is queued as a line, without its CRC*/
+#define 	USART_FRAME_CRC_INIT 0xFFFF /*!< Initial value of the CRC-16 of a binary frame (CRC-16/CCITT-FALSE)*/
+#define 	USART_FRAME_CRC_POLY 0x1021 /*!< Polynomial of the CRC-16 of a binary frame*/
 
 /* Typedefs --------------------------------------------------------------------*/
 /**
@@ -45,9 +52,16 @@ typedef struct{
     uint8_t pin_rx; /*!< Pin/line where the USART RX is connected*/
     uint8_t alt_func_tx; /*!< Alternate function for the TX pin*/
     uint8_t alt_func_rx; /*!< Alternate function for the RX pin*/
-    char input_buffer [USART_INPUT_BUFFER_LENGTH]; /*!< Input buffer*/
-    uint8_t i_idx; /*!< Index to the input buffer*/
-    bool read_complete; /*!< Flag to indicate that the data has been read*/
+    char input_lines [USART_RX_QUEUE_DEPTH][USART_INPUT_BUFFER_LENGTH]; /*!< Queue of lines received: line i is at i % USART_RX_QUEUE_DEPTH*/
+    uint8_t i_idx; /*!< Index to the line being received*/
+    volatile uint32_t rx_head; /*!< Index of the oldest line received not read yet. Only moved by the reader*/
+    volatile uint32_t rx_tail; /*!< Index of the line being received. Only moved by the ISR: the queue holds the lines rx_head to rx_tail - 1*/
+    bool rx_overflow; /*!< Flag to indicate that the line being received is dropped because the queue was full*/
+    volatile uint32_t dropped_lines; /*!< Lines dropped because the queue was full*/
+    bool rx_frame; /*!< Flag to indicate that the line being received is a binary frame: it ends after its length, not at an end char*/
+    uint8_t frame_length; /*!< Bytes of the binary frame being received, from its start byte to its CRC. 0 until its length is received*/
+    uint16_t frame_crc; /*!< CRC-16 of the binary frame being received, updated byte by byte. It is 0 after the CRC of a frame with no errors*/
+    volatile uint32_t bad_frames; /*!< Binary frames dropped because of a wrong length or CRC*/
     char output_buffer [USART_OUTPUT_BUFFER_LENGTH]; /*!< Output buffer*/
     uint8_t o_idx; /*!< Index to the output buffer*/
     bool write_complete; /*!< Flag to indicate that the data has been sent*/
@@ -81,7 +95,7 @@ void port_usart_init (uint32_t usart_id);
 bool port_usart_tx_done (uint32_t usart_id);
 
 /**
- * @brief Check if a reception is completed
+ * @brief Check if a reception is completed: there is a line in the queue of lines received
  * 
  * @param usart_id This index is used to select the element of the usart_arr[] array.
  * @return true 
@@ -90,7 +104,7 @@ bool port_usart_tx_done (uint32_t usart_id);
 bool port_usart_rx_done (uint32_t usart_id);
 
 /**
- * @brief Get the message received through the USART and store it in the buffer passed as an argument \n
+ * @brief Get the oldest message received through the USART and store it in the buffer passed as an argument \n
  * This function is called from the function do_get_data_rx() of the FSM to store the message received
  * to the buffer of the FSM
  *  
@@ -120,12 +134,29 @@ void port_usart_copy_to_output_buffer (uint32_t usart_id, char *p_data, uint32_t
 
 /**
  * @brief Reset the input buffer of the USART. \n 
- * This function is called from do_get_data_rx() to reset the input buffer of the USART after the message has been read.
+ * This function is called from do_get_data_rx() to remove the oldest message from the queue of lines received after it has been read.
+ * The next message, if any, becomes the oldest one.
  * 
   * @param usart_id This index is used to select the element of the usart_arr[] array.
  */
 void port_usart_reset_input_buffer (uint32_t usart_id);
 
+/**
+ * @brief Get the number of lines dropped because they were received while the queue of lines received was full.
+ * 
+ * @param usart_id This index is used to select the element of the usart_arr[] array.
+ * @return uint32_t Number of lines dropped since the USART was initialized
+ */
+uint32_t port_usart_get_dropped_lines (uint32_t usart_id);
+
+/**
+ * @brief Get the number of binary frames dropped because their length or their CRC was wrong.
+ * 
+ * @param usart_id This index is used to select the element of the usart_arr[] array.
+ * @return uint32_t Number of frames dropped since the USART was initialized
+ */
+uint32_t port_usart_get_bad_frames (uint32_t usart_id);
+
 /**
  * @brief Reset the output buffer of the USART. \n 
  * This function is called from do_set_data_tx() and do_tx_end() to reset the output buffer of the USART after the message has been read.
@@ -137,6 +168,7 @@ void port_usart_reset_output_buffer (uint32_t usart_id);
 /**
  * @brief Function to read the data from the USART Data Register and store it in the input buffer. \n 
  * This function is called from the ISR USART3_IRQHandler() when the RXNE flag is set \n 
+ * A line that starts with USART_FRAME_START_CONSTANT is a binary frame: it is decoded byte by byte, and queued once its CRC has been checked \n 
  * ![Implements](docs/assets/imgs/flow_graph_store_data.png)
  * 
  * @param usart_id This index is used to select the element of the usart_arr[] array.
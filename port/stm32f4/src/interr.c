@@ -97,5 +97,17 @@ void USART3_IRQHandler(void ){
  */
 void TIM2_IRQHandler ( void ) {
     TIM2 -> SR &= ~TIM_SR_UIF;
-    buzzers_arr[BUZZER_0_ID].note_end = true;
+    port_buzzer_update_note(BUZZER_0_ID);
 }	
+
+/**
+ * @brief This function handles DMA1 stream 4 global interrupt. \n 
+ * This stream writes the notes of a melody played by DMA into the timer that controls the frequency of the note. The end of its transfer is the end of the melody.
+ */
+void DMA1_Stream4_IRQHandler ( void ) {
+    port_system_systick_resume();
+    if (DMA1 -> HISR & DMA_HISR_TCIF4) {
+        DMA1 -> HIFCR = DMA_HIFCR_CTCIF4;
+        port_buzzer_dma_end(BUZZER_0_ID);
+    }
+}
@@ -10,13 +10,34 @@
 #include <math.h>
 /* HW dependent libraries */
 #include "port_buzzer.h"
+#include "note_table.h"
 #define ALT_FUNC2_TIM3 2
+#define ALT_FUNC2_TIM4 2 /*!< Alternate function of TIM4 CH1 on PB6 */
+#define ALT_FUNC3_TIM10 3 /*!< Alternate function of TIM10 CH1 on PB8 */
+#define ALT_FUNC3_TIM11 3 /*!< Alternate function of TIM11 CH1 on PB9 */
 #define TIM_AS_PWM1_MASK 0x0060 
+#define TIM_PSC_WORD_OFFSET 10U /*!< Offset of PSC from the first register of a timer, in words. DMA base address of the bursts of the duration timer */
+#define TIM_ARR_WORD_OFFSET 11U /*!< Offset of ARR from the first register of a timer, in words. DMA base address of the bursts of the PWM timer */
+#define DMA_DURATION_FRAME_WORDS 2U /*!< Words written into the duration timer per note: PSC and ARR */
+#define DMA_PWM_FRAME_WORDS 3U /*!< Words written into the PWM timer per note: ARR, RCR (not used by TIM3) and CCR1 */
+#define DMA_CHANNEL_TIM2_UP 3U /*!< Channel of TIM2_UP in DMA1 stream 1 */
+#define DMA_CHANNEL_TIM3_TRIG 5U /*!< Channel of TIM3_TRIG in DMA1 stream 4 */
+#define DMA_DURATION_PADDING 0xFFFFU /*!< PSC and ARR of the duration timer after the last note: longest period, until the end of the transfer */
 /* Global variables */
 port_buzzer_hw_t buzzers_arr [] = {
     [BUZZER_0_ID] = {.p_port = BUZZER_0_GPIO, .pin = BUZZER_0_PIN, .alt_func = BUZZER_PWM_DC, .note_end = false}, 
 };
 
+port_buzzer_voice_hw_t voices_arr [] = {
+    [0] = {.p_tim = TIM3, .p_port = BUZZER_0_GPIO, .pin = BUZZER_0_PIN, .alt_func = ALT_FUNC2_TIM3},
+    [1] = {.p_tim = TIM4, .p_port = BUZZER_VOICE_1_GPIO, .pin = BUZZER_VOICE_1_PIN, .alt_func = ALT_FUNC2_TIM4},
+    [2] = {.p_tim = TIM10, .p_port = BUZZER_VOICE_2_GPIO, .pin = BUZZER_VOICE_2_PIN, .alt_func = ALT_FUNC3_TIM10},
+    [3] = {.p_tim = TIM11, .p_port = BUZZER_VOICE_3_GPIO, .pin = BUZZER_VOICE_3_PIN, .alt_func = ALT_FUNC3_TIM11},
+};
+
+static uint32_t dma_duration_frames[(PORT_BUZZER_DMA_MAX_NOTES + 2U) * DMA_DURATION_FRAME_WORDS]; /*!< PSC and ARR of the duration timer of the notes played by DMA, plus two padding frames */
+static uint32_t dma_pwm_frames[(PORT_BUZZER_DMA_MAX_NOTES + 1U) * DMA_PWM_FRAME_WORDS]; /*!< ARR, RCR and CCR1 of the PWM timer of the notes played by DMA, plus a silence */
+
 
 /* Private functions */
 /**
@@ -75,6 +96,365 @@ static void _timer_pwm_setup	(	uint32_t 	buzzer_id	)	{
 
 
 
+/**
+ * @brief Configure the timers of the extra voices of the buzzer: one PWM channel each (CH1), as the timer of the main voice. \n
+ * The four channels of TIM3 share its prescaler and period, so each voice needs a timer of its own to play its own frequency.
+ * 
+ * @param buzzer_id Buzzer melody player ID. This index is used to select the element of the buzzers_arr[] array
+ */
+static void _timer_voices_setup(uint32_t buzzer_id)
+{
+  if (buzzer_id == BUZZER_0_ID)
+  {
+    RCC->APB1ENR |= RCC_APB1ENR_TIM4EN;
+    RCC->APB2ENR |= RCC_APB2ENR_TIM10EN | RCC_APB2ENR_TIM11EN;
+
+    for (uint32_t voice = 1; voice < PORT_BUZZER_MAX_VOICES; voice++)
+    {
+      port_buzzer_voice_hw_t *p_voice = &voices_arr[voice];
+      port_system_gpio_config(p_voice -> p_port, p_voice -> pin, GPIO_MODE_ALTERNATE, GPIO_PUPDR_NOPULL);
+      port_system_gpio_config_alternate(p_voice -> p_port, p_voice -> pin, p_voice -> alt_func);
+
+      TIM_TypeDef *p_tim = p_voice -> p_tim;
+      p_tim -> CR1 = TIM_CR1_ARPE;
+      p_tim -> CNT = 0;
+      p_tim -> ARR = 0;
+      p_tim -> PSC = 0;
+      p_tim -> EGR = TIM_EGR_UG;
+      p_tim -> CCER &= ~TIM_CCER_CC1E;
+      p_tim -> CCMR1 |= TIM_CCMR1_OC1M_2 | TIM_CCMR1_OC1M_1 | TIM_CCMR1_OC1PE;
+    }
+  }
+}
+
+/**
+ * @brief Load the PWM register values of a note into the timer of a voice and start it. A silence leaves the timer disabled.
+ * 
+ * @param p_tim Timer of the voice
+ * @param p_regs Pointer to the register values of the note
+ */
+static void _load_voice(TIM_TypeDef *p_tim, const port_buzzer_note_regs_t *p_regs)
+{
+  p_tim -> CR1 &= ~TIM_CR1_CEN;
+  p_tim -> CNT = 0;
+  if (p_regs -> pwm_arr != 0){
+    p_tim -> CCR1 = p_regs -> pwm_ccr;
+    p_tim -> PSC = p_regs -> pwm_psc;
+    p_tim -> ARR = p_regs -> pwm_arr;
+    p_tim -> EGR |= TIM_EGR_UG;
+    p_tim -> CCER |= TIM_CCER_CC1E;
+    p_tim -> CR1 |= TIM_CR1_CEN;
+  }
+}
+
+/**
+ * @brief Configure the DMA streams that play a melody with no CPU involvement: DMA1 stream 1 (TIM2_UP) and DMA1 stream 4 (TIM3_TRIG).
+ * 
+ * @param buzzer_id Buzzer melody player ID. This index is used to select the element of the buzzers_arr[] array
+ */
+static void _dma_setup(uint32_t buzzer_id)
+{
+  if (buzzer_id == BUZZER_0_ID)
+  {
+    RCC->AHB1ENR |= RCC_AHB1ENR_DMA1EN;
+
+    DMA1_Stream1 -> CR = 0;
+    DMA1_Stream4 -> CR = 0;
+    DMA1 -> LIFCR = DMA_LIFCR_CTCIF1;
+    DMA1 -> HIFCR = DMA_HIFCR_CTCIF4;
+
+    /* Configure interruptions: only the end of the transfer of the PWM timer, that is the end of the melody */
+    NVIC_SetPriority(DMA1_Stream4_IRQn, NVIC_EncodePriority(NVIC_GetPriorityGrouping(), 3, 0));
+    NVIC_EnableIRQ(DMA1_Stream4_IRQn);
+    buzzers_arr[buzzer_id].dma_busy = false;
+  }
+}
+
+/**
+ * @brief Stop the DMA playback and restore the configuration of the timers for the playback note by note.
+ * 
+ * @param buzzer_id Buzzer melody player ID. This index is used to select the element of the buzzers_arr[] array
+ */
+static void _dma_disable(uint32_t buzzer_id)
+{
+  if (buzzer_id == BUZZER_0_ID)
+  {
+    // No more requests
+    TIM2 -> DIER &= ~TIM_DIER_UDE;
+    TIM2 -> CR2 &= ~TIM_CR2_MMS;
+    TIM3 -> DIER &= ~TIM_DIER_TDE;
+    TIM3 -> SMCR &= ~(TIM_SMCR_SMS | TIM_SMCR_TS);
+    DMA1_Stream1 -> CR &= ~DMA_SxCR_EN;
+    DMA1_Stream4 -> CR &= ~DMA_SxCR_EN;
+    while ((DMA1_Stream1 -> CR & DMA_SxCR_EN) || (DMA1_Stream4 -> CR & DMA_SxCR_EN))
+    {
+    }
+    DMA1 -> LIFCR = DMA_LIFCR_CTCIF1;
+    DMA1 -> HIFCR = DMA_HIFCR_CTCIF4;
+
+    // The update flag has been set by every note: clear it before enabling the interrupt again
+    TIM2 -> SR = ~TIM_SR_UIF;
+    TIM2 -> DIER |= TIM_DIER_UIE;
+    TIM3 -> CR1 |= TIM_CR1_ARPE;
+    TIM3 -> CCMR1 |= TIM_CCMR1_OC1PE;
+    buzzers_arr[buzzer_id].dma_busy = false;
+  }
+}
+
+/**
+ * @brief Get the note that is playing by DMA: each update event has written one note into the PWM timer.
+ * 
+ * @param buzzer_id Buzzer melody player ID. This index is used to select the element of the buzzers_arr[] array
+ * @return uint32_t Index of the note from the start of the DMA playback
+ */
+static uint32_t _dma_note_index(uint32_t buzzer_id)
+{
+  return buzzers_arr[buzzer_id].dma_length - DMA1_Stream4 -> NDTR / DMA_PWM_FRAME_WORDS;
+}
+
+/**
+ * @brief Find the pre-solved PWM timer registers of a note (see tools/gen_note_table.py).
+ * 
+ * @param frequency_q16 Frequency of the note in Hz, Q16.16
+ * @return const note_regs_t* Entry of the note table, or NULL if the registers have to be computed
+ */
+static const note_regs_t *_find_note_regs(uint32_t frequency_q16)
+{
+  // The table is only valid for the clock and duty cycle it has been solved for
+  if ((SystemCoreClock != NOTE_TABLE_CLOCK_HZ) || (BUZZER_PWM_DC != NOTE_TABLE_PWM_DC))
+  {
+    return NULL;
+  }
+  return note_table_find_q16(frequency_q16);
+}
+
+/**
+ * @brief Compute the PSC, ARR and CCR1 values of the timer that controls the frequency of a note from its frequency in fixed point. \n
+ * Integer arithmetic only, as _compute_duration_ticks_regs().
+ * 
+ * @param frequency_q16 Frequency of the note in Hz, Q16.16. Must not be 0
+ * @param p_psc Pointer to store the prescaler
+ * @param p_arr Pointer to store the auto-reload value
+ * @param p_ccr Pointer to store the capture/compare value
+ */
+static void _compute_pwm_regs_q16(uint32_t frequency_q16, uint32_t *p_psc, uint32_t *p_arr, uint32_t *p_ccr)
+{
+  // Fast path: the registers of the notes of melodies.h are solved at build time
+  const note_regs_t *p_regs = _find_note_regs(frequency_q16);
+  if (p_regs != NULL)
+  {
+    *p_ccr = p_regs -> ccr;
+    *p_psc = p_regs -> psc;
+    *p_arr = p_regs -> arr;
+    return;
+  }
+
+  // Number of timer clock periods of the PWM period, rounded
+  uint64_t period = (((uint64_t)SystemCoreClock << 16) + frequency_q16 / 2U) / frequency_q16;
+
+  // Same steps as with doubles: initial PSC for the maximum ARR (65535), ARR for that PSC, and PSC incremented if ARR does not fit
+  uint64_t psc_computed = (period + 32768U) / 65536U;
+  psc_computed = (psc_computed > 0) ? psc_computed - 1 : 0;
+  uint64_t arr_computed = (period + (psc_computed + 1U) / 2U) / (psc_computed + 1U) - 1U;
+  if (arr_computed > 65535U){
+    psc_computed++;
+    arr_computed = (period + (psc_computed + 1U) / 2U) / (psc_computed + 1U) - 1U;
+  }
+
+  // Set the PWM pulse width to BUZZER_PWM_DC
+  *p_ccr = (uint32_t)(((arr_computed + 1U) * BUZZER_PWM_DC_Q8) >> 8);
+  *p_psc = (uint32_t)psc_computed;
+  *p_arr = (uint32_t)arr_computed;
+}
+
+/**
+ * @brief Compute the PSC, ARR and CCR1 values of the timer that controls the frequency of a note. \n
+ * The frequencies in the range of PORT_BUZZER_HZ_Q16() are computed in fixed point. The rest are computed with doubles.
+ * 
+ * @param frequency_hz Frequency of the note in Hz. Must not be 0
+ * @param p_psc Pointer to store the prescaler
+ * @param p_arr Pointer to store the auto-reload value
+ * @param p_ccr Pointer to store the capture/compare value
+ */
+static void _compute_pwm_regs(double frequency_hz, uint32_t *p_psc, uint32_t *p_arr, uint32_t *p_ccr)
+{
+  if ((frequency_hz >= PORT_BUZZER_Q16_MIN_HZ) && (frequency_hz < PORT_BUZZER_Q16_MAX_HZ))
+  {
+    _compute_pwm_regs_q16(PORT_BUZZER_HZ_Q16(frequency_hz), p_psc, p_arr, p_ccr);
+    return;
+  }
+  double sysclk_double = (double)SystemCoreClock;
+
+  // Le damos un valor inicial al PSC contando con que ARR vale 65535.0
+
+  double psc_pwm = round(((sysclk_double / frequency_hz)/(65535.0 + 1.0)) - 1.0);
+  // Recalculamos el valor de ARR con el psc obtenido
+
+  double arr_pwm = round(((sysclk_double / frequency_hz)/(psc_pwm + 1.0)) - 1.0);
+
+  // Check if the value of ARR is greater than 65535.0
+
+  if(arr_pwm > 65535.0){
+    // If so, increment psc
+    psc_pwm++;
+    // recalculate arr
+    arr_pwm = round(((sysclk_double / frequency_hz)/(psc_pwm + 1.0)) - 1.0);
+  }
+
+  // Set the PWM pulse width to BUZZER_PWM_DC
+  *p_ccr = (uint32_t)(BUZZER_PWM_DC * (arr_pwm + 1.0));
+  *p_psc = (uint32_t)psc_pwm;
+  *p_arr = (uint32_t)arr_pwm;
+}
+
+/**
+ * @brief Compute the PSC and ARR values of the timer that controls the duration of a note from its number of timer clock periods. \n
+ * Integer arithmetic only: the FPU of the Cortex-M4 is single precision and doubles run in software.
+ * 
+ * @param ticks Duration of the note in timer clock periods. Must not be 0
+ * @param p_psc Pointer to store the prescaler
+ * @param p_arr Pointer to store the auto-reload value
+ */
+static void _compute_duration_ticks_regs(uint64_t ticks, uint32_t *p_psc, uint32_t *p_arr)
+{
+
+  // Compute an initial value for the PSC considering the maximum 
+  // value of ARR (65535), rounding to the nearest integer
+
+  uint32_t psc_computed = (uint32_t)((ticks + 32768U) / 65536U);
+  psc_computed = (psc_computed > 0) ? psc_computed - 1 : 0;
+
+  // Recompute the value of ARR register with the PSC calculated
+
+  uint64_t arr_computed = (ticks + (psc_computed + 1U) / 2U) / (psc_computed + 1U) - 1U;
+
+  // Check if the new value of ARR is greater than 65535 and if so, increment psc
+  // by 1 and recalculate ARR
+
+  if(arr_computed > 65535U){
+    psc_computed++;
+    arr_computed = (ticks + (psc_computed + 1U) / 2U) / (psc_computed + 1U) - 1U;
+  }
+
+  *p_psc = psc_computed;
+  *p_arr = (uint32_t)arr_computed;
+}
+
+/**
+ * @brief Compute the PSC and ARR values of the timer that controls the duration of a note.
+ * 
+ * @param duration_ms Duration of the note in ms
+ * @param p_psc Pointer to store the prescaler
+ * @param p_arr Pointer to store the auto-reload value
+ */
+static void _compute_duration_regs(uint32_t duration_ms, uint32_t *p_psc, uint32_t *p_arr)
+{
+  // Number of timer clock periods of the note
+  uint64_t ticks = (uint64_t)(SystemCoreClock / 1000U) * duration_ms;
+  if (ticks == 0){
+    ticks = 1;
+  }
+  _compute_duration_ticks_regs(ticks, p_psc, p_arr);
+}
+
+/**
+ * @brief Compute the PSC and ARR values of the timer that controls the duration of a note given in us.
+ * 
+ * @param duration_us Duration of the note in us
+ * @param p_psc Pointer to store the prescaler
+ * @param p_arr Pointer to store the auto-reload value
+ */
+static void _compute_duration_us_regs(uint32_t duration_us, uint32_t *p_psc, uint32_t *p_arr)
+{
+  uint64_t ticks = ((uint64_t)SystemCoreClock * duration_us + 500000U) / 1000000U;
+  if (ticks == 0){
+    ticks = 1;
+  }
+  _compute_duration_ticks_regs(ticks, p_psc, p_arr);
+}
+
+/**
+ * @brief Load the PSC, ARR and CCR1 values of a note into the timer that controls the frequency of the note and enable it.
+ * 
+ * @param psc Prescaler
+ * @param arr Auto-reload value
+ * @param ccr Capture/compare value
+ */
+static void _load_pwm_regs(uint32_t psc, uint32_t arr, uint32_t ccr)
+{
+  TIM3 -> CR1 &= ~TIM_CR1_CEN;
+  TIM3 -> CNT = 0;
+  TIM3 -> CCR1 = ccr;
+  TIM3 -> PSC = psc;
+  TIM3 -> ARR = arr;
+
+  //by an update event
+  TIM3 -> EGR |= TIM_EGR_UG;
+
+  // Enable the output compare in the capture/compare register
+  TIM3->CCER |= TIM_CCER_CC1E;
+
+  //Enable the timer
+  TIM3 -> CR1 |= TIM_CR1_CEN;
+}
+
+/**
+ * @brief Time of the schedule of the melody in core clock cycles. It wraps around at 2^32, as the cycle counter.
+ * 
+ * @param buzzer_id Buzzer melody player ID. This index is used to select the element of the buzzers_arr[] array.
+ * @param time_us Time from the start of the melody in us
+ * @return uint32_t
+ */
+static uint32_t _schedule_cycles(uint32_t buzzer_id, uint32_t time_us)
+{
+  return buzzers_arr[buzzer_id].schedule_origin_cycles + time_us * (SystemCoreClock / 1000000U);
+}
+
+/**
+ * @brief Current time in core clock cycles, to measure the gap between notes.
+ * 
+ * @return uint32_t
+ */
+static uint32_t _now_cycles(void)
+{
+  return port_system_get_cycle_count();
+}
+
+/**
+ * @brief Remember the PSC and ARR values active in the timer that controls the duration of the note. They cannot be read back from
+ * the timer while the next note is staged in its preload registers.
+ * 
+ * @param buzzer_id Buzzer melody player ID. This index is used to select the element of the buzzers_arr[] array.
+ * @param psc Prescaler of the current note
+ * @param arr Auto-reload value of the current note
+ */
+static void _set_active_duration(uint32_t buzzer_id, uint32_t psc, uint32_t arr)
+{
+  buzzers_arr[buzzer_id].note_psc = (uint16_t)psc;
+  buzzers_arr[buzzer_id].note_arr = (uint16_t)arr;
+}
+
+/**
+ * @brief Account the gap between the end of the previous note and the start of the current one, if a note has ended.
+ * 
+ * @param buzzer_id Buzzer melody player ID. This index is used to select the element of the buzzers_arr[] array.
+ */
+static void _close_gap(uint32_t buzzer_id)
+{
+  port_buzzer_hw_t *p_buzzer = &buzzers_arr[buzzer_id];
+  if (p_buzzer -> gap_pending)
+  {
+    uint32_t gap = _now_cycles() - p_buzzer -> note_end_cycles;
+    p_buzzer -> gap_pending = false;
+    p_buzzer -> gap_stats.count++;
+    p_buzzer -> gap_stats.total_cycles += gap;
+    if (gap > p_buzzer -> gap_stats.max_cycles)
+    {
+      p_buzzer -> gap_stats.max_cycles = gap;
+    }
+  }
+}
+
 /* Public functions -----------------------------------------------------------*/
 
 
@@ -88,8 +468,17 @@ void port_buzzer_init(uint32_t buzzer_id)
   port_buzzer_hw_t buzzer = buzzers_arr[buzzer_id];
   port_system_gpio_config(buzzer.p_port, buzzer.pin, GPIO_MODE_ALTERNATE, GPIO_PUPDR_NOPULL);
   port_system_gpio_config_alternate(buzzer.p_port, buzzer.pin, GPIO_MODE_ALTERNATE);
+  // Time base of the gap statistics and of the schedule of the melodies
+  if (!(DWT -> CTRL & DWT_CTRL_CYCCNTENA_Msk))
+  {
+    port_system_cycle_counter_init();
+  }
   _timer_duration_setup(buzzer_id);
   _timer_pwm_setup(buzzer_id);
+  _timer_voices_setup(buzzer_id);
+  _dma_setup(buzzer_id);
+  buzzers_arr[buzzer_id].next_staged = false;
+  buzzers_arr[buzzer_id].sequencer = NULL;
 }
 
 /**
@@ -106,50 +495,406 @@ if(buzzer_id == BUZZER_0_ID) {
   TIM2 -> CR1 &= ~TIM_CR1_CEN;
   TIM2 -> CNT = 0;
 
-  //2) Convert duration_ms and SystemCoreClock to double
-  // and store them in a local variable
+  //2) Compute the values of PSC and ARR of the note
 
-  double sysclk_double = (double)SystemCoreClock; 
-  double ms_double = (double)duration_ms;
-  double a_milis = 1000.0;
+  uint32_t psc_computed;
+  uint32_t arr_computed;
+  _compute_duration_regs(duration_ms, &psc_computed, &arr_computed);
 
+  //6) Load the values computed into the corresponding registers of the timer
 
-  // 3) Compute an initial value for the PSC considering the maximum 
-  // value of ARR (65535.0). Store it as double
+  TIM2 -> PSC = psc_computed;
+  TIM2 -> ARR = arr_computed;
 
-  double psc_computed = round(((((sysclk_double/a_milis) * ms_double)/(65535.0 +1.0))-1.0));
+  //7) Load them into the active registers with an update event
+  TIM2->EGR = TIM_EGR_UG;
+  _set_active_duration(buzzer_id, psc_computed, arr_computed);
 
-  
-  // 4) Recompute the value of ARR register with the PSC calculated
+  //8) Set the note_end flag to the appropiate value
+  buzzers_arr[buzzer_id].note_end = false;
+  _close_gap(buzzer_id);
 
-  double arr_computed = round((((sysclk_double/a_milis) * ms_double)/(psc_computed +1.0))-1.0);
+  //9) Enable the timer
+  TIM2 -> CR1 |= TIM_CR1_CEN;
+ 
+}
+}
 
+/**
+ * @brief Set the time origin of the schedule of the melody.
+ * 
+ * @param buzzer_id Buzzer melody player ID. This index is used to select the element of the buzzers_arr[] array.
+ * @param elapsed_us Time of the schedule that corresponds to now, in us.
+ */
+void port_buzzer_set_schedule_origin(uint32_t buzzer_id, uint32_t elapsed_us){
+  if (buzzer_id == BUZZER_0_ID){
+    buzzers_arr[buzzer_id].schedule_origin_cycles = _now_cycles() - elapsed_us * (SystemCoreClock / 1000000U);
+  }
+}
 
-  //5) Check if the new value of ARR is greater than 65535 and if so, increment psc
-  // by 1 and recalculate ARR
+/**
+ * @brief Set the duration of the current note so that it ends at a time of the schedule of the melody.
+ * 
+ * @param buzzer_id Buzzer melody player ID. This index is used to select the element of the buzzers_arr[] array.
+ * @param end_us Time of the end of the note from the start of the melody, in us.
+ */
+void port_buzzer_set_note_end(uint32_t buzzer_id, uint32_t end_us){
+if (buzzer_id == BUZZER_0_ID){
+  TIM2 -> CR1 &= ~TIM_CR1_CEN;
+  TIM2 -> CNT = 0;
 
-  if(arr_computed > 65535.0){
-    psc_computed++;
-    arr_computed = round((((sysclk_double/a_milis) * ms_double)/(psc_computed +1.0))-1.0);
-  }
+  // The note is shortened by the time the player is late. A note that should have already ended lasts the shortest period the timer can count
+  int32_t remaining = (int32_t)(_schedule_cycles(buzzer_id, end_us) - _now_cycles());
+  uint64_t ticks = (remaining > (int32_t)PORT_BUZZER_MIN_NOTE_TICKS) ? (uint64_t)remaining : PORT_BUZZER_MIN_NOTE_TICKS;
+  uint32_t psc_computed;
+  uint32_t arr_computed;
+  _compute_duration_ticks_regs(ticks, &psc_computed, &arr_computed);
+  TIM2 -> PSC = psc_computed;
+  TIM2 -> ARR = arr_computed;
+  TIM2 -> EGR = TIM_EGR_UG;
+  _set_active_duration(buzzer_id, psc_computed, arr_computed);
+  buzzers_arr[buzzer_id].note_end = false;
+  TIM2 -> CR1 |= TIM_CR1_CEN;
+}
+}
 
-  //6) Load the values computed into the corresponding registers of the timer
+/**
+ * @brief Get the difference between the end of the last note and a time of the schedule of the melody.
+ * 
+ * @param buzzer_id Buzzer melody player ID. This index is used to select the element of the buzzers_arr[] array.
+ * @param end_us Expected time of the end of the last note from the start of the melody, in us.
+ * @return int32_t Drift in us. Positive if the note has ended late
+ */
+int32_t port_buzzer_get_schedule_drift(uint32_t buzzer_id, uint32_t end_us){
+  if (buzzer_id == BUZZER_0_ID){
+    int32_t drift_cycles = (int32_t)(buzzers_arr[buzzer_id].note_end_cycles - _schedule_cycles(buzzer_id, end_us));
+    return drift_cycles / (int32_t)(SystemCoreClock / 1000000U);
+  }
+  return 0;
+}
 
-  TIM2 -> PSC = (uint32_t)(psc_computed);
-  TIM2 -> ARR = (uint32_t)(arr_computed);
+/**
+ * @brief Start a note loading register values computed in advance.
+ * 
+ * @param buzzer_id Buzzer melody player ID. This index is used to select the element of the buzzers_arr[] array.
+ * @param p_regs Pointer to the register values of the note.
+ */
+void port_buzzer_set_note_regs(uint32_t buzzer_id, const port_buzzer_note_regs_t *p_regs){
+if (buzzer_id == BUZZER_0_ID){
+  // Frequency of the note. A silence leaves the PWM timer disabled
+  _load_voice(TIM3, p_regs);
+  port_buzzer_start_note_duration(buzzer_id, p_regs);
+}
+}
 
-  //7) Load them into the active registers with an update event
-  TIM2->EGR = TIM_EGR_UG;
+/**
+ * @brief Set the frequency of a voice of the buzzer.
+ * 
+ * @param buzzer_id Buzzer melody player ID. This index is used to select the element of the buzzers_arr[] array.
+ * @param voice Index of the voice. This index is used to select the element of the voices_arr[] array.
+ * @param p_regs Pointer to the register values of the note. Only the values of the PWM timer are used.
+ */
+void port_buzzer_set_voice_regs(uint32_t buzzer_id, uint32_t voice, const port_buzzer_note_regs_t *p_regs){
+  if ((buzzer_id == BUZZER_0_ID) && (voice < PORT_BUZZER_MAX_VOICES)){
+    _load_voice(voices_arr[voice].p_tim, p_regs);
+  }
+}
 
-  //8) Set the note_end flag to the appropiate value
+/**
+ * @brief Start the timer that controls the duration of the note with precomputed register values.
+ * 
+ * @param buzzer_id Buzzer melody player ID. This index is used to select the element of the buzzers_arr[] array.
+ * @param p_regs Pointer to the register values of the note. Only the values of the duration timer are used.
+ */
+void port_buzzer_start_note_duration(uint32_t buzzer_id, const port_buzzer_note_regs_t *p_regs){
+if (buzzer_id == BUZZER_0_ID){
+  TIM2 -> CR1 &= ~TIM_CR1_CEN;
+  TIM2 -> CNT = 0;
+  TIM2 -> PSC = p_regs -> duration_psc;
+  TIM2 -> ARR = p_regs -> duration_arr;
+  TIM2 -> EGR = TIM_EGR_UG;
+  _set_active_duration(buzzer_id, p_regs -> duration_psc, p_regs -> duration_arr);
   buzzers_arr[buzzer_id].note_end = false;
-
-  //9) Enable the timer
+  _close_gap(buzzer_id);
   TIM2 -> CR1 |= TIM_CR1_CEN;
- 
 }
 }
 
+/**
+ * @brief Scale the rest of the duration of the note that is playing.
+ * 
+ * @param buzzer_id Buzzer melody player ID. This index is used to select the element of the buzzers_arr[] array.
+ * @param num Numerator of the factor applied to the rest of the note.
+ * @param den Denominator of the factor applied to the rest of the note.
+ * @return uint32_t Rest of the duration of the note after scaling it, in us. 0 if no note is playing.
+ */
+uint32_t port_buzzer_rescale_note(uint32_t buzzer_id, uint32_t num, uint32_t den){
+  uint32_t remaining_us = 0;
+  if ((buzzer_id == BUZZER_0_ID) && (TIM2 -> CR1 & TIM_CR1_CEN) && (den != 0)){
+    port_buzzer_hw_t *p_buzzer = &buzzers_arr[buzzer_id];
+    // Mask the update interrupt, so that the note cannot end while it is reprogrammed
+    TIM2 -> DIER &= ~TIM_DIER_UIE;
+    uint32_t cnt = TIM2 -> CNT;
+    if ((TIM2 -> SR & TIM_SR_UIF) || (cnt > p_buzzer -> note_arr)){
+      // The note has just ended: the ISR handles it
+      TIM2 -> DIER |= TIM_DIER_UIE;
+      return 0;
+    }
+    uint64_t remaining = ((uint64_t)p_buzzer -> note_arr + 1U - cnt) * ((uint64_t)p_buzzer -> note_psc + 1U);
+    remaining = (remaining * num) / den;
+    if (remaining < PORT_BUZZER_MIN_NOTE_TICKS){
+      remaining = PORT_BUZZER_MIN_NOTE_TICKS;
+    }
+    uint32_t psc_computed;
+    uint32_t arr_computed;
+    _compute_duration_ticks_regs(remaining, &psc_computed, &arr_computed);
+
+    // The update event that loads the new values must not be taken as the end of the note
+    TIM2 -> CR1 &= ~TIM_CR1_CEN;
+    TIM2 -> CNT = 0;
+    TIM2 -> PSC = psc_computed;
+    TIM2 -> ARR = arr_computed;
+    TIM2 -> CR1 |= TIM_CR1_URS;
+    TIM2 -> EGR = TIM_EGR_UG;
+    TIM2 -> CR1 &= ~TIM_CR1_URS;
+    _set_active_duration(buzzer_id, psc_computed, arr_computed);
+
+    // The staged note keeps its values in the preload registers
+    if (p_buzzer -> next_staged){
+      TIM2 -> PSC = p_buzzer -> next_regs.duration_psc;
+      TIM2 -> ARR = p_buzzer -> next_regs.duration_arr;
+    }
+    TIM2 -> CR1 |= TIM_CR1_CEN;
+    TIM2 -> DIER |= TIM_DIER_UIE;
+    remaining_us = (uint32_t)((((uint64_t)psc_computed + 1U) * ((uint64_t)arr_computed + 1U) * 1000000U) / SystemCoreClock);
+  }
+  return remaining_us;
+}
+
+/**
+ * @brief Get the time left of the note that is playing, with no change to the timer that controls the duration of the note.
+ * 
+ * @param buzzer_id Buzzer melody player ID. This index is used to select the element of the buzzers_arr[] array.
+ * @return uint32_t Time left of the note in us. 0 if no note is playing or it has just ended.
+ */
+uint32_t port_buzzer_get_note_remaining_us(uint32_t buzzer_id){
+  uint32_t remaining_us = 0;
+  if ((buzzer_id == BUZZER_0_ID) && (TIM2 -> CR1 & TIM_CR1_CEN)){
+    port_buzzer_hw_t *p_buzzer = &buzzers_arr[buzzer_id];
+    uint32_t psc = p_buzzer -> note_psc;
+    uint32_t arr = p_buzzer -> note_arr;
+    bool ended = (TIM2 -> SR & TIM_SR_UIF) != 0;
+    if (p_buzzer -> dma_busy){
+      // The DMA loads the duration of every note: the update flag is set by all of them
+      uint32_t note_index = _dma_note_index(buzzer_id);
+      psc = dma_duration_frames[note_index * DMA_DURATION_FRAME_WORDS];
+      arr = dma_duration_frames[note_index * DMA_DURATION_FRAME_WORDS + 1U];
+      ended = false;
+    }
+    uint32_t cnt = TIM2 -> CNT;
+    if (!ended && (cnt <= arr)){
+      remaining_us = (uint32_t)((((uint64_t)arr + 1U - cnt) * ((uint64_t)psc + 1U) * 1000000U) / SystemCoreClock);
+    }
+  }
+  return remaining_us;
+}
+
+/**
+ * @brief Stage the next note in the preload registers while the current note plays.
+ * 
+ * @param buzzer_id Buzzer melody player ID. This index is used to select the element of the buzzers_arr[] array.
+ * @param p_regs Pointer to the register values of the next note.
+ */
+void port_buzzer_set_next_note_regs(uint32_t buzzer_id, const port_buzzer_note_regs_t *p_regs){
+if (buzzer_id == BUZZER_0_ID){
+  // The PWM timer runs at the frequency of the current note: its values are loaded at the end of the note
+  buzzers_arr[buzzer_id].next_regs = *p_regs;
+  buzzers_arr[buzzer_id].next_staged = true;
+
+  // PSC is always preloaded and ARR is preloaded (ARPE): both become active at the next update event
+  TIM2 -> PSC = p_regs -> duration_psc;
+  TIM2 -> ARR = p_regs -> duration_arr;
+}
+}
+
+/**
+ * @brief Handle the update event of the timer that controls the duration of the note. Called from its ISR.
+ * 
+ * @param buzzer_id Buzzer melody player ID. This index is used to select the element of the buzzers_arr[] array.
+ */
+void port_buzzer_update_note(uint32_t buzzer_id){
+if (buzzer_id == BUZZER_0_ID){
+  port_buzzer_hw_t *p_buzzer = &buzzers_arr[buzzer_id];
+  // Cycles since the update event, i.e. latency of this ISR
+  uint32_t latency = TIM2 -> CNT * (TIM2 -> PSC + 1U);
+  p_buzzer -> note_end_cycles = _now_cycles() - latency;
+  p_buzzer -> gap_pending = true;
+  if (p_buzzer -> next_staged)
+  {
+    // The duration of the staged note is already active: switch the frequency
+    const port_buzzer_note_regs_t *p_regs = &(p_buzzer -> next_regs);
+    p_buzzer -> next_staged = false;
+    _set_active_duration(buzzer_id, p_regs -> duration_psc, p_regs -> duration_arr);
+    _load_voice(TIM3, p_regs);
+    _close_gap(buzzer_id);
+
+    // The sequencer provides the following note: the player is only notified at the end of the sequence
+    if (p_buzzer -> sequencer != NULL)
+    {
+      port_buzzer_note_regs_t regs;
+      if (p_buzzer -> sequencer(p_buzzer -> p_sequencer_arg, &regs))
+      {
+        port_buzzer_set_next_note_regs(buzzer_id, &regs);
+      }
+      return;
+    }
+  }
+  p_buzzer -> note_end = true;
+}
+}
+
+/**
+ * @brief Cancel the staged note, if it has not started yet.
+ * 
+ * @param buzzer_id Buzzer melody player ID. This index is used to select the element of the buzzers_arr[] array.
+ * @return true 
+ * @return false 
+ */
+bool port_buzzer_cancel_next_note(uint32_t buzzer_id){
+  bool cancelled = false;
+  if (buzzer_id == BUZZER_0_ID){
+    // Mask the update interrupt, so that the note cannot start while it is cancelled
+    TIM2 -> DIER &= ~TIM_DIER_UIE;
+    cancelled = buzzers_arr[buzzer_id].next_staged;
+    buzzers_arr[buzzer_id].next_staged = false;
+    TIM2 -> DIER |= TIM_DIER_UIE;
+  }
+  return cancelled;
+}
+
+/**
+ * @brief Mask or unmask the interrupt of the timer that controls the duration of the note.
+ * 
+ * @param buzzer_id Buzzer melody player ID. This index is used to select the element of the buzzers_arr[] array.
+ * @param enable true to unmask the interrupt, false to mask it.
+ */
+void port_buzzer_set_note_interrupt(uint32_t buzzer_id, bool enable){
+  if (buzzer_id == BUZZER_0_ID){
+    if (enable){
+      TIM2 -> DIER |= TIM_DIER_UIE;
+    }
+    else{
+      TIM2 -> DIER &= ~TIM_DIER_UIE;
+    }
+  }
+}
+
+/**
+ * @brief Register the function that provides the notes of a sequence from the ISR.
+ * 
+ * @param buzzer_id Buzzer melody player ID. This index is used to select the element of the buzzers_arr[] array.
+ * @param sequencer Function that provides the next note, or NULL.
+ * @param p_arg Argument passed to the sequencer.
+ */
+void port_buzzer_set_sequencer(uint32_t buzzer_id, port_buzzer_sequencer_t sequencer, void *p_arg){
+  if (buzzer_id == BUZZER_0_ID){
+    buzzers_arr[buzzer_id].sequencer = sequencer;
+    buzzers_arr[buzzer_id].p_sequencer_arg = p_arg;
+  }
+}
+
+/**
+ * @brief Check if the staged note has not been started yet.
+ * 
+ * @param buzzer_id Buzzer melody player ID. This index is used to select the element of the buzzers_arr[] array.
+ * @return true 
+ * @return false 
+ */
+bool port_buzzer_get_next_note_staged(uint32_t buzzer_id){
+  if (buzzer_id == BUZZER_0_ID){
+    return buzzers_arr[buzzer_id].next_staged;
+  }
+  return false;
+}
+
+/**
+ * @brief Compute the register values of a note.
+ * 
+ * @param frequency_hz Frequency of the note in Hz. 0 for a silence.
+ * @param duration_ms Duration of the note in ms.
+ * @param p_regs Pointer to store the register values.
+ */
+void port_buzzer_get_note_regs(double frequency_hz, uint32_t duration_ms, port_buzzer_note_regs_t *p_regs){
+  uint32_t psc = 0;
+  uint32_t arr = 0;
+  uint32_t ccr = 0;
+  if (frequency_hz != 0){
+    _compute_pwm_regs(frequency_hz, &psc, &arr, &ccr);
+  }
+  p_regs -> pwm_psc = (uint16_t)psc;
+  p_regs -> pwm_arr = (uint16_t)arr;
+  p_regs -> pwm_ccr = (uint16_t)ccr;
+  _compute_duration_regs(duration_ms, &psc, &arr);
+  p_regs -> duration_psc = (uint16_t)psc;
+  p_regs -> duration_arr = (uint16_t)arr;
+}
+
+/**
+ * @brief Compute the register values of a note in fixed point.
+ * 
+ * @param frequency_q16 Frequency of the note in Hz, Q16.16. 0 for a silence.
+ * @param duration_us Duration of the note in us.
+ * @param p_regs Pointer to store the register values.
+ */
+void port_buzzer_get_note_regs_q16(uint32_t frequency_q16, uint32_t duration_us, port_buzzer_note_regs_t *p_regs){
+  uint32_t psc = 0;
+  uint32_t arr = 0;
+  uint32_t ccr = 0;
+  if (frequency_q16 != 0){
+    _compute_pwm_regs_q16(frequency_q16, &psc, &arr, &ccr);
+  }
+  p_regs -> pwm_psc = (uint16_t)psc;
+  p_regs -> pwm_arr = (uint16_t)arr;
+  p_regs -> pwm_ccr = (uint16_t)ccr;
+  port_buzzer_get_duration_regs(duration_us, p_regs);
+}
+
+/**
+ * @brief Compute the register values of the timer that controls the duration of a note.
+ * 
+ * @param duration_us Duration of the note in us.
+ * @param p_regs Pointer to store the register values. The values of the timer that controls the frequency are not modified.
+ */
+void port_buzzer_get_duration_regs(uint32_t duration_us, port_buzzer_note_regs_t *p_regs){
+  uint32_t psc;
+  uint32_t arr;
+  _compute_duration_us_regs(duration_us, &psc, &arr);
+  p_regs -> duration_psc = (uint16_t)psc;
+  p_regs -> duration_arr = (uint16_t)arr;
+}
+
+/**
+ * @brief Get the statistics of the gaps between notes.
+ * 
+ * @param buzzer_id Buzzer melody player ID. This index is used to select the element of the buzzers_arr[] array.
+ * @param p_stats Pointer to store the statistics.
+ */
+void port_buzzer_get_gap_stats(uint32_t buzzer_id, port_buzzer_gap_stats_t *p_stats){
+  *p_stats = buzzers_arr[buzzer_id].gap_stats;
+}
+
+/**
+ * @brief Reset the statistics of the gaps between notes.
+ * 
+ * @param buzzer_id Buzzer melody player ID. This index is used to select the element of the buzzers_arr[] array.
+ */
+void port_buzzer_reset_gap_stats(uint32_t buzzer_id){
+  buzzers_arr[buzzer_id].gap_pending = false;
+  buzzers_arr[buzzer_id].gap_stats.count = 0;
+  buzzers_arr[buzzer_id].gap_stats.max_cycles = 0;
+  buzzers_arr[buzzer_id].gap_stats.total_cycles = 0;
+}
+
 /**
  * @brief Retrieve the status of the note end flag.
  * 
@@ -165,6 +910,18 @@ bool port_buzzer_get_note_timeout	(	uint32_t 	buzzer_id	)	{
     return false;
   }
 }
+
+/**
+ * @brief Reset the note end flag.
+ * 
+ * @param buzzer_id Buzzer melody player ID. This index is used to select the element of the buzzers_arr[] array.
+ */
+void port_buzzer_reset_note_timeout(uint32_t buzzer_id){
+  if (buzzer_id == BUZZER_0_ID){
+    buzzers_arr[buzzer_id].note_end = false;
+  }
+}
+
 /**
  * @brief Set the PWM frequency of the timer that controls the frequency of the note.
  * 
@@ -185,52 +942,220 @@ if(buzzer_id == BUZZER_0_ID){
   //Resto de casos donde la frecuencia no es 0
   else {
     //Configure the values of PSC and ARR
-    //Primero pasar la f_clk a double
+    uint32_t psc_pwm;
+    uint32_t arr_pwm;
+    uint32_t ccr_pwm;
+    _compute_pwm_regs(frequency_hz, &psc_pwm, &arr_pwm, &ccr_pwm);
+    _load_pwm_regs(psc_pwm, arr_pwm, ccr_pwm);
+  }
+}
+}
+
+/**
+ * @brief Set the PWM frequency of the timer that controls the frequency of the note, given in fixed point.
+ * 
+ * @param buzzer_id Buzzer melody player ID. This index is used to select the element of the buzzers_arr[] array.
+ * @param frequency_q16 Frequency of the note in Hz, Q16.16.
+ */
+void port_buzzer_set_note_frequency_q16(uint32_t buzzer_id, uint32_t frequency_q16){
+if (buzzer_id == BUZZER_0_ID){
+  if (frequency_q16 == 0){
     TIM3 -> CR1 &= ~TIM_CR1_CEN;
     TIM3 -> CNT = 0;
+    return;
+  }
+  uint32_t psc_pwm;
+  uint32_t arr_pwm;
+  uint32_t ccr_pwm;
+  _compute_pwm_regs_q16(frequency_q16, &psc_pwm, &arr_pwm, &ccr_pwm);
+  _load_pwm_regs(psc_pwm, arr_pwm, ccr_pwm);
+}
+}
 
-    double sysclk_double = (double)SystemCoreClock;
-
-    // Le damos un valor inicial al PSC contando con que ARR vale 65535.0
-
-    double psc_pwm = round(((sysclk_double / frequency_hz)/(65535.0 + 1.0)) - 1.0);
-    // Recalculamos el valor de ARR con el psc obtenido
-
-    double arr_pwm = round(((sysclk_double / frequency_hz)/(psc_pwm + 1.0)) - 1.0);
-
-    // Check if the value of ARR is greater than 65535.0
 
-    if(arr_pwm > 65535.0){
-      // If so, increment psc
-      psc_pwm++;
-      // recalculate arr
-      arr_pwm = round(((sysclk_double / frequency_hz)/(psc_pwm + 1.0)) - 1.0);
-    }
+/**
+ * @brief Load the register values of a note of a melody to play by DMA. \n
+ * The timer that controls the frequency has a fixed prescaler in DMA playback: the period of the note is kept with the ARR and CCR1 scaled to it.
+ * 
+ * @param buzzer_id Buzzer melody player ID. This index is used to select the element of the buzzers_arr[] array.
+ * @param index Index of the note from the start of the DMA playback.
+ * @param p_regs Pointer to the register values of the note.
+ * @return true 
+ * @return false 
+ */
+bool port_buzzer_dma_load_note(uint32_t buzzer_id, uint32_t index, const port_buzzer_note_regs_t *p_regs){
+  if ((buzzer_id != BUZZER_0_ID) || (index >= PORT_BUZZER_DMA_MAX_NOTES)){
+    return false;
+  }
+  // A silence keeps the output low: CCR1 = 0
+  uint32_t arr = 0;
+  uint32_t ccr = 0;
+  if (p_regs -> pwm_arr != 0){
+    uint64_t period = ((uint64_t)p_regs -> pwm_psc + 1U) * ((uint64_t)p_regs -> pwm_arr + 1U);
+    uint64_t arr_scaled = (period + (PORT_BUZZER_DMA_PWM_PSC + 1U) / 2U) / (PORT_BUZZER_DMA_PWM_PSC + 1U);
+    arr_scaled = (arr_scaled > 65536U) ? 65536U : ((arr_scaled < 2U) ? 2U : arr_scaled);
+    arr = (uint32_t)arr_scaled - 1U;
+    ccr = (uint32_t)(((uint64_t)p_regs -> pwm_ccr * arr_scaled) / ((uint64_t)p_regs -> pwm_arr + 1U));
+  }
+  uint32_t *p_pwm = &dma_pwm_frames[index * DMA_PWM_FRAME_WORDS];
+  p_pwm[0] = arr;
+  p_pwm[1] = 0;
+  p_pwm[2] = ccr;
+  uint32_t *p_duration = &dma_duration_frames[index * DMA_DURATION_FRAME_WORDS];
+  p_duration[0] = p_regs -> duration_psc;
+  p_duration[1] = p_regs -> duration_arr;
+  return true;
+}
 
-    // Set the PWM pulse width to BUZZER_PWM_DC
+/**
+ * @brief Play the notes loaded with port_buzzer_dma_load_note() with no CPU involvement.
+ * 
+ * @param buzzer_id Buzzer melody player ID. This index is used to select the element of the buzzers_arr[] array.
+ * @param length Number of notes to play.
+ */
+void port_buzzer_dma_start(uint32_t buzzer_id, uint32_t length){
+if ((buzzer_id == BUZZER_0_ID) && (length > 0) && (length <= PORT_BUZZER_DMA_MAX_NOTES)){
+  port_buzzer_stop(buzzer_id);
 
-    TIM3 -> CCR1 = (uint32_t)(BUZZER_PWM_DC * (arr_pwm + 1.0));
-    
-    // PSC and ARR into the active registers
-    TIM3 -> PSC = (uint32_t)psc_pwm;
-    TIM3 -> ARR = (uint32_t)arr_pwm;
+  // The update event that ends the last note writes a silence into the PWM timer and ends the transfer. The duration timer is
+  // written one note ahead: two padding frames
+  uint32_t *p_pwm = &dma_pwm_frames[length * DMA_PWM_FRAME_WORDS];
+  p_pwm[0] = 0;
+  p_pwm[1] = 0;
+  p_pwm[2] = 0;
+  for (uint32_t i = length; i < length + 2U; i++){
+    dma_duration_frames[i * DMA_DURATION_FRAME_WORDS] = DMA_DURATION_PADDING;
+    dma_duration_frames[i * DMA_DURATION_FRAME_WORDS + 1U] = DMA_DURATION_PADDING;
+  }
 
-    //by an update event
+  // PWM timer: first note, fixed prescaler and no preload. It is reset by the update events of the duration timer (TRGO on ITR1),
+  // and its trigger requests a burst with the ARR, RCR and CCR1 of the next note
+  TIM3 -> CR1 &= ~(TIM_CR1_CEN | TIM_CR1_ARPE);
+  TIM3 -> CCMR1 &= ~TIM_CCMR1_OC1PE;
+  TIM3 -> CNT = 0;
+  TIM3 -> PSC = PORT_BUZZER_DMA_PWM_PSC;
+  TIM3 -> ARR = dma_pwm_frames[0];
+  TIM3 -> CCR1 = dma_pwm_frames[2];
+  TIM3 -> EGR = TIM_EGR_UG;
+  TIM3 -> SR = 0;
+  TIM3 -> CCER |= TIM_CCER_CC1E;
+  TIM3 -> DCR = (TIM_ARR_WORD_OFFSET << TIM_DCR_DBA_Pos) | ((DMA_PWM_FRAME_WORDS - 1U) << TIM_DCR_DBL_Pos);
+  TIM3 -> SMCR = TIM_SMCR_SMS_2 | TIM_SMCR_TS_0;
+  TIM3 -> DIER |= TIM_DIER_TDE;
 
-    TIM3 -> EGR |= TIM_EGR_UG;
+  // Duration timer: first note active and second note in the preload registers. Its update requests a burst with the PSC and ARR
+  // of the note after the next one
+  TIM2 -> CR1 &= ~TIM_CR1_CEN;
+  TIM2 -> DIER &= ~TIM_DIER_UIE;
+  TIM2 -> CNT = 0;
+  TIM2 -> PSC = dma_duration_frames[0];
+  TIM2 -> ARR = dma_duration_frames[1];
+  TIM2 -> EGR = TIM_EGR_UG;
+  TIM2 -> SR = ~TIM_SR_UIF;
+  TIM2 -> PSC = dma_duration_frames[DMA_DURATION_FRAME_WORDS];
+  TIM2 -> ARR = dma_duration_frames[DMA_DURATION_FRAME_WORDS + 1U];
+  TIM2 -> DCR = (TIM_PSC_WORD_OFFSET << TIM_DCR_DBA_Pos) | ((DMA_DURATION_FRAME_WORDS - 1U) << TIM_DCR_DBL_Pos);
+  TIM2 -> CR2 = (TIM2 -> CR2 & ~TIM_CR2_MMS) | TIM_CR2_MMS_1;
+  TIM2 -> DIER |= TIM_DIER_UDE;
 
-    // Enable the output compare in the capture/compare register
+  // Memory to peripheral, words
+  DMA1 -> LIFCR = DMA_LIFCR_CTCIF1;
+  DMA1 -> HIFCR = DMA_HIFCR_CTCIF4;
+  DMA1_Stream1 -> CR = (DMA_CHANNEL_TIM2_UP << DMA_SxCR_CHSEL_Pos) | DMA_SxCR_MSIZE_1 | DMA_SxCR_PSIZE_1 | DMA_SxCR_MINC | DMA_SxCR_DIR_0;
+  DMA1_Stream1 -> PAR = (uintptr_t)&(TIM2 -> DMAR);
+  DMA1_Stream1 -> M0AR = (uintptr_t)&dma_duration_frames[2U * DMA_DURATION_FRAME_WORDS];
+  DMA1_Stream1 -> NDTR = length * DMA_DURATION_FRAME_WORDS;
+  DMA1_Stream4 -> CR = (DMA_CHANNEL_TIM3_TRIG << DMA_SxCR_CHSEL_Pos) | DMA_SxCR_MSIZE_1 | DMA_SxCR_PSIZE_1 | DMA_SxCR_MINC | DMA_SxCR_DIR_0 | DMA_SxCR_TCIE;
+  DMA1_Stream4 -> PAR = (uintptr_t)&(TIM3 -> DMAR);
+  DMA1_Stream4 -> M0AR = (uintptr_t)&dma_pwm_frames[DMA_PWM_FRAME_WORDS];
+  DMA1_Stream4 -> NDTR = length * DMA_PWM_FRAME_WORDS;
+  DMA1_Stream1 -> CR |= DMA_SxCR_EN;
+  DMA1_Stream4 -> CR |= DMA_SxCR_EN;
 
-    TIM3->CCER |= TIM_CCER_CC1E;
+  buzzers_arr[buzzer_id].note_end = false;
+  buzzers_arr[buzzer_id].dma_busy = true;
+  buzzers_arr[buzzer_id].dma_length = length;
+  TIM3 -> CR1 |= TIM_CR1_CEN;
+  TIM2 -> CR1 |= TIM_CR1_CEN;
+}
+}
 
-    //Enable the timer
+/**
+ * @brief Stop the DMA requests and let the note that is playing go on with the playback note by note.
+ * 
+ * @param buzzer_id Buzzer melody player ID. This index is used to select the element of the buzzers_arr[] array.
+ * @return uint32_t Index of the note that is playing.
+ */
+uint32_t port_buzzer_dma_detach(uint32_t buzzer_id){
+  uint32_t note_index = 0;
+  if ((buzzer_id == BUZZER_0_ID) && buzzers_arr[buzzer_id].dma_busy){
+    note_index = _dma_note_index(buzzer_id);
+    _set_active_duration(buzzer_id, dma_duration_frames[note_index * DMA_DURATION_FRAME_WORDS], dma_duration_frames[note_index * DMA_DURATION_FRAME_WORDS + 1U]);
+    _dma_disable(buzzer_id);
+    buzzers_arr[buzzer_id].next_staged = false;
+  }
+  return note_index;
+}
 
-    TIM3 -> CR1 |= TIM_CR1_CEN;
+/**
+ * @brief Stop the DMA playback and set the note end flag.
+ * 
+ * @param buzzer_id Buzzer melody player ID. This index is used to select the element of the buzzers_arr[] array.
+ * @return uint32_t Index of the note that was playing.
+ */
+uint32_t port_buzzer_dma_stop(uint32_t buzzer_id){
+  uint32_t note_index = 0;
+  if ((buzzer_id == BUZZER_0_ID) && buzzers_arr[buzzer_id].dma_busy){
+    TIM2 -> CR1 &= ~TIM_CR1_CEN;
+    note_index = _dma_note_index(buzzer_id);
+    port_buzzer_stop(buzzer_id);
+    buzzers_arr[buzzer_id].note_end = true;
+  }
+  return note_index;
+}
 
+/**
+ * @brief Handle the end of the DMA playback. Called from the ISR of the DMA stream.
+ * 
+ * @param buzzer_id Buzzer melody player ID. This index is used to select the element of the buzzers_arr[] array.
+ */
+void port_buzzer_dma_end(uint32_t buzzer_id){
+  if (buzzer_id == BUZZER_0_ID){
+    // The transfer ends with the update event that ends the last note
+    buzzers_arr[buzzer_id].note_end_cycles = _now_cycles();
+    port_buzzer_stop(buzzer_id);
+    buzzers_arr[buzzer_id].note_end = true;
   }
 }
+
+/**
+ * @brief Check if a melody is being played by DMA.
+ * 
+ * @param buzzer_id Buzzer melody player ID. This index is used to select the element of the buzzers_arr[] array.
+ * @return true 
+ * @return false 
+ */
+bool port_buzzer_get_dma_busy(uint32_t buzzer_id){
+  if (buzzer_id == BUZZER_0_ID){
+    return buzzers_arr[buzzer_id].dma_busy;
+  }
+  return false;
 }
 
+/**
+ * @brief Get the note that is playing by DMA, with no change to the playback.
+ * 
+ * @param buzzer_id Buzzer melody player ID. This index is used to select the element of the buzzers_arr[] array.
+ * @return uint32_t Index of the note from the start of the DMA playback. 0 if no melody is played by DMA.
+ */
+uint32_t port_buzzer_get_dma_note(uint32_t buzzer_id){
+  if (buzzer_id == BUZZER_0_ID){
+    if (buzzers_arr[buzzer_id].dma_busy){
+      return _dma_note_index(buzzer_id);
+    }
+  }
+  return 0;
+}
 
 /**
  * @brief Disable the PWM output of the timer that controls the frequency of the note and the timer that controls the duration of the note.
@@ -241,6 +1166,13 @@ void port_buzzer_stop	(	uint32_t 	buzzer_id	) {
 if (buzzer_id == BUZZER_0_ID){
   TIM3->CR1 &= ~TIM_CR1_CEN;
   TIM2 -> CR1 &= ~TIM_CR1_CEN;
+  for (uint32_t voice = 1; voice < PORT_BUZZER_MAX_VOICES; voice++){
+    voices_arr[voice].p_tim -> CR1 &= ~TIM_CR1_CEN;
+  }
+  buzzers_arr[buzzer_id].next_staged = false;
+  if (buzzers_arr[buzzer_id].dma_busy){
+    _dma_disable(buzzer_id);
+  }
 }
 }	
 
@@ -0,0 +1,30 @@
+/**
+ * @file port_melody_bank.c
+ * @brief Portable functions to access the melody bank of the jukebox.
+ * @author Javier de Ponte Hernando
+ * @author Roberto Maldonado Macafee
+ * @date 18/10/2026
+ */
+/* Includes ------------------------------------------------------------------*/
+#include <stddef.h>
+#include "port_melody_bank.h"
+#include "melody_bank_data.h"
+
+/* Public functions */
+const void *port_melody_bank_get(uint32_t *p_size)
+{
+    *p_size = MELODY_BANK_DATA_SIZE;
+    return melody_bank_data;
+}
+
+const void *port_melody_bank_get_slot(uint32_t slot, uint32_t *p_size)
+{
+    static const uint32_t slot_address[PORT_MELODY_BANK_NUM_SLOTS] = {PORT_MELODY_BANK_SLOT_0_ADDRESS, PORT_MELODY_BANK_SLOT_1_ADDRESS};
+    if (slot >= PORT_MELODY_BANK_NUM_SLOTS)
+    {
+        *p_size = 0;
+        return NULL;
+    }
+    *p_size = PORT_MELODY_BANK_SLOT_SIZE;
+    return (const void *)slot_address[slot];
+}
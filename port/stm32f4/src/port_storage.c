@@ -0,0 +1,82 @@
+/**
+ * @file port_storage.c
+ * @brief Portable functions to read the storage device of the streamed melodies: an SPI flash on SPI2.
+ * @author Javier de Ponte Hernando
+ * @author Roberto Maldonado Macafee
+ * @date 18/10/2026
+ */
+/* Includes ------------------------------------------------------------------*/
+#include "port_system.h"
+#include "port_storage.h"
+
+/* Private variables */
+static uint32_t storage_size = 0; /*!< Size of the SPI flash in bytes, 0 if there is none */
+
+/* Private functions */
+/**
+ * @brief Send a byte over the SPI and receive the byte sent back.
+ *
+ * @param byte Byte to send
+ * @return uint8_t Byte received
+ */
+static uint8_t _transfer(uint8_t byte)
+{
+    while (!(STORAGE_SPI->SR & SPI_SR_TXE))
+    {
+    }
+    *(volatile uint8_t *)&STORAGE_SPI->DR = byte;
+    while (!(STORAGE_SPI->SR & SPI_SR_RXNE))
+    {
+    }
+    return *(volatile uint8_t *)&STORAGE_SPI->DR;
+}
+
+/* Public functions */
+uint32_t port_storage_init(void)
+{
+    // Chip select as output, released
+    port_system_gpio_config(STORAGE_GPIO, STORAGE_PIN_CS, GPIO_MODE_OUT, GPIO_PUPDR_NOPULL);
+    port_system_gpio_write(STORAGE_GPIO, STORAGE_PIN_CS, true);
+    port_system_gpio_config(STORAGE_GPIO, STORAGE_PIN_SCK, GPIO_MODE_ALTERNATE, GPIO_PUPDR_NOPULL);
+    port_system_gpio_config(STORAGE_GPIO, STORAGE_PIN_MISO, GPIO_MODE_ALTERNATE, GPIO_PUPDR_PUP);
+    port_system_gpio_config(STORAGE_GPIO, STORAGE_PIN_MOSI, GPIO_MODE_ALTERNATE, GPIO_PUPDR_NOPULL);
+    port_system_gpio_config_alternate(STORAGE_GPIO, STORAGE_PIN_SCK, STORAGE_AF);
+    port_system_gpio_config_alternate(STORAGE_GPIO, STORAGE_PIN_MISO, STORAGE_AF);
+    port_system_gpio_config_alternate(STORAGE_GPIO, STORAGE_PIN_MOSI, STORAGE_AF);
+
+    // SPI2 master, mode 0, 8 bits, chip select by software, fPCLK1 / 4
+    RCC->APB1ENR |= RCC_APB1ENR_SPI2EN;
+    STORAGE_SPI->CR1 = 0;
+    STORAGE_SPI->CR1 = SPI_CR1_MSTR | SPI_CR1_SSM | SPI_CR1_SSI | SPI_CR1_BR_0;
+    STORAGE_SPI->CR1 |= SPI_CR1_SPE;
+
+    // The capacity code of the JEDEC ID is log2 of the size: a missing device reads 0xFF or 0x00
+    port_system_gpio_write(STORAGE_GPIO, STORAGE_PIN_CS, false);
+    _transfer(STORAGE_CMD_JEDEC_ID);
+    _transfer(0xFF);
+    _transfer(0xFF);
+    uint8_t capacity = _transfer(0xFF);
+    port_system_gpio_write(STORAGE_GPIO, STORAGE_PIN_CS, true);
+    storage_size = ((capacity >= 16) && (capacity <= 24)) ? (1UL << capacity) : 0;
+    return storage_size;
+}
+
+bool port_storage_read(uint32_t address, void *p_data, uint32_t size)
+{
+    if ((address > storage_size) || (size > storage_size - address))
+    {
+        return false;
+    }
+    uint8_t *p_bytes = (uint8_t *)p_data;
+    port_system_gpio_write(STORAGE_GPIO, STORAGE_PIN_CS, false);
+    _transfer(STORAGE_CMD_READ);
+    _transfer((uint8_t)(address >> 16));
+    _transfer((uint8_t)(address >> 8));
+    _transfer((uint8_t)address);
+    for (uint32_t i = 0; i < size; i++)
+    {
+        p_bytes[i] = _transfer(0xFF);
+    }
+    port_system_gpio_write(STORAGE_GPIO, STORAGE_PIN_CS, true);
+    return true;
+}
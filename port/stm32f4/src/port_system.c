@@ -189,6 +189,27 @@ void port_system_delay_until_ms(uint32_t *p_t, uint32_t ms)
   *p_t = port_system_get_millis();
 }
 
+/**
+ * @brief Enable and reset the cycle counter of the core (DWT CYCCNT)
+ * 
+ */
+void port_system_cycle_counter_init(void)
+{
+  CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+  DWT->CYCCNT = 0;
+  DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+}
+
+/**
+ * @brief Get the number of core clock cycles counted since port_system_cycle_counter_init()
+ * 
+ * @return uint32_t 
+ */
+uint32_t port_system_get_cycle_count(void)
+{
+  return DWT->CYCCNT;
+}
+
 //------------------------------------------------------
 // GPIO RELATED FUNCTIONS
 //------------------------------------------------------
@@ -11,6 +11,7 @@
 #include <stdlib.h>
 #include "port_system.h"
 #include "port_usart.h"
+#include "command_frame.h"
 /* HW dependent libraries */
 
 /* Global variables */
@@ -30,7 +31,14 @@ port_usart_hw_t usart_arr[] = {
     .alt_func_tx = USART_0_AF_TX,
     .alt_func_rx = USART_0_AF_RX,
     .i_idx = 0,
-    .read_complete = false,
+    .rx_head = 0,
+    .rx_tail = 0,
+    .rx_overflow = false,
+    .dropped_lines = 0,
+    .rx_frame = false,
+    .frame_length = 0,
+    .frame_crc = USART_FRAME_CRC_INIT,
+    .bad_frames = 0,
     .o_idx = 0,
     .write_complete = false}
 };
@@ -46,6 +54,59 @@ void _reset_buffer(char * buffer, uint32_t length){
     memset(buffer, EMPTY_BUFFER_CONSTANT, length);
 }
 
+/**
+ * @brief Store a byte of the binary frame being received, from its start byte to the last byte of its CRC. \n
+ * The CRC is checked as the bytes arrive: the CRC-16 of a frame followed by its CRC is 0. A frame with no errors is
+ * queued as a line, without its CRC. A frame with a wrong length or CRC is dropped, and the next byte may start a line.
+ * 
+ * @param p_hw Pointer to the USART
+ * @param data Byte received
+ */
+static void _store_frame_byte(port_usart_hw_t *p_hw, uint8_t data){
+    uint8_t idx = p_hw -> i_idx;
+    char *p_line = p_hw -> input_lines[p_hw -> rx_tail % USART_RX_QUEUE_DEPTH];
+    bool queued = false;
+    //The start byte is not part of the CRC
+    if (idx > 0){
+        p_hw -> frame_crc = command_frame_crc16_update(p_hw -> frame_crc, data);
+    }
+    //The CRC is not stored: the line holds the header and the payload
+    if (!p_hw -> rx_overflow && ((p_hw -> frame_length == 0) || (idx < p_hw -> frame_length - USART_FRAME_CRC_LENGTH))){
+        p_line[idx] = (char)data;
+    }
+    p_hw -> i_idx = idx + 1;
+    if (idx == USART_FRAME_HEADER_LENGTH - 1){
+        //The length of the payload tells where the frame ends. A payload that does not fit in a line is not a frame
+        if (data <= USART_FRAME_MAX_PAYLOAD){
+            p_hw -> frame_length = USART_FRAME_HEADER_LENGTH + data + USART_FRAME_CRC_LENGTH;
+            return;
+        }
+        p_hw -> bad_frames++;
+    }
+    else if ((p_hw -> frame_length == 0) || (p_hw -> i_idx < p_hw -> frame_length)){
+        return;
+    }
+    else if (p_hw -> rx_overflow){
+        //A frame that started while the queue was full is dropped, whole
+        p_hw -> dropped_lines++;
+    }
+    else if (p_hw -> frame_crc == 0){
+        //The frame is complete and has no errors: queue it
+        p_hw -> rx_tail++;
+        queued = true;
+    }
+    else {
+        p_hw -> bad_frames++;
+    }
+    //The frame has ended. The bytes of a frame with errors are not left in the line, unless it is a line queued
+    if (!queued && !p_hw -> rx_overflow){
+        _reset_buffer(p_line, USART_INPUT_BUFFER_LENGTH);
+    }
+    p_hw -> rx_frame = false;
+    p_hw -> rx_overflow = false;
+    p_hw -> i_idx = 0;
+}
+
 /* Public functions */
 
 
@@ -110,13 +171,13 @@ void port_usart_init(uint32_t usart_id)
     //Enable the USART
     usart_arr[usart_id].p_usart -> CR1 |= USART_CR1_UE;
     //reset buffer
-    _reset_buffer(usart_arr[usart_id].input_buffer, USART_INPUT_BUFFER_LENGTH);
+    _reset_buffer(usart_arr[usart_id].input_lines[0], sizeof(usart_arr[usart_id].input_lines));
     _reset_buffer(usart_arr[usart_id].output_buffer, USART_OUTPUT_BUFFER_LENGTH);
 }
 
 
 void port_usart_get_from_input_buffer(uint32_t usart_id, char * p_buffer){
-    memcpy(p_buffer, usart_arr[usart_id].input_buffer, USART_INPUT_BUFFER_LENGTH);
+    memcpy(p_buffer, usart_arr[usart_id].input_lines[usart_arr[usart_id].rx_head % USART_RX_QUEUE_DEPTH], USART_INPUT_BUFFER_LENGTH);
 }
 
 
@@ -131,8 +192,22 @@ bool port_usart_get_txr_status(uint32_t usart_id ){
 
 
 void port_usart_reset_input_buffer( uint32_t usart_id ){
-    _reset_buffer(usart_arr[usart_id].input_buffer, USART_INPUT_BUFFER_LENGTH);
-    usart_arr[usart_id].read_complete = false;
+    uint32_t rx_head = usart_arr[usart_id].rx_head;
+    if (rx_head != usart_arr[usart_id].rx_tail){
+        //The line is cleared before it is released: the ISR only writes lines released
+        _reset_buffer(usart_arr[usart_id].input_lines[rx_head % USART_RX_QUEUE_DEPTH], USART_INPUT_BUFFER_LENGTH);
+        usart_arr[usart_id].rx_head = rx_head + 1;
+    }
+}
+
+
+uint32_t port_usart_get_dropped_lines( uint32_t usart_id ){
+    return usart_arr[usart_id].dropped_lines;
+}
+
+
+uint32_t port_usart_get_bad_frames( uint32_t usart_id ){
+    return usart_arr[usart_id].bad_frames;
 }
 
 
@@ -143,7 +218,7 @@ void port_usart_reset_output_buffer( uint32_t usart_id ){
 
 
 bool port_usart_rx_done( uint32_t usart_id ){
-    return usart_arr[usart_id].read_complete;
+    return usart_arr[usart_id].rx_head != usart_arr[usart_id].rx_tail;
 }
 
 
@@ -154,24 +229,48 @@ bool port_usart_tx_done( uint32_t usart_id ){
 
 void port_usart_store_data( uint32_t usart_id ){
    //Retrieve data from DR register
-   char data =  usart_arr[usart_id].p_usart -> DR; 
-
+   char data = usart_arr[usart_id].p_usart -> DR; 
+   port_usart_hw_t *p_hw = &usart_arr[usart_id];
+   //A line that starts while the queue is full is dropped, whole
+   bool queue_full = (p_hw -> rx_tail - p_hw -> rx_head) >= USART_RX_QUEUE_DEPTH;
+
+   //The bytes of a binary frame are decoded one by one: an end char is part of its payload
+   if (p_hw -> rx_frame){
+    _store_frame_byte(p_hw, (uint8_t)data);
+    return;
+   }
+   if ((p_hw -> i_idx == 0) && !p_hw -> rx_overflow && ((uint8_t)data == USART_FRAME_START_CONSTANT)){
+    //A binary frame starts. It is dropped, whole, if the queue is full
+    p_hw -> rx_frame = true;
+    p_hw -> rx_overflow = queue_full;
+    p_hw -> frame_length = 0;
+    p_hw -> frame_crc = USART_FRAME_CRC_INIT;
+    _store_frame_byte(p_hw, (uint8_t)data);
+    return;
+   }
    if( data != END_CHAR_CONSTANT){
-    //Retrieve input data index
-    uint8_t i_idx = usart_arr[usart_id].i_idx;
-    if(i_idx >= USART_INPUT_BUFFER_LENGTH){
-        //Reset input buffer index
-        usart_arr[usart_id].i_idx = 0;
-    }
-    //Load data in input buffer and update input buffer index
-   usart_arr[usart_id].input_buffer[i_idx] = data;
-   usart_arr[usart_id].i_idx++;
+    if (queue_full || p_hw -> rx_overflow){
+        p_hw -> rx_overflow = true;
+        return;
+    }
+    //Retrieve input data index. Wrap around if the line is full
+    if(p_hw -> i_idx >= USART_INPUT_BUFFER_LENGTH){
+        p_hw -> i_idx = 0;
+    }
+    //Load data in the line being received and update input buffer index
+    p_hw -> input_lines[p_hw -> rx_tail % USART_RX_QUEUE_DEPTH][p_hw -> i_idx] = data;
+    p_hw -> i_idx++;
    } else {
-    //Data has been read. Reset input buffer index
-    usart_arr[usart_id].read_complete = true;
-    usart_arr[usart_id].i_idx = 0;
+    //The line is complete: queue it, or count it as dropped. Reset input buffer index
+    if (queue_full || p_hw -> rx_overflow){
+        p_hw -> dropped_lines++;
+    }
+    else {
+        p_hw -> rx_tail++;
+    }
+    p_hw -> rx_overflow = false;
+    p_hw -> i_idx = 0;
    }
-  
 }
 
 
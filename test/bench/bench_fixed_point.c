@@ -0,0 +1,149 @@
+/**
+ * @file bench_fixed_point.c
+ * @brief Benchmark of the computation of the register values of a note at a speed other than 1: doubles (frequency in Hz
+ * and speed factor, as the player did before the fixed point API) against fixed point (Q16.16 frequency and Q8.8 speed).
+ *
+ * On the board the counts are core cycles (DWT), where every double operation is a call to a software routine. On the
+ * native platform they are host cycles, where doubles run in hardware: the gap on the Cortex-M4 is larger.
+ *
+ * @author Javier de Ponte Hernando
+ * @author Roberto Maldonado Macafee
+ * @date 18/10/2026
+ */
+
+/* Includes ------------------------------------------------------------------*/
+/* Standard C libraries */
+#include <stdio.h>
+#include <math.h>
+
+/* HW dependent libraries */
+#include "port_system.h"
+#include "port_buzzer.h"
+
+/* Other libraries */
+#include "fsm_buzzer.h"
+#include "melodies.h"
+#include "note_table.h"
+
+/* Private defines ------------------------------------------------------------*/
+#define BENCH_ROUNDS 20       /*!< Number of times every note of the melody is computed */
+#define BENCH_SPEED 1.5       /*!< Speed of the player */
+#define BENCH_DETUNE 1.000001 /*!< Factor applied to the notes to miss the note table and force the computation */
+#define BENCH_MAX_NOTES 128   /*!< Maximum length of the melody */
+
+/**
+ * @brief Register values of a note computed with doubles, as the player did before the fixed point API: duration divided by the
+ * speed and PSC/ARR of the PWM timer solved with doubles when the note is not in the table.
+ *
+ * @param frequency_hz Frequency of the note in Hz
+ * @param duration_ms Duration of the note in ms at normal speed
+ * @param speed Speed of the player
+ * @param p_regs Pointer to store the register values
+ */
+static void _double_note_regs(double frequency_hz, uint32_t duration_ms, double speed, port_buzzer_note_regs_t *p_regs)
+{
+    double duration = (double)duration_ms / speed;
+    const note_regs_t *p_note = note_table_find(frequency_hz);
+    if (p_note != NULL)
+    {
+        p_regs->pwm_psc = p_note->psc;
+        p_regs->pwm_arr = p_note->arr;
+        p_regs->pwm_ccr = p_note->ccr;
+    }
+    else if (frequency_hz != 0)
+    {
+        double sysclk_double = (double)SystemCoreClock;
+        double psc_pwm = round(((sysclk_double / frequency_hz) / (65535.0 + 1.0)) - 1.0);
+        double arr_pwm = round(((sysclk_double / frequency_hz) / (psc_pwm + 1.0)) - 1.0);
+        if (arr_pwm > 65535.0)
+        {
+            psc_pwm++;
+            arr_pwm = round(((sysclk_double / frequency_hz) / (psc_pwm + 1.0)) - 1.0);
+        }
+        p_regs->pwm_ccr = (uint16_t)(BUZZER_PWM_DC * (arr_pwm + 1.0));
+        p_regs->pwm_psc = (uint16_t)psc_pwm;
+        p_regs->pwm_arr = (uint16_t)arr_pwm;
+    }
+    port_buzzer_note_regs_t duration_regs;
+    port_buzzer_get_note_regs(0, (uint32_t)duration, &duration_regs);
+    p_regs->duration_psc = duration_regs.duration_psc;
+    p_regs->duration_arr = duration_regs.duration_arr;
+}
+
+/**
+ * @brief Compute the register values of every note of a melody BENCH_ROUNDS times and return the average cost of a note.
+ *
+ * @param p_melody Melody
+ * @param detune Factor applied to the frequency of the notes
+ * @param fixed_point True to use the fixed point API
+ * @return uint32_t Average cycles per note
+ */
+static uint32_t _bench(const melody_t *p_melody, double detune, bool fixed_point)
+{
+    static uint32_t frequencies_q16[BENCH_MAX_NOTES]; // Converted in advance, as a melody stored in fixed point
+    static double frequencies_hz[BENCH_MAX_NOTES];
+    for (uint32_t i = 0; i < p_melody->melody_length; i++)
+    {
+        frequencies_hz[i] = melody_get_note_hz(p_melody, i) * detune;
+        frequencies_q16[i] = PORT_BUZZER_HZ_Q16(frequencies_hz[i]);
+    }
+    uint32_t speed_q8 = FSM_BUZZER_SPEED_Q8(BENCH_SPEED);
+
+    uint64_t total = 0;
+    uint32_t notes = 0;
+    port_buzzer_note_regs_t regs;
+    for (uint32_t round = 0; round < BENCH_ROUNDS; round++)
+    {
+        for (uint32_t i = 0; i < p_melody->melody_length; i++)
+        {
+            uint32_t start = port_system_get_cycle_count();
+            if (fixed_point)
+            {
+                uint32_t duration_us = (uint32_t)(((uint64_t)melody_get_duration_ms(p_melody, i) * 1000U * FSM_BUZZER_SPEED_Q8_ONE) / speed_q8);
+                port_buzzer_get_note_regs_q16(frequencies_q16[i], duration_us, &regs);
+            }
+            else
+            {
+                _double_note_regs(frequencies_hz[i], melody_get_duration_ms(p_melody, i), BENCH_SPEED, &regs);
+            }
+            total += port_system_get_cycle_count() - start;
+            notes++;
+        }
+    }
+    return (uint32_t)(total / notes);
+}
+
+/**
+ * @brief Print the cost of a note with both APIs.
+ *
+ * @param p_label Label of the row
+ * @param detune Factor applied to the frequency of the notes
+ */
+static void _report(const char *p_label, double detune)
+{
+    uint32_t double_cycles = _bench(&spanish_anthem, detune, false);
+    uint32_t fixed_cycles = _bench(&spanish_anthem, detune, true);
+    printf("  %s: doubles %lu cycles/note, fixed point %lu cycles/note", p_label, (unsigned long)double_cycles, (unsigned long)fixed_cycles);
+    if (fixed_cycles > 0)
+    {
+        printf(" (x%lu.%02lu)", (unsigned long)(double_cycles / fixed_cycles), (unsigned long)((double_cycles % fixed_cycles) * 100 / fixed_cycles));
+    }
+    printf("\n");
+}
+
+/**
+ * @brief Main benchmark function.
+ *
+ * @return int
+ */
+int main(void)
+{
+    port_system_init();
+    port_buzzer_init(BUZZER_0_ID);
+    port_system_cycle_counter_init();
+
+    printf("Register values of the %lu notes of %s at speed %.1f x %d rounds\n", (unsigned long)spanish_anthem.melody_length, spanish_anthem.p_name, BENCH_SPEED, BENCH_ROUNDS);
+    _report("notes of the table", 1.0);
+    _report("notes out of the table", BENCH_DETUNE);
+    return 0;
+}
@@ -0,0 +1,93 @@
+/**
+ * @file bench_melody_codec.c
+ * @brief Benchmark of the packed melodies: size of the tokens of the compact melodies of the jukebox against the
+ * compact format (a MIDI note number and a number of ticks a note), and cost of reading a note as the player does (its
+ * frequency and its duration, in order) from a melody packed against a compact melody.
+ *
+ * On the board the counts are core cycles (DWT). On the native platform they are host cycles: only the ratio between
+ * both formats is meaningful.
+ *
+ * @author Javier de Ponte Hernando
+ * @author Roberto Maldonado Macafee
+ * @date 18/10/2026
+ */
+
+/* Includes ------------------------------------------------------------------*/
+/* Standard C libraries */
+#include <stdio.h>
+
+/* HW dependent libraries */
+#include "port_system.h"
+
+/* Other libraries */
+#include "melodies.h"
+#include "melody_codec.h"
+
+/* Private defines ------------------------------------------------------------*/
+#define BENCH_MAX_NOTES 256U /*!< Maximum number of notes of the melodies measured */
+#define BENCH_ROUNDS 100     /*!< Times every melody is read */
+
+static const melody_t *melodies[] = {&happy_birthday_melody, &tetris_melody, &spanish_anthem, &feliz_navidad_melody}; /*!< Compact melodies measured */
+
+/**
+ * @brief Read every note of a melody in order BENCH_ROUNDS times and return the average cost of a note.
+ *
+ * @param p_melody Melody
+ * @return uint32_t Average cycles per note
+ */
+static uint32_t _bench(const melody_t *p_melody)
+{
+    uint64_t total = 0;
+    uint32_t notes = 0;
+    volatile uint32_t sink = 0;
+    for (uint32_t round = 0; round < BENCH_ROUNDS; round++)
+    {
+        for (uint32_t i = 0; i < p_melody->melody_length; i++)
+        {
+            uint32_t start = port_system_get_cycle_count();
+            sink += melody_get_note_q16(p_melody, i) + melody_get_duration_ms(p_melody, i);
+            total += port_system_get_cycle_count() - start;
+            notes++;
+        }
+    }
+    return (uint32_t)(total / notes);
+}
+
+/**
+ * @brief Main benchmark function.
+ *
+ * @return int
+ */
+int main(void)
+{
+    port_system_init();
+    port_system_cycle_counter_init();
+
+    uint32_t total_compact = 0;
+    uint32_t total_packed = 0;
+    printf("Size of the notes and durations in bytes, and cycles to read a note in order (%d rounds)\n", BENCH_ROUNDS);
+    printf("  %-16s %6s %8s %7s %6s %14s %13s\n", "melody", "notes", "compact", "packed", "ratio", "compact cycles", "packed cycles");
+    for (uint32_t i = 0; i < sizeof(melodies) / sizeof(melodies[0]); i++)
+    {
+        static uint8_t data[3U * BENCH_MAX_NOTES];
+        static melody_codec_t codec;
+        const melody_t *p_melody = melodies[i];
+        int32_t size = melody_codec_encode(p_melody->p_midi_notes, p_melody->p_ticks, p_melody->melody_length, data, sizeof(data));
+        if (size < 0)
+        {
+            printf("  %-16s cannot be packed\n", p_melody->p_name);
+            continue;
+        }
+        melody_codec_init(&codec, data, (uint32_t)size, p_melody->melody_length);
+        melody_t packed = {.p_name = p_melody->p_name, .p_codec = &codec, .melody_length = p_melody->melody_length, .tick_ms = p_melody->tick_ms};
+        uint32_t compact = melody_get_size(p_melody, true);
+        printf("  %-16s %6u %8lu %7ld %5lu%% %14lu %13lu\n", p_melody->p_name, p_melody->melody_length, (unsigned long)compact, (long)size,
+               (unsigned long)((100U * (uint32_t)size) / compact), (unsigned long)_bench(p_melody), (unsigned long)_bench(&packed));
+        total_compact += compact;
+        total_packed += (uint32_t)size;
+    }
+    printf("  %-16s %6s %8lu %7lu %5lu%%\n", "total", "", (unsigned long)total_compact, (unsigned long)total_packed,
+           (unsigned long)((100U * total_packed) / total_compact));
+    printf("  decoder state: %lu bytes, for a melody of any length\n", (unsigned long)sizeof(melody_codec_t));
+    return 0;
+}
@@ -0,0 +1,68 @@
+/**
+ * @file bench_melody_size.c
+ * @brief Report of the memory taken by the melodies of the jukebox with the notes in Hz and durations in ms (a double and a uint16_t
+ * a note, plus the registers of the compiled melody) against the compact format (a MIDI note number and a number of ticks a note).
+ *
+ * The compact notes share the MIDI index of the note table, which is counted once. Sizes are in bytes of the platform the benchmark is
+ * built for: the pointers of the MIDI index take 4 bytes on the board and 8 bytes on a 64-bit host.
+ *
+ * @author Javier de Ponte Hernando
+ * @author Roberto Maldonado Macafee
+ * @date 18/10/2026
+ */
+
+/* Includes ------------------------------------------------------------------*/
+/* Standard C libraries */
+#include <stdio.h>
+
+/* HW dependent libraries */
+#include "port_system.h"
+#include "port_buzzer.h"
+
+/* Other libraries */
+#include "melodies.h"
+#include "note_table.h"
+
+/* Private defines ------------------------------------------------------------*/
+#define BENCH_FLASH_BYTES (64U * 1024U) /*!< Flash reserved for melodies in the estimation of the number of songs */
+
+static const melody_t *melodies[] = {&happy_birthday_melody, &tetris_melody, &spanish_anthem, &feliz_navidad_melody,
+                                     &scale_melody, &scale_reverse_melody, &scale_thirds_melody, &scale_bass_melody}; /*!< Melodies measured */
+
+/**
+ * @brief Main benchmark function.
+ *
+ * @return int
+ */
+int main(void)
+{
+    uint32_t total_notes = 0;
+    uint32_t total_hz = 0;
+    uint32_t total_compact = 0;
+    printf("Memory of the notes and durations of the melodies, in bytes\n");
+    printf("  %-16s %6s %12s %8s\n", "melody", "notes", "Hz + regs", "compact");
+    for (uint32_t i = 0; i < sizeof(melodies) / sizeof(melodies[0]); i++)
+    {
+        const melody_t *p_melody = melodies[i];
+        // The melodies in Hz are also compiled into timer registers
+        uint32_t hz = melody_get_size(p_melody, false) + p_melody->melody_length * sizeof(port_buzzer_note_regs_t);
+        uint32_t compact = melody_get_size(p_melody, true);
+        printf("  %-16s %6u %12lu %8lu%s\n", p_melody->p_name, p_melody->melody_length, (unsigned long)hz, (unsigned long)compact,
+               melody_is_compact(p_melody) ? " (stored compact)" : "");
+        total_notes += p_melody->melody_length;
+        total_hz += hz;
+        total_compact += compact;
+    }
+    uint32_t index = sizeof(note_table_midi);
+    printf("  %-16s %6lu %12lu %8lu + %lu of the shared MIDI index\n", "total", (unsigned long)total_notes, (unsigned long)total_hz,
+           (unsigned long)total_compact, (unsigned long)index);
+    printf("  reduction: %lu%%\n", (unsigned long)(100U - (100U * (total_compact + index)) / total_hz));
+
+    // Songs of the average length of the melodies above that fit in the flash reserved for melodies
+    uint32_t song_notes = total_notes / (sizeof(melodies) / sizeof(melodies[0]));
+    uint32_t song_hz = song_notes * (sizeof(double) + sizeof(uint16_t) + sizeof(port_buzzer_note_regs_t)) + sizeof(melody_t);
+    uint32_t song_compact = song_notes * 2U + sizeof(melody_t);
+    printf("Songs of %lu notes in %lu KB: %lu in Hz, %lu compact\n", (unsigned long)song_notes, (unsigned long)(BENCH_FLASH_BYTES / 1024U),
+           (unsigned long)(BENCH_FLASH_BYTES / song_hz), (unsigned long)((BENCH_FLASH_BYTES - index) / song_compact));
+    return 0;
+}
@@ -0,0 +1,97 @@
+/**
+ * @file bench_note_frequency.c
+ * @brief Benchmark of port_buzzer_set_note_frequency(): pre-solved note table (fast path) against the PSC/ARR
+ * computation with doubles (used for frequencies that are not in melodies.h).
+ *
+ * On the board the counts are core cycles (DWT). On the native platform they are host cycles, where doubles run in
+ * hardware: the gap on the Cortex-M4, that only has a single precision FPU, is larger.
+ *
+ * @author Javier de Ponte Hernando
+ * @author Roberto Maldonado Macafee
+ * @date 17/10/2026
+ */
+
+/* Includes ------------------------------------------------------------------*/
+/* Standard C libraries */
+#include <stdio.h>
+
+/* HW dependent libraries */
+#include "port_system.h"
+#include "port_buzzer.h"
+
+/* Other libraries */
+#include "note_table.h"
+
+/* Private defines ------------------------------------------------------------*/
+#define BENCH_ROUNDS 200 /*!< Number of times every note is set */
+#define BENCH_DETUNE 1.000001 /*!< Factor applied to the notes to miss the table and force the computation */
+
+/**
+ * @brief Set every note of the table BENCH_ROUNDS times and return the average cost of a call.
+ *
+ * @param detune Factor applied to the frequency of the notes
+ * @return uint32_t Average cycles per call
+ */
+static uint32_t _bench(double detune)
+{
+    uint64_t total = 0;
+    uint32_t calls = 0;
+    for (uint32_t round = 0; round < BENCH_ROUNDS; round++)
+    {
+        // Entry 0 is the silence: it does not program the timer
+        for (uint32_t i = 1; i < NOTE_TABLE_LENGTH; i++)
+        {
+            double frequency_hz = note_table[i].frequency_hz * detune;
+            uint32_t start = port_system_get_cycle_count();
+            port_buzzer_set_note_frequency(BUZZER_0_ID, frequency_hz);
+            total += port_system_get_cycle_count() - start;
+            calls++;
+        }
+    }
+    return (uint32_t)(total / calls);
+}
+
+/**
+ * @brief Measure the cost of reading the cycle counter, to subtract it from the results.
+ *
+ * @return uint32_t
+ */
+static uint32_t _overhead(void)
+{
+    uint64_t total = 0;
+    for (uint32_t i = 0; i < BENCH_ROUNDS; i++)
+    {
+        uint32_t start = port_system_get_cycle_count();
+        total += port_system_get_cycle_count() - start;
+    }
+    return (uint32_t)(total / BENCH_ROUNDS);
+}
+
+/**
+ * @brief Main benchmark function.
+ *
+ * @return int
+ */
+int main(void)
+{
+    port_system_init();
+    port_buzzer_init(BUZZER_0_ID);
+    port_system_cycle_counter_init();
+
+    uint32_t overhead = _overhead();
+    uint32_t table_cycles = _bench(1.0);
+    uint32_t computed_cycles = _bench(BENCH_DETUNE);
+    table_cycles = (table_cycles > overhead) ? table_cycles - overhead : 0;
+    computed_cycles = (computed_cycles > overhead) ? computed_cycles - overhead : 0;
+    port_buzzer_stop(BUZZER_0_ID);
+
+    printf("port_buzzer_set_note_frequency() over %d notes x %d rounds\n", NOTE_TABLE_LENGTH - 1, BENCH_ROUNDS);
+    printf("  note table (fast path): %lu cycles/call\n", (unsigned long)table_cycles);
+    printf("  computed with doubles:  %lu cycles/call\n", (unsigned long)computed_cycles);
+    if (table_cycles > 0)
+    {
+        printf("  speed-up: x%lu.%02lu\n", (unsigned long)(computed_cycles / table_cycles), (unsigned long)((computed_cycles % table_cycles) * 100 / table_cycles));
+    }
+    printf("  worst pitch error of the table: %.4f cents\n", NOTE_TABLE_MAX_ERROR_CENTS);
+    return 0;
+}
@@ -0,0 +1,114 @@
+/**
+ * @file bench_note_gap.c
+ * @brief Benchmark of the silent gap between the end of a note and the start of the next one: notes started by the
+ * main loop against notes staged in the timers (gapless mode).
+ *
+ * The main loop fires the same FSMs as main.c. The gaps are measured by the buzzer port: in core cycles (DWT) on the
+ * board and in cycles of the virtual clock on the native platform, where every poll of a port status function costs
+ * NATIVE_SIM_POLL_CYCLES.
+ *
+ * @author Javier de Ponte Hernando
+ * @author Roberto Maldonado Macafee
+ * @date 18/10/2026
+ */
+
+/* Includes ------------------------------------------------------------------*/
+/* Standard C libraries */
+#include <stdio.h>
+
+/* HW dependent libraries */
+#include "port_system.h"
+#include "port_button.h"
+#include "port_usart.h"
+#include "port_buzzer.h"
+
+/* Other libraries */
+#include "fsm_button.h"
+#include "fsm_usart.h"
+#include "fsm_buzzer.h"
+#include "melodies.h"
+
+/* Global variables */
+static const melody_t *melodies[] = {&happy_birthday_melody, &tetris_melody, &scale_melody, &feliz_navidad_melody}; /*!< Melodies played */
+
+/**
+ * @brief Play every melody with the given mode and accumulate the gaps between notes.
+ *
+ * @param p_fsm_buzzer Buzzer FSM
+ * @param p_fsm_button Button FSM, fired as in main.c
+ * @param p_fsm_usart USART FSM, fired as in main.c
+ * @param gapless Mode of the player
+ * @param p_stats Pointer to store the accumulated statistics
+ */
+static void _bench(fsm_t *p_fsm_buzzer, fsm_t *p_fsm_button, fsm_t *p_fsm_usart, bool gapless, port_buzzer_gap_stats_t *p_stats)
+{
+    p_stats->count = 0;
+    p_stats->max_cycles = 0;
+    p_stats->total_cycles = 0;
+    fsm_buzzer_set_gapless(p_fsm_buzzer, gapless);
+    for (uint32_t i = 0; i < sizeof(melodies) / sizeof(melodies[0]); i++)
+    {
+        fsm_buzzer_set_melody(p_fsm_buzzer, melodies[i]);
+        fsm_buzzer_set_action(p_fsm_buzzer, PLAY);
+        fsm_fire(p_fsm_buzzer);
+        port_buzzer_reset_gap_stats(BUZZER_0_ID);
+        while (fsm_buzzer_get_action(p_fsm_buzzer) != STOP)
+        {
+            fsm_fire(p_fsm_button);
+            fsm_fire(p_fsm_usart);
+            fsm_fire(p_fsm_buzzer);
+        }
+
+        port_buzzer_gap_stats_t stats;
+        port_buzzer_get_gap_stats(BUZZER_0_ID, &stats);
+        p_stats->count += stats.count;
+        p_stats->total_cycles += stats.total_cycles;
+        if (stats.max_cycles > p_stats->max_cycles)
+        {
+            p_stats->max_cycles = stats.max_cycles;
+        }
+    }
+}
+
+/**
+ * @brief Print the statistics of the gaps.
+ *
+ * @param p_label Name of the mode
+ * @param p_stats Statistics
+ */
+static void _print(const char *p_label, const port_buzzer_gap_stats_t *p_stats)
+{
+    uint32_t cycles_per_us = SystemCoreClock / 1000000U;
+    uint32_t avg = (p_stats->count > 0) ? (uint32_t)(p_stats->total_cycles / p_stats->count) : 0;
+    printf("  %s %lu gaps, avg %lu cycles (%lu us), max %lu cycles (%lu us)\n", p_label, (unsigned long)p_stats->count,
+           (unsigned long)avg, (unsigned long)(avg / cycles_per_us),
+           (unsigned long)p_stats->max_cycles, (unsigned long)(p_stats->max_cycles / cycles_per_us));
+}
+
+/**
+ * @brief Main benchmark function.
+ *
+ * @return int
+ */
+int main(void)
+{
+    port_system_init();
+    port_system_cycle_counter_init();
+    fsm_t *p_fsm_button = fsm_button_new(BUTTON_0_DEBOUNCE_TIME_MS, BUTTON_0_ID);
+    fsm_t *p_fsm_usart = fsm_usart_new(USART_0_ID);
+    fsm_t *p_fsm_buzzer = fsm_buzzer_new(BUZZER_0_ID);
+
+    port_buzzer_gap_stats_t restarted;
+    port_buzzer_gap_stats_t staged;
+    _bench(p_fsm_buzzer, p_fsm_button, p_fsm_usart, false, &restarted);
+    _bench(p_fsm_buzzer, p_fsm_button, p_fsm_usart, true, &staged);
+
+    printf("Gap between notes over %d melodies\n", (int)(sizeof(melodies) / sizeof(melodies[0])));
+    _print("started by the main loop:", &restarted);
+    _print("staged (gapless):        ", &staged);
+
+    fsm_destroy(p_fsm_button);
+    fsm_destroy(p_fsm_usart);
+    fsm_destroy(p_fsm_buzzer);
+    return 0;
+}
@@ -0,0 +1,153 @@
+/**
+ * @file bench_command_dispatch.c
+ * @brief Benchmark of the dispatch of the commands of the USART: cycles from a line received to the call of the
+ * handler of its command. The chain of strcmp() the jukebox used, after copying the command and its parameter out of
+ * the line with strtok(), against the command table of the jukebox, after tokenizing the line in place.
+ *
+ * Both dispatchers hold the commands of the jukebox, in the order of the chain, with handlers that do nothing, so only
+ * the parse and the lookup are measured. The chain gets slower for the commands at its end; the table costs the same
+ * for every command.
+ *
+ * @author Javier de Ponte Hernando
+ * @author Roberto Maldonado Macafee
+ * @date 18/10/2026
+ */
+
+/* Includes ------------------------------------------------------------------*/
+/* Standard C libraries */
+#include <stdio.h>
+#include <string.h>
+
+/* HW dependent libraries */
+#include "port_system.h"
+
+/* Other libraries */
+#include "command_line.h"
+#include "command_table.h"
+
+/* Private defines ------------------------------------------------------------*/
+#define BENCH_ROUNDS 10000    /*!< Times every line is dispatched */
+#define BENCH_LINE_LENGTH 64U /*!< Maximum length of a line */
+
+/**
+ * @brief Lines measured: a command of the jukebox each, in the order of the chain, and a command that does not exist.
+ */
+static const char *lines[] = {"play", "stop", "pause", "speed 1.5 200", "next", "select tetris", "info", "drift",
+                              "seek 1000", "upload song 10", "bank", "stream", "cache", "volume 3"};
+
+static volatile uint32_t handled; /*!< Calls of the handlers, so that they are not optimized out */
+
+/**
+ * @brief Handler of every command: it only counts its call.
+ */
+static void _handler(void *p_context, command_line_t *p_line)
+{
+    handled++;
+}
+
+/**
+ * @brief Split a line into its command and its parameter, and copy them, as the jukebox did.
+ *
+ * @param p_line Line, modified
+ * @param p_command Pointer to store the command
+ * @param p_param Pointer to store the parameter, " " if there is none
+ */
+static void _parse_copy(char *p_line, char *p_command, char *p_param)
+{
+    char *p_token = strtok(p_line, " ");
+    strcpy(p_command, (p_token != NULL) ? p_token : "");
+    p_token = strtok(NULL, "");
+    strcpy(p_param, (p_token != NULL) ? p_token : " ");
+}
+
+/**
+ * @brief Dispatch a command with a chain of strcmp(), in the order of the jukebox.
+ *
+ * @param p_command Command
+ * @param p_param Parameter
+ * @return true if the command exists
+ */
+static bool _dispatch_chain(const char *p_command, char *p_param)
+{
+    for (uint32_t i = 0; i < sizeof(lines) / sizeof(lines[0]) - 1U; i++)
+    {
+        size_t length = strcspn(lines[i], " ");
+        if ((strncmp(p_command, lines[i], length) == 0) && (p_command[length] == '\0'))
+        {
+            handled++;
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief Parse and dispatch a line BENCH_ROUNDS times and return the average cost.
+ *
+ * @param p_table Command table, or NULL to dispatch with the chain of strcmp()
+ * @param p_line Line
+ * @return uint32_t Average cycles per line
+ */
+static uint32_t _bench(const command_table_t *p_table, const char *p_line)
+{
+    uint64_t total = 0;
+    for (uint32_t round = 0; round < BENCH_ROUNDS; round++)
+    {
+        char text[BENCH_LINE_LENGTH];
+        strcpy(text, p_line);
+        uint32_t start = port_system_get_cycle_count();
+        if (p_table != NULL)
+        {
+            command_line_t line;
+            command_line_tokenize(&line, text);
+            command_table_dispatch(p_table, &line);
+        }
+        else
+        {
+            char command[BENCH_LINE_LENGTH];
+            char param[BENCH_LINE_LENGTH];
+            _parse_copy(text, command, param);
+            _dispatch_chain(command, param);
+        }
+        total += port_system_get_cycle_count() - start;
+    }
+    return (uint32_t)(total / BENCH_ROUNDS);
+}
+
+/**
+ * @brief Main benchmark function.
+ *
+ * @return int
+ */
+int main(void)
+{
+    static command_table_t table;
+    static char names[sizeof(lines) / sizeof(lines[0])][BENCH_LINE_LENGTH];
+    port_system_init();
+    port_system_cycle_counter_init();
+
+    command_table_init(&table);
+    for (uint32_t i = 0; i < sizeof(lines) / sizeof(lines[0]) - 1U; i++)
+    {
+        size_t length = strcspn(lines[i], " ");
+        memcpy(names[i], lines[i], length);
+        command_table_register(&table, names[i], COMMAND_TABLE_NO_OPCODE, 0, COMMAND_TABLE_ANY_ARGS, _handler, NULL);
+    }
+
+    uint64_t total_chain = 0;
+    uint64_t total_table = 0;
+    printf("Cycles to parse a line and call the handler of its command (%d rounds)\n", BENCH_ROUNDS);
+    printf("  %-16s %8s %8s\n", "line", "strcmp", "table");
+    for (uint32_t i = 0; i < sizeof(lines) / sizeof(lines[0]); i++)
+    {
+        uint32_t chain = _bench(NULL, lines[i]);
+        uint32_t table_cycles = _bench(&table, lines[i]);
+        printf("  %-16s %8lu %8lu\n", lines[i], (unsigned long)chain, (unsigned long)table_cycles);
+        total_chain += chain;
+        total_table += table_cycles;
+    }
+    printf("  %-16s %8lu %8lu\n", "average", (unsigned long)(total_chain / (sizeof(lines) / sizeof(lines[0]))),
+           (unsigned long)(total_table / (sizeof(lines) / sizeof(lines[0]))));
+    printf("  commands found: %lu\n", (unsigned long)handled);
+    return 0;
+}
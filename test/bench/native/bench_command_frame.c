@@ -0,0 +1,252 @@
+/**
+ * @file bench_command_frame.c
+ * @brief Benchmark of the throughput of the commands received over the USART: text lines against binary frames.
+ *
+ * The same commands, with the arguments of the commands of the jukebox, are sent back to back through USART_0 at
+ * USART_0_BAUDRATE, as text lines and as binary frames (command_frame.h). They are received by the ISR of the USART
+ * port, queued, decoded and dispatched to a command table with the names of the commands of the jukebox and handlers
+ * that do nothing. The commands per second are measured with the virtual clock: they are bound by the bytes on the
+ * line. The virtual clock does not account the time spent running code, so the cycles from the first byte of a
+ * command to the call of its handler (the ISR of every byte, the decoding and the dispatch) are measured apart, with
+ * the bytes written straight to the Data Register.
+ *
+ * @author Javier de Ponte Hernando
+ * @author Roberto Maldonado Macafee
+ * @date 18/10/2026
+ */
+
+/* Includes ------------------------------------------------------------------*/
+/* Standard C libraries */
+#include <stdio.h>
+#include <string.h>
+
+/* HW dependent libraries */
+#include "port_system.h"
+#include "port_usart.h"
+
+/* Other libraries */
+#include "command_line.h"
+#include "command_table.h"
+#include "command_frame.h"
+
+/* Private defines ------------------------------------------------------------*/
+#define BENCH_ROUNDS 100                  /*!< Times every command is sent */
+#define BENCH_CYCLES_ROUNDS 10000         /*!< Times every command is decoded to measure its cycles */
+#define BENCH_MAX_ARGS 2U                 /*!< Maximum number of arguments of a command measured */
+#define BENCH_COMMAND_LENGTH 40U          /*!< Maximum length of a command, as a text line or as a frame */
+#define BENCH_STREAM_LENGTH (BENCH_ROUNDS * sizeof(commands) / sizeof(commands[0]) * BENCH_COMMAND_LENGTH) /*!< Bytes of all the commands sent */
+
+/* Typedefs --------------------------------------------------------------------*/
+/**
+ * @brief Command measured: its name, the order of the jukebox, and its arguments.
+ */
+typedef struct
+{
+    const char *p_name;                   /*!< Name of the command */
+    uint8_t opcode;                       /*!< Opcode of the command in the jukebox */
+    const char *args[BENCH_MAX_ARGS];     /*!< Arguments of the command */
+    uint32_t num_args;                    /*!< Number of arguments */
+} bench_command_t;
+
+/**
+ * @brief Encoding of the commands.
+ */
+typedef enum
+{
+    BENCH_TEXT = 0, /*!< Text lines */
+    BENCH_FRAME,    /*!< Binary frames */
+} bench_mode_t;
+
+/* Private variables ----------------------------------------------------------*/
+/**
+ * @brief Commands measured: the names of the jukebox, in the order of its command table, with typical arguments.
+ */
+static const bench_command_t commands[] = {
+    {"play", 0, {NULL}, 0},
+    {"stop", 1, {NULL}, 0},
+    {"speed", 3, {"1.5", "200"}, 2},
+    {"next", 4, {NULL}, 0},
+    {"select", 5, {"tetris"}, 1},
+    {"info", 6, {NULL}, 0},
+    {"seek", 8, {"1000"}, 1},
+    {"upload", 9, {"song", "10"}, 2},
+};
+
+/**
+ * @brief Names of the commands of the jukebox, in the order of its command table.
+ */
+static const char *names[] = {"play", "stop", "pause", "speed", "next", "select", "info", "drift", "seek", "upload", "bank", "stream", "cache", "queue", "dequeue", "clear", "list"};
+
+static command_table_t table;       /*!< Command table of the benchmark */
+static volatile uint32_t handled;   /*!< Calls of the handlers */
+
+/* Private functions ----------------------------------------------------------*/
+/**
+ * @brief Handler of every command: it only counts its call.
+ */
+static void _handler(void *p_context, command_line_t *p_line)
+{
+    handled++;
+}
+
+/**
+ * @brief Encode a command as a text line or as a frame.
+ *
+ * @param p_command Command
+ * @param mode Encoding
+ * @param p_bytes Pointer to store the bytes
+ * @return uint32_t Number of bytes
+ */
+static uint32_t _encode(const bench_command_t *p_command, bench_mode_t mode, uint8_t *p_bytes)
+{
+    if (mode == BENCH_FRAME)
+    {
+        return command_frame_encode(p_command->opcode, p_command->args, p_command->num_args, p_bytes, BENCH_COMMAND_LENGTH);
+    }
+    char *p_text = (char *)p_bytes;
+    strcpy(p_text, p_command->p_name);
+    for (uint32_t i = 0; i < p_command->num_args; i++)
+    {
+        strcat(p_text, " ");
+        strcat(p_text, p_command->args[i]);
+    }
+    strcat(p_text, "\n");
+    return (uint32_t)strlen(p_text);
+}
+
+/**
+ * @brief Read the line at the head of the queue of the USART, decode it and dispatch its command, as the jukebox does.
+ */
+static void _read_line(void)
+{
+    char text[USART_INPUT_BUFFER_LENGTH + 1] = {0};
+    command_line_t line;
+    uint8_t opcode;
+    port_usart_get_from_input_buffer(USART_0_ID, text);
+    if (command_frame_is_frame(text))
+    {
+        if (command_frame_decode(&line, text, &opcode))
+        {
+            command_table_call(command_table_get(&table, opcode), &line);
+        }
+    }
+    else if (command_line_tokenize(&line, text))
+    {
+        command_table_dispatch(&table, &line);
+    }
+    port_usart_reset_input_buffer(USART_0_ID);
+}
+
+/**
+ * @brief Send every command BENCH_ROUNDS times, back to back, and read them as they are received.
+ *
+ * @param mode Encoding
+ * @param p_bytes Pointer to store the average bytes per command
+ * @return uint32_t Commands per second, by the virtual clock
+ */
+static uint32_t _bench_throughput(bench_mode_t mode, uint32_t *p_bytes)
+{
+    static uint8_t stream[BENCH_STREAM_LENGTH];
+    uint32_t length = 0;
+    uint32_t expected = BENCH_ROUNDS * sizeof(commands) / sizeof(commands[0]);
+    for (uint32_t round = 0; round < BENCH_ROUNDS; round++)
+    {
+        for (uint32_t i = 0; i < sizeof(commands) / sizeof(commands[0]); i++)
+        {
+            length += _encode(&commands[i], mode, &stream[length]);
+        }
+    }
+    port_usart_init(USART_0_ID);
+    port_usart_enable_rx_interrupt(USART_0_ID);
+    handled = 0;
+
+    uint64_t start = port_system_sim_get_cycles();
+    uint32_t sent = 0;
+    while (handled < expected)
+    {
+        // The simulated FIFO of the line takes the bytes as there is room
+        sent += port_usart_sim_receive(USART_0_ID, (const char *)&stream[sent], length - sent);
+        if (port_usart_rx_done(USART_0_ID))
+        {
+            _read_line();
+        }
+        else if (!port_system_sim_wait_for_event())
+        {
+            break;
+        }
+    }
+    uint64_t elapsed = port_system_sim_get_cycles() - start;
+    *p_bytes = length / expected;
+    return (uint32_t)(((uint64_t)handled * SystemCoreClock) / elapsed);
+}
+
+/**
+ * @brief Measure the cycles from the first byte of a command to the call of its handler.
+ *
+ * @param p_command Command
+ * @param mode Encoding
+ * @return uint32_t Average cycles per command
+ */
+static uint32_t _bench_cycles(const bench_command_t *p_command, bench_mode_t mode)
+{
+    uint8_t bytes[BENCH_COMMAND_LENGTH];
+    uint32_t length = _encode(p_command, mode, bytes);
+    uint64_t total = 0;
+    port_usart_init(USART_0_ID);
+    for (uint32_t round = 0; round < BENCH_CYCLES_ROUNDS; round++)
+    {
+        uint32_t start = port_system_get_cycle_count();
+        for (uint32_t i = 0; i < length; i++)
+        {
+            usart_arr[USART_0_ID].p_usart->DR = bytes[i];
+            port_usart_store_data(USART_0_ID);
+        }
+        _read_line();
+        total += port_system_get_cycle_count() - start;
+    }
+    return (uint32_t)(total / BENCH_CYCLES_ROUNDS);
+}
+
+/**
+ * @brief Main benchmark function.
+ *
+ * @return int
+ */
+int main(void)
+{
+    port_system_init();
+    port_system_cycle_counter_init();
+    command_table_init(&table);
+    for (uint32_t i = 0; i < sizeof(names) / sizeof(names[0]); i++)
+    {
+        command_table_register(&table, names[i], (uint8_t)i, 0, COMMAND_TABLE_ANY_ARGS, _handler, NULL);
+    }
+
+    printf("Cycles from the first byte of a command to its handler (%d rounds)\n", BENCH_CYCLES_ROUNDS);
+    printf("  %-20s %6s %6s %8s %8s\n", "command", "bytes", "", "cycles", "");
+    printf("  %-20s %6s %6s %8s %8s\n", "", "text", "frame", "text", "frame");
+    for (uint32_t i = 0; i < sizeof(commands) / sizeof(commands[0]); i++)
+    {
+        uint8_t bytes[BENCH_COMMAND_LENGTH];
+        char text[BENCH_COMMAND_LENGTH];
+        uint32_t text_length = _encode(&commands[i], BENCH_TEXT, (uint8_t *)text);
+        text[text_length - 1U] = '\0';
+        printf("  %-20s %6lu %6lu %8lu %8lu\n", text, (unsigned long)text_length,
+               (unsigned long)_encode(&commands[i], BENCH_FRAME, bytes),
+               (unsigned long)_bench_cycles(&commands[i], BENCH_TEXT), (unsigned long)_bench_cycles(&commands[i], BENCH_FRAME));
+    }
+
+    uint32_t text_bytes;
+    uint32_t frame_bytes;
+    uint32_t text_rate = _bench_throughput(BENCH_TEXT, &text_bytes);
+    uint32_t text_handled = handled;
+    uint32_t frame_rate = _bench_throughput(BENCH_FRAME, &frame_bytes);
+    printf("Commands per second at %d baud (%lu commands back to back)\n", USART_0_BAUDRATE,
+           (unsigned long)(BENCH_ROUNDS * sizeof(commands) / sizeof(commands[0])));
+    printf("  %-8s %10s %10s %10s\n", "mode", "bytes/cmd", "cmds/s", "handled");
+    printf("  %-8s %10lu %10lu %10lu\n", "text", (unsigned long)text_bytes, (unsigned long)text_rate, (unsigned long)text_handled);
+    printf("  %-8s %10lu %10lu %10lu\n", "frame", (unsigned long)frame_bytes, (unsigned long)frame_rate, (unsigned long)handled);
+    printf("  dropped lines: %lu, bad frames: %lu\n", (unsigned long)port_usart_get_dropped_lines(USART_0_ID),
+           (unsigned long)port_usart_get_bad_frames(USART_0_ID));
+    return 0;
+}
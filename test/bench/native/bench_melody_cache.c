@@ -0,0 +1,194 @@
+/**
+ * @file bench_melody_cache.c
+ * @brief Benchmark of the melody cache: time spent getting the notes of the melodies of a library in a storage device,
+ * decoding every melody requested against decoding through the LRU cache of the jukebox.
+ *
+ * A library of BENCH_NUM_MELODIES melodies of BENCH_MELODY_LENGTH notes is written to a file, used as the storage
+ * device. The requests of a user are replayed with three distributions: Zipf (a few favourites requested most of the
+ * time), uniform, and sequential (`next` through the whole library, the worst case of an LRU cache). The decode time
+ * counts opening the melody and reading all its notes; the counts are host cycles and include the reads of the file,
+ * so they are a lower bound of the time of an SPI flash.
+ *
+ * @author Javier de Ponte Hernando
+ * @author Roberto Maldonado Macafee
+ * @date 18/10/2026
+ */
+
+/* Includes ------------------------------------------------------------------*/
+/* Standard C libraries */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* HW dependent libraries */
+#include "port_system.h"
+#include "port_storage.h"
+
+/* Other libraries */
+#include "melodies.h"
+#include "melody_bank.h"
+#include "melody_stream.h"
+#include "melody_cache.h"
+
+/* Private defines ------------------------------------------------------------*/
+#define BENCH_NUM_MELODIES 16U                     /*!< Melodies of the library */
+#define BENCH_MELODY_LENGTH 200U                   /*!< Notes of every melody of the library */
+#define BENCH_NAME_SIZE 8U                         /*!< Bytes of the name of a melody */
+#define BENCH_REQUESTS 1000U                       /*!< Requests replayed with every distribution */
+#define BENCH_LIBRARY_PATH "bench_melody_cache.bin" /*!< File of the library, in the working directory */
+
+/* Global variables */
+static melody_stream_t stream; /*!< Library of the storage device */
+static melody_cache_t cache;   /*!< Cache under test */
+static melody_t view;          /*!< Melody selected, as the jukebox keeps it */
+static uint8_t midi_notes[BENCH_MELODY_LENGTH]; /*!< Notes decoded without the cache */
+static uint8_t ticks[BENCH_MELODY_LENGTH];      /*!< Durations decoded without the cache */
+static uint32_t seed = 1;      /*!< State of the pseudo-random generator: the requests are the same on every run */
+
+/**
+ * @brief Write the library to a file in the melody bank format, and use it as the storage device.
+ */
+static void _write_library(void)
+{
+    uint32_t index_offset = sizeof(melody_bank_t) + BENCH_NUM_MELODIES * sizeof(melody_bank_entry_t);
+    uint32_t names_offset = index_offset + BENCH_NUM_MELODIES * sizeof(uint16_t);
+    uint32_t notes_offset = names_offset + BENCH_NUM_MELODIES * BENCH_NAME_SIZE;
+    static uint8_t image[sizeof(melody_bank_t) + BENCH_NUM_MELODIES * (sizeof(melody_bank_entry_t) + sizeof(uint16_t) + BENCH_NAME_SIZE + 2U * BENCH_MELODY_LENGTH)];
+    memset(image, 0, sizeof(image));
+    *(melody_bank_t *)image = (melody_bank_t){.magic = MELODY_BANK_MAGIC, .version = MELODY_BANK_VERSION, .num_melodies = BENCH_NUM_MELODIES, .size = sizeof(image), .index_offset = index_offset};
+    for (uint32_t m = 0; m < BENCH_NUM_MELODIES; m++)
+    {
+        melody_bank_entry_t *p_entry = (melody_bank_entry_t *)&image[sizeof(melody_bank_t) + m * sizeof(melody_bank_entry_t)];
+        *p_entry = (melody_bank_entry_t){.name_offset = names_offset + m * BENCH_NAME_SIZE, .notes_offset = notes_offset + m * 2U * BENCH_MELODY_LENGTH, .melody_length = BENCH_MELODY_LENGTH, .tick_ms = 10};
+        sprintf((char *)&image[p_entry->name_offset], "song%lu", (unsigned long)m);
+        for (uint32_t i = 0; i < BENCH_MELODY_LENGTH; i++)
+        {
+            image[p_entry->notes_offset + i] = (uint8_t)(48U + (m + i) % 24U);
+            image[p_entry->notes_offset + BENCH_MELODY_LENGTH + i] = (uint8_t)(1U + i % 4U);
+            p_entry->duration_ms += (1U + i % 4U) * 10U;
+        }
+    }
+    FILE *p_file = fopen(BENCH_LIBRARY_PATH, "wb");
+    fwrite(image, 1, sizeof(image), p_file);
+    fclose(p_file);
+    setenv(NATIVE_STORAGE_ENV, BENCH_LIBRARY_PATH, 1);
+}
+
+/**
+ * @brief Get a pseudo-random number (LCG of Numerical Recipes).
+ */
+static uint32_t _random(void)
+{
+    seed = seed * 1664525U + 1013904223U;
+    return seed >> 8;
+}
+
+/**
+ * @brief Get the melody of a request: Zipf with exponent 1 (melody m is requested with a weight 1 / (m + 1)).
+ */
+static uint32_t _zipf(uint32_t request)
+{
+    (void)request;
+    static uint32_t cumulative[BENCH_NUM_MELODIES];
+    if (cumulative[BENCH_NUM_MELODIES - 1U] == 0)
+    {
+        uint32_t sum = 0;
+        for (uint32_t m = 0; m < BENCH_NUM_MELODIES; m++)
+        {
+            sum += 720720U / (m + 1U); // Integer weights: 720720 is divisible by 1 to 16
+            cumulative[m] = sum;
+        }
+    }
+    uint32_t value = _random() % cumulative[BENCH_NUM_MELODIES - 1U];
+    uint32_t m = 0;
+    while (value >= cumulative[m])
+    {
+        m++;
+    }
+    return m;
+}
+
+/**
+ * @brief Get the melody of a request: uniform.
+ */
+static uint32_t _uniform(uint32_t request)
+{
+    (void)request;
+    return _random() % BENCH_NUM_MELODIES;
+}
+
+/**
+ * @brief Get the melody of a request: the next melody of the library.
+ */
+static uint32_t _sequential(uint32_t request)
+{
+    return request % BENCH_NUM_MELODIES;
+}
+
+/**
+ * @brief Replay the requests of a distribution, without and with the cache.
+ *
+ * @param p_label Name of the distribution
+ * @param request Function to get the melody of a request
+ */
+static void _bench(const char *p_label, uint32_t (*request)(uint32_t))
+{
+    uint64_t uncached = 0;
+    uint64_t cached = 0;
+    seed = 1;
+    for (uint32_t r = 0; r < BENCH_REQUESTS; r++)
+    {
+        uint32_t index = request(r);
+        uint32_t start = port_system_get_cycle_count();
+        melody_stream_open(&stream, index, &view);
+        melody_decode(&view, midi_notes, ticks);
+        uncached += port_system_get_cycle_count() - start;
+    }
+
+    seed = 1;
+    melody_cache_init(&cache, &view);
+    memset(&view, 0, sizeof(view));
+    uint32_t reads = port_storage_sim_get_reads();
+    for (uint32_t r = 0; r < BENCH_REQUESTS; r++)
+    {
+        uint32_t index = request(r);
+        uint32_t start = port_system_get_cycle_count();
+        // As the jukebox selects a melody streamed
+        if (!melody_cache_get(&cache, index, &view))
+        {
+            melody_stream_open(&stream, index, &view);
+            melody_cache_store(&cache, index, &view, &view);
+        }
+        cached += port_system_get_cycle_count() - start;
+    }
+    reads = port_storage_sim_get_reads() - reads;
+
+    printf("  %-10s: %4lu hits, %4lu misses, %4lu evictions, %5lu device reads\n", p_label, (unsigned long)cache.hits, (unsigned long)cache.misses, (unsigned long)cache.evictions, (unsigned long)reads);
+    printf("              uncached %lu cycles/request, cached %lu cycles/request", (unsigned long)(uncached / BENCH_REQUESTS), (unsigned long)(cached / BENCH_REQUESTS));
+    if (uncached > cached)
+    {
+        printf(", %lu%% of the decode time saved", (unsigned long)((uncached - cached) * 100U / uncached));
+    }
+    printf("\n");
+}
+
+int main(void)
+{
+    port_system_init();
+    port_system_cycle_counter_init();
+    _write_library();
+    if (!melody_stream_init(&stream, port_storage_read, port_storage_init()))
+    {
+        printf("The library cannot be read from %s\n", BENCH_LIBRARY_PATH);
+        return 1;
+    }
+
+    printf("Melody cache of %u slots, %lu requests to a library of %u melodies of %u notes\n", MELODY_CACHE_NUM_SLOTS, (unsigned long)BENCH_REQUESTS, BENCH_NUM_MELODIES, BENCH_MELODY_LENGTH);
+    _bench("Zipf", _zipf);
+    _bench("uniform", _uniform);
+    _bench("sequential", _sequential);
+
+    unsetenv(NATIVE_STORAGE_ENV);
+    remove(BENCH_LIBRARY_PATH);
+    return 0;
+}
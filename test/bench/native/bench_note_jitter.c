@@ -0,0 +1,162 @@
+/**
+ * @file bench_note_jitter.c
+ * @brief Benchmark of the note-start jitter of the jukebox under a flood of USART commands: notes advanced by
+ * fsm_buzzer from the main loop against notes advanced by the ISR of the duration timer (sequencer mode).
+ *
+ * The system runs as in main.c. A line of `info` commands is kept busy at USART_0_BAUDRATE while the jukebox plays
+ * its start-up melody and tetris. The virtual clock does not account the time spent running code, so every command
+ * parsed by the jukebox is charged BENCH_PARSE_CYCLES (estimate of do_read_command() on the Cortex-M4: strtok(),
+ * string compares, sprintf() and the soft-float atof()). The jitter of a note is the time between the update event
+ * that ends the previous note and its start, as measured by the buzzer port.
+ *
+ * @author Javier de Ponte Hernando
+ * @author Roberto Maldonado Macafee
+ * @date 18/10/2026
+ */
+
+/* Includes ------------------------------------------------------------------*/
+/* Standard C libraries */
+#include <stdio.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+/* HW dependent libraries */
+#include "port_system.h"
+#include "port_button.h"
+#include "port_usart.h"
+#include "port_buzzer.h"
+
+/* Other libraries */
+#include "fsm_button.h"
+#include "fsm_usart.h"
+#include "fsm_buzzer.h"
+#include "fsm_jukebox.h"
+
+/* Private defines ------------------------------------------------------------*/
+#define BENCH_PARSE_CYCLES 20000U /*!< Virtual cycles charged for every command parsed by the jukebox */
+#define BENCH_FLOOD_COMMAND "info\n" /*!< Command of the flood */
+#define BENCH_ON_OFF_PRESS_TIME_MS 1000 /*!< Same as main.c */
+#define BENCH_NEXT_SONG_BUTTON_TIME_MS 500 /*!< Same as main.c */
+
+/* Global variables */
+static bool flooding = false; /*!< The flood of commands is running */
+
+/**
+ * @brief Keep the USART line busy with commands. Reschedules itself every command time.
+ *
+ * @param arg Not used
+ */
+static void _flood(uint32_t arg)
+{
+    if (!flooding)
+    {
+        return;
+    }
+    uint32_t length = strlen(BENCH_FLOOD_COMMAND);
+    port_usart_sim_receive(USART_0_ID, BENCH_FLOOD_COMMAND, length);
+    uint64_t command_cycles = (uint64_t)length * 10U * SystemCoreClock / USART_0_BAUDRATE;
+    port_system_sim_schedule(port_system_sim_get_cycles() + command_cycles, _flood, 0);
+}
+
+/**
+ * @brief Run the jukebox with the flood and return the jitter of the notes.
+ *
+ * @param sequencer Mode of the buzzer player
+ * @param p_stats Pointer to store the statistics of the note-start jitter
+ * @return uint32_t Number of commands parsed
+ */
+static uint32_t _bench(bool sequencer, port_buzzer_gap_stats_t *p_stats)
+{
+    port_system_init();
+    fsm_t *p_fsm_button = fsm_button_new(BUTTON_0_DEBOUNCE_TIME_MS, BUTTON_0_ID);
+    fsm_t *p_fsm_usart = fsm_usart_new(USART_0_ID);
+    fsm_t *p_fsm_buzzer = fsm_buzzer_new(BUZZER_0_ID);
+    fsm_t *p_fsm_jukebox = fsm_jukebox_new(p_fsm_button, BENCH_ON_OFF_PRESS_TIME_MS, p_fsm_usart, p_fsm_buzzer, BENCH_NEXT_SONG_BUTTON_TIME_MS);
+    fsm_buzzer_set_sequencer(p_fsm_buzzer, sequencer);
+    port_buzzer_reset_gap_stats(BUZZER_0_ID);
+
+    // Turn the jukebox on: it plays the start-up melody
+    port_button_sim_press(BUTTON_0_ID, BENCH_ON_OFF_PRESS_TIME_MS + 200);
+    flooding = true;
+    _flood(0);
+
+    uint32_t commands = 0;
+    bool tetris_requested = false;
+    while (true)
+    {
+        fsm_fire(p_fsm_button);
+        fsm_fire(p_fsm_usart);
+        fsm_fire(p_fsm_buzzer);
+        bool command = fsm_usart_check_data_received(p_fsm_usart);
+        fsm_fire(p_fsm_jukebox);
+        if (command && !fsm_usart_check_data_received(p_fsm_usart))
+        {
+            commands++;
+            port_system_sim_advance(BENCH_PARSE_CYCLES);
+        }
+
+        if (!tetris_requested && (p_fsm_jukebox->current_state == WAIT_COMMAND))
+        {
+            // After the start-up melody, play tetris with the command of the button
+            fsm_buzzer_set_melody(p_fsm_buzzer, &tetris_melody);
+            fsm_buzzer_set_action(p_fsm_buzzer, PLAY);
+            tetris_requested = true;
+        }
+        else if (tetris_requested && (fsm_buzzer_get_action(p_fsm_buzzer) == STOP))
+        {
+            break;
+        }
+    }
+    flooding = false;
+    port_buzzer_get_gap_stats(BUZZER_0_ID, p_stats);
+
+    fsm_destroy(p_fsm_button);
+    fsm_destroy(p_fsm_usart);
+    fsm_destroy(p_fsm_buzzer);
+    fsm_destroy(p_fsm_jukebox);
+    return commands;
+}
+
+/**
+ * @brief Print the statistics of the jitter.
+ *
+ * @param p_label Name of the mode
+ * @param p_stats Statistics
+ * @param commands Number of commands parsed
+ */
+static void _print(const char *p_label, const port_buzzer_gap_stats_t *p_stats, uint32_t commands)
+{
+    uint32_t cycles_per_us = SystemCoreClock / 1000000U;
+    uint32_t avg = (p_stats->count > 0) ? (uint32_t)(p_stats->total_cycles / p_stats->count) : 0;
+    printf("  %s %lu notes, %lu commands, avg %lu us, worst %lu us\n", p_label, (unsigned long)p_stats->count,
+           (unsigned long)commands, (unsigned long)(avg / cycles_per_us), (unsigned long)(p_stats->max_cycles / cycles_per_us));
+}
+
+/**
+ * @brief Main benchmark function.
+ *
+ * @return int
+ */
+int main(void)
+{
+    port_buzzer_gap_stats_t polled;
+    port_buzzer_gap_stats_t sequenced;
+
+    // The answers of the jukebox to the flood go to stdout: discard them while it runs
+    fflush(stdout);
+    int stdout_fd = dup(STDOUT_FILENO);
+    int null_fd = open("/dev/null", O_WRONLY);
+    dup2(null_fd, STDOUT_FILENO);
+    uint32_t polled_commands = _bench(false, &polled);
+    uint32_t sequenced_commands = _bench(true, &sequenced);
+    fflush(stdout);
+    dup2(stdout_fd, STDOUT_FILENO);
+    close(null_fd);
+    close(stdout_fd);
+
+    printf("Note-start jitter under a flood of \"info\" commands (%u cycles per command)\n", BENCH_PARSE_CYCLES);
+    _print("main loop (fsm_buzzer):", &polled, polled_commands);
+    _print("sequencer (TIM2 ISR):  ", &sequenced, sequenced_commands);
+    return 0;
+}
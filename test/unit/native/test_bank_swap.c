@@ -0,0 +1,125 @@
+#include <unity.h>
+#include <stdlib.h>
+#include <string.h>
+#include "port_system.h"
+#include "port_buzzer.h"
+#include "port_melody_bank.h"
+#include "fsm_buzzer.h"
+#include "fsm_jukebox.h"
+#include "melody_bank.h"
+
+#define MELODY_INDEX 1 /*!< Index of the melody of the bank played by the tests */
+
+fsm_t *p_fsm_buzzer;  /*!< Buzzer FSM used by the tests */
+fsm_t *p_fsm_jukebox; /*!< Jukebox FSM under test. It only uses the buzzer to swap banks */
+
+void setUp(void)
+{
+    p_fsm_buzzer = fsm_buzzer_new(BUZZER_0_ID);
+    p_fsm_jukebox = fsm_jukebox_new(NULL, 0, NULL, p_fsm_buzzer, 0);
+}
+
+void tearDown(void)
+{
+    unsetenv(NATIVE_MELODY_BANK_UPDATE_ENV);
+    port_buzzer_stop(BUZZER_0_ID);
+    fsm_destroy(p_fsm_jukebox);
+    fsm_destroy(p_fsm_buzzer);
+}
+
+/**
+ * @brief Select a melody of the active bank and play it, as the `next` command does.
+ */
+static void _play(uint32_t index)
+{
+    fsm_jukebox_t *p_fsm = (fsm_jukebox_t *)p_fsm_jukebox;
+    p_fsm->melody_idx = (uint16_t)index;
+    melody_bank_get_melody(p_fsm->p_bank, index, &(p_fsm->melody));
+    p_fsm->p_melody = p_fsm->melody.p_name;
+    fsm_buzzer_set_melody(p_fsm_buzzer, &(p_fsm->melody));
+    fsm_buzzer_set_action(p_fsm_buzzer, PLAY);
+    fsm_fire(p_fsm_buzzer);
+}
+
+/**
+ * @brief Check if a pointer points into the image of a melody bank.
+ */
+static bool _in_bank(const melody_bank_t *p_bank, const void *p_data)
+{
+    return ((const uint8_t *)p_data >= (const uint8_t *)p_bank) && ((const uint8_t *)p_data < (const uint8_t *)p_bank + p_bank->size);
+}
+
+void test_bank_swap_playing(void)
+{
+    fsm_jukebox_t *p_fsm = (fsm_jukebox_t *)p_fsm_jukebox;
+    const melody_bank_t *p_first_bank = p_fsm->p_bank;
+    UNITY_TEST_ASSERT_TRUE(p_first_bank != NULL, __LINE__, "ERROR: The jukebox must open the melody bank");
+    _play(MELODY_INDEX);
+    const uint8_t *p_notes = p_fsm->melody.p_midi_notes;
+    uint8_t first_note = p_notes[0];
+
+    // Swap while the melody plays: the lookups use the new bank, the melody keeps its notes in the old one
+    UNITY_TEST_ASSERT_EQUAL_INT(melody_bank_get_length(p_first_bank), fsm_jukebox_swap_bank(p_fsm_jukebox), __LINE__, "ERROR: The bank must be swapped while a melody is playing");
+    UNITY_TEST_ASSERT_TRUE(p_fsm->p_bank == p_fsm->bank_slots[0], __LINE__, "ERROR: The active bank must be the bank of the slot loaded");
+    UNITY_TEST_ASSERT_TRUE(p_fsm->p_bank != p_first_bank, __LINE__, "ERROR: The new bank must be read in place from its slot");
+    UNITY_TEST_ASSERT_TRUE(p_fsm->melody.p_midi_notes == p_notes, __LINE__, "ERROR: The melody playing must keep reading its notes from the old bank");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(first_note, p_fsm->melody.p_midi_notes[0], __LINE__, "ERROR: The notes of the melody playing must stay valid");
+    UNITY_TEST_ASSERT_EQUAL_INT(PLAY, fsm_buzzer_get_action(p_fsm_buzzer), __LINE__, "ERROR: The melody playing must not be stopped by a swap");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(MELODY_INDEX, p_fsm->melody_idx, __LINE__, "ERROR: The melody selected must keep its index in the new bank");
+
+    // Play from the bank of slot 0 and swap to slot 1: slot 0 is busy until the melody ends
+    fsm_buzzer_set_action(p_fsm_buzzer, STOP);
+    fsm_fire(p_fsm_buzzer);
+    _play(MELODY_INDEX);
+    UNITY_TEST_ASSERT_TRUE(_in_bank(p_fsm->bank_slots[0], p_fsm->melody.p_midi_notes), __LINE__, "ERROR: The melody must be read from the active bank");
+    UNITY_TEST_ASSERT_TRUE(fsm_jukebox_swap_bank(p_fsm_jukebox) > 0, __LINE__, "ERROR: The bank must be swapped to the other slot");
+    UNITY_TEST_ASSERT_TRUE(p_fsm->p_bank == p_fsm->bank_slots[1], __LINE__, "ERROR: The active bank must be the bank of slot 1");
+    UNITY_TEST_ASSERT_EQUAL_INT(-1, fsm_jukebox_get_free_bank_slot(p_fsm_jukebox), __LINE__, "ERROR: The slot of the melody playing must not be free");
+    UNITY_TEST_ASSERT_EQUAL_INT(-1, fsm_jukebox_swap_bank(p_fsm_jukebox), __LINE__, "ERROR: The bank must not be swapped while both slots are in use");
+    UNITY_TEST_ASSERT_TRUE(_in_bank(p_fsm->bank_slots[0], p_fsm->melody.p_midi_notes), __LINE__, "ERROR: The melody playing must not be moved");
+
+    // Once the melody ends, the melody selected is read from the active bank and the old slot is free
+    fsm_buzzer_set_action(p_fsm_buzzer, STOP);
+    fsm_fire(p_fsm_buzzer);
+    UNITY_TEST_ASSERT_EQUAL_INT(0, fsm_jukebox_get_free_bank_slot(p_fsm_jukebox), __LINE__, "ERROR: The old slot must be free once the melody ends");
+    UNITY_TEST_ASSERT_TRUE(_in_bank(p_fsm->p_bank, p_fsm->melody.p_midi_notes), __LINE__, "ERROR: The melody selected must be read from the active bank");
+    UNITY_TEST_ASSERT_TRUE(_in_bank(p_fsm->p_bank, p_fsm->p_melody), __LINE__, "ERROR: The name of the melody selected must be read from the active bank");
+    UNITY_TEST_ASSERT_EQUAL_STRING(melody_bank_get_name(p_first_bank, MELODY_INDEX), p_fsm->p_melody, __LINE__, "ERROR: The melody selected must not change");
+}
+
+void test_bank_swap_invalid(void)
+{
+    fsm_jukebox_t *p_fsm = (fsm_jukebox_t *)p_fsm_jukebox;
+    const melody_bank_t *p_bank = p_fsm->p_bank;
+    setenv(NATIVE_MELODY_BANK_UPDATE_ENV, "/nonexistent/jukebox_bank.bin", 1);
+    UNITY_TEST_ASSERT_EQUAL_INT(-2, fsm_jukebox_swap_bank(p_fsm_jukebox), __LINE__, "ERROR: An erased slot must not be swapped in");
+    UNITY_TEST_ASSERT_TRUE(p_fsm->p_bank == p_bank, __LINE__, "ERROR: The active bank must be kept when the new bank is not valid");
+    UNITY_TEST_ASSERT_TRUE(p_fsm->bank_slots[0] == NULL, __LINE__, "ERROR: A slot with no valid bank must be empty");
+    UNITY_TEST_ASSERT_EQUAL_INT(0, fsm_jukebox_get_free_bank_slot(p_fsm_jukebox), __LINE__, "ERROR: An empty slot must be free");
+}
+
+void test_bank_swap_uploaded(void)
+{
+    fsm_jukebox_t *p_fsm = (fsm_jukebox_t *)p_fsm_jukebox;
+    uint32_t bank_length = melody_bank_get_length(p_fsm->p_bank);
+    UNITY_TEST_ASSERT_TRUE(melody_pool_begin(&(p_fsm->pool), "uploaded"), __LINE__, "ERROR: A melody must be uploaded");
+    melody_pool_append(&(p_fsm->pool), 60, 4);
+    UNITY_TEST_ASSERT_EQUAL_INT(0, melody_pool_commit(&(p_fsm->pool), 10), __LINE__, "ERROR: A melody must be uploaded");
+    melody_pool_get_melody(&(p_fsm->pool), 0, &(p_fsm->melody));
+    p_fsm->p_melody = p_fsm->melody.p_name;
+    p_fsm->melody_idx = (uint16_t)bank_length;
+
+    UNITY_TEST_ASSERT_TRUE(fsm_jukebox_swap_bank(p_fsm_jukebox) >= 0, __LINE__, "ERROR: The bank must be swapped");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(melody_bank_get_length(p_fsm->p_bank), p_fsm->melody_idx, __LINE__, "ERROR: An uploaded melody must follow the melodies of the new bank");
+    UNITY_TEST_ASSERT_EQUAL_STRING("uploaded", p_fsm->p_melody, __LINE__, "ERROR: An uploaded melody must stay selected");
+}
+
+int main(void)
+{
+    port_system_init();
+    UNITY_BEGIN();
+    RUN_TEST(test_bank_swap_playing);
+    RUN_TEST(test_bank_swap_invalid);
+    RUN_TEST(test_bank_swap_uploaded);
+    return UNITY_END();
+}
@@ -0,0 +1,292 @@
+#include <unity.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include "port_system.h"
+#include "port_buzzer.h"
+#include "port_storage.h"
+#include "fsm_buzzer.h"
+#include "melody_bank.h"
+#include "melody_stream.h"
+#include "melody_bank_data.h"
+
+#define LONG_MELODY_LENGTH 600U                          /*!< Notes of the melody of the long library: several times the ring */
+#define LONG_MELODY_TICK_MS 10U                          /*!< Duration of a tick of the melody of the long library */
+#define LONG_LIBRARY_NAMES_SIZE 8U                       /*!< Bytes of the name index and of the name of the melody of the long library */
+#define LONG_LIBRARY_PATH "test_melody_stream_library.bin" /*!< File of the long library, in the working directory of the test */
+#define STORAGE_READ_MS 2U                               /*!< Time a read of the slow device takes */
+
+static melody_stream_t stream;       /*!< Stream under test */
+static const melody_bank_t *p_bank; /*!< Bank linked in the executable: the storage file holds the same image */
+static uint32_t isr_reads;           /*!< Reads of the slow device from an ISR */
+static melody_codec_t codec;         /*!< Codec of the packed melodies of the bank */
+
+void setUp(void)
+{
+    setenv(NATIVE_STORAGE_ENV, MELODY_BANK_DATA_PATH, 1);
+    p_bank = melody_bank_open(melody_bank_data, MELODY_BANK_DATA_SIZE);
+    melody_stream_init(&stream, port_storage_read, port_storage_init());
+}
+
+void tearDown(void)
+{
+    unsetenv(NATIVE_STORAGE_ENV);
+    port_storage_init();
+    remove(LONG_LIBRARY_PATH);
+}
+
+/**
+ * @brief Write a library with one melody longer than the ring to a file, and use it as the storage device.
+ * The notes go up the chromatic scale and their durations are 1 to 4 ticks.
+ */
+static void _use_long_library(void)
+{
+    static uint8_t image[sizeof(melody_bank_t) + sizeof(melody_bank_entry_t) + LONG_LIBRARY_NAMES_SIZE + 2U * LONG_MELODY_LENGTH];
+    melody_bank_t *p_header = (melody_bank_t *)image;
+    melody_bank_entry_t *p_entry = (melody_bank_entry_t *)&image[sizeof(melody_bank_t)];
+    uint32_t index_offset = sizeof(melody_bank_t) + sizeof(melody_bank_entry_t);
+    memset(image, 0, sizeof(image));
+    *p_header = (melody_bank_t){.magic = MELODY_BANK_MAGIC, .version = MELODY_BANK_VERSION, .num_melodies = 1, .size = sizeof(image), .index_offset = index_offset};
+    *p_entry = (melody_bank_entry_t){.name_offset = index_offset + 2U, .notes_offset = sizeof(image) - 2U * LONG_MELODY_LENGTH, .melody_length = LONG_MELODY_LENGTH, .tick_ms = LONG_MELODY_TICK_MS};
+    strcpy((char *)&image[p_entry->name_offset], "long");
+    for (uint32_t i = 0; i < LONG_MELODY_LENGTH; i++)
+    {
+        image[p_entry->notes_offset + i] = (uint8_t)(60U + i % 12U);
+        image[p_entry->notes_offset + LONG_MELODY_LENGTH + i] = (uint8_t)(1U + i % 4U);
+        p_entry->duration_ms += (1U + i % 4U) * LONG_MELODY_TICK_MS;
+    }
+    FILE *p_file = fopen(LONG_LIBRARY_PATH, "wb");
+    fwrite(image, 1, sizeof(image), p_file);
+    fclose(p_file);
+    setenv(NATIVE_STORAGE_ENV, LONG_LIBRARY_PATH, 1);
+    melody_stream_init(&stream, port_storage_read, port_storage_init());
+}
+
+/**
+ * @brief Read the storage device slowly, as an SPI flash does: the ISRs due meanwhile run in the middle of the read.
+ * The reads from an ISR are counted.
+ */
+static bool _slow_read(uint32_t address, void *p_data, uint32_t size)
+{
+    if (port_system_sim_in_isr())
+    {
+        isr_reads++;
+    }
+    bool read = port_storage_read(address, p_data, size);
+    port_system_sim_advance((uint64_t)SystemCoreClock / 1000U * STORAGE_READ_MS);
+    return read;
+}
+
+/**
+ * @brief Get the duration of a note of the long melody.
+ */
+static uint32_t _long_duration_ms(uint32_t note)
+{
+    return (1U + note % 4U) * LONG_MELODY_TICK_MS;
+}
+
+void test_stream_library(void)
+{
+    UNITY_TEST_ASSERT_EQUAL_UINT32(melody_bank_get_length(p_bank), melody_stream_get_length(&stream), __LINE__, "ERROR: The stream must read the library of the storage device");
+    for (uint32_t i = 0; i < melody_bank_get_length(p_bank); i++)
+    {
+        melody_t expected;
+        melody_t streamed;
+        if (!melody_bank_get_melody(p_bank, i, &expected))
+        {
+            melody_bank_get_packed(p_bank, i, &codec, &expected);
+        }
+        UNITY_TEST_ASSERT_TRUE(melody_stream_open(&stream, i, &streamed), __LINE__, "ERROR: A melody of the library must be open");
+        if (melody_bank_is_packed(p_bank, i))
+        {
+            UNITY_TEST_ASSERT_TRUE((streamed.p_codec == &stream.codec) && (streamed.p_stream == NULL), __LINE__, "ERROR: A packed melody streamed must be decoded by the codec of the stream");
+            UNITY_TEST_ASSERT_EQUAL_UINT32(1, stream.reads, __LINE__, "ERROR: The tokens of a packed melody must be read at once");
+            UNITY_TEST_ASSERT_EQUAL_MEMORY(codec.p_data, stream.tokens, codec.size, __LINE__, "ERROR: A packed melody streamed must have its tokens");
+        }
+        UNITY_TEST_ASSERT_EQUAL_STRING(expected.p_name, streamed.p_name, __LINE__, "ERROR: A melody streamed must have its name");
+        UNITY_TEST_ASSERT_EQUAL_UINT32(expected.melody_length, streamed.melody_length, __LINE__, "ERROR: A melody streamed must have its length");
+        UNITY_TEST_ASSERT_TRUE(melody_is_compact(&streamed), __LINE__, "ERROR: A melody streamed must be compact");
+        for (uint32_t note = 0; note < expected.melody_length; note++)
+        {
+            UNITY_TEST_ASSERT_EQUAL_UINT32(melody_get_note_q16(&expected, note), melody_get_note_q16(&streamed, note), __LINE__, "ERROR: A melody streamed must have its notes");
+            UNITY_TEST_ASSERT_EQUAL_UINT32(melody_get_duration_ms(&expected, note), melody_get_duration_ms(&streamed, note), __LINE__, "ERROR: A melody streamed must have its durations");
+        }
+    }
+    UNITY_TEST_ASSERT_FALSE(melody_stream_open(&stream, melody_bank_get_length(p_bank), &(melody_t){0}), __LINE__, "ERROR: A melody out of the library must not be open");
+}
+
+void test_stream_find(void)
+{
+    // By the perfect hash of the library
+    for (uint32_t i = 0; i < melody_bank_get_length(p_bank); i++)
+    {
+        UNITY_TEST_ASSERT_EQUAL_INT(i, melody_stream_find(&stream, melody_bank_get_name(p_bank, i)), __LINE__, "ERROR: Every melody of the library must be found by its name");
+    }
+    UNITY_TEST_ASSERT_EQUAL_INT(-1, melody_stream_find(&stream, "tetri"), __LINE__, "ERROR: A missing name must not be found");
+
+    // One by one in a library with no perfect hash
+    _use_long_library();
+    UNITY_TEST_ASSERT_EQUAL_INT(0, melody_stream_find(&stream, "long"), __LINE__, "ERROR: A melody must be found in a library with no perfect hash");
+    UNITY_TEST_ASSERT_EQUAL_INT(-1, melody_stream_find(&stream, "lon"), __LINE__, "ERROR: A missing name must not be found in a library with no perfect hash");
+}
+
+void test_stream_read_ahead(void)
+{
+    melody_t melody;
+    _use_long_library();
+    UNITY_TEST_ASSERT_TRUE(melody_stream_open(&stream, 0, &melody), __LINE__, "ERROR: The melody of the long library must be open");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(MELODY_STREAM_RING_NOTES - MELODY_STREAM_HISTORY_NOTES, stream.tail, __LINE__, "ERROR: The ring must be filled when the melody is open");
+
+    // Refilled between notes, as the main loop does: every note is read ahead
+    uint32_t reads = port_storage_sim_get_reads();
+    for (uint32_t note = 0; note < melody.melody_length; note++)
+    {
+        melody_get_duration_ms(&melody, note);
+        UNITY_TEST_ASSERT_TRUE(stream.tail - stream.first <= MELODY_STREAM_RING_NOTES, __LINE__, "ERROR: Only the notes of the ring must be resident");
+        melody_stream_refill(&stream);
+    }
+    UNITY_TEST_ASSERT_EQUAL_UINT32(0, stream.underruns, __LINE__, "ERROR: Notes read ahead must not underrun");
+    UNITY_TEST_ASSERT_TRUE(port_storage_sim_get_reads() > reads, __LINE__, "ERROR: The notes must be read from the device while they are played");
+
+    // Not refilled: the notes are fetched when they are played, late, and every block read on demand is an underrun
+    melody_stream_rewind(&stream);
+    for (uint32_t note = 0; note < melody.melody_length; note++)
+    {
+        melody_stream_fetch(&stream, note);
+        UNITY_TEST_ASSERT_EQUAL_UINT32(_long_duration_ms(note), melody_get_duration_ms(&melody, note), __LINE__, "ERROR: A note not read ahead must be read when it is played");
+    }
+    uint32_t expected_underruns = (melody.melody_length - (MELODY_STREAM_RING_NOTES - MELODY_STREAM_HISTORY_NOTES) + MELODY_STREAM_BLOCK_NOTES - 1U) / MELODY_STREAM_BLOCK_NOTES;
+    UNITY_TEST_ASSERT_EQUAL_UINT32(expected_underruns, stream.underruns, __LINE__, "ERROR: The notes not read ahead must be counted as underruns");
+
+    // A note not in the ring is never read from the device by the player
+    uint32_t underruns = stream.underruns;
+    reads = port_storage_sim_get_reads();
+    UNITY_TEST_ASSERT_EQUAL_UINT32(0, melody_get_duration_ms(&melody, 0), __LINE__, "ERROR: A note not in the ring must not be read by the player");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(reads, port_storage_sim_get_reads(), __LINE__, "ERROR: The player must not read the device");
+
+    // A jump back is not an underrun
+    UNITY_TEST_ASSERT_TRUE(melody_stream_fetch(&stream, 0), __LINE__, "ERROR: A note before the ring must be fetched again");
+    UNITY_TEST_ASSERT_TRUE(melody_get_duration_ms(&melody, 0) > 0, __LINE__, "ERROR: A note before the ring must be read again");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(underruns, stream.underruns, __LINE__, "ERROR: A jump must not be counted as an underrun");
+}
+
+void test_stream_plays(void)
+{
+    melody_t melody;
+    _use_long_library();
+    melody_stream_open(&stream, 0, &melody);
+    fsm_t *p_fsm_buzzer = fsm_buzzer_new(BUZZER_0_ID);
+    // Modes of the jukebox: a melody streamed is not played by DMA
+    fsm_buzzer_set_sequencer(p_fsm_buzzer, true);
+    fsm_buzzer_set_dma(p_fsm_buzzer, true);
+    fsm_buzzer_set_absolute_time(p_fsm_buzzer, true);
+    fsm_buzzer_set_melody(p_fsm_buzzer, &melody);
+    uint32_t elapsed_ms;
+    uint32_t total_ms;
+    fsm_buzzer_get_progress(p_fsm_buzzer, &elapsed_ms, &total_ms);
+    UNITY_TEST_ASSERT_EQUAL_UINT32(LONG_MELODY_LENGTH * 25U, total_ms, __LINE__, "ERROR: The duration of a melody streamed must be known before it plays");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(0, stream.underruns, __LINE__, "ERROR: Reading the durations of the melody must not count underruns");
+
+    fsm_buzzer_set_action(p_fsm_buzzer, PLAY);
+    uint32_t start = port_system_get_millis();
+    while ((fsm_buzzer_get_action(p_fsm_buzzer) == PLAY) && (port_system_get_millis() - start < 2U * total_ms))
+    {
+        fsm_fire(p_fsm_buzzer);
+        fsm_buzzer_refill(p_fsm_buzzer);
+    }
+    UNITY_TEST_ASSERT_EQUAL_INT(STOP, fsm_buzzer_get_action(p_fsm_buzzer), __LINE__, "ERROR: A melody streamed must play to its end");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(0, stream.underruns, __LINE__, "ERROR: A melody streamed and refilled from the main loop must not underrun");
+    port_buzzer_stop(BUZZER_0_ID);
+    fsm_destroy(p_fsm_buzzer);
+}
+
+void test_stream_timeline(void)
+{
+    for (uint32_t i = 0; i < melody_bank_get_length(p_bank); i++)
+    {
+        melody_t melody;
+        melody_stream_open(&stream, i, &melody);
+        if (melody.p_stream == NULL)
+        {
+            // A packed melody is decoded from RAM: its timeline is walked with no read of the device
+            continue;
+        }
+        fsm_t *p_fsm_buzzer = fsm_buzzer_new(BUZZER_0_ID);
+        stream.underruns = 1;
+        uint32_t reads = stream.reads;
+        uint32_t storage_reads = port_storage_sim_get_reads();
+        fsm_buzzer_set_melody(p_fsm_buzzer, &melody);
+        uint32_t elapsed_ms;
+        uint32_t total_ms;
+        fsm_buzzer_get_progress(p_fsm_buzzer, &elapsed_ms, &total_ms);
+        UNITY_TEST_ASSERT_EQUAL_UINT32(melody_bank_get_duration_ms(p_bank, i), total_ms, __LINE__, "ERROR: The duration of a melody streamed must be read from its start times");
+        UNITY_TEST_ASSERT_EQUAL_UINT32(1, port_storage_sim_get_reads() - storage_reads, __LINE__, "ERROR: Setting a melody streamed must only read its start times");
+        UNITY_TEST_ASSERT_EQUAL_UINT32(reads + 1U, stream.reads, __LINE__, "ERROR: The read of the start times must be counted");
+        UNITY_TEST_ASSERT_EQUAL_UINT32(1, stream.underruns, __LINE__, "ERROR: Setting a melody must not clear the counters of its stream");
+        fsm_destroy(p_fsm_buzzer);
+    }
+}
+
+void test_stream_refill_during_isr(void)
+{
+    melody_t melody;
+    _use_long_library();
+    melody_stream_init(&stream, _slow_read, port_storage_init());
+    melody_stream_open(&stream, 0, &melody);
+    fsm_t *p_fsm_buzzer = fsm_buzzer_new(BUZZER_0_ID);
+    fsm_buzzer_set_sequencer(p_fsm_buzzer, true);
+    fsm_buzzer_set_absolute_time(p_fsm_buzzer, true);
+    fsm_buzzer_set_melody(p_fsm_buzzer, &melody);
+    uint32_t total_ms = LONG_MELODY_LENGTH * 25U;
+
+    // Refilled from the main loop: the ISR of the player stages the notes while the device is read
+    isr_reads = 0;
+    fsm_buzzer_set_action(p_fsm_buzzer, PLAY);
+    uint32_t start = port_system_get_millis();
+    while ((fsm_buzzer_get_action(p_fsm_buzzer) == PLAY) && (port_system_get_millis() - start < 2U * total_ms))
+    {
+        fsm_fire(p_fsm_buzzer);
+        fsm_buzzer_refill(p_fsm_buzzer);
+    }
+    UNITY_TEST_ASSERT_EQUAL_INT(STOP, fsm_buzzer_get_action(p_fsm_buzzer), __LINE__, "ERROR: A melody streamed from a slow device must play to its end");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(0, isr_reads, __LINE__, "ERROR: The ISR of the player must not read the device");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(0, stream.underruns, __LINE__, "ERROR: A melody refilled while it plays must not underrun");
+    UNITY_TEST_ASSERT(abs(fsm_buzzer_get_drift_us(p_fsm_buzzer)) <= 1000, __LINE__, "ERROR: The notes staged by the ISR during a refill must keep their timing");
+
+    // Not refilled: the ISR leaves the notes not read ahead to the main loop, which fetches them late
+    melody_stream_rewind(&stream);
+    fsm_buzzer_set_action(p_fsm_buzzer, PLAY);
+    start = port_system_get_millis();
+    while ((fsm_buzzer_get_action(p_fsm_buzzer) == PLAY) && (port_system_get_millis() - start < 2U * total_ms))
+    {
+        fsm_fire(p_fsm_buzzer);
+    }
+    UNITY_TEST_ASSERT_EQUAL_INT(STOP, fsm_buzzer_get_action(p_fsm_buzzer), __LINE__, "ERROR: A melody streamed with no refill must play to its end");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(0, isr_reads, __LINE__, "ERROR: The ISR of the player must not read the device on an underrun");
+    UNITY_TEST_ASSERT_TRUE(stream.underruns > 0, __LINE__, "ERROR: The notes not read ahead must be counted as underruns");
+    port_buzzer_stop(BUZZER_0_ID);
+    fsm_buzzer_set_sequencer(p_fsm_buzzer, false);
+    fsm_destroy(p_fsm_buzzer);
+}
+
+void test_stream_no_device(void)
+{
+    unsetenv(NATIVE_STORAGE_ENV);
+    UNITY_TEST_ASSERT_FALSE(melody_stream_init(&stream, port_storage_read, port_storage_init()), __LINE__, "ERROR: There must be no library without a device");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(0, melody_stream_get_length(&stream), __LINE__, "ERROR: The library of a missing device must be empty");
+    UNITY_TEST_ASSERT_FALSE(melody_stream_open(&stream, 0, &(melody_t){0}), __LINE__, "ERROR: No melody must be open without a device");
+}
+
+int main(void)
+{
+    port_system_init();
+    UNITY_BEGIN();
+    RUN_TEST(test_stream_library);
+    RUN_TEST(test_stream_find);
+    RUN_TEST(test_stream_read_ahead);
+    RUN_TEST(test_stream_plays);
+    RUN_TEST(test_stream_timeline);
+    RUN_TEST(test_stream_refill_during_isr);
+    RUN_TEST(test_stream_no_device);
+    return UNITY_END();
+}
@@ -0,0 +1,344 @@
+#include <unity.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "port_system.h"
+#include "port_buzzer.h"
+#include "port_melody_bank.h"
+#include "port_usart.h"
+#include "port_button.h"
+#include "fsm_button.h"
+#include "fsm_usart.h"
+#include "fsm_buzzer.h"
+#include "fsm_jukebox.h"
+#include "melody_bank.h"
+#include "command_line.h"
+
+#define QUEUE_MAX_GAP_CYCLES 1000 /*!< Maximum gap between two melodies of the queue: latency of the ISR of the duration timer */
+#define QUEUE_BANK_PATH "test_play_queue_bank.bin" /*!< Bank file programmed into a slot by the tests: the bank built without its first melody */
+
+fsm_t *p_fsm_button;  /*!< Button FSM used by the tests. It is never pressed */
+fsm_t *p_fsm_usart;   /*!< USART FSM used by the tests: it keeps the replies of the commands */
+fsm_t *p_fsm_buzzer;  /*!< Buzzer FSM used by the tests */
+fsm_t *p_fsm_jukebox; /*!< Jukebox FSM under test */
+
+void setUp(void)
+{
+    p_fsm_button = fsm_button_new(100, BUTTON_0_ID);
+    p_fsm_usart = fsm_usart_new(USART_0_ID);
+    p_fsm_buzzer = fsm_buzzer_new(BUZZER_0_ID);
+    fsm_buzzer_set_sequencer(p_fsm_buzzer, true);
+    p_fsm_jukebox = fsm_jukebox_new(p_fsm_button, 3000, p_fsm_usart, p_fsm_buzzer, 1000);
+    fsm_set_state(p_fsm_jukebox, WAIT_COMMAND);
+    port_system_cycle_counter_init();
+}
+
+void tearDown(void)
+{
+    port_buzzer_stop(BUZZER_0_ID);
+    fsm_destroy(p_fsm_jukebox);
+    fsm_destroy(p_fsm_buzzer);
+    fsm_destroy(p_fsm_usart);
+    fsm_destroy(p_fsm_button);
+}
+
+/**
+ * @brief Run a command of the jukebox, as if it had been received by the USART.
+ *
+ * @return const char* Reply of the command, or an empty string if there is none
+ */
+static const char *_command(const char *p_format, ...)
+{
+    static char text[USART_INPUT_BUFFER_LENGTH + 1];
+    fsm_usart_t *p_usart = (fsm_usart_t *)p_fsm_usart;
+    command_line_t line;
+    va_list args;
+    va_start(args, p_format);
+    vsnprintf(text, sizeof(text), p_format, args);
+    va_end(args);
+    memset(p_usart->out_data, 0, sizeof(p_usart->out_data));
+    command_line_tokenize(&line, text);
+    command_table_dispatch(&(((fsm_jukebox_t *)p_fsm_jukebox)->commands), &line);
+    return p_usart->out_data;
+}
+
+/**
+ * @brief Get the name of a melody of the bank.
+ */
+static const char *_name(uint32_t index)
+{
+    return melody_bank_get_name(((fsm_jukebox_t *)p_fsm_jukebox)->p_bank, index);
+}
+
+/**
+ * @brief Event of the simulation that only wakes the jukebox up from its sleep.
+ */
+static void _wake_up(uint32_t arg)
+{
+}
+
+/**
+ * @brief Store a melody in the pool of the jukebox, as an upload does.
+ */
+static void _upload(const char *p_name, uint32_t notes)
+{
+    melody_pool_t *p_pool = &(((fsm_jukebox_t *)p_fsm_jukebox)->pool);
+    melody_pool_begin(p_pool, p_name);
+    for (uint32_t i = 0; i < notes; i++)
+    {
+        melody_pool_append(p_pool, 60, 4);
+    }
+    melody_pool_commit(p_pool, 10);
+}
+
+/**
+ * @brief Write the bank built without its first melody: the melodies of the bank after it, and the melodies that follow
+ * the bank in the library, move down by one. The perfect hash is dropped, so the names are found in the sorted index.
+ */
+static void _write_bank_without_first(void)
+{
+    uint32_t size;
+    const void *p_built = port_melody_bank_get(&size);
+    uint8_t *p_image = malloc(size);
+    memcpy(p_image, p_built, size);
+    melody_bank_t *p_bank = (melody_bank_t *)p_image;
+    melody_bank_entry_t *p_entries = (melody_bank_entry_t *)(p_bank + 1);
+    uint16_t *p_index = (uint16_t *)(p_image + p_bank->index_offset);
+    uint32_t num = p_bank->num_melodies;
+    memmove(&p_entries[0], &p_entries[1], (num - 1U) * sizeof(melody_bank_entry_t));
+    uint32_t count = 0;
+    for (uint32_t i = 0; i < num; i++)
+    {
+        if (p_index[i] != 0)
+        {
+            p_index[count++] = (uint16_t)(p_index[i] - 1U);
+        }
+    }
+    p_bank->num_melodies = (uint16_t)(num - 1U);
+    p_bank->hash_offset = 0;
+    p_bank->hash_buckets = 0;
+    FILE *p_file = fopen(QUEUE_BANK_PATH, "wb");
+    fwrite(p_image, 1, size, p_file);
+    fclose(p_file);
+    free(p_image);
+}
+
+/**
+ * @brief Fire the buzzer and the jukebox, as the main loop does, until the buzzer stops by itself or the jukebox selects a melody.
+ *
+ * @return true if the buzzer has stopped at some point
+ */
+static bool _run_until(uint32_t melody_idx)
+{
+    fsm_jukebox_t *p_fsm = (fsm_jukebox_t *)p_fsm_jukebox;
+    bool stopped = false;
+    while ((p_fsm->melody_idx != melody_idx) || (fsm_buzzer_get_melody(p_fsm_buzzer) != &(p_fsm->melody)))
+    {
+        fsm_fire(p_fsm_buzzer);
+        stopped |= (fsm_buzzer_get_action(p_fsm_buzzer) == STOP);
+        fsm_fire(p_fsm_jukebox);
+    }
+    return stopped;
+}
+
+void test_queue_commands(void)
+{
+    fsm_jukebox_t *p_fsm = (fsm_jukebox_t *)p_fsm_jukebox;
+    char expected[USART_OUTPUT_BUFFER_LENGTH];
+    UNITY_TEST_ASSERT_TRUE(melody_bank_get_length(p_fsm->p_bank) >= 2, __LINE__, "ERROR: The bank must have two melodies at least");
+    UNITY_TEST_ASSERT_EQUAL_STRING("Queue: empty\n", _command("list"), __LINE__, "ERROR: The queue must be empty at the start");
+
+    // By index and by name
+    sprintf(expected, "Queued: %s (1)\n", _name(0));
+    UNITY_TEST_ASSERT_EQUAL_STRING(expected, _command("queue 0"), __LINE__, "ERROR: A melody must be queued by its index");
+    sprintf(expected, "Queued: %s (2)\n", _name(1));
+    UNITY_TEST_ASSERT_EQUAL_STRING(expected, _command("queue %s", _name(1)), __LINE__, "ERROR: A melody must be queued by its name");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(1, p_fsm->play_queue[(p_fsm->queue_head + 1U) % JUKEBOX_QUEUE_LENGTH].index, __LINE__, "ERROR: A melody must be queued at the end");
+    sprintf(expected, "Queue: %s, %s\n", _name(0), _name(1));
+    UNITY_TEST_ASSERT_EQUAL_STRING(expected, _command("list"), __LINE__, "ERROR: The queue must be listed from its head");
+    UNITY_TEST_ASSERT_EQUAL_STRING("Error : Melody not found\n", _command("queue 60000"), __LINE__, "ERROR: A melody out of the library must not be queued");
+
+    // Dequeue from the head, then clear
+    sprintf(expected, "Dequeued: %s\n", _name(0));
+    UNITY_TEST_ASSERT_EQUAL_STRING(expected, _command("dequeue"), __LINE__, "ERROR: The head of the queue must be dequeued");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(1, p_fsm->queue_count, __LINE__, "ERROR: One melody must be left in the queue");
+    UNITY_TEST_ASSERT_EQUAL_STRING("", _command("clear"), __LINE__, "ERROR: clear must not reply");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(0, p_fsm->queue_count, __LINE__, "ERROR: The queue must be empty after clear");
+    UNITY_TEST_ASSERT_EQUAL_STRING("Error : Queue empty\n", _command("dequeue"), __LINE__, "ERROR: An empty queue must not be dequeued");
+}
+
+void test_queue_full(void)
+{
+    fsm_jukebox_t *p_fsm = (fsm_jukebox_t *)p_fsm_jukebox;
+    _command("stop");
+    for (uint32_t i = 0; i < JUKEBOX_QUEUE_LENGTH; i++)
+    {
+        _command("queue %lu", (unsigned long)(i % melody_bank_get_length(p_fsm->p_bank)));
+    }
+    UNITY_TEST_ASSERT_EQUAL_UINT32(JUKEBOX_QUEUE_LENGTH, p_fsm->queue_count, __LINE__, "ERROR: The queue must hold JUKEBOX_QUEUE_LENGTH melodies");
+    UNITY_TEST_ASSERT_EQUAL_STRING("Error : Queue full\n", _command("queue 0"), __LINE__, "ERROR: A melody must not be queued in a full queue");
+
+    // The list fits in a line
+    const char *p_list = _command("list");
+    size_t length = strlen(p_list);
+    UNITY_TEST_ASSERT_TRUE((length > 0) && (length < USART_OUTPUT_BUFFER_LENGTH), __LINE__, "ERROR: The list must fit in a line");
+    UNITY_TEST_ASSERT_EQUAL_INT('\n', p_list[length - 1U], __LINE__, "ERROR: The list must end with a new line");
+
+    // The ring buffer wraps around
+    _command("dequeue");
+    UNITY_TEST_ASSERT_TRUE(_command("queue 1")[0] != 'E', __LINE__, "ERROR: A melody must be queued after a dequeue of a full queue");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(1, p_fsm->play_queue[(p_fsm->queue_head + JUKEBOX_QUEUE_LENGTH - 1U) % JUKEBOX_QUEUE_LENGTH].index, __LINE__, "ERROR: The tail of the queue must wrap around");
+}
+
+void test_queue_starts_when_stopped(void)
+{
+    fsm_jukebox_t *p_fsm = (fsm_jukebox_t *)p_fsm_jukebox;
+    _command("queue 1");
+    fsm_fire(p_fsm_jukebox);
+    UNITY_TEST_ASSERT_EQUAL_INT(PLAY, fsm_buzzer_get_action(p_fsm_buzzer), __LINE__, "ERROR: A melody queued while the buzzer is stopped must be played");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(1, p_fsm->melody_idx, __LINE__, "ERROR: The melody queued must be selected");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(0, p_fsm->queue_count, __LINE__, "ERROR: The melody played must leave the queue");
+}
+
+void test_queue_gapless_advance(void)
+{
+    fsm_jukebox_t *p_fsm = (fsm_jukebox_t *)p_fsm_jukebox;
+    _command("select 0");
+    _command("queue 1");
+    UNITY_TEST_ASSERT_TRUE(((fsm_buzzer_t *)p_fsm_buzzer)->p_next_melody == &(p_fsm->next_melody), __LINE__, "ERROR: The head of the queue must be staged in the buzzer");
+    fsm_fire(p_fsm_buzzer);
+    port_buzzer_reset_gap_stats(BUZZER_0_ID);
+
+    // The next melody is played with no command and no stop
+    UNITY_TEST_ASSERT_FALSE(_run_until(1), __LINE__, "ERROR: The buzzer must not stop between the melodies of the queue");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(0, p_fsm->queue_count, __LINE__, "ERROR: The melody played must leave the queue");
+    UNITY_TEST_ASSERT_EQUAL_STRING(_name(1), p_fsm->p_melody, __LINE__, "ERROR: The melody of the queue must be the melody playing");
+    while (fsm_buzzer_get_action(p_fsm_buzzer) != STOP)
+    {
+        fsm_fire(p_fsm_buzzer);
+    }
+    port_buzzer_gap_stats_t stats;
+    port_buzzer_get_gap_stats(BUZZER_0_ID, &stats);
+    melody_t melody;
+    melody_bank_get_melody(p_fsm->p_bank, 0, &melody);
+    uint32_t notes = melody.melody_length;
+    melody_bank_get_melody(p_fsm->p_bank, 1, &melody);
+    notes += melody.melody_length;
+    UNITY_TEST_ASSERT_EQUAL_UINT32(notes - 1U, stats.count, __LINE__, "ERROR: Every note of both melodies must be played");
+    UNITY_TEST_ASSERT_TRUE(stats.max_cycles < QUEUE_MAX_GAP_CYCLES, __LINE__, "ERROR: The gap between the melodies of the queue is too long");
+}
+
+void test_queue_stop(void)
+{
+    fsm_jukebox_t *p_fsm = (fsm_jukebox_t *)p_fsm_jukebox;
+    _command("select 0");
+    _command("queue 1");
+    _command("stop");
+    UNITY_TEST_ASSERT_TRUE(((fsm_buzzer_t *)p_fsm_buzzer)->p_next_melody == NULL, __LINE__, "ERROR: A stop must drop the melody staged");
+    fsm_fire(p_fsm_buzzer);
+    for (uint32_t i = 0; i < 2; i++)
+    {
+        // The jukebox sleeps with nothing to do: wake it up to fire it again
+        port_system_sim_schedule(port_system_sim_get_cycles() + SystemCoreClock / 1000U, _wake_up, 0);
+        fsm_fire(p_fsm_jukebox);
+    }
+    UNITY_TEST_ASSERT_EQUAL_INT(STOP, fsm_buzzer_get_action(p_fsm_buzzer), __LINE__, "ERROR: The queue must not advance after a stop");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(1, p_fsm->queue_count, __LINE__, "ERROR: A stop must keep the queue");
+
+    // Playing again goes on with the queue
+    _command("play");
+    UNITY_TEST_ASSERT_TRUE(((fsm_buzzer_t *)p_fsm_buzzer)->p_next_melody == &(p_fsm->next_melody), __LINE__, "ERROR: The head of the queue must be staged again on play");
+}
+
+void test_queue_packed(void)
+{
+    fsm_jukebox_t *p_fsm = (fsm_jukebox_t *)p_fsm_jukebox;
+    const uint8_t *p_cache = (const uint8_t *)&(p_fsm->cache);
+    int32_t packed = melody_bank_find(p_fsm->p_bank, "ode_to_joy");
+    UNITY_TEST_ASSERT_TRUE(melody_bank_is_packed(p_fsm->p_bank, (uint32_t)packed), __LINE__, "ERROR: The melody assets must be packed");
+    _command("select 0");
+    _command("queue %ld", (long)packed);
+    UNITY_TEST_ASSERT_TRUE(((fsm_buzzer_t *)p_fsm_buzzer)->p_next_melody == NULL, __LINE__, "ERROR: A packed melody must not be staged in the buzzer");
+
+    // Played when the melody before ends, decoded into the cache
+    uint32_t misses = p_fsm->cache.misses;
+    UNITY_TEST_ASSERT_TRUE(_run_until((uint32_t)packed), __LINE__, "ERROR: The buzzer must stop before a packed melody");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(misses + 1U, p_fsm->cache.misses, __LINE__, "ERROR: A packed melody must be looked up in the cache");
+    UNITY_TEST_ASSERT_TRUE((p_fsm->melody.p_midi_notes >= p_cache) && (p_fsm->melody.p_midi_notes < p_cache + sizeof(p_fsm->cache)), __LINE__, "ERROR: A packed melody must be decoded into the cache");
+    UNITY_TEST_ASSERT_EQUAL_STRING("ode_to_joy", p_fsm->p_melody, __LINE__, "ERROR: The packed melody must be the melody playing");
+    UNITY_TEST_ASSERT_EQUAL_INT(PLAY, fsm_buzzer_get_action(p_fsm_buzzer), __LINE__, "ERROR: The packed melody must be played");
+
+    // Played again, it is read from the cache
+    uint32_t hits = p_fsm->cache.hits;
+    _command("select %ld", (long)packed);
+    UNITY_TEST_ASSERT_EQUAL_UINT32(hits + 1U, p_fsm->cache.hits, __LINE__, "ERROR: A packed melody played lately must be read from the cache");
+
+    // After a swap, it is decoded again from the new bank
+    _command("stop");
+    fsm_fire(p_fsm_buzzer);
+    UNITY_TEST_ASSERT_TRUE(fsm_jukebox_swap_bank(p_fsm_jukebox) > 0, __LINE__, "ERROR: The bank must be swapped");
+    misses = p_fsm->cache.misses;
+    _command("select %ld", (long)packed);
+    UNITY_TEST_ASSERT_EQUAL_UINT32(misses + 1U, p_fsm->cache.misses, __LINE__, "ERROR: A melody of the old bank must not be read from the cache");
+    UNITY_TEST_ASSERT_EQUAL_STRING("ode_to_joy", p_fsm->melody.p_name, __LINE__, "ERROR: The packed melody of the new bank must be selected");
+}
+
+void test_queue_stable_indexes(void)
+{
+    fsm_jukebox_t *p_fsm = (fsm_jukebox_t *)p_fsm_jukebox;
+    char expected[USART_OUTPUT_BUFFER_LENGTH];
+    char name[MELODY_STREAM_NAME_LENGTH];
+    uint32_t bank_length = melody_bank_get_length(p_fsm->p_bank);
+    UNITY_TEST_ASSERT_TRUE(bank_length >= 3, __LINE__, "ERROR: The bank must have three melodies at least");
+    snprintf(name, sizeof(name), "%s", _name(2));
+
+    // Two melodies uploaded, queued after two melodies of the bank. The last one queued is the most recently used
+    _upload("evicted", 4);
+    _upload("kept", 4);
+    _command("queue 0");
+    _command("queue 2");
+    _command("queue evicted");
+    _command("queue kept");
+
+    // A melody that does not fit with them evicts the least recently used: the indexes of the pool move
+    _upload("large", MELODY_POOL_ARENA_SIZE / 2U - 6U);
+    UNITY_TEST_ASSERT_EQUAL_UINT32(1, melody_pool_get_evictions(&(p_fsm->pool)), __LINE__, "ERROR: A melody uploaded must be evicted");
+    UNITY_TEST_ASSERT_EQUAL_INT(0, melody_pool_find(&(p_fsm->pool), "kept"), __LINE__, "ERROR: The index of a melody uploaded must move on an eviction");
+
+    // A bank with one melody less: the melodies of the bank and the melodies uploaded move down by one
+    _write_bank_without_first();
+    setenv(NATIVE_MELODY_BANK_UPDATE_ENV, QUEUE_BANK_PATH, 1);
+    int32_t length = fsm_jukebox_swap_bank(p_fsm_jukebox);
+    unsetenv(NATIVE_MELODY_BANK_UPDATE_ENV);
+    remove(QUEUE_BANK_PATH);
+    UNITY_TEST_ASSERT_EQUAL_INT(bank_length - 1U, length, __LINE__, "ERROR: The bank must be swapped to a bank with one melody less");
+    sprintf(expected, "Queue: %s, evicted, kept\n", name);
+    UNITY_TEST_ASSERT_EQUAL_STRING(expected, _command("list"), __LINE__, "ERROR: A melody not in the new bank must leave the queue, and the others must be kept");
+
+    // The melodies of the queue are played from their new indexes; the melody evicted is skipped
+    fsm_fire(p_fsm_jukebox);
+    UNITY_TEST_ASSERT_EQUAL_UINT32(1, p_fsm->melody_idx, __LINE__, "ERROR: A melody of the bank queued must be played from its index in the new bank");
+    UNITY_TEST_ASSERT_EQUAL_STRING(name, p_fsm->p_melody, __LINE__, "ERROR: The melody of the bank queued must be played after a swap");
+    fsm_buzzer_set_action(p_fsm_buzzer, STOP);
+    fsm_fire(p_fsm_buzzer);
+    fsm_fire(p_fsm_jukebox);
+    fsm_fire(p_fsm_jukebox);
+    UNITY_TEST_ASSERT_EQUAL_UINT32(0, p_fsm->queue_count, __LINE__, "ERROR: Every melody of the queue must be played or skipped");
+    UNITY_TEST_ASSERT_EQUAL_STRING("kept", p_fsm->p_melody, __LINE__, "ERROR: A melody uploaded must be played by its name after an eviction and a swap");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(melody_bank_get_length(p_fsm->p_bank) + melody_stream_get_length(&(p_fsm->stream)), p_fsm->melody_idx, __LINE__, "ERROR: A melody uploaded must be played from its index in the pool");
+}
+
+int main(void)
+{
+    port_system_init();
+    UNITY_BEGIN();
+    RUN_TEST(test_queue_commands);
+    RUN_TEST(test_queue_full);
+    RUN_TEST(test_queue_starts_when_stopped);
+    RUN_TEST(test_queue_gapless_advance);
+    RUN_TEST(test_queue_stop);
+    RUN_TEST(test_queue_packed);
+    RUN_TEST(test_queue_stable_indexes);
+    return UNITY_END();
+}
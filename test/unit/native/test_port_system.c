@@ -0,0 +1,201 @@
+#include <unity.h>
+#include <string.h>
+#include <stdlib.h>
+#include "port_system.h"
+#include "port_button.h"
+#include "port_usart.h"
+#include "port_buzzer.h"
+#include "port_melody_bank.h"
+#include "melody_bank_data.h"
+#include "command_frame.h"
+
+#define CYCLES_PER_MS (HSI_VALUE / 1000U) /*!< Core clock cycles in a millisecond */
+
+void setUp(void)
+{
+    port_system_init();
+}
+
+void tearDown(void)
+{
+}
+
+void test_virtual_clock(void)
+{
+    UNITY_TEST_ASSERT_EQUAL_UINT32(0, port_system_get_millis(), __LINE__, "ERROR: The virtual clock must start at 0 ms");
+
+    port_system_delay_ms(250);
+    UNITY_TEST_ASSERT_EQUAL_UINT32(250, port_system_get_millis(), __LINE__, "ERROR: port_system_delay_ms() must advance the virtual clock");
+    UNITY_TEST_ASSERT_TRUE(port_system_sim_get_cycles() == 250 * CYCLES_PER_MS, __LINE__, "ERROR: The virtual clock must count core clock cycles");
+
+    port_system_set_millis(1000);
+    port_system_delay_ms(5);
+    UNITY_TEST_ASSERT_EQUAL_UINT32(1005, port_system_get_millis(), __LINE__, "ERROR: port_system_set_millis() must set the reference of the milliseconds");
+
+    uint32_t t = port_system_get_millis();
+    port_system_delay_until_ms(&t, 20);
+    UNITY_TEST_ASSERT_EQUAL_UINT32(1025, t, __LINE__, "ERROR: port_system_delay_until_ms() must update the time reference");
+}
+
+void test_note_duration(void)
+{
+    port_buzzer_init(BUZZER_0_ID);
+    port_buzzer_set_note_frequency(BUZZER_0_ID, 440.0);
+    port_buzzer_set_note_duration(BUZZER_0_ID, 300);
+
+    // Busy waiting jumps straight to the end of the note
+    uint32_t polls = 0;
+    while (!port_buzzer_get_note_timeout(BUZZER_0_ID))
+    {
+        polls++;
+    }
+    UNITY_TEST_ASSERT_INT_WITHIN(1, 300, port_system_get_millis(), __LINE__, "ERROR: The note must end after its duration in virtual time");
+    UNITY_TEST_ASSERT_TRUE(polls < 3, __LINE__, "ERROR: Waiting for the end of a note must not poll the timer once per cycle");
+
+    port_buzzer_stop(BUZZER_0_ID);
+    UNITY_TEST_ASSERT_FALSE(port_system_sim_wait_for_event(), __LINE__, "ERROR: No interrupt must be pending after the buzzer has stopped");
+}
+
+void test_button_press(void)
+{
+    port_button_init(BUTTON_0_ID);
+    UNITY_TEST_ASSERT_FALSE(port_button_is_pressed(BUTTON_0_ID), __LINE__, "ERROR: The button must be released after init");
+
+    port_button_sim_press(BUTTON_0_ID, 200);
+    UNITY_TEST_ASSERT_TRUE(port_button_is_pressed(BUTTON_0_ID), __LINE__, "ERROR: The EXTI ISR must flag the press");
+
+    port_system_delay_ms(199);
+    UNITY_TEST_ASSERT_TRUE(port_button_is_pressed(BUTTON_0_ID), __LINE__, "ERROR: The button must be pressed during the whole press");
+
+    port_system_delay_ms(2);
+    UNITY_TEST_ASSERT_FALSE(port_button_is_pressed(BUTTON_0_ID), __LINE__, "ERROR: The EXTI ISR must flag the release");
+}
+
+void test_usart_receive(void)
+{
+    char msg[] = "play\n";
+    char buffer[USART_INPUT_BUFFER_LENGTH];
+    port_usart_init(USART_0_ID);
+    port_usart_enable_rx_interrupt(USART_0_ID);
+
+    UNITY_TEST_ASSERT_EQUAL_UINT32(strlen(msg), port_usart_sim_receive(USART_0_ID, msg, strlen(msg)), __LINE__, "ERROR: All the bytes must be queued");
+    while (!port_usart_rx_done(USART_0_ID))
+    {
+    }
+    // 5 bytes at 9600 baud, 10 bits per byte
+    UNITY_TEST_ASSERT_INT_WITHIN(1, 5, port_system_get_millis(), __LINE__, "ERROR: The bytes must be received at the baud rate");
+
+    port_usart_get_from_input_buffer(USART_0_ID, buffer);
+    UNITY_TEST_ASSERT_EQUAL_MEMORY("play", buffer, 4, __LINE__, "ERROR: The received bytes must be stored by the USART ISR");
+}
+
+void test_usart_receive_queue(void)
+{
+    char msg[] = "a\nb\nc\nd\ne\nf\n";
+    char buffer[USART_INPUT_BUFFER_LENGTH];
+    port_usart_init(USART_0_ID);
+    port_usart_enable_rx_interrupt(USART_0_ID);
+
+    // Six lines back to back, none read: the queue keeps the first ones and drops the rest
+    port_usart_sim_receive(USART_0_ID, msg, strlen(msg));
+    port_system_delay_ms(20);
+    UNITY_TEST_ASSERT_EQUAL_UINT32(6U - USART_RX_QUEUE_DEPTH, port_usart_get_dropped_lines(USART_0_ID), __LINE__, "ERROR: The lines received while the queue is full must be counted as dropped");
+    for (uint32_t i = 0; i < USART_RX_QUEUE_DEPTH; i++)
+    {
+        UNITY_TEST_ASSERT_TRUE(port_usart_rx_done(USART_0_ID), __LINE__, "ERROR: The lines received must be queued");
+        port_usart_get_from_input_buffer(USART_0_ID, buffer);
+        char expected[] = {(char)('a' + i), EMPTY_BUFFER_CONSTANT};
+        UNITY_TEST_ASSERT_EQUAL_STRING(expected, buffer, __LINE__, "ERROR: The lines must be read in the order they were received");
+        port_usart_reset_input_buffer(USART_0_ID);
+    }
+    UNITY_TEST_ASSERT_FALSE(port_usart_rx_done(USART_0_ID), __LINE__, "ERROR: The queue must be empty once all the lines have been read");
+
+    // A line received once there is room is queued again
+    port_usart_sim_receive(USART_0_ID, "g\n", 2);
+    port_system_delay_ms(5);
+    port_usart_get_from_input_buffer(USART_0_ID, buffer);
+    UNITY_TEST_ASSERT_EQUAL_STRING("g", buffer, __LINE__, "ERROR: A line must be queued once there is room");
+}
+
+void test_usart_receive_frame(void)
+{
+    uint8_t frames[3][USART_INPUT_BUFFER_LENGTH + USART_FRAME_CRC_LENGTH];
+    const char *args[] = {"a\nb"};
+    const uint8_t bad_length[] = {USART_FRAME_START_CONSTANT, 1, USART_FRAME_MAX_PAYLOAD + 1};
+    char buffer[USART_INPUT_BUFFER_LENGTH];
+    uint32_t length = command_frame_encode(5, args, 1, frames[0], sizeof(frames[0]));
+    memcpy(frames[1], frames[0], length);
+    frames[1][length - 1]++;
+    port_usart_init(USART_0_ID);
+    port_usart_enable_rx_interrupt(USART_0_ID);
+
+    // A frame with an end char in its payload, a frame with a wrong CRC, a wrong length and text lines in between
+    port_usart_sim_receive(USART_0_ID, (const char *)frames[0], length);
+    port_usart_sim_receive(USART_0_ID, "info\n", 5);
+    port_usart_sim_receive(USART_0_ID, (const char *)frames[1], length);
+    port_usart_sim_receive(USART_0_ID, (const char *)bad_length, sizeof(bad_length));
+    port_usart_sim_receive(USART_0_ID, "play\n", 5);
+    port_system_delay_ms(50);
+    UNITY_TEST_ASSERT_EQUAL_UINT32(2, port_usart_get_bad_frames(USART_0_ID), __LINE__, "ERROR: The frames with a wrong CRC or length must be dropped");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(0, port_usart_get_dropped_lines(USART_0_ID), __LINE__, "ERROR: The frames with errors must not be counted as dropped lines");
+
+    port_usart_get_from_input_buffer(USART_0_ID, buffer);
+    UNITY_TEST_ASSERT_EQUAL_MEMORY(frames[0], buffer, length - USART_FRAME_CRC_LENGTH, __LINE__, "ERROR: A frame must be queued whole, without its CRC");
+    UNITY_TEST_ASSERT_EQUAL_INT(EMPTY_BUFFER_CONSTANT, buffer[length - USART_FRAME_CRC_LENGTH], __LINE__, "ERROR: The CRC of a frame must not be queued");
+    port_usart_reset_input_buffer(USART_0_ID);
+    port_usart_get_from_input_buffer(USART_0_ID, buffer);
+    UNITY_TEST_ASSERT_EQUAL_STRING("info", buffer, __LINE__, "ERROR: A text line must follow a frame");
+    port_usart_reset_input_buffer(USART_0_ID);
+    port_usart_get_from_input_buffer(USART_0_ID, buffer);
+    UNITY_TEST_ASSERT_EQUAL_STRING("play", buffer, __LINE__, "ERROR: The bytes of the frames with errors must not be left in the next line");
+    port_usart_reset_input_buffer(USART_0_ID);
+    UNITY_TEST_ASSERT_FALSE(port_usart_rx_done(USART_0_ID), __LINE__, "ERROR: Only the frames with no errors and the text lines must be queued");
+}
+
+void test_usart_transmit(void)
+{
+    char msg[USART_OUTPUT_BUFFER_LENGTH] = "Jukebox ON\n";
+    char output[USART_OUTPUT_BUFFER_LENGTH];
+    port_usart_init(USART_0_ID);
+    port_usart_copy_to_output_buffer(USART_0_ID, msg, USART_OUTPUT_BUFFER_LENGTH);
+    port_usart_enable_tx_interrupt(USART_0_ID);
+    while (!port_usart_tx_done(USART_0_ID))
+    {
+    }
+    UNITY_TEST_ASSERT_EQUAL_UINT32(strlen(msg), port_usart_sim_read_output(USART_0_ID, output, sizeof(output)), __LINE__, "ERROR: All the bytes must be transmitted");
+    UNITY_TEST_ASSERT_EQUAL_STRING(msg, output, __LINE__, "ERROR: The bytes must be transmitted in order");
+    UNITY_TEST_ASSERT_EQUAL_INT(0, usart_arr[USART_0_ID].p_usart->CR1 & USART_CR1_TXEIE, __LINE__, "ERROR: The TX interrupt must be disabled after the last byte");
+}
+
+void test_melody_bank_mapped(void)
+{
+    uint32_t size;
+    const void *p_bank = port_melody_bank_get(&size);
+    UNITY_TEST_ASSERT_TRUE(port_melody_bank_sim_is_mapped(), __LINE__, "ERROR: The melody bank built with the project must be mapped from its file");
+    UNITY_TEST_ASSERT_TRUE(p_bank != melody_bank_data, __LINE__, "ERROR: The mapped bank must not be the copy linked in the executable");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(MELODY_BANK_DATA_SIZE, size, __LINE__, "ERROR: The mapped bank must have the size of the file");
+    UNITY_TEST_ASSERT_EQUAL_INT(0, memcmp(p_bank, melody_bank_data, size), __LINE__, "ERROR: The file and the linked copy must be the same bank");
+    UNITY_TEST_ASSERT_TRUE(port_melody_bank_get(&size) == p_bank, __LINE__, "ERROR: The bank must be mapped only once");
+
+    port_melody_bank_sim_unmap();
+    setenv(NATIVE_MELODY_BANK_ENV, "/nonexistent/melody_bank.bin", 1);
+    p_bank = port_melody_bank_get(&size);
+    unsetenv(NATIVE_MELODY_BANK_ENV);
+    UNITY_TEST_ASSERT_FALSE(port_melody_bank_sim_is_mapped(), __LINE__, "ERROR: A missing file must not be mapped");
+    UNITY_TEST_ASSERT_TRUE(p_bank == melody_bank_data, __LINE__, "ERROR: The linked copy must be used when the file cannot be mapped");
+    port_melody_bank_sim_unmap();
+}
+
+int main(void)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_virtual_clock);
+    RUN_TEST(test_note_duration);
+    RUN_TEST(test_button_press);
+    RUN_TEST(test_usart_receive);
+    RUN_TEST(test_usart_receive_queue);
+    RUN_TEST(test_usart_receive_frame);
+    RUN_TEST(test_usart_transmit);
+    RUN_TEST(test_melody_bank_mapped);
+    return UNITY_END();
+}
@@ -269,10 +269,14 @@ void test_buffer_reset(void)
     port_usart_init(USART_0_ID);
 
     // Check that the input and output buffers are reset with the EMPTY value
-    for (int i = 0; i < USART_INPUT_BUFFER_LENGTH; i++)
+    for (int line = 0; line < USART_RX_QUEUE_DEPTH; line++)
     {
-        UNITY_TEST_ASSERT_EQUAL_UINT8(EMPTY_BUFFER_CONSTANT, usart_arr[USART_0_ID].input_buffer[i], __LINE__, "ERROR: USART input buffer is not reset with the EMPTY_BUFFER_CONSTANT value");
+        for (int i = 0; i < USART_INPUT_BUFFER_LENGTH; i++)
+        {
+            UNITY_TEST_ASSERT_EQUAL_UINT8(EMPTY_BUFFER_CONSTANT, usart_arr[USART_0_ID].input_lines[line][i], __LINE__, "ERROR: USART input buffer is not reset with the EMPTY_BUFFER_CONSTANT value");
+        }
     }
+    UNITY_TEST_ASSERT_FALSE(port_usart_rx_done(USART_0_ID), __LINE__, "ERROR: USART queue of lines received is not empty after the configuration");
 
     for (int i = 0; i < USART_OUTPUT_BUFFER_LENGTH; i++)
     {
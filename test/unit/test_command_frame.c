@@ -0,0 +1,135 @@
+#include <unity.h>
+#include <string.h>
+#include "port_system.h"
+#include "command_frame.h"
+#include "command_table.h"
+
+static command_table_t table; /*!< Table of the commands of the frames */
+static uint32_t calls;        /*!< Number of calls of the handler */
+static uint32_t last_speed;   /*!< First argument of the last call of the handler, in Q8 */
+
+void setUp(void)
+{
+    command_table_init(&table);
+    calls = 0;
+    last_speed = 0;
+}
+
+void tearDown(void)
+{
+}
+
+/**
+ * @brief Handler of the commands of the tests: it records its call and its first argument, if any.
+ */
+static void _handler(void *p_context, command_line_t *p_line)
+{
+    calls++;
+    command_line_get_fixed(p_line, 0, 8, &last_speed);
+}
+
+/**
+ * @brief Receive a frame as the USART port queues it: without its CRC, and followed by NUL characters.
+ */
+static char *_receive(const uint8_t *p_frame, uint32_t length)
+{
+    static char line[COMMAND_FRAME_MAX_LENGTH + 1];
+    memset(line, 0, sizeof(line));
+    memcpy(line, p_frame, length - COMMAND_FRAME_CRC_LENGTH);
+    return line;
+}
+
+void test_command_frame_crc(void)
+{
+    uint8_t frame[COMMAND_FRAME_MAX_LENGTH];
+    UNITY_TEST_ASSERT_EQUAL_UINT32(0x29B1, command_frame_crc16((const uint8_t *)"123456789", 9), __LINE__, "ERROR: The CRC must be CRC-16/CCITT-FALSE");
+
+    const char *args[] = {"1.5", "200"};
+    uint32_t length = command_frame_encode(3, args, 2, frame, sizeof(frame));
+    UNITY_TEST_ASSERT_EQUAL_UINT32(COMMAND_FRAME_HEADER_LENGTH + 7U + COMMAND_FRAME_CRC_LENGTH, length, __LINE__, "ERROR: The arguments must be separated by a NUL in the payload");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(COMMAND_FRAME_START, frame[0], __LINE__, "ERROR: A frame must begin with the start byte");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(3, frame[1], __LINE__, "ERROR: The opcode must follow the start byte");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(7, frame[2], __LINE__, "ERROR: The length of the payload must follow the opcode");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(0, command_frame_crc16(&frame[1], length - 1U), __LINE__, "ERROR: The CRC of a frame followed by its CRC must be 0");
+}
+
+void test_command_frame_decode(void)
+{
+    uint8_t frame[COMMAND_FRAME_MAX_LENGTH];
+    command_line_t line;
+    uint8_t opcode;
+    const char *args[] = {"my song", "", "10"};
+    uint32_t length = command_frame_encode(7, args, 3, frame, sizeof(frame));
+    char *p_frame = _receive(frame, length);
+    UNITY_TEST_ASSERT_TRUE(command_frame_is_frame(p_frame), __LINE__, "ERROR: A frame must be told apart from a text line");
+    UNITY_TEST_ASSERT_FALSE(command_frame_is_frame("play"), __LINE__, "ERROR: A text line must not be a frame");
+    UNITY_TEST_ASSERT_TRUE(command_frame_decode(&line, p_frame, &opcode), __LINE__, "ERROR: A frame must be decoded");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(7, opcode, __LINE__, "ERROR: The opcode of a frame must be decoded");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(0, line.command.length, __LINE__, "ERROR: The command of a frame must be empty");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(3, line.num_args, __LINE__, "ERROR: Every argument of a frame must be decoded");
+    UNITY_TEST_ASSERT_EQUAL_STRING("my song", command_line_get_string(&line, 0), __LINE__, "ERROR: An argument may have spaces");
+    UNITY_TEST_ASSERT_EQUAL_STRING("", command_line_get_string(&line, 1), __LINE__, "ERROR: An argument may be empty");
+    uint32_t value;
+    UNITY_TEST_ASSERT_TRUE(command_line_get_uint(&line, 2, &value) && (value == 10), __LINE__, "ERROR: The arguments of a frame must be read as numbers");
+
+    // No arguments
+    length = command_frame_encode(1, NULL, 0, frame, sizeof(frame));
+    UNITY_TEST_ASSERT_EQUAL_UINT32(COMMAND_FRAME_HEADER_LENGTH + COMMAND_FRAME_CRC_LENGTH, length, __LINE__, "ERROR: A frame with no arguments must have an empty payload");
+    UNITY_TEST_ASSERT_TRUE(command_frame_decode(&line, _receive(frame, length), &opcode), __LINE__, "ERROR: A frame with no arguments must be decoded");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(0, line.num_args, __LINE__, "ERROR: An empty payload must have no arguments");
+
+    // Too many arguments
+    const char *many[] = {"1", "2", "3", "4", "5", "6", "7", "8", "9"};
+    length = command_frame_encode(1, many, 9, frame, sizeof(frame));
+    UNITY_TEST_ASSERT_FALSE(command_frame_decode(&line, _receive(frame, length), &opcode), __LINE__, "ERROR: A frame with too many arguments must not be decoded");
+}
+
+void test_command_frame_limits(void)
+{
+    uint8_t frame[COMMAND_FRAME_MAX_LENGTH];
+    char payload[COMMAND_FRAME_MAX_PAYLOAD + 2];
+    memset(payload, 'a', sizeof(payload) - 1U);
+    payload[sizeof(payload) - 1U] = '\0';
+    const char *args[] = {payload};
+    UNITY_TEST_ASSERT_EQUAL_UINT32(0, command_frame_encode(1, args, 1, frame, sizeof(frame)), __LINE__, "ERROR: A payload longer than a line must not be encoded");
+    payload[COMMAND_FRAME_MAX_PAYLOAD] = '\0';
+    UNITY_TEST_ASSERT_EQUAL_UINT32(COMMAND_FRAME_MAX_LENGTH, command_frame_encode(1, args, 1, frame, sizeof(frame)), __LINE__, "ERROR: The longest payload must be encoded");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(0, command_frame_encode(1, args, 1, frame, sizeof(frame) - 1U), __LINE__, "ERROR: A frame must not overflow its buffer");
+}
+
+void test_command_frame_opcodes(void)
+{
+    uint8_t frame[COMMAND_FRAME_MAX_LENGTH];
+    command_line_t line;
+    uint8_t opcode;
+    command_table_register(&table, "speed", 3, 1, 2, _handler, NULL);
+    command_table_register(&table, "play", 0, 0, 0, _handler, NULL);
+
+    // The opcode is the one registered, whatever the order of registration
+    const char *args[] = {"1.5"};
+    command_frame_decode(&line, _receive(frame, command_frame_encode(3, args, 1, frame, sizeof(frame))), &opcode);
+    const command_t *p_command = command_table_get(&table, opcode);
+    UNITY_TEST_ASSERT_TRUE((p_command != NULL) && (strcmp(p_command->p_name, "speed") == 0), __LINE__, "ERROR: A command must be found by its opcode");
+    UNITY_TEST_ASSERT_EQUAL_INT(COMMAND_TABLE_OK, command_table_call(p_command, &line), __LINE__, "ERROR: The command of a frame must be called");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(1, calls, __LINE__, "ERROR: The handler of the command of a frame must be called once");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(384, last_speed, __LINE__, "ERROR: The handler must get the arguments of the frame");
+
+    // The schema of the command is checked as for a text line
+    command_frame_decode(&line, _receive(frame, command_frame_encode(0, args, 1, frame, sizeof(frame))), &opcode);
+    UNITY_TEST_ASSERT_EQUAL_INT(COMMAND_TABLE_WRONG_ARGS, command_table_call(command_table_get(&table, opcode), &line), __LINE__, "ERROR: The arguments of a frame must match the schema of its command");
+    UNITY_TEST_ASSERT_TRUE(command_table_get(&table, 1) == NULL, __LINE__, "ERROR: An opcode not registered must not be found");
+    UNITY_TEST_ASSERT_TRUE(command_table_get(&table, COMMAND_TABLE_MAX_OPCODES) == NULL, __LINE__, "ERROR: An opcode out of the table must not be found");
+    UNITY_TEST_ASSERT_EQUAL_INT(COMMAND_TABLE_NOT_FOUND, command_table_call(NULL, &line), __LINE__, "ERROR: A command not found must not be called");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(1, calls, __LINE__, "ERROR: The handler must not be called for a wrong frame");
+}
+
+int main(void)
+{
+    port_system_init();
+    UNITY_BEGIN();
+    RUN_TEST(test_command_frame_crc);
+    RUN_TEST(test_command_frame_decode);
+    RUN_TEST(test_command_frame_limits);
+    RUN_TEST(test_command_frame_opcodes);
+    return UNITY_END();
+}
@@ -0,0 +1,122 @@
+#include <unity.h>
+#include <string.h>
+#include "port_system.h"
+#include "command_line.h"
+
+static command_line_t line; /*!< Line under test */
+static char text[64];       /*!< Buffer of the line: the tokens point into it */
+
+void setUp(void)
+{
+    memset(text, 0, sizeof(text));
+}
+
+void tearDown(void)
+{
+}
+
+/**
+ * @brief Copy a line into the buffer and tokenize it.
+ */
+static bool _tokenize(const char *p_text)
+{
+    strcpy(text, p_text);
+    return command_line_tokenize(&line, text);
+}
+
+void test_command_line_tokens(void)
+{
+    UNITY_TEST_ASSERT_TRUE(_tokenize("  speed 2\t 300\r"), __LINE__, "ERROR: A line must be tokenized");
+    UNITY_TEST_ASSERT_TRUE(command_token_equals(&line.command, "speed"), __LINE__, "ERROR: The first token must be the command");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(2, line.num_args, __LINE__, "ERROR: Every word after the command must be an argument");
+    UNITY_TEST_ASSERT_TRUE(command_token_equals(&line.args[0], "2"), __LINE__, "ERROR: An argument must be a slice of the line");
+    UNITY_TEST_ASSERT_TRUE(command_token_equals(&line.args[1], "300"), __LINE__, "ERROR: An argument must not include the separators");
+    UNITY_TEST_ASSERT_TRUE((line.command.p_start >= text) && (line.args[1].p_start < text + sizeof(text)), __LINE__, "ERROR: The tokens must point into the buffer of the line");
+    UNITY_TEST_ASSERT_FALSE(command_token_equals(&line.command, "spee"), __LINE__, "ERROR: A prefix must not be equal to a token");
+
+    UNITY_TEST_ASSERT_TRUE(_tokenize("   "), __LINE__, "ERROR: A blank line must be tokenized");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(0, line.command.length, __LINE__, "ERROR: A blank line must have no command");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(0, line.num_args, __LINE__, "ERROR: A blank line must have no arguments");
+
+    UNITY_TEST_ASSERT_TRUE(_tokenize("a 1 2 3 4 5 6 7 8"), __LINE__, "ERROR: A line with the maximum number of arguments must be tokenized");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(COMMAND_LINE_MAX_ARGS, line.num_args, __LINE__, "ERROR: Every argument must be kept");
+    UNITY_TEST_ASSERT_FALSE(_tokenize("a 1 2 3 4 5 6 7 8 9"), __LINE__, "ERROR: A line with too many arguments must be rejected");
+}
+
+void test_command_line_quotes(void)
+{
+    UNITY_TEST_ASSERT_TRUE(_tokenize("upload \"my song\" 10"), __LINE__, "ERROR: A line with a quoted name must be tokenized");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(2, line.num_args, __LINE__, "ERROR: A quoted name must be a single argument");
+    UNITY_TEST_ASSERT_EQUAL_STRING("my song", command_line_get_string(&line, 0), __LINE__, "ERROR: A quoted name must not include its quotes");
+    UNITY_TEST_ASSERT_EQUAL_STRING("10", command_line_get_string(&line, 1), __LINE__, "ERROR: The argument after a quoted name must be kept");
+
+    UNITY_TEST_ASSERT_TRUE(_tokenize("select \"\""), __LINE__, "ERROR: An empty quoted name must be tokenized");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(1, line.num_args, __LINE__, "ERROR: An empty quoted name must be an argument");
+    UNITY_TEST_ASSERT_EQUAL_STRING("", command_line_get_string(&line, 0), __LINE__, "ERROR: An empty quoted name must be empty");
+
+    UNITY_TEST_ASSERT_FALSE(_tokenize("select \"my song"), __LINE__, "ERROR: A quote not closed must be rejected");
+    UNITY_TEST_ASSERT_FALSE(_tokenize("select \"my\"song"), __LINE__, "ERROR: A quote not followed by a separator must be rejected");
+}
+
+void test_command_line_strings(void)
+{
+    _tokenize("select Spanish  anthem ");
+    UNITY_TEST_ASSERT_EQUAL_STRING("Spanish  anthem", command_line_get_rest(&line, 0), __LINE__, "ERROR: The rest of the line must keep its inner spaces");
+    _tokenize("select Spanish anthem");
+    UNITY_TEST_ASSERT_EQUAL_STRING("anthem", command_line_get_rest(&line, 1), __LINE__, "ERROR: The rest of the line must start at its argument");
+    UNITY_TEST_ASSERT_EQUAL_STRING("Spanish", command_line_get_string(&line, 0), __LINE__, "ERROR: An argument must be got as a string");
+    UNITY_TEST_ASSERT_TRUE(command_line_get_string(&line, 2) == NULL, __LINE__, "ERROR: A missing argument must not be got");
+    UNITY_TEST_ASSERT_TRUE(command_line_get_rest(&line, 2) == NULL, __LINE__, "ERROR: A missing argument must not be got");
+}
+
+void test_command_line_numbers(void)
+{
+    uint32_t value;
+    _tokenize("n 0 4294967295 4294967296 12a -1 1.5");
+    UNITY_TEST_ASSERT_TRUE(command_line_get_uint(&line, 0, &value) && (value == 0), __LINE__, "ERROR: 0 must be parsed");
+    UNITY_TEST_ASSERT_TRUE(command_line_get_uint(&line, 1, &value) && (value == UINT32_MAX), __LINE__, "ERROR: The largest integer must be parsed");
+    UNITY_TEST_ASSERT_FALSE(command_line_get_uint(&line, 2, &value), __LINE__, "ERROR: An integer that overflows must be rejected");
+    UNITY_TEST_ASSERT_FALSE(command_line_get_uint(&line, 3, &value), __LINE__, "ERROR: An integer with letters must be rejected");
+    UNITY_TEST_ASSERT_FALSE(command_line_get_uint(&line, 4, &value), __LINE__, "ERROR: A negative integer must be rejected");
+    UNITY_TEST_ASSERT_FALSE(command_line_get_uint(&line, 5, &value), __LINE__, "ERROR: A decimal must not be an integer");
+    UNITY_TEST_ASSERT_FALSE(command_line_get_uint(&line, 6, &value), __LINE__, "ERROR: A missing argument must not be parsed");
+    UNITY_TEST_ASSERT_FALSE(command_line_get_fixed(&line, 1, 8, &value), __LINE__, "ERROR: A number that overflows once scaled must be rejected");
+
+    _tokenize("n 2 1.25 0.1 .5 3. 1.99999 1.2.3 x");
+    UNITY_TEST_ASSERT_TRUE(command_line_get_fixed(&line, 0, 8, &value) && (value == 512), __LINE__, "ERROR: An integer must be parsed as fixed point");
+    UNITY_TEST_ASSERT_TRUE(command_line_get_fixed(&line, 1, 8, &value) && (value == 320), __LINE__, "ERROR: A decimal must be parsed as fixed point");
+    UNITY_TEST_ASSERT_TRUE(command_line_get_fixed(&line, 2, 8, &value) && (value == 26), __LINE__, "ERROR: A decimal must be rounded to the nearest");
+    UNITY_TEST_ASSERT_TRUE(command_line_get_fixed(&line, 3, 16, &value) && (value == 32768), __LINE__, "ERROR: A decimal with no integer part must be parsed");
+    UNITY_TEST_ASSERT_TRUE(command_line_get_fixed(&line, 4, 8, &value) && (value == 768), __LINE__, "ERROR: A decimal with no fraction must be parsed");
+    UNITY_TEST_ASSERT_TRUE(command_line_get_fixed(&line, 5, 8, &value) && (value == 512), __LINE__, "ERROR: Only the first decimals must be parsed");
+    UNITY_TEST_ASSERT_FALSE(command_line_get_fixed(&line, 6, 8, &value), __LINE__, "ERROR: A number with two points must be rejected");
+    UNITY_TEST_ASSERT_FALSE(command_line_get_fixed(&line, 7, 8, &value), __LINE__, "ERROR: A word must not be a number");
+}
+
+void test_command_line_batch(void)
+{
+    strcpy(text, " select \"a;b\" ; speed 2;;info");
+    char *p_text = text;
+    UNITY_TEST_ASSERT_EQUAL_STRING("select \"a;b\"", command_line_next(&p_text), __LINE__, "ERROR: A separator between quotes must be part of a name");
+    UNITY_TEST_ASSERT_EQUAL_STRING("speed 2", command_line_next(&p_text), __LINE__, "ERROR: The commands of a batch must be split at the separators");
+    UNITY_TEST_ASSERT_EQUAL_STRING("", command_line_next(&p_text), __LINE__, "ERROR: An empty command of a batch must be blank");
+    UNITY_TEST_ASSERT_EQUAL_STRING("info", command_line_next(&p_text), __LINE__, "ERROR: The last command of a batch must be got");
+    UNITY_TEST_ASSERT_TRUE(command_line_next(&p_text) == NULL, __LINE__, "ERROR: There must be no command after the last one");
+
+    strcpy(text, "play");
+    p_text = text;
+    UNITY_TEST_ASSERT_TRUE(command_line_next(&p_text) == text, __LINE__, "ERROR: A line with no separator must be a single command, in place");
+    UNITY_TEST_ASSERT_TRUE(command_line_next(&p_text) == NULL, __LINE__, "ERROR: A line with no separator must hold a single command");
+}
+
+int main(void)
+{
+    port_system_init();
+    UNITY_BEGIN();
+    RUN_TEST(test_command_line_tokens);
+    RUN_TEST(test_command_line_quotes);
+    RUN_TEST(test_command_line_strings);
+    RUN_TEST(test_command_line_numbers);
+    RUN_TEST(test_command_line_batch);
+    return UNITY_END();
+}
@@ -0,0 +1,119 @@
+#include <unity.h>
+#include <string.h>
+#include "port_system.h"
+#include "command_table.h"
+
+static command_table_t table;     /*!< Table under test */
+static uint32_t calls;            /*!< Number of calls of the handlers */
+static void *p_last_context;      /*!< Context of the last call of a handler */
+static char last_param[32];       /*!< Arguments of the last call of a handler */
+
+void setUp(void)
+{
+    command_table_init(&table);
+    calls = 0;
+    p_last_context = NULL;
+    memset(last_param, 0, sizeof(last_param));
+}
+
+void tearDown(void)
+{
+}
+
+/**
+ * @brief Handler of the commands of the tests: it records its call.
+ */
+static void _handler(void *p_context, command_line_t *p_line)
+{
+    calls++;
+    p_last_context = p_context;
+    strncpy(last_param, (p_line->num_args > 0) ? command_line_get_rest(p_line, 0) : "", sizeof(last_param) - 1U);
+}
+
+/**
+ * @brief Tokenize a line and dispatch its command.
+ */
+static command_table_result_t _dispatch(const char *p_text)
+{
+    static char text[32];
+    command_line_t line;
+    strcpy(text, p_text);
+    command_line_tokenize(&line, text);
+    return command_table_dispatch(&table, &line);
+}
+
+void test_command_table_dispatch(void)
+{
+    static int context_play;
+    static int context_speed;
+    UNITY_TEST_ASSERT_TRUE(command_table_register(&table, "play", 0, 0, 0, _handler, &context_play), __LINE__, "ERROR: A command must be registered");
+    UNITY_TEST_ASSERT_TRUE(command_table_register(&table, "speed", 3, 1, 2, _handler, &context_speed), __LINE__, "ERROR: A command must be registered");
+
+    UNITY_TEST_ASSERT_EQUAL_INT(COMMAND_TABLE_OK, _dispatch("speed 1.5 200"), __LINE__, "ERROR: A command registered must be dispatched");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(1, calls, __LINE__, "ERROR: The handler of a command must be called once");
+    UNITY_TEST_ASSERT_TRUE(p_last_context == &context_speed, __LINE__, "ERROR: The handler must get the context of its command");
+    UNITY_TEST_ASSERT_EQUAL_STRING("1.5 200", last_param, __LINE__, "ERROR: The handler must get the arguments of the command");
+
+    UNITY_TEST_ASSERT_EQUAL_INT(COMMAND_TABLE_OK, _dispatch("play"), __LINE__, "ERROR: A command with no arguments must be dispatched");
+    UNITY_TEST_ASSERT_TRUE(p_last_context == &context_play, __LINE__, "ERROR: The handler must get the context of its command");
+
+    // Names that only share their length or their first character with a command
+    UNITY_TEST_ASSERT_EQUAL_INT(COMMAND_TABLE_NOT_FOUND, _dispatch("plan"), __LINE__, "ERROR: A name of the same length must not be a command");
+    UNITY_TEST_ASSERT_EQUAL_INT(COMMAND_TABLE_NOT_FOUND, _dispatch("pla"), __LINE__, "ERROR: A prefix of a command must not be a command");
+    UNITY_TEST_ASSERT_EQUAL_INT(COMMAND_TABLE_NOT_FOUND, _dispatch("plays"), __LINE__, "ERROR: A longer name must not be a command");
+    UNITY_TEST_ASSERT_EQUAL_INT(COMMAND_TABLE_NOT_FOUND, _dispatch(""), __LINE__, "ERROR: An empty name must not be a command");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(2, calls, __LINE__, "ERROR: No handler must be called for a missing command");
+}
+
+void test_command_table_schema(void)
+{
+    command_table_register(&table, "speed", 3, 1, 2, _handler, NULL);
+    command_table_register(&table, "select", 5, 1, COMMAND_TABLE_ANY_ARGS, _handler, NULL);
+
+    UNITY_TEST_ASSERT_EQUAL_INT(COMMAND_TABLE_WRONG_ARGS, _dispatch("speed"), __LINE__, "ERROR: A command with too few arguments must not be dispatched");
+    UNITY_TEST_ASSERT_EQUAL_INT(COMMAND_TABLE_WRONG_ARGS, _dispatch("speed 1 2 3"), __LINE__, "ERROR: A command with too many arguments must not be dispatched");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(0, calls, __LINE__, "ERROR: No handler must be called for wrong arguments");
+    UNITY_TEST_ASSERT_EQUAL_INT(COMMAND_TABLE_OK, _dispatch("select a b c d e"), __LINE__, "ERROR: A command with any number of arguments must be dispatched");
+}
+
+void test_command_table_register(void)
+{
+    static char names[COMMAND_TABLE_MAX_COMMANDS + 1U][4];
+    UNITY_TEST_ASSERT_FALSE(command_table_register(&table, "", 0, 0, 0, _handler, NULL), __LINE__, "ERROR: An empty name must not be registered");
+    UNITY_TEST_ASSERT_FALSE(command_table_register(&table, "a b", 0, 0, 0, _handler, NULL), __LINE__, "ERROR: A name with spaces must not be registered");
+    UNITY_TEST_ASSERT_FALSE(command_table_register(&table, "play", 0, 0, 0, NULL, NULL), __LINE__, "ERROR: A command with no handler must not be registered");
+    UNITY_TEST_ASSERT_FALSE(command_table_register(&table, "play", COMMAND_TABLE_MAX_OPCODES, 0, 0, _handler, NULL), __LINE__, "ERROR: A command with an opcode out of the table must not be registered");
+    UNITY_TEST_ASSERT_TRUE(command_table_register(&table, "play", 0, 0, 0, _handler, NULL), __LINE__, "ERROR: A command must be registered");
+    UNITY_TEST_ASSERT_FALSE(command_table_register(&table, "play", 1, 0, 0, _handler, NULL), __LINE__, "ERROR: A command must not be registered twice");
+    UNITY_TEST_ASSERT_FALSE(command_table_register(&table, "stop", 0, 0, 0, _handler, NULL), __LINE__, "ERROR: An opcode must not be registered twice");
+    UNITY_TEST_ASSERT_TRUE(command_table_register(&table, "help", COMMAND_TABLE_NO_OPCODE, 0, 0, _handler, NULL), __LINE__, "ERROR: A command with no opcode must be registered");
+    UNITY_TEST_ASSERT_TRUE(command_table_register(&table, "info", COMMAND_TABLE_NO_OPCODE, 0, 0, _handler, NULL), __LINE__, "ERROR: Many commands must be registered with no opcode");
+    UNITY_TEST_ASSERT_TRUE(command_table_get(&table, COMMAND_TABLE_NO_OPCODE) == NULL, __LINE__, "ERROR: A command with no opcode must not be found by an opcode");
+
+    // Fill the table: every command is still found, whatever its bucket
+    for (uint32_t i = 3; i <= COMMAND_TABLE_MAX_COMMANDS; i++)
+    {
+        names[i][0] = (char)('a' + i % 26U);
+        names[i][1] = (char)('0' + i / 10U);
+        names[i][2] = (char)('0' + i % 10U);
+        bool registered = command_table_register(&table, names[i], (uint8_t)i, 0, 0, _handler, NULL);
+        UNITY_TEST_ASSERT_EQUAL_INT(i < COMMAND_TABLE_MAX_COMMANDS, registered, __LINE__, "ERROR: Commands must be registered until the table is full");
+    }
+    UNITY_TEST_ASSERT_TRUE(command_table_find(&table, "play", 4) != NULL, __LINE__, "ERROR: A command must be found in a full table");
+    for (uint32_t i = 3; i < COMMAND_TABLE_MAX_COMMANDS; i++)
+    {
+        const command_t *p_command = command_table_find(&table, names[i], strlen(names[i]));
+        UNITY_TEST_ASSERT_TRUE((p_command != NULL) && (strcmp(p_command->p_name, names[i]) == 0), __LINE__, "ERROR: Every command must be found in a full table");
+        UNITY_TEST_ASSERT_TRUE(command_table_get(&table, i) == p_command, __LINE__, "ERROR: Every command must be found by its opcode in a full table");
+    }
+}
+
+int main(void)
+{
+    port_system_init();
+    UNITY_BEGIN();
+    RUN_TEST(test_command_table_dispatch);
+    RUN_TEST(test_command_table_schema);
+    RUN_TEST(test_command_table_register);
+    return UNITY_END();
+}
@@ -0,0 +1,145 @@
+#include <unity.h>
+#include "port_system.h"
+#include "port_buzzer.h"
+#include "fsm_buzzer.h"
+#include "melodies.h"
+#include "note_table.h"
+
+#define NOTE_MS 250 /*!< Duration of every note of scale_melody */
+
+static const uint8_t scale_compact_notes[] = {MIDI_NOTE(DO, 4), MIDI_NOTE(RE, 4), MIDI_NOTE(MI, 4), MIDI_NOTE(FA, 4),
+                                              MIDI_NOTE(SOL, 4), MIDI_NOTE(LA, 4), MIDI_NOTE(SI, 4), MIDI_NOTE(DO, 5)}; /*!< Notes of scale_melody */
+static const uint8_t scale_compact_ticks[] = {1, 1, 1, 1, 1, 1, 1, 1};                                             /*!< Durations of scale_melody */
+static const melody_t scale_compact_melody = {.p_name = "scale_compact",
+                                              .p_midi_notes = scale_compact_notes,
+                                              .p_ticks = scale_compact_ticks,
+                                              .tick_ms = NOTE_MS,
+                                              .melody_length = 8}; /*!< scale_melody in the compact format */
+
+static const uint8_t silence_notes[] = {MIDI_NOTE(DO, 4), MIDI_SILENCE}; /*!< Notes of a compact melody with a silence */
+static const uint8_t silence_ticks[] = {3, 2};                           /*!< Durations of a compact melody with a silence */
+static const melody_t silence_melody = {.p_name = "silence",
+                                        .p_midi_notes = silence_notes,
+                                        .p_ticks = silence_ticks,
+                                        .tick_ms = 100,
+                                        .melody_length = 2}; /*!< Compact melody with a silence */
+
+fsm_t *p_fsm_buzzer; /*!< Buzzer FSM used by the tests */
+
+void setUp(void)
+{
+    p_fsm_buzzer = fsm_buzzer_new(BUZZER_0_ID);
+}
+
+void tearDown(void)
+{
+    port_buzzer_stop(BUZZER_0_ID);
+    fsm_destroy(p_fsm_buzzer);
+}
+
+void test_midi_note_numbers(void)
+{
+    UNITY_TEST_ASSERT_EQUAL_UINT32(60, MIDI_NOTE(DO, 4), __LINE__, "ERROR: DO4 must be the MIDI note 60");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(69, MIDI_NOTE(LA, 4), __LINE__, "ERROR: LA4 must be the MIDI note 69");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(78, MIDI_NOTE(FAs, 5), __LINE__, "ERROR: FA#5 must be the MIDI note 78");
+    UNITY_TEST_ASSERT_TRUE(note_table_find_midi(MIDI_SILENCE) == NULL, __LINE__, "ERROR: A silence must not be in the note table");
+    UNITY_TEST_ASSERT_TRUE(note_table_find_midi(NOTE_TABLE_MIDI_FIRST + NOTE_TABLE_MIDI_LENGTH) == NULL, __LINE__, "ERROR: A note out of the table must not be found");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(PORT_BUZZER_HZ_Q16(LA4), note_table_find_midi(MIDI_NOTE(LA, 4))->frequency_q16, __LINE__, "ERROR: The MIDI notes must have the frequencies of melodies.h");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(PORT_BUZZER_HZ_Q16(SI8), note_table_find_midi(MIDI_NOTE(SI, 8))->frequency_q16, __LINE__, "ERROR: The MIDI notes must have the frequencies of melodies.h");
+}
+
+void test_accessors_both_formats(void)
+{
+    UNITY_TEST_ASSERT_FALSE(melody_is_compact(&scale_melody), __LINE__, "ERROR: scale_melody has its notes in Hz");
+    UNITY_TEST_ASSERT_TRUE(melody_is_compact(&scale_compact_melody), __LINE__, "ERROR: A melody with no p_notes must be compact");
+    for (uint32_t i = 0; i < scale_melody.melody_length; i++)
+    {
+        UNITY_TEST_ASSERT_EQUAL_UINT32(PORT_BUZZER_HZ_Q16(scale_melody.p_notes[i]), melody_get_note_q16(&scale_melody, i), __LINE__, "ERROR: Wrong note of a melody in Hz");
+        UNITY_TEST_ASSERT_EQUAL_UINT32(melody_get_note_q16(&scale_melody, i), melody_get_note_q16(&scale_compact_melody, i), __LINE__, "ERROR: A compact melody must play the same notes");
+        UNITY_TEST_ASSERT_TRUE(melody_get_note_hz(&scale_melody, i) == melody_get_note_hz(&scale_compact_melody, i), __LINE__, "ERROR: A compact melody must play the same notes");
+        UNITY_TEST_ASSERT_EQUAL_UINT32(melody_get_duration_ms(&scale_melody, i), melody_get_duration_ms(&scale_compact_melody, i), __LINE__, "ERROR: A compact melody must last the same");
+    }
+    UNITY_TEST_ASSERT_EQUAL_UINT32(0, melody_get_note_q16(&silence_melody, 1), __LINE__, "ERROR: MIDI_SILENCE must be a silence");
+    UNITY_TEST_ASSERT_TRUE(melody_get_note_hz(&silence_melody, 1) == SILENCE, __LINE__, "ERROR: MIDI_SILENCE must be a silence");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(300, melody_get_duration_ms(&silence_melody, 0), __LINE__, "ERROR: The duration of a note must be its ticks times tick_ms");
+}
+
+void test_playlist_melodies(void)
+{
+    const melody_t *melodies[] = {&happy_birthday_melody, &tetris_melody, &spanish_anthem, &feliz_navidad_melody};
+    for (uint32_t i = 0; i < sizeof(melodies) / sizeof(melodies[0]); i++)
+    {
+        UNITY_TEST_ASSERT_TRUE(melody_is_compact(melodies[i]), __LINE__, "ERROR: The melodies of the jukebox must be compact");
+        for (uint32_t j = 0; j < melodies[i]->melody_length; j++)
+        {
+            UNITY_TEST_ASSERT_TRUE(note_table_find_q16(melody_get_note_q16(melodies[i], j)) != NULL, __LINE__, "ERROR: Every note of a melody must be in the note table");
+            UNITY_TEST_ASSERT_TRUE(melody_get_duration_ms(melodies[i], j) > 0, __LINE__, "ERROR: Every note of a melody must last");
+        }
+        UNITY_TEST_ASSERT_EQUAL_UINT32(melodies[i]->melody_length * 2, melody_get_size(melodies[i], true), __LINE__, "ERROR: A compact note must take 2 bytes");
+    }
+    // First notes of Happy Birthday, as written in Hz and ms before
+    UNITY_TEST_ASSERT_EQUAL_UINT32(PORT_BUZZER_HZ_Q16(DO4), melody_get_note_q16(&happy_birthday_melody, 0), __LINE__, "ERROR: Wrong note of Happy Birthday");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(PORT_BUZZER_HZ_Q16(LAs4), melody_get_note_q16(&happy_birthday_melody, 19), __LINE__, "ERROR: Wrong note of Happy Birthday");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(300, melody_get_duration_ms(&happy_birthday_melody, 0), __LINE__, "ERROR: Wrong duration of Happy Birthday");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(800, melody_get_duration_ms(&happy_birthday_melody, 5), __LINE__, "ERROR: Wrong duration of Happy Birthday");
+}
+
+void test_fsm_plays_compact_melody(void)
+{
+    port_buzzer_note_regs_t expected[8];
+    fsm_buzzer_set_melody(p_fsm_buzzer, &scale_melody);
+    fsm_buzzer_set_action(p_fsm_buzzer, PLAY);
+    fsm_fire(p_fsm_buzzer);
+    for (uint32_t i = 0; i < scale_melody.melody_length; i++)
+    {
+        port_system_delay_ms(NOTE_MS / 2);
+        expected[i] = (port_buzzer_note_regs_t){.pwm_psc = TIM3->PSC, .pwm_arr = TIM3->ARR, .pwm_ccr = TIM3->CCR1, .duration_psc = TIM2->PSC, .duration_arr = TIM2->ARR};
+        port_system_delay_ms(NOTE_MS / 2);
+        fsm_fire(p_fsm_buzzer);
+        fsm_fire(p_fsm_buzzer);
+    }
+    port_buzzer_stop(BUZZER_0_ID);
+    fsm_destroy(p_fsm_buzzer);
+
+    p_fsm_buzzer = fsm_buzzer_new(BUZZER_0_ID);
+    fsm_buzzer_set_melody(p_fsm_buzzer, &scale_compact_melody);
+    fsm_buzzer_set_action(p_fsm_buzzer, PLAY);
+    fsm_fire(p_fsm_buzzer);
+    for (uint32_t i = 0; i < scale_compact_melody.melody_length; i++)
+    {
+        port_system_delay_ms(NOTE_MS / 2);
+        UNITY_TEST_ASSERT_EQUAL_UINT32(expected[i].pwm_psc, TIM3->PSC, __LINE__, "ERROR: A compact melody must load the same PSC of the PWM timer");
+        UNITY_TEST_ASSERT_EQUAL_UINT32(expected[i].pwm_arr, TIM3->ARR, __LINE__, "ERROR: A compact melody must load the same ARR of the PWM timer");
+        UNITY_TEST_ASSERT_EQUAL_UINT32(expected[i].pwm_ccr, TIM3->CCR1, __LINE__, "ERROR: A compact melody must load the same CCR of the PWM timer");
+        UNITY_TEST_ASSERT_EQUAL_UINT32(expected[i].duration_psc, TIM2->PSC, __LINE__, "ERROR: A compact melody must load the same PSC of the duration timer");
+        UNITY_TEST_ASSERT_EQUAL_UINT32(expected[i].duration_arr, TIM2->ARR, __LINE__, "ERROR: A compact melody must load the same ARR of the duration timer");
+        port_system_delay_ms(NOTE_MS / 2);
+        fsm_fire(p_fsm_buzzer);
+        fsm_fire(p_fsm_buzzer);
+    }
+}
+
+void test_fsm_compact_silence(void)
+{
+    fsm_buzzer_set_melody(p_fsm_buzzer, &silence_melody);
+    fsm_buzzer_set_action(p_fsm_buzzer, PLAY);
+    fsm_fire(p_fsm_buzzer);
+    port_system_delay_ms(150);
+    UNITY_TEST_ASSERT(TIM3->CR1 & TIM_CR1_CEN, __LINE__, "ERROR: The first note must be playing");
+    port_system_delay_ms(200);
+    fsm_fire(p_fsm_buzzer);
+    fsm_fire(p_fsm_buzzer);
+    UNITY_TEST_ASSERT_EQUAL_UINT32(0, TIM3->CR1 & TIM_CR1_CEN, __LINE__, "ERROR: MIDI_SILENCE must not play any note");
+}
+
+int main(void)
+{
+    port_system_init();
+    UNITY_BEGIN();
+    RUN_TEST(test_midi_note_numbers);
+    RUN_TEST(test_accessors_both_formats);
+    RUN_TEST(test_playlist_melodies);
+    RUN_TEST(test_fsm_plays_compact_melody);
+    RUN_TEST(test_fsm_compact_silence);
+    return UNITY_END();
+}
@@ -0,0 +1,145 @@
+#include <unity.h>
+#include <stdlib.h>
+#include <math.h>
+#include "port_system.h"
+#include "port_buzzer.h"
+#include "fsm_buzzer.h"
+#include "melodies.h"
+#include "note_table.h"
+#include "compiled_melodies.h"
+
+fsm_t *p_fsm_buzzer; /*!< Buzzer FSM used by the tests */
+
+void setUp(void)
+{
+    p_fsm_buzzer = fsm_buzzer_new(BUZZER_0_ID);
+}
+
+void tearDown(void)
+{
+    port_buzzer_stop(BUZZER_0_ID);
+    free(p_fsm_buzzer);
+}
+
+void test_compiled_melodies_present(void)
+{
+    UNITY_TEST_ASSERT_EQUAL_UINT32(NOTE_TABLE_CLOCK_HZ, compiled_melodies_clock_hz, __LINE__, "ERROR: The melodies must be compiled for the same clock as the note table");
+    UNITY_TEST_ASSERT_TRUE(compiled_melodies_length > 0, __LINE__, "ERROR: There must be at least one compiled melody");
+    for (uint32_t i = 0; i < compiled_melodies_length; i++)
+    {
+        UNITY_TEST_ASSERT_EQUAL_UINT32(compiled_melodies[i].p_source->melody_length, compiled_melodies[i].melody_length, __LINE__, "ERROR: A compiled melody must have the length of its source melody");
+    }
+}
+
+void test_compiled_pwm_registers(void)
+{
+    for (uint32_t i = 0; i < compiled_melodies_length; i++)
+    {
+        const compiled_melody_t *p_compiled = &compiled_melodies[i];
+        for (uint32_t j = 0; j < p_compiled->melody_length; j++)
+        {
+            double frequency_hz = p_compiled->p_source->p_notes[j];
+            const port_buzzer_note_regs_t *p_regs = &p_compiled->p_regs[j];
+            if (frequency_hz == SILENCE)
+            {
+                UNITY_TEST_ASSERT_EQUAL_UINT32(0, p_regs->pwm_arr, __LINE__, "ERROR: A silence must be compiled with ARR = 0");
+                continue;
+            }
+            const note_regs_t *p_note = note_table_find(frequency_hz);
+            UNITY_TEST_ASSERT_TRUE(p_note != NULL, __LINE__, "ERROR: Every note of a melody must be in the note table");
+            UNITY_TEST_ASSERT_EQUAL_UINT32(p_note->psc, p_regs->pwm_psc, __LINE__, "ERROR: Wrong compiled PSC of the PWM timer");
+            UNITY_TEST_ASSERT_EQUAL_UINT32(p_note->arr, p_regs->pwm_arr, __LINE__, "ERROR: Wrong compiled ARR of the PWM timer");
+            UNITY_TEST_ASSERT_EQUAL_UINT32(p_note->ccr, p_regs->pwm_ccr, __LINE__, "ERROR: Wrong compiled CCR of the PWM timer");
+        }
+    }
+}
+
+void test_compiled_duration_registers(void)
+{
+    for (uint32_t i = 0; i < compiled_melodies_length; i++)
+    {
+        const compiled_melody_t *p_compiled = &compiled_melodies[i];
+        for (uint32_t j = 0; j < p_compiled->melody_length; j++)
+        {
+            port_buzzer_set_note_duration(BUZZER_0_ID, p_compiled->p_source->p_durations[j]);
+            UNITY_TEST_ASSERT_EQUAL_UINT32(TIM2->PSC, p_compiled->p_regs[j].duration_psc, __LINE__, "ERROR: Wrong compiled PSC of the duration timer");
+            UNITY_TEST_ASSERT_EQUAL_UINT32(TIM2->ARR, p_compiled->p_regs[j].duration_arr, __LINE__, "ERROR: Wrong compiled ARR of the duration timer");
+        }
+    }
+}
+
+void test_compiled_melody_find(void)
+{
+    melody_t copy = scale_bass_melody;
+    const compiled_melody_t *p_compiled = compiled_melody_find(&scale_bass_melody);
+    UNITY_TEST_ASSERT_TRUE(p_compiled != NULL, __LINE__, "ERROR: The melodies of melodies.c must be compiled");
+    UNITY_TEST_ASSERT_TRUE(p_compiled->p_source == &scale_bass_melody, __LINE__, "ERROR: compiled_melody_find() returned a wrong melody");
+    UNITY_TEST_ASSERT_TRUE(compiled_melody_find(&copy) == p_compiled, __LINE__, "ERROR: A copy of a melody must be found too");
+
+    copy.melody_length--;
+    UNITY_TEST_ASSERT_TRUE(compiled_melody_find(&copy) == NULL, __LINE__, "ERROR: A different melody must not be found");
+    UNITY_TEST_ASSERT_TRUE(compiled_melody_find(NULL) == NULL, __LINE__, "ERROR: A NULL melody must not be found");
+}
+
+void test_fsm_plays_compiled_melody(void)
+{
+    const compiled_melody_t *p_compiled = compiled_melody_find(&scale_bass_melody);
+    fsm_buzzer_set_melody(p_fsm_buzzer, &scale_bass_melody);
+    fsm_buzzer_set_action(p_fsm_buzzer, PLAY);
+    fsm_fire(p_fsm_buzzer);
+
+    UNITY_TEST_ASSERT_TRUE(((fsm_buzzer_t *)p_fsm_buzzer)->p_compiled == p_compiled, __LINE__, "ERROR: The FSM must play the compiled melody at normal speed");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(p_compiled->p_regs[0].pwm_psc, TIM3->PSC, __LINE__, "ERROR: The compiled PSC of the PWM timer has not been loaded");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(p_compiled->p_regs[0].pwm_arr, TIM3->ARR, __LINE__, "ERROR: The compiled ARR of the PWM timer has not been loaded");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(p_compiled->p_regs[0].pwm_ccr, TIM3->CCR1, __LINE__, "ERROR: The compiled CCR of the PWM timer has not been loaded");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(p_compiled->p_regs[0].duration_psc, TIM2->PSC, __LINE__, "ERROR: The compiled PSC of the duration timer has not been loaded");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(p_compiled->p_regs[0].duration_arr, TIM2->ARR, __LINE__, "ERROR: The compiled ARR of the duration timer has not been loaded");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(TIM_CR1_CEN, TIM3->CR1 & TIM_CR1_CEN, __LINE__, "ERROR: The PWM timer must be enabled");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(TIM_CR1_CEN, TIM2->CR1 & TIM_CR1_CEN, __LINE__, "ERROR: The duration timer must be enabled");
+}
+
+void test_fsm_fallback_other_speed(void)
+{
+    uint32_t duration_ms = scale_bass_melody.p_durations[0];
+    fsm_buzzer_set_melody(p_fsm_buzzer, &scale_bass_melody);
+    fsm_buzzer_set_speed(p_fsm_buzzer, 2.0);
+    fsm_buzzer_set_action(p_fsm_buzzer, PLAY);
+    fsm_fire(p_fsm_buzzer);
+    uint32_t psc = TIM2->PSC;
+    uint32_t arr = TIM2->ARR;
+
+    // The duration of the note must be the one computed at runtime for the speed of the player
+    port_buzzer_set_note_duration(BUZZER_0_ID, (uint32_t)(duration_ms / 2.0));
+    UNITY_TEST_ASSERT_EQUAL_UINT32(TIM2->PSC, psc, __LINE__, "ERROR: The PSC of the duration timer does not take into account the speed of the player");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(TIM2->ARR, arr, __LINE__, "ERROR: The ARR of the duration timer does not take into account the speed of the player");
+}
+
+void test_fsm_compiled_pwm_other_speed(void)
+{
+    const compiled_melody_t *p_compiled = compiled_melody_find(&scale_bass_melody);
+    fsm_buzzer_set_melody(p_fsm_buzzer, &scale_bass_melody);
+    fsm_buzzer_set_speed_q8(p_fsm_buzzer, FSM_BUZZER_SPEED_Q8(1.5));
+    fsm_buzzer_set_action(p_fsm_buzzer, PLAY);
+    fsm_fire(p_fsm_buzzer);
+
+    // The frequency does not depend on the speed: it is loaded from the compiled melody
+    UNITY_TEST_ASSERT_EQUAL_UINT32(p_compiled->p_regs[0].pwm_psc, TIM3->PSC, __LINE__, "ERROR: The compiled PSC of the PWM timer must be loaded at any speed");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(p_compiled->p_regs[0].pwm_arr, TIM3->ARR, __LINE__, "ERROR: The compiled ARR of the PWM timer must be loaded at any speed");
+    double ticks = (double)SystemCoreClock * scale_bass_melody.p_durations[0] / 1000.0 / 1.5;
+    double generated = ((double)TIM2->PSC + 1.0) * ((double)TIM2->ARR + 1.0);
+    UNITY_TEST_ASSERT_TRUE(fabs(generated - ticks) <= ((double)TIM2->PSC + 1.0) / 2.0, __LINE__, "ERROR: The duration of the note must be scaled by the speed in fixed point");
+}
+
+int main(void)
+{
+    port_system_init();
+    UNITY_BEGIN();
+    RUN_TEST(test_compiled_melodies_present);
+    RUN_TEST(test_compiled_pwm_registers);
+    RUN_TEST(test_compiled_duration_registers);
+    RUN_TEST(test_compiled_melody_find);
+    RUN_TEST(test_fsm_plays_compiled_melody);
+    RUN_TEST(test_fsm_fallback_other_speed);
+    RUN_TEST(test_fsm_compiled_pwm_other_speed);
+    return UNITY_END();
+}
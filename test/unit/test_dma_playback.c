@@ -0,0 +1,142 @@
+#include <unity.h>
+#include <math.h>
+#include "port_system.h"
+#include "port_buzzer.h"
+#include "fsm_buzzer.h"
+#include "melodies.h"
+
+#define NOTE_MS 250 /*!< Duration of every note of scale_melody */
+
+static const double silence_notes[] = {DO4, SILENCE, RE4};         /*!< Notes of a melody with a silence */
+static const uint16_t silence_durations[] = {100, 100, 100};       /*!< Durations of a melody with a silence */
+static const melody_t silence_melody = {.p_name = "silence",
+                                        .p_notes = silence_notes,
+                                        .p_durations = silence_durations,
+                                        .melody_length = 3}; /*!< Melody with a silence */
+
+fsm_t *p_fsm_buzzer; /*!< Buzzer FSM used by the tests */
+
+void setUp(void)
+{
+    p_fsm_buzzer = fsm_buzzer_new(BUZZER_0_ID);
+    fsm_buzzer_set_dma(p_fsm_buzzer, true);
+    fsm_buzzer_set_melody(p_fsm_buzzer, &scale_melody);
+}
+
+void tearDown(void)
+{
+    port_buzzer_stop(BUZZER_0_ID);
+    fsm_destroy(p_fsm_buzzer);
+}
+
+/**
+ * @brief Check that the PWM timer plays a note.
+ *
+ * @param frequency_hz Frequency of the note in Hz
+ * @param line Line of the test
+ */
+static void _assert_note(double frequency_hz, uint32_t line)
+{
+    double pwm_hz = (double)SystemCoreClock / ((TIM3->PSC + 1.0) * (TIM3->ARR + 1.0));
+    UNITY_TEST_ASSERT(fabs(pwm_hz - frequency_hz) < frequency_hz * 0.002, line, "ERROR: The PWM timer must play the frequency of the note");
+    UNITY_TEST_ASSERT_UINT32_WITHIN(1, (TIM3->ARR + 1) / 2, TIM3->CCR1, line, "ERROR: The PWM timer must keep the duty cycle");
+    UNITY_TEST_ASSERT(TIM3->CR1 & TIM_CR1_CEN, line, "ERROR: The PWM timer must be running");
+}
+
+void test_dma_plays_melody(void)
+{
+    fsm_buzzer_set_action(p_fsm_buzzer, PLAY);
+    fsm_fire(p_fsm_buzzer);
+    UNITY_TEST_ASSERT_TRUE(port_buzzer_get_dma_busy(BUZZER_0_ID), __LINE__, "ERROR: The melody must be played by DMA");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(scale_melody.melody_length, ((fsm_buzzer_t *)p_fsm_buzzer)->note_index, __LINE__, "ERROR: The whole melody must be handed to the HW");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(0, TIM2->DIER & TIM_DIER_UIE, __LINE__, "ERROR: The notes must not interrupt the CPU");
+
+    // The FSM is not fired: the timers and the DMA play every note
+    port_system_delay_ms(NOTE_MS / 2);
+    for (uint32_t i = 0; i < scale_melody.melody_length; i++)
+    {
+        _assert_note(scale_melody.p_notes[i], __LINE__);
+        UNITY_TEST_ASSERT_FALSE(buzzers_arr[BUZZER_0_ID].note_end, __LINE__, "ERROR: The player must only be notified at the end of the melody");
+        port_system_delay_ms(NOTE_MS);
+    }
+    UNITY_TEST_ASSERT_TRUE(buzzers_arr[BUZZER_0_ID].note_end, __LINE__, "ERROR: The end of the transfer must end the melody");
+    UNITY_TEST_ASSERT_FALSE(port_buzzer_get_dma_busy(BUZZER_0_ID), __LINE__, "ERROR: The DMA playback must be over");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(0, TIM2->CR1 & TIM_CR1_CEN, __LINE__, "ERROR: The duration timer must be stopped at the end of the melody");
+    UNITY_TEST_ASSERT(TIM2->DIER & TIM_DIER_UIE, __LINE__, "ERROR: The note by note playback must be restored");
+
+    fsm_fire(p_fsm_buzzer);
+    fsm_fire(p_fsm_buzzer);
+    UNITY_TEST_ASSERT_EQUAL_UINT32(WAIT_MELODY, ((fsm_buzzer_t *)p_fsm_buzzer)->f.current_state, __LINE__, "ERROR: The FSM must wait for a new melody at the end of the melody");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(STOP, fsm_buzzer_get_action(p_fsm_buzzer), __LINE__, "ERROR: The player must stop at the end of the melody");
+}
+
+void test_dma_silence(void)
+{
+    fsm_buzzer_set_melody(p_fsm_buzzer, &silence_melody);
+    fsm_buzzer_set_action(p_fsm_buzzer, PLAY);
+    fsm_fire(p_fsm_buzzer);
+    port_system_delay_ms(150);
+    UNITY_TEST_ASSERT_EQUAL_UINT32(0, TIM3->CCR1, __LINE__, "ERROR: A silence must keep the PWM output low");
+    port_system_delay_ms(100);
+    _assert_note(RE4, __LINE__);
+}
+
+void test_dma_pause_resume(void)
+{
+    fsm_buzzer_set_action(p_fsm_buzzer, PLAY);
+    fsm_fire(p_fsm_buzzer);
+    port_system_delay_ms(2 * NOTE_MS + NOTE_MS / 2);
+    fsm_buzzer_set_action(p_fsm_buzzer, PAUSE);
+    UNITY_TEST_ASSERT_FALSE(port_buzzer_get_dma_busy(BUZZER_0_ID), __LINE__, "ERROR: The DMA playback must stop on pause");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(2, ((fsm_buzzer_t *)p_fsm_buzzer)->note_index, __LINE__, "ERROR: The note that was playing must be played on resume");
+
+    fsm_fire(p_fsm_buzzer);
+    fsm_fire(p_fsm_buzzer);
+    UNITY_TEST_ASSERT_EQUAL_UINT32(PAUSE_NOTE, ((fsm_buzzer_t *)p_fsm_buzzer)->f.current_state, __LINE__, "ERROR: The player must pause");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(0, TIM2->CR1 & TIM_CR1_CEN, __LINE__, "ERROR: The duration timer must be stopped while paused");
+
+    fsm_buzzer_set_action(p_fsm_buzzer, PLAY);
+    fsm_fire(p_fsm_buzzer);
+    fsm_fire(p_fsm_buzzer);
+    UNITY_TEST_ASSERT_TRUE(port_buzzer_get_dma_busy(BUZZER_0_ID), __LINE__, "ERROR: The rest of the melody must be played by DMA on resume");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(2, ((fsm_buzzer_t *)p_fsm_buzzer)->dma_first_note, __LINE__, "ERROR: The DMA playback must resume at the paused note");
+    port_system_delay_ms(NOTE_MS / 2);
+    _assert_note(scale_melody.p_notes[2], __LINE__);
+    port_system_delay_ms(NOTE_MS);
+    _assert_note(scale_melody.p_notes[3], __LINE__);
+}
+
+void test_dma_stop(void)
+{
+    fsm_buzzer_set_action(p_fsm_buzzer, PLAY);
+    fsm_fire(p_fsm_buzzer);
+    port_system_delay_ms(NOTE_MS + NOTE_MS / 2);
+    fsm_buzzer_set_action(p_fsm_buzzer, STOP);
+    UNITY_TEST_ASSERT_FALSE(port_buzzer_get_dma_busy(BUZZER_0_ID), __LINE__, "ERROR: The DMA playback must stop on stop");
+    fsm_fire(p_fsm_buzzer);
+    fsm_fire(p_fsm_buzzer);
+    UNITY_TEST_ASSERT_EQUAL_UINT32(WAIT_START, ((fsm_buzzer_t *)p_fsm_buzzer)->f.current_state, __LINE__, "ERROR: The player must stop");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(0, ((fsm_buzzer_t *)p_fsm_buzzer)->note_index, __LINE__, "ERROR: The melody must be rewound on stop");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(0, TIM3->CR1 & TIM_CR1_CEN, __LINE__, "ERROR: The PWM timer must be stopped");
+}
+
+void test_dma_player_idle(void)
+{
+    fsm_buzzer_set_action(p_fsm_buzzer, PLAY);
+    fsm_fire(p_fsm_buzzer);
+    UNITY_TEST_ASSERT_FALSE(fsm_buzzer_check_activity(p_fsm_buzzer), __LINE__, "ERROR: The player must let the system sleep while the DMA plays the melody");
+    port_system_delay_ms(scale_melody.melody_length * NOTE_MS + NOTE_MS / 2);
+    UNITY_TEST_ASSERT_TRUE(fsm_buzzer_check_activity(p_fsm_buzzer), __LINE__, "ERROR: The player must wake up at the end of the melody");
+}
+
+int main(void)
+{
+    port_system_init();
+    UNITY_BEGIN();
+    RUN_TEST(test_dma_plays_melody);
+    RUN_TEST(test_dma_silence);
+    RUN_TEST(test_dma_pause_resume);
+    RUN_TEST(test_dma_stop);
+    RUN_TEST(test_dma_player_idle);
+    return UNITY_END();
+}
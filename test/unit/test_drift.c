@@ -0,0 +1,94 @@
+#include <unity.h>
+#include <stdlib.h>
+#include "port_system.h"
+#include "port_buzzer.h"
+#include "fsm_buzzer.h"
+#include "melodies.h"
+
+#define NOTE_MS 250         /*!< Duration of every note of scale_melody */
+#define LATENCY_MS 1        /*!< Time the main loop takes to notice the end of each note */
+#define SCHEDULE_ERROR_US 20 /*!< Error of the end of a note on schedule: rounding of the registers of the timer */
+
+fsm_t *p_fsm_buzzer; /*!< Buzzer FSM used by the tests */
+
+void setUp(void)
+{
+    p_fsm_buzzer = fsm_buzzer_new(BUZZER_0_ID);
+    fsm_buzzer_set_melody(p_fsm_buzzer, &scale_melody);
+}
+
+void tearDown(void)
+{
+    port_buzzer_stop(BUZZER_0_ID);
+    fsm_destroy(p_fsm_buzzer);
+}
+
+/**
+ * @brief Fire the FSM until the melody ends, with a busy main loop that notices the end of each note LATENCY_MS late.
+ *
+ * @param pause_at Index of the note at which the player is paused for a while, or the length of the melody
+ */
+static void _play_late(uint32_t pause_at)
+{
+    fsm_buzzer_set_action(p_fsm_buzzer, PLAY);
+    fsm_fire(p_fsm_buzzer);
+    while (fsm_buzzer_get_action(p_fsm_buzzer) != STOP)
+    {
+        fsm_buzzer_t *p_fsm = (fsm_buzzer_t *)p_fsm_buzzer;
+        if ((p_fsm->f.current_state == WAIT_NOTE) && port_buzzer_get_note_timeout(BUZZER_0_ID))
+        {
+            port_system_delay_ms(LATENCY_MS);
+            if (p_fsm->note_index == pause_at)
+            {
+                fsm_buzzer_set_action(p_fsm_buzzer, PAUSE);
+                fsm_fire(p_fsm_buzzer);
+                fsm_fire(p_fsm_buzzer);
+                port_system_delay_ms(NOTE_MS);
+                fsm_buzzer_set_action(p_fsm_buzzer, PLAY);
+            }
+        }
+        fsm_fire(p_fsm_buzzer);
+    }
+}
+
+void test_relative_time_drifts(void)
+{
+    _play_late(scale_melody.melody_length);
+    // Every note but the first one starts late and lasts its whole duration
+    int32_t expected_us = (int32_t)(scale_melody.melody_length - 1) * LATENCY_MS * 1000;
+    UNITY_TEST_ASSERT(fsm_buzzer_get_drift_us(p_fsm_buzzer) >= expected_us, __LINE__, "ERROR: The latency of the main loop must accumulate along the melody");
+}
+
+void test_absolute_time_compensates(void)
+{
+    fsm_buzzer_set_absolute_time(p_fsm_buzzer, true);
+    _play_late(scale_melody.melody_length);
+    UNITY_TEST_ASSERT(abs(fsm_buzzer_get_drift_us(p_fsm_buzzer)) <= SCHEDULE_ERROR_US, __LINE__, "ERROR: The latency of the main loop must be compensated by the next note");
+}
+
+void test_absolute_time_pause(void)
+{
+    fsm_buzzer_set_absolute_time(p_fsm_buzzer, true);
+    _play_late(3);
+    UNITY_TEST_ASSERT(abs(fsm_buzzer_get_drift_us(p_fsm_buzzer)) <= SCHEDULE_ERROR_US, __LINE__, "ERROR: The time paused must not be accounted as drift");
+}
+
+void test_absolute_time_speed(void)
+{
+    fsm_buzzer_set_absolute_time(p_fsm_buzzer, true);
+    fsm_buzzer_set_speed(p_fsm_buzzer, 3.0);
+    _play_late(scale_melody.melody_length);
+    // The durations at this speed are not a whole number of ms: the schedule keeps the fractions
+    UNITY_TEST_ASSERT(abs(fsm_buzzer_get_drift_us(p_fsm_buzzer)) <= SCHEDULE_ERROR_US, __LINE__, "ERROR: The schedule must follow the scaled durations");
+}
+
+int main(void)
+{
+    port_system_init();
+    UNITY_BEGIN();
+    RUN_TEST(test_relative_time_drifts);
+    RUN_TEST(test_absolute_time_compensates);
+    RUN_TEST(test_absolute_time_pause);
+    RUN_TEST(test_absolute_time_speed);
+    return UNITY_END();
+}
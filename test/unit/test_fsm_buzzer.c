@@ -100,7 +100,7 @@ void test_note_duration_interr(void)
     fsm_fire(p_fsm);
 
     // Wait for the note to end or for the timeout to be reached
-    while (!buzzers_arr[BUZZER_0_ID].note_end)
+    while (!port_buzzer_get_note_timeout(BUZZER_0_ID))
     {
         // Calculate the elapsed time
         uint32_t elapsed_time = port_system_get_millis() - start_tick;
@@ -69,11 +69,13 @@ void test_usart_rx()
 {
     char char_array_test[] = "TEST RX";
 
-    // Copy the data to the USART buffer
-    memcpy(usart_arr[USART_0_ID].input_buffer, char_array_test, sizeof(char_array_test));
+    uint32_t line = usart_arr[USART_0_ID].rx_tail % USART_RX_QUEUE_DEPTH;
 
-    // Force read_complete
-    usart_arr[USART_0_ID].read_complete = true;
+    // Copy the data to the line being received by the USART
+    memcpy(usart_arr[USART_0_ID].input_lines[line], char_array_test, sizeof(char_array_test));
+
+    // Force the line to be complete
+    usart_arr[USART_0_ID].rx_tail++;
 
     // First transition
     fsm_fire(p_fsm);
@@ -85,10 +87,10 @@ void test_usart_rx()
     // Check that the USART buffer has been cleared correctly
     char expected_buffer[sizeof(char_array_test)];
     memset(expected_buffer, EMPTY_BUFFER_CONSTANT, sizeof(expected_buffer));
-    UNITY_TEST_ASSERT_EQUAL_MEMORY(expected_buffer, usart_arr[USART_0_ID].input_buffer, sizeof(expected_buffer), __LINE__, "The data has not been cleared correctly from the input buffer of the USART");
+    UNITY_TEST_ASSERT_EQUAL_MEMORY(expected_buffer, usart_arr[USART_0_ID].input_lines[line], sizeof(expected_buffer), __LINE__, "The data has not been cleared correctly from the input buffer of the USART");
 
-    // Check that the read_complete flag has been cleared correctly
-    UNITY_TEST_ASSERT_EQUAL_INT(false, usart_arr[USART_0_ID].read_complete, __LINE__, "The read_complete flag has not been cleared correctly");
+    // Check that the line has been removed from the queue of the USART
+    UNITY_TEST_ASSERT_EQUAL_INT(false, port_usart_rx_done(USART_0_ID), __LINE__, "The line read has not been removed from the queue of the USART");
 
     // Check that data_received flag has been set correctly
     UNITY_TEST_ASSERT_EQUAL_INT(true, ((fsm_usart_t *)p_fsm)->data_received, __LINE__, "The data_received flag has not been set correctly");
@@ -118,7 +120,7 @@ void test_usart_tx()
     UNITY_TEST_ASSERT_EQUAL_INT(USART_CR1_TXEIE, usart_arr[USART_0_ID].p_usart->CR1 & USART_CR1_TXEIE, __LINE__, "The TXEIE bit has not been enabled correctly after sending the first and following chars");
     
     // Wait for the last char to be sent, leaving the ISR to send the rest of the chars.
-    while ((!usart_arr[USART_0_ID].write_complete))
+    while (!port_usart_tx_done(USART_0_ID))
     {        
     }
 
@@ -148,6 +150,71 @@ void test_usart_tx()
     UNITY_TEST_ASSERT_EQUAL_INT(false, usart_arr[USART_0_ID].write_complete, __LINE__, "The write_complete flag has not been cleared correctly in the transition to WAIT_DATA");
 }
 
+/**
+ * @brief Test the reception of several lines in a row: they wait in the queue of the USART until the previous one is read.
+ * 
+ */
+void test_usart_rx_queue()
+{
+    const char *lines[] = {"play", "info", "stop"};
+    for (uint32_t i = 0; i < 3; i++)
+    {
+        strcpy(usart_arr[USART_0_ID].input_lines[usart_arr[USART_0_ID].rx_tail % USART_RX_QUEUE_DEPTH], lines[i]);
+        usart_arr[USART_0_ID].rx_tail++;
+    }
+
+    // The line not read yet is not overwritten by the next ones
+    fsm_fire(p_fsm);
+    fsm_fire(p_fsm);
+    UNITY_TEST_ASSERT_EQUAL_STRING("play", ((fsm_usart_t *)p_fsm)->in_data, __LINE__, "A line not read must not be overwritten by the next line");
+
+    // Each reset reads the next line at once, so that all of them are read in a row
+    for (uint32_t i = 0; i < 3; i++)
+    {
+        UNITY_TEST_ASSERT_TRUE(fsm_usart_check_data_received(p_fsm), __LINE__, "A line queued must be ready to be read");
+        UNITY_TEST_ASSERT_EQUAL_STRING(lines[i], fsm_usart_get_in_buffer(p_fsm), __LINE__, "The lines must be read in the order they were received");
+        fsm_usart_reset_input_data(p_fsm);
+    }
+    UNITY_TEST_ASSERT_FALSE(fsm_usart_check_data_received(p_fsm), __LINE__, "There must be no data once all the lines have been read");
+}
+
+/**
+ * @brief Test the transmission of several lines set in a row: they are sent one after the other.
+ * 
+ */
+void test_usart_tx_queue()
+{
+    fsm_usart_set_out_data(p_fsm, "first\n");
+    fsm_usart_set_out_data(p_fsm, "second\n");
+    UNITY_TEST_ASSERT_EQUAL_STRING("first\nsecond\n", ((fsm_usart_t *)p_fsm)->out_data, __LINE__, "A line set before the previous one is sent must be queued after it");
+
+    fsm_fire(p_fsm);
+    UNITY_TEST_ASSERT_EQUAL_STRING("first\nsecond\n", usart_arr[USART_0_ID].output_buffer, __LINE__, "The lines queued must be passed to the USART");
+    while (!port_usart_tx_done(USART_0_ID))
+    {
+    }
+    fsm_fire(p_fsm);
+    UNITY_TEST_ASSERT_EQUAL_STRING("second\n", ((fsm_usart_t *)p_fsm)->out_data, __LINE__, "Only the line sent must be removed from the queue");
+
+    fsm_fire(p_fsm);
+    UNITY_TEST_ASSERT_EQUAL_INT(SEND_DATA, fsm_get_state(p_fsm), __LINE__, "The next line queued must be sent");
+    while (!port_usart_tx_done(USART_0_ID))
+    {
+    }
+    fsm_fire(p_fsm);
+    UNITY_TEST_ASSERT_EQUAL_STRING("", ((fsm_usart_t *)p_fsm)->out_data, __LINE__, "The queue must be empty once all the lines have been sent");
+
+    // A line that does not fit is dropped
+    char long_line[USART_OUTPUT_BUFFER_LENGTH];
+    memset(long_line, 'x', sizeof(long_line) - 2);
+    long_line[sizeof(long_line) - 2] = '\n';
+    long_line[sizeof(long_line) - 1] = EMPTY_BUFFER_CONSTANT;
+    fsm_usart_set_out_data(p_fsm, "first\n");
+    fsm_usart_set_out_data(p_fsm, long_line);
+    UNITY_TEST_ASSERT_EQUAL_STRING("first\n", ((fsm_usart_t *)p_fsm)->out_data, __LINE__, "A line that does not fit must not be queued");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(1, ((fsm_usart_t *)p_fsm)->dropped_replies, __LINE__, "A line that does not fit must be counted as dropped");
+}
+
 /**
  * @brief Main test function. Read the terminal for instructions or notes.
  * 
@@ -160,5 +227,7 @@ int main(void)
     RUN_TEST(test_initial_config);
     RUN_TEST(test_usart_rx);
     RUN_TEST(test_usart_tx);
+    RUN_TEST(test_usart_rx_queue);
+    RUN_TEST(test_usart_tx_queue);
     return UNITY_END();
 }
\ No newline at end of file
@@ -0,0 +1,164 @@
+#include <unity.h>
+#include "port_system.h"
+#include "port_buzzer.h"
+#include "fsm_buzzer.h"
+#include "melodies.h"
+
+#define GAPLESS_MAX_GAP_CYCLES 1000 /*!< Maximum gap between notes in gapless mode: latency of the ISR of the duration timer */
+
+fsm_t *p_fsm_buzzer; /*!< Buzzer FSM used by the tests */
+
+void setUp(void)
+{
+    p_fsm_buzzer = fsm_buzzer_new(BUZZER_0_ID);
+    port_system_cycle_counter_init();
+    port_buzzer_reset_gap_stats(BUZZER_0_ID);
+}
+
+void tearDown(void)
+{
+    port_buzzer_stop(BUZZER_0_ID);
+    fsm_destroy(p_fsm_buzzer);
+}
+
+/**
+ * @brief Play a melody until the player stops by itself.
+ */
+static void _play(const melody_t *p_melody, bool gapless)
+{
+    fsm_buzzer_set_gapless(p_fsm_buzzer, gapless);
+    fsm_buzzer_set_melody(p_fsm_buzzer, p_melody);
+    fsm_buzzer_set_action(p_fsm_buzzer, PLAY);
+    fsm_fire(p_fsm_buzzer);
+    port_buzzer_reset_gap_stats(BUZZER_0_ID);
+    while (fsm_buzzer_get_action(p_fsm_buzzer) != STOP)
+    {
+        fsm_fire(p_fsm_buzzer);
+    }
+}
+
+void test_next_note_in_preload_registers(void)
+{
+    port_buzzer_note_regs_t current;
+    port_buzzer_note_regs_t next;
+    port_buzzer_get_note_regs(LA4, 20, &current);
+    port_buzzer_get_note_regs(DO5, 10, &next);
+
+    port_buzzer_set_note_regs(BUZZER_0_ID, &current);
+    port_buzzer_set_next_note_regs(BUZZER_0_ID, &next);
+    UNITY_TEST_ASSERT_TRUE(port_buzzer_get_next_note_staged(BUZZER_0_ID), __LINE__, "ERROR: The next note must be staged");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(next.duration_psc, TIM2->PSC, __LINE__, "ERROR: The PSC of the next note must be in the preload register of the duration timer");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(next.duration_arr, TIM2->ARR, __LINE__, "ERROR: The ARR of the next note must be in the preload register of the duration timer");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(current.pwm_arr, TIM3->ARR, __LINE__, "ERROR: The frequency of the current note must not change before the end of the note");
+
+    while (!port_buzzer_get_note_timeout(BUZZER_0_ID))
+    {
+    }
+    UNITY_TEST_ASSERT_FALSE(port_buzzer_get_next_note_staged(BUZZER_0_ID), __LINE__, "ERROR: The staged note must start at the end of the current note");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(next.pwm_psc, TIM3->PSC, __LINE__, "ERROR: Wrong PSC of the PWM timer after the end of the note");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(next.pwm_arr, TIM3->ARR, __LINE__, "ERROR: Wrong ARR of the PWM timer after the end of the note");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(next.pwm_ccr, TIM3->CCR1, __LINE__, "ERROR: Wrong CCR1 of the PWM timer after the end of the note");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(TIM_CR1_CEN, TIM3->CR1 & TIM_CR1_CEN, __LINE__, "ERROR: The PWM timer must keep running");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(TIM_CR1_CEN, TIM2->CR1 & TIM_CR1_CEN, __LINE__, "ERROR: The duration timer must keep running");
+
+    port_buzzer_gap_stats_t stats;
+    port_buzzer_get_gap_stats(BUZZER_0_ID, &stats);
+    UNITY_TEST_ASSERT_EQUAL_UINT32(1, stats.count, __LINE__, "ERROR: The gap before the staged note must be measured");
+    UNITY_TEST_ASSERT_TRUE(stats.max_cycles < GAPLESS_MAX_GAP_CYCLES, __LINE__, "ERROR: The gap before a staged note is too long");
+}
+
+void test_restart_gap_measured(void)
+{
+    port_buzzer_set_note_duration(BUZZER_0_ID, 5);
+    while (!port_buzzer_get_note_timeout(BUZZER_0_ID))
+    {
+    }
+    port_system_delay_ms(2);
+    port_buzzer_set_note_duration(BUZZER_0_ID, 5);
+
+    port_buzzer_gap_stats_t stats;
+    port_buzzer_get_gap_stats(BUZZER_0_ID, &stats);
+    UNITY_TEST_ASSERT_EQUAL_UINT32(1, stats.count, __LINE__, "ERROR: The gap before a restarted note must be measured");
+    UNITY_TEST_ASSERT_TRUE(stats.max_cycles >= 2 * (SystemCoreClock / 1000), __LINE__, "ERROR: The gap before a restarted note is too short");
+}
+
+void test_fsm_gapless_melody(void)
+{
+    _play(&scale_melody, true);
+
+    port_buzzer_gap_stats_t stats;
+    port_buzzer_get_gap_stats(BUZZER_0_ID, &stats);
+    UNITY_TEST_ASSERT_EQUAL_UINT32(scale_melody.melody_length - 1, stats.count, __LINE__, "ERROR: Every note of the melody must be played");
+    UNITY_TEST_ASSERT_TRUE(stats.max_cycles < GAPLESS_MAX_GAP_CYCLES, __LINE__, "ERROR: The gap between notes in gapless mode is too long");
+}
+
+void test_fsm_gapless_pause(void)
+{
+    fsm_buzzer_set_gapless(p_fsm_buzzer, true);
+    fsm_buzzer_set_melody(p_fsm_buzzer, &scale_melody);
+    fsm_buzzer_set_action(p_fsm_buzzer, PLAY);
+    fsm_fire(p_fsm_buzzer);
+    UNITY_TEST_ASSERT_TRUE(((fsm_buzzer_t *)p_fsm_buzzer)->next_staged, __LINE__, "ERROR: The second note must be staged when the melody starts");
+
+    // Pause at the end of the first note: the second one, already started by the HW, is stopped
+    fsm_buzzer_set_action(p_fsm_buzzer, PAUSE);
+    while (!port_buzzer_get_note_timeout(BUZZER_0_ID))
+    {
+    }
+    fsm_fire(p_fsm_buzzer);
+    fsm_fire(p_fsm_buzzer);
+    UNITY_TEST_ASSERT_EQUAL_UINT32(PAUSE_NOTE, ((fsm_buzzer_t *)p_fsm_buzzer)->f.current_state, __LINE__, "ERROR: The player must be paused");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(0, TIM2->CR1 & TIM_CR1_CEN, __LINE__, "ERROR: The duration timer must be stopped while paused");
+    UNITY_TEST_ASSERT_FALSE(((fsm_buzzer_t *)p_fsm_buzzer)->next_staged, __LINE__, "ERROR: No note must be staged while paused");
+
+    // On resume the second note is played from the beginning
+    fsm_buzzer_set_action(p_fsm_buzzer, PLAY);
+    fsm_fire(p_fsm_buzzer);
+    fsm_fire(p_fsm_buzzer);
+    UNITY_TEST_ASSERT_EQUAL_UINT32(2, ((fsm_buzzer_t *)p_fsm_buzzer)->note_index, __LINE__, "ERROR: The second note must be played on resume");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(TIM_CR1_CEN, TIM2->CR1 & TIM_CR1_CEN, __LINE__, "ERROR: The duration timer must run on resume");
+}
+
+void test_fsm_gapless_next_melody(void)
+{
+    fsm_buzzer_set_gapless(p_fsm_buzzer, true);
+    fsm_buzzer_set_melody(p_fsm_buzzer, &scale_melody);
+    UNITY_TEST_ASSERT_TRUE(fsm_buzzer_set_next_melody(p_fsm_buzzer, &scale_reverse_melody), __LINE__, "ERROR: A melody must be set to follow the melody playing");
+    fsm_buzzer_set_action(p_fsm_buzzer, PLAY);
+    fsm_fire(p_fsm_buzzer);
+    port_buzzer_reset_gap_stats(BUZZER_0_ID);
+    while (fsm_buzzer_get_action(p_fsm_buzzer) != STOP)
+    {
+        fsm_fire(p_fsm_buzzer);
+    }
+
+    // The player has gone on with the next melody without stopping, and its first note was staged
+    port_buzzer_gap_stats_t stats;
+    port_buzzer_get_gap_stats(BUZZER_0_ID, &stats);
+    UNITY_TEST_ASSERT_TRUE(fsm_buzzer_get_melody(p_fsm_buzzer) == &scale_reverse_melody, __LINE__, "ERROR: The player must go on with the next melody");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(scale_melody.melody_length + scale_reverse_melody.melody_length - 1, stats.count, __LINE__, "ERROR: Every note of both melodies must be played");
+    UNITY_TEST_ASSERT_TRUE(stats.max_cycles < GAPLESS_MAX_GAP_CYCLES, __LINE__, "ERROR: The gap between the melodies in gapless mode is too long");
+    UNITY_TEST_ASSERT_TRUE(((fsm_buzzer_t *)p_fsm_buzzer)->p_next_melody == NULL, __LINE__, "ERROR: The next melody must be played once");
+}
+
+void test_fsm_legacy_melody(void)
+{
+    _play(&scale_melody, false);
+
+    port_buzzer_gap_stats_t stats;
+    port_buzzer_get_gap_stats(BUZZER_0_ID, &stats);
+    UNITY_TEST_ASSERT_EQUAL_UINT32(scale_melody.melody_length - 1, stats.count, __LINE__, "ERROR: Every gap between notes must be measured");
+}
+
+int main(void)
+{
+    port_system_init();
+    UNITY_BEGIN();
+    RUN_TEST(test_next_note_in_preload_registers);
+    RUN_TEST(test_restart_gap_measured);
+    RUN_TEST(test_fsm_gapless_melody);
+    RUN_TEST(test_fsm_gapless_pause);
+    RUN_TEST(test_fsm_gapless_next_melody);
+    RUN_TEST(test_fsm_legacy_melody);
+    return UNITY_END();
+}
@@ -0,0 +1,295 @@
+#include <unity.h>
+#include <string.h>
+#include "port_system.h"
+#include "port_buzzer.h"
+#include "port_melody_bank.h"
+#include "fsm_buzzer.h"
+#include "melodies.h"
+#include "melody_bank.h"
+#include "melody_codec.h"
+#include "melody_timeline.h"
+#include "note_table.h"
+
+#define BANK_MAX_SIZE 4096 /*!< Size of the copies of the bank modified by the tests */
+#define BANK_NUM_ASSETS 2  /*!< Melodies of assets/melodies, after the playlist */
+#define BANK_MAX_NOTES 256 /*!< Length of the copies of the melodies decoded by the tests */
+#define PLAYLIST_LENGTH (sizeof(playlist) / sizeof(playlist[0])) /*!< Melodies of melodies.c in the bank */
+
+static const melody_t *playlist[] = {&happy_birthday_melody, &tetris_melody, &scale_melody, &spanish_anthem, &feliz_navidad_melody}; /*!< Melodies of the bank, in order */
+static uint32_t bank_copy[BANK_MAX_SIZE / sizeof(uint32_t)]; /*!< Copy of the bank, 4-byte aligned */
+static melody_codec_t codec; /*!< Codec of the packed melody read last */
+
+const melody_bank_t *p_bank; /*!< Melody bank of the jukebox */
+uint32_t bank_size;          /*!< Size of the melody bank */
+
+void setUp(void)
+{
+    const void *p_data = port_melody_bank_get(&bank_size);
+    p_bank = melody_bank_open(p_data, bank_size);
+    memcpy(bank_copy, p_data, bank_size);
+}
+
+void tearDown(void)
+{
+}
+
+/**
+ * @brief Read a melody of the bank, packed or not.
+ */
+static bool _get_melody(uint32_t index, melody_t *p_melody)
+{
+    return melody_bank_get_melody(p_bank, index, p_melody) || melody_bank_get_packed(p_bank, index, &codec, p_melody);
+}
+
+/**
+ * @brief Read a melody of the bank with its notes and durations decoded in RAM.
+ */
+static void _get_decoded(uint32_t index, melody_t *p_melody)
+{
+    static uint8_t midi_notes[BANK_MAX_NOTES];
+    static uint8_t ticks[BANK_MAX_NOTES];
+    _get_melody(index, p_melody);
+    UNITY_TEST_ASSERT_TRUE(p_melody->melody_length <= BANK_MAX_NOTES, __LINE__, "ERROR: BANK_MAX_NOTES is too small for the melodies of the bank");
+    UNITY_TEST_ASSERT_TRUE(melody_decode(p_melody, midi_notes, ticks), __LINE__, "ERROR: Every melody of the bank must be decoded");
+    p_melody->p_midi_notes = midi_notes;
+    p_melody->p_ticks = ticks;
+    p_melody->p_codec = NULL;
+}
+
+void test_bank_valid(void)
+{
+    UNITY_TEST_ASSERT_TRUE(p_bank != NULL, __LINE__, "ERROR: The melody bank of the jukebox must be valid");
+    UNITY_TEST_ASSERT_TRUE(bank_size <= BANK_MAX_SIZE, __LINE__, "ERROR: BANK_MAX_SIZE is too small for the melody bank");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(PLAYLIST_LENGTH + BANK_NUM_ASSETS, melody_bank_get_length(p_bank), __LINE__, "ERROR: The bank must hold the melodies of the jukebox and the melody assets");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(0, melody_bank_get_length(NULL), __LINE__, "ERROR: No bank must have no melodies");
+}
+
+void test_bank_melodies(void)
+{
+    for (uint32_t i = 0; i < PLAYLIST_LENGTH; i++)
+    {
+        melody_t melody;
+        UNITY_TEST_ASSERT_TRUE(melody_bank_get_melody(p_bank, i, &melody), __LINE__, "ERROR: Every melody of the bank must be read");
+        UNITY_TEST_ASSERT_TRUE(melody_is_compact(&melody), __LINE__, "ERROR: The melodies of the bank must be compact");
+        UNITY_TEST_ASSERT_EQUAL_STRING(playlist[i]->p_name, melody.p_name, __LINE__, "ERROR: The melodies of the bank must keep the order of the playlist");
+        UNITY_TEST_ASSERT_EQUAL_UINT32(playlist[i]->melody_length, melody.melody_length, __LINE__, "ERROR: Wrong length of a melody of the bank");
+        for (uint32_t j = 0; j < melody.melody_length; j++)
+        {
+            UNITY_TEST_ASSERT_EQUAL_UINT32(melody_get_note_q16(playlist[i], j), melody_get_note_q16(&melody, j), __LINE__, "ERROR: Wrong note of a melody of the bank");
+            UNITY_TEST_ASSERT_EQUAL_UINT32(melody_get_duration_ms(playlist[i], j), melody_get_duration_ms(&melody, j), __LINE__, "ERROR: Wrong duration of a melody of the bank");
+        }
+        UNITY_TEST_ASSERT_TRUE((const uint8_t *)melody.p_midi_notes > (const uint8_t *)p_bank, __LINE__, "ERROR: The notes must be read in place");
+        UNITY_TEST_ASSERT_TRUE((const uint8_t *)melody.p_ticks + melody.melody_length <= (const uint8_t *)p_bank + bank_size, __LINE__, "ERROR: The notes must be read in place");
+    }
+    melody_t melody = scale_melody;
+    UNITY_TEST_ASSERT_FALSE(melody_bank_get_melody(p_bank, melody_bank_get_length(p_bank), &melody), __LINE__, "ERROR: A melody out of the bank must not be read");
+    UNITY_TEST_ASSERT_TRUE(melody.p_notes == scale_melody.p_notes, __LINE__, "ERROR: A failed read must not modify the melody");
+    UNITY_TEST_ASSERT_TRUE(melody_bank_get_name(p_bank, melody_bank_get_length(p_bank)) == NULL, __LINE__, "ERROR: A melody out of the bank has no name");
+}
+
+void test_bank_find(void)
+{
+    for (uint32_t i = 0; i < PLAYLIST_LENGTH; i++)
+    {
+        UNITY_TEST_ASSERT_EQUAL_INT(i, melody_bank_find(p_bank, playlist[i]->p_name), __LINE__, "ERROR: Every melody must be found by its name");
+    }
+    UNITY_TEST_ASSERT_EQUAL_INT(-1, melody_bank_find(p_bank, "tetri"), __LINE__, "ERROR: A prefix of a name must not be found");
+    UNITY_TEST_ASSERT_EQUAL_INT(-1, melody_bank_find(p_bank, "tetris2"), __LINE__, "ERROR: A missing name must not be found");
+    UNITY_TEST_ASSERT_EQUAL_INT(-1, melody_bank_find(p_bank, ""), __LINE__, "ERROR: An empty name must not be found");
+    UNITY_TEST_ASSERT_EQUAL_INT(-1, melody_bank_find(NULL, "tetris"), __LINE__, "ERROR: No melody must be found without a bank");
+}
+
+void test_bank_find_hash(void)
+{
+    melody_bank_t *p_copy = (melody_bank_t *)bank_copy;
+    UNITY_TEST_ASSERT_TRUE(p_bank->hash_offset != 0, __LINE__, "ERROR: The bank must be built with a perfect hash of the names");
+    // The same lookups with the perfect hash and with the binary search of a copy with no hash
+    p_copy->hash_offset = 0;
+    UNITY_TEST_ASSERT_TRUE(melody_bank_open(bank_copy, bank_size) != NULL, __LINE__, "ERROR: A bank with no perfect hash must be valid");
+    for (uint32_t i = 0; i < melody_bank_get_length(p_bank); i++)
+    {
+        const char *p_name = melody_bank_get_name(p_bank, i);
+        UNITY_TEST_ASSERT_EQUAL_INT(i, melody_bank_find(p_bank, p_name), __LINE__, "ERROR: Every melody of the bank must be found by its perfect hash");
+        UNITY_TEST_ASSERT_EQUAL_INT(i, melody_bank_find(p_copy, p_name), __LINE__, "ERROR: Every melody of the bank must be found by a binary search");
+    }
+    UNITY_TEST_ASSERT_EQUAL_INT(-1, melody_bank_find(p_bank, "Spanish"), __LINE__, "ERROR: A missing name must not be found by its hash");
+    UNITY_TEST_ASSERT_EQUAL_INT(-1, melody_bank_find(p_bank, "tetris "), __LINE__, "ERROR: A missing name must not be found by its hash");
+}
+
+void test_bank_durations(void)
+{
+    for (uint32_t i = 0; i < melody_bank_get_length(p_bank); i++)
+    {
+        melody_t melody;
+        uint32_t total_ms = 0;
+        _get_melody(i, &melody);
+        for (uint32_t j = 0; j < melody.melody_length; j++)
+        {
+            total_ms += melody_get_duration_ms(&melody, j);
+        }
+        UNITY_TEST_ASSERT_EQUAL_UINT32(total_ms, melody_bank_get_duration_ms(p_bank, i), __LINE__, "ERROR: The total duration of a melody must be the sum of its durations");
+    }
+    UNITY_TEST_ASSERT_EQUAL_UINT32(0, melody_bank_get_duration_ms(p_bank, melody_bank_get_length(p_bank)), __LINE__, "ERROR: A melody out of the bank has no duration");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(0, melody_bank_get_duration_ms(NULL, 0), __LINE__, "ERROR: No bank has no durations");
+}
+
+void test_bank_timeline(void)
+{
+    static melody_timeline_t loaded;
+    static melody_timeline_t walked;
+    for (uint32_t i = 0; i < melody_bank_get_length(p_bank); i++)
+    {
+        melody_t melody;
+        _get_melody(i, &melody);
+        UNITY_TEST_ASSERT_TRUE(melody.p_start_ms != NULL, __LINE__, "ERROR: A melody of the bank must have the start times of its notes");
+        melody_timeline_build(&loaded, &melody);
+        melody_t plain = melody;
+        plain.p_start_ms = NULL;
+        plain.timeline_stride = 0;
+        melody_timeline_build(&walked, &plain);
+        UNITY_TEST_ASSERT_EQUAL_UINT32(walked.stride, loaded.stride, __LINE__, "ERROR: The start times of the bank must have the stride of the timeline");
+        UNITY_TEST_ASSERT_EQUAL_UINT32(walked.num_entries, loaded.num_entries, __LINE__, "ERROR: The bank must have a start time per entry of the timeline");
+        for (uint32_t entry = 0; entry <= walked.num_entries; entry++)
+        {
+            UNITY_TEST_ASSERT_EQUAL_UINT32(walked.start_ms[entry], loaded.start_ms[entry], __LINE__, "ERROR: The start times of the bank must be the prefix sum of the durations");
+        }
+        UNITY_TEST_ASSERT_EQUAL_UINT32(melody_bank_get_duration_ms(p_bank, i), melody_timeline_get_total_ms(&loaded), __LINE__, "ERROR: The last start time of the bank must be the duration of the melody");
+    }
+}
+
+void test_bank_assets(void)
+{
+    melody_t melody;
+    int32_t index = melody_bank_find(p_bank, "ode_to_joy");
+    UNITY_TEST_ASSERT_EQUAL_INT(PLAYLIST_LENGTH, index, __LINE__, "ERROR: The RTTTL asset must follow the playlist, in file name order");
+    _get_decoded((uint32_t)index, &melody);
+    UNITY_TEST_ASSERT_EQUAL_UINT32(30, melody.melody_length, __LINE__, "ERROR: Wrong length of the RTTTL asset");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(MIDI_NOTE(MI, 5), melody.p_midi_notes[0], __LINE__, "ERROR: Wrong first note of the RTTTL asset");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(500, melody_get_duration_ms(&melody, 0), __LINE__, "ERROR: A quarter note at 120 bpm must last 500 ms");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(750, melody_get_duration_ms(&melody, 12), __LINE__, "ERROR: A dotted quarter note at 120 bpm must last 750 ms");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(16000, melody_bank_get_duration_ms(p_bank, index), __LINE__, "ERROR: Wrong total duration of the RTTTL asset");
+
+    index = melody_bank_find(p_bank, "twinkle_twinkle");
+    UNITY_TEST_ASSERT_EQUAL_INT(PLAYLIST_LENGTH + 1, index, __LINE__, "ERROR: The MIDI asset must follow the playlist, in file name order");
+    _get_decoded((uint32_t)index, &melody);
+    UNITY_TEST_ASSERT_EQUAL_UINT32(MIDI_NOTE(DO, 4), melody.p_midi_notes[0], __LINE__, "ERROR: The MIDI asset must play its lead track");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(MIDI_SILENCE, melody.p_midi_notes[1], __LINE__, "ERROR: The gaps of the lead track must be silences, not other tracks");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(525, melody_get_duration_ms(&melody, 0), __LINE__, "ERROR: Wrong duration of a note of the MIDI asset at 100 bpm");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(9525, melody_bank_get_duration_ms(p_bank, index), __LINE__, "ERROR: Wrong total duration of the MIDI asset");
+
+    for (uint32_t i = PLAYLIST_LENGTH; i < melody_bank_get_length(p_bank); i++)
+    {
+        _get_decoded(i, &melody);
+        for (uint32_t j = 0; j < melody.melody_length; j++)
+        {
+            uint8_t note = melody.p_midi_notes[j];
+            UNITY_TEST_ASSERT_TRUE((note == MIDI_SILENCE) || (note_table_find_midi(note) != NULL), __LINE__, "ERROR: The notes of the assets must be in the note table");
+            UNITY_TEST_ASSERT_TRUE(melody.p_ticks[j] > 0, __LINE__, "ERROR: The notes of the assets must have a duration");
+        }
+    }
+}
+
+void test_bank_packed(void)
+{
+    static uint8_t tokens[3U * BANK_MAX_NOTES];
+    melody_t melody;
+    for (uint32_t i = 0; i < PLAYLIST_LENGTH; i++)
+    {
+        UNITY_TEST_ASSERT_FALSE(melody_bank_is_packed(p_bank, i), __LINE__, "ERROR: The melodies of the playlist must not be packed");
+        UNITY_TEST_ASSERT_FALSE(melody_bank_get_packed(p_bank, i, &codec, &melody), __LINE__, "ERROR: A melody not packed must not be read as packed");
+    }
+    for (uint32_t i = PLAYLIST_LENGTH; i < melody_bank_get_length(p_bank); i++)
+    {
+        UNITY_TEST_ASSERT_TRUE(melody_bank_is_packed(p_bank, i), __LINE__, "ERROR: The melody assets must be packed");
+        UNITY_TEST_ASSERT_FALSE(melody_bank_get_melody(p_bank, i, &melody), __LINE__, "ERROR: A packed melody must not be read as notes");
+        UNITY_TEST_ASSERT_TRUE(melody_bank_get_packed(p_bank, i, &codec, &melody), __LINE__, "ERROR: A packed melody must be read with a codec");
+        UNITY_TEST_ASSERT_TRUE(melody.p_codec == &codec, __LINE__, "ERROR: A packed melody must be decoded by its codec");
+        UNITY_TEST_ASSERT_TRUE(melody_is_compact(&melody), __LINE__, "ERROR: A packed melody must be compact");
+        UNITY_TEST_ASSERT_TRUE(codec.p_data > (const uint8_t *)p_bank, __LINE__, "ERROR: The tokens must be read in place");
+        UNITY_TEST_ASSERT_TRUE(codec.p_data + codec.size <= (const uint8_t *)p_bank + bank_size, __LINE__, "ERROR: The tokens must be read in place");
+        UNITY_TEST_ASSERT_TRUE(codec.size < 2U * melody.melody_length, __LINE__, "ERROR: A melody must be packed only if its tokens are smaller");
+
+        // The builder writes the tokens of melody_codec_encode()
+        melody_t decoded;
+        _get_decoded(i, &decoded);
+        int32_t size = melody_codec_encode(decoded.p_midi_notes, decoded.p_ticks, decoded.melody_length, tokens, sizeof(tokens));
+        UNITY_TEST_ASSERT_EQUAL_INT(size, codec.size, __LINE__, "ERROR: The tokens of the bank must be the tokens of the encoder");
+        UNITY_TEST_ASSERT_EQUAL_MEMORY(tokens, codec.p_data, codec.size, __LINE__, "ERROR: The tokens of the bank must be the tokens of the encoder");
+    }
+    UNITY_TEST_ASSERT_FALSE(melody_bank_is_packed(p_bank, melody_bank_get_length(p_bank)), __LINE__, "ERROR: A melody out of the bank is not packed");
+}
+
+void test_bank_invalid(void)
+{
+    melody_bank_t *p_copy = (melody_bank_t *)bank_copy;
+    UNITY_TEST_ASSERT_TRUE(melody_bank_open(bank_copy, bank_size) != NULL, __LINE__, "ERROR: A copy of the bank must be valid");
+    UNITY_TEST_ASSERT_TRUE(melody_bank_open(bank_copy, bank_size - 1) == NULL, __LINE__, "ERROR: A truncated bank must not be valid");
+    UNITY_TEST_ASSERT_TRUE(melody_bank_open((const uint8_t *)bank_copy + 1, bank_size - 1) == NULL, __LINE__, "ERROR: A misaligned bank must not be valid");
+    UNITY_TEST_ASSERT_TRUE(melody_bank_open(NULL, bank_size) == NULL, __LINE__, "ERROR: No bank must not be valid");
+
+    p_copy->magic ^= 1U;
+    UNITY_TEST_ASSERT_TRUE(melody_bank_open(bank_copy, bank_size) == NULL, __LINE__, "ERROR: A bank with a wrong magic number must not be valid");
+    p_copy->magic ^= 1U;
+    p_copy->version++;
+    UNITY_TEST_ASSERT_TRUE(melody_bank_open(bank_copy, bank_size) == NULL, __LINE__, "ERROR: A bank of another version must not be valid");
+    p_copy->version--;
+
+    melody_bank_entry_t *p_entry = (melody_bank_entry_t *)(p_copy + 1);
+    p_entry->melody_length = UINT16_MAX;
+    UNITY_TEST_ASSERT_TRUE(melody_bank_open(bank_copy, bank_size) == NULL, __LINE__, "ERROR: A melody out of the bank must not be valid");
+    memcpy(bank_copy, p_bank, bank_size);
+    p_entry->name_offset = bank_size;
+    UNITY_TEST_ASSERT_TRUE(melody_bank_open(bank_copy, bank_size) == NULL, __LINE__, "ERROR: A name out of the bank must not be valid");
+    memcpy(bank_copy, p_bank, bank_size);
+    ((uint16_t *)((uint8_t *)bank_copy + p_copy->index_offset))[0] = p_copy->num_melodies;
+    UNITY_TEST_ASSERT_TRUE(melody_bank_open(bank_copy, bank_size) == NULL, __LINE__, "ERROR: A name index out of the entries must not be valid");
+    memcpy(bank_copy, p_bank, bank_size);
+    ((uint16_t *)((uint8_t *)bank_copy + p_copy->hash_offset))[p_copy->hash_buckets] = p_copy->num_melodies;
+    UNITY_TEST_ASSERT_TRUE(melody_bank_open(bank_copy, bank_size) == NULL, __LINE__, "ERROR: A slot of the perfect hash out of the entries must not be valid");
+    memcpy(bank_copy, p_bank, bank_size);
+    p_entry->timeline_offset = bank_size - sizeof(uint32_t);
+    UNITY_TEST_ASSERT_TRUE(melody_bank_open(bank_copy, bank_size) == NULL, __LINE__, "ERROR: Start times out of the bank must not be valid");
+    memcpy(bank_copy, p_bank, bank_size);
+    p_entry[PLAYLIST_LENGTH].packed_size = bank_size;
+    UNITY_TEST_ASSERT_TRUE(melody_bank_open(bank_copy, bank_size) == NULL, __LINE__, "ERROR: Tokens out of the bank must not be valid");
+    memcpy(bank_copy, p_bank, bank_size);
+    p_entry[PLAYLIST_LENGTH].packed_size = 0;
+    UNITY_TEST_ASSERT_TRUE(melody_bank_open(bank_copy, bank_size) == NULL, __LINE__, "ERROR: A packed melody with no tokens must not be valid");
+    memcpy(bank_copy, p_bank, bank_size);
+    p_copy->hash_buckets = bank_size;
+    UNITY_TEST_ASSERT_TRUE(melody_bank_open(bank_copy, bank_size) == NULL, __LINE__, "ERROR: A perfect hash out of the bank must not be valid");
+}
+
+void test_fsm_plays_bank_melody(void)
+{
+    melody_t melody;
+    fsm_t *p_fsm_buzzer = fsm_buzzer_new(BUZZER_0_ID);
+    melody_bank_get_melody(p_bank, melody_bank_find(p_bank, "tetris"), &melody);
+    fsm_buzzer_set_melody(p_fsm_buzzer, &melody);
+    fsm_buzzer_set_action(p_fsm_buzzer, PLAY);
+    fsm_fire(p_fsm_buzzer);
+    port_buzzer_note_regs_t regs;
+    port_buzzer_get_note_regs_q16(PORT_BUZZER_HZ_Q16(MI5), melody_get_duration_ms(&tetris_melody, 0) * 1000U, &regs);
+    UNITY_TEST_ASSERT_EQUAL_UINT32(regs.pwm_psc, TIM3->PSC, __LINE__, "ERROR: The first note of the melody of the bank must be played");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(regs.pwm_arr, TIM3->ARR, __LINE__, "ERROR: The first note of the melody of the bank must be played");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(regs.duration_arr, TIM2->ARR, __LINE__, "ERROR: The first note of the melody of the bank must last its duration");
+    port_buzzer_stop(BUZZER_0_ID);
+    fsm_destroy(p_fsm_buzzer);
+}
+
+int main(void)
+{
+    port_system_init();
+    UNITY_BEGIN();
+    RUN_TEST(test_bank_valid);
+    RUN_TEST(test_bank_melodies);
+    RUN_TEST(test_bank_find);
+    RUN_TEST(test_bank_find_hash);
+    RUN_TEST(test_bank_durations);
+    RUN_TEST(test_bank_timeline);
+    RUN_TEST(test_bank_assets);
+    RUN_TEST(test_bank_packed);
+    RUN_TEST(test_bank_invalid);
+    RUN_TEST(test_fsm_plays_bank_melody);
+    return UNITY_END();
+}
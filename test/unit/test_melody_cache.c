@@ -0,0 +1,114 @@
+#include <unity.h>
+#include <string.h>
+#include "port_system.h"
+#include "melodies.h"
+#include "melody_cache.h"
+
+static melody_cache_t cache;                    /*!< Cache under test */
+static melody_t view;                           /*!< View of the melody playing, never evicted by the cache */
+static uint8_t midi_notes[MELODY_CACHE_SLOT_NOTES + 1U]; /*!< MIDI note numbers of the source melodies */
+static uint8_t ticks[MELODY_CACHE_SLOT_NOTES + 1U];      /*!< Durations of the source melodies */
+
+void setUp(void)
+{
+    memset(&view, 0, sizeof(view));
+    melody_cache_init(&cache, &view);
+}
+
+void tearDown(void)
+{
+}
+
+/**
+ * @brief Get a compact source melody whose notes all depend on its id, and store it in the cache.
+ */
+static bool _store(uint32_t id, uint32_t length, melody_t *p_melody)
+{
+    for (uint32_t i = 0; i < length; i++)
+    {
+        midi_notes[i] = (uint8_t)(40U + id);
+        ticks[i] = (uint8_t)(1U + i % 8U);
+    }
+    melody_t source = {.p_name = "source", .p_midi_notes = midi_notes, .p_ticks = ticks, .melody_length = (uint16_t)length, .tick_ms = 25};
+    return melody_cache_store(&cache, id, &source, p_melody);
+}
+
+void test_cache_hit_miss(void)
+{
+    melody_t melody;
+    UNITY_TEST_ASSERT_FALSE(melody_cache_get(&cache, 3, &melody), __LINE__, "ERROR: A melody not stored must not be found");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(1, cache.misses, __LINE__, "ERROR: A lookup of a melody not stored must count a miss");
+
+    UNITY_TEST_ASSERT_TRUE(_store(3, 10, &melody), __LINE__, "ERROR: A melody must be stored");
+    memset(midi_notes, 0, sizeof(midi_notes));
+    UNITY_TEST_ASSERT_TRUE(melody_cache_get(&cache, 3, &melody), __LINE__, "ERROR: A melody stored must be found");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(1, cache.hits, __LINE__, "ERROR: A lookup of a melody stored must count a hit");
+    UNITY_TEST_ASSERT_TRUE(melody_is_compact(&melody), __LINE__, "ERROR: A melody of the cache must be compact");
+    UNITY_TEST_ASSERT_EQUAL_STRING("source", melody.p_name, __LINE__, "ERROR: A melody of the cache must keep its name");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(10, melody.melody_length, __LINE__, "ERROR: A melody of the cache must keep its length");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(25, melody.tick_ms, __LINE__, "ERROR: A melody of the cache must keep its tick");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(43, melody.p_midi_notes[9], __LINE__, "ERROR: A melody of the cache must own a copy of its notes");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(2, melody.p_ticks[9], __LINE__, "ERROR: A melody of the cache must own a copy of its durations");
+}
+
+void test_cache_lru_eviction(void)
+{
+    melody_t melody;
+    for (uint32_t id = 0; id < MELODY_CACHE_NUM_SLOTS; id++)
+    {
+        UNITY_TEST_ASSERT_TRUE(_store(id, 4, &melody), __LINE__, "ERROR: A melody must be stored in a free slot");
+    }
+    UNITY_TEST_ASSERT_EQUAL_UINT32(0, cache.evictions, __LINE__, "ERROR: Free slots must be used before evicting");
+
+    // Melody 0 is used again: melody 1 is the least recently used
+    melody_cache_get(&cache, 0, &melody);
+    UNITY_TEST_ASSERT_TRUE(_store(MELODY_CACHE_NUM_SLOTS, 4, &melody), __LINE__, "ERROR: A melody must be stored in a full cache");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(1, cache.evictions, __LINE__, "ERROR: Storing in a full cache must count an eviction");
+    UNITY_TEST_ASSERT_FALSE(melody_cache_get(&cache, 1, &melody), __LINE__, "ERROR: The least recently used melody must be evicted");
+    UNITY_TEST_ASSERT_TRUE(melody_cache_get(&cache, 0, &melody), __LINE__, "ERROR: A melody used lately must not be evicted");
+
+    // Storing a melody again replaces it, it does not evict another one
+    UNITY_TEST_ASSERT_TRUE(_store(2, 6, &melody), __LINE__, "ERROR: A melody must be stored again");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(1, cache.evictions, __LINE__, "ERROR: Storing a melody again must not count an eviction");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(6, melody.melody_length, __LINE__, "ERROR: A melody stored again must be replaced");
+}
+
+void test_cache_view_pinned(void)
+{
+    // The view plays melody 0, the least recently used: the next one is evicted instead
+    UNITY_TEST_ASSERT_TRUE(_store(0, 4, &view), __LINE__, "ERROR: A melody must be stored into the view");
+    for (uint32_t id = 1; id <= MELODY_CACHE_NUM_SLOTS; id++)
+    {
+        _store(id, 4, &(melody_t){0});
+    }
+    UNITY_TEST_ASSERT_EQUAL_UINT32(40, view.p_midi_notes[0], __LINE__, "ERROR: The notes of the melody playing must not be overwritten");
+    UNITY_TEST_ASSERT_TRUE(melody_cache_get(&cache, 0, &(melody_t){0}), __LINE__, "ERROR: The melody playing must not be evicted");
+    UNITY_TEST_ASSERT_FALSE(melody_cache_get(&cache, 1, &(melody_t){0}), __LINE__, "ERROR: The least recently used melody not playing must be evicted");
+
+    // A clear keeps the melody playing only
+    melody_cache_clear(&cache);
+    UNITY_TEST_ASSERT_TRUE(melody_cache_get(&cache, 0, &(melody_t){0}), __LINE__, "ERROR: The melody playing must not be cleared");
+    UNITY_TEST_ASSERT_FALSE(melody_cache_get(&cache, MELODY_CACHE_NUM_SLOTS, &(melody_t){0}), __LINE__, "ERROR: The melodies not playing must be cleared");
+}
+
+void test_cache_rejected(void)
+{
+    melody_t melody = {0};
+    UNITY_TEST_ASSERT_FALSE(_store(0, MELODY_CACHE_SLOT_NOTES + 1U, &melody), __LINE__, "ERROR: A melody longer than a slot must not be stored");
+    double notes[] = {440.0};
+    uint16_t durations[] = {100};
+    melody_t hz = {.p_name = "hz", .p_notes = notes, .p_durations = durations, .melody_length = 1};
+    UNITY_TEST_ASSERT_FALSE(melody_cache_store(&cache, 0, &hz, &melody), __LINE__, "ERROR: A melody in Hz must not be stored");
+    UNITY_TEST_ASSERT_FALSE(melody_cache_get(&cache, 0, &melody), __LINE__, "ERROR: A melody rejected must not be found");
+}
+
+int main(void)
+{
+    port_system_init();
+    UNITY_BEGIN();
+    RUN_TEST(test_cache_hit_miss);
+    RUN_TEST(test_cache_lru_eviction);
+    RUN_TEST(test_cache_view_pinned);
+    RUN_TEST(test_cache_rejected);
+    return UNITY_END();
+}
@@ -0,0 +1,166 @@
+#include <unity.h>
+#include <string.h>
+#include "port_system.h"
+#include "port_buzzer.h"
+#include "fsm_buzzer.h"
+#include "melodies.h"
+#include "melody_codec.h"
+
+#define TEST_MAX_NOTES 256U /*!< Maximum number of notes of the melodies of the tests */
+
+static uint8_t data[3U * TEST_MAX_NOTES]; /*!< Tokens of the melody packed */
+static melody_codec_t codec;              /*!< Codec under test */
+static melody_t packed;                   /*!< Melody packed */
+
+void setUp(void)
+{
+    memset(data, 0, sizeof(data));
+}
+
+void tearDown(void)
+{
+}
+
+/**
+ * @brief Pack a compact melody into the melody of the tests.
+ */
+static int32_t _pack(const uint8_t *p_midi_notes, const uint8_t *p_ticks, uint32_t length, uint16_t tick_ms)
+{
+    int32_t size = melody_codec_encode(p_midi_notes, p_ticks, length, data, sizeof(data));
+    if (size >= 0)
+    {
+        melody_codec_init(&codec, data, (uint32_t)size, (uint16_t)length);
+        packed = (melody_t){.p_name = "packed", .p_codec = &codec, .melody_length = (uint16_t)length, .tick_ms = tick_ms};
+    }
+    return size;
+}
+
+/**
+ * @brief Check every note of the melody packed against the notes of the original, in order.
+ */
+static void _check_notes(const melody_t *p_expected, uint32_t line)
+{
+    for (uint32_t note = 0; note < p_expected->melody_length; note++)
+    {
+        UNITY_TEST_ASSERT_EQUAL_UINT32(melody_get_note_q16(p_expected, note), melody_get_note_q16(&packed, note), line, "ERROR: A melody packed must have its notes");
+        UNITY_TEST_ASSERT_EQUAL_UINT32(melody_get_duration_ms(p_expected, note), melody_get_duration_ms(&packed, note), line, "ERROR: A melody packed must have its durations");
+    }
+}
+
+void test_codec_melodies(void)
+{
+    const melody_t *melodies[] = {&happy_birthday_melody, &tetris_melody, &spanish_anthem, &feliz_navidad_melody};
+    for (uint32_t i = 0; i < sizeof(melodies) / sizeof(melodies[0]); i++)
+    {
+        const melody_t *p_melody = melodies[i];
+        int32_t size = _pack(p_melody->p_midi_notes, p_melody->p_ticks, p_melody->melody_length, p_melody->tick_ms);
+        UNITY_TEST_ASSERT_TRUE(size > 0, __LINE__, "ERROR: A compact melody must be packed");
+        UNITY_TEST_ASSERT_TRUE((uint32_t)size < melody_get_size(p_melody, true), __LINE__, "ERROR: A melody packed must be smaller than the compact melody");
+        UNITY_TEST_ASSERT_TRUE(melody_is_compact(&packed), __LINE__, "ERROR: A melody packed must be compact");
+        _check_notes(p_melody, __LINE__);
+
+        // As the melody cache decodes it
+        uint8_t midi_notes[TEST_MAX_NOTES];
+        uint8_t ticks[TEST_MAX_NOTES];
+        UNITY_TEST_ASSERT_TRUE(melody_decode(&packed, midi_notes, ticks), __LINE__, "ERROR: A melody packed must be decoded at once");
+        UNITY_TEST_ASSERT_EQUAL_MEMORY(p_melody->p_midi_notes, midi_notes, p_melody->melody_length, __LINE__, "ERROR: A melody packed must be decoded to its notes");
+        UNITY_TEST_ASSERT_EQUAL_MEMORY(p_melody->p_ticks, ticks, p_melody->melody_length, __LINE__, "ERROR: A melody packed must be decoded to its ticks");
+    }
+}
+
+void test_codec_tokens(void)
+{
+    // A run, a silence, a jump out of the range of the deltas and a repeated phrase
+    const uint8_t midi_notes[] = {60, 62, 64, 64, 64, 64, MIDI_SILENCE, 100, 20, 60, 62, 64, 64, 64, 64, MIDI_SILENCE};
+    const uint8_t ticks[] = {1, 1, 2, 2, 2, 2, 4, 4, 4, 1, 1, 2, 2, 2, 2, 4};
+    uint32_t length = sizeof(midi_notes);
+    int32_t size = _pack(midi_notes, ticks, length, 10);
+    UNITY_TEST_ASSERT_TRUE(size > 0, __LINE__, "ERROR: The melody must be packed");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(MELODY_CODEC_NOTE_TICKS | MELODY_CODEC_DELTA_BIAS, data[0], __LINE__, "ERROR: The first note must be a delta from the initial pitch with its ticks");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(MELODY_CODEC_RUN | 2U, data[5], __LINE__, "ERROR: A note repeated must be a run");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(MELODY_CODEC_SILENCE_TICKS, data[6], __LINE__, "ERROR: A silence must be a silence token");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(MELODY_CODEC_ABSOLUTE, data[8], __LINE__, "ERROR: A jump out of the range of the deltas must be an absolute note");
+    UNITY_TEST_ASSERT_TRUE(data[size - 3] >= MELODY_CODEC_BACKREF, __LINE__, "ERROR: A phrase repeated must be a back-reference");
+    for (uint32_t note = 0; note < length; note++)
+    {
+        uint8_t midi_note;
+        uint8_t note_ticks;
+        UNITY_TEST_ASSERT_TRUE(melody_codec_get_note(&codec, note, &midi_note, &note_ticks), __LINE__, "ERROR: Every note must be decoded");
+        UNITY_TEST_ASSERT_EQUAL_UINT32(midi_notes[note], midi_note, __LINE__, "ERROR: A note must be decoded");
+        UNITY_TEST_ASSERT_EQUAL_UINT32(ticks[note], note_ticks, __LINE__, "ERROR: The ticks of a note must be decoded");
+    }
+    UNITY_TEST_ASSERT_FALSE(melody_codec_get_note(&codec, length, &(uint8_t){0}, &(uint8_t){0}), __LINE__, "ERROR: A note out of the melody must not be decoded");
+}
+
+void test_codec_random_access(void)
+{
+    const melody_t *p_melody = &spanish_anthem;
+    _pack(p_melody->p_midi_notes, p_melody->p_ticks, p_melody->melody_length, p_melody->tick_ms);
+    const uint32_t order[] = {40, 41, 40, 10, 11, 12, 0, p_melody->melody_length - 1U, 5};
+    for (uint32_t i = 0; i < sizeof(order) / sizeof(order[0]); i++)
+    {
+        uint32_t note = order[i];
+        UNITY_TEST_ASSERT_EQUAL_UINT32(melody_get_duration_ms(p_melody, note), melody_get_duration_ms(&packed, note), __LINE__, "ERROR: A note read out of order must be decoded");
+        UNITY_TEST_ASSERT_EQUAL_UINT32(melody_get_note_q16(p_melody, note), melody_get_note_q16(&packed, note), __LINE__, "ERROR: A note read out of order must be decoded");
+    }
+}
+
+void test_codec_invalid(void)
+{
+    uint8_t midi_note;
+    uint8_t ticks;
+    const uint8_t forward[] = {MELODY_CODEC_NOTE_TICKS | MELODY_CODEC_DELTA_BIAS, 1, MELODY_CODEC_BACKREF, 8, 0};
+    melody_codec_init(&codec, forward, sizeof(forward), 3);
+    UNITY_TEST_ASSERT_TRUE(melody_codec_get_note(&codec, 0, &midi_note, &ticks), __LINE__, "ERROR: A valid note must be decoded");
+    UNITY_TEST_ASSERT_FALSE(melody_codec_get_note(&codec, 1, &midi_note, &ticks), __LINE__, "ERROR: A back-reference forwards must not be decoded");
+
+    const uint8_t nested[] = {MELODY_CODEC_BACKREF, 0, 0, MELODY_CODEC_BACKREF, 0, 0};
+    melody_codec_init(&codec, nested, sizeof(nested), 4);
+    UNITY_TEST_ASSERT_FALSE(melody_codec_get_note(&codec, 0, &midi_note, &ticks), __LINE__, "ERROR: A back-reference to a back-reference must not be decoded");
+
+    const uint8_t run_first[] = {MELODY_CODEC_RUN | 1U};
+    melody_codec_init(&codec, run_first, sizeof(run_first), 2);
+    UNITY_TEST_ASSERT_FALSE(melody_codec_get_note(&codec, 0, &midi_note, &ticks), __LINE__, "ERROR: A run with no note before must not be decoded");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(0, ticks, __LINE__, "ERROR: A note not decoded must be a silence of no duration");
+
+    UNITY_TEST_ASSERT_EQUAL_INT(-1, melody_codec_encode(spanish_anthem.p_midi_notes, spanish_anthem.p_ticks, spanish_anthem.melody_length, data, 4), __LINE__, "ERROR: A melody must not be packed into a buffer too small");
+}
+
+void test_codec_plays(void)
+{
+    const melody_t *p_melody = &spanish_anthem;
+    _pack(p_melody->p_midi_notes, p_melody->p_ticks, p_melody->melody_length, p_melody->tick_ms);
+    fsm_t *p_fsm_buzzer = fsm_buzzer_new(BUZZER_0_ID);
+    // Modes of the jukebox: a melody packed is not played by DMA
+    fsm_buzzer_set_sequencer(p_fsm_buzzer, true);
+    fsm_buzzer_set_dma(p_fsm_buzzer, true);
+    fsm_buzzer_set_absolute_time(p_fsm_buzzer, true);
+    fsm_buzzer_set_melody(p_fsm_buzzer, &packed);
+    uint32_t elapsed_ms;
+    uint32_t total_ms;
+    fsm_buzzer_get_progress(p_fsm_buzzer, &elapsed_ms, &total_ms);
+    UNITY_TEST_ASSERT_EQUAL_UINT32(0, codec.position, __LINE__, "ERROR: The codec must be rewound once the duration of the melody is known");
+
+    fsm_buzzer_set_action(p_fsm_buzzer, PLAY);
+    uint32_t start = port_system_get_millis();
+    while ((fsm_buzzer_get_action(p_fsm_buzzer) == PLAY) && (port_system_get_millis() - start < 2U * total_ms))
+    {
+        fsm_fire(p_fsm_buzzer);
+    }
+    UNITY_TEST_ASSERT_EQUAL_INT(STOP, fsm_buzzer_get_action(p_fsm_buzzer), __LINE__, "ERROR: A melody packed must play to its end");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(p_melody->melody_length - 1U, codec.index, __LINE__, "ERROR: A melody packed must be decoded note by note while it plays");
+    port_buzzer_stop(BUZZER_0_ID);
+    fsm_destroy(p_fsm_buzzer);
+}
+
+int main(void)
+{
+    port_system_init();
+    UNITY_BEGIN();
+    RUN_TEST(test_codec_melodies);
+    RUN_TEST(test_codec_tokens);
+    RUN_TEST(test_codec_random_access);
+    RUN_TEST(test_codec_invalid);
+    RUN_TEST(test_codec_plays);
+    return UNITY_END();
+}
@@ -0,0 +1,237 @@
+#include <unity.h>
+#include <string.h>
+#include "port_system.h"
+#include "port_buzzer.h"
+#include "fsm_buzzer.h"
+#include "melodies.h"
+#include "melody_pool.h"
+#include "melody_upload.h"
+#include "note_table.h"
+
+static melody_pool_t pool;     /*!< Pool under test */
+static melody_upload_t upload; /*!< Upload decoder under test */
+static melody_t view;          /*!< View of the melody playing, kept valid by the pool */
+static uint32_t holds;         /*!< Number of times the pool has held the player */
+static bool held;              /*!< The pool holds the player */
+static bool masked;            /*!< The interrupt of the player was masked while it was held */
+
+void setUp(void)
+{
+    memset(&view, 0, sizeof(view));
+    holds = 0;
+    held = false;
+    masked = false;
+    melody_pool_init(&pool, &view);
+    melody_upload_init(&upload, &pool);
+}
+
+void tearDown(void)
+{
+}
+
+/**
+ * @brief Store a melody of a number of notes with the same note and ticks.
+ */
+static int32_t _store(const char *p_name, uint32_t length, uint8_t midi_note)
+{
+    if (!melody_pool_begin(&pool, p_name))
+    {
+        return -1;
+    }
+    for (uint32_t i = 0; i < length; i++)
+    {
+        if (!melody_pool_append(&pool, midi_note, (uint8_t)(i + 1U)))
+        {
+            melody_pool_abort(&pool);
+            return -1;
+        }
+    }
+    return melody_pool_commit(&pool, 10);
+}
+
+/**
+ * @brief Hold function of the pool: hold the player and record the state of its interrupt.
+ */
+static void _hold(void *p_arg, bool hold)
+{
+    fsm_buzzer_hold((fsm_t *)p_arg, hold);
+    if (hold)
+    {
+        holds++;
+        masked = (TIM2->DIER & TIM_DIER_UIE) == 0;
+    }
+    held = hold;
+}
+
+void test_upload_rtttl(void)
+{
+    melody_t melody;
+    UNITY_TEST_ASSERT_TRUE(melody_upload_begin(&upload, "joy", 0), __LINE__, "ERROR: An RTTTL upload must start");
+    UNITY_TEST_ASSERT_TRUE(melody_upload_feed(&upload, "joy:d=4,o=5,b=12"), __LINE__, "ERROR: The name and defaults must be decoded");
+    UNITY_TEST_ASSERT_TRUE(melody_upload_feed(&upload, "0:e,8f#,2"), __LINE__, "ERROR: A token split between chunks must be decoded");
+    UNITY_TEST_ASSERT_TRUE(melody_upload_feed(&upload, "g.,p,C6"), __LINE__, "ERROR: Pauses and uppercase notes must be decoded");
+    UNITY_TEST_ASSERT_EQUAL_INT(0, melody_upload_end(&upload), __LINE__, "ERROR: The melody must be stored in the pool");
+    UNITY_TEST_ASSERT_FALSE(melody_upload_is_active(&upload), __LINE__, "ERROR: The upload must be finished");
+
+    UNITY_TEST_ASSERT_TRUE(melody_pool_get_melody(&pool, 0, &melody), __LINE__, "ERROR: The melody uploaded must be read");
+    UNITY_TEST_ASSERT_EQUAL_STRING("joy", melody.p_name, __LINE__, "ERROR: The melody must have the name of the upload");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(5, melody.melody_length, __LINE__, "ERROR: Wrong length of the melody uploaded");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(MIDI_NOTE(MI, 5), melody.p_midi_notes[0], __LINE__, "ERROR: Wrong note of the melody uploaded");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(MIDI_NOTE(FAs, 5), melody.p_midi_notes[1], __LINE__, "ERROR: Wrong sharp note of the melody uploaded");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(MIDI_NOTE(SOL, 5), melody.p_midi_notes[2], __LINE__, "ERROR: Wrong note of the melody uploaded");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(MIDI_SILENCE, melody.p_midi_notes[3], __LINE__, "ERROR: A pause must be a silence");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(MIDI_NOTE(DO, 6), melody.p_midi_notes[4], __LINE__, "ERROR: Wrong note with octave of the melody uploaded");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(500, melody_get_duration_ms(&melody, 0), __LINE__, "ERROR: A quarter note at 120 bpm must last 500 ms");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(250, melody_get_duration_ms(&melody, 1), __LINE__, "ERROR: An eighth note at 120 bpm must last 250 ms");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(1500, melody_get_duration_ms(&melody, 2), __LINE__, "ERROR: A dotted half note at 120 bpm must last 1500 ms");
+}
+
+void test_upload_hex(void)
+{
+    melody_t melody;
+    UNITY_TEST_ASSERT_TRUE(melody_upload_begin(&upload, "hex", 100), __LINE__, "ERROR: A hexadecimal upload must start");
+    UNITY_TEST_ASSERT_TRUE(melody_upload_feed(&upload, "3C04 3e"), __LINE__, "ERROR: Pairs must be decoded");
+    UNITY_TEST_ASSERT_TRUE(melody_upload_feed(&upload, "02,0001 0C01 7F01"), __LINE__, "ERROR: A pair split between chunks must be decoded");
+    UNITY_TEST_ASSERT_EQUAL_INT(0, melody_upload_end(&upload), __LINE__, "ERROR: The melody must be stored in the pool");
+    melody_pool_get_melody(&pool, 0, &melody);
+    UNITY_TEST_ASSERT_EQUAL_UINT32(5, melody.melody_length, __LINE__, "ERROR: Wrong length of the melody uploaded");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(60, melody.p_midi_notes[0], __LINE__, "ERROR: Wrong note of the melody uploaded");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(200, melody_get_duration_ms(&melody, 1), __LINE__, "ERROR: Wrong duration of the melody uploaded");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(MIDI_SILENCE, melody.p_midi_notes[2], __LINE__, "ERROR: Note 0 must be a silence");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(MIDI_NOTE(DO, 1), melody.p_midi_notes[3], __LINE__, "ERROR: A low note must be moved up by octaves into the note table");
+    UNITY_TEST_ASSERT_TRUE(note_table_find_midi(melody.p_midi_notes[4]) != NULL, __LINE__, "ERROR: A high note must be moved down by octaves into the note table");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(127 % 12, melody.p_midi_notes[4] % 12, __LINE__, "ERROR: A note moved into the note table must keep its pitch class");
+}
+
+void test_upload_errors(void)
+{
+    UNITY_TEST_ASSERT_FALSE(melody_upload_feed(&upload, "3C04"), __LINE__, "ERROR: Data with no upload must fail");
+    UNITY_TEST_ASSERT_FALSE(melody_upload_begin(&upload, "a_name_that_is_too_long", 0), __LINE__, "ERROR: A long name must fail");
+    UNITY_TEST_ASSERT_FALSE(melody_upload_begin(&upload, "", 0), __LINE__, "ERROR: An empty name must fail");
+
+    melody_upload_begin(&upload, "bad", 0);
+    UNITY_TEST_ASSERT_FALSE(melody_upload_feed(&upload, "d=4,o=5,b=120:e,3x,"), __LINE__, "ERROR: A wrong note must fail");
+    UNITY_TEST_ASSERT_FALSE(melody_upload_is_active(&upload), __LINE__, "ERROR: A wrong note must abort the upload");
+    melody_upload_begin(&upload, "bad", 0);
+    UNITY_TEST_ASSERT_FALSE(melody_upload_feed(&upload, "d=3:e"), __LINE__, "ERROR: A wrong default must fail");
+    melody_upload_begin(&upload, "bad", 10);
+    UNITY_TEST_ASSERT_FALSE(melody_upload_feed(&upload, "3C00"), __LINE__, "ERROR: A note of no ticks must fail");
+    melody_upload_begin(&upload, "bad", 10);
+    melody_upload_feed(&upload, "3C0");
+    UNITY_TEST_ASSERT_EQUAL_INT(-1, melody_upload_end(&upload), __LINE__, "ERROR: An incomplete pair must fail");
+    melody_upload_begin(&upload, "bad", 0);
+    UNITY_TEST_ASSERT_EQUAL_INT(-1, melody_upload_end(&upload), __LINE__, "ERROR: A melody with no notes must fail");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(0, melody_pool_get_length(&pool), __LINE__, "ERROR: Failed uploads must not be stored");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(0, pool.used, __LINE__, "ERROR: Failed uploads must not use the arena");
+}
+
+void test_pool_eviction(void)
+{
+    melody_t melody;
+    uint32_t length = MELODY_POOL_ARENA_SIZE / 8U; // Four melodies fill the arena
+    UNITY_TEST_ASSERT_EQUAL_INT(0, _store("a", length, 60), __LINE__, "ERROR: A melody must be stored");
+    UNITY_TEST_ASSERT_EQUAL_INT(1, _store("b", length, 62), __LINE__, "ERROR: A melody must be stored");
+    UNITY_TEST_ASSERT_EQUAL_INT(2, _store("c", length, 64), __LINE__, "ERROR: A melody must be stored");
+    UNITY_TEST_ASSERT_EQUAL_INT(3, _store("d", length, 65), __LINE__, "ERROR: A melody must be stored");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(0, melody_pool_get_evictions(&pool), __LINE__, "ERROR: No melody must be evicted while there is room");
+
+    // "a" is used, so "b" is the least recently used melody
+    melody_pool_get_melody(&pool, 0, &melody);
+    UNITY_TEST_ASSERT_TRUE(_store("e", 1, 67) >= 0, __LINE__, "ERROR: A melody must be stored when the arena is full");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(1, melody_pool_get_evictions(&pool), __LINE__, "ERROR: One melody must be evicted");
+    UNITY_TEST_ASSERT_EQUAL_INT(-1, melody_pool_find(&pool, "b"), __LINE__, "ERROR: The least recently used melody must be evicted");
+    UNITY_TEST_ASSERT_TRUE(melody_pool_find(&pool, "a") >= 0, __LINE__, "ERROR: A melody used must not be evicted");
+
+    // The arena is compacted: the melodies after the evicted one keep their notes
+    melody_pool_get_melody(&pool, (uint32_t)melody_pool_find(&pool, "d"), &melody);
+    UNITY_TEST_ASSERT_EQUAL_UINT32(length, melody.melody_length, __LINE__, "ERROR: A moved melody must keep its length");
+    for (uint32_t i = 0; i < length; i++)
+    {
+        UNITY_TEST_ASSERT_EQUAL_UINT32(65, melody.p_midi_notes[i], __LINE__, "ERROR: A moved melody must keep its notes");
+        UNITY_TEST_ASSERT_EQUAL_UINT32(i + 1U, melody.p_ticks[i], __LINE__, "ERROR: A moved melody must keep its ticks");
+    }
+
+    // Replacing a melody frees its notes
+    UNITY_TEST_ASSERT_TRUE(_store("e", 2, 69) >= 0, __LINE__, "ERROR: A melody must be replaced");
+    melody_pool_get_melody(&pool, (uint32_t)melody_pool_find(&pool, "e"), &melody);
+    UNITY_TEST_ASSERT_EQUAL_UINT32(2, melody.melody_length, __LINE__, "ERROR: The melody replaced must have the new notes");
+}
+
+void test_pool_playing_melody(void)
+{
+    uint32_t length = MELODY_POOL_ARENA_SIZE / 4U; // Two melodies fill the arena
+    _store("a", length, 60);
+    _store("b", length, 62);
+    melody_pool_get_melody(&pool, 1, &view);
+    melody_pool_get_melody(&pool, 0, &(melody_t){0}); // "b" is the least recently used, but it is playing
+
+    fsm_t *p_fsm_buzzer = fsm_buzzer_new(BUZZER_0_ID);
+    fsm_buzzer_set_melody(p_fsm_buzzer, &view);
+    fsm_buzzer_set_action(p_fsm_buzzer, PLAY);
+    fsm_fire(p_fsm_buzzer);
+
+    UNITY_TEST_ASSERT_TRUE(_store("c", 1, 64) >= 0, __LINE__, "ERROR: A melody must be stored while another one is playing");
+    UNITY_TEST_ASSERT_EQUAL_INT(-1, melody_pool_find(&pool, "a"), __LINE__, "ERROR: The melody playing must not be evicted");
+    UNITY_TEST_ASSERT_TRUE(view.p_midi_notes == pool.arena, __LINE__, "ERROR: The view of the melody playing must follow its notes");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(62, view.p_midi_notes[length - 1U], __LINE__, "ERROR: The melody playing must keep its notes");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(length % 256U, view.p_ticks[length - 1U], __LINE__, "ERROR: The melody playing must keep its ticks");
+    UNITY_TEST_ASSERT_EQUAL_INT(PLAY, fsm_buzzer_get_action(p_fsm_buzzer), __LINE__, "ERROR: The melody playing must not be stopped by an upload");
+
+    UNITY_TEST_ASSERT_FALSE(melody_pool_begin(&pool, "b"), __LINE__, "ERROR: The melody playing must not be replaced");
+    UNITY_TEST_ASSERT_EQUAL_INT(-1, _store("d", length * 2U, 65), __LINE__, "ERROR: A melody larger than the room left by the melody playing must fail");
+    UNITY_TEST_ASSERT_TRUE(melody_pool_find(&pool, "b") >= 0, __LINE__, "ERROR: The melody playing must be kept when the pool is full");
+    port_buzzer_stop(BUZZER_0_ID);
+    fsm_destroy(p_fsm_buzzer);
+}
+
+void test_pool_hold(void)
+{
+    uint32_t length = MELODY_POOL_ARENA_SIZE / 8U; // Four melodies fill the arena
+    fsm_t *p_fsm_buzzer = fsm_buzzer_new(BUZZER_0_ID);
+    melody_pool_set_hold(&pool, _hold, p_fsm_buzzer);
+    _store("a", length, 60);
+    _store("b", length, 62);
+    _store("c", length, 64);
+    _store("d", length, 65);
+    melody_pool_get_melody(&pool, 1, &view);
+
+    fsm_buzzer_set_sequencer(p_fsm_buzzer, true);
+    fsm_buzzer_set_melody(p_fsm_buzzer, &view);
+    fsm_buzzer_set_action(p_fsm_buzzer, PLAY);
+    fsm_fire(p_fsm_buzzer);
+
+    // "a" is before the melody playing: its notes are moved, and the player is held meanwhile
+    melody_pool_get_melody(&pool, 2, &(melody_t){0});
+    melody_pool_get_melody(&pool, 3, &(melody_t){0});
+    UNITY_TEST_ASSERT_TRUE(_store("e", 1, 67) >= 0, __LINE__, "ERROR: A melody must be stored while another one is playing");
+    UNITY_TEST_ASSERT_EQUAL_INT(-1, melody_pool_find(&pool, "a"), __LINE__, "ERROR: The least recently used melody must be evicted");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(1, holds, __LINE__, "ERROR: The player must be held while the melody playing is moved");
+    UNITY_TEST_ASSERT_TRUE(masked, __LINE__, "ERROR: The interrupt of the player must be masked while it is held");
+    UNITY_TEST_ASSERT_FALSE(held, __LINE__, "ERROR: The player must be released after the move");
+    UNITY_TEST_ASSERT_TRUE((TIM2->DIER & TIM_DIER_UIE) != 0, __LINE__, "ERROR: The interrupt of the player must be unmasked after the move");
+    UNITY_TEST_ASSERT_TRUE(view.p_midi_notes == pool.arena, __LINE__, "ERROR: The view of the melody playing must follow its notes");
+
+    // "c" is after the melody playing: the melody playing is not moved, and the player is not held
+    melody_pool_get_melody(&pool, (uint32_t)melody_pool_find(&pool, "d"), &(melody_t){0});
+    melody_pool_get_melody(&pool, (uint32_t)melody_pool_find(&pool, "e"), &(melody_t){0});
+    UNITY_TEST_ASSERT_TRUE(_store("f", length, 69) >= 0, __LINE__, "ERROR: A melody must be stored while another one is playing");
+    UNITY_TEST_ASSERT_EQUAL_INT(-1, melody_pool_find(&pool, "c"), __LINE__, "ERROR: The least recently used melody must be evicted");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(1, holds, __LINE__, "ERROR: The player must not be held if the melody playing is not moved");
+    UNITY_TEST_ASSERT_EQUAL_INT(PLAY, fsm_buzzer_get_action(p_fsm_buzzer), __LINE__, "ERROR: The melody playing must not be stopped by an upload");
+    port_buzzer_stop(BUZZER_0_ID);
+    fsm_buzzer_set_sequencer(p_fsm_buzzer, false);
+    fsm_destroy(p_fsm_buzzer);
+}
+
+int main(void)
+{
+    port_system_init();
+    UNITY_BEGIN();
+    RUN_TEST(test_upload_rtttl);
+    RUN_TEST(test_upload_hex);
+    RUN_TEST(test_upload_errors);
+    RUN_TEST(test_pool_eviction);
+    RUN_TEST(test_pool_playing_melody);
+    RUN_TEST(test_pool_hold);
+    return UNITY_END();
+}
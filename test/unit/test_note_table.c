@@ -0,0 +1,131 @@
+#include <unity.h>
+#include <math.h>
+#include "port_system.h"
+#include "port_buzzer.h"
+#include "melodies.h"
+#include "note_table.h"
+
+#define MAX_PITCH_ERROR_CENTS 1.0 /*!< Maximum pitch error allowed for a note of the table */
+
+void setUp(void)
+{
+    port_buzzer_init(BUZZER_0_ID);
+}
+
+void tearDown(void)
+{
+    port_buzzer_stop(BUZZER_0_ID);
+}
+
+/**
+ * @brief Pitch error in cents of the PWM signal generated with some register values.
+ */
+static double _pitch_error_cents(double frequency_hz, uint32_t psc, uint32_t arr)
+{
+    double generated_hz = (double)NOTE_TABLE_CLOCK_HZ / (((double)psc + 1.0) * ((double)arr + 1.0));
+    return fabs(1200.0 * log2(generated_hz / frequency_hz));
+}
+
+void test_table_sorted(void)
+{
+    UNITY_TEST_ASSERT_EQUAL_INT(SILENCE, note_table[0].frequency_hz, __LINE__, "ERROR: The first entry of the note table must be the silence");
+    for (uint32_t i = 1; i < NOTE_TABLE_LENGTH; i++)
+    {
+        UNITY_TEST_ASSERT_TRUE(note_table[i - 1].frequency_hz < note_table[i].frequency_hz, __LINE__, "ERROR: The note table must be sorted by frequency");
+    }
+}
+
+void test_table_find(void)
+{
+    double notes[] = {DO1, LA4, SOLs6, SI8};
+    for (uint32_t i = 0; i < sizeof(notes) / sizeof(notes[0]); i++)
+    {
+        const note_regs_t *p_regs = note_table_find(notes[i]);
+        UNITY_TEST_ASSERT_TRUE(p_regs != NULL, __LINE__, "ERROR: Every note of melodies.h must be in the note table");
+        UNITY_TEST_ASSERT_TRUE(p_regs->frequency_hz == notes[i], __LINE__, "ERROR: note_table_find() returned a wrong note");
+    }
+    UNITY_TEST_ASSERT_TRUE(note_table_find(LA4 + 0.001) == NULL, __LINE__, "ERROR: Frequencies out of the table must not be found");
+    UNITY_TEST_ASSERT_TRUE(note_table_find(20000.0) == NULL, __LINE__, "ERROR: Frequencies above the table must not be found");
+}
+
+void test_table_pitch(void)
+{
+    for (uint32_t i = 1; i < NOTE_TABLE_LENGTH; i++)
+    {
+        double error = _pitch_error_cents(note_table[i].frequency_hz, note_table[i].psc, note_table[i].arr);
+        UNITY_TEST_ASSERT_TRUE(error <= MAX_PITCH_ERROR_CENTS, __LINE__, "ERROR: The pitch error of a note of the table is too large");
+        UNITY_TEST_ASSERT_EQUAL_UINT32((uint32_t)(BUZZER_PWM_DC * (note_table[i].arr + 1.0)), note_table[i].ccr, __LINE__, "ERROR: The CCR of a note of the table does not match the duty cycle");
+    }
+}
+
+void test_fast_path_registers(void)
+{
+    port_buzzer_set_note_frequency(BUZZER_0_ID, LA4);
+    const note_regs_t *p_regs = note_table_find(LA4);
+    UNITY_TEST_ASSERT_EQUAL_UINT32(p_regs->psc, TIM3->PSC, __LINE__, "ERROR: The PSC of a note of the table has not been loaded");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(p_regs->arr, TIM3->ARR, __LINE__, "ERROR: The ARR of a note of the table has not been loaded");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(p_regs->ccr, TIM3->CCR1, __LINE__, "ERROR: The CCR1 of a note of the table has not been loaded");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(TIM_CR1_CEN, TIM3->CR1 & TIM_CR1_CEN, __LINE__, "ERROR: The PWM timer must be enabled");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(TIM_CCER_CC1E, TIM3->CCER & TIM_CCER_CC1E, __LINE__, "ERROR: The PWM output must be enabled");
+}
+
+void test_computed_path_registers(void)
+{
+    // A frequency out of the table is still computed
+    double frequency_hz = 1000.5;
+    port_buzzer_set_note_frequency(BUZZER_0_ID, frequency_hz);
+    UNITY_TEST_ASSERT_TRUE(_pitch_error_cents(frequency_hz, TIM3->PSC, TIM3->ARR) < 5.0, __LINE__, "ERROR: The frequency of a note out of the table has not been computed");
+    UNITY_TEST_ASSERT_EQUAL_UINT32((uint32_t)(BUZZER_PWM_DC * (TIM3->ARR + 1.0)), TIM3->CCR1, __LINE__, "ERROR: The CCR1 of a note out of the table is wrong");
+}
+
+void test_fixed_point_registers(void)
+{
+    // Every note of the table is found by its frequency in fixed point
+    for (uint32_t i = 1; i < NOTE_TABLE_LENGTH; i++)
+    {
+        UNITY_TEST_ASSERT_TRUE(note_table_find_q16(PORT_BUZZER_HZ_Q16(note_table[i].frequency_hz)) == &note_table[i], __LINE__, "ERROR: A note of the table must be found by its frequency in fixed point");
+    }
+
+    // Out of the table the registers computed in fixed point match the ones computed with doubles
+    double frequency_hz = 1000.5;
+    port_buzzer_set_note_frequency_q16(BUZZER_0_ID, PORT_BUZZER_HZ_Q16(frequency_hz));
+    UNITY_TEST_ASSERT_TRUE(_pitch_error_cents(frequency_hz, TIM3->PSC, TIM3->ARR) < 5.0, __LINE__, "ERROR: The frequency of a note in fixed point has not been computed");
+    UNITY_TEST_ASSERT_EQUAL_UINT32((uint32_t)(BUZZER_PWM_DC * (TIM3->ARR + 1.0)), TIM3->CCR1, __LINE__, "ERROR: The CCR1 of a note in fixed point is wrong");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(TIM_CR1_CEN, TIM3->CR1 & TIM_CR1_CEN, __LINE__, "ERROR: The PWM timer must be enabled");
+
+    port_buzzer_set_note_frequency_q16(BUZZER_0_ID, 0);
+    UNITY_TEST_ASSERT_EQUAL_UINT32(0, TIM3->CR1 & TIM_CR1_CEN, __LINE__, "ERROR: A silence must disable the PWM timer");
+
+    // The duration in us is kept with the resolution of the timer
+    port_buzzer_note_regs_t regs;
+    port_buzzer_get_note_regs_q16(PORT_BUZZER_HZ_Q16(LA4), 166667, &regs);
+    double generated = ((double)regs.duration_psc + 1.0) * ((double)regs.duration_arr + 1.0);
+    UNITY_TEST_ASSERT_TRUE(fabs(generated - (double)SystemCoreClock * 0.166667) <= ((double)regs.duration_psc + 1.0) / 2.0, __LINE__, "ERROR: The duration of a note in us has not been computed correctly");
+}
+
+void test_note_duration_registers(void)
+{
+    uint32_t durations_ms[] = {1, 100, 250, 1000, 4095, 60000};
+    for (uint32_t i = 0; i < sizeof(durations_ms) / sizeof(durations_ms[0]); i++)
+    {
+        port_buzzer_set_note_duration(BUZZER_0_ID, durations_ms[i]);
+        double ticks = ((double)SystemCoreClock / 1000.0) * durations_ms[i];
+        double generated = ((double)TIM2->PSC + 1.0) * ((double)TIM2->ARR + 1.0);
+        UNITY_TEST_ASSERT_TRUE(TIM2->ARR <= 65535, __LINE__, "ERROR: The ARR of the note duration timer must fit in 16 bits");
+        UNITY_TEST_ASSERT_TRUE(fabs(generated - ticks) <= ((double)TIM2->PSC + 1.0) / 2.0, __LINE__, "ERROR: The duration of the note has not been computed correctly");
+    }
+}
+
+int main(void)
+{
+    port_system_init();
+    UNITY_BEGIN();
+    RUN_TEST(test_table_sorted);
+    RUN_TEST(test_table_find);
+    RUN_TEST(test_table_pitch);
+    RUN_TEST(test_fast_path_registers);
+    RUN_TEST(test_computed_path_registers);
+    RUN_TEST(test_fixed_point_registers);
+    RUN_TEST(test_note_duration_registers);
+    return UNITY_END();
+}
@@ -0,0 +1,159 @@
+#include <unity.h>
+#include <stdlib.h>
+#include <math.h>
+#include "port_system.h"
+#include "port_buzzer.h"
+#include "fsm_buzzer.h"
+#include "melodies.h"
+
+#define NOTE_MS 250 /*!< Duration of every note of the scale of scale_harmony_multitrack */
+#define HARMONY_MS 2000 /*!< Duration of scale_harmony_multitrack */
+
+static const double chord_notes[][1] = {{DO4}, {MI4}, {SOL4}, {DO5}, {MI5}}; /*!< Notes of a chord of five notes, one per track */
+static const uint16_t chord_durations[] = {100};                             /*!< Duration of the notes of the chord */
+static const melody_t chord_tracks[] = {
+    {.p_name = "chord_0", .p_notes = chord_notes[0], .p_durations = chord_durations, .melody_length = 1},
+    {.p_name = "chord_1", .p_notes = chord_notes[1], .p_durations = chord_durations, .melody_length = 1},
+    {.p_name = "chord_2", .p_notes = chord_notes[2], .p_durations = chord_durations, .melody_length = 1},
+    {.p_name = "chord_3", .p_notes = chord_notes[3], .p_durations = chord_durations, .melody_length = 1},
+    {.p_name = "chord_4", .p_notes = chord_notes[4], .p_durations = chord_durations, .melody_length = 1},
+}; /*!< Tracks of a chord of five notes */
+static const multitrack_melody_t chord_multitrack = {.p_name = "chord",
+                                                     .p_tracks = {&chord_tracks[0], &chord_tracks[1], &chord_tracks[2], &chord_tracks[3], &chord_tracks[4]},
+                                                     .num_tracks = 5}; /*!< Chord with more notes than voices */
+
+fsm_t *p_fsm_buzzer; /*!< Buzzer FSM used by the tests */
+
+void setUp(void)
+{
+    p_fsm_buzzer = fsm_buzzer_new(BUZZER_0_ID);
+    fsm_buzzer_set_multitrack(p_fsm_buzzer, &scale_harmony_multitrack);
+}
+
+void tearDown(void)
+{
+    port_buzzer_stop(BUZZER_0_ID);
+    fsm_destroy(p_fsm_buzzer);
+}
+
+/**
+ * @brief Check that a voice plays a note.
+ *
+ * @param voice Index of the voice
+ * @param frequency_hz Frequency of the note in Hz
+ * @param line Line of the test
+ */
+static void _assert_voice(uint32_t voice, double frequency_hz, uint32_t line)
+{
+    TIM_TypeDef *p_tim = voices_arr[voice].p_tim;
+    double pwm_hz = (double)SystemCoreClock / ((p_tim->PSC + 1.0) * (p_tim->ARR + 1.0));
+    UNITY_TEST_ASSERT(fabs(pwm_hz - frequency_hz) < frequency_hz * 0.002, line, "ERROR: The voice must play the frequency of the note");
+    UNITY_TEST_ASSERT_UINT32_WITHIN(1, (p_tim->ARR + 1) / 2, p_tim->CCR1, line, "ERROR: The voice must keep the duty cycle");
+    UNITY_TEST_ASSERT(p_tim->CR1 & TIM_CR1_CEN, line, "ERROR: The timer of the voice must be running");
+}
+
+/**
+ * @brief Fire the FSM until the note that is playing ends and the next segment starts.
+ */
+static void _next_segment(void)
+{
+    while (!port_buzzer_get_note_timeout(BUZZER_0_ID))
+    {
+    }
+    fsm_fire(p_fsm_buzzer);
+    fsm_fire(p_fsm_buzzer);
+}
+
+void test_tracks_on_voices(void)
+{
+    fsm_buzzer_set_action(p_fsm_buzzer, PLAY);
+    fsm_fire(p_fsm_buzzer);
+    _assert_voice(0, DO4, __LINE__);
+    _assert_voice(1, MI4, __LINE__);
+    _assert_voice(2, DO3, __LINE__);
+    UNITY_TEST_ASSERT_EQUAL_UINT32(0, voices_arr[3].p_tim->CR1 & TIM_CR1_CEN, __LINE__, "ERROR: A voice with no note must be silent");
+}
+
+void test_segments_share_timebase(void)
+{
+    fsm_buzzer_set_action(p_fsm_buzzer, PLAY);
+    fsm_fire(p_fsm_buzzer);
+    uint32_t start = port_system_get_millis();
+    _next_segment();
+    UNITY_TEST_ASSERT_UINT32_WITHIN(1, NOTE_MS, port_system_get_millis() - start, __LINE__, "ERROR: A segment must end with the first note that ends");
+    _assert_voice(0, RE4, __LINE__);
+    _assert_voice(1, FA4, __LINE__);
+    _assert_voice(2, DO3, __LINE__);
+
+    // The bass note changes in the middle of a note of the scale: the scale notes go on in a shorter segment
+    _next_segment();
+    _next_segment();
+    _assert_voice(0, FA4, __LINE__);
+    _assert_voice(2, SOL3, __LINE__);
+    start = port_system_get_millis();
+    _next_segment();
+    UNITY_TEST_ASSERT_UINT32_WITHIN(1, NOTE_MS, port_system_get_millis() - start, __LINE__, "ERROR: The segment must end with the next note of the scale");
+}
+
+void test_multitrack_in_sync(void)
+{
+    fsm_buzzer_set_absolute_time(p_fsm_buzzer, true);
+    fsm_buzzer_set_action(p_fsm_buzzer, PLAY);
+    uint32_t start = port_system_get_millis();
+    while (fsm_buzzer_get_action(p_fsm_buzzer) != STOP)
+    {
+        fsm_fire(p_fsm_buzzer);
+    }
+    UNITY_TEST_ASSERT_UINT32_WITHIN(2, HARMONY_MS, port_system_get_millis() - start, __LINE__, "ERROR: The tracks must end together");
+    UNITY_TEST_ASSERT(abs(fsm_buzzer_get_drift_us(p_fsm_buzzer)) < 100, __LINE__, "ERROR: The segments must follow the schedule of the melody");
+    for (uint32_t voice = 0; voice < PORT_BUZZER_MAX_VOICES; voice++)
+    {
+        UNITY_TEST_ASSERT_EQUAL_UINT32(0, voices_arr[voice].p_tim->CR1 & TIM_CR1_CEN, __LINE__, "ERROR: Every voice must be stopped at the end of the melody");
+    }
+}
+
+void test_voice_stealing(void)
+{
+    fsm_buzzer_set_multitrack(p_fsm_buzzer, &chord_multitrack);
+    fsm_buzzer_set_action(p_fsm_buzzer, PLAY);
+    fsm_fire(p_fsm_buzzer);
+    UNITY_TEST_ASSERT_EQUAL_UINT32(1, fsm_buzzer_get_stolen_notes(p_fsm_buzzer), __LINE__, "ERROR: The note with no voice must be counted");
+    _assert_voice(0, DO4, __LINE__);
+    _assert_voice(3, MI5, __LINE__);
+}
+
+void test_multitrack_pause_resume(void)
+{
+    fsm_buzzer_set_action(p_fsm_buzzer, PLAY);
+    fsm_fire(p_fsm_buzzer);
+    port_system_delay_ms(NOTE_MS / 2);
+    fsm_buzzer_set_action(p_fsm_buzzer, PAUSE);
+    fsm_fire(p_fsm_buzzer);
+    fsm_fire(p_fsm_buzzer);
+    UNITY_TEST_ASSERT_EQUAL_UINT32(0, voices_arr[2].p_tim->CR1 & TIM_CR1_CEN, __LINE__, "ERROR: Every voice must be stopped while paused");
+
+    fsm_buzzer_set_action(p_fsm_buzzer, PLAY);
+    fsm_fire(p_fsm_buzzer);
+    fsm_fire(p_fsm_buzzer);
+    _assert_voice(0, RE4, __LINE__);
+    _assert_voice(2, DO3, __LINE__);
+}
+
+void test_single_track_after_multitrack(void)
+{
+    fsm_buzzer_set_melody(p_fsm_buzzer, &scale_melody);
+    UNITY_TEST_ASSERT(((fsm_buzzer_t *)p_fsm_buzzer)->p_multitrack == NULL, __LINE__, "ERROR: A melody must replace the multi-track melody");
+}
+
+int main(void)
+{
+    port_system_init();
+    UNITY_BEGIN();
+    RUN_TEST(test_tracks_on_voices);
+    RUN_TEST(test_segments_share_timebase);
+    RUN_TEST(test_multitrack_in_sync);
+    RUN_TEST(test_voice_stealing);
+    RUN_TEST(test_multitrack_pause_resume);
+    RUN_TEST(test_single_track_after_multitrack);
+    return UNITY_END();
+}
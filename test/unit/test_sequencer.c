@@ -0,0 +1,144 @@
+#include <unity.h>
+#include "port_system.h"
+#include "port_buzzer.h"
+#include "fsm_buzzer.h"
+#include "melodies.h"
+
+fsm_t *p_fsm_buzzer; /*!< Buzzer FSM used by the tests */
+
+void setUp(void)
+{
+    p_fsm_buzzer = fsm_buzzer_new(BUZZER_0_ID);
+    fsm_buzzer_set_sequencer(p_fsm_buzzer, true);
+    fsm_buzzer_set_melody(p_fsm_buzzer, &scale_melody);
+}
+
+void tearDown(void)
+{
+    port_buzzer_stop(BUZZER_0_ID);
+    fsm_destroy(p_fsm_buzzer);
+}
+
+/**
+ * @brief Wait for the note end flag, without firing the FSM.
+ */
+static void _wait_note_end(void)
+{
+    while (!port_buzzer_get_note_timeout(BUZZER_0_ID))
+    {
+    }
+}
+
+void test_isr_plays_melody(void)
+{
+    fsm_buzzer_set_action(p_fsm_buzzer, PLAY);
+    fsm_fire(p_fsm_buzzer);
+    port_buzzer_reset_gap_stats(BUZZER_0_ID);
+    UNITY_TEST_ASSERT_EQUAL_UINT32(2, ((fsm_buzzer_t *)p_fsm_buzzer)->note_index, __LINE__, "ERROR: The second note must be staged when the melody starts");
+
+    // The FSM is not fired: the whole melody is played by the ISR
+    _wait_note_end();
+    port_buzzer_gap_stats_t stats;
+    port_buzzer_get_gap_stats(BUZZER_0_ID, &stats);
+    UNITY_TEST_ASSERT_EQUAL_UINT32(scale_melody.melody_length, ((fsm_buzzer_t *)p_fsm_buzzer)->note_index, __LINE__, "ERROR: The ISR must advance note_index up to the end of the melody");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(scale_melody.melody_length - 1, stats.count, __LINE__, "ERROR: Every note of the melody must be started by the ISR");
+
+    // The FSM is only notified of the end of the melody
+    fsm_fire(p_fsm_buzzer);
+    fsm_fire(p_fsm_buzzer);
+    UNITY_TEST_ASSERT_EQUAL_UINT32(WAIT_MELODY, ((fsm_buzzer_t *)p_fsm_buzzer)->f.current_state, __LINE__, "ERROR: The FSM must wait for a new melody at the end of the melody");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(STOP, fsm_buzzer_get_action(p_fsm_buzzer), __LINE__, "ERROR: The player must stop at the end of the melody");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(0, TIM2->CR1 & TIM_CR1_CEN, __LINE__, "ERROR: The duration timer must be stopped at the end of the melody");
+}
+
+void test_pause_at_note_end(void)
+{
+    fsm_buzzer_set_action(p_fsm_buzzer, PLAY);
+    fsm_fire(p_fsm_buzzer);
+    fsm_buzzer_set_action(p_fsm_buzzer, PAUSE);
+    UNITY_TEST_ASSERT_FALSE(port_buzzer_get_next_note_staged(BUZZER_0_ID), __LINE__, "ERROR: The staged note must be cancelled on pause");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(1, ((fsm_buzzer_t *)p_fsm_buzzer)->note_index, __LINE__, "ERROR: The cancelled note must be played on resume");
+
+    _wait_note_end();
+    fsm_fire(p_fsm_buzzer);
+    fsm_fire(p_fsm_buzzer);
+    UNITY_TEST_ASSERT_EQUAL_UINT32(PAUSE_NOTE, ((fsm_buzzer_t *)p_fsm_buzzer)->f.current_state, __LINE__, "ERROR: The player must pause at the end of the current note");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(0, TIM2->CR1 & TIM_CR1_CEN, __LINE__, "ERROR: The duration timer must be stopped while paused");
+
+    fsm_buzzer_set_action(p_fsm_buzzer, PLAY);
+    fsm_fire(p_fsm_buzzer);
+    fsm_fire(p_fsm_buzzer);
+    UNITY_TEST_ASSERT_EQUAL_UINT32(WAIT_NOTE, ((fsm_buzzer_t *)p_fsm_buzzer)->f.current_state, __LINE__, "ERROR: The player must resume");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(3, ((fsm_buzzer_t *)p_fsm_buzzer)->note_index, __LINE__, "ERROR: The second note must be played and the third one staged on resume");
+    UNITY_TEST_ASSERT_TRUE(port_buzzer_get_next_note_staged(BUZZER_0_ID), __LINE__, "ERROR: The sequencer must go on after resume");
+}
+
+void test_stop_at_note_end(void)
+{
+    fsm_buzzer_set_action(p_fsm_buzzer, PLAY);
+    fsm_fire(p_fsm_buzzer);
+    fsm_buzzer_set_action(p_fsm_buzzer, STOP);
+    _wait_note_end();
+    fsm_fire(p_fsm_buzzer);
+    fsm_fire(p_fsm_buzzer);
+    UNITY_TEST_ASSERT_EQUAL_UINT32(WAIT_START, ((fsm_buzzer_t *)p_fsm_buzzer)->f.current_state, __LINE__, "ERROR: The player must stop at the end of the current note");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(0, ((fsm_buzzer_t *)p_fsm_buzzer)->note_index, __LINE__, "ERROR: The melody must be rewound on stop");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(0, TIM2->CR1 & TIM_CR1_CEN, __LINE__, "ERROR: The duration timer must be stopped");
+}
+
+void test_isr_follows_next_melody(void)
+{
+    UNITY_TEST_ASSERT_FALSE(fsm_buzzer_set_next_melody(p_fsm_buzzer, &(melody_t){0}), __LINE__, "ERROR: An empty melody must not follow");
+    UNITY_TEST_ASSERT_TRUE(fsm_buzzer_set_next_melody(p_fsm_buzzer, &scale_reverse_melody), __LINE__, "ERROR: A melody must be set to follow the melody playing");
+    fsm_buzzer_set_action(p_fsm_buzzer, PLAY);
+    fsm_fire(p_fsm_buzzer);
+    port_buzzer_reset_gap_stats(BUZZER_0_ID);
+
+    // The FSM is not fired: the ISR goes on with the next melody after the last note of the first one
+    _wait_note_end();
+    port_buzzer_gap_stats_t stats;
+    port_buzzer_get_gap_stats(BUZZER_0_ID, &stats);
+    UNITY_TEST_ASSERT_TRUE(fsm_buzzer_get_melody(p_fsm_buzzer) == &scale_reverse_melody, __LINE__, "ERROR: The ISR must go on with the next melody");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(scale_reverse_melody.melody_length, ((fsm_buzzer_t *)p_fsm_buzzer)->note_index, __LINE__, "ERROR: The ISR must advance note_index up to the end of the next melody");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(scale_melody.melody_length + scale_reverse_melody.melody_length - 1, stats.count, __LINE__, "ERROR: Every note of both melodies must be started by the ISR");
+    UNITY_TEST_ASSERT_TRUE(((fsm_buzzer_t *)p_fsm_buzzer)->p_next_melody == NULL, __LINE__, "ERROR: The next melody must be played once");
+
+    fsm_fire(p_fsm_buzzer);
+    fsm_fire(p_fsm_buzzer);
+    UNITY_TEST_ASSERT_EQUAL_UINT32(STOP, fsm_buzzer_get_action(p_fsm_buzzer), __LINE__, "ERROR: The player must stop at the end of the next melody");
+}
+
+void test_stop_drops_next_melody(void)
+{
+    fsm_buzzer_set_next_melody(p_fsm_buzzer, &scale_reverse_melody);
+    fsm_buzzer_set_action(p_fsm_buzzer, PLAY);
+    fsm_fire(p_fsm_buzzer);
+    fsm_buzzer_set_action(p_fsm_buzzer, STOP);
+    UNITY_TEST_ASSERT_TRUE(((fsm_buzzer_t *)p_fsm_buzzer)->p_next_melody == NULL, __LINE__, "ERROR: A stop must drop the next melody");
+    fsm_buzzer_set_next_melody(p_fsm_buzzer, &scale_reverse_melody);
+    fsm_buzzer_set_melody(p_fsm_buzzer, &scale_melody);
+    UNITY_TEST_ASSERT_TRUE(((fsm_buzzer_t *)p_fsm_buzzer)->p_next_melody == NULL, __LINE__, "ERROR: A new melody must drop the next melody");
+}
+
+void test_sequencer_disabled(void)
+{
+    fsm_buzzer_set_sequencer(p_fsm_buzzer, false);
+    fsm_buzzer_set_action(p_fsm_buzzer, PLAY);
+    fsm_fire(p_fsm_buzzer);
+    UNITY_TEST_ASSERT_FALSE(port_buzzer_get_next_note_staged(BUZZER_0_ID), __LINE__, "ERROR: No note must be staged without the sequencer");
+    _wait_note_end();
+    UNITY_TEST_ASSERT_EQUAL_UINT32(1, ((fsm_buzzer_t *)p_fsm_buzzer)->note_index, __LINE__, "ERROR: The ISR must not advance the melody without the sequencer");
+}
+
+int main(void)
+{
+    port_system_init();
+    UNITY_BEGIN();
+    RUN_TEST(test_isr_plays_melody);
+    RUN_TEST(test_pause_at_note_end);
+    RUN_TEST(test_stop_at_note_end);
+    RUN_TEST(test_isr_follows_next_melody);
+    RUN_TEST(test_stop_drops_next_melody);
+    RUN_TEST(test_sequencer_disabled);
+    return UNITY_END();
+}
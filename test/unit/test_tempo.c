@@ -0,0 +1,136 @@
+#include <unity.h>
+#include "port_system.h"
+#include "port_buzzer.h"
+#include "fsm_buzzer.h"
+#include "melodies.h"
+
+#define NOTE_MS 250 /*!< Duration of every note of scale_melody */
+#define TOLERANCE_MS 2 /*!< Error of the end of a note: rounding of the registers of the timer and the delays of the test */
+
+fsm_t *p_fsm_buzzer; /*!< Buzzer FSM used by the tests */
+
+void setUp(void)
+{
+    p_fsm_buzzer = fsm_buzzer_new(BUZZER_0_ID);
+    fsm_buzzer_set_melody(p_fsm_buzzer, &scale_melody);
+}
+
+void tearDown(void)
+{
+    port_buzzer_stop(BUZZER_0_ID);
+    fsm_destroy(p_fsm_buzzer);
+}
+
+/**
+ * @brief Wait until the note that is playing ends.
+ *
+ * @return uint32_t Time waited, in ms
+ */
+static uint32_t _wait_note_end(void)
+{
+    uint32_t start = port_system_get_millis();
+    while (!port_buzzer_get_note_timeout(BUZZER_0_ID) && (port_system_get_millis() - start < 4 * NOTE_MS))
+    {
+        port_system_delay_ms(1);
+    }
+    return port_system_get_millis() - start;
+}
+
+/**
+ * @brief Start the melody and change the speed halfway through the first note.
+ *
+ * @param speed_q8 New speed, Q8.8
+ * @return uint32_t Time from the change of speed to the end of the first note, in ms
+ */
+static uint32_t _change_speed_mid_note(uint16_t speed_q8)
+{
+    fsm_buzzer_set_action(p_fsm_buzzer, PLAY);
+    fsm_fire(p_fsm_buzzer);
+    port_system_delay_ms(NOTE_MS / 2);
+    fsm_buzzer_set_speed_q8(p_fsm_buzzer, speed_q8);
+    return _wait_note_end();
+}
+
+void test_rescale_note_faster(void)
+{
+    uint32_t rest_ms = _change_speed_mid_note(2 * FSM_BUZZER_SPEED_Q8_ONE);
+    UNITY_TEST_ASSERT_UINT32_WITHIN(TOLERANCE_MS, NOTE_MS / 4, rest_ms, __LINE__, "ERROR: The rest of the note must be halved at double speed");
+}
+
+void test_rescale_note_slower(void)
+{
+    uint32_t rest_ms = _change_speed_mid_note(FSM_BUZZER_SPEED_Q8_ONE / 2);
+    UNITY_TEST_ASSERT_UINT32_WITHIN(TOLERANCE_MS, NOTE_MS, rest_ms, __LINE__, "ERROR: The rest of the note must be doubled at half speed");
+}
+
+void test_rescale_gapless(void)
+{
+    fsm_buzzer_set_gapless(p_fsm_buzzer, true);
+    uint32_t rest_ms = _change_speed_mid_note(2 * FSM_BUZZER_SPEED_Q8_ONE);
+    UNITY_TEST_ASSERT_UINT32_WITHIN(TOLERANCE_MS, NOTE_MS / 4, rest_ms, __LINE__, "ERROR: The rest of the note must be rescaled in gapless mode");
+    // The HW starts the next note, staged again at the new speed
+    port_buzzer_reset_note_timeout(BUZZER_0_ID);
+    UNITY_TEST_ASSERT_UINT32_WITHIN(TOLERANCE_MS, NOTE_MS / 2, _wait_note_end(), __LINE__, "ERROR: The staged note must be played at the new speed");
+}
+
+void test_rescale_dma(void)
+{
+    fsm_buzzer_set_dma(p_fsm_buzzer, true);
+    uint32_t rest_ms = _change_speed_mid_note(2 * FSM_BUZZER_SPEED_Q8_ONE);
+    UNITY_TEST_ASSERT_UINT32_WITHIN(TOLERANCE_MS, NOTE_MS / 4, rest_ms, __LINE__, "ERROR: The rest of the note must be rescaled in DMA mode");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(1, ((fsm_buzzer_t *)p_fsm_buzzer)->note_index, __LINE__, "ERROR: The melody must go on from the next note");
+}
+
+void test_rescale_keeps_schedule(void)
+{
+    fsm_buzzer_set_absolute_time(p_fsm_buzzer, true);
+    fsm_buzzer_set_action(p_fsm_buzzer, PLAY);
+    fsm_fire(p_fsm_buzzer);
+    port_system_delay_ms(NOTE_MS / 2);
+    fsm_buzzer_set_speed_q8(p_fsm_buzzer, 2 * FSM_BUZZER_SPEED_Q8_ONE);
+    while (fsm_buzzer_get_action(p_fsm_buzzer) != STOP)
+    {
+        fsm_fire(p_fsm_buzzer);
+    }
+    // The schedule restarts at the change of speed: the time already played at the old speed is not drift
+    int32_t drift_us = fsm_buzzer_get_drift_us(p_fsm_buzzer);
+    UNITY_TEST_ASSERT((drift_us < 1000) && (drift_us > -1000), __LINE__, "ERROR: The schedule must follow the change of speed");
+}
+
+void test_speed_ramp(void)
+{
+    fsm_buzzer_t *p_fsm = (fsm_buzzer_t *)p_fsm_buzzer;
+    // Ramp from 1 to 2 along two notes: the speed is stepped at the start of each note
+    fsm_buzzer_set_speed_ramp(p_fsm_buzzer, 2 * FSM_BUZZER_SPEED_Q8_ONE, 2 * NOTE_MS);
+    fsm_buzzer_set_action(p_fsm_buzzer, PLAY);
+    fsm_fire(p_fsm_buzzer);
+    uint16_t first_step = p_fsm->speed_q8;
+    UNITY_TEST_ASSERT(first_step > FSM_BUZZER_SPEED_Q8_ONE, __LINE__, "ERROR: The speed must go up along the ramp");
+    UNITY_TEST_ASSERT(first_step < 2 * FSM_BUZZER_SPEED_Q8_ONE, __LINE__, "ERROR: The ramp must not reach the target in one note");
+    while (p_fsm->note_index < 4)
+    {
+        fsm_fire(p_fsm_buzzer);
+    }
+    UNITY_TEST_ASSERT_EQUAL_UINT32(2 * FSM_BUZZER_SPEED_Q8_ONE, p_fsm->speed_q8, __LINE__, "ERROR: The ramp must end at the target speed");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(0, p_fsm->ramp_remaining_us, __LINE__, "ERROR: The ramp must be over");
+}
+
+void test_speed_ramp_zero(void)
+{
+    fsm_buzzer_set_speed_ramp(p_fsm_buzzer, FSM_BUZZER_SPEED_Q8_ONE / 2, 0);
+    UNITY_TEST_ASSERT_EQUAL_UINT32(FSM_BUZZER_SPEED_Q8_ONE / 2, ((fsm_buzzer_t *)p_fsm_buzzer)->speed_q8, __LINE__, "ERROR: A ramp of 0 ms must set the speed at once");
+}
+
+int main(void)
+{
+    port_system_init();
+    UNITY_BEGIN();
+    RUN_TEST(test_rescale_note_faster);
+    RUN_TEST(test_rescale_note_slower);
+    RUN_TEST(test_rescale_gapless);
+    RUN_TEST(test_rescale_dma);
+    RUN_TEST(test_rescale_keeps_schedule);
+    RUN_TEST(test_speed_ramp);
+    RUN_TEST(test_speed_ramp_zero);
+    return UNITY_END();
+}
@@ -0,0 +1,209 @@
+#include <unity.h>
+#include "port_system.h"
+#include "port_buzzer.h"
+#include "fsm_buzzer.h"
+#include "melodies.h"
+#include "melody_timeline.h"
+
+#define NOTE_MS 250 /*!< Duration of every note of scale_melody */
+#define SCALE_MS (8 * NOTE_MS) /*!< Duration of scale_melody */
+#define TOLERANCE_MS 2 /*!< Error of a time: rounding of the registers of the timer and the delays of the test */
+#define LONG_MELODY_LENGTH (2 * MELODY_TIMELINE_MAX_ENTRIES + 5) /*!< Notes of a melody that does not fit in the timeline note by note */
+
+fsm_t *p_fsm_buzzer; /*!< Buzzer FSM used by the tests */
+static melody_timeline_t timeline; /*!< Timeline used by the tests of the index */
+
+void setUp(void)
+{
+    p_fsm_buzzer = fsm_buzzer_new(BUZZER_0_ID);
+    fsm_buzzer_set_melody(p_fsm_buzzer, &scale_melody);
+}
+
+void tearDown(void)
+{
+    port_buzzer_stop(BUZZER_0_ID);
+    fsm_destroy(p_fsm_buzzer);
+}
+
+/**
+ * @brief Get the time played reported by the player.
+ *
+ * @return uint32_t Time played, in ms at the speed of the player
+ */
+static uint32_t _elapsed_ms(void)
+{
+    uint32_t elapsed_ms;
+    uint32_t total_ms;
+    fsm_buzzer_get_progress(p_fsm_buzzer, &elapsed_ms, &total_ms);
+    return elapsed_ms;
+}
+
+/**
+ * @brief Wait until the note that is playing ends.
+ *
+ * @return uint32_t Time waited, in ms
+ */
+static uint32_t _wait_note_end(void)
+{
+    uint32_t start = port_system_get_millis();
+    while (!port_buzzer_get_note_timeout(BUZZER_0_ID) && (port_system_get_millis() - start < 4 * NOTE_MS))
+    {
+        port_system_delay_ms(1);
+    }
+    return port_system_get_millis() - start;
+}
+
+void test_timeline_index(void)
+{
+    static const uint8_t notes[] = {60, MIDI_SILENCE, 62, 64, 65};
+    static const uint8_t ticks[] = {4, 0, 2, 8, 1};
+    const melody_t melody = {.p_name = "index", .p_midi_notes = notes, .p_ticks = ticks, .tick_ms = 10, .melody_length = 5};
+    melody_timeline_build(&timeline, &melody);
+    UNITY_TEST_ASSERT_EQUAL_UINT32(150, melody_timeline_get_total_ms(&timeline), __LINE__, "ERROR: The total must be the sum of the durations");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(60, melody_timeline_get_start_ms(&timeline, 3), __LINE__, "ERROR: A note must start at the sum of the previous durations");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(150, melody_timeline_get_start_ms(&timeline, 9), __LINE__, "ERROR: The start past the end must be the total");
+
+    uint32_t offset_ms;
+    UNITY_TEST_ASSERT_EQUAL_UINT32(0, melody_timeline_find(&timeline, 39, &offset_ms), __LINE__, "ERROR: The time must be in the first note");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(39, offset_ms, __LINE__, "ERROR: The offset must be the time from the start of the note");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(2, melody_timeline_find(&timeline, 40, &offset_ms), __LINE__, "ERROR: A note with no duration must be skipped");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(0, offset_ms, __LINE__, "ERROR: The note must start at the time");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(4, melody_timeline_find(&timeline, 149, NULL), __LINE__, "ERROR: The time must be in the last note");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(5, melody_timeline_find(&timeline, 150, &offset_ms), __LINE__, "ERROR: The end of the melody must give its length");
+}
+
+void test_timeline_stride(void)
+{
+    static uint8_t notes[LONG_MELODY_LENGTH];
+    static uint8_t ticks[LONG_MELODY_LENGTH];
+    for (uint32_t i = 0; i < LONG_MELODY_LENGTH; i++)
+    {
+        notes[i] = 60;
+        ticks[i] = (uint8_t)(1 + i % 3);
+    }
+    const melody_t melody = {.p_name = "long", .p_midi_notes = notes, .p_ticks = ticks, .tick_ms = 1, .melody_length = LONG_MELODY_LENGTH};
+    melody_timeline_build(&timeline, &melody);
+    UNITY_TEST_ASSERT_EQUAL_UINT32(3, timeline.stride, __LINE__, "ERROR: A long melody must keep one start every few notes");
+    uint32_t start_ms = 0;
+    for (uint32_t i = 0; i < LONG_MELODY_LENGTH; i++)
+    {
+        UNITY_TEST_ASSERT_EQUAL_UINT32(start_ms, melody_timeline_get_start_ms(&timeline, i), __LINE__, "ERROR: The start of a note between entries must be walked");
+        uint32_t offset_ms;
+        UNITY_TEST_ASSERT_EQUAL_UINT32(i, melody_timeline_find(&timeline, start_ms + ticks[i] - 1U, &offset_ms), __LINE__, "ERROR: The note between entries must be found");
+        UNITY_TEST_ASSERT_EQUAL_UINT32(ticks[i] - 1U, offset_ms, __LINE__, "ERROR: The offset between entries must be kept");
+        start_ms += ticks[i];
+    }
+    UNITY_TEST_ASSERT_EQUAL_UINT32(start_ms, melody_timeline_get_total_ms(&timeline), __LINE__, "ERROR: The total of a long melody must be kept");
+}
+
+void test_progress(void)
+{
+    uint32_t elapsed_ms;
+    uint32_t total_ms;
+    fsm_buzzer_get_progress(p_fsm_buzzer, &elapsed_ms, &total_ms);
+    UNITY_TEST_ASSERT_EQUAL_UINT32(0, elapsed_ms, __LINE__, "ERROR: Nothing must be played while the player is stopped");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(SCALE_MS, total_ms, __LINE__, "ERROR: The total must be the duration of the melody");
+
+    // Waiting for the end of a note jumps to it: the time played is compared with the time measured
+    uint32_t start = port_system_get_millis();
+    fsm_buzzer_set_action(p_fsm_buzzer, PLAY);
+    while (port_system_get_millis() - start < 2 * NOTE_MS + 100)
+    {
+        fsm_fire(p_fsm_buzzer);
+    }
+    uint32_t played_ms = port_system_get_millis() - start;
+    UNITY_TEST_ASSERT_UINT32_WITHIN(TOLERANCE_MS, played_ms, _elapsed_ms(), __LINE__, "ERROR: The time played must follow the melody");
+
+    // At double speed both times are halved
+    fsm_buzzer_set_speed_q8(p_fsm_buzzer, 2 * FSM_BUZZER_SPEED_Q8_ONE);
+    fsm_buzzer_get_progress(p_fsm_buzzer, &elapsed_ms, &total_ms);
+    UNITY_TEST_ASSERT_UINT32_WITHIN(TOLERANCE_MS, played_ms / 2, elapsed_ms, __LINE__, "ERROR: The time played must be scaled by the speed");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(SCALE_MS / 2, total_ms, __LINE__, "ERROR: The total must be scaled by the speed");
+}
+
+void test_progress_modes(void)
+{
+    // The note playing is found from the staged note in sequencer mode and from the DMA playback in DMA mode
+    fsm_buzzer_set_sequencer(p_fsm_buzzer, true);
+    fsm_buzzer_set_action(p_fsm_buzzer, PLAY);
+    fsm_fire(p_fsm_buzzer);
+    port_system_delay_ms(NOTE_MS + 60);
+    UNITY_TEST_ASSERT_UINT32_WITHIN(TOLERANCE_MS, NOTE_MS + 60, _elapsed_ms(), __LINE__, "ERROR: The time played must be kept in sequencer mode");
+    fsm_buzzer_set_action(p_fsm_buzzer, STOP);
+    fsm_buzzer_set_sequencer(p_fsm_buzzer, false);
+    port_buzzer_stop(BUZZER_0_ID);
+
+    fsm_t *p_fsm_dma = fsm_buzzer_new(BUZZER_0_ID);
+    fsm_buzzer_set_melody(p_fsm_dma, &scale_melody);
+    fsm_buzzer_set_dma(p_fsm_dma, true);
+    fsm_buzzer_set_action(p_fsm_dma, PLAY);
+    fsm_fire(p_fsm_dma);
+    port_system_delay_ms(3 * NOTE_MS + 20);
+    uint32_t elapsed_ms;
+    uint32_t total_ms;
+    fsm_buzzer_get_progress(p_fsm_dma, &elapsed_ms, &total_ms);
+    UNITY_TEST_ASSERT_UINT32_WITHIN(TOLERANCE_MS, 3 * NOTE_MS + 20, elapsed_ms, __LINE__, "ERROR: The time played must be kept in DMA mode");
+    fsm_buzzer_set_action(p_fsm_dma, STOP);
+    fsm_destroy(p_fsm_dma);
+}
+
+void test_seek_playing(void)
+{
+    fsm_buzzer_t *p_fsm = (fsm_buzzer_t *)p_fsm_buzzer;
+    fsm_buzzer_set_gapless(p_fsm_buzzer, true);
+    fsm_buzzer_set_action(p_fsm_buzzer, PLAY);
+    fsm_fire(p_fsm_buzzer);
+    port_system_delay_ms(50);
+    UNITY_TEST_ASSERT(fsm_buzzer_seek(p_fsm_buzzer, 4 * NOTE_MS + 100), __LINE__, "ERROR: The player must seek while a note plays");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(5, p_fsm->note_index, __LINE__, "ERROR: The melody must go on after the note found");
+    UNITY_TEST_ASSERT_UINT32_WITHIN(TOLERANCE_MS, 4 * NOTE_MS + 100, _elapsed_ms(), __LINE__, "ERROR: The time played must be the time seeked");
+    UNITY_TEST_ASSERT_UINT32_WITHIN(TOLERANCE_MS, NOTE_MS - 100, _wait_note_end(), __LINE__, "ERROR: The note must start from the middle");
+    while (fsm_buzzer_get_action(p_fsm_buzzer) != STOP)
+    {
+        fsm_fire(p_fsm_buzzer);
+    }
+    int32_t drift_us = fsm_buzzer_get_drift_us(p_fsm_buzzer);
+    UNITY_TEST_ASSERT((drift_us < 1000) && (drift_us > -1000), __LINE__, "ERROR: The schedule must restart at the seek");
+}
+
+void test_seek_paused(void)
+{
+    fsm_buzzer_t *p_fsm = (fsm_buzzer_t *)p_fsm_buzzer;
+    fsm_buzzer_set_action(p_fsm_buzzer, PLAY);
+    fsm_fire(p_fsm_buzzer);
+    fsm_buzzer_set_action(p_fsm_buzzer, PAUSE);
+    while (p_fsm->f.current_state != PAUSE_NOTE)
+    {
+        fsm_fire(p_fsm_buzzer);
+    }
+    UNITY_TEST_ASSERT(fsm_buzzer_seek(p_fsm_buzzer, 6 * NOTE_MS + 200), __LINE__, "ERROR: The player must seek while paused");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(6 * NOTE_MS + 200, _elapsed_ms(), __LINE__, "ERROR: The time played must be the time seeked while paused");
+    fsm_buzzer_set_action(p_fsm_buzzer, PLAY);
+    fsm_fire(p_fsm_buzzer);
+    fsm_fire(p_fsm_buzzer);
+    UNITY_TEST_ASSERT_EQUAL_UINT32(7, p_fsm->note_index, __LINE__, "ERROR: The melody must resume after the note found");
+    UNITY_TEST_ASSERT_UINT32_WITHIN(TOLERANCE_MS, NOTE_MS - 200, _wait_note_end(), __LINE__, "ERROR: The note must resume from the middle");
+}
+
+void test_seek_invalid(void)
+{
+    UNITY_TEST_ASSERT(!fsm_buzzer_seek(p_fsm_buzzer, 100), __LINE__, "ERROR: A stopped player must not seek");
+    fsm_buzzer_set_action(p_fsm_buzzer, PLAY);
+    fsm_fire(p_fsm_buzzer);
+    UNITY_TEST_ASSERT(!fsm_buzzer_seek(p_fsm_buzzer, SCALE_MS), __LINE__, "ERROR: The player must not seek past the end of the melody");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(1, ((fsm_buzzer_t *)p_fsm_buzzer)->note_index, __LINE__, "ERROR: A failed seek must not move the player");
+}
+
+int main(void)
+{
+    port_system_init();
+    UNITY_BEGIN();
+    RUN_TEST(test_timeline_index);
+    RUN_TEST(test_timeline_stride);
+    RUN_TEST(test_progress);
+    RUN_TEST(test_progress_modes);
+    RUN_TEST(test_seek_playing);
+    RUN_TEST(test_seek_paused);
+    RUN_TEST(test_seek_invalid);
+    return UNITY_END();
+}
@@ -0,0 +1,420 @@
+#!/usr/bin/env python3
+"""Build the read-only melody bank of the jukebox from the melodies of melodies.c and from melody asset files.
+
+The bank is a single binary image (see melody_bank.h), little endian and 4-byte aligned:
+
+    melody_bank_t header        magic, version, number of melodies, size, offsets of the name index and of the hash
+    melody_bank_entry_t[n]      name, payload and timeline offsets, total duration, size of the tokens, length, tick,
+                                timeline stride and flags of each melody, in playlist order
+    uint16_t[n]                 entry numbers sorted by name (strcmp order), for the binary search by name
+    uint16_t[buckets]           displacements of the minimal perfect hash of the names
+    uint16_t[n]                 entry numbers, one per slot of the perfect hash
+    names                       NUL-terminated names
+    timelines                   uint32_t start times in ms of the notes 0, stride, 2 * stride... of each melody, then its
+                                total duration
+    payloads                    MIDI note numbers of each melody followed by its durations in ticks, or its tokens if it
+                                is packed
+
+The perfect hash is built with hash and displace: the names are spread into buckets by their hash with seed 0, and
+each bucket gets the smallest displacement that sends all its names to free slots when it is used as the seed. A
+lookup takes two hashes and one string comparison, whatever the number of melodies (see melody_bank_find()).
+
+The timeline of a melody has the start of one note every stride notes, with the smallest stride that keeps it within
+the MELODY_TIMELINE_MAX_ENTRIES entries of the timeline of the player (see melody_timeline.h). The player loads it as
+it is when it sets the melody, instead of walking its durations, which for a streamed melody would read it to the end.
+
+Compact melodies are copied as they are. The notes of melodies in Hz must be note defines of melodies.h: they are
+stored as MIDI note numbers, and their durations as ticks of the greatest common divisor of the durations. Every
+array must have exactly melody_length elements: C would fill the missing ones with zeros without a warning.
+
+Asset files (.rtttl and .mid, see melody_assets.py) are added after the melodies of melodies.c, sorted by file name.
+Their notes are moved by octaves into the range of the note table, and their durations are stored as ticks of their
+greatest common divisor, or of the smallest tick that fits the longest duration in one byte (durations are then
+rounded to whole ticks).
+
+With --pack-assets the payload of an asset is the tokens of a packed melody (see melody_codec.h) when they are smaller
+than its notes and durations, and its entry is flagged MELODY_BANK_FLAG_PACKED. The tokens are the same that
+melody_codec_encode() writes. The melodies of melodies.c are not packed: the jukebox chains them with no gap.
+
+Usage: build_melody_bank.py <melodies.h> <melodies.c> <output dir> <melody> [<melody> ...] [--assets <file> ...]
+                            [--pack-assets]
+The output dir gets melody_bank.bin (mapped by the native port), include/melody_bank_data.h and
+src/melody_bank_data.c (the same image as a const array, linked in flash).
+"""
+
+import argparse
+import math
+import os
+import re
+import struct
+
+from compile_melodies import MELODY_RE, FIELD_RE, strip_comments, parse_defines, value_of
+from gen_note_table import midi_number
+import melody_assets
+
+MAGIC = 0x4B4E424D  # "MBNK"
+VERSION = 5
+HEADER = struct.Struct('<IHHIIII')
+ENTRY = struct.Struct('<IIIIIHHHH')
+FLAG_PACKED = 0x0001  # MELODY_BANK_FLAG_PACKED
+MAX_TICKS = 255
+MAX_LENGTH = 65535
+HASH_BASIS = 2166136261
+HASH_PRIME = 16777619
+HASH_NAMES_PER_BUCKET = 2
+MAX_DISPLACEMENT = 65535
+TIMELINE_MAX_ENTRIES = 512  # MELODY_TIMELINE_MAX_ENTRIES
+# Tokens of a packed melody (see melody_codec.h)
+CODEC_NOTE = 0x00
+CODEC_NOTE_TICKS = 0x40
+CODEC_RUN = 0x80
+CODEC_SILENCE = 0xA0
+CODEC_SILENCE_TICKS = 0xA1
+CODEC_ABSOLUTE = 0xA2
+CODEC_ABSOLUTE_TICKS = 0xA3
+CODEC_BACKREF = 0xC0
+CODEC_DELTA_BIAS = 32
+CODEC_RUN_MAX_NOTES = 32
+CODEC_BACKREF_MIN_TOKENS = 2
+CODEC_BACKREF_MAX_TOKENS = 65
+CODEC_BACKREF_SIZE = 3
+CODEC_MAX_SIZE = 0x10000
+CODEC_INITIAL_PITCH = 60
+ARRAY_RE = re.compile(r'static\s+const\s+(double|uint16_t|uint8_t)\s+(\w+)\s*\[\s*(\w+)\s*\]\s*=\s*\{([^}]*)\}\s*;', re.S)
+TOKEN_RE = re.compile(r'MIDI_NOTE\(\s*(\w+)\s*,\s*(\d)\s*\)|([\w.]+)')
+
+
+def parse_arrays(text, defines):
+    """Return {name: list of tokens}. A token is a ('midi', number), ('name', define) or ('value', number)."""
+    arrays = {}
+    for _, name, length, body in ARRAY_RE.findall(text):
+        tokens = []
+        for note, octave, token in TOKEN_RE.findall(body):
+            if note:
+                tokens.append(('midi', midi_number(note + octave)))
+            elif token == 'MIDI_SILENCE':
+                tokens.append(('midi', 0))
+            elif token in defines:
+                tokens.append(('name', token))
+            else:
+                tokens.append(('value', value_of(token, defines, name)))
+        size = int(value_of(length, defines, name))
+        if len(tokens) != size:
+            raise SystemExit('build_melody_bank: %s has %d elements, not %d' % (name, len(tokens), size))
+        arrays[name] = tokens
+    return arrays
+
+
+def to_midi(token, where):
+    kind, value = token
+    if kind == 'midi':
+        return value
+    if kind == 'name':
+        if value == 'SILENCE':
+            return 0
+        number = midi_number(value)
+        if number is not None:
+            return number
+    elif value == 0:
+        return 0
+    raise SystemExit('build_melody_bank: %s: %r is not a note of melodies.h' % (where, value))
+
+
+def to_ticks(durations, where):
+    """Return (ticks, tick_ms) of durations in ms: ticks of their greatest common divisor, or of the smallest tick that
+    fits the longest duration in one byte."""
+    tick_ms = 0
+    for d in durations:
+        tick_ms = math.gcd(tick_ms, d)
+    tick_ms = max(tick_ms, 1, -(-max(durations, default=0) // MAX_TICKS))
+    ticks = [max(1, int(round(d / tick_ms))) if d > 0 else 0 for d in durations]
+    if tick_ms > 65535:
+        raise SystemExit('build_melody_bank: the durations of %s do not fit in ticks of one byte' % where)
+    return ticks, tick_ms
+
+
+def check_length(var, length, arrays):
+    for array in arrays:
+        if len(array) != length:
+            raise SystemExit('build_melody_bank: %s has %d elements in an array, but its length is %d' % (var, len(array), length))
+
+
+def parse_melodies(melodies_h, melodies_c):
+    """Return {variable name: (name, MIDI notes, ticks, tick_ms)} for every melody_t of melodies.c."""
+    h = strip_comments(open(melodies_h).read())
+    c = strip_comments(open(melodies_c).read())
+    defines = parse_defines(h, c)
+    arrays = parse_arrays(c, defines)
+    melodies = {}
+    for var, body in MELODY_RE.findall(c):
+        fields = dict(FIELD_RE.findall(body))
+        name = fields['p_name'].strip().strip('"')
+        length = int(value_of(fields['melody_length'], defines, var))
+        if 'p_notes' in fields:
+            check_length(var, length, (arrays[fields['p_notes']], arrays[fields['p_durations']]))
+            notes = [to_midi(t, var) for t in arrays[fields['p_notes']]]
+            durations = [int(t[1]) if t[0] == 'value' else int(value_of(t[1], defines, var)) for t in arrays[fields['p_durations']]]
+            ticks, tick_ms = to_ticks(durations, var)
+            if [t * tick_ms for t in ticks] != durations:
+                raise SystemExit('build_melody_bank: the durations of %s do not fit in ticks of one byte' % var)
+        else:
+            check_length(var, length, (arrays[fields['p_midi_notes']], arrays[fields['p_ticks']]))
+            notes = [to_midi(t, var) for t in arrays[fields['p_midi_notes']]]
+            ticks = [int(t[1]) for t in arrays[fields['p_ticks']]]
+            tick_ms = int(value_of(fields['tick_ms'], defines, var))
+        if max(ticks, default=0) > MAX_TICKS or tick_ms > 65535:
+            raise SystemExit('build_melody_bank: the durations of %s do not fit in ticks of one byte' % var)
+        melodies[var] = (name, notes, ticks, tick_ms)
+    return melodies
+
+
+def load_assets(paths, melodies_h):
+    """Return the melodies of asset files, sorted by file name, with their notes moved into the note table range."""
+    low, high = melody_assets.note_range(melodies_h)
+    melodies = []
+    for path in sorted(paths, key=os.path.basename):
+        try:
+            name, notes, durations = melody_assets.load(path)
+        except melody_assets.AssetError as e:
+            raise SystemExit('build_melody_bank: %s' % e)
+        if not 0 < len(notes) <= MAX_LENGTH:
+            raise SystemExit('build_melody_bank: %s has %d notes, it must have 1 to %d' % (path, len(notes), MAX_LENGTH))
+        notes, moved = melody_assets.clamp(notes, low, high)
+        if moved:
+            print('build_melody_bank: %s: %d notes moved by octaves into MIDI notes %d-%d' % (path, moved, low, high))
+        ticks, tick_ms = to_ticks(durations, path)
+        error = max(abs(t * tick_ms - d) for t, d in zip(ticks, durations))
+        if error:
+            print('build_melody_bank: %s: durations rounded to ticks of %d ms (error up to %d ms)' % (path, tick_ms, error))
+        melodies.append((name, notes, ticks, tick_ms))
+    return melodies
+
+
+def name_hash(name, seed):
+    """Hash of a name, as melody_bank_hash(): FNV-1a from a seeded basis and the final mix of MurmurHash3."""
+    h = HASH_BASIS ^ seed
+    for c in name:
+        h = ((h ^ c) * HASH_PRIME) & 0xFFFFFFFF
+    h ^= h >> 16
+    h = (h * 0x85EBCA6B) & 0xFFFFFFFF
+    h ^= h >> 13
+    h = (h * 0xC2B2AE35) & 0xFFFFFFFF
+    h ^= h >> 16
+    return h
+
+
+def perfect_hash(names):
+    """Return (displacements, slots) of a minimal perfect hash of the names: the name i is in the slot
+    name_hash(name, displacements[name_hash(name, 0) % buckets]) % n, and slots[slot] is i."""
+    n = len(names)
+    buckets = [[] for _ in range(max(1, -(-n // HASH_NAMES_PER_BUCKET)))]
+    for i, name in enumerate(names):
+        buckets[name_hash(name, 0) % len(buckets)].append(i)
+    displacements = [0] * len(buckets)
+    slots = [None] * n
+    # The largest buckets are placed first, while most slots are free
+    for b in sorted(range(len(buckets)), key=lambda b: -len(buckets[b])):
+        if not buckets[b]:
+            break
+        for d in range(1, MAX_DISPLACEMENT + 1):
+            candidates = [name_hash(names[i], d) % n for i in buckets[b]]
+            if len(set(candidates)) == len(candidates) and all(slots[c] is None for c in candidates):
+                break
+        else:
+            raise SystemExit('build_melody_bank: no perfect hash of the names of the melodies was found')
+        displacements[b] = d
+        for i, c in zip(buckets[b], candidates):
+            slots[c] = i
+    return displacements, slots
+
+
+def align(data, alignment=4):
+    return data + b'\0' * (-len(data) % alignment)
+
+
+def timeline(ticks, tick_ms):
+    """Return (stride, start times) of a melody: the start in ms of the notes 0, stride, 2 * stride... and the total."""
+    stride = max(1, -(-len(ticks) // TIMELINE_MAX_ENTRIES))
+    starts = []
+    time_ms = 0
+    for i, t in enumerate(ticks):
+        if i % stride == 0:
+            starts.append(time_ms)
+        time_ms += t * tick_ms
+    return stride, starts + [time_ms]
+
+
+def literal_tokens(notes, ticks):
+    """Return the tokens of a melody with no back-references, as _encode_literal() of melody_codec.c."""
+    tokens = []
+    pitch = CODEC_INITIAL_PITCH
+    last_ticks = 0
+    i = 0
+    while i < len(notes):
+        # A note repeated twice or more is a run: repeated once, a note token is as short
+        repeats = 0
+        while (i > 0 and i + repeats < len(notes) and repeats < CODEC_RUN_MAX_NOTES and
+               notes[i + repeats] == notes[i - 1] and ticks[i + repeats] == ticks[i - 1]):
+            repeats += 1
+        if repeats >= 2:
+            tokens.append(bytes([CODEC_RUN | (repeats - 1)]))
+            i += repeats
+            continue
+        new_ticks = ticks[i] != last_ticks
+        delta = notes[i] - pitch
+        if notes[i] == 0:
+            tokens.append(bytes([CODEC_SILENCE_TICKS, ticks[i]]) if new_ticks else bytes([CODEC_SILENCE]))
+        elif -CODEC_DELTA_BIAS <= delta < CODEC_DELTA_BIAS:
+            token = (CODEC_NOTE_TICKS if new_ticks else CODEC_NOTE) | (delta + CODEC_DELTA_BIAS)
+            tokens.append(bytes([token, ticks[i]]) if new_ticks else bytes([token]))
+            pitch = notes[i]
+        else:
+            tokens.append(bytes([CODEC_ABSOLUTE_TICKS, notes[i], ticks[i]]) if new_ticks else bytes([CODEC_ABSOLUTE, notes[i]]))
+            pitch = notes[i]
+        last_ticks = ticks[i]
+        i += 1
+    return tokens
+
+
+def pack(notes, ticks):
+    """Return the tokens of a packed melody, as melody_codec_encode(): each phrase that repeats tokens already written
+    is replaced by the longest back-reference to them, the first one found on a tie."""
+    tokens = literal_tokens(notes, ticks)
+    out = []  # (offset, token, back-reference)
+    size = 0
+    i = 0
+    while i < len(tokens):
+        best_size, best_source, best_tokens = CODEC_BACKREF_SIZE, 0, 0
+        for j, (source, _, _) in enumerate(out):
+            if source >= CODEC_MAX_SIZE:
+                break
+            n = 0
+            match_size = 0
+            while (n < CODEC_BACKREF_MAX_TOKENS and j + n < len(out) and i + n < len(tokens) and not out[j + n][2] and
+                   out[j + n][1] == tokens[i + n]):
+                match_size += len(tokens[i + n])
+                n += 1
+            if n >= CODEC_BACKREF_MIN_TOKENS and match_size > best_size:
+                best_size, best_source, best_tokens = match_size, source, n
+        if best_tokens:
+            token = bytes([CODEC_BACKREF | (best_tokens - CODEC_BACKREF_MIN_TOKENS), best_source & 0xFF, best_source >> 8])
+            out.append((size, token, True))
+            i += best_tokens
+        else:
+            token = tokens[i]
+            out.append((size, token, False))
+            i += 1
+        size += len(token)
+    return b''.join(token for _, token, _ in out) if size <= CODEC_MAX_SIZE else None
+
+
+def build(melodies, packed=()):
+    """Return the image of the bank with the melodies in the given order. The melodies whose index is in packed are
+    stored as tokens when they are smaller than their notes and durations."""
+    n = len(melodies)
+    if len({m[0] for m in melodies}) != n:
+        raise SystemExit('build_melody_bank: the names of the melodies must be unique')
+    displacements, slots = perfect_hash([m[0].encode() for m in melodies])
+    index_offset = HEADER.size + n * ENTRY.size
+    hash_offset = index_offset + ((2 * n + 3) & ~3)
+    names_offset = hash_offset + ((2 * (len(displacements) + n) + 3) & ~3)
+    names = b''
+    name_offsets = []
+    for name, _, _, _ in melodies:
+        name_offsets.append(names_offset + len(names))
+        names += name.encode() + b'\0'
+    timelines_offset = names_offset + len(align(names))
+    timelines = b''
+    strides = []
+    timeline_offsets = []
+    for _, _, ticks, tick_ms in melodies:
+        stride, starts = timeline(ticks, tick_ms)
+        strides.append(stride)
+        timeline_offsets.append(timelines_offset + len(timelines))
+        timelines += struct.pack('<%dI' % len(starts), *starts)
+    payload_offset = timelines_offset + len(timelines)
+    payloads = b''
+    entries = b''
+    for i, ((name, notes, ticks, tick_ms), name_offset, timeline_offset, stride) in enumerate(zip(melodies, name_offsets, timeline_offsets, strides)):
+        payload = bytes(notes) + bytes(ticks)
+        tokens = pack(notes, ticks) if i in packed else None
+        if tokens is not None and len(tokens) < len(payload):
+            entries += ENTRY.pack(name_offset, payload_offset + len(payloads), sum(ticks) * tick_ms, timeline_offset, len(tokens), len(notes), tick_ms, stride, FLAG_PACKED)
+            payload = tokens
+        else:
+            entries += ENTRY.pack(name_offset, payload_offset + len(payloads), sum(ticks) * tick_ms, timeline_offset, 0, len(notes), tick_ms, stride, 0)
+        payloads += payload
+    order = sorted(range(n), key=lambda i: melodies[i][0].encode())
+    index = align(struct.pack('<%dH' % n, *order))
+    table = align(struct.pack('<%dH' % (len(displacements) + n), *(displacements + slots)))
+    body = entries + index + table + align(names) + timelines + align(payloads)
+    return HEADER.pack(MAGIC, VERSION, n, HEADER.size + len(body), index_offset, hash_offset, len(displacements)) + body
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument('melodies_h')
+    parser.add_argument('melodies_c')
+    parser.add_argument('output_dir')
+    parser.add_argument('melody', nargs='+', help='melody_t variables of melodies.c, in playlist order')
+    parser.add_argument('--assets', nargs='*', default=[], help='.rtttl and .mid files, added after the melodies')
+    parser.add_argument('--pack-assets', action='store_true', help='store the assets as packed melodies')
+    args = parser.parse_args()
+
+    melodies = parse_melodies(args.melodies_h, args.melodies_c)
+    missing = [m for m in args.melody if m not in melodies]
+    if missing:
+        raise SystemExit('build_melody_bank: no melody_t named %s in %s' % (', '.join(missing), args.melodies_c))
+    assets = load_assets(args.assets, args.melodies_h)
+    packed = range(len(args.melody), len(args.melody) + len(assets)) if args.pack_assets else ()
+    image = build([melodies[m] for m in args.melody] + assets, packed)
+
+    os.makedirs(os.path.join(args.output_dir, 'include'), exist_ok=True)
+    os.makedirs(os.path.join(args.output_dir, 'src'), exist_ok=True)
+    bin_path = os.path.abspath(os.path.join(args.output_dir, 'melody_bank.bin'))
+    with open(bin_path, 'wb') as f:
+        f.write(image)
+
+    with open(os.path.join(args.output_dir, 'include', 'melody_bank_data.h'), 'w') as f:
+        f.write('''/**
+ * @file melody_bank_data.h
+ * @brief Melody bank of the jukebox, built from melodies.c and the melody assets.
+ *
+ * Generated by tools/build_melody_bank.py. Do not edit.
+ */
+#ifndef MELODY_BANK_DATA_H_
+#define MELODY_BANK_DATA_H_
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+
+/* Defines and enums ----------------------------------------------------------*/
+#define MELODY_BANK_DATA_SIZE %dU /*!< Size of the melody bank in bytes */
+#define MELODY_BANK_DATA_PATH "%s" /*!< Path of the same melody bank as a file */
+
+/* Global variables */
+extern const uint8_t melody_bank_data[MELODY_BANK_DATA_SIZE]; /*!< Melody bank image, 4-byte aligned */
+
+#endif /* MELODY_BANK_DATA_H_ */
+''' % (len(image), bin_path))
+
+    with open(os.path.join(args.output_dir, 'src', 'melody_bank_data.c'), 'w') as f:
+        f.write('''/**
+ * @file melody_bank_data.c
+ * @brief Melody bank of the jukebox: %s.
+ *
+ * Generated by tools/build_melody_bank.py. Do not edit.
+ */
+/* Includes ------------------------------------------------------------------*/
+#include "melody_bank_data.h"
+
+/* Global variables */
+const uint8_t melody_bank_data[MELODY_BANK_DATA_SIZE] __attribute__((aligned(4))) = {
+''' % ', '.join(args.melody + [m[0] for m in assets]))
+        for i in range(0, len(image), 16):
+            f.write('    %s,\n' % ', '.join('0x%02x' % b for b in image[i:i + 16]))
+        f.write('};\n')
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,139 @@
+#!/usr/bin/env python3
+"""Compile the melodies of melodies.c into ready-to-load timer register values.
+
+Every note of every melody_t is turned into the TIM3 (PWM) PSC/ARR/CCR words and the TIM2 (note duration) PSC/ARR
+words that the buzzer port loads with port_buzzer_set_note_regs(). The player then changes notes with a few register
+stores and no arithmetic (see fsm_buzzer.c). The PWM registers are solved for the lowest pitch error, as in
+gen_note_table.py. The duration registers are computed exactly as port_buzzer_set_note_duration() does.
+Compact melodies (MIDI note numbers and ticks, no p_notes) are not compiled.
+
+Usage: compile_melodies.py <melodies.h> <melodies.c> <output dir> [--clock-hz 16000000] [--duty-cycle 0.5]
+The output dir gets src/compiled_melodies_data.c.
+"""
+
+import argparse
+import os
+import re
+import sys
+
+from gen_note_table import solve
+
+DEFINE_RE = re.compile(r'^\s*#define\s+(\w+)\s+([0-9.]+)', re.M)
+ARRAY_RE = re.compile(r'static\s+const\s+(double|uint16_t)\s+(\w+)\s*\[\s*(\w+)\s*\]\s*=\s*\{([^}]*)\}\s*;', re.S)
+MELODY_RE = re.compile(r'const\s+melody_t\s+(\w+)\s*=\s*\{(.*?)\}\s*;', re.S)
+FIELD_RE = re.compile(r'\.(\w+)\s*=\s*(?:\([^)]*\))?\s*([^,]+?)\s*(?:,|$)', re.S)
+
+
+def strip_comments(text):
+    text = re.sub(r'/\*.*?\*/', '', text, flags=re.S)
+    return re.sub(r'//[^\n]*', '', text)
+
+
+def parse_defines(*texts):
+    defines = {}
+    for text in texts:
+        for name, value in DEFINE_RE.findall(text):
+            defines[name] = float(value)
+    return defines
+
+
+def value_of(token, defines, where):
+    token = token.strip()
+    if token in defines:
+        return defines[token]
+    try:
+        return float(token)
+    except ValueError:
+        raise SystemExit('compile_melodies: cannot evaluate "%s" in %s' % (token, where))
+
+
+def parse_melodies(melodies_h, melodies_c):
+    h = strip_comments(open(melodies_h).read())
+    c = strip_comments(open(melodies_c).read())
+    defines = parse_defines(h, c)
+    arrays = {}
+    for ctype, name, length, body in ARRAY_RE.findall(c):
+        values = [value_of(t, defines, name) for t in body.split(',') if t.strip()]
+        size = int(value_of(length, defines, name))
+        if len(values) > size:
+            raise SystemExit('compile_melodies: %s has %d elements, more than its length %d' % (name, len(values), size))
+        if len(values) < size:
+            # Same as the C compiler: the missing elements are zero
+            print('compile_melodies: warning: %s has %d elements, %d are zero' % (name, len(values), size - len(values)), file=sys.stderr)
+            values += [0.0] * (size - len(values))
+        arrays[name] = values
+    melodies = []
+    for name, body in MELODY_RE.findall(c):
+        fields = dict(FIELD_RE.findall(body))
+        if 'p_notes' not in fields:
+            continue  # Compact melodies are played from the note table: compiling them would undo their size
+        notes = arrays[fields['p_notes']]
+        durations = arrays[fields['p_durations']]
+        length = int(value_of(fields['melody_length'], defines, name))
+        if length > len(notes) or length > len(durations):
+            raise SystemExit('compile_melodies: %s is longer than its notes or durations' % name)
+        melodies.append((name, notes[:length], [int(d) for d in durations[:length]]))
+    return melodies
+
+
+def duration_regs(clock_hz, duration_ms):
+    """Same integer arithmetic as port_buzzer_set_note_duration()."""
+    ticks = max(1, (clock_hz // 1000) * duration_ms)
+    psc = (ticks + 32768) // 65536
+    psc = psc - 1 if psc > 0 else 0
+    arr = (ticks + (psc + 1) // 2) // (psc + 1) - 1
+    if arr > 65535:
+        psc += 1
+        arr = (ticks + (psc + 1) // 2) // (psc + 1) - 1
+    if psc > 65535:
+        raise SystemExit('compile_melodies: a note of %d ms does not fit in the note duration timer' % duration_ms)
+    return psc, arr
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument('melodies_h')
+    parser.add_argument('melodies_c')
+    parser.add_argument('output_dir')
+    parser.add_argument('--clock-hz', type=int, default=16000000, help='Timer input clock (default: HSI, 16 MHz)')
+    parser.add_argument('--duty-cycle', type=float, default=0.5, help='PWM duty cycle 0-1 (BUZZER_PWM_DC)')
+    args = parser.parse_args()
+
+    melodies = parse_melodies(args.melodies_h, args.melodies_c)
+    pwm_cache = {}
+
+    os.makedirs(os.path.join(args.output_dir, 'src'), exist_ok=True)
+    with open(os.path.join(args.output_dir, 'src', 'compiled_melodies_data.c'), 'w') as f:
+        f.write('''/**
+ * @file compiled_melodies_data.c
+ * @brief Melodies of melodies.c compiled into timer register values.
+ *
+ * Generated by tools/compile_melodies.py. Do not edit.
+ */
+/* Includes ------------------------------------------------------------------*/
+#include "compiled_melodies.h"
+
+/* Global variables */
+const uint32_t compiled_melodies_clock_hz = %dU; /*!< Timer clock the melodies have been compiled for */
+''' % args.clock_hz)
+        for name, notes, durations in melodies:
+            f.write('\nstatic const port_buzzer_note_regs_t %s_regs[%d] = {\n' % (name, len(notes)))
+            for freq, duration in zip(notes, durations):
+                if freq == 0:
+                    pwm = (0, 0, 0)
+                else:
+                    if freq not in pwm_cache:
+                        psc, arr, _ = solve(args.clock_hz, freq)
+                        pwm_cache[freq] = (psc, arr, int(args.duty_cycle * (arr + 1)))
+                    pwm = pwm_cache[freq]
+                dur = duration_regs(args.clock_hz, duration)
+                f.write('    {%d, %d, %d, %d, %d}, /* %r Hz, %d ms */\n' % (pwm + dur + (freq, duration)))
+            f.write('};\n')
+        f.write('\nconst compiled_melody_t compiled_melodies[] = {\n')
+        for name, notes, _ in melodies:
+            f.write('    {.p_source = &%s, .p_regs = %s_regs, .melody_length = %d},\n' % (name, name, len(notes)))
+        f.write('};\n\nconst uint32_t compiled_melodies_length = %d; /*!< Number of compiled melodies */\n' % len(melodies))
+
+
+if __name__ == '__main__':
+    main()
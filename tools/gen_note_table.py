@@ -0,0 +1,268 @@
+#!/usr/bin/env python3
+"""Generate the table of pre-solved TIM3 PSC/ARR/CCR values for every note of melodies.h.
+
+For each note define (DO1 ... SI8 and SILENCE) the prescaler and auto-reload values are searched for the lowest
+pitch error of the PWM signal, so the buzzer port can load them straight into the timer registers instead of
+computing them with double precision arithmetic on every note.
+
+The table is also indexed by MIDI note number (DO4 is 60), which is how the notes of compact melodies are stored.
+
+Usage: gen_note_table.py <melodies.h> <output dir> [--clock-hz 16000000] [--duty-cycle 0.5]
+The output dir gets include/note_table.h and src/note_table.c.
+"""
+
+import argparse
+import math
+import os
+import re
+
+TIMER_MAX = 65535  # TIM3 is a 16-bit timer: PSC and ARR are 16-bit registers
+NOTE_RE = re.compile(r'^\s*#define\s+((?:DO|RE|MI|FA|SOL|LA|SI)s?[1-8]|SILENCE)\s+([0-9.]+)')
+NAME_RE = re.compile(r'^(DO|RE|MI|FA|SOL|LA|SI)(s?)([1-8])$')
+SEMITONES = {'DO': 0, 'RE': 2, 'MI': 4, 'FA': 5, 'SOL': 7, 'LA': 9, 'SI': 11}
+
+
+def parse_notes(path):
+    """Return a list of (name, frequency) with the note defines of melodies.h, in order of appearance."""
+    notes = []
+    with open(path) as f:
+        for line in f:
+            m = NOTE_RE.match(line)
+            if m:
+                notes.append((m.group(1), float(m.group(2))))
+    return notes
+
+
+def midi_number(name):
+    """MIDI note number of a note define (DO4 is 60), or None for SILENCE."""
+    m = NAME_RE.match(name)
+    if not m:
+        return None
+    return 12 * (int(m.group(3)) + 1) + SEMITONES[m.group(1)] + (1 if m.group(2) else 0)
+
+
+def to_q16(frequency_hz):
+    """Frequency in Q16.16 fixed point, rounded as PORT_BUZZER_HZ_Q16() does."""
+    return int(frequency_hz * 65536.0 + 0.5)
+
+
+def cents(f_out, f):
+    """Pitch error in cents."""
+    return abs(1200.0 * math.log2(f_out / f))
+
+
+def solve(clock_hz, frequency_hz):
+    """Return (psc, arr, error_cents) with the lowest pitch error. Ties keep the lowest PSC (finest resolution)."""
+    n = clock_hz / frequency_hz  # timer clock periods per PWM period
+    best = None
+    psc_min = max(0, math.ceil(n / (TIMER_MAX + 1)) - 1)
+    for psc in range(psc_min, TIMER_MAX + 1):
+        period = n / (psc + 1)
+        if period < 2:
+            break
+        for arr in {math.floor(period) - 1, math.ceil(period) - 1}:
+            if arr < 1 or arr > TIMER_MAX:
+                continue
+            err = cents(clock_hz / ((psc + 1) * (arr + 1)), frequency_hz)
+            if best is None or err < best[2] - 1e-12:
+                best = (psc, arr, err)
+        if best[2] == 0.0:
+            break
+    return best
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument('melodies_h')
+    parser.add_argument('output_dir')
+    parser.add_argument('--clock-hz', type=int, default=16000000, help='TIM3 input clock (default: HSI, 16 MHz)')
+    parser.add_argument('--duty-cycle', type=float, default=0.5, help='PWM duty cycle 0-1 (BUZZER_PWM_DC)')
+    args = parser.parse_args()
+
+    notes = parse_notes(args.melodies_h)
+    if not notes:
+        raise SystemExit('gen_note_table: no note defines found in ' + args.melodies_h)
+
+    rows = []
+    for name, freq in notes:
+        if freq == 0:
+            rows.append((freq, name, 0, 0, 0, 0.0))
+            continue
+        psc, arr, err = solve(args.clock_hz, freq)
+        ccr = int(args.duty_cycle * (arr + 1))
+        rows.append((freq, name, psc, arr, ccr, err))
+    # Sorted by frequency for the binary search. Notes with the same frequency share one entry
+    rows.sort(key=lambda r: r[0])
+    unique = []
+    for r in rows:
+        if unique and unique[-1][0] == r[0]:
+            continue
+        unique.append(r)
+    max_err = max(r[5] for r in unique)
+    index = {r[0]: i for i, r in enumerate(unique)}
+    midi = {}
+    for name, freq in notes:
+        number = midi_number(name)
+        if number is not None:
+            midi[number] = index[freq]
+    midi_first = min(midi)
+    midi_last = max(midi)
+    if len(midi) != midi_last - midi_first + 1:
+        raise SystemExit('gen_note_table: the note defines must be consecutive semitones')
+
+    os.makedirs(os.path.join(args.output_dir, 'include'), exist_ok=True)
+    os.makedirs(os.path.join(args.output_dir, 'src'), exist_ok=True)
+
+    with open(os.path.join(args.output_dir, 'include', 'note_table.h'), 'w') as f:
+        f.write('''/**
+ * @file note_table.h
+ * @brief Pre-solved TIM3 register values for the notes of melodies.h.
+ *
+ * Generated by tools/gen_note_table.py. Do not edit.
+ */
+#ifndef NOTE_TABLE_H_
+#define NOTE_TABLE_H_
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+
+/* Defines and enums ----------------------------------------------------------*/
+#define NOTE_TABLE_LENGTH %d /*!< Number of entries of the note table */
+#define NOTE_TABLE_CLOCK_HZ %dU /*!< Timer clock the table has been solved for */
+#define NOTE_TABLE_PWM_DC %r /*!< PWM duty cycle used to compute CCR */
+#define NOTE_TABLE_MAX_ERROR_CENTS %.4f /*!< Worst pitch error of the table in cents */
+#define NOTE_TABLE_MIDI_FIRST %d /*!< MIDI note number of the first entry of note_table_midi */
+#define NOTE_TABLE_MIDI_LENGTH %d /*!< Number of entries of note_table_midi */
+
+/* Typedefs --------------------------------------------------------------------*/
+/**
+ * @brief Register values of the PWM timer for a note.
+ *
+ */
+typedef struct
+{
+    double frequency_hz; /*!< Frequency of the note as written in melodies.h */
+    uint32_t frequency_q16; /*!< Frequency of the note in Hz, Q16.16 fixed point */
+    uint16_t psc;        /*!< Prescaler */
+    uint16_t arr;        /*!< Auto-reload value */
+    uint16_t ccr;        /*!< Capture/compare value */
+} note_regs_t;
+
+/* Global variables */
+extern const note_regs_t note_table[NOTE_TABLE_LENGTH]; /*!< Note table, sorted by frequency */
+extern const note_regs_t *const note_table_midi[NOTE_TABLE_MIDI_LENGTH]; /*!< Entries of the note table by MIDI note number, from NOTE_TABLE_MIDI_FIRST */
+
+/* Function prototypes and explanation -------------------------------------------------*/
+/**
+ * @brief Find the register values of a note. The frequency must be exactly one of the note defines.
+ *
+ * @param frequency_hz Frequency of the note in Hz
+ * @return const note_regs_t* Entry of the table, or NULL if the frequency is not in the table
+ */
+const note_regs_t *note_table_find(double frequency_hz);
+
+/**
+ * @brief Find the register values of a note by its frequency in fixed point. The frequency must be exactly one of the note defines
+ * rounded to Q16.16.
+ *
+ * @param frequency_q16 Frequency of the note in Hz, Q16.16 fixed point
+ * @return const note_regs_t* Entry of the table, or NULL if the frequency is not in the table
+ */
+const note_regs_t *note_table_find_q16(uint32_t frequency_q16);
+
+/**
+ * @brief Find the register values of a note by its MIDI note number (DO4 is 60). The equal-temperament frequencies are the note
+ * defines of melodies.h.
+ *
+ * @param midi_note MIDI note number
+ * @return const note_regs_t* Entry of the table, or NULL if the note is out of the table
+ */
+const note_regs_t *note_table_find_midi(uint8_t midi_note);
+
+#endif /* NOTE_TABLE_H_ */
+''' % (len(unique), args.clock_hz, args.duty_cycle, max_err, midi_first, midi_last - midi_first + 1))
+
+    with open(os.path.join(args.output_dir, 'src', 'note_table.c'), 'w') as f:
+        f.write('''/**
+ * @file note_table.c
+ * @brief Pre-solved TIM3 register values for the notes of melodies.h.
+ *
+ * Generated by tools/gen_note_table.py. Do not edit.
+ */
+/* Includes ------------------------------------------------------------------*/
+#include <stddef.h>
+#include "note_table.h"
+
+/* Global variables */
+const note_regs_t note_table[NOTE_TABLE_LENGTH] = {
+''')
+        for freq, name, psc, arr, ccr, err in unique:
+            f.write('    {%r, %dU, %d, %d, %d}, /* %s: %.4f cents */\n' % (freq, to_q16(freq), psc, arr, ccr, name, err))
+        f.write('''};
+
+const note_regs_t *const note_table_midi[NOTE_TABLE_MIDI_LENGTH] = {
+''')
+        for number in range(midi_first, midi_last + 1):
+            f.write('    &note_table[%d], /* %d: %s */\n' % (midi[number], number, unique[midi[number]][1]))
+        f.write('''};
+
+/* Public functions */
+const note_regs_t *note_table_find(double frequency_hz)
+{
+    uint32_t low = 0;
+    uint32_t high = NOTE_TABLE_LENGTH;
+    while (low < high)
+    {
+        uint32_t mid = (low + high) / 2;
+        if (note_table[mid].frequency_hz < frequency_hz)
+        {
+            low = mid + 1;
+        }
+        else
+        {
+            high = mid;
+        }
+    }
+    if ((low < NOTE_TABLE_LENGTH) && (note_table[low].frequency_hz == frequency_hz))
+    {
+        return &note_table[low];
+    }
+    return NULL;
+}
+
+const note_regs_t *note_table_find_q16(uint32_t frequency_q16)
+{
+    uint32_t low = 0;
+    uint32_t high = NOTE_TABLE_LENGTH;
+    while (low < high)
+    {
+        uint32_t mid = (low + high) / 2;
+        if (note_table[mid].frequency_q16 < frequency_q16)
+        {
+            low = mid + 1;
+        }
+        else
+        {
+            high = mid;
+        }
+    }
+    if ((low < NOTE_TABLE_LENGTH) && (note_table[low].frequency_q16 == frequency_q16))
+    {
+        return &note_table[low];
+    }
+    return NULL;
+}
+
+const note_regs_t *note_table_find_midi(uint8_t midi_note)
+{
+    if ((midi_note < NOTE_TABLE_MIDI_FIRST) || (midi_note >= NOTE_TABLE_MIDI_FIRST + NOTE_TABLE_MIDI_LENGTH))
+    {
+        return NULL;
+    }
+    return note_table_midi[midi_note - NOTE_TABLE_MIDI_FIRST];
+}
+''')
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,255 @@
+#!/usr/bin/env python3
+"""Import melodies from RTTTL (.rtttl) and Standard MIDI (.mid) files.
+
+Every file becomes one monophonic compact melody: MIDI note numbers (0 is a silence) and durations in ms. Of a MIDI
+file only the lead track is used, the one with the highest mean pitch (the percussion channel is ignored), reduced to
+the highest note sounding at each moment. Notes out of the range of the note table are moved by octaves into it.
+
+Usage as a script, to check files: melody_assets.py <melodies.h> <file> [<file> ...]
+"""
+
+import os
+import struct
+import sys
+
+from gen_note_table import parse_notes, midi_number
+
+RTTTL_NOTES = {'c': 0, 'd': 2, 'e': 4, 'f': 5, 'g': 7, 'a': 9, 'b': 11, 'h': 11}
+RTTTL_DURATIONS = (1, 2, 4, 8, 16, 32)
+MIDI_PERCUSSION_CHANNEL = 9
+
+
+class AssetError(Exception):
+    pass
+
+
+def note_range(melodies_h):
+    """Lowest and highest MIDI note numbers of the note table, i.e. the notes the PWM timer is solved for."""
+    numbers = [midi_number(name) for name, _ in parse_notes(melodies_h)]
+    numbers = [n for n in numbers if n is not None]
+    return min(numbers), max(numbers)
+
+
+def clamp(notes, low, high):
+    """Move the notes out of [low, high] by octaves into it. Return the notes and the number of notes moved."""
+    moved = 0
+    out = []
+    for n in notes:
+        if n != 0 and not low <= n <= high:
+            while n < low:
+                n += 12
+            while n > high:
+                n -= 12
+            moved += 1
+        out.append(n)
+    return out, moved
+
+
+def parse_rtttl(text, where):
+    """Return (name, notes, durations in ms) of an RTTTL ringtone: <name>:d=<dur>,o=<oct>,b=<bpm>:<notes>."""
+    parts = ''.join(text.split()).split(':')
+    if len(parts) != 3:
+        raise AssetError('%s: an RTTTL melody must be <name>:<defaults>:<notes>' % where)
+    name, defaults, body = parts
+    settings = {'d': 4, 'o': 6, 'b': 63}
+    for item in filter(None, defaults.lower().split(',')):
+        key, _, value = item.partition('=')
+        if key not in settings or not value.isdigit():
+            raise AssetError('%s: wrong RTTTL default "%s"' % (where, item))
+        settings[key] = int(value)
+    if settings['b'] <= 0 or settings['d'] not in RTTTL_DURATIONS:
+        raise AssetError('%s: wrong RTTTL defaults "%s"' % (where, defaults))
+    whole_ms = 60000.0 * 4 / settings['b']
+    notes = []
+    durations = []
+    for token in filter(None, body.lower().split(',')):
+        i = 0
+        digits = ''
+        while i < len(token) and token[i].isdigit():
+            digits += token[i]
+            i += 1
+        duration = int(digits) if digits else settings['d']
+        if duration not in RTTTL_DURATIONS or i >= len(token) or token[i] not in RTTTL_NOTES and token[i] != 'p':
+            raise AssetError('%s: wrong RTTTL note "%s"' % (where, token))
+        letter = token[i]
+        i += 1
+        sharp = i < len(token) and token[i] == '#'
+        i += sharp
+        dotted = i < len(token) and token[i] == '.'
+        i += dotted
+        octave = settings['o']
+        if i < len(token) and token[i].isdigit():
+            octave = int(token[i])
+            i += 1
+        if i < len(token) and token[i] == '.':
+            dotted = True
+            i += 1
+        if i != len(token):
+            raise AssetError('%s: wrong RTTTL note "%s"' % (where, token))
+        ms = whole_ms / duration * (1.5 if dotted else 1.0)
+        notes.append(0 if letter == 'p' else 12 * (octave + 1) + RTTTL_NOTES[letter] + sharp)
+        durations.append(int(round(ms)))
+    return name or os.path.splitext(os.path.basename(where))[0], notes, durations
+
+
+def _read_vlq(data, pos):
+    value = 0
+    for _ in range(4):
+        byte = data[pos]
+        pos += 1
+        value = (value << 7) | (byte & 0x7F)
+        if not byte & 0x80:
+            return value, pos
+    raise AssetError('variable length quantity longer than 4 bytes')
+
+
+def _read_track(data, where):
+    """Return the events of a track: (tick, kind, value) with kind 'on', 'off' (value = note) or 'tempo' (value = us per quarter)."""
+    events = []
+    pos = 0
+    tick = 0
+    status = 0
+    while pos < len(data):
+        delta, pos = _read_vlq(data, pos)
+        tick += delta
+        if data[pos] & 0x80:
+            status = data[pos]
+            pos += 1
+        elif status == 0:
+            raise AssetError('%s: running status with no previous status' % where)
+        if status == 0xFF:
+            kind = data[pos]
+            length, pos = _read_vlq(data, pos + 1)
+            if kind == 0x51 and length == 3:
+                events.append((tick, 'tempo', int.from_bytes(data[pos:pos + 3], 'big')))
+            pos += length
+            status = 0
+            if kind == 0x2F:
+                break
+        elif status in (0xF0, 0xF7):
+            length, pos = _read_vlq(data, pos)
+            pos += length
+            status = 0
+        else:
+            command = status & 0xF0
+            channel = status & 0x0F
+            size = 1 if command in (0xC0, 0xD0) else 2
+            args = data[pos:pos + size]
+            pos += size
+            if channel == MIDI_PERCUSSION_CHANNEL or command not in (0x80, 0x90):
+                continue
+            if command == 0x90 and args[1] > 0:
+                events.append((tick, 'on', args[0]))
+            else:
+                events.append((tick, 'off', args[0]))
+    return events
+
+
+def parse_midi(data, where):
+    """Return (name, notes, durations in ms) of a Standard MIDI File (format 0 or 1, ticks per quarter note)."""
+    if data[:4] != b'MThd':
+        raise AssetError('%s: not a Standard MIDI File' % where)
+    length, fmt, ntracks, division = struct.unpack('>IHHH', data[4:14])
+    if fmt not in (0, 1):
+        raise AssetError('%s: MIDI format %d is not supported' % (where, fmt))
+    if division & 0x8000:
+        raise AssetError('%s: SMPTE time division is not supported' % where)
+    pos = 8 + length
+    tempos = []
+    lead = []
+    for _ in range(ntracks):
+        if data[pos:pos + 4] != b'MTrk':
+            raise AssetError('%s: missing track chunk' % where)
+        size = struct.unpack('>I', data[pos + 4:pos + 8])[0]
+        try:
+            events = _read_track(data[pos + 8:pos + 8 + size], where)
+        except IndexError:
+            raise AssetError('%s: truncated track' % where)
+        pos += 8 + size
+        tempos += [e for e in events if e[1] == 'tempo']
+        pitches = [e[2] for e in events if e[1] == 'on']
+        if pitches and (not lead or sum(pitches) / len(pitches) > lead[0]):
+            lead = [sum(pitches) / len(pitches), [e for e in events if e[1] != 'tempo']]
+    if not lead:
+        raise AssetError('%s: no notes' % where)
+    events = tempos + lead[1]
+    # Tempo changes first at the same tick; note offs before note ons
+    order = {'tempo': 0, 'off': 1, 'on': 2}
+    events.sort(key=lambda e: (e[0], order[e[1]]))
+
+    tempo = 500000  # us per quarter note until the first tempo event
+    last_tick = 0
+    time_us = 0.0
+    sounding = {}
+    segments = []  # (start in us, note)
+
+    def top():
+        return max(sounding) if sounding else 0
+
+    for tick, kind, value in events:
+        time_us += (tick - last_tick) * tempo / division
+        last_tick = tick
+        if kind == 'tempo':
+            tempo = value
+            continue
+        before = top()
+        if kind == 'on':
+            sounding[value] = sounding.get(value, 0) + 1
+        elif value in sounding:
+            sounding[value] -= 1
+            if sounding[value] == 0:
+                del sounding[value]
+        after = top()
+        if after != before or (kind == 'on' and value == after):
+            if segments and segments[-1][0] == time_us:
+                segments[-1] = (time_us, after)
+            else:
+                segments.append((time_us, after))
+    notes = []
+    durations = []
+    for (start, note), (end, _) in zip(segments, segments[1:] + [(time_us, 0)]):
+        ms = int(round(end / 1000.0)) - int(round(start / 1000.0))
+        if ms <= 0:
+            continue
+        if notes and note == 0 and notes[-1] == 0:
+            durations[-1] += ms
+            continue
+        notes.append(note)
+        durations.append(ms)
+    # Leading and trailing silences are not part of the melody
+    while notes and notes[0] == 0:
+        notes.pop(0)
+        durations.pop(0)
+    while notes and notes[-1] == 0:
+        notes.pop()
+        durations.pop()
+    return os.path.splitext(os.path.basename(where))[0], notes, durations
+
+
+def load(path):
+    """Return (name, notes, durations in ms) of a .rtttl or .mid file."""
+    ext = os.path.splitext(path)[1].lower()
+    if ext == '.rtttl':
+        with open(path) as f:
+            return parse_rtttl(f.read(), path)
+    if ext in ('.mid', '.midi'):
+        with open(path, 'rb') as f:
+            return parse_midi(f.read(), path)
+    raise AssetError('%s: unknown melody file type' % path)
+
+
+def main():
+    if len(sys.argv) < 3:
+        raise SystemExit(__doc__.strip().splitlines()[-1])
+    low, high = note_range(sys.argv[1])
+    for path in sys.argv[2:]:
+        try:
+            name, notes, durations = load(path)
+        except AssetError as e:
+            raise SystemExit('melody_assets: %s' % e)
+        notes, moved = clamp(notes, low, high)
+        print('%s: "%s", %d notes, %d ms, %d notes moved by octaves' % (path, name, len(notes), sum(durations), moved))
+
+
+if __name__ == '__main__':
+    main()